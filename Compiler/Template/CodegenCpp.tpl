@@ -3857,6 +3857,7 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
    <%if Flags.isSet(Flags.WRITE_TO_BUFFER) then algloopResiduals(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq)%>
    <%initAlgloop(simCode, &extraFuncs, &extraFuncsDecl, extraFuncsNamespace, eq, context, stateDerVectorName, useFlatArrayNotation)%>
    <%queryDensity(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq,context, useFlatArrayNotation)%>
+   <%getSparsePatternCode(simCode, eq)%>
    <%updateAlgloop(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq,context, stateDerVectorName, useFlatArrayNotation)%>
    <%upateAlgloopNonLinear(simCode , &extraFuncs , &extraFuncsDecl, extraFuncsNamespace, eq, context, stateDerVectorName, useFlatArrayNotation)%>
 
@@ -3911,6 +3912,7 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
    <%initAlgloop(simCode, &extraFuncs, &extraFuncsDecl, extraFuncsNamespace, eq, context, stateDerVectorName, useFlatArrayNotation)%>
 
    <%queryDensity(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq,context, useFlatArrayNotation)%>
+   <%getSparsePatternCode(simCode, eq)%>
    <%updateAlgloop(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq,context, stateDerVectorName, useFlatArrayNotation)%>
    <%upateAlgloopNonLinear(simCode , &extraFuncs , &extraFuncsDecl, extraFuncsNamespace, eq, context, stateDerVectorName, useFlatArrayNotation)%>
 
@@ -3954,6 +3956,54 @@ match simCode
       >>
 end queryDensity;
 
+template getSparsePatternCode(SimCode simCode, SimEqSystem eqn)
+ "Generates function that provides the sparse pattern and the column coloring of the jacobian of an algloop,
+  all arrays are constant initialized so several instances can query them concurrently"
+::=
+match simCode
+  case SIMCODE(modelInfo = MODELINFO(__)) then
+    let modelname = lastIdentOfPath(modelInfo.name)
+    match eqn
+      case eq as SES_NONLINEAR(nlSystem = nls as NONLINEARSYSTEM(__)) then
+        match nls.jacobianMatrix
+          case SOME((_,_,_,(sparsepattern as _::_,_),colorList as _::_,maxColor,_)) then
+            let columnStart = (List.intRange(intAdd(listLength(sparsepattern), 1)) |> column1 =>
+                intSub(lengthListElements(unzipSecond(sparsepattern)),
+                       lengthListElements(List.lastN(unzipSecond(sparsepattern), intSub(intAdd(listLength(sparsepattern), 1), column1))))
+              ;separator=",")
+            let rowIndex = (sparsepattern |> (i, indexes) => (indexes |> indexrow => indexrow ;separator=",") ;separator=",")
+            let columnColor = (sparsepattern |> (column, _) =>
+                (colorList |> columns hasindex color0 => (columns |> i_index => if intEq(i_index, column) then intAdd(color0, 1)))
+              ;separator=",")
+            <<
+            int <%modelname%>Algloop<%nls.index%>::getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn)
+            {
+              static const int columnStart[] = {<%columnStart%>};
+              static const int rowIndex[] = {<%if rowIndex then rowIndex else '0'%>};
+              static const int columnColor[] = {<%columnColor%>};
+              leadindex = columnStart;
+              index = rowIndex;
+              colorOfColumn = columnColor;
+              return <%maxColor%>;
+            }
+            >>
+          else
+            <<
+            int <%modelname%>Algloop<%nls.index%>::getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn)
+            {
+              return 0;
+            }
+            >>
+        end match
+      case eq as SES_LINEAR(lSystem = ls as LINEARSYSTEM(__)) then
+        <<
+        int <%modelname%>Algloop<%ls.index%>::getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn)
+        {
+          return 0;
+        }
+        >>
+end getSparsePatternCode;
+
 
 template updateAlgloop(SimCode simCode ,Text& extraFuncs,Text& extraFuncsDecl,Text extraFuncsNamespace,SimEqSystem eqn,Context context, Text stateDerVectorName /*=__zDot*/, Boolean useFlatArrayNotation)
 ::=
@@ -6928,9 +6978,16 @@ case SIMCODE(modelInfo = MODELINFO(__),simulationSettingsOpt = SOME(settings as
       <<
       <%generateMeasureTimeEndCode("measuredFunctionStartValues", "measuredFunctionEndValues", "(*measureTimeFunctionsArray)[2]",  "writeOutput", "MEASURETIME_MODELFUNCTIONS")%>
         write_data_t& container = _writeOutput->getFreeContainer();
-        all_vars_time_t all_vars = make_tuple(outputRealVars.outputVars,outputIntVars.outputVars,outputBoolVars.outputVars,_simTime);
-        neg_all_vars_t neg_all_vars =      make_tuple(outputRealVars.negateOutputVars,outputIntVars.negateOutputVars,outputBoolVars.negateOutputVars);
-       _writeOutput->addContainerToWriteQueue(make_tuple(all_vars,neg_all_vars));
+        all_vars_time_t& all_vars = get<0>(container);
+        neg_all_vars_t& neg_all_vars = get<1>(container);
+        get<0>(all_vars) = outputRealVars.outputVars;
+        get<1>(all_vars) = outputIntVars.outputVars;
+        get<2>(all_vars) = outputBoolVars.outputVars;
+        get<3>(all_vars) = _simTime;
+        get<0>(neg_all_vars) = outputRealVars.negateOutputVars;
+        get<1>(neg_all_vars) = outputIntVars.negateOutputVars;
+        get<2>(neg_all_vars) = outputBoolVars.negateOutputVars;
+       _writeOutput->addContainerToWriteQueue(container);
       >>
     %>
     }
@@ -7877,6 +7934,8 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
     virtual bool isLinearTearing();
     virtual bool isConsistent();
     virtual void getSparseAdata(double* data, int nonzeros);
+    /// Provide the sparse pattern of the jacobian in compressed column format and the coloring of its columns
+    virtual int getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn);
 
     >>
 //void writeOutput(HistoryImplType::value_type_v& v ,vector<string>& head ,const IMixedSystem::OUTPUT command  = IMixedSystem::UNDEF_OUTPUT);
@@ -311,6 +311,13 @@ let numberOfBooleans = intAdd(varInfo.numBoolAlgVars,intAdd(varInfo.numBoolParam
   #define STATES { <%vars.stateVars |> SIMVAR(__) => if stringEq(crefStr(name),"$dummy") then '' else '<%cref(name)%>_'  ;separator=", "%> }
   #define STATESDERIVATIVES { <%vars.derivativeVars |> SIMVAR(__) => if stringEq(crefStr(name),"der($dummy)") then '' else '<%cref(name)%>_'  ;separator=", "%> }
 
+  // define inputs and outputs as vectors of value references, in the order of the Jacobians B, C and D
+  #define NUMBER_OF_INPUTS <%listLength(vars.inputVars)%>
+  #define INPUTS { <%vars.inputVars |> SIMVAR(__) => '<%cref(name)%>_' ;separator=", "%> }
+  #define NUMBER_OF_OUTPUTS <%listLength(vars.outputVars)%>
+  #define OUTPUTS { <%vars.outputVars |> SIMVAR(__) => '<%cref(name)%>_' ;separator=", "%> }
+  <%if Flags.isSet(Flags.DIS_SYMJAC_FMI20) then '#define FMU_DISABLE_DIRECTIONAL_DERIVATIVES'%>
+
   <%System.tmpTickReset(0)%>
   <%(functions |> fn => defineExternalFunction(fn) ; separator="\n")%>
   >>
@@ -1340,6 +1347,8 @@ case FMIIMPORT(__) then
       importFMU1CoSimulationStandAlone(fmi)
     case (INFO(fmiVersion = "2.0", fmiType = 1)) then
       importFMU2ModelExchange(fmi)
+    case (INFO(fmiVersion = "2.0", fmiType = 2)) then
+      importFMU2CoSimulationStandAlone(fmi)
 end importFMUModelica;
 
 template importFMU1ModelExchange(FmiImport fmi)
@@ -2285,6 +2294,135 @@ case FMIIMPORT(fmiInfo=INFO(__),fmiExperimentAnnotation=EXPERIMENTANNOTATION(__)
   >>
 end importFMU1CoSimulationStandAlone;
 
+template importFMU2CoSimulationStandAlone(FmiImport fmi)
+ "Generates Modelica code for FMI Co-simulation stand alone version 2.0.
+  The FMU is the only slave of the co-simulation master of the runtime, which
+  steps it to every sample. Only the Real parameters, inputs and outputs are
+  connected."
+::=
+match fmi
+case FMIIMPORT(fmiInfo=INFO(__),fmiExperimentAnnotation=EXPERIMENTANNOTATION(__)) then
+  /* Get Real parameters and their value references */
+  let realParametersVRs = dumpVariables(fmiModelVariablesList, "real", "parameter", false, 1, "2.0")
+  let realParametersNames = dumpVariables(fmiModelVariablesList, "real", "parameter", false, 2, "2.0")
+  /* Get dependent Real parameters and their value references */
+  let realDependentParametersVRs = dumpVariables(fmiModelVariablesList, "real", "parameter", true, 1, "2.0")
+  let realDependentParametersNames = dumpVariables(fmiModelVariablesList, "real", "parameter", true, 2, "2.0")
+  /* Get input Real varibales and their value references */
+  let realInputVariablesVRs = dumpVariables(fmiModelVariablesList, "real", "input", false, 1, "2.0")
+  let realInputVariablesNames = dumpVariables(fmiModelVariablesList, "real", "input", false, 2, "2.0")
+  /* Get output Real varibales and their value references */
+  let realOutputVariablesVRs = dumpVariables(fmiModelVariablesList, "real", "output", false, 1, "2.0")
+  let realOutputVariablesNames = dumpVariables(fmiModelVariablesList, "real", "output", false, 2, "2.0")
+  <<
+  model <%fmiInfo.fmiModelIdentifier%>_<%getFMIType(fmiInfo)%>_FMU<%if stringEq(fmiInfo.fmiDescription, "") then "" else " \""+fmiInfo.fmiDescription+"\""%>
+    <%dumpFMITypeDefinitions(fmiTypeDefinitionsList)%>
+    constant String fmuWorkingDir = "<%fmuWorkingDirectory%>";
+    parameter Integer logLevel = <%fmiLogLevel%> "log level used during the loading of FMU" annotation (Dialog(tab="FMI", group="Enable logging"));
+    parameter Boolean debugLogging = <%fmiDebugOutput%> "enables the FMU simulation logging" annotation (Dialog(tab="FMI", group="Enable logging"));
+    parameter Real startTime = <%fmiExperimentAnnotation.fmiExperimentStartTime%> "start time used to initialize the slave" annotation (Dialog(tab="FMI", group="Step time"));
+    parameter Real stopTime = <%fmiExperimentAnnotation.fmiExperimentStopTime%> "stop time used to initialize the slave" annotation (Dialog(tab="FMI", group="Step time"));
+    parameter Real numberOfSteps = 500 annotation (Dialog(tab="FMI", group="Step time"));
+    parameter Real communicationStepSize = (stopTime-startTime)/numberOfSteps "step size between the communication points" annotation (Dialog(tab="FMI", group="Step time"));
+    constant Boolean stopTimeDefined = true;
+    <%dumpFMIModelVariablesList("2.0", fmiModelVariablesList, fmiTypeDefinitionsList, generateInputConnectors, generateOutputConnectors)%>
+  protected
+    FMI2CoSimulation fmi2cs = FMI2CoSimulation(logLevel, fmuWorkingDir, "<%fmiInfo.fmiModelIdentifier%>", debugLogging);
+    parameter Real flowParamsStart(fixed=false);
+    parameter Real flowInitialized(fixed=false);
+    discrete Real flowStep(start=0.0, fixed=true);
+    discrete Real flowInputs(start=0.0, fixed=true);
+  initial algorithm
+    flowParamsStart := 1;
+    <%if not stringEq(realParametersVRs, "") then "flowParamsStart := fmi2Functions.fmi2SetReal(fmi2cs, {"+realParametersVRs+"}, {"+realParametersNames+"}, flowParamsStart);"%>
+  initial equation
+    flowInitialized = fmi2Functions.fmi2Initialize(fmi2cs, startTime, stopTimeDefined, stopTime, flowParamsStart);
+    <%if not stringEq(realDependentParametersVRs, "") then "{"+realDependentParametersNames+"} = fmi2Functions.fmi2GetReal(fmi2cs, {"+realDependentParametersVRs+"}, flowInitialized);"%>
+  equation
+    /* the inputs at a communication point are held until the next one */
+    when sample(startTime, communicationStepSize) then
+      flowStep = fmi2Functions.fmi2DoStep(fmi2cs, time, flowInitialized);
+      <%if not stringEq(realInputVariablesVRs, "") then "flowInputs = fmi2Functions.fmi2SetReal(fmi2cs, {"+realInputVariablesVRs+"}, {"+realInputVariablesNames+"}, flowStep);" else "flowInputs = flowStep;"%>
+    end when;
+    <%if not boolAnd(stringEq(realOutputVariablesNames, ""), stringEq(realOutputVariablesVRs, "")) then "{"+realOutputVariablesNames+"} = fmi2Functions.fmi2GetReal(fmi2cs, {"+realOutputVariablesVRs+"}, flowInitialized+flowStep);"%>
+    annotation(experiment(StartTime=<%fmiExperimentAnnotation.fmiExperimentStartTime%>, StopTime=<%fmiExperimentAnnotation.fmiExperimentStopTime%>, Tolerance=<%fmiExperimentAnnotation.fmiExperimentTolerance%>));
+    annotation (Icon(graphics={
+        Rectangle(
+          extent={{-100,100},{100,-100}},
+          lineColor={0,0,0},
+          fillColor={240,240,240},
+          fillPattern=FillPattern.Solid,
+          lineThickness=0.5),
+        Text(
+          extent={{-100,40},{100,0}},
+          lineColor={0,0,0},
+          textString="%name"),
+        Text(
+          extent={{-100,-50},{100,-90}},
+          lineColor={0,0,0},
+          textString="V2.0")}));
+  protected
+    class FMI2CoSimulation
+      extends ExternalObject;
+        function constructor
+          input Integer fmiLogLevel;
+          input String workingDirectory;
+          input String instanceName;
+          input Boolean debugLogging;
+          output FMI2CoSimulation fmi2cs;
+          external "C" fmi2cs = FMI2CoSimulationStandAloneConstructor_OMC(fmiLogLevel, workingDirectory, instanceName, debugLogging) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+        end constructor;
+
+        function destructor
+          input FMI2CoSimulation fmi2cs;
+          external "C" FMI2CoSimulationMasterDestructor_OMC(fmi2cs) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+        end destructor;
+    end FMI2CoSimulation;
+
+    <%dumpFMITypeDefinitionsMappingFunctions(fmiTypeDefinitionsList)%>
+
+    <%dumpFMITypeDefinitionsArrayMappingFunctions(fmiTypeDefinitionsList)%>
+
+    package fmi2Functions
+      function fmi2Initialize
+        input FMI2CoSimulation fmi2cs;
+        input Real tStart;
+        input Boolean stopTimeDefined;
+        input Real tStop;
+        input Real preInitialized;
+        output Real postInitialized=preInitialized;
+        external "C" fmi2MasterInitialize_OMC(fmi2cs, tStart, stopTimeDefined, tStop) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+      end fmi2Initialize;
+
+      function fmi2DoStep
+        input FMI2CoSimulation fmi2cs;
+        input Real communicationPoint;
+        input Real preStep;
+        output Real postStep=preStep;
+        external "C" fmi2MasterDoStepUntil_OMC(fmi2cs, communicationPoint) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+      end fmi2DoStep;
+
+      function fmi2GetReal
+        input FMI2CoSimulation fmi2cs;
+        input Real realValueReferences[:];
+        input Real inFlowInput;
+        output Real realValues[size(realValueReferences, 1)];
+        external "C" fmi2MasterGetRealArray_OMC(fmi2cs, 0, size(realValueReferences, 1), realValueReferences, inFlowInput, realValues) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+      end fmi2GetReal;
+
+      function fmi2SetReal
+        input FMI2CoSimulation fmi2cs;
+        input Real realValueReferences[:];
+        input Real realValues[size(realValueReferences, 1)];
+        input Real inFlowInput;
+        output Real outFlowInput=inFlowInput;
+        external "C" fmi2MasterSetRealArray_OMC(fmi2cs, 0, size(realValueReferences, 1), realValueReferences, realValues) annotation(Library = {"OpenModelicaFMIRuntimeC", "fmilib"});
+      end fmi2SetReal;
+    end fmi2Functions;
+  end <%fmiInfo.fmiModelIdentifier%>_<%getFMIType(fmiInfo)%>_FMU;
+  >>
+end importFMU2CoSimulationStandAlone;
+
 template dumpFMITypeDefinitions(list<TypeDefinitions> fmiTypeDefinitionsList)
  "Generates the Type Definitions code."
 ::=
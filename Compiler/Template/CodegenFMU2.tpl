@@ -143,9 +143,9 @@ case SIMCODE(__) then
     canRunAsynchronuously = "false"
     canBeInstantiatedOnlyOncePerProcess="true"
     canNotUseMemoryManagementFunctions="false"
-    canGetAndSetFMUstate="false"
-    canSerializeFMUstate="false"
-    <% if Flags.isSet(FMU_EXPERIMENTAL) then 'providesDirectionalDerivative="true"'%> />
+    canGetAndSetFMUstate="true"
+    canSerializeFMUstate="true"
+    <% if not Flags.isSet(Flags.DIS_SYMJAC_FMI20) then 'providesDirectionalDerivative="true"'%> />
   >>
 end CoSimulation;
 
@@ -59,7 +59,9 @@ case SIMCODE(__) then
   let modelIdentifier = modelNamePrefix(simCode)
   <<
   <ModelExchange
-    modelIdentifier="<%modelIdentifier%>"<% if Flags.isSet(FMU_EXPERIMENTAL) then ' providesDirectionalDerivative="true"'%>>
+    modelIdentifier="<%modelIdentifier%>"
+    canGetAndSetFMUstate="true"
+    canSerializeFMUstate="true"<% if not Flags.isSet(Flags.DIS_SYMJAC_FMI20) then ' providesDirectionalDerivative="true"'%>>
   </ModelExchange>
   >>
 end ModelExchange;
@@ -846,13 +846,13 @@ int FMIImpl__initializeFMIImport(const char* file_name, const char* working_dire
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Error parsing the modelDescription.xml file."), NULL, 0);
       return 0;
     }
-    /* remove the following block once we have support for FMI 2.0 CS. */
+    /* the Modelica code of an FMU that supports both types would have to choose one. */
     fmiType = fmi2_import_get_fmu_kind(fmi);
-    if (fmiType == fmi2_fmu_kind_cs || fmiType == fmi2_fmu_kind_me_and_cs) {
+    if (fmiType == fmi2_fmu_kind_me_and_cs) {
       const char* tokens[1] = {fmi2_fmu_kind_to_string(fmiType)};
       fmi2_import_free(fmi);
       fmi_import_free_context(context);
-      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("The FMU version is 2.0 and FMU type is %s. Unsupported FMU type. Only FMI 2.0 ModelExchange is supported."), tokens, 1);
+      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("The FMU version is 2.0 and FMU type is %s. Unsupported FMU type. Only FMI 2.0 ModelExchange or CoSimulation is supported."), tokens, 1);
       return 0;
     }
     *fmiInstance = mmc_mk_some(fmi);
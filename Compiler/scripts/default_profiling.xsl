@@ -17,6 +17,13 @@
   </xsl:choose>
 </xsl:template>
 
+<xsl:template name="Histogram">
+  <xsl:param name="node" />
+  <xsl:for-each select="$node/histogram/bucket">
+    <abbr title="{@min} s - {@max} s"><xsl:value-of select="@count"/></abbr><xsl:if test="position() != last()">&nbsp;</xsl:if>
+  </xsl:for-each>
+</xsl:template>
+
 <xsl:template match="/simulation">
 <html>
 <head>
@@ -79,26 +86,32 @@
 
 <h2>Global Steps</h2>
   <table>
-  <tr><th>&nbsp;</th><th>Steps</th><th>Total Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th>Average Time</th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th></tr>
+  <tr><th>&nbsp;</th><th>Steps</th><th>Total Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th>Average Time</th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th><xsl:if test="/simulation/modelinfo/steps"><th><abbr title="The minimum accumulated time of this action during a single time step">Min Time</abbr></th><th><abbr title="Number of time steps per accumulated time, in logarithmic buckets (hover for the bounds)">Histogram</abbr></th></xsl:if></tr>
   <tr>
-     <td><a href="{modelinfo/prefix}_prof.999.svg"><img class="thumb" src="{modelinfo/prefix}_prof.999.thumb.svg" alt="Graph thumbnail 999" /></a></td>
+     <td><xsl:if test="not(modelinfo/steps)"><a href="{modelinfo/prefix}_prof.999.svg"><img class="thumb" src="{modelinfo/prefix}_prof.999.thumb.svg" alt="Graph thumbnail 999" /></a></xsl:if></td>
      <td><xsl:value-of select="modelinfo/numStep"/></td>
      <td><xsl:value-of select="modelinfo/totalStepsTime"/></td>
      <td><xsl:value-of select="format-number(100 * modelinfo/totalStepsTime div modelinfo/totalTime,'##0.00')"/>%</td>
      <td><xsl:value-of select="modelinfo/totalStepsTime div modelinfo/numStep"/></td>
      <td><xsl:value-of select="modelinfo/maxTime"/></td>
      <td><xsl:value-of select="format-number((modelinfo/numStep * modelinfo/maxTime div modelinfo/totalStepsTime)-1,'##0.00')"/>x</td>
+     <xsl:if test="modelinfo/steps">
+       <td><xsl:value-of select="modelinfo/steps/minTime"/></td>
+       <td><xsl:call-template name="Histogram"><xsl:with-param name="node" select="modelinfo/steps"/></xsl:call-template></td>
+     </xsl:if>
   </tr>
   </table>
 
 <h2>Measured Function Calls</h2>
   <table>
-  <tr><th>&nbsp;</th><th class="name">Name</th><th>Calls</th><th>Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th></tr>
+  <tr><th>&nbsp;</th><th class="name">Name</th><th>Calls</th><th>Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th><xsl:if test="/simulation/modelinfo/steps"><th><abbr title="The minimum accumulated time of this action during a single time step">Min Time</abbr></th><th><abbr title="Number of time steps per accumulated time, in logarithmic buckets (hover for the bounds)">Histogram</abbr></th></xsl:if><xsl:if test="/simulation/modelinfo/hwcounters"><th><abbr title="Instructions per cycle">IPC</abbr></th><th><abbr title="Cache misses per 1000 instructions">Cache MPKI</abbr></th><th><abbr title="Branch misses per 1000 instructions">Branch MPKI</abbr></th></xsl:if></tr>
   <xsl:for-each select="functions/function">
     <tr>
       <td>
-        <a href="{//simulation/modelinfo/prefix}_prof.{@id}.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{@id}.thumb.svg" alt="Graph thumbnail function {@id}" /></a>
-        <a href="{//simulation/modelinfo/prefix}_prof.{@id}_count.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{@id}_count.thumb.svg" alt="Graph thumbnail count function {@id}" /></a>
+        <xsl:if test="not(/simulation/modelinfo/steps)">
+          <a href="{//simulation/modelinfo/prefix}_prof.{@id}.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{@id}.thumb.svg" alt="Graph thumbnail function {@id}" /></a>
+          <a href="{//simulation/modelinfo/prefix}_prof.{@id}_count.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{@id}_count.thumb.svg" alt="Graph thumbnail count function {@id}" /></a>
+        </xsl:if>
       </td>
       <td class="name"><a href="{info/@filename}#line={info/@startline}"><xsl:value-of select="name"/></a></td>
       <td><xsl:value-of select="ncall"/></td>
@@ -106,18 +119,29 @@
       <td><xsl:value-of select="format-number(100 * time div /simulation/modelinfo/totalTime,'##0.00')"/>%</td>
       <td><xsl:value-of select="maxTime"/></td>
       <td><xsl:value-of select="format-number((ncall * maxTime div time)-1,'##0.00')"/>x</td>
+      <xsl:if test="/simulation/modelinfo/steps">
+        <td><xsl:value-of select="minTime"/></td>
+        <td><xsl:call-template name="Histogram"><xsl:with-param name="node" select="."/></xsl:call-template></td>
+      </xsl:if>
+      <xsl:if test="/simulation/modelinfo/hwcounters">
+        <td><xsl:value-of select="hwcounters/ipc"/></td>
+        <td><xsl:value-of select="hwcounters/cacheMPKI"/></td>
+        <td><xsl:value-of select="hwcounters/branchMPKI"/></td>
+      </xsl:if>
     </tr>
   </xsl:for-each>
   </table>
 
 <h2>Measured Blocks</h2>
   <table>
-  <tr><th>&nbsp;</th><th class="name">Name</th><th>Calls</th><th>Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th></tr>
+  <tr><th>&nbsp;</th><th class="name">Name</th><th>Calls</th><th>Time</th><th><abbr title="Fraction of total simulation time">Fraction</abbr></th><th><abbr title="The maximum accumulated time of this action during a single time step">Max Time</abbr></th><th><abbr title="Deviation from average execution time">Deviation</abbr></th><xsl:if test="/simulation/modelinfo/steps"><th><abbr title="The minimum accumulated time of this action during a single time step">Min Time</abbr></th><th><abbr title="Number of time steps per accumulated time, in logarithmic buckets (hover for the bounds)">Histogram</abbr></th></xsl:if><xsl:if test="/simulation/modelinfo/hwcounters"><th><abbr title="Instructions per cycle">IPC</abbr></th><th><abbr title="Cache misses per 1000 instructions">Cache MPKI</abbr></th><th><abbr title="Branch misses per 1000 instructions">Branch MPKI</abbr></th></xsl:if></tr>
   <xsl:for-each select="profileblocks/profileblock">
     <tr>
       <td>
-        <a href="{//simulation/modelinfo/prefix}_prof.{ref/@refid}.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{ref/@refid}.thumb.svg" alt="Graph thumbnail {ref/@refid}" /></a>
-        <a href="{//simulation/modelinfo/prefix}_prof.{ref/@refid}_count.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{ref/@refid}_count.thumb.svg" alt="Graph thumbnail count {ref/@refid}" /></a>
+        <xsl:if test="not(/simulation/modelinfo/steps)">
+          <a href="{//simulation/modelinfo/prefix}_prof.{ref/@refid}.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{ref/@refid}.thumb.svg" alt="Graph thumbnail {ref/@refid}" /></a>
+          <a href="{//simulation/modelinfo/prefix}_prof.{ref/@refid}_count.svg"><img class="thumb" src="{//simulation/modelinfo/prefix}_prof.{ref/@refid}_count.thumb.svg" alt="Graph thumbnail count {ref/@refid}" /></a>
+        </xsl:if>
       </td>
       <td class="name"><a href="#{ref/@refid}"><xsl:value-of select="id(ref/@refid)/@name"/></a></td>
       <td><xsl:value-of select="ncall"/></td>
@@ -125,6 +149,15 @@
       <td><xsl:value-of select="format-number(100 * time div /simulation/modelinfo/totalTime,'##0.00')"/>%</td>
       <td><xsl:value-of select="maxTime"/></td>
       <td><xsl:value-of select="format-number((ncall * maxTime div time)-1,'##0.00')"/>x</td>
+      <xsl:if test="/simulation/modelinfo/steps">
+        <td><xsl:value-of select="minTime"/></td>
+        <td><xsl:call-template name="Histogram"><xsl:with-param name="node" select="."/></xsl:call-template></td>
+      </xsl:if>
+      <xsl:if test="/simulation/modelinfo/hwcounters">
+        <td><xsl:value-of select="hwcounters/ipc"/></td>
+        <td><xsl:value-of select="hwcounters/cacheMPKI"/></td>
+        <td><xsl:value-of select="hwcounters/branchMPKI"/></td>
+      </xsl:if>
     </tr>
   </xsl:for-each>
   </table>
@@ -0,0 +1,141 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "FMICommon.h"
+#include "FMI2Common.h"
+
+/*
+ * FMI version 2.0 Co-Simulation functions
+ */
+
+void* FMI2CoSimulationConstructor_OMC(int fmi_log_level, char* working_directory, char* instanceName, int debugLogging)
+{
+  FMI2CoSimulation* FMI2CS = malloc(sizeof(FMI2CoSimulation));
+  jm_status_enu_t status, instantiateSlaveStatus;
+  fmi2_fmu_kind_enu_t fmuKind;
+  FMI2CS->FMILogLevel = fmi_log_level;
+  /* JM callbacks */
+  FMI2CS->JMCallbacks.malloc = malloc;
+  FMI2CS->JMCallbacks.calloc = calloc;
+  FMI2CS->JMCallbacks.realloc = realloc;
+  FMI2CS->JMCallbacks.free = free;
+  FMI2CS->JMCallbacks.logger = importlogger;
+  FMI2CS->JMCallbacks.log_level = FMI2CS->FMILogLevel;
+  FMI2CS->JMCallbacks.context = 0;
+  FMI2CS->FMIImportContext = fmi_import_allocate_context(&FMI2CS->JMCallbacks);
+  FMI2CS->FMIState = NULL;
+  /* parse the xml file */
+  FMI2CS->FMIWorkingDirectory = (char*) malloc(strlen(working_directory)+1);
+  strcpy(FMI2CS->FMIWorkingDirectory, working_directory);
+  FMI2CS->FMIImportInstance = fmi2_import_parse_xml(FMI2CS->FMIImportContext, FMI2CS->FMIWorkingDirectory, NULL);
+  if(!FMI2CS->FMIImportInstance) {
+    FMI2CS->FMISolvingMode = fmi2_none_mode;
+    ModelicaFormatError("Error parsing the XML file contained in %s\n", FMI2CS->FMIWorkingDirectory);
+    return 0;
+  }
+  fmuKind = fmi2_import_get_fmu_kind(FMI2CS->FMIImportInstance);
+  if (fmuKind != fmi2_fmu_kind_cs && fmuKind != fmi2_fmu_kind_me_and_cs) {
+    FMI2CS->FMISolvingMode = fmi2_none_mode;
+    ModelicaFormatError("The FMU contained in %s does not support Co-Simulation\n", FMI2CS->FMIWorkingDirectory);
+    return 0;
+  }
+  /* FMI callback functions */
+  FMI2CS->FMICallbackFunctions.logger = fmi2logger;
+  FMI2CS->FMICallbackFunctions.allocateMemory = calloc;
+  FMI2CS->FMICallbackFunctions.freeMemory = free;
+  FMI2CS->FMICallbackFunctions.stepFinished = NULL;
+  FMI2CS->FMICallbackFunctions.componentEnvironment = FMI2CS->FMIImportInstance;
+  /* Load the binary (dll/so) */
+  status = fmi2_import_create_dllfmu(FMI2CS->FMIImportInstance, fmi2_fmu_kind_cs, &FMI2CS->FMICallbackFunctions);
+  if (status == jm_status_error) {
+    FMI2CS->FMISolvingMode = fmi2_none_mode;
+    ModelicaFormatError("Loading of FMU dynamic link library failed with status : %s\n", jm_log_level_to_string(status));
+    return 0;
+  }
+  FMI2CS->FMIInstanceName = (char*) malloc(strlen(instanceName)+1);
+  strcpy(FMI2CS->FMIInstanceName, instanceName);
+  FMI2CS->FMIDebugLogging = debugLogging;
+  instantiateSlaveStatus = fmi2_import_instantiate(FMI2CS->FMIImportInstance, FMI2CS->FMIInstanceName, fmi2_cosimulation, NULL, fmi2_false);
+  if (instantiateSlaveStatus == jm_status_error) {
+    FMI2CS->FMISolvingMode = fmi2_none_mode;
+    ModelicaFormatError("fmi2Instantiate failed with status : %s\n", jm_log_level_to_string(instantiateSlaveStatus));
+    return 0;
+  }
+  /* Only call fmi2SetDebugLogging if debugLogging is true */
+  if (FMI2CS->FMIDebugLogging) {
+    int i;
+    size_t categoriesSize = 0;
+    fmi2_status_t debugLoggingStatus;
+    fmi2_string_t *categories;
+    /* Read the log categories size */
+    categoriesSize = fmi2_import_get_log_categories_num(FMI2CS->FMIImportInstance);
+    categories = (fmi2_string_t*)malloc(categoriesSize*sizeof(fmi2_string_t));
+    for (i = 0 ; i < categoriesSize ; i++) {
+      categories[i] = fmi2_import_get_log_category(FMI2CS->FMIImportInstance, i);
+    }
+    debugLoggingStatus = fmi2_import_set_debug_logging(FMI2CS->FMIImportInstance, FMI2CS->FMIDebugLogging, categoriesSize, categories);
+    free(categories);
+    if (debugLoggingStatus != fmi2_status_ok && debugLoggingStatus != fmi2_status_warning) {
+      ModelicaFormatMessage("fmi2SetDebugLogging failed with status : %s\n", fmi2_status_to_string(debugLoggingStatus));
+    }
+  }
+  /* the master uses these to decide whether a macro step can be rejected and redone */
+  FMI2CS->FMICanGetAndSetFMUstate = fmi2_import_get_capability(FMI2CS->FMIImportInstance, fmi2_cs_canGetAndSetFMUstate);
+  FMI2CS->FMICanHandleVariableCommunicationStepSize = fmi2_import_get_capability(FMI2CS->FMIImportInstance, fmi2_cs_canHandleVariableCommunicationStepSize);
+  FMI2CS->FMICanInterpolateInputs = fmi2_import_get_capability(FMI2CS->FMIImportInstance, fmi2_cs_canInterpolateInputs);
+  FMI2CS->FMISolvingMode = fmi2_instantiated_mode;
+  return FMI2CS;
+}
+
+void FMI2CoSimulationDestructor_OMC(void* in_fmi2cs)
+{
+  FMI2CoSimulation* FMI2CS = (FMI2CoSimulation*)in_fmi2cs;
+  if (FMI2CS->FMIState) {
+    fmi2_import_free_fmu_state(FMI2CS->FMIImportInstance, &FMI2CS->FMIState);
+  }
+  fmi2_import_terminate(FMI2CS->FMIImportInstance);
+  fmi2_import_free_instance(FMI2CS->FMIImportInstance);
+  fmi2_import_destroy_dllfmu(FMI2CS->FMIImportInstance);
+  fmi2_import_free(FMI2CS->FMIImportInstance);
+  fmi_import_free_context(FMI2CS->FMIImportContext);
+  free(FMI2CS->FMIWorkingDirectory);
+  free(FMI2CS->FMIInstanceName);
+  free(FMI2CS);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,705 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "FMICommon.h"
+#include "FMI2CoSimulationMaster.h"
+
+#define FMI2_MASTER_MAX_REJECTIONS 10
+
+static int fmi2StatusIsOk(fmi2_status_t status)
+{
+  return status == fmi2_status_ok || status == fmi2_status_warning;
+}
+
+/*
+ * Slaves that can interpolate their inputs get the input derivatives, all
+ * other slaves hold their inputs constant over the macro step.
+ */
+static int slaveInterpolatesInputs(FMI2CoSimulationMaster* master, FMI2MasterSlave* slave)
+{
+  return master->extrapolationOrder > 0 && slave->FMI2CS->FMICanInterpolateInputs;
+}
+
+/*
+ * Order of the extrapolation the consumer of an extrapolated connection
+ * sees: 1 if it gets the slope of the last two communication points, 0 if
+ * it holds the last value.
+ */
+static int connectionExtrapolationOrder(FMI2CoSimulationMaster* master, FMI2Connection* c)
+{
+  return slaveInterpolatesInputs(master, &master->slaves[c->toSlave]) && c->hasPrevious ? 1 : 0;
+}
+
+/*
+ * Steps one slave over [master->time, master->time + master->stepSize].
+ * Runs on any thread of the pool; only touches the buffers of this slave and
+ * the nextValue of its outgoing connections.
+ */
+static void stepSlave(FMI2CoSimulationMaster* master, int i)
+{
+  FMI2MasterSlave* slave = &master->slaves[i];
+  fmi2_import_t* fmu = slave->FMI2CS->FMIImportInstance;
+  int interpolate = slaveInterpolatesInputs(master, slave);
+  fmi2_status_t status;
+  int k;
+
+  for (k = 0; k < slave->numberOfInputs; k++) {
+    FMI2Connection* c = &master->connections[slave->inputs[k]];
+    if (c->extrapolated) {
+      slave->inputValues[k] = c->value;
+      slave->inputDerivatives[k] = connectionExtrapolationOrder(master, c) ? (c->value - c->previousValue) / (c->time - c->previousTime) : 0.0;
+    } else if (interpolate) {
+      /* the producer already reached the end of the step, interpolate its output */
+      slave->inputValues[k] = c->value;
+      slave->inputDerivatives[k] = (c->nextValue - c->value) / master->stepSize;
+    } else {
+      slave->inputValues[k] = c->nextValue;
+      slave->inputDerivatives[k] = 0.0;
+    }
+  }
+
+  status = fmi2_import_set_real(fmu, slave->inputValueReferences, slave->numberOfInputs, slave->inputValues);
+  if (fmi2StatusIsOk(status) && interpolate && slave->numberOfInputs > 0) {
+    status = fmi2_import_set_real_input_derivatives(fmu, slave->inputValueReferences, slave->numberOfInputs, slave->inputOrders, slave->inputDerivatives);
+  }
+  if (fmi2StatusIsOk(status)) {
+    /* the slave may only discard its past if the master never rolls it back */
+    status = fmi2_import_do_step(fmu, master->time, master->stepSize, master->canRollback ? fmi2_false : fmi2_true);
+  }
+  if (fmi2StatusIsOk(status)) {
+    status = fmi2_import_get_real(fmu, slave->outputValueReferences, slave->numberOfOutputs, slave->outputValues);
+    for (k = 0; k < slave->numberOfOutputs; k++) {
+      master->connections[slave->outputs[k]].nextValue = slave->outputValues[k];
+    }
+  }
+  slave->status = status;
+}
+
+static void* masterWorker(void* in_master)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  pthread_mutex_lock(&master->mutex);
+  for (;;) {
+    int job;
+    while (!master->shutdown && master->nextJob >= master->lastJob) {
+      pthread_cond_wait(&master->workCond, &master->mutex);
+    }
+    if (master->shutdown) {
+      break;
+    }
+    job = master->levelSlaves[master->nextJob++];
+    pthread_mutex_unlock(&master->mutex);
+    stepSlave(master, job);
+    pthread_mutex_lock(&master->mutex);
+    if (--master->pendingJobs == 0) {
+      pthread_cond_signal(&master->doneCond);
+    }
+  }
+  pthread_mutex_unlock(&master->mutex);
+  return NULL;
+}
+
+/*
+ * Steps all slaves of one level and returns once all of them are done.
+ */
+static void stepLevel(FMI2CoSimulationMaster* master, int level)
+{
+  int first = master->levelIndex[level], last = master->levelIndex[level+1];
+  int job;
+
+  if (master->numberOfThreads <= 1 || last - first == 1) {
+    for (job = first; job < last; job++) {
+      stepSlave(master, master->levelSlaves[job]);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&master->mutex);
+  master->nextJob = first;
+  master->lastJob = last;
+  master->pendingJobs = last - first;
+  pthread_cond_broadcast(&master->workCond);
+  while (master->nextJob < master->lastJob) {
+    job = master->levelSlaves[master->nextJob++];
+    pthread_mutex_unlock(&master->mutex);
+    stepSlave(master, job);
+    pthread_mutex_lock(&master->mutex);
+    master->pendingJobs--;
+  }
+  while (master->pendingJobs > 0) {
+    pthread_cond_wait(&master->doneCond, &master->mutex);
+  }
+  pthread_mutex_unlock(&master->mutex);
+}
+
+/*
+ * Orders the slaves along the connection graph. A slave is placed once all
+ * its producers are placed; if only cycles remain, the remaining slave with
+ * the fewest unplaced producers is placed and its inputs from unplaced
+ * producers are extrapolated. Each slave gets the level one above its
+ * highest producer, so slaves in the same level are independent.
+ * For Jacobi every slave is in level 0 and every connection is extrapolated.
+ */
+static void buildSchedule(FMI2CoSimulationMaster* master)
+{
+  int n = master->numberOfSlaves;
+  int* unplacedProducers = calloc(n, sizeof(int));
+  int* placed = calloc(n, sizeof(int));
+  int* levelSize;
+  int i, k, p;
+
+  master->levelSlaves = malloc(n*sizeof(int));
+  for (i = 0; i < master->numberOfConnections; i++) {
+    master->connections[i].extrapolated = 1;
+  }
+
+  if (master->algorithm == fmi2_master_jacobi) {
+    for (i = 0; i < n; i++) {
+      master->slaves[i].level = 0;
+    }
+    master->numberOfLevels = n > 0 ? 1 : 0;
+  } else {
+    for (i = 0; i < master->numberOfConnections; i++) {
+      FMI2Connection* c = &master->connections[i];
+      if (c->fromSlave != c->toSlave) {
+        unplacedProducers[c->toSlave]++;
+      }
+    }
+    master->numberOfLevels = 0;
+    for (p = 0; p < n; p++) {
+      int next = -1;
+      for (i = 0; i < n; i++) {
+        if (!placed[i] && (next < 0 || unplacedProducers[i] < unplacedProducers[next])) {
+          next = i;
+        }
+      }
+      placed[next] = 1;
+      master->slaves[next].level = 0;
+      for (k = 0; k < master->slaves[next].numberOfInputs; k++) {
+        FMI2Connection* c = &master->connections[master->slaves[next].inputs[k]];
+        if (c->fromSlave != next && placed[c->fromSlave]) {
+          c->extrapolated = 0;
+          if (master->slaves[c->fromSlave].level + 1 > master->slaves[next].level) {
+            master->slaves[next].level = master->slaves[c->fromSlave].level + 1;
+          }
+        }
+      }
+      for (k = 0; k < master->slaves[next].numberOfOutputs; k++) {
+        FMI2Connection* c = &master->connections[master->slaves[next].outputs[k]];
+        if (!placed[c->toSlave]) {
+          unplacedProducers[c->toSlave]--;
+        }
+      }
+      if (master->slaves[next].level + 1 > master->numberOfLevels) {
+        master->numberOfLevels = master->slaves[next].level + 1;
+      }
+    }
+  }
+
+  levelSize = calloc(master->numberOfLevels + 1, sizeof(int));
+  master->levelIndex = calloc(master->numberOfLevels + 1, sizeof(int));
+  for (i = 0; i < n; i++) {
+    levelSize[master->slaves[i].level]++;
+  }
+  for (k = 0; k < master->numberOfLevels; k++) {
+    master->levelIndex[k+1] = master->levelIndex[k] + levelSize[k];
+    levelSize[k] = master->levelIndex[k];
+  }
+  for (i = 0; i < n; i++) {
+    master->levelSlaves[levelSize[master->slaves[i].level]++] = i;
+  }
+
+  free(levelSize);
+  free(placed);
+  free(unplacedProducers);
+}
+
+/*
+ * Sets up the per slave input and output buffers from the connection list.
+ */
+static void buildSlaveBuffers(FMI2CoSimulationMaster* master)
+{
+  int i, k;
+  for (i = 0; i < master->numberOfSlaves; i++) {
+    master->slaves[i].numberOfInputs = 0;
+    master->slaves[i].numberOfOutputs = 0;
+  }
+  for (k = 0; k < master->numberOfConnections; k++) {
+    master->slaves[master->connections[k].toSlave].numberOfInputs++;
+    master->slaves[master->connections[k].fromSlave].numberOfOutputs++;
+  }
+  for (i = 0; i < master->numberOfSlaves; i++) {
+    FMI2MasterSlave* slave = &master->slaves[i];
+    slave->inputs = malloc(slave->numberOfInputs*sizeof(int));
+    slave->inputValueReferences = malloc(slave->numberOfInputs*sizeof(fmi2_value_reference_t));
+    slave->inputValues = malloc(slave->numberOfInputs*sizeof(fmi2_real_t));
+    slave->inputDerivatives = malloc(slave->numberOfInputs*sizeof(fmi2_real_t));
+    slave->inputOrders = malloc(slave->numberOfInputs*sizeof(fmi2_integer_t));
+    slave->outputs = malloc(slave->numberOfOutputs*sizeof(int));
+    slave->outputValueReferences = malloc(slave->numberOfOutputs*sizeof(fmi2_value_reference_t));
+    slave->outputValues = malloc(slave->numberOfOutputs*sizeof(fmi2_real_t));
+    slave->numberOfInputs = 0;
+    slave->numberOfOutputs = 0;
+  }
+  for (k = 0; k < master->numberOfConnections; k++) {
+    FMI2Connection* c = &master->connections[k];
+    FMI2MasterSlave* to = &master->slaves[c->toSlave];
+    FMI2MasterSlave* from = &master->slaves[c->fromSlave];
+    to->inputs[to->numberOfInputs] = k;
+    to->inputValueReferences[to->numberOfInputs] = c->toValueReference;
+    to->inputOrders[to->numberOfInputs] = 1;
+    to->numberOfInputs++;
+    from->outputs[from->numberOfOutputs] = k;
+    from->outputValueReferences[from->numberOfOutputs] = c->fromValueReference;
+    from->numberOfOutputs++;
+  }
+}
+
+/*
+ * Copies the current outputs of all slaves to the connected inputs, in
+ * schedule order, until the values no longer change. Used in initialization
+ * mode. An input keeps its start value until the output of its producer has
+ * been read.
+ */
+static void propagateConnections(FMI2CoSimulationMaster* master)
+{
+  int iter, j, k;
+  for (k = 0; k < master->numberOfConnections; k++) {
+    master->connections[k].isRead = 0;
+  }
+  for (iter = 0; iter <= master->numberOfSlaves; iter++) {
+    int changed = 0;
+    for (j = 0; j < master->numberOfSlaves; j++) {
+      FMI2MasterSlave* slave = &master->slaves[master->levelSlaves[j]];
+      fmi2_import_t* fmu = slave->FMI2CS->FMIImportInstance;
+      fmi2_status_t status = fmi2_status_ok;
+      for (k = 0; k < slave->numberOfInputs && fmi2StatusIsOk(status); k++) {
+        FMI2Connection* c = &master->connections[slave->inputs[k]];
+        if (c->isRead) {
+          status = fmi2_import_set_real(fmu, &slave->inputValueReferences[k], 1, &c->value);
+        }
+      }
+      if (fmi2StatusIsOk(status)) {
+        status = fmi2_import_get_real(fmu, slave->outputValueReferences, slave->numberOfOutputs, slave->outputValues);
+      }
+      if (!fmi2StatusIsOk(status)) {
+        ModelicaFormatError("Propagating the connections of %s failed with status : %s\n", slave->FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+      }
+      for (k = 0; k < slave->numberOfOutputs; k++) {
+        FMI2Connection* c = &master->connections[slave->outputs[k]];
+        if (!c->isRead || c->value != slave->outputValues[k]) {
+          c->value = slave->outputValues[k];
+          c->isRead = 1;
+          changed = 1;
+        }
+      }
+    }
+    if (!changed) {
+      break;
+    }
+  }
+}
+
+/*
+ * Weighted error between the input the consumer of each extrapolated
+ * connection saw at the end of the macro step and the computed output; the
+ * step is acceptable if it is <= 1. order is set to the extrapolation order
+ * of the connection with the largest error.
+ */
+static double extrapolationError(FMI2CoSimulationMaster* master, int* order)
+{
+  double err = 0.0;
+  int k;
+  *order = 0;
+  for (k = 0; k < master->numberOfConnections; k++) {
+    FMI2Connection* c = &master->connections[k];
+    double predicted = c->value, e;
+    int connectionOrder;
+    if (!c->extrapolated) {
+      continue;
+    }
+    connectionOrder = connectionExtrapolationOrder(master, c);
+    if (connectionOrder > 0) {
+      predicted += (c->value - c->previousValue) / (c->time - c->previousTime) * master->stepSize;
+    }
+    e = fabs(c->nextValue - predicted) / (master->tolerance * (1.0 + fabs(c->nextValue)));
+    if (e > err) {
+      err = e;
+      *order = connectionOrder;
+    }
+  }
+  return err;
+}
+
+void* FMI2CoSimulationMasterConstructor_OMC(int fmi_log_level, int algorithm, int extrapolationOrder, double tolerance, int numberOfThreads)
+{
+  FMI2CoSimulationMaster* master = calloc(1, sizeof(FMI2CoSimulationMaster));
+  master->FMILogLevel = fmi_log_level;
+  master->algorithm = algorithm == fmi2_master_gauss_seidel ? fmi2_master_gauss_seidel : fmi2_master_jacobi;
+  master->extrapolationOrder = extrapolationOrder > 0 ? 1 : 0;
+  master->tolerance = tolerance;
+  master->maxRejections = FMI2_MASTER_MAX_REJECTIONS;
+  master->numberOfThreads = numberOfThreads;
+  pthread_mutex_init(&master->mutex, NULL);
+  pthread_cond_init(&master->workCond, NULL);
+  pthread_cond_init(&master->doneCond, NULL);
+  return master;
+}
+
+void FMI2CoSimulationMasterDestructor_OMC(void* in_master)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  int i;
+  if (master->threads) {
+    pthread_mutex_lock(&master->mutex);
+    master->shutdown = 1;
+    pthread_cond_broadcast(&master->workCond);
+    pthread_mutex_unlock(&master->mutex);
+    for (i = 0; i < master->numberOfThreads - 1; i++) {
+      pthread_join(master->threads[i], NULL);
+    }
+    free(master->threads);
+  }
+  for (i = 0; i < master->numberOfSlaves; i++) {
+    FMI2MasterSlave* slave = &master->slaves[i];
+    FMI2CoSimulationDestructor_OMC(slave->FMI2CS);
+    free(slave->inputs);
+    free(slave->inputValueReferences);
+    free(slave->inputValues);
+    free(slave->inputDerivatives);
+    free(slave->inputOrders);
+    free(slave->outputs);
+    free(slave->outputValueReferences);
+    free(slave->outputValues);
+  }
+  free(master->slaves);
+  free(master->connections);
+  free(master->levelIndex);
+  free(master->levelSlaves);
+  pthread_cond_destroy(&master->doneCond);
+  pthread_cond_destroy(&master->workCond);
+  pthread_mutex_destroy(&master->mutex);
+  free(master);
+}
+
+/*
+ * Loads and instantiates the FMU unpacked in working_directory.
+ * Returns the slave index used by fmi2MasterConnect_OMC.
+ */
+int fmi2MasterAddSlave_OMC(void* in_master, char* working_directory, char* instanceName, int debugLogging)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  FMI2CoSimulation* FMI2CS;
+  if (master->initialized) {
+    ModelicaFormatError("Cannot add slave %s after the co-simulation master is initialized\n", instanceName);
+    return -1;
+  }
+  FMI2CS = (FMI2CoSimulation*)FMI2CoSimulationConstructor_OMC(master->FMILogLevel, working_directory, instanceName, debugLogging);
+  if (!FMI2CS) {
+    return -1;
+  }
+  if (master->numberOfSlaves == master->slavesSize) {
+    master->slavesSize = master->slavesSize ? 2*master->slavesSize : 4;
+    master->slaves = realloc(master->slaves, master->slavesSize*sizeof(FMI2MasterSlave));
+  }
+  memset(&master->slaves[master->numberOfSlaves], 0, sizeof(FMI2MasterSlave));
+  master->slaves[master->numberOfSlaves].FMI2CS = FMI2CS;
+  return master->numberOfSlaves++;
+}
+
+/*
+ * Connects the real output fromValueReference of slave fromSlave to the real
+ * input toValueReference of slave toSlave.
+ */
+void fmi2MasterConnect_OMC(void* in_master, int fromSlave, int fromValueReference, int toSlave, int toValueReference)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  FMI2Connection* c;
+  if (master->initialized) {
+    ModelicaFormatError("Cannot add connections after the co-simulation master is initialized\n");
+    return;
+  }
+  if (fromSlave < 0 || fromSlave >= master->numberOfSlaves || toSlave < 0 || toSlave >= master->numberOfSlaves) {
+    ModelicaFormatError("Invalid connection from slave %d to slave %d, the master has %d slaves\n", fromSlave, toSlave, master->numberOfSlaves);
+    return;
+  }
+  if (master->numberOfConnections == master->connectionsSize) {
+    master->connectionsSize = master->connectionsSize ? 2*master->connectionsSize : 8;
+    master->connections = realloc(master->connections, master->connectionsSize*sizeof(FMI2Connection));
+  }
+  c = &master->connections[master->numberOfConnections++];
+  memset(c, 0, sizeof(FMI2Connection));
+  c->fromSlave = fromSlave;
+  c->fromValueReference = (fmi2_value_reference_t)fromValueReference;
+  c->toSlave = toSlave;
+  c->toValueReference = (fmi2_value_reference_t)toValueReference;
+}
+
+/*
+ * Builds the schedule, initializes all slaves with consistent connected
+ * inputs and starts the thread pool.
+ */
+void fmi2MasterInitialize_OMC(void* in_master, double tStart, int stopTimeDefined, double tStop)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  fmi2_status_t status;
+  int i, k;
+
+  buildSlaveBuffers(master);
+  buildSchedule(master);
+  master->initialized = 1;
+
+  master->canRollback = master->tolerance > 0;
+  for (i = 0; i < master->numberOfSlaves; i++) {
+    FMI2CoSimulation* FMI2CS = master->slaves[i].FMI2CS;
+    if (master->canRollback && !(FMI2CS->FMICanGetAndSetFMUstate && FMI2CS->FMICanHandleVariableCommunicationStepSize)) {
+      ModelicaFormatMessage("%s cannot get and set its state or vary its communication step size, macro steps will not be rejected\n", FMI2CS->FMIInstanceName);
+      master->canRollback = 0;
+    }
+    status = fmi2_import_setup_experiment(FMI2CS->FMIImportInstance, fmi2_false, 0.0, tStart, stopTimeDefined, tStop);
+    if (fmi2StatusIsOk(status)) {
+      status = fmi2_import_enter_initialization_mode(FMI2CS->FMIImportInstance);
+    }
+    if (!fmi2StatusIsOk(status)) {
+      ModelicaFormatError("fmi2EnterInitializationMode of %s failed with status : %s\n", FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+    }
+    FMI2CS->FMISolvingMode = fmi2_initialization_mode;
+  }
+
+  propagateConnections(master);
+
+  for (i = 0; i < master->numberOfSlaves; i++) {
+    FMI2CoSimulation* FMI2CS = master->slaves[i].FMI2CS;
+    status = fmi2_import_exit_initialization_mode(FMI2CS->FMIImportInstance);
+    if (!fmi2StatusIsOk(status)) {
+      ModelicaFormatError("fmi2ExitInitializationMode of %s failed with status : %s\n", FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+    }
+    FMI2CS->FMISolvingMode = fmi2_event_mode;
+  }
+  for (k = 0; k < master->numberOfConnections; k++) {
+    master->connections[k].time = tStart;
+    master->connections[k].hasPrevious = 0;
+  }
+  master->time = tStart;
+
+  if (master->numberOfThreads <= 0) {
+    master->numberOfThreads = master->numberOfSlaves;
+  }
+  if (master->numberOfThreads > master->numberOfSlaves) {
+    master->numberOfThreads = master->numberOfSlaves;
+  }
+  if (master->numberOfThreads > 1) {
+    master->threads = malloc((master->numberOfThreads - 1)*sizeof(pthread_t));
+    for (i = 0; i < master->numberOfThreads - 1; i++) {
+      if (pthread_create(&master->threads[i], NULL, masterWorker, master)) {
+        ModelicaFormatMessage("Could not start co-simulation worker thread, using %d threads\n", i + 1);
+        master->numberOfThreads = i + 1;
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * Performs one macro step of at most communicationStepSize.
+ * Returns the size of the accepted step, which is smaller than requested if
+ * the step was rejected.
+ */
+double fmi2MasterDoStep_OMC(void* in_master, double communicationStepSize)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  int rejections, i, k, level;
+
+  if (!master->initialized) {
+    ModelicaFormatError("fmi2MasterDoStep called before the co-simulation master is initialized\n");
+    return 0.0;
+  }
+
+  if (master->canRollback) {
+    for (i = 0; i < master->numberOfSlaves; i++) {
+      FMI2CoSimulation* FMI2CS = master->slaves[i].FMI2CS;
+      fmi2_status_t status = fmi2_import_get_fmu_state(FMI2CS->FMIImportInstance, &FMI2CS->FMIState);
+      if (!fmi2StatusIsOk(status)) {
+        ModelicaFormatError("fmi2GetFMUstate of %s failed with status : %s\n", FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+      }
+    }
+  }
+
+  master->stepSize = communicationStepSize;
+  for (rejections = 0; ; rejections++) {
+    int discarded = 0, order = 0;
+    double err = 0.0;
+    for (level = 0; level < master->numberOfLevels; level++) {
+      stepLevel(master, level);
+      for (k = master->levelIndex[level]; k < master->levelIndex[level+1]; k++) {
+        FMI2MasterSlave* slave = &master->slaves[master->levelSlaves[k]];
+        if (slave->status == fmi2_status_discard && master->canRollback) {
+          discarded = 1;
+        } else if (!fmi2StatusIsOk(slave->status)) {
+          ModelicaFormatError("fmi2DoStep of %s failed at time %g with status : %s\n", slave->FMI2CS->FMIInstanceName, master->time, fmi2_status_to_string(slave->status));
+        }
+      }
+      if (discarded) {
+        break;
+      }
+    }
+
+    if (!master->canRollback) {
+      break;
+    }
+    if (!discarded) {
+      err = extrapolationError(master, &order);
+      if (err <= 1.0) {
+        break;
+      }
+    }
+    if (rejections == master->maxRejections) {
+      ModelicaFormatMessage("Accepting macro step at time %g with step size %g after %d rejections\n", master->time, master->stepSize, rejections);
+      break;
+    }
+
+    for (i = 0; i < master->numberOfSlaves; i++) {
+      FMI2CoSimulation* FMI2CS = master->slaves[i].FMI2CS;
+      fmi2_status_t status = fmi2_import_set_fmu_state(FMI2CS->FMIImportInstance, FMI2CS->FMIState);
+      if (!fmi2StatusIsOk(status)) {
+        ModelicaFormatError("fmi2SetFMUstate of %s failed with status : %s\n", FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+      }
+    }
+    /* the extrapolation error is of order order+1 in the step size */
+    master->stepSize *= discarded ? 0.5 : fmax(0.1, fmin(0.5, 0.9 * pow(err, -1.0 / (order + 1))));
+    master->numberOfRejectedSteps++;
+  }
+
+  for (k = 0; k < master->numberOfConnections; k++) {
+    FMI2Connection* c = &master->connections[k];
+    c->previousValue = c->value;
+    c->previousTime = c->time;
+    c->hasPrevious = 1;
+    c->value = c->nextValue;
+    c->time = master->time + master->stepSize;
+  }
+  master->time += master->stepSize;
+  master->numberOfSteps++;
+  return master->stepSize;
+}
+
+/*
+ * Reads a real variable of a slave between macro steps.
+ */
+double fmi2MasterGetReal_OMC(void* in_master, int slave, int valueReference)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  fmi2_value_reference_t vr = (fmi2_value_reference_t)valueReference;
+  fmi2_real_t value = 0.0;
+  fmi2_status_t status = fmi2_import_get_real(master->slaves[slave].FMI2CS->FMIImportInstance, &vr, 1, &value);
+  if (!fmi2StatusIsOk(status)) {
+    ModelicaFormatError("fmi2GetReal of %s failed with status : %s\n", master->slaves[slave].FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+  }
+  return value;
+}
+
+/*
+ * Sets a real input or parameter of a slave between macro steps, e.g. an
+ * input that is not driven by a connection.
+ */
+void fmi2MasterSetReal_OMC(void* in_master, int slave, int valueReference, double value)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  fmi2_value_reference_t vr = (fmi2_value_reference_t)valueReference;
+  fmi2_status_t status = fmi2_import_set_real(master->slaves[slave].FMI2CS->FMIImportInstance, &vr, 1, &value);
+  if (!fmi2StatusIsOk(status)) {
+    ModelicaFormatError("fmi2SetReal of %s failed with status : %s\n", master->slaves[slave].FMI2CS->FMIInstanceName, fmi2_status_to_string(status));
+  }
+}
+
+/*
+ * Creates a master with the single slave unpacked in working_directory. Used
+ * by the Modelica model generated for an imported FMI 2.0 Co-Simulation FMU,
+ * which steps it with fmi2MasterDoStepUntil_OMC.
+ */
+void* FMI2CoSimulationStandAloneConstructor_OMC(int fmi_log_level, char* working_directory, char* instanceName, int debugLogging)
+{
+  void* master = FMI2CoSimulationMasterConstructor_OMC(fmi_log_level, fmi2_master_jacobi, 0, 0.0, 1);
+  if (fmi2MasterAddSlave_OMC(master, working_directory, instanceName, debugLogging) < 0) {
+    FMI2CoSimulationMasterDestructor_OMC(master);
+    return NULL;
+  }
+  return master;
+}
+
+/*
+ * Steps the master to the communication point tNext, with several macro
+ * steps if a step is rejected. Does nothing if the master already is at
+ * tNext, e.g. at the first sample of the generated model.
+ */
+void fmi2MasterDoStepUntil_OMC(void* in_master, double tNext)
+{
+  FMI2CoSimulationMaster* master = (FMI2CoSimulationMaster*)in_master;
+  /* the sample times of the model and the sum of the steps differ by round-off */
+  double eps = 1e-12 * fmax(1.0, fabs(tNext));
+  while (tNext - master->time > eps) {
+    fmi2MasterDoStep_OMC(master, tNext - master->time);
+  }
+}
+
+/*
+ * Wrapper for fmi2MasterGetReal_OMC with the value references and values as
+ * arrays, as passed by the generated model.
+ */
+void fmi2MasterGetRealArray_OMC(void* in_master, int slave, int numberOfValueReferences, double* realValueReferences, double flowInput, double* realValues)
+{
+  int i;
+  for (i = 0; i < numberOfValueReferences; i++) {
+    realValues[i] = fmi2MasterGetReal_OMC(in_master, slave, (int)realValueReferences[i]);
+  }
+}
+
+/*
+ * Wrapper for fmi2MasterSetReal_OMC with the value references and values as
+ * arrays, as passed by the generated model.
+ */
+void fmi2MasterSetRealArray_OMC(void* in_master, int slave, int numberOfValueReferences, double* realValueReferences, double* realValues)
+{
+  int i;
+  for (i = 0; i < numberOfValueReferences; i++) {
+    fmi2MasterSetReal_OMC(in_master, slave, (int)realValueReferences[i], realValues[i]);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,157 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF GPL VERSION 3 LICENSE OR
+ * THIS OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES RECIPIENT'S ACCEPTANCE
+ * OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3, ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from OSMC, either from the above address,
+ * from the URLs: http://www.ida.liu.se/projects/OpenModelica or
+ * http://www.openmodelica.org, and in the OpenModelica distribution.
+ * GNU version 3 is obtained from: http://www.gnu.org/copyleft/gpl.html.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ * Native master for a system of connected FMI 2.0 Co-Simulation FMUs.
+ *
+ * The master owns the slaves and the connection graph between their real
+ * outputs and inputs. Each macro step is scheduled as a sequence of levels;
+ * the slaves within one level do not depend on each other and are stepped
+ * concurrently on a small thread pool.
+ *
+ * Jacobi:       all slaves form one level and use extrapolated inputs.
+ * Gauss-Seidel: slaves are ordered along the connection graph, so a slave
+ *               uses the outputs its producers computed in the same macro
+ *               step; only connections closing an algebraic loop are
+ *               extrapolated.
+ *
+ * If every slave can get/set its FMU state and handle variable communication
+ * step sizes, a macro step whose extrapolation error exceeds the tolerance is
+ * rolled back and redone with half the step size.
+ */
+
+#ifndef FMI2COSIMULATIONMASTER__H_
+#define FMI2COSIMULATIONMASTER__H_
+
+#include <pthread.h>
+
+#include "FMI2Common.h"
+
+typedef enum {
+  fmi2_master_jacobi = 0,
+  fmi2_master_gauss_seidel
+} fmi2_master_algorithm_t;
+
+/*
+ * One connection from a real output of slave fromSlave to a real input of
+ * slave toSlave.
+ */
+typedef struct {
+  int fromSlave;
+  fmi2_value_reference_t fromValueReference;
+  int toSlave;
+  fmi2_value_reference_t toValueReference;
+  int extrapolated;         /* consumer does not wait for the producer in the current macro step */
+  double value;             /* output at the last accepted communication point */
+  double previousValue;     /* output at the communication point before */
+  double time;
+  double previousTime;
+  int hasPrevious;
+  double nextValue;         /* output at the end of the macro step in progress */
+  int isRead;               /* value was read from the producer during initialization */
+} FMI2Connection;
+
+/*
+ * Per slave data, including the value reference and value buffers of its
+ * connected inputs and outputs so a macro step does not allocate.
+ */
+typedef struct {
+  FMI2CoSimulation* FMI2CS;
+  int numberOfInputs;
+  int* inputs;              /* connection indices */
+  fmi2_value_reference_t* inputValueReferences;
+  fmi2_real_t* inputValues;
+  fmi2_real_t* inputDerivatives;
+  fmi2_integer_t* inputOrders;
+  int numberOfOutputs;
+  int* outputs;             /* connection indices */
+  fmi2_value_reference_t* outputValueReferences;
+  fmi2_real_t* outputValues;
+  int level;
+  fmi2_status_t status;
+} FMI2MasterSlave;
+
+typedef struct {
+  int FMILogLevel;
+  fmi2_master_algorithm_t algorithm;
+  int extrapolationOrder;   /* 0: hold, 1: linear */
+  double tolerance;         /* <= 0 disables step rejection */
+  int maxRejections;
+
+  FMI2MasterSlave* slaves;
+  int numberOfSlaves;
+  int slavesSize;
+  FMI2Connection* connections;
+  int numberOfConnections;
+  int connectionsSize;
+
+  /* schedule, slaves of level l are levelSlaves[levelIndex[l]..levelIndex[l+1]-1] */
+  int numberOfLevels;
+  int* levelIndex;
+  int* levelSlaves;
+
+  int canRollback;
+  int initialized;
+  double time;
+  double stepSize;
+  long numberOfSteps;
+  long numberOfRejectedSteps;
+
+  /* thread pool, the calling thread works on each level as well */
+  int numberOfThreads;
+  pthread_t* threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t workCond;
+  pthread_cond_t doneCond;
+  int nextJob;
+  int lastJob;
+  int pendingJobs;
+  int shutdown;
+} FMI2CoSimulationMaster;
+
+void* FMI2CoSimulationConstructor_OMC(int fmi_log_level, char* working_directory, char* instanceName, int debugLogging);
+void FMI2CoSimulationDestructor_OMC(void* in_fmi2cs);
+
+void* FMI2CoSimulationMasterConstructor_OMC(int fmi_log_level, int algorithm, int extrapolationOrder, double tolerance, int numberOfThreads);
+void FMI2CoSimulationMasterDestructor_OMC(void* in_master);
+int fmi2MasterAddSlave_OMC(void* in_master, char* working_directory, char* instanceName, int debugLogging);
+void fmi2MasterConnect_OMC(void* in_master, int fromSlave, int fromValueReference, int toSlave, int toValueReference);
+void fmi2MasterInitialize_OMC(void* in_master, double tStart, int stopTimeDefined, double tStop);
+double fmi2MasterDoStep_OMC(void* in_master, double communicationStepSize);
+double fmi2MasterGetReal_OMC(void* in_master, int slave, int valueReference);
+void fmi2MasterSetReal_OMC(void* in_master, int slave, int valueReference, double value);
+
+/* a master with one slave, for the model generated when importing an FMI 2.0 Co-Simulation FMU */
+void* FMI2CoSimulationStandAloneConstructor_OMC(int fmi_log_level, char* working_directory, char* instanceName, int debugLogging);
+void fmi2MasterDoStepUntil_OMC(void* in_master, double tNext);
+void fmi2MasterGetRealArray_OMC(void* in_master, int slave, int numberOfValueReferences, double* realValueReferences, double flowInput, double* realValues);
+void fmi2MasterSetRealArray_OMC(void* in_master, int slave, int numberOfValueReferences, double* realValueReferences, double* realValues);
+
+#endif
@@ -63,6 +63,26 @@ typedef struct {
   fmi2_solving_mode_t FMISolvingMode;
 } FMI2ModelExchange;
 
+/*
+ * Structure holding one FMI 2.0 Co-Simulation slave.
+ * Used by the co-simulation master, see FMI2CoSimulationMaster.h.
+ */
+typedef struct {
+  int FMILogLevel;
+  jm_callbacks JMCallbacks;
+  fmi_import_context_t* FMIImportContext;
+  fmi2_callback_functions_t FMICallbackFunctions;
+  char* FMIWorkingDirectory;
+  fmi2_import_t* FMIImportInstance;
+  char* FMIInstanceName;
+  int FMIDebugLogging;
+  int FMICanGetAndSetFMUstate;
+  int FMICanHandleVariableCommunicationStepSize;
+  int FMICanInterpolateInputs;
+  fmi2_FMU_state_t FMIState;
+  fmi2_solving_mode_t FMISolvingMode;
+} FMI2CoSimulation;
+
 void fmi2logger(fmi2_component_t c, fmi2_string_t instanceName, fmi2_status_t status, fmi2_string_t category, fmi2_string_t message, ...);
 
 #endif
@@ -0,0 +1,43 @@
+/* Stubs for the parts of the simulation and solver library that the FMI 2.0
+ * export interface calls, but that the tests of fmu2_model_interface.c do not
+ * use. The checkpoint image is stubbed by the tests that do not use it. */
+
+#include "simulation_data.h"
+#include "simulation/options.h"
+#include "simulation/simulation_input_xml.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/stateset.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/events.h"
+#include "simulation/solver/initialization/initialization.h"
+
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+
+modelica_boolean checkRelations(DATA *data) { return 0; }
+void copyStartValuestoInitValues(DATA *data) {}
+void deInitializeDataStruc(DATA *data) {}
+int freeLinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int freeMixedSystems(DATA *data, threadData_t *threadData) { return 0; }
+int freeNonlinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+void freeStateSetData(DATA *data) {}
+double getNextSampleTimeFMU(DATA *data) { return -1.0; }
+void initDelay(DATA* data, double startTime) {}
+void initSample(DATA *data, threadData_t *threadData, double start, double stop) {}
+int initialization(DATA *data, threadData_t *threadData, const char* pInitMethod, const char* pInitFile, double initTime, int lambda_steps) { return 1; }
+void initializeDataStruc(DATA *data, threadData_t *threadData) {}
+int initializeLinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int initializeMixedSystems(DATA *data, threadData_t *threadData) { return 0; }
+int initializeNonlinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+void initializeStateSetJacobians(DATA *data, threadData_t *threadData) {}
+void modelInfoInit(MODEL_DATA_XML *xml) {}
+void overwriteOldSimulationData(DATA *data) {}
+void setAllParamsToStart(DATA *data) {}
+void setAllVarsToStart(DATA* data) {}
+void setZCtol(double relativeTol) {}
+int stateSelection(DATA *data, threadData_t *threadData, char reportError, int switchStates) { return 0; }
+void storePreValues(DATA *data) {}
+void updateRelationsPre(DATA *data) {}
@@ -0,0 +1,207 @@
+/* Runs the co-simulation master with two fake slaves that replace the FMI
+ * Library: a source with the output y = 1 + t^2 and a sink that holds its
+ * input u (start value 5) and returns it as output. The sink is added first,
+ * so initialization reaches it before the source output is known, and it
+ * cannot interpolate its inputs, so it sees a zero-order hold.
+ * Checks that
+ *  - initialization does not overwrite the start value of the sink input
+ *    with a connection value that was never read,
+ *  - do_step is not told that no state will be restored if the master may
+ *    roll back,
+ *  - the step size control uses the error of the hold the sink sees,
+ *  - the stand-alone master of the generated model reaches every sample
+ *    with one macro step and does not step at the first sample, and its
+ *    array wrappers set and get the variables of the slave. */
+
+#include <stdarg.h>
+#include <math.h>
+
+#include "FMI2CoSimulationMaster.h"
+
+#define TOLERANCE 0.012
+
+enum { SINK, SOURCE };
+
+struct fmi2_import_t {
+  int kind;
+  double t;
+  double u;
+  int inputsSetToZero;
+  int discardedHistory;     /* the last do_step allowed to discard the past */
+  int restoredDiscarded;    /* set_fmu_state after such a do_step */
+};
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+void ModelicaFormatMessage(const char *string, ...)
+{
+  va_list args;
+  va_start(args, string);
+  vprintf(string, args);
+  va_end(args);
+}
+
+void ModelicaFormatError(const char *string, ...)
+{
+  va_list args;
+  va_start(args, string);
+  vfprintf(stderr, string, args);
+  va_end(args);
+  exit(1);
+}
+
+const char* fmi2_status_to_string(fmi2_status_t status)
+{
+  return status == fmi2_status_ok ? "ok" : "not ok";
+}
+
+static double output(fmi2_import_t* fmu, double t)
+{
+  return fmu->kind == SOURCE ? 1.0 + t*t : fmu->u;
+}
+
+fmi2_status_t fmi2_import_setup_experiment(fmi2_import_t* fmu, fmi2_boolean_t toleranceDefined, fmi2_real_t tolerance, fmi2_real_t startTime, fmi2_boolean_t stopTimeDefined, fmi2_real_t stopTime)
+{
+  fmu->t = startTime;
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_enter_initialization_mode(fmi2_import_t* fmu)
+{
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_exit_initialization_mode(fmi2_import_t* fmu)
+{
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_set_real(fmi2_import_t* fmu, const fmi2_value_reference_t vr[], size_t nvr, const fmi2_real_t value[])
+{
+  size_t i;
+  for (i = 0; i < nvr; i++) {
+    if (fmu->kind != SINK || vr[i] != 0) {
+      return fmi2_status_error;
+    }
+    fmu->inputsSetToZero += value[i] == 0.0;
+    fmu->u = value[i];
+  }
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_set_real_input_derivatives(fmi2_import_t* fmu, const fmi2_value_reference_t vr[], size_t nvr, const fmi2_integer_t order[], const fmi2_real_t value[])
+{
+  /* the sink cannot interpolate its inputs */
+  return fmi2_status_error;
+}
+
+fmi2_status_t fmi2_import_get_real(fmi2_import_t* fmu, const fmi2_value_reference_t vr[], size_t nvr, fmi2_real_t value[])
+{
+  size_t i;
+  for (i = 0; i < nvr; i++) {
+    value[i] = output(fmu, fmu->t);
+  }
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_do_step(fmi2_import_t* fmu, fmi2_real_t currentCommunicationPoint, fmi2_real_t communicationStepSize, fmi2_boolean_t noSetFMUStatePriorToCurrentPoint)
+{
+  fmu->t = currentCommunicationPoint + communicationStepSize;
+  fmu->discardedHistory = noSetFMUStatePriorToCurrentPoint;
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_get_fmu_state(fmi2_import_t* fmu, fmi2_FMU_state_t* s)
+{
+  if (!*s) {
+    *s = malloc(sizeof(struct fmi2_import_t));
+  }
+  memcpy(*s, fmu, sizeof(struct fmi2_import_t));
+  return fmi2_status_ok;
+}
+
+fmi2_status_t fmi2_import_set_fmu_state(fmi2_import_t* fmu, fmi2_FMU_state_t s)
+{
+  struct fmi2_import_t* state = (struct fmi2_import_t*)s;
+  fmu->restoredDiscarded += fmu->discardedHistory;
+  fmu->t = state->t;
+  fmu->u = state->u;
+  return fmi2_status_ok;
+}
+
+void* FMI2CoSimulationConstructor_OMC(int fmi_log_level, char* working_directory, char* instanceName, int debugLogging)
+{
+  FMI2CoSimulation* FMI2CS = calloc(1, sizeof(FMI2CoSimulation));
+  FMI2CS->FMIImportInstance = calloc(1, sizeof(struct fmi2_import_t));
+  FMI2CS->FMIImportInstance->kind = strcmp(working_directory, "source") ? SINK : SOURCE;
+  FMI2CS->FMIImportInstance->u = 5.0;
+  FMI2CS->FMIInstanceName = instanceName;
+  FMI2CS->FMICanGetAndSetFMUstate = 1;
+  FMI2CS->FMICanHandleVariableCommunicationStepSize = 1;
+  FMI2CS->FMICanInterpolateInputs = 0;
+  return FMI2CS;
+}
+
+void FMI2CoSimulationDestructor_OMC(void* in_fmi2cs)
+{
+  FMI2CoSimulation* FMI2CS = (FMI2CoSimulation*)in_fmi2cs;
+  free(FMI2CS->FMIState);
+  free(FMI2CS->FMIImportInstance);
+  free(FMI2CS);
+}
+
+int main()
+{
+  void* master = FMI2CoSimulationMasterConstructor_OMC(0, fmi2_master_jacobi, 1, TOLERANCE, 2);
+  int sink = fmi2MasterAddSlave_OMC(master, "sink", "sink", 0);
+  int source = fmi2MasterAddSlave_OMC(master, "source", "source", 0);
+  fmi2_import_t* sinkFMU = ((FMI2CoSimulationMaster*)master)->slaves[sink].FMI2CS->FMIImportInstance;
+  fmi2_import_t* sourceFMU = ((FMI2CoSimulationMaster*)master)->slaves[source].FMI2CS->FMIImportInstance;
+  double h, t, vr[1] = {0.0}, value[1];
+  int k;
+
+  fmi2MasterConnect_OMC(master, source, 0, sink, 0);
+  fmi2MasterInitialize_OMC(master, 0.0, 1, 1.0);
+  CHECK(sinkFMU->inputsSetToZero == 0, "initialization set the sink input to a connection value that was not read");
+  CHECK(fmi2MasterGetReal_OMC(master, sink, 1) == 1.0, "sink input after initialization is %g, expected 1", fmi2MasterGetReal_OMC(master, sink, 1));
+
+  /* [0, 0.1]: the sink holds 1, the source ends at 1.01, error 0.41 */
+  h = fmi2MasterDoStep_OMC(master, 0.1);
+  CHECK(h == 0.1, "first step has size %g, expected 0.1", h);
+
+  /* [0.1, 0.2]: the sink holds 1.01, the source ends at 1.04, error 1.23;
+   * a linear extrapolation would predict 1.02 with error 0.82 and accept.
+   * The step is redone with 0.05: the source ends at 1.0225, error 0.52 */
+  h = fmi2MasterDoStep_OMC(master, 0.1);
+  CHECK(fabs(h - 0.05) < 1e-12, "second step has size %g, expected 0.05", h);
+  CHECK(((FMI2CoSimulationMaster*)master)->numberOfRejectedSteps == 1, "%ld rejected steps, expected 1", ((FMI2CoSimulationMaster*)master)->numberOfRejectedSteps);
+  CHECK(fmi2MasterGetReal_OMC(master, sink, 1) == 1.01, "sink holds %g, expected 1.01", fmi2MasterGetReal_OMC(master, sink, 1));
+
+  CHECK(sinkFMU->restoredDiscarded + sourceFMU->restoredDiscarded == 0, "a slave was rolled back after do_step allowed it to discard its past");
+
+  FMI2CoSimulationMasterDestructor_OMC(master);
+
+  /* the source alone, sampled every 0.1 like the generated model does */
+  master = FMI2CoSimulationStandAloneConstructor_OMC(0, "source", "source", 0);
+  fmi2MasterInitialize_OMC(master, 0.0, 1, 1.0);
+  for (k = 0; k <= 3; k++) {
+    t = 0.1*k;
+    fmi2MasterDoStepUntil_OMC(master, t);
+    fmi2MasterGetRealArray_OMC(master, 0, 1, vr, 0.0, value);
+    CHECK(fabs(value[0] - (1.0 + t*t)) < 1e-12, "stand-alone source is %g at time %g, expected %g", value[0], t, 1.0 + t*t);
+  }
+  CHECK(((FMI2CoSimulationMaster*)master)->numberOfSteps == 3, "%ld macro steps for 3 samples", ((FMI2CoSimulationMaster*)master)->numberOfSteps);
+  FMI2CoSimulationMasterDestructor_OMC(master);
+
+  master = FMI2CoSimulationStandAloneConstructor_OMC(0, "sink", "sink", 0);
+  fmi2MasterInitialize_OMC(master, 0.0, 1, 1.0);
+  value[0] = 2.5;
+  fmi2MasterSetRealArray_OMC(master, 0, 1, vr, value);
+  fmi2MasterDoStepUntil_OMC(master, 0.1);
+  fmi2MasterGetRealArray_OMC(master, 0, 1, vr, 0.0, value);
+  CHECK(value[0] == 2.5, "stand-alone sink holds %g, expected 2.5", value[0]);
+  FMI2CoSimulationMasterDestructor_OMC(master);
+  return errors;
+}
@@ -0,0 +1,310 @@
+/* Compiles the FMI 2.0 export interface the way the generated code of an FMU
+ * does, for a fake model with two states, two inputs and two outputs whose
+ * value references are not in the order of INPUTS and OUTPUTS:
+ *   der(x1) = -x1 + 2*x2^2 + 3*ua        y1 = x1 + ua*ub
+ *   der(x2) = x1*x2 - ub                 y2 = sin(x2) + 4*ub
+ * with INPUTS = {ua, ub} and OUTPUTS = {y1, y2}. The symbolic Jacobians A, B,
+ * C and D of the fake model use the seed and row order of the generated
+ * code: columns in the order of STATES and INPUTS, rows in the order of
+ * STATESDERIVATIVES and OUTPUTS.
+ * Checks fmi2GetDirectionalDerivative against central differences of the
+ * model, for single columns and for general directions, once with all
+ * Jacobians and once with a Jacobian D that fails to initialize, which must
+ * fall back to finite differences. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "simulation/options.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/events.h"
+#include "simulation/solver/checkpoint.h"
+#include "fmu2_model_interface.h"
+
+/* value references */
+enum { X1, X2, DER_X1, DER_X2, UB, UA, Y2, Y1, NUM_REALS };
+
+#define MODEL_GUID "{test_directional_derivative}"
+#define MODEL_IDENTIFIER test_directional_derivative
+#define NUMBER_OF_STATES 2
+#define NUMBER_OF_EVENT_INDICATORS 0
+#define NUMBER_OF_REALS 8
+#define NUMBER_OF_INTEGERS 0
+#define NUMBER_OF_STRINGS 0
+#define NUMBER_OF_BOOLEANS 0
+#define NUMBER_OF_EXTERNALFUNCTIONS 0
+#define STATES { X1, X2 }
+#define STATESDERIVATIVES { DER_X1, DER_X2 }
+#define NUMBER_OF_INPUTS 2
+#define INPUTS { UA, UB }
+#define NUMBER_OF_OUTPUTS 2
+#define OUTPUTS { Y1, Y2 }
+
+/* as declared by the generated code, the functions not used here are stubs */
+void setStartValues(ModelInstance *comp) {}
+void setDefaultStartValues(ModelInstance *comp) {}
+void eventUpdate(ModelInstance* comp, fmi2EventInfo* eventInfo) {}
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value);
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr) { return 0; }
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value) { return fmi2Error; }
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr) { return fmi2False; }
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value) { return fmi2Error; }
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr) { return ""; }
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value) { return fmi2Error; }
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value) { return fmi2Error; }
+int checkpointSerialize(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer) { return 1; }
+int checkpointValidate(DATA *data, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+int checkpointDeserialize(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+
+#define fmu2_model_interface_setupDataStruc test_directional_derivative_setupDataStruc
+void test_directional_derivative_setupDataStruc(DATA *data) {}
+#include "fmu2_model_interface.c"
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+static modelica_real realVars[NUM_REALS];
+static int failJacobianD = 0;
+
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  return comp->fmuData->localData[0]->realVars[vr];
+}
+
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value)
+{
+  comp->fmuData->localData[0]->realVars[vr] = value;
+  return fmi2OK;
+}
+
+/* model */
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  v[DER_X1] = -v[X1] + 2.0*v[X2]*v[X2] + 3.0*v[UA];
+  v[DER_X2] = v[X1]*v[X2] - v[UB];
+  return 0;
+}
+
+static int functionAlgebraics(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  v[Y1] = v[X1] + v[UA]*v[UB];
+  v[Y2] = sin(v[X2]) + 4.0*v[UB];
+  return 0;
+}
+
+/* the Jacobians in the order of the generated code, each with a full 2x2 pattern */
+static unsigned int leadindex[] = {2, 4};
+static unsigned int rowIndex[] = {0, 1, 0, 1};
+static unsigned int colorCols[] = {1, 2};
+
+static int initialJacobian(DATA *data, int index)
+{
+  ANALYTIC_JACOBIAN *jac = &data->simulationInfo->analyticJacobians[index];
+  jac->sizeRows = 2;
+  jac->sizeCols = 2;
+  jac->sparsePattern.leadindex = leadindex;
+  jac->sparsePattern.index = rowIndex;
+  jac->sparsePattern.colorCols = colorCols;
+  jac->sparsePattern.numberOfNoneZeros = 4;
+  jac->sparsePattern.maxColors = 2;
+  jac->seedVars = (modelica_real*) calloc(2, sizeof(modelica_real));
+  jac->resultVars = (modelica_real*) calloc(2, sizeof(modelica_real));
+  return 0;
+}
+
+static int initialJacobianA(void *data, threadData_t *threadData) { return initialJacobian((DATA*) data, 0); }
+static int initialJacobianB(void *data, threadData_t *threadData) { return initialJacobian((DATA*) data, 1); }
+static int initialJacobianC(void *data, threadData_t *threadData) { return initialJacobian((DATA*) data, 2); }
+static int initialJacobianD(void *data, threadData_t *threadData) { return failJacobianD || initialJacobian((DATA*) data, 3); }
+
+/* resultVars = J * seedVars */
+static void jacobianColumn(DATA *data, int index, double j11, double j12, double j21, double j22)
+{
+  ANALYTIC_JACOBIAN *jac = &data->simulationInfo->analyticJacobians[index];
+  jac->resultVars[0] = j11*jac->seedVars[0] + j12*jac->seedVars[1];
+  jac->resultVars[1] = j21*jac->seedVars[0] + j22*jac->seedVars[1];
+}
+
+static int jacobianAColumn(void *d, threadData_t *threadData)
+{
+  DATA *data = (DATA*) d;
+  double *v = data->localData[0]->realVars;
+  jacobianColumn(data, 0, -1.0, 4.0*v[X2], v[X2], v[X1]);
+  return 0;
+}
+
+static int jacobianBColumn(void *d, threadData_t *threadData)
+{
+  jacobianColumn((DATA*) d, 1, 3.0, 0.0, 0.0, -1.0);
+  return 0;
+}
+
+static int jacobianCColumn(void *d, threadData_t *threadData)
+{
+  DATA *data = (DATA*) d;
+  double *v = data->localData[0]->realVars;
+  jacobianColumn(data, 2, 1.0, 0.0, 0.0, cos(v[X2]));
+  return 0;
+}
+
+static int jacobianDColumn(void *d, threadData_t *threadData)
+{
+  DATA *data = (DATA*) d;
+  double *v = data->localData[0]->realVars;
+  jacobianColumn(data, 3, v[UB], v[UA], 0.0, 4.0);
+  return 0;
+}
+
+static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {
+  .functionODE = functionODE,
+  .functionAlgebraics = functionAlgebraics,
+  .INDEX_JAC_A = 0,
+  .INDEX_JAC_B = 1,
+  .INDEX_JAC_C = 2,
+  .INDEX_JAC_D = 3,
+  .initialAnalyticJacobianA = initialJacobianA,
+  .initialAnalyticJacobianB = initialJacobianB,
+  .initialAnalyticJacobianC = initialJacobianC,
+  .initialAnalyticJacobianD = initialJacobianD,
+  .functionJacA_column = jacobianAColumn,
+  .functionJacB_column = jacobianBColumn,
+  .functionJacC_column = jacobianCColumn,
+  .functionJacD_column = jacobianDColumn
+};
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+static const fmi2CallbackFunctions functions = {logger, calloc, free, NULL, NULL};
+
+static const double point[NUM_REALS] = {[X1] = 0.7, [X2] = -1.3, [UA] = 0.4, [UB] = 2.5};
+
+/* central difference of an unknown in the direction dv of the knowns, leaves the variables as they are */
+static double centralDifference(DATA *data, const fmi2ValueReference known[], const double dv[], size_t nKnown, fmi2ValueReference unknown)
+{
+  const double h = 1e-6;
+  double plus, minus, backup[NUM_REALS];
+  size_t i;
+
+  memcpy(backup, realVars, sizeof(realVars));
+  memcpy(realVars, point, sizeof(realVars));
+  for (i = 0; i < nKnown; i++)
+    realVars[known[i]] += h*dv[i];
+  functionODE(data, NULL);
+  functionAlgebraics(data, NULL);
+  plus = realVars[unknown];
+
+  memcpy(realVars, point, sizeof(realVars));
+  for (i = 0; i < nKnown; i++)
+    realVars[known[i]] -= h*dv[i];
+  functionODE(data, NULL);
+  functionAlgebraics(data, NULL);
+  minus = realVars[unknown];
+
+  memcpy(realVars, backup, sizeof(realVars));
+  return (plus - minus) / (2.0*h);
+}
+
+static void checkDirectionalDerivative(ModelInstance *comp, const fmi2ValueReference known[], const double dv[], size_t nKnown, double tolerance, const char *name)
+{
+  const fmi2ValueReference unknown[] = {Y2, DER_X1, Y1, DER_X2};
+  double result[4], expected;
+  fmi2Status status;
+  size_t i;
+
+  status = fmi2GetDirectionalDerivative(comp, unknown, 4, known, nKnown, dv, result);
+  CHECK(status == fmi2OK, "%s: fmi2GetDirectionalDerivative(#r%u#, ...) returned %d", name, known[0], status);
+  for (i = 0; i < 4; i++) {
+    expected = centralDifference(comp->fmuData, known, dv, nKnown, unknown[i]);
+    CHECK(fabs(result[i] - expected) <= tolerance*(1.0 + fabs(expected)),
+          "%s: d(#r%u#)/d(#r%u#, ...) = %.10g, finite differences give %.10g", name, unknown[i], known[0], result[i], expected);
+  }
+  /* the knowns are restored */
+  CHECK(realVars[X1] == point[X1] && realVars[X2] == point[X2] && realVars[UA] == point[UA] && realVars[UB] == point[UB],
+        "%s: the knowns were changed", name);
+}
+
+static void run(int withJacobianD, double tolerance, const char *name)
+{
+  static ANALYTIC_JACOBIAN analyticJacobians[4];
+  static MODEL_DATA modelData;
+  static SIMULATION_INFO simulationInfo;
+  static SIMULATION_DATA simulationData;
+  static SIMULATION_DATA *localData[1] = {&simulationData};
+  static DATA data;
+  threadData_t threadDataOnStack = {0};
+  ModelInstance comp = {0};
+  const fmi2ValueReference knowns[] = {X1, X2, UA, UB};
+  const fmi2ValueReference direction[] = {UB, X2, UA};
+  const double dv[] = {0.3, -1.1, 2.0}, unit = 1.0;
+  int i;
+
+  memset(analyticJacobians, 0, sizeof(analyticJacobians));
+  modelData.nVariablesReal = NUM_REALS;
+  simulationInfo.analyticJacobians = analyticJacobians;
+  simulationData.realVars = realVars;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+  data.callback = &callbacks;
+  memcpy(realVars, point, sizeof(realVars));
+
+  comp.functions = &functions;
+  comp.fmuData = &data;
+  comp.threadData = &threadDataOnStack;
+  comp.state = modelContinuousTimeMode;
+  comp.logCategories[LOG_STATUSERROR] = fmi2True;
+  comp._need_update = 1;
+  comp._need_update_algebraics = 1;
+
+  failJacobianD = !withJacobianD;
+  initializeDirectionalDerivatives(&comp);
+  CHECK(comp.jacobians[3].available == withJacobianD, "%s: Jacobian D is %savailable", name, comp.jacobians[3].available ? "" : "not ");
+
+  /* column by column like an importer, then a general direction */
+  for (i = 0; i < 4; i++)
+    checkDirectionalDerivative(&comp, &knowns[i], &unit, 1, tolerance, name);
+  checkDirectionalDerivative(&comp, direction, dv, 3, tolerance, name);
+  invalidateModel(&comp);
+  checkDirectionalDerivative(&comp, direction, dv, 3, tolerance, name);
+
+  for (i = 0; i < 4; i++) {
+    free(analyticJacobians[i].seedVars);
+    free(analyticJacobians[i].resultVars);
+    if (comp.jacobians[i].values)
+      free(comp.jacobians[i].values);
+  }
+  free(comp.jac_known);
+  free(comp.jac_unknown);
+  free(comp.jac_seed);
+  free(comp.jac_result);
+  free(comp.jac_work);
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  run(1, 1e-8, "symbolic Jacobians");
+  run(0, 1e-6, "Jacobian D not available");
+  return errors;
+}
@@ -0,0 +1,310 @@
+/* Integrates a fake model with two states and an event indicator by
+ * fmi2DoStep of the FMI 2.0 export interface, with each of the co-simulation
+ * solvers:
+ *   der(x1) = -x1, x1 is reset to 1 when it falls below 0.5
+ *   der(x2) = -lambda*(x2 - cos(t))
+ * Checks that
+ *  - the solver is read from resources/<modelIdentifier>_flags.json and
+ *    explicit Euler is the default, also if a tolerance is defined; it gives
+ *    exactly the results of the fixed-step Euler steps of the interface
+ *    before the other solvers were added,
+ *  - RK23 rejects the first step, which is too long for the tolerance, and
+ *    is far more accurate than Euler,
+ *  - RK23 locates the events at ln(2) and 2*ln(2) inside the communication
+ *    steps, where Euler only finds them at the next communication point,
+ *  - implicit Euler stays stable on the stiff model (lambda = 1000) with a
+ *    communication step for which explicit Euler diverges, and also locates
+ *    the events. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/events.h"
+#include "simulation/solver/checkpoint.h"
+#include "fmu2_model_interface.h"
+
+/* value references */
+enum { X1, X2, DER_X1, DER_X2, NUM_REALS };
+
+#define MODEL_GUID "{test_do_step}"
+#define MODEL_IDENTIFIER test_do_step
+#define NUMBER_OF_STATES 2
+#define NUMBER_OF_EVENT_INDICATORS 1
+#define NUMBER_OF_REALS 4
+#define NUMBER_OF_INTEGERS 0
+#define NUMBER_OF_STRINGS 0
+#define NUMBER_OF_BOOLEANS 0
+#define NUMBER_OF_EXTERNALFUNCTIONS 0
+#define STATES { X1, X2 }
+#define STATESDERIVATIVES { DER_X1, DER_X2 }
+#define NUMBER_OF_INPUTS 0
+#define INPUTS { 0 }
+#define NUMBER_OF_OUTPUTS 0
+#define OUTPUTS { 0 }
+#define FMU_DISABLE_DIRECTIONAL_DERIVATIVES
+
+/* as declared by the generated code, the functions not used here are stubs */
+void setStartValues(ModelInstance *comp) {}
+void setDefaultStartValues(ModelInstance *comp) {}
+void eventUpdate(ModelInstance* comp, fmi2EventInfo* eventInfo) {}
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr) { return comp->fmuData->localData[0]->realVars[vr]; }
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value) { comp->fmuData->localData[0]->realVars[vr] = value; return fmi2OK; }
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr) { return 0; }
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value) { return fmi2Error; }
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr) { return fmi2False; }
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value) { return fmi2Error; }
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr) { return ""; }
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value) { return fmi2Error; }
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value) { return fmi2Error; }
+int checkpointSerialize(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer) { return 1; }
+int checkpointValidate(DATA *data, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+int checkpointDeserialize(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+
+#define fmu2_model_interface_setupDataStruc test_do_step_setupDataStruc
+void test_do_step_setupDataStruc(DATA *data) {}
+#include "fmu2_model_interface.c"
+
+#define FLAGS_FILE "test_do_step_flags.json"
+#define MAX_EVENTS 10
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* model */
+static double lambda;
+static double eventTimes[MAX_EVENTS];
+static int numEvents;
+
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  v[DER_X1] = -v[X1];
+  v[DER_X2] = -lambda*(v[X2] - cos(data->localData[0]->timeValue));
+  return 0;
+}
+
+/* the event: x1 is reset when it fell below 0.5 */
+static int functionDAE(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  if (v[X1] < 0.5) {
+    if (numEvents < MAX_EVENTS) {
+      eventTimes[numEvents] = data->localData[0]->timeValue;
+    }
+    numEvents++;
+    v[X1] = 1.0;
+  }
+  return functionODE(data, threadData);
+}
+
+static int functionZeroCrossings(DATA *data, threadData_t *threadData, double *gout)
+{
+  gout[0] = data->localData[0]->realVars[X1] - 0.5;
+  return 0;
+}
+
+static int functionNoop(DATA *data, threadData_t *threadData) { return 0; }
+
+static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {
+  .functionODE = functionODE,
+  .functionAlgebraics = functionNoop,
+  .functionDAE = functionDAE,
+  .output_function = functionNoop,
+  .function_storeDelayed = functionNoop,
+  .function_ZeroCrossings = functionZeroCrossings,
+  .checkForDiscreteChanges = functionNoop
+};
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+static const fmi2CallbackFunctions functions = {logger, calloc, free, NULL, NULL};
+
+typedef struct {
+  double x[NUMBER_OF_STATES];
+  unsigned long accepted;
+  unsigned long rejected;
+} RESULT;
+
+/* communication steps of size H from 0 to stopTime */
+static RESULT run(CoSimulationSolver solver, double lambda_, double H, double stopTime)
+{
+  static MODEL_DATA modelData;
+  static SIMULATION_INFO simulationInfo;
+  static SIMULATION_DATA simulationData;
+  static SIMULATION_DATA *localData[1] = {&simulationData};
+  static DATA data;
+  static modelica_real realVars[NUM_REALS];
+  static modelica_real zeroCrossings[NUMBER_OF_EVENT_INDICATORS];
+  threadData_t threadDataOnStack = {0};
+  ModelInstance comp = {0};
+  RESULT result = {{0}};
+  double t = 0.0, tNext;
+
+  lambda = lambda_;
+  numEvents = 0;
+  memset(realVars, 0, sizeof(realVars));
+  realVars[X1] = 1.0;
+  realVars[X2] = 1.0;
+  modelData.nVariablesReal = NUM_REALS;
+  simulationData.realVars = realVars;
+  simulationData.timeValue = 0.0;
+  simulationInfo.zeroCrossings = zeroCrossings;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+  data.callback = &callbacks;
+
+  comp.functions = &functions;
+  comp.fmuData = &data;
+  comp.threadData = &threadDataOnStack;
+  comp.type = fmi2CoSimulation;
+  comp.state = modelInstantiated;
+  comp.logCategories[LOG_STATUSERROR] = fmi2True;
+  comp._need_update = 1;
+  comp._need_update_algebraics = 1;
+  comp.solver = solver;
+
+  if (fmi2SetupExperiment(&comp, fmi2True, 1e-6, 0.0, fmi2False, 0.0) != fmi2OK) {
+    CHECK(0, "fmi2SetupExperiment failed");
+    return result;
+  }
+  comp.state = modelContinuousTimeMode;
+  fmi2GetEventIndicators(&comp, comp.event_indicators, NUMBER_OF_EVENT_INDICATORS);
+  while (t < stopTime - 0.5*H) {
+    tNext = t + H;
+    if (fmi2DoStep(&comp, t, tNext - t, fmi2True) != fmi2OK) {
+      CHECK(0, "fmi2DoStep failed at time %g", t);
+      break;
+    }
+    t = tNext;
+  }
+  fmi2GetContinuousStates(&comp, result.x, NUMBER_OF_STATES);
+  result.accepted = comp.stepsAccepted;
+  result.rejected = comp.stepsRejected;
+
+  free(comp.states);
+  free(comp.states_der);
+  free(comp.event_indicators);
+  free(comp.event_indicators_prev);
+  free(comp.rk_work);
+  free(comp.ie_jacobian);
+  free(comp.ie_pivot);
+  return result;
+}
+
+/* the communication steps of explicit Euler as fmi2DoStep did them before the other solvers */
+static void fixedStepEuler(double H, double stopTime, double *x)
+{
+  double t = 0.0, tNext, h, der[NUMBER_OF_STATES];
+  x[0] = 1.0;
+  x[1] = 1.0;
+  while (t < stopTime - 0.5*H) {
+    tNext = t + H;
+    h = tNext - t;
+    der[0] = -x[0];
+    der[1] = -(x[1] - cos(t));
+    x[0] += h*der[0];
+    x[1] += h*der[1];
+    t = tNext;
+  }
+}
+
+/* x2 with lambda = 1 */
+static double exactX2(double t)
+{
+  return 0.5*(cos(t) + sin(t)) + 0.5*exp(-t);
+}
+
+static int readSolver(const char *json, CoSimulationSolver *solver)
+{
+  ModelInstance comp = {0};
+  FILE *file = fopen(FLAGS_FILE, "w");
+  fmi2Status status;
+  fputs(json, file);
+  fclose(file);
+  comp.functions = &functions;
+  comp.solver = fmi2CoSimulationImplicitEuler;
+  status = readCoSimulationFlags(&comp, "file:.");
+  remove(FLAGS_FILE);
+  *solver = comp.solver;
+  return status == fmi2OK;
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  ModelInstance comp = {0};
+  CoSimulationSolver solver;
+  RESULT euler, rk23, impeuler;
+  double x[NUMBER_OF_STATES], rk23Events[2] = {0}, error;
+  double ln2 = log(2.0);
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  /* the option */
+  comp.functions = &functions;
+  comp.solver = fmi2CoSimulationRK23;
+  CHECK(readCoSimulationFlags(&comp, "file:.") == fmi2OK && comp.solver == fmi2CoSimulationEuler, "without %s the solver is not explicit Euler", FLAGS_FILE);
+  CHECK(readSolver("{\"s\": \"rk23\"}", &solver) && solver == fmi2CoSimulationRK23, "\"rk23\" did not select RK23");
+  CHECK(readSolver("{\"s\": \"impeuler\"}", &solver) && solver == fmi2CoSimulationImplicitEuler, "\"impeuler\" did not select implicit Euler");
+  CHECK(readSolver("{}", &solver) && solver == fmi2CoSimulationEuler, "the default solver is not explicit Euler");
+  CHECK(!readSolver("{\"s\": \"dassl\"}", &solver), "an unknown solver was accepted");
+
+  /* no events before t = 0.5: explicit Euler gives the old fixed-step results */
+  euler = run(fmi2CoSimulationEuler, 1.0, 0.1, 0.5);
+  fixedStepEuler(0.1, 0.5, x);
+  CHECK(euler.x[0] == x[0] && euler.x[1] == x[1], "explicit Euler gives %.17g %.17g, the fixed-step Euler steps %.17g %.17g",
+        euler.x[0], euler.x[1], x[0], x[1]);
+  CHECK(euler.accepted == 5 && euler.rejected == 0, "explicit Euler took %lu steps and rejected %lu, expected 5 and 0", euler.accepted, euler.rejected);
+
+  /* RK23 rejects the first steps and is accurate */
+  rk23 = run(fmi2CoSimulationRK23, 1.0, 0.1, 0.5);
+  error = fmax(fabs(rk23.x[0] - exp(-0.5)), fabs(rk23.x[1] - exactX2(0.5)));
+  CHECK(rk23.rejected > 0, "RK23 rejected no step of the length of the communication step");
+  CHECK(error < 1e-5, "the error of RK23 is %g", error);
+  CHECK(fabs(euler.x[0] - exp(-0.5)) > 100*error, "explicit Euler is as accurate as RK23");
+
+  /* RK23 locates the events inside the communication steps */
+  rk23 = run(fmi2CoSimulationRK23, 1.0, 0.1, 2.0);
+  CHECK(numEvents == 2, "RK23: %d events, expected 2", numEvents);
+  CHECK(numEvents == 2 && fabs(eventTimes[0] - ln2) < 1e-5 && fabs(eventTimes[1] - 2*ln2) < 1e-5,
+        "RK23: events at %.9g and %.9g, expected %.9g and %.9g", eventTimes[0], eventTimes[1], ln2, 2*ln2);
+  memcpy(rk23Events, eventTimes, sizeof(rk23Events));
+  error = fabs(rk23.x[0] - exp(-(2.0 - 2*ln2)));
+  CHECK(error < 1e-5, "RK23: x1 at the stop time differs by %g", error);
+  euler = run(fmi2CoSimulationEuler, 1.0, 0.1, 2.0);
+  CHECK(numEvents >= 1 && fabs(eventTimes[0] - 0.7) < 1e-12, "explicit Euler should find the first event at the communication point 0.7, not %.9g", eventTimes[0]);
+
+  /* implicit Euler on the stiff model before the first event, explicit Euler diverges */
+  euler = run(fmi2CoSimulationEuler, 1000.0, 0.01, 0.6);
+  CHECK(!(fabs(euler.x[1]) < 1e3), "explicit Euler does not diverge on the stiff model (x2 = %g)", euler.x[1]);
+  impeuler = run(fmi2CoSimulationImplicitEuler, 1000.0, 0.01, 0.6);
+  error = fabs(impeuler.x[1] - cos(0.6));
+  CHECK(error < 0.02, "implicit Euler: x2 differs from cos(0.6) by %g", error);
+  CHECK(impeuler.rejected == 0 && impeuler.accepted == 60, "implicit Euler took %lu steps and rejected %lu, expected 60 and 0",
+        impeuler.accepted, impeuler.rejected);
+  impeuler = run(fmi2CoSimulationImplicitEuler, 1000.0, 0.1, 2.0);
+  CHECK(numEvents == 2 && fabs(eventTimes[0] - ln2) < 0.05 && fabs(eventTimes[1] - 2*ln2) < 0.1,
+        "implicit Euler: %d events, at %.9g and %.9g", numEvents, eventTimes[0], eventTimes[1]);
+  CHECK(numEvents == 2 && fabs(eventTimes[0] - 0.7) > 1e-6, "implicit Euler did not locate the first event inside the communication step");
+
+  printf("RK23: %lu steps, %lu rejected, events at %.9g and %.9g\n", rk23.accepted, rk23.rejected, rk23Events[0], rk23Events[1]);
+  printf("implicit Euler: %lu steps, %lu rejected, events at %.9g and %.9g\n", impeuler.accepted, impeuler.rejected, eventTimes[0], eventTimes[1]);
+  return errors;
+}
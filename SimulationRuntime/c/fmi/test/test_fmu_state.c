@@ -0,0 +1,221 @@
+/* Gets, sets, serializes and deserializes the FMU state of a fake model with
+ * two states and a parameter, through the FMI 2.0 export interface and the
+ * checkpoint image of the simulation runtime. The memory callbacks of the
+ * environment count the blocks they hand out.
+ * Checks that
+ *  - a state restores the values it was taken from,
+ *  - the state and its image are allocated with the memory callbacks, and
+ *    an existing state is overwritten without allocating,
+ *  - a truncated state is rejected by fmi2SetFMUstate before anything of
+ *    the instance is changed,
+ *  - a serialized state with a truncated image is rejected by
+ *    fmi2DeSerializeFMUstate,
+ *  - all memory is given back by fmi2FreeFMUstate. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/events.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/nonlinearValuesList.h"
+#include "fmu2_model_interface.h"
+
+/* value references */
+enum { X1, X2, DER_X1, DER_X2, NUM_REALS };
+
+#define MODEL_GUID "{test_fmu_state}"
+#define MODEL_IDENTIFIER test_fmu_state
+#define NUMBER_OF_STATES 2
+#define NUMBER_OF_EVENT_INDICATORS 0
+#define NUMBER_OF_REALS 4
+#define NUMBER_OF_INTEGERS 0
+#define NUMBER_OF_STRINGS 0
+#define NUMBER_OF_BOOLEANS 0
+#define NUMBER_OF_EXTERNALFUNCTIONS 0
+#define STATES { X1, X2 }
+#define STATESDERIVATIVES { DER_X1, DER_X2 }
+#define NUMBER_OF_INPUTS 0
+#define INPUTS { 0 }
+#define NUMBER_OF_OUTPUTS 0
+#define OUTPUTS { 0 }
+#define FMU_DISABLE_DIRECTIONAL_DERIVATIVES
+
+/* as declared by the generated code, the functions not used here are stubs */
+void setStartValues(ModelInstance *comp) {}
+void setDefaultStartValues(ModelInstance *comp) {}
+void eventUpdate(ModelInstance* comp, fmi2EventInfo* eventInfo) {}
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr) { return comp->fmuData->localData[0]->realVars[vr]; }
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value) { return fmi2Error; }
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr) { return 0; }
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value) { return fmi2Error; }
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr) { return fmi2False; }
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value) { return fmi2Error; }
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr) { return ""; }
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value) { return fmi2Error; }
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value) { return fmi2Error; }
+
+#define fmu2_model_interface_setupDataStruc test_fmu_state_setupDataStruc
+void test_fmu_state_setupDataStruc(DATA *data) {}
+#include "fmu2_model_interface.c"
+
+/* simulation and solver library used by checkpoint.c */
+const size_t SIZERINGBUFFER = 3;
+void updateDiscreteSystem(DATA *data, threadData_t *threadData) {}
+void storeOldValues(DATA *data) {}
+void cleanValueList(VALUES_LIST *valueList, LIST_NODE* next) {}
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* memory callbacks of the environment */
+static long numAllocated = 0, numLive = 0;
+
+static void* allocateMemory(size_t nobj, size_t size)
+{
+  numAllocated++;
+  numLive++;
+  return calloc(nobj, size);
+}
+
+static void freeMemory(void *obj)
+{
+  if (obj) {
+    numLive--;
+  }
+  free(obj);
+}
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+static const fmi2CallbackFunctions functions = {logger, allocateMemory, freeMemory, NULL, NULL};
+
+static modelica_real realVars[3][NUM_REALS];
+static modelica_real realVarsOld[NUM_REALS], realVarsPre[NUM_REALS];
+static modelica_real realParameter[1];
+
+static void setValues(ModelInstance *comp, double x1, double x2, double p)
+{
+  int i;
+  for (i = 0; i < 3; i++) {
+    realVars[i][X1] = x1 - i;
+    realVars[i][X2] = x2 - i;
+  }
+  comp->fmuData->localData[0]->timeValue = x1;
+  realParameter[0] = p;
+}
+
+static int hasValues(ModelInstance *comp, double x1, double x2, double p)
+{
+  int i;
+  for (i = 0; i < 3; i++) {
+    if (realVars[i][X1] != x1 - i || realVars[i][X2] != x2 - i) {
+      return 0;
+    }
+  }
+  return comp->fmuData->localData[0]->timeValue == x1 && realParameter[0] == p;
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  static STATIC_REAL_DATA realParameterData[1];
+  static MODEL_DATA modelData;
+  static SIMULATION_INFO simulationInfo;
+  static SIMULATION_DATA simulationData[3];
+  static SIMULATION_DATA *localData[3] = {&simulationData[0], &simulationData[1], &simulationData[2]};
+  static DATA data;
+  threadData_t threadDataOnStack = {0};
+  ModelInstance comp = {0};
+  ModelInstanceState *state;
+  fmi2FMUstate s1 = NULL, s2 = NULL, s3 = NULL;
+  fmi2Byte *serialized;
+  size_t size;
+  long allocated;
+  int i;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  modelData.modelGUID = MODEL_GUID;
+  modelData.nStates = NUMBER_OF_STATES;
+  modelData.nVariablesReal = NUM_REALS;
+  modelData.nParametersReal = 1;
+  modelData.realParameterData = realParameterData;
+  for (i = 0; i < 3; i++) {
+    simulationData[i].realVars = realVars[i];
+  }
+  simulationInfo.realVarsOld = realVarsOld;
+  simulationInfo.realVarsPre = realVarsPre;
+  simulationInfo.realParameter = realParameter;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+
+  comp.functions = &functions;
+  comp.fmuData = &data;
+  comp.threadData = &threadDataOnStack;
+  comp.state = modelEventMode;
+  comp.logCategories[LOG_STATUSERROR] = fmi2True;
+
+  /* get and set */
+  setValues(&comp, 1.0, 2.0, 3.0);
+  CHECK(fmi2GetFMUstate(&comp, &s1) == fmi2OK, "fmi2GetFMUstate failed");
+  CHECK(numAllocated == 2 && numLive == 2, "fmi2GetFMUstate allocated %ld blocks with the callbacks, expected the state and its image", numAllocated);
+  setValues(&comp, 5.0, 6.0, 7.0);
+  CHECK(fmi2SetFMUstate(&comp, s1) == fmi2OK && hasValues(&comp, 1.0, 2.0, 3.0), "fmi2SetFMUstate did not restore the state");
+
+  /* an existing state is overwritten in place */
+  setValues(&comp, 5.0, 6.0, 7.0);
+  allocated = numAllocated;
+  CHECK(fmi2GetFMUstate(&comp, &s1) == fmi2OK && numAllocated == allocated, "overwriting a state allocated %ld blocks", numAllocated - allocated);
+  setValues(&comp, 1.0, 2.0, 3.0);
+  CHECK(fmi2SetFMUstate(&comp, s1) == fmi2OK && hasValues(&comp, 5.0, 6.0, 7.0), "fmi2SetFMUstate did not restore the overwritten state");
+
+  /* a truncated state changes nothing */
+  state = (ModelInstanceState*) s1;
+  state->image.size -= sizeof(double);
+  state->header.imageSize -= sizeof(double);
+  setValues(&comp, 8.0, 9.0, 10.0);
+  comp.state = modelContinuousTimeMode;
+  CHECK(fmi2SetFMUstate(&comp, s1) == fmi2Error, "fmi2SetFMUstate accepted a truncated state");
+  CHECK(hasValues(&comp, 8.0, 9.0, 10.0) && comp.state == modelContinuousTimeMode, "fmi2SetFMUstate changed the instance before it rejected a truncated state");
+  state->image.size += sizeof(double);
+  state->header.imageSize += sizeof(double);
+
+  /* serialized */
+  CHECK(fmi2GetFMUstate(&comp, &s2) == fmi2OK, "fmi2GetFMUstate failed");
+  CHECK(fmi2SerializedFMUstateSize(&comp, s2, &size) == fmi2OK, "fmi2SerializedFMUstateSize failed");
+  serialized = (fmi2Byte*) malloc(size);
+  CHECK(fmi2SerializeFMUstate(&comp, s2, serialized, size) == fmi2OK, "fmi2SerializeFMUstate failed");
+  CHECK(fmi2DeSerializeFMUstate(&comp, serialized, size, &s3) == fmi2OK, "fmi2DeSerializeFMUstate failed");
+  setValues(&comp, 1.0, 2.0, 3.0);
+  CHECK(s3 && fmi2SetFMUstate(&comp, s3) == fmi2OK && hasValues(&comp, 8.0, 9.0, 10.0), "the deserialized state did not restore the values");
+  CHECK(fmi2FreeFMUstate(&comp, &s3) == fmi2OK && s3 == NULL, "fmi2FreeFMUstate failed");
+
+  /* the header is consistent with the size, the image is truncated */
+  ((ModelInstanceStateHeader*) serialized)->imageSize -= sizeof(double);
+  CHECK(fmi2DeSerializeFMUstate(&comp, serialized, size - sizeof(double), &s3) == fmi2Error && s3 == NULL,
+        "fmi2DeSerializeFMUstate accepted a truncated image");
+  free(serialized);
+
+  fmi2FreeFMUstate(&comp, &s1);
+  fmi2FreeFMUstate(&comp, &s2);
+  fmi2FreeFMUstate(&comp, &s3);
+  CHECK(numLive == 0, "%ld blocks of the memory callbacks were not freed", numLive);
+  return errors;
+}
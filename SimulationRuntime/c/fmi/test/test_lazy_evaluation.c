@@ -0,0 +1,246 @@
+/* Benchmark and regression test of the lazy evaluation of the FMI 2.0 export
+ * interface. A fake model with four states in a chain, an input and an
+ * output is integrated by explicit Euler steps the way a model-exchange
+ * importer calls the FMU: each step sets the time, the input (which only
+ * changes every 100 steps) and the states, reads the derivatives and the
+ * output, completes the step, and then sets the unchanged states again and
+ * reads the derivatives once more, e.g. for an error estimate.
+ * The loop runs
+ *  - lazily, as fmu2_model_interface.c does,
+ *  - eagerly, with both partitions marked stale before every getter, as
+ *    if the model was evaluated on every call.
+ * The test fails if the lazy run evaluates a partition more than once per
+ * step or gives other results than the eager one. It prints the number of
+ * evaluations and the wall times of both runs. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "openmodelica.h"
+#include "openmodelica_func.h"
+#include "simulation_data.h"
+#include "util/omc_error.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/events.h"
+#include "simulation/solver/checkpoint.h"
+#include "fmu2_model_interface.h"
+
+/* value references */
+enum { X1, X2, X3, X4, DER_X1, DER_X2, DER_X3, DER_X4, U, Y, NUM_REALS };
+
+#define MODEL_GUID "{test_lazy_evaluation}"
+#define MODEL_IDENTIFIER test_lazy_evaluation
+#define NUMBER_OF_STATES 4
+#define NUMBER_OF_EVENT_INDICATORS 0
+#define NUMBER_OF_REALS 10
+#define NUMBER_OF_INTEGERS 0
+#define NUMBER_OF_STRINGS 0
+#define NUMBER_OF_BOOLEANS 0
+#define NUMBER_OF_EXTERNALFUNCTIONS 0
+#define STATES { X1, X2, X3, X4 }
+#define STATESDERIVATIVES { DER_X1, DER_X2, DER_X3, DER_X4 }
+#define NUMBER_OF_INPUTS 1
+#define INPUTS { U }
+#define NUMBER_OF_OUTPUTS 1
+#define OUTPUTS { Y }
+#define FMU_DISABLE_DIRECTIONAL_DERIVATIVES
+
+/* as declared by the generated code, the functions not used here are stubs */
+void setStartValues(ModelInstance *comp) {}
+void setDefaultStartValues(ModelInstance *comp) {}
+void eventUpdate(ModelInstance* comp, fmi2EventInfo* eventInfo) {}
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr);
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value);
+fmi2Integer getInteger(ModelInstance* comp, const fmi2ValueReference vr) { return 0; }
+fmi2Status setInteger(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Integer value) { return fmi2Error; }
+fmi2Boolean getBoolean(ModelInstance* comp, const fmi2ValueReference vr) { return fmi2False; }
+fmi2Status setBoolean(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Boolean value) { return fmi2Error; }
+fmi2String getString(ModelInstance* comp, const fmi2ValueReference vr) { return ""; }
+fmi2Status setString(ModelInstance* comp, const fmi2ValueReference vr, fmi2String value) { return fmi2Error; }
+fmi2Status setExternalFunction(ModelInstance* c, const fmi2ValueReference vr, const void* value) { return fmi2Error; }
+int checkpointSerialize(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer) { return 1; }
+int checkpointValidate(DATA *data, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+int checkpointDeserialize(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *image, size_t size) { return 1; }
+
+#define fmu2_model_interface_setupDataStruc test_lazy_evaluation_setupDataStruc
+void test_lazy_evaluation_setupDataStruc(DATA *data) {}
+#include "fmu2_model_interface.c"
+
+#define NUM_STEPS 20000
+#define STEP_SIZE 1e-3
+/* iterations of the work each evaluation of a partition stands for */
+#define WORK 2000
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+static modelica_real realVars[NUM_REALS];
+static long numODE, numAlgebraics;
+
+fmi2Real getReal(ModelInstance* comp, const fmi2ValueReference vr)
+{
+  return comp->fmuData->localData[0]->realVars[vr];
+}
+
+fmi2Status setReal(ModelInstance* comp, const fmi2ValueReference vr, const fmi2Real value)
+{
+  comp->fmuData->localData[0]->realVars[vr] = value;
+  return fmi2OK;
+}
+
+/* stands for the equations of a larger model, returns 0 */
+static double work(double v)
+{
+  volatile double sum = 0.0;
+  int i;
+  for (i = 0; i < WORK; i++)
+    sum += sin(v + i);
+  return 0.0 * sum;
+}
+
+/* model */
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  numODE++;
+  v[DER_X1] = -v[X1] + v[U] + work(v[X1]);
+  v[DER_X2] = v[X1] - v[X2];
+  v[DER_X3] = v[X2] - v[X3];
+  v[DER_X4] = v[X3] - v[X4];
+  return 0;
+}
+
+static int functionAlgebraics(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  numAlgebraics++;
+  v[Y] = v[X4] + 0.5*v[DER_X4] + work(v[X4]);
+  return 0;
+}
+
+static int functionNoop(DATA *data, threadData_t *threadData) { return 0; }
+
+static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {
+  .functionODE = functionODE,
+  .functionAlgebraics = functionAlgebraics,
+  .output_function = functionNoop,
+  .function_storeDelayed = functionNoop
+};
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+static const fmi2CallbackFunctions functions = {logger, calloc, free, NULL, NULL};
+
+typedef struct {
+  double wall;
+  long numODE;
+  long numAlgebraics;
+  double x[NUMBER_OF_STATES];
+  double y;
+} RESULT;
+
+/* marks both partitions stale as if the getter evaluated the model */
+static void markStale(ModelInstance *comp, int eager)
+{
+  if (eager) {
+    comp->_need_update = 1;
+    comp->_need_update_algebraics = 1;
+  }
+}
+
+static RESULT run(int eager)
+{
+  static MODEL_DATA modelData;
+  static SIMULATION_INFO simulationInfo;
+  static SIMULATION_DATA simulationData;
+  static SIMULATION_DATA *localData[1] = {&simulationData};
+  static DATA data;
+  threadData_t threadDataOnStack = {0};
+  ModelInstance comp = {0};
+  const fmi2ValueReference vrU = U, vrY = Y;
+  double x[NUMBER_OF_STATES] = {1.0, 0.0, 0.0, 0.0}, dx[NUMBER_OF_STATES];
+  double u = 0.0, y = 0.0, t = 0.0;
+  fmi2Boolean enterEventMode, terminateSimulation;
+  struct timespec start, stop;
+  RESULT result;
+  int step, i;
+
+  memset(realVars, 0, sizeof(realVars));
+  modelData.nVariablesReal = NUM_REALS;
+  simulationData.realVars = realVars;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+  data.callback = &callbacks;
+
+  comp.functions = &functions;
+  comp.fmuData = &data;
+  comp.threadData = &threadDataOnStack;
+  comp.state = modelContinuousTimeMode;
+  comp.logCategories[LOG_STATUSERROR] = fmi2True;
+  comp._need_update = 1;
+  comp._need_update_algebraics = 1;
+  numODE = numAlgebraics = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (step = 0; step < NUM_STEPS; step++) {
+    if (step % 100 == 0)
+      u = 1.0 + 0.01*step;
+    fmi2SetTime(&comp, t);
+    fmi2SetReal(&comp, &vrU, 1, &u);
+    fmi2SetContinuousStates(&comp, x, NUMBER_OF_STATES);
+    markStale(&comp, eager);
+    fmi2GetDerivatives(&comp, dx, NUMBER_OF_STATES);
+    markStale(&comp, eager);
+    fmi2GetReal(&comp, &vrY, 1, &y);
+    markStale(&comp, eager);
+    fmi2CompletedIntegratorStep(&comp, fmi2True, &enterEventMode, &terminateSimulation);
+
+    fmi2SetContinuousStates(&comp, x, NUMBER_OF_STATES);
+    markStale(&comp, eager);
+    fmi2GetDerivatives(&comp, dx, NUMBER_OF_STATES);
+    for (i = 0; i < NUMBER_OF_STATES; i++)
+      x[i] += STEP_SIZE*dx[i];
+    t += STEP_SIZE;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  result.wall = (stop.tv_sec - start.tv_sec) + 1e-9*(stop.tv_nsec - start.tv_nsec);
+  result.numODE = numODE;
+  result.numAlgebraics = numAlgebraics;
+  memcpy(result.x, x, sizeof(x));
+  result.y = y;
+  return result;
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  RESULT eager, lazy;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  eager = run(1);
+  lazy = run(0);
+
+  CHECK(lazy.numODE == NUM_STEPS, "%ld evaluations of the ODE partition in %d steps", lazy.numODE, NUM_STEPS);
+  CHECK(lazy.numAlgebraics == NUM_STEPS, "%ld evaluations of the algebraic partition in %d steps", lazy.numAlgebraics, NUM_STEPS);
+  CHECK(!memcmp(lazy.x, eager.x, sizeof(lazy.x)) && lazy.y == eager.y, "the lazy evaluation changed the results");
+
+  printf("%d model-exchange steps\n", NUM_STEPS);
+  printf("eager: %ld functionODE, %ld functionAlgebraics, wall %.3f s\n", eager.numODE, eager.numAlgebraics, eager.wall);
+  printf("lazy:  %ld functionODE, %ld functionAlgebraics, wall %.3f s\n", lazy.numODE, lazy.numAlgebraics, lazy.wall);
+  return errors;
+}
@@ -33,6 +33,7 @@
 #include "util/rtclock.h"
 #include "modelinfo.h"
 #include "simulation_info_json.h"
+#include "profile_aggregate.h"
 #include "simulation_runtime.h"
 #include "util/omc_mmap.h"
 #include "solver/model_help.h"
@@ -234,6 +235,55 @@ static void printVar(FILE *fout, int level, VAR_INFO* info) {
 }
 
 
+static const char *hwCounterNames[RT_HW_NUM_COUNTERS] = {"cycles", "instructions", "cacheMisses", "branchMisses"};
+
+/* Instructions per cycle and misses per 1000 instructions */
+static void hwCounterRates(int ix, double *ipc, double *cacheMPKI, double *branchMPKI)
+{
+  double cycles = rt_hw_total(ix, RT_HW_CYCLES);
+  double instructions = rt_hw_total(ix, RT_HW_INSTRUCTIONS);
+  *ipc = cycles > 0 ? instructions / cycles : 0;
+  *cacheMPKI = instructions > 0 ? 1000.0 * rt_hw_total(ix, RT_HW_CACHE_MISSES) / instructions : 0;
+  *branchMPKI = instructions > 0 ? 1000.0 * rt_hw_total(ix, RT_HW_BRANCH_MISSES) / instructions : 0;
+}
+
+static void printHwCountersXML(FILE *fout, int level, int ix)
+{
+  int i;
+  double ipc, cacheMPKI, branchMPKI;
+  if (!rt_hw_enabled()) {
+    return;
+  }
+  hwCounterRates(ix, &ipc, &cacheMPKI, &branchMPKI);
+  indent(fout,level);fprintf(fout, "<hwcounters>\n");
+  for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+    if (rt_hw_available((enum omc_rt_hwcounter_t) i)) {
+      indent(fout,level+2);fprintf(fout, "<%s>%lu</%s>\n", hwCounterNames[i], (unsigned long) rt_hw_total(ix, (enum omc_rt_hwcounter_t) i), hwCounterNames[i]);
+    }
+  }
+  indent(fout,level+2);fprintf(fout, "<ipc>%.3f</ipc>\n", ipc);
+  indent(fout,level+2);fprintf(fout, "<cacheMPKI>%.3f</cacheMPKI>\n", cacheMPKI);
+  indent(fout,level+2);fprintf(fout, "<branchMPKI>%.3f</branchMPKI>\n", branchMPKI);
+  indent(fout,level);fprintf(fout, "</hwcounters>\n");
+}
+
+static void printHwCountersJSON(FILE *fout, int ix)
+{
+  int i;
+  double ipc, cacheMPKI, branchMPKI;
+  if (!rt_hw_enabled()) {
+    return;
+  }
+  hwCounterRates(ix, &ipc, &cacheMPKI, &branchMPKI);
+  fputs(",\"hwcounters\":{", fout);
+  for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+    if (rt_hw_available((enum omc_rt_hwcounter_t) i)) {
+      fprintf(fout, "\"%s\":%lu,", hwCounterNames[i], (unsigned long) rt_hw_total(ix, (enum omc_rt_hwcounter_t) i));
+    }
+  }
+  fprintf(fout, "\"ipc\":%.3f,\"cacheMPKI\":%.3f,\"branchMPKI\":%.3f}", ipc, cacheMPKI, branchMPKI);
+}
+
 static void printFunctions(FILE *fout, FILE *plt, const char *plotFormat, const char *modelFilePrefix, DATA *data) {
   int i;
   for(i=0; i<data->modelData->modelDataXml.nFunctions; i++) {
@@ -246,6 +296,10 @@ static void printFunctions(FILE *fout, FILE *plt, const char *plotFormat, const
     indent(fout,4);fprintf(fout, "<ncall>%d</ncall>\n", (int) rt_ncall_total(i + SIM_TIMER_FIRST_FUNCTION));
     indent(fout,4);fprintf(fout, "<time>%.9f</time>\n",rt_total(i + SIM_TIMER_FIRST_FUNCTION));
     indent(fout,4);fprintf(fout, "<maxTime>%.9f</maxTime>\n",rt_max_accumulated(i + SIM_TIMER_FIRST_FUNCTION));
+    if (prof_aggregate_active()) {
+      prof_aggregate_print_xml(fout, 4, prof_aggregate_block(i));
+    }
+    printHwCountersXML(fout, 4, i + SIM_TIMER_FIRST_FUNCTION);
     printInfoTag(fout, 6, func.info);
     indent(fout,2);
     fprintf(fout, "</function>\n");
@@ -263,6 +317,10 @@ static void printProfileBlocks(FILE *fout, FILE *plt, const char *plotFormat, DA
     indent(fout,4);fprintf(fout, "<ncall>%d</ncall>\n", (int) rt_ncall_total(i + SIM_TIMER_FIRST_FUNCTION));
     indent(fout,4);fprintf(fout, "<time>%.9f</time>\n", rt_total(i + SIM_TIMER_FIRST_FUNCTION));
     indent(fout,4);fprintf(fout, "<maxTime>%.9f</maxTime>\n",rt_max_accumulated(i + SIM_TIMER_FIRST_FUNCTION));
+    if (prof_aggregate_active()) {
+      prof_aggregate_print_xml(fout, 4, prof_aggregate_block(i));
+    }
+    printHwCountersXML(fout, 4, i + SIM_TIMER_FIRST_FUNCTION);
     indent(fout,2);fprintf(fout, "</profileblock>\n");
   }
 }
@@ -318,16 +376,21 @@ int printModelInfo(DATA *data, threadData_t *threadData, const char *filename, c
 {
   static char buf[256];
   FILE *fout = fopen(filename, "w");
-  FILE *plotCommands;
+  FILE *plotCommands = NULL;
   time_t t;
   int i;
+  /* Without the per-step data there is nothing to plot and no plot file is
+   * created; the html file is still generated */
+  int rawData = !prof_aggregate_active();
+  if (rawData) {
 #if defined(__MINGW32__) || defined(_MSC_VER) || defined(NO_PIPE)
-  plotCommands = fopen(plotfile, "w");
+    plotCommands = fopen(plotfile, "w");
 #else
-  plotCommands = popen("gnuplot", "w");
+    plotCommands = popen("gnuplot", "w");
 #endif
-  if (!plotCommands) {
-    warningStreamPrint(LOG_UTIL, 0, "Plots of profiling data were disabled: %s\n", strerror(errno));
+    if (!plotCommands) {
+      warningStreamPrint(LOG_UTIL, 0, "Plots of profiling data were disabled: %s\n", strerror(errno));
+    }
   }
 
   assertStreamPrint(threadData, 0 != fout, "Failed to open %s: %s\n", filename, strerror(errno));
@@ -354,11 +417,13 @@ int printModelInfo(DATA *data, threadData_t *threadData, const char *filename, c
   {
     warningStreamPrint(LOG_UTIL, 0, "time() failed: %s", strerror(errno));
     fclose(fout);
+    if (plotCommands) {
 #if defined(__MINGW32__) || defined(_MSC_VER) || defined(NO_PIPE)
       fclose(plotCommands);
 #else
       pclose(plotCommands);
 #endif
+    }
     return 1;
   }
   if(!strftime(buf, 250, "%Y-%m-%d %H:%M:%S", localtime(&t)))
@@ -386,6 +451,12 @@ int printModelInfo(DATA *data, threadData_t *threadData, const char *filename, c
   indent(fout, 2); fprintf(fout, "<totalStepsTime>%f</totalStepsTime>\n", rt_total(SIM_TIMER_STEP));
   indent(fout, 2); fprintf(fout, "<numStep>%d</numStep>\n", (int) rt_ncall_total(SIM_TIMER_STEP));
   indent(fout, 2); fprintf(fout, "<maxTime>%.9f</maxTime>\n", rt_max_accumulated(SIM_TIMER_STEP));
+  if (prof_aggregate_active()) {
+    indent(fout, 2); fprintf(fout, "<steps>\n");
+    prof_aggregate_print_xml(fout, 4, prof_aggregate_block(-1));
+    indent(fout, 2); fprintf(fout, "</steps>\n");
+  }
+  printHwCountersXML(fout, 2, SIM_TIMER_STEP);
   fprintf(fout, "</modelinfo>\n");
 
   fprintf(fout, "<modelinfo_ext>\n");
@@ -439,14 +510,14 @@ int printModelInfo(DATA *data, threadData_t *threadData, const char *filename, c
   fprintf(fout, "</simulation>\n");
 
   fclose(fout);
-  if(plotCommands) {
+  if(plotCommands || !rawData) {
     const char *omhome = data->simulationInfo->OPENMODELICAHOME;
     char *buf = NULL;
     int genHtmlRes;
     buf = (char*)malloc(230 + 2*strlen(plotfile) + 2*(omhome ? strlen(omhome) : 0));
     assert(buf);
 #if defined(__MINGW32__) || defined(_MSC_VER) || defined(NO_PIPE)
-    if(omhome) {
+    if(plotCommands && omhome) {
 #if defined(__MINGW32__) || defined(_MSC_VER)
       sprintf(buf, "%s/lib/omc/libexec/gnuplot/binary/gnuplot.exe %s", omhome, plotfile);
 #else
@@ -458,7 +529,7 @@ int printModelInfo(DATA *data, threadData_t *threadData, const char *filename, c
       }
     }
 #else
-    if(0 != pclose(plotCommands)) {
+    if(plotCommands && 0 != pclose(plotCommands)) {
       warningStreamPrint(LOG_UTIL, 0, "Warning: Plot command failed\n");
     }
 #endif
@@ -528,10 +599,15 @@ static void printJSONFunctions(FILE *fout, DATA *data) {
     fputs(i == 0 ? "\n" : ",\n", fout);
     fprintf(fout, "{\"name\":\"");
     escapeJSON(fout, func.name);
-    fprintf(fout, "\",\"ncall\":%d,\"time\":%.9f,\"maxTime\":%.9f}",
+    fprintf(fout, "\",\"ncall\":%d,\"time\":%.9f,\"maxTime\":%.9f",
       (int) rt_ncall_total(i + SIM_TIMER_FIRST_FUNCTION),
       rt_total(i + SIM_TIMER_FIRST_FUNCTION),
       rt_max_accumulated(i + SIM_TIMER_FIRST_FUNCTION));
+    if (prof_aggregate_active()) {
+      prof_aggregate_print_json(fout, prof_aggregate_block(i));
+    }
+    printHwCountersJSON(fout, i + SIM_TIMER_FIRST_FUNCTION);
+    fputs("}", fout);
   }
 }
 
@@ -541,11 +617,16 @@ static void printJSONProfileBlocks(FILE *fout, DATA *data) {
     const struct EQUATION_INFO eq = modelInfoGetEquationIndexByProfileBlock(&data->modelData->modelDataXml, i-data->modelData->modelDataXml.nFunctions);
     rt_clear(i + SIM_TIMER_FIRST_FUNCTION);
     fputs(i == data->modelData->modelDataXml.nFunctions ? "\n" : ",\n", fout);
-    fprintf(fout, "{\"id\":%d,\"ncall\":%d,\"time\":%.9f,\"maxTime\":%.9f}",
+    fprintf(fout, "{\"id\":%d,\"ncall\":%d,\"time\":%.9f,\"maxTime\":%.9f",
       (int) eq.id,
       (int) rt_ncall_total(i + SIM_TIMER_FIRST_FUNCTION),
       rt_total(i + SIM_TIMER_FIRST_FUNCTION),
       rt_max_accumulated(i + SIM_TIMER_FIRST_FUNCTION));
+    if (prof_aggregate_active()) {
+      prof_aggregate_print_json(fout, prof_aggregate_block(i));
+    }
+    printHwCountersJSON(fout, i + SIM_TIMER_FIRST_FUNCTION);
+    fputs("}", fout);
   }
 }
 
@@ -559,7 +640,9 @@ int printModelInfoJSON(DATA *data, threadData_t *threadData, const char *filenam
   if (!fout) {
     throwStreamPrint(NULL, "Failed to open file %s for writing", filename);
   }
-  convertProfileData(data->modelData->modelFilePrefix, data->modelData->modelDataXml.nFunctions+data->modelData->modelDataXml.nProfileBlocks);
+  if (!prof_aggregate_active()) {
+    convertProfileData(data->modelData->modelFilePrefix, data->modelData->modelDataXml.nFunctions+data->modelData->modelDataXml.nProfileBlocks);
+  }
   if(time(&t) < 0)
   {
     fclose(fout);
@@ -601,6 +684,15 @@ int printModelInfoJSON(DATA *data, threadData_t *threadData, const char *filenam
   fprintf(fout, ",\n\"totalTimeProfileBlocks\":%g",totalTimeEqs); /* The overhead the profiling is huge if small equations are profiled */
   fprintf(fout, ",\n\"numStep\":%d", (int) rt_ncall_total(SIM_TIMER_STEP));
   fprintf(fout, ",\n\"maxTime\":%.9g", rt_max_accumulated(SIM_TIMER_STEP));
+  printHwCountersJSON(fout, SIM_TIMER_STEP); /* the global steps */
+  if (prof_aggregate_active()) {
+    fprintf(fout, ",\n\"steps\":{\"ncall\":%d", (int) rt_ncall_total(SIM_TIMER_STEP));
+    prof_aggregate_print_json(fout, prof_aggregate_block(-1));
+    fputs("}", fout);
+    if (prof_agg_data.windowSize > 0) {
+      prof_aggregate_print_windows_json(fout);
+    }
+  }
   fprintf(fout, ",\n\"functions\":[");
   printJSONFunctions(fout,data);
   fprintf(fout, "\n],\n\"profileBlocks\":[");
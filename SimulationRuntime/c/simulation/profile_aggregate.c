@@ -0,0 +1,225 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "profile_aggregate.h"
+#include "util/rtclock.h"
+#include "util/omc_error.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+PROF_AGG_DATA prof_agg_data = {0};
+
+static void clearBlock(PROF_AGG_BLOCK *block)
+{
+  memset(block, 0, sizeof(PROF_AGG_BLOCK));
+  block->minTime = DBL_MAX;
+}
+
+static inline int bucketIndex(double t)
+{
+  int e;
+  double ns = t*1e9;
+  if (ns < 2.0) {
+    return 0;
+  }
+  frexp(ns, &e);
+  /* ns = m*2^e with m in [0.5,1) => floor(log2(ns)) = e-1 */
+  return e-1 < PROF_AGG_NUM_BUCKETS ? e-1 : PROF_AGG_NUM_BUCKETS-1;
+}
+
+static inline void addToBlock(PROF_AGG_BLOCK *block, uint32_t ncall, double t)
+{
+  block->ncall += ncall;
+  block->nsteps++;
+  block->total += t;
+  if (t < block->minTime) {
+    block->minTime = t;
+  }
+  if (t > block->maxTime) {
+    block->maxTime = t;
+  }
+  block->histogram[bucketIndex(t)]++;
+}
+
+void prof_aggregate_init(int numBlocks, int firstTimer, double windowSize)
+{
+  int i;
+  prof_aggregate_free();
+  prof_agg_data.numBlocks = numBlocks;
+  prof_agg_data.firstTimer = firstTimer;
+  prof_agg_data.blocks = (PROF_AGG_BLOCK*) malloc(numBlocks*sizeof(PROF_AGG_BLOCK));
+  assertStreamPrint(NULL, 0 == numBlocks || 0 != prof_agg_data.blocks, "out of memory");
+  clearBlock(&prof_agg_data.step);
+  for (i=0; i<numBlocks; i++) {
+    clearBlock(prof_agg_data.blocks + i);
+  }
+  prof_agg_data.windowSize = windowSize > 0 ? windowSize : 0;
+  prof_agg_data.active = 1;
+}
+
+static PROF_AGG_WINDOW* newWindow(double time)
+{
+  PROF_AGG_WINDOW *window;
+  int n = prof_agg_data.numBlocks;
+  if (prof_agg_data.numWindows == prof_agg_data.allocWindows) {
+    prof_agg_data.allocWindows = prof_agg_data.allocWindows ? 2*prof_agg_data.allocWindows : 16;
+    prof_agg_data.windows = (PROF_AGG_WINDOW*) realloc(prof_agg_data.windows, prof_agg_data.allocWindows*sizeof(PROF_AGG_WINDOW));
+    assertStreamPrint(NULL, 0 != prof_agg_data.windows, "out of memory");
+  }
+  window = prof_agg_data.windows + prof_agg_data.numWindows++;
+  /* Align the windows to multiples of the window size */
+  window->startTime = floor(time/prof_agg_data.windowSize)*prof_agg_data.windowSize;
+  window->nsteps = 0;
+  window->stepTime = 0;
+  window->blockTime = (double*) calloc(n ? n : 1, sizeof(double));
+  window->blockNcall = (uint32_t*) calloc(n ? n : 1, sizeof(uint32_t));
+  assertStreamPrint(NULL, 0 != window->blockTime && 0 != window->blockNcall, "out of memory");
+  return window;
+}
+
+void prof_aggregate_step(double time, double stepTime)
+{
+  int i;
+  PROF_AGG_WINDOW *window = NULL;
+
+  if (!prof_agg_data.active) {
+    return;
+  }
+
+  addToBlock(&prof_agg_data.step, 1, stepTime);
+
+  if (prof_agg_data.windowSize > 0) {
+    window = prof_agg_data.numWindows ? prof_agg_data.windows + prof_agg_data.numWindows - 1 : NULL;
+    if (!window || time >= window->startTime + prof_agg_data.windowSize) {
+      window = newWindow(time);
+    }
+    window->nsteps++;
+    window->stepTime += stepTime;
+  }
+
+  for (i=0; i<prof_agg_data.numBlocks; i++) {
+    uint32_t ncall = rt_ncall(prof_agg_data.firstTimer + i);
+    double t;
+    if (0 == ncall) {
+      continue;
+    }
+    t = rt_accumulated(prof_agg_data.firstTimer + i);
+    addToBlock(prof_agg_data.blocks + i, ncall, t);
+    if (window) {
+      window->blockTime[i] += t;
+      window->blockNcall[i] += ncall;
+    }
+  }
+}
+
+void prof_aggregate_free()
+{
+  int i;
+  for (i=0; i<prof_agg_data.numWindows; i++) {
+    free(prof_agg_data.windows[i].blockTime);
+    free(prof_agg_data.windows[i].blockNcall);
+  }
+  free(prof_agg_data.windows);
+  free(prof_agg_data.blocks);
+  memset(&prof_agg_data, 0, sizeof(PROF_AGG_DATA));
+}
+
+const PROF_AGG_BLOCK* prof_aggregate_block(int i)
+{
+  return i < 0 ? &prof_agg_data.step : prof_agg_data.blocks + i;
+}
+
+static int lastNonEmptyBucket(const PROF_AGG_BLOCK *block)
+{
+  int i;
+  for (i=PROF_AGG_NUM_BUCKETS-1; i>=0; i--) {
+    if (block->histogram[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Prints the aggregated fields of a block; to be appended to an existing JSON object */
+void prof_aggregate_print_json(FILE *fout, const PROF_AGG_BLOCK *block)
+{
+  int i, last = lastNonEmptyBucket(block);
+  fprintf(fout, ",\"nsteps\":%lu,\"minTime\":%.9f,\"meanTime\":%.9f,\"histogram\":[",
+    (unsigned long) block->nsteps,
+    block->nsteps ? block->minTime : 0.0,
+    block->nsteps ? block->total/block->nsteps : 0.0);
+  for (i=0; i<=last; i++) {
+    fprintf(fout, i ? ",%lu" : "%lu", (unsigned long) block->histogram[i]);
+  }
+  fputs("]", fout);
+}
+
+static void indent(FILE *fout, int n) {
+  while(n--) fputc(' ', fout);
+}
+
+void prof_aggregate_print_xml(FILE *fout, int level, const PROF_AGG_BLOCK *block)
+{
+  int i, last = lastNonEmptyBucket(block);
+  indent(fout,level);fprintf(fout, "<nsteps>%lu</nsteps>\n", (unsigned long) block->nsteps);
+  indent(fout,level);fprintf(fout, "<minTime>%.9f</minTime>\n", block->nsteps ? block->minTime : 0.0);
+  indent(fout,level);fprintf(fout, "<meanTime>%.9f</meanTime>\n", block->nsteps ? block->total/block->nsteps : 0.0);
+  indent(fout,level);fprintf(fout, "<histogram>\n");
+  for (i=0; i<=last; i++) {
+    if (block->histogram[i]) {
+      indent(fout,level+2);fprintf(fout, "<bucket min=\"%g\" max=\"%g\" count=\"%lu\"/>\n", i ? ldexp(1e-9, i) : 0.0, ldexp(1e-9, i+1), (unsigned long) block->histogram[i]);
+    }
+  }
+  indent(fout,level);fprintf(fout, "</histogram>\n");
+}
+
+void prof_aggregate_print_windows_json(FILE *fout)
+{
+  int i, j;
+  fprintf(fout, ",\n\"windowSize\":%g", prof_agg_data.windowSize);
+  fprintf(fout, ",\n\"windows\":[");
+  for (i=0; i<prof_agg_data.numWindows; i++) {
+    const PROF_AGG_WINDOW *window = prof_agg_data.windows + i;
+    fputs(i == 0 ? "\n" : ",\n", fout);
+    fprintf(fout, "{\"startTime\":%.12g,\"nsteps\":%lu,\"stepTime\":%.9f,\"ncall\":[", window->startTime, (unsigned long) window->nsteps, window->stepTime);
+    for (j=0; j<prof_agg_data.numBlocks; j++) {
+      fprintf(fout, j ? ",%lu" : "%lu", (unsigned long) window->blockNcall[j]);
+    }
+    fputs("],\"time\":[", fout);
+    for (j=0; j<prof_agg_data.numBlocks; j++) {
+      fprintf(fout, j ? ",%.9f" : "%.9f", window->blockTime[j]);
+    }
+    fputs("]}", fout);
+  }
+  fputs("\n]", fout);
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Aggregated time measurements.
+ *
+ * Instead of writing the ncall/time data of every function and profile block
+ * for every global step to disk (see -measureTimeRaw), the statistics are
+ * aggregated in memory: number of calls, total, min and max time per step and
+ * a histogram with logarithmic buckets. Optionally the data is also sampled in
+ * windows of simulation time (-measureTimeWindow).
+ */
+
+#ifndef __SIMULATION_PROFILE_AGGREGATE__H
+#define __SIMULATION_PROFILE_AGGREGATE__H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bucket k holds the steps with a time in [2^k, 2^(k+1)) ns; bucket 0 also
+ * holds everything below 2 ns and the last bucket everything above. */
+#define PROF_AGG_NUM_BUCKETS 48
+
+typedef struct PROF_AGG_BLOCK
+{
+  uint64_t ncall;       /* total number of calls */
+  uint32_t nsteps;      /* number of global steps with at least one call */
+  double total;         /* total time */
+  double minTime;       /* minimum accumulated time during one step */
+  double maxTime;       /* maximum accumulated time during one step */
+  uint32_t histogram[PROF_AGG_NUM_BUCKETS];
+} PROF_AGG_BLOCK;
+
+typedef struct PROF_AGG_WINDOW
+{
+  double startTime;     /* simulation time of the first step in the window */
+  uint32_t nsteps;
+  double stepTime;      /* time spent in the global steps of the window */
+  double *blockTime;    /* time per function/profile block */
+  uint32_t *blockNcall; /* calls per function/profile block */
+} PROF_AGG_WINDOW;
+
+typedef struct PROF_AGG_DATA
+{
+  int active;
+  int numBlocks;        /* nFunctions + nProfileBlocks */
+  int firstTimer;       /* rtclock index of the first block */
+  PROF_AGG_BLOCK step;  /* the global steps */
+  PROF_AGG_BLOCK *blocks;
+
+  double windowSize;    /* 0 disables the sampled windows */
+  int numWindows;
+  int allocWindows;
+  PROF_AGG_WINDOW *windows;
+} PROF_AGG_DATA;
+
+extern PROF_AGG_DATA prof_agg_data;
+
+void prof_aggregate_init(int numBlocks, int firstTimer, double windowSize);
+/* Collects the rt_ncall/rt_accumulated values of the current global step */
+void prof_aggregate_step(double time, double stepTime);
+void prof_aggregate_free();
+
+static inline int prof_aggregate_active()
+{
+  return prof_agg_data.active;
+}
+
+/* Returns the block for function/profile block i or the global steps for i=-1 */
+const PROF_AGG_BLOCK* prof_aggregate_block(int i);
+
+void prof_aggregate_print_json(FILE *fout, const PROF_AGG_BLOCK *block);
+void prof_aggregate_print_xml(FILE *fout, int level, const PROF_AGG_BLOCK *block);
+void prof_aggregate_print_windows_json(FILE *fout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,7 @@
  */
 
 #include "simulation_result.h"
+#include "util/rtclock.h"
 
 extern "C" {
 
@@ -37,10 +38,23 @@ static void sim_result_doNothing(simulation_result* self, DATA *data, threadData
   /* Do nothing */
 }
 
-simulation_result sim_result = {
+double sim_result_cpuTime(simulation_result *self)
+{
+  double cpuTimeValue;
+  if (self->rowCpuTime) {
+    return *self->rowCpuTime;
+  }
+  rt_accumulate(SIM_TIMER_TOTAL);
+  cpuTimeValue = rt_accumulated(SIM_TIMER_TOTAL);
+  rt_tick(SIM_TIMER_TOTAL);
+  return cpuTimeValue;
+}
+
+OMC_THREAD_LOCAL simulation_result sim_result = {
   NULL, /* filename */
   0, /* numpoints */
   0, /* cpuTime */
+  NULL, /* rowCpuTime */
   NULL, /* extra data */
   sim_result_doNothing, /* init */
   sim_result_doNothing, /* emit */
@@ -42,6 +42,7 @@ typedef struct simulation_result {
   const char *filename;
   long numpoints;
   int cpuTime;
+  const double *rowCpuTime; /* if set, the cpu time of the emitted row, taken when the simulation thread queued it */
   void *storage; /* Internal data used for each storage scheme */
   void (*init)(struct simulation_result*,DATA*,threadData_t *threadData);
   void (*emit)(struct simulation_result*,DATA*,threadData_t *threadData);
@@ -49,7 +50,11 @@ typedef struct simulation_result {
   void (*free)(struct simulation_result*,DATA*,threadData_t *threadData);
 } simulation_result;
 
-extern simulation_result sim_result;
+/* the cpu time column of the emitted row */
+double sim_result_cpuTime(simulation_result *self);
+
+/* the result of the simulation running in the current thread */
+extern OMC_THREAD_LOCAL simulation_result sim_result;
 
 #ifdef __cplusplus
 }
@@ -61,9 +61,7 @@ void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
   double cpuTimeValue = 0;
   rt_tick(SIM_TIMER_OUTPUT);
 
-  rt_accumulate(SIM_TIMER_TOTAL);
-  cpuTimeValue = rt_accumulated(SIM_TIMER_TOTAL);
-  rt_tick(SIM_TIMER_TOTAL);
+  cpuTimeValue = sim_result_cpuTime(self);
 
   fprintf(fout, format, data->localData[0]->timeValue);
   if(self->cpuTime)
@@ -310,9 +310,7 @@ void mat4_emit(simulation_result *self,DATA *data, threadData_t *threadData)
   double datPoint=0;
   rt_tick(SIM_TIMER_OUTPUT);
 
-  rt_accumulate(SIM_TIMER_TOTAL);
-  double cpuTimeValue = rt_accumulated(SIM_TIMER_TOTAL);
-  rt_tick(SIM_TIMER_TOTAL);
+  double cpuTimeValue = sim_result_cpuTime(self);
 
   /* this is done wrong -- a buffering should be used
      although ofstream does have some buffering, but it is not enough and
@@ -109,9 +109,7 @@ static void add_result(simulation_result *self,DATA *data,double *data_, long *a
   int i;
   double cpuTimeValue = 0;
 
-  rt_accumulate(SIM_TIMER_TOTAL);
-  cpuTimeValue = rt_accumulated(SIM_TIMER_TOTAL);
-  rt_tick(SIM_TIMER_TOTAL);
+  cpuTimeValue = sim_result_cpuTime(self);
 
   {
     data_[pltData->currentPos++] = simData->localData[0]->timeValue;
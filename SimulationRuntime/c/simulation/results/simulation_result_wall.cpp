@@ -57,55 +57,48 @@ typedef struct wall_storage {
   std::ofstream fp;
   long header_length;
   long data_start;
+  char buffer[9];                 /* scratch for the type byte and the big-endian value of a msgpack item */
 } wall_storage;
 
-static void msgpack_obj_header(std::ofstream &fp, int n) {
-  static char buffer[1];
-  static int32_t ibuffer;
-  buffer[0] = 0xDF;
-  ibuffer = htonl(n);
-  fp.write(buffer, 1);
-  fp.write((char *)&ibuffer, 4);
+static void msgpack_obj_header(wall_storage *storage, int n) {
+  int32_t ibuffer = htonl(n);
+  storage->buffer[0] = 0xDF;
+  memcpy(storage->buffer+1, &ibuffer, 4);
+  storage->fp.write(storage->buffer, 5);
 }
 
-static void msgpack_array_header(std::ofstream &fp, int n) {
-  static char buffer[1];
-  static int32_t ibuffer;
-  buffer[0] = 0xDD;
-  ibuffer = htonl(n);
-  fp.write(buffer, 1);
-  fp.write((char *)&ibuffer, 4);
+static void msgpack_array_header(wall_storage *storage, int n) {
+  int32_t ibuffer = htonl(n);
+  storage->buffer[0] = 0xDD;
+  memcpy(storage->buffer+1, &ibuffer, 4);
+  storage->fp.write(storage->buffer, 5);
 }
 
-static void msgpack_int32(std::ofstream &fp, int32_t n) {
-  static char buffer[1];
-  static int32_t ibuffer;
-  buffer[0] = 0xd2;
-  ibuffer = htonl(n);
-  fp.write(buffer, 1);
-  fp.write((char *)&ibuffer, 4);
+static void msgpack_int32(wall_storage *storage, int32_t n) {
+  int32_t ibuffer = htonl(n);
+  storage->buffer[0] = 0xd2;
+  memcpy(storage->buffer+1, &ibuffer, 4);
+  storage->fp.write(storage->buffer, 5);
 }
 
-static void msgpack_boolean(std::ofstream &fp, bool b) {
-  static char buffer[1];
-  if (b) buffer[0] = 0xc3;
-  else buffer[0] = 0xc2;
-  fp.write(buffer, 1);
+static void msgpack_boolean(wall_storage *storage, bool b) {
+  if (b) storage->buffer[0] = 0xc3;
+  else storage->buffer[0] = 0xc2;
+  storage->fp.write(storage->buffer, 1);
 }
 
-static void raw_uint32(std::ofstream &fp, uint32_t n) {
-  static uint32_t ibuffer;
-  ibuffer = htonl(n);
-  fp.write((char *)&ibuffer, 4);
+static void raw_uint32(wall_storage *storage, uint32_t n) {
+  uint32_t ibuffer = htonl(n);
+  memcpy(storage->buffer, &ibuffer, 4);
+  storage->fp.write(storage->buffer, 4);
 }
 
-static void msgpack_str(std::ofstream &fp, const char *s) {
-  static char buffer[1];
+static void msgpack_str(wall_storage *storage, const char *s) {
   int strl = htonl(strlen(s));
-  buffer[0] = 0xDB;
-  fp.write(buffer, 1);
-  fp.write((char*)&strl, 4);
-  fp.write(s, strlen(s));
+  storage->buffer[0] = 0xDB;
+  memcpy(storage->buffer+1, &strl, 4);
+  storage->fp.write(storage->buffer, 5);
+  storage->fp.write(s, strlen(s));
 }
 
 static void marshall_double(double d, char *buffer) {
@@ -114,34 +107,30 @@ static void marshall_double(double d, char *buffer) {
   else for(int i=0;i<8;i++) buffer[7-i] = b[i];
 }
 
-static void msgpack_double(std::ofstream &fp, double d) {
-  static char buffer[1];
-  static char dbuffer[8];
-
-  buffer[0] = 0xcb;
-  marshall_double(d, dbuffer);
-  fp.write(buffer, 1);
-  fp.write(dbuffer, 8);
+static void msgpack_double(wall_storage *storage, double d) {
+  storage->buffer[0] = 0xcb;
+  marshall_double(d, storage->buffer+1);
+  storage->fp.write(storage->buffer, 9);
 }
 
-static void write_description(std::ofstream &fp, const char *name, const char *comment) {
-  msgpack_str(fp, name); // key
-  msgpack_obj_header(fp, 1); // value (is an object of one field)
-  msgpack_str(fp, "description"); // field name
-  msgpack_str(fp, comment); // field value
+static void write_description(wall_storage *storage, const char *name, const char *comment) {
+  msgpack_str(storage, name); // key
+  msgpack_obj_header(storage, 1); // value (is an object of one field)
+  msgpack_str(storage, "description"); // field name
+  msgpack_str(storage, comment); // field value
 }
 
-static void write_alias(std::ofstream &fp, const char *name, const char *sig, bool negate) {
-  msgpack_str(fp, name); // alias name
-  msgpack_obj_header(fp, negate ? 2 : 1);
-  msgpack_str(fp, "s");
-  msgpack_str(fp, sig);
-  if (negate) { msgpack_str(fp, "t"); msgpack_str(fp, "inv"); }
+static void write_alias(wall_storage *storage, const char *name, const char *sig, bool negate) {
+  msgpack_str(storage, name); // alias name
+  msgpack_obj_header(storage, negate ? 2 : 1);
+  msgpack_str(storage, "s");
+  msgpack_str(storage, sig);
+  if (negate) { msgpack_str(storage, "t"); msgpack_str(storage, "inv"); }
 }
 
-static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[]) {
+static void write_aliases(wall_storage *storage, MODEL_DATA *modelData, int include[]) {
   const char *sig = NULL;
-  msgpack_str(fp, "als");
+  msgpack_str(storage, "als");
   int na = 0; // Number of aliases (include time) for this request
   for(long i=0;i<modelData->nAliasReal;i++)
     na += include[(int)modelData->realAlias[i].aliasType];
@@ -152,7 +141,7 @@ static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[
   for(long i=0;i<modelData->nAliasString;i++)
     na += include[(int)modelData->stringAlias[i].aliasType];
 
-  msgpack_obj_header(fp, na);
+  msgpack_obj_header(storage, na);
 
   for(long i=0;i<modelData->nAliasReal;i++) {
     DATA_REAL_ALIAS *alias = &modelData->realAlias[i];
@@ -160,7 +149,7 @@ static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[
     if (alias->aliasType==2) sig = "time";
     if (alias->aliasType==1) sig = modelData->realParameterData[alias->nameID].info.name;
     if (alias->aliasType==0) sig = modelData->realVarsData[alias->nameID].info.name;
-    write_alias(fp, alias->info.name, sig, alias->negate);
+    write_alias(storage, alias->info.name, sig, alias->negate);
   }
 
   for(long i=0;i<modelData->nAliasInteger;i++) {
@@ -169,7 +158,7 @@ static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[
     if (alias->aliasType==2) sig = "time";
     if (alias->aliasType==1) sig = modelData->integerParameterData[alias->nameID].info.name;
     if (alias->aliasType==0) sig = modelData->integerVarsData[alias->nameID].info.name;
-    write_alias(fp, alias->info.name, sig, alias->negate);
+    write_alias(storage, alias->info.name, sig, alias->negate);
   }
 
   for(long i=0;i<modelData->nAliasBoolean;i++) {
@@ -178,7 +167,7 @@ static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[
     if (alias->aliasType==2) sig = "time";
     if (alias->aliasType==1) sig = modelData->booleanParameterData[alias->nameID].info.name;
     if (alias->aliasType==0) sig = modelData->booleanVarsData[alias->nameID].info.name;
-    write_alias(fp, alias->info.name, sig, alias->negate);
+    write_alias(storage, alias->info.name, sig, alias->negate);
   }
 
   for(long i=0;i<modelData->nAliasString;i++) {
@@ -187,107 +176,105 @@ static void write_aliases(std::ofstream &fp, MODEL_DATA *modelData, int include[
     if (alias->aliasType==2) sig = "time";
     if (alias->aliasType==1) sig = modelData->stringParameterData[alias->nameID].info.name;
     if (alias->aliasType==0) sig = modelData->stringVarsData[alias->nameID].info.name;
-    write_alias(fp, alias->info.name, sig, alias->negate);
+    write_alias(storage, alias->info.name, sig, alias->negate);
   }
 }
 
-static void write_param_table(std::ofstream &fp, MODEL_DATA *modelData) {
-  msgpack_str(fp, PARAM_TABLE_NAME);
-  msgpack_obj_header(fp, 4); // params
+static void write_param_table(wall_storage *storage, MODEL_DATA *modelData) {
+  msgpack_str(storage, PARAM_TABLE_NAME);
+  msgpack_obj_header(storage, 4); // params
 
-  msgpack_str(fp, "tmeta");
-  msgpack_obj_header(fp, 0); // tmeta
+  msgpack_str(storage, "tmeta");
+  msgpack_obj_header(storage, 0); // tmeta
 
-  msgpack_str(fp, "sigs");
-  msgpack_array_header(fp, 1+modelData->nParametersReal+modelData->nParametersInteger+
+  msgpack_str(storage, "sigs");
+  msgpack_array_header(storage, 1+modelData->nParametersReal+modelData->nParametersInteger+
     modelData->nParametersBoolean+modelData->nParametersString);
-  msgpack_str(fp, "time");
+  msgpack_str(storage, "time");
   for(long i=0;i<modelData->nParametersReal;i++)
-    msgpack_str(fp, modelData->realParameterData[i].info.name);
+    msgpack_str(storage, modelData->realParameterData[i].info.name);
   for(long i=0;i<modelData->nParametersInteger;i++)
-    msgpack_str(fp, modelData->integerParameterData[i].info.name);
+    msgpack_str(storage, modelData->integerParameterData[i].info.name);
   for(long i=0;i<modelData->nParametersBoolean;i++)
-    msgpack_str(fp, modelData->booleanParameterData[i].info.name);
+    msgpack_str(storage, modelData->booleanParameterData[i].info.name);
   for(long i=0;i<modelData->nParametersString;i++)
-    msgpack_str(fp, modelData->stringParameterData[i].info.name);
+    msgpack_str(storage, modelData->stringParameterData[i].info.name);
 
   int include[3] = {0, 1, 0};
-  write_aliases(fp, modelData, include);
+  write_aliases(storage, modelData, include);
 
-  msgpack_str(fp, "vmeta");
-  msgpack_obj_header(fp, 1+modelData->nParametersReal+modelData->nParametersInteger+
+  msgpack_str(storage, "vmeta");
+  msgpack_obj_header(storage, 1+modelData->nParametersReal+modelData->nParametersInteger+
     modelData->nParametersBoolean+modelData->nParametersString);
-  write_description(fp, "time", "Time");
+  write_description(storage, "time", "Time");
   for(long i=0;i<modelData->nParametersReal;i++)
-    write_description(fp, modelData->realParameterData[i].info.name,
+    write_description(storage, modelData->realParameterData[i].info.name,
           modelData->realParameterData[i].info.comment);
   for(long i=0;i<modelData->nParametersInteger;i++)
-    write_description(fp, modelData->integerParameterData[i].info.name,
+    write_description(storage, modelData->integerParameterData[i].info.name,
           modelData->integerParameterData[i].info.comment);
   for(long i=0;i<modelData->nParametersBoolean;i++)
-    write_description(fp, modelData->booleanParameterData[i].info.name,
+    write_description(storage, modelData->booleanParameterData[i].info.name,
           modelData->booleanParameterData[i].info.comment);
   for(long i=0;i<modelData->nParametersString;i++)
-    write_description(fp, modelData->stringParameterData[i].info.name,
+    write_description(storage, modelData->stringParameterData[i].info.name,
           modelData->stringParameterData[i].info.comment);
 }
 
-static void write_cont_table(std::ofstream &fp, MODEL_DATA *modelData) {
+static void write_cont_table(wall_storage *storage, MODEL_DATA *modelData) {
   long nvars = modelData->nVariablesReal+modelData->nVariablesInteger+
     modelData->nVariablesBoolean+modelData->nVariablesString;
-  msgpack_str(fp, "continuous");
-  msgpack_obj_header(fp, 4); // params
+  msgpack_str(storage, "continuous");
+  msgpack_obj_header(storage, 4); // params
 
-  msgpack_str(fp, "tmeta");
-  msgpack_obj_header(fp, 0); // tmeta
+  msgpack_str(storage, "tmeta");
+  msgpack_obj_header(storage, 0); // tmeta
 
-  msgpack_str(fp, "sigs");
-  msgpack_array_header(fp, nvars+1);
-  msgpack_str(fp, "time");
+  msgpack_str(storage, "sigs");
+  msgpack_array_header(storage, nvars+1);
+  msgpack_str(storage, "time");
   for(long i=0;i<modelData->nVariablesReal;i++)
-    msgpack_str(fp, modelData->realVarsData[i].info.name);
+    msgpack_str(storage, modelData->realVarsData[i].info.name);
   for(long i=0;i<modelData->nVariablesInteger;i++)
-    msgpack_str(fp, modelData->integerVarsData[i].info.name);
+    msgpack_str(storage, modelData->integerVarsData[i].info.name);
   for(long i=0;i<modelData->nVariablesBoolean;i++)
-    msgpack_str(fp, modelData->booleanVarsData[i].info.name);
+    msgpack_str(storage, modelData->booleanVarsData[i].info.name);
   for(long i=0;i<modelData->nVariablesString;i++)
-    msgpack_str(fp, modelData->stringVarsData[i].info.name);
+    msgpack_str(storage, modelData->stringVarsData[i].info.name);
 
   int include[3] = {1, 0, 1};
-  write_aliases(fp, modelData, include);
+  write_aliases(storage, modelData, include);
 
-  msgpack_str(fp, "vmeta");
-  msgpack_obj_header(fp, 1+nvars);
-  write_description(fp, "time", "Time");
+  msgpack_str(storage, "vmeta");
+  msgpack_obj_header(storage, 1+nvars);
+  write_description(storage, "time", "Time");
   for(long i=0;i<modelData->nVariablesReal;i++)
-    write_description(fp, modelData->realVarsData[i].info.name,
+    write_description(storage, modelData->realVarsData[i].info.name,
           modelData->realVarsData[i].info.comment);
   for(long i=0;i<modelData->nVariablesInteger;i++)
-    write_description(fp, modelData->integerVarsData[i].info.name,
+    write_description(storage, modelData->integerVarsData[i].info.name,
           modelData->integerVarsData[i].info.comment);
   for(long i=0;i<modelData->nVariablesBoolean;i++)
-    write_description(fp, modelData->booleanVarsData[i].info.name,
+    write_description(storage, modelData->booleanVarsData[i].info.name,
           modelData->booleanVarsData[i].info.comment);
   for(long i=0;i<modelData->nVariablesString;i++)
-    write_description(fp, modelData->stringVarsData[i].info.name,
+    write_description(storage, modelData->stringVarsData[i].info.name,
           modelData->stringVarsData[i].info.comment);
 }
 
-static void write_header(std::ofstream &fp, MODEL_DATA *modelData) {
-  static char buffer[80];
-
-  msgpack_obj_header(fp, 3); // header
+static void write_header(wall_storage *storage, MODEL_DATA *modelData) {
+  msgpack_obj_header(storage, 3); // header
 
-  msgpack_str(fp, "fmeta");
-  msgpack_obj_header(fp, 0); // fmeta
+  msgpack_str(storage, "fmeta");
+  msgpack_obj_header(storage, 0); // fmeta
 
-  msgpack_str(fp, "tabs");
-  msgpack_obj_header(fp, 2); // tabs
-  write_param_table(fp, modelData);
-  write_cont_table(fp, modelData);
+  msgpack_str(storage, "tabs");
+  msgpack_obj_header(storage, 2); // tabs
+  write_param_table(storage, modelData);
+  write_cont_table(storage, modelData);
 
-  msgpack_str(fp, "objs");
-  msgpack_obj_header(fp, 0); // objs
+  msgpack_str(storage, "objs");
+  msgpack_obj_header(storage, 0); // objs
 }
 
 /* The purpose of this routine is to do the following (in order):
@@ -300,9 +287,9 @@ static void write_header(std::ofstream &fp, MODEL_DATA *modelData) {
 void recon_wall_init(simulation_result *self,DATA *data, threadData_t *threadData)
 {
   wall_storage *storage = new wall_storage();
-  static char header[14] = {0x72, 0x65, 0x63, 0x6f, 0x6e, 0x3a, 0x77,
+  static const char header[14] = {0x72, 0x65, 0x63, 0x6f, 0x6e, 0x3a, 0x77,
           0x61, 0x6c, 0x6c, 0x3a, 0x76, 0x30, 0x31};
-  static char blank_length[4] = {0x00, 0x00, 0x00, 0x00};
+  static const char blank_length[4] = {0x00, 0x00, 0x00, 0x00};
   self->storage = (void *)storage;
   try {
     storage->fp.open(self->filename, std::ofstream::binary|std::ofstream::trunc);
@@ -316,11 +303,11 @@ void recon_wall_init(simulation_result *self,DATA *data, threadData_t *threadDat
     /* Fill in empty length info (to be filled in later, after header is written) */
     storage->fp.write(blank_length, 4);
     /* Write header */
-    write_header(storage->fp, data->modelData);
+    write_header(storage, data->modelData);
     storage->data_start = storage->fp.tellp();
     uint32_t sz = storage->data_start-(storage->header_length+4);
     storage->fp.seekp(storage->header_length);
-    raw_uint32(storage->fp, sz);
+    raw_uint32(storage, sz);
     storage->fp.seekp(storage->data_start);
   }
   catch(...)
@@ -331,40 +318,40 @@ void recon_wall_init(simulation_result *self,DATA *data, threadData_t *threadDat
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
 
-void write_parameter_data(std::ofstream &fp, double t,
+static void write_parameter_data(wall_storage *storage, double t,
         MODEL_DATA *modelData, const SIMULATION_INFO *sInfo) {
+  std::ofstream &fp = storage->fp;
   long i;
 
   long length_pos = fp.tellp();
-  raw_uint32(fp, 0);
+  raw_uint32(storage, 0);
 
   long data_pos = fp.tellp();
-  msgpack_obj_header(fp, 1); // table name
-  msgpack_str(fp, PARAM_TABLE_NAME);
+  msgpack_obj_header(storage, 1); // table name
+  msgpack_str(storage, PARAM_TABLE_NAME);
 
-  msgpack_array_header(fp, 1+modelData->nParametersReal+modelData->nParametersInteger+
+  msgpack_array_header(storage, 1+modelData->nParametersReal+modelData->nParametersInteger+
     modelData->nParametersBoolean+modelData->nParametersString);
 
-  msgpack_double(fp, t);
-  for(i=0;i<modelData->nParametersReal;i++) msgpack_double(fp, sInfo->realParameter[i]);
-  for(i=0;i<modelData->nParametersInteger;i++) msgpack_int32(fp, sInfo->integerParameter[i]);
-  for(i=0;i<modelData->nParametersBoolean;i++) msgpack_boolean(fp, sInfo->booleanParameter[i]);
-  for(i=0;i<modelData->nParametersString;i++) msgpack_str(fp, MMC_STRINGDATA(sInfo->stringParameter[i]));
+  msgpack_double(storage, t);
+  for(i=0;i<modelData->nParametersReal;i++) msgpack_double(storage, sInfo->realParameter[i]);
+  for(i=0;i<modelData->nParametersInteger;i++) msgpack_int32(storage, sInfo->integerParameter[i]);
+  for(i=0;i<modelData->nParametersBoolean;i++) msgpack_boolean(storage, sInfo->booleanParameter[i]);
+  for(i=0;i<modelData->nParametersString;i++) msgpack_str(storage, MMC_STRINGDATA(sInfo->stringParameter[i]));
 
   long end_pos = fp.tellp();
   fp.seekp(length_pos);
-  raw_uint32(fp, end_pos-data_pos);
+  raw_uint32(storage, end_pos-data_pos);
   fp.seekp(end_pos);
 }
 
 void recon_wall_writeParameterData(simulation_result *self,DATA *data, threadData_t *threadData)
 {
   wall_storage *storage = (wall_storage *)self->storage;
-  std::ofstream &fp = storage->fp;
   MODEL_DATA *modelData = data->modelData;
   const SIMULATION_INFO *sInfo = data->simulationInfo;
-  write_parameter_data(fp, sInfo->startTime, modelData, sInfo);
-  write_parameter_data(fp, sInfo->stopTime, modelData, sInfo);
+  write_parameter_data(storage, sInfo->startTime, modelData, sInfo);
+  write_parameter_data(storage, sInfo->stopTime, modelData, sInfo);
 }
 
 void recon_wall_emit(simulation_result *self,DATA *data, threadData_t *threadData)
@@ -376,32 +363,32 @@ void recon_wall_emit(simulation_result *self,DATA *data, threadData_t *threadDat
 
   long i;
   long length_pos = fp.tellp();
-  raw_uint32(fp, 0);
+  raw_uint32(storage, 0);
 
   long data_pos = fp.tellp();
-  msgpack_obj_header(fp, 1); // table name
-  msgpack_str(fp, CONT_TABLE_NAME);
+  msgpack_obj_header(storage, 1); // table name
+  msgpack_str(storage, CONT_TABLE_NAME);
 
-  msgpack_array_header(fp, 1+modelData->nVariablesReal+modelData->nVariablesInteger+
+  msgpack_array_header(storage, 1+modelData->nVariablesReal+modelData->nVariablesInteger+
     modelData->nVariablesBoolean+modelData->nVariablesString);
 
-  msgpack_double(fp, data->localData[0]->timeValue);
+  msgpack_double(storage, data->localData[0]->timeValue);
   for(i=0;i<modelData->nVariablesReal;i++) {
-    msgpack_double(fp, data->localData[0]->realVars[i]);
+    msgpack_double(storage, data->localData[0]->realVars[i]);
   }
   for(i=0;i<modelData->nVariablesInteger;i++) {
-    msgpack_int32(fp, data->localData[0]->integerVars[i]);
+    msgpack_int32(storage, data->localData[0]->integerVars[i]);
   }
   for(i=0;i<modelData->nVariablesBoolean;i++) {
-    msgpack_boolean(fp, data->localData[0]->booleanVars[i]);
+    msgpack_boolean(storage, data->localData[0]->booleanVars[i]);
   }
   for(i=0;i<modelData->nVariablesString;i++) {
-    msgpack_str(fp, MMC_STRINGDATA(data->localData[0]->stringVars[i]));
+    msgpack_str(storage, MMC_STRINGDATA(data->localData[0]->stringVars[i]));
   }
 
   long end_pos = fp.tellp();
   fp.seekp(length_pos);
-  raw_uint32(fp, end_pos-data_pos);
+  raw_uint32(storage, end_pos-data_pos);
   fp.seekp(end_pos);
 }
 
@@ -0,0 +1,546 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * file simulation_batch.cpp
+ * simulates the loaded model once per run of a parameter matrix. The model is
+ * read and initialized once by initRuntimeAndSimulation; every run gets an
+ * instance with its own SIMULATION_INFO and variable data that shares the
+ * names and the init image with the loaded model. A pool of threads
+ * simulates the runs, each thread with its own instance and threadData.
+ */
+
+#include "simulation_batch.h"
+#include "options.h"
+#include "util/omc_error.h"
+#include "util/read_csv.h"
+#include "util/cJSON.h"
+#include "util/modelica_string.h"
+#include "util/memory_pool.h"
+#include "util/rtclock.h"
+#include "util/OldModelicaTables.h"
+#include "meta/meta_modelica.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#if defined(__MINGW32__) || defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/* what the values of a column of the matrix override */
+enum BATCH_TARGET
+{
+  BATCH_START_TIME = 0,
+  BATCH_STOP_TIME,
+  BATCH_STEP_SIZE,
+  BATCH_TOLERANCE,
+  BATCH_REAL_VAR,
+  BATCH_INTEGER_VAR,
+  BATCH_BOOLEAN_VAR,
+  BATCH_STRING_VAR,
+  BATCH_REAL_PARAMETER,
+  BATCH_INTEGER_PARAMETER,
+  BATCH_BOOLEAN_PARAMETER,
+  BATCH_STRING_PARAMETER
+};
+
+typedef struct BATCH_COLUMN
+{
+  enum BATCH_TARGET target;
+  long index;                          /* index into the variable data of the target */
+} BATCH_COLUMN;
+
+typedef struct BATCH_VALUE
+{
+  int isSet;                           /* 0 if the run keeps the start value of the model */
+  double real;
+  modelica_string string;              /* NULL unless the value is a string */
+} BATCH_VALUE;
+
+typedef struct BATCH_INSTANCE
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+} BATCH_INSTANCE;
+
+struct BatchMatrix
+{
+  vector<string> names;
+  vector<BATCH_COLUMN> columns;
+  vector<vector<BATCH_VALUE> > runs;   /* runs[run][column] */
+};
+
+struct BatchState
+{
+  DATA *model;                         /* the model loaded by initRuntimeAndSimulation */
+  const BatchMatrix *matrix;
+  vector<string> resultFiles;
+  vector<int> status;                  /* return value of each run */
+  const char *argv_0;
+  pthread_mutex_t mutex;
+  size_t next;                         /* next run to simulate */
+};
+
+static int numProcessors()
+{
+#if defined(__MINGW32__) || defined(_MSC_VER)
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  return sysinfo.dwNumberOfProcessors > 0 ? sysinfo.dwNumberOfProcessors : 1;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int) n : 1;
+#endif
+}
+
+static void readMatrixCSV(BatchMatrix &matrix, const char *fileName, threadData_t *threadData)
+{
+  struct csv_data *csv = read_csv(fileName);
+  int i, j;
+
+  if (!csv) {
+    throwStreamPrint(threadData, "batch: could not read the parameter matrix %s", fileName);
+  }
+  for (i=0; i<csv->numvars; i++) {
+    matrix.names.push_back(csv->variables[i]);
+  }
+  matrix.runs.resize(csv->numsteps);
+  for (j=0; j<csv->numsteps; j++) {
+    matrix.runs[j].resize(csv->numvars);
+    for (i=0; i<csv->numvars; i++) {
+      BATCH_VALUE &value = matrix.runs[j][i];
+      value.isSet = 1;
+      value.real = csv->data[i*csv->numsteps + j];
+      value.string = NULL;
+    }
+  }
+  omc_free_csv_reader(csv);
+}
+
+static void readMatrixJSON(BatchMatrix &matrix, const char *fileName, threadData_t *threadData)
+{
+  ifstream in(fileName);
+  stringstream content;
+  cJSON *root, *run, *item;
+  size_t i, j;
+
+  if (!in) {
+    throwStreamPrint(threadData, "batch: could not read the parameter matrix %s", fileName);
+  }
+  content << in.rdbuf();
+  root = cJSON_Parse(content.str().c_str());
+  if (!root || root->type != cJSON_Array) {
+    if (root) {
+      cJSON_Delete(root);
+    }
+    throwStreamPrint(threadData, "batch: %s does not contain a JSON array of runs", fileName);
+  }
+
+  /* the columns are all names used by any run */
+  for (run=root->child; run; run=run->next) {
+    if (run->type != cJSON_Object) {
+      cJSON_Delete(root);
+      throwStreamPrint(threadData, "batch: every run in %s has to be a JSON object", fileName);
+    }
+    for (item=run->child; item; item=item->next) {
+      for (i=0; i<matrix.names.size() && matrix.names[i] != item->string; i++);
+      if (i == matrix.names.size()) {
+        matrix.names.push_back(item->string);
+      }
+    }
+  }
+
+  for (run=root->child, j=0; run; run=run->next, j++) {
+    BATCH_VALUE unset = {0, 0.0, NULL};
+    matrix.runs.push_back(vector<BATCH_VALUE>(matrix.names.size(), unset));
+    for (item=run->child; item; item=item->next) {
+      for (i=0; matrix.names[i] != item->string; i++);
+      BATCH_VALUE &value = matrix.runs[j][i];
+      value.isSet = 1;
+      switch (item->type) {
+      case cJSON_Number: value.real = item->valuedouble; break;
+      case cJSON_True:   value.real = 1.0; break;
+      case cJSON_False:  value.real = 0.0; break;
+      case cJSON_String: value.string = (modelica_string) mmc_mk_scon_persist(item->valuestring); break;
+      default:
+        cJSON_Delete(root);
+        throwStreamPrint(threadData, "batch: the value of %s in run %ld is neither a number, a boolean nor a string", matrix.names[i].c_str(), (long) j+1);
+      }
+    }
+  }
+  cJSON_Delete(root);
+}
+
+/* maps the names of the matrix to the variables and parameters of the model */
+static void resolveColumns(BatchMatrix &matrix, const MODEL_DATA *modelData, threadData_t *threadData)
+{
+  size_t i, j;
+  long k;
+
+  for (i=0; i<matrix.names.size(); i++) {
+    const char *name = matrix.names[i].c_str();
+    BATCH_COLUMN column = {BATCH_START_TIME, -1};
+
+    if (0 == strcmp(name, "startTime")) {
+      column.target = BATCH_START_TIME;
+    } else if (0 == strcmp(name, "stopTime")) {
+      column.target = BATCH_STOP_TIME;
+    } else if (0 == strcmp(name, "stepSize")) {
+      column.target = BATCH_STEP_SIZE;
+    } else if (0 == strcmp(name, "tolerance")) {
+      column.target = BATCH_TOLERANCE;
+    } else {
+      #define FIND_BATCH_TARGET(vars, n, t) \
+        for (k=0; column.index < 0 && k<modelData->n; k++) { \
+          if (0 == strcmp(name, modelData->vars[k].info.name)) { \
+            column.target = t; \
+            column.index = k; \
+          } \
+        }
+      FIND_BATCH_TARGET(realParameterData, nParametersReal, BATCH_REAL_PARAMETER)
+      FIND_BATCH_TARGET(integerParameterData, nParametersInteger, BATCH_INTEGER_PARAMETER)
+      FIND_BATCH_TARGET(booleanParameterData, nParametersBoolean, BATCH_BOOLEAN_PARAMETER)
+      FIND_BATCH_TARGET(stringParameterData, nParametersString, BATCH_STRING_PARAMETER)
+      FIND_BATCH_TARGET(realVarsData, nVariablesReal, BATCH_REAL_VAR)
+      FIND_BATCH_TARGET(integerVarsData, nVariablesInteger, BATCH_INTEGER_VAR)
+      FIND_BATCH_TARGET(booleanVarsData, nVariablesBoolean, BATCH_BOOLEAN_VAR)
+      FIND_BATCH_TARGET(stringVarsData, nVariablesString, BATCH_STRING_VAR)
+      #undef FIND_BATCH_TARGET
+      if (column.index < 0) {
+        throwStreamPrint(threadData, "batch: %s is neither a variable nor a parameter of the model (nor startTime, stopTime, stepSize or tolerance)", name);
+      }
+    }
+
+    /* strings only go into string variables and the other way around */
+    for (j=0; j<matrix.runs.size(); j++) {
+      const BATCH_VALUE &value = matrix.runs[j][i];
+      int isString = (column.target == BATCH_STRING_VAR || column.target == BATCH_STRING_PARAMETER);
+      if (value.isSet && isString != (value.string != NULL)) {
+        throwStreamPrint(threadData, "batch: the value of %s in run %ld has the wrong type", name, (long) j+1);
+      }
+    }
+    matrix.columns.push_back(column);
+  }
+}
+
+/* overrides the start values of the instance with the values of the run */
+static void applyRun(DATA *data, const BatchMatrix &matrix, size_t run)
+{
+  MODEL_DATA *modelData = data->modelData;
+  SIMULATION_INFO *simulationInfo = data->simulationInfo;
+  size_t i;
+
+  for (i=0; i<matrix.columns.size(); i++) {
+    const BATCH_VALUE &value = matrix.runs[run][i];
+    const long k = matrix.columns[i].index;
+    if (!value.isSet) {
+      continue;
+    }
+    switch (matrix.columns[i].target) {
+    case BATCH_START_TIME:        simulationInfo->startTime = value.real; break;
+    case BATCH_STOP_TIME:         simulationInfo->stopTime = value.real; break;
+    case BATCH_STEP_SIZE:         simulationInfo->stepSize = value.real; break;
+    case BATCH_TOLERANCE:         simulationInfo->tolerance = value.real; break;
+    case BATCH_REAL_VAR:          modelData->realVarsData[k].attribute.start = value.real; break;
+    case BATCH_INTEGER_VAR:       modelData->integerVarsData[k].attribute.start = (modelica_integer) value.real; break;
+    case BATCH_BOOLEAN_VAR:       modelData->booleanVarsData[k].attribute.start = value.real != 0.0; break;
+    case BATCH_STRING_VAR:        modelData->stringVarsData[k].attribute.start = value.string; break;
+    case BATCH_REAL_PARAMETER:    modelData->realParameterData[k].attribute.start = value.real; break;
+    case BATCH_INTEGER_PARAMETER: modelData->integerParameterData[k].attribute.start = (modelica_integer) value.real; break;
+    case BATCH_BOOLEAN_PARAMETER: modelData->booleanParameterData[k].attribute.start = value.real != 0.0; break;
+    case BATCH_STRING_PARAMETER:  modelData->stringParameterData[k].attribute.start = value.string; break;
+    }
+  }
+}
+
+/* Sets up the instance for one run: fresh dynamic data, a copy of the
+ * variable data of the loaded model and the start values of the run. */
+static void setupInstance(BATCH_INSTANCE *inst, const BatchState *state, size_t run, threadData_t *threadData)
+{
+  const MODEL_DATA *modelData = state->model->modelData;
+  const SIMULATION_INFO *simulationInfo = state->model->simulationInfo;
+
+  memset(inst, 0, sizeof(BATCH_INSTANCE));
+  inst->modelData = *modelData;
+  inst->modelData.sharesStaticData = 1;
+  inst->modelData.resultFileName = GC_strdup(state->resultFiles[run].c_str());
+  inst->simulationInfo.startTime = simulationInfo->startTime;
+  inst->simulationInfo.stopTime = simulationInfo->stopTime;
+  inst->simulationInfo.stepSize = simulationInfo->stepSize;
+  inst->simulationInfo.tolerance = simulationInfo->tolerance;
+  inst->simulationInfo.solverMethod = simulationInfo->solverMethod;
+  inst->simulationInfo.outputFormat = simulationInfo->outputFormat;
+  inst->simulationInfo.variableFilter = simulationInfo->variableFilter;
+  inst->simulationInfo.OPENMODELICAHOME = simulationInfo->OPENMODELICAHOME;
+  inst->data.modelData = &inst->modelData;
+  inst->data.simulationInfo = &inst->simulationInfo;
+  inst->data.callback = state->model->callback;
+
+  initializeDataStruc(&inst->data, threadData);
+
+  #define COPY_VAR_DATA(vars, n) if (modelData->n > 0) { \
+    memcpy(inst->modelData.vars, modelData->vars, modelData->n * sizeof(*modelData->vars)); \
+  }
+  COPY_VAR_DATA(realVarsData, nVariablesReal)
+  COPY_VAR_DATA(integerVarsData, nVariablesInteger)
+  COPY_VAR_DATA(booleanVarsData, nVariablesBoolean)
+  COPY_VAR_DATA(stringVarsData, nVariablesString)
+  COPY_VAR_DATA(realParameterData, nParametersReal)
+  COPY_VAR_DATA(integerParameterData, nParametersInteger)
+  COPY_VAR_DATA(booleanParameterData, nParametersBoolean)
+  COPY_VAR_DATA(stringParameterData, nParametersString)
+  COPY_VAR_DATA(realAlias, nAliasReal)
+  COPY_VAR_DATA(integerAlias, nAliasInteger)
+  COPY_VAR_DATA(booleanAlias, nAliasBoolean)
+  COPY_VAR_DATA(stringAlias, nAliasString)
+  #undef COPY_VAR_DATA
+
+  inst->simulationInfo.nlsMethod = simulationInfo->nlsMethod;
+  inst->simulationInfo.lsMethod = simulationInfo->lsMethod;
+  inst->simulationInfo.lssMethod = simulationInfo->lssMethod;
+  inst->simulationInfo.mixedMethod = simulationInfo->mixedMethod;
+  inst->simulationInfo.newtonStrategy = simulationInfo->newtonStrategy;
+  inst->simulationInfo.nlsCsvInfomation = simulationInfo->nlsCsvInfomation;
+
+  applyRun(&inst->data, *state->matrix, run);
+  inst->simulationInfo.numSteps = static_cast<modelica_integer>(round((inst->simulationInfo.stopTime - inst->simulationInfo.startTime)/inst->simulationInfo.stepSize));
+
+  initializeMixedSystems(&inst->data, threadData);
+  initializeLinearSystems(&inst->data, threadData);
+  initializeNonlinearSystems(&inst->data, threadData);
+}
+
+static void freeInstance(BATCH_INSTANCE *inst, threadData_t *threadData)
+{
+  freeMixedSystems(&inst->data, threadData);
+  freeLinearSystems(&inst->data, threadData);
+  freeNonlinearSystems(&inst->data, threadData);
+  inst->data.callback->callExternalObjectDestructors(&inst->data, threadData);
+  deInitializeDataStruc(&inst->data);
+}
+
+static int simulateRun(BatchState *state, BATCH_INSTANCE *inst, size_t run, threadData_t *threadData)
+{
+  volatile int retVal = 1;
+  volatile int isSetUp = 0;
+  /* the timers, pools and tables of the OpenMP workers of this run count for it */
+  rt_clock_group *timers = rt_group_new();
+  pool_group *pools = pool_group_new();
+  table_group *tables = table_group_new();
+  rt_group_join(timers);
+  pool_group_join(pools);
+  table_group_join(tables);
+  MMC_TRY_INTERNAL(globalJumpBuffer)
+    setupInstance(inst, state, run, threadData);
+    isSetUp = 1;
+    retVal = runSimulation(&inst->data, threadData, state->argv_0);
+  MMC_CATCH_INTERNAL(globalJumpBuffer)
+  /* also a run that failed with an error gives its instance back */
+  if (isSetUp) {
+    freeInstance(inst, threadData);
+  }
+  rt_group_join(NULL);
+  pool_group_join(NULL);
+  table_group_join(NULL);
+  rt_group_free(timers);
+  pool_group_free(pools);
+  table_group_free(tables);
+  return retVal;
+}
+
+static void* batchWorker(void *arg)
+{
+  BatchState *state = (BatchState*) arg;
+  BATCH_INSTANCE inst;
+  size_t run;
+
+  while (1) {
+    pthread_mutex_lock(&state->mutex);
+    run = state->next++;
+    pthread_mutex_unlock(&state->mutex);
+    if (run >= state->matrix->runs.size()) {
+      break;
+    }
+    MMC_TRY_TOP()
+    state->status[run] = simulateRun(state, &inst, run, threadData);
+    MMC_CATCH_TOP()
+    infoStreamPrint(LOG_STDOUT, 0, "batch run %ld of %ld %s: %s", (long) run+1, (long) state->matrix->runs.size(),
+                    state->status[run] ? "failed" : "finished", state->resultFiles[run].c_str());
+  }
+  return NULL;
+}
+
+/* Writes the CSV results of all runs to one file, with the run in the first
+ * column, and removes the result files of the runs. */
+static int stackResults(const BatchState &state, const string &resultFile)
+{
+  ofstream out(resultFile.c_str());
+  string header, line;
+  size_t run;
+
+  if (!out) {
+    warningStreamPrint(LOG_STDOUT, 0, "batch: could not create the result file %s", resultFile.c_str());
+    return 1;
+  }
+  for (run=0; run<state.resultFiles.size(); run++) {
+    ifstream in(state.resultFiles[run].c_str());
+    if (!in || !getline(in, line)) {
+      continue;
+    }
+    if (header.empty()) {
+      header = line;
+      out << "\"run\"," << header << "\n";
+    } else if (line != header) {
+      warningStreamPrint(LOG_STDOUT, 0, "batch: the result of run %ld has different columns; it is kept in %s", (long) run+1, state.resultFiles[run].c_str());
+      continue;
+    }
+    while (getline(in, line)) {
+      out << run+1 << "," << line << "\n";
+    }
+    in.close();
+    remove(state.resultFiles[run].c_str());
+  }
+  out.close();
+  infoStreamPrint(LOG_STDOUT, 0, "batch: stacked the results of %ld runs in %s", (long) state.resultFiles.size(), resultFile.c_str());
+  return out.fail() ? 1 : 0;
+}
+
+int runBatch(int argc, char **argv, DATA *data, threadData_t *threadData)
+{
+  const char *matrixFile = omc_flagValue[FLAG_BATCH];
+  const char *resultMode = omc_flagValue[FLAG_BATCH_RESULT];
+  const char *result_file = omc_flagValue[FLAG_R];
+  int stacked = 0, numThreads, i, retVal = 0;
+  size_t len = strlen(matrixFile), run;
+  string base, ext;
+  BatchMatrix matrix;
+  BatchState state;
+  vector<pthread_t> threads;
+
+  if (resultMode && 0 == strcmp(resultMode, "stacked")) {
+    stacked = 1;
+  } else if (resultMode && 0 != strcmp(resultMode, "files")) {
+    throwStreamPrint(threadData, "-batchResult expects files or stacked (got '%s')", resultMode);
+  }
+
+  if (len > 5 && 0 == strcmp(matrixFile + len - 5, ".json")) {
+    readMatrixJSON(matrix, matrixFile, threadData);
+  } else {
+    readMatrixCSV(matrix, matrixFile, threadData);
+  }
+  resolveColumns(matrix, data->modelData, threadData);
+  if (matrix.runs.empty()) {
+    warningStreamPrint(LOG_STDOUT, 0, "batch: %s does not contain any run", matrixFile);
+    return 0;
+  }
+
+  if (stacked && 0 != strcmp("csv", data->simulationInfo->outputFormat)) {
+    infoStreamPrint(LOG_STDOUT, 0, "batch: stacked results are written as csv instead of %s", data->simulationInfo->outputFormat);
+    data->simulationInfo->outputFormat = "csv";
+  }
+  if (measure_time_flag) {
+    warningStreamPrint(LOG_STDOUT, 0, "batch: the runs are not profiled");
+    measure_time_flag = 0;
+  }
+  if (omc_flag[FLAG_CHECKPOINT] || omc_flag[FLAG_CHECKPOINT_TIME] || omc_flag[FLAG_CHECKPOINT_INTERVAL]) {
+    warningStreamPrint(LOG_STDOUT, 0, "batch: no checkpoints are written, the runs would overwrite each other's file");
+    omc_flag[FLAG_CHECKPOINT] = omc_flag[FLAG_CHECKPOINT_TIME] = omc_flag[FLAG_CHECKPOINT_INTERVAL] = 0;
+  }
+
+  /* <base>_<run>.<ext> from -r=<base>.<ext> or <model>_res.<format> */
+  base = result_file ? result_file : string(data->modelData->modelFilePrefix) + "_res";
+  ext = data->simulationInfo->outputFormat;
+  if (result_file) {
+    size_t dot = base.rfind('.'), sep = base.find_last_of("/\\");
+    if (dot != string::npos && (sep == string::npos || dot > sep)) {
+      ext = base.substr(dot + 1);
+      base = base.substr(0, dot);
+    }
+  }
+  for (run=0; run<matrix.runs.size(); run++) {
+    stringstream name;
+    name << base << "_" << run+1 << "." << (stacked ? "csv" : ext);
+    state.resultFiles.push_back(name.str());
+  }
+
+  numThreads = omc_flag[FLAG_BATCH_THREADS] ? atoi(omc_flagValue[FLAG_BATCH_THREADS]) : numProcessors();
+  if (numThreads < 1) {
+    numThreads = 1;
+  }
+  if ((size_t) numThreads > matrix.runs.size()) {
+    numThreads = (int) matrix.runs.size();
+  }
+  infoStreamPrint(LOG_STDOUT, 0, "batch: simulating %ld runs of %s with %d model instances", (long) matrix.runs.size(), matrixFile, numThreads);
+
+  state.model = data;
+  state.matrix = &matrix;
+  state.status.assign(matrix.runs.size(), 1);
+  state.argv_0 = argv[0];
+  state.next = 0;
+  pthread_mutex_init(&state.mutex, NULL);
+
+  if (numThreads == 1) {
+    batchWorker(&state);
+  } else {
+    threads.resize(numThreads);
+    for (i=0; i<numThreads; i++) {
+      GC_pthread_create(&threads[i], NULL, batchWorker, &state);
+    }
+    for (i=0; i<numThreads; i++) {
+      GC_pthread_join(threads[i], NULL);
+    }
+  }
+  pthread_mutex_destroy(&state.mutex);
+
+  for (run=0; run<matrix.runs.size(); run++) {
+    if (state.status[run]) {
+      retVal = 1;
+    }
+  }
+  if (stacked) {
+    retVal = stackResults(state, base + ".csv") || retVal;
+  }
+  return retVal;
+}
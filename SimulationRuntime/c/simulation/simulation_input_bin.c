@@ -0,0 +1,648 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * file simulation_input_bin.c
+ * stores the data read from Model_init.xml in a binary image and maps it
+ * again on later runs (see -initCache). The image consists of a header, one
+ * section of fixed size records per kind of variable and a string table.
+ * The records reference the strings by offset, so the names used in
+ * MODEL_DATA point directly into the mapped file.
+ */
+
+#include "simulation_input_bin.h"
+#include "options.h"
+#include "util/omc_error.h"
+#include "util/omc_mmap.h"
+#include "util/uthash.h"
+#include "meta/meta_modelica.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#if defined(_MSC_VER)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define INIT_BIN_MAGIC "OMCINIT"
+#define INIT_BIN_VERSION 1
+#define INIT_BIN_BYTE_ORDER 0x01020304
+
+enum INIT_BIN_SECTION
+{
+  INIT_BIN_REAL_VARS = 0,
+  INIT_BIN_INTEGER_VARS,
+  INIT_BIN_BOOLEAN_VARS,
+  INIT_BIN_STRING_VARS,
+  INIT_BIN_REAL_PARAMETERS,
+  INIT_BIN_INTEGER_PARAMETERS,
+  INIT_BIN_BOOLEAN_PARAMETERS,
+  INIT_BIN_STRING_PARAMETERS,
+  INIT_BIN_REAL_ALIAS,
+  INIT_BIN_INTEGER_ALIAS,
+  INIT_BIN_BOOLEAN_ALIAS,
+  INIT_BIN_STRING_ALIAS,
+  INIT_BIN_NUM_SECTIONS
+};
+
+typedef struct INIT_BIN_HEADER
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t recordSize[INIT_BIN_NUM_SECTIONS];
+  uint32_t emitProtected;      /* the flags filterOutput depends on */
+  uint32_t ignoreHideResult;
+  int64_t xmlSize;             /* the _init.xml file the image was created from */
+  int64_t xmlMTime;
+  int64_t nStates;
+  int64_t count[INIT_BIN_NUM_SECTIONS];
+  uint64_t offset[INIT_BIN_NUM_SECTIONS];
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+  double startTime;
+  double stopTime;
+  double stepSize;
+  double tolerance;
+  uint32_t guid;               /* offsets into the string table */
+  uint32_t solverMethod;
+  uint32_t outputFormat;
+  uint32_t variableFilter;
+  uint32_t OPENMODELICAHOME;
+  uint32_t reserved;
+} INIT_BIN_HEADER;
+
+typedef struct INIT_BIN_VAR_INFO
+{
+  uint32_t name;
+  uint32_t comment;
+  uint32_t filename;
+  int32_t id;
+  int32_t inputIndex;
+  int32_t lineStart;
+  int32_t colStart;
+  int32_t lineEnd;
+  int32_t colEnd;
+  int32_t readonly;
+} INIT_BIN_VAR_INFO;
+
+typedef struct INIT_BIN_REAL
+{
+  INIT_BIN_VAR_INFO info;
+  double start;
+  double nominal;
+  double min;
+  double max;
+  uint8_t useStart;
+  uint8_t fixed;
+  uint8_t useNominal;
+  uint8_t filterOutput;
+  uint8_t pad[4];
+} INIT_BIN_REAL;
+
+typedef struct INIT_BIN_INTEGER
+{
+  INIT_BIN_VAR_INFO info;
+  int64_t start;
+  int64_t min;
+  int64_t max;
+  uint8_t useStart;
+  uint8_t fixed;
+  uint8_t filterOutput;
+  uint8_t pad[5];
+} INIT_BIN_INTEGER;
+
+typedef struct INIT_BIN_BOOLEAN
+{
+  INIT_BIN_VAR_INFO info;
+  uint8_t useStart;
+  uint8_t fixed;
+  uint8_t start;
+  uint8_t filterOutput;
+  uint8_t pad[4];
+} INIT_BIN_BOOLEAN;
+
+typedef struct INIT_BIN_STRING
+{
+  INIT_BIN_VAR_INFO info;
+  uint32_t start;
+  uint8_t useStart;
+  uint8_t filterOutput;
+  uint8_t pad[2];
+} INIT_BIN_STRING;
+
+typedef struct INIT_BIN_ALIAS
+{
+  INIT_BIN_VAR_INFO info;
+  int32_t nameID;
+  uint8_t negate;
+  uint8_t aliasType;
+  uint8_t filterOutput;
+  uint8_t pad;
+} INIT_BIN_ALIAS;
+
+static const uint32_t recordSizes[INIT_BIN_NUM_SECTIONS] = {
+  sizeof(INIT_BIN_REAL), sizeof(INIT_BIN_INTEGER), sizeof(INIT_BIN_BOOLEAN), sizeof(INIT_BIN_STRING),
+  sizeof(INIT_BIN_REAL), sizeof(INIT_BIN_INTEGER), sizeof(INIT_BIN_BOOLEAN), sizeof(INIT_BIN_STRING),
+  sizeof(INIT_BIN_ALIAS), sizeof(INIT_BIN_ALIAS), sizeof(INIT_BIN_ALIAS), sizeof(INIT_BIN_ALIAS)
+};
+
+static void modelCounts(MODEL_DATA *modelData, int64_t *count)
+{
+  count[INIT_BIN_REAL_VARS] = modelData->nVariablesReal;
+  count[INIT_BIN_INTEGER_VARS] = modelData->nVariablesInteger;
+  count[INIT_BIN_BOOLEAN_VARS] = modelData->nVariablesBoolean;
+  count[INIT_BIN_STRING_VARS] = modelData->nVariablesString;
+  count[INIT_BIN_REAL_PARAMETERS] = modelData->nParametersReal;
+  count[INIT_BIN_INTEGER_PARAMETERS] = modelData->nParametersInteger;
+  count[INIT_BIN_BOOLEAN_PARAMETERS] = modelData->nParametersBoolean;
+  count[INIT_BIN_STRING_PARAMETERS] = modelData->nParametersString;
+  count[INIT_BIN_REAL_ALIAS] = modelData->nAliasReal;
+  count[INIT_BIN_INTEGER_ALIAS] = modelData->nAliasInteger;
+  count[INIT_BIN_BOOLEAN_ALIAS] = modelData->nAliasBoolean;
+  count[INIT_BIN_STRING_ALIAS] = modelData->nAliasString;
+}
+
+static int statFile(const char *filename, int64_t *size, int64_t *mtime)
+{
+  struct stat s;
+  if (0 != stat(filename, &s)) {
+    return 0;
+  }
+  *size = (int64_t) s.st_size;
+  *mtime = (int64_t) s.st_mtime;
+  return 1;
+}
+
+char* input_bin_filename(const char *xmlFilename)
+{
+  size_t len = strlen(xmlFilename);
+  char *res = (char*) malloc(len + 5);
+  strcpy(res, xmlFilename);
+  if (len > 4 && 0 == strcmp(res + len - 4, ".xml")) {
+    len -= 4;
+  }
+  strcpy(res + len, ".bin");
+  return res;
+}
+
+/* ------------------------------------------------------------------------ */
+/* reading */
+
+typedef struct INIT_BIN_IMAGE
+{
+  omc_mmap_read map;
+  const char *strings;
+  uint64_t stringsSize;
+  int valid;
+} INIT_BIN_IMAGE;
+
+static inline const char* binString(INIT_BIN_IMAGE *image, uint32_t offset)
+{
+  if (offset >= image->stringsSize) {
+    image->valid = 0;
+    return "";
+  }
+  return image->strings + offset;
+}
+
+static inline void readVarInfo(INIT_BIN_IMAGE *image, const INIT_BIN_VAR_INFO *in, VAR_INFO *info)
+{
+  info->id = in->id;
+  info->inputIndex = in->inputIndex;
+  info->name = binString(image, in->name);
+  info->comment = binString(image, in->comment);
+  info->info.filename = binString(image, in->filename);
+  info->info.lineStart = in->lineStart;
+  info->info.colStart = in->colStart;
+  info->info.lineEnd = in->lineEnd;
+  info->info.colEnd = in->colEnd;
+  info->info.readonly = in->readonly;
+}
+
+static void readReal(INIT_BIN_IMAGE *image, const INIT_BIN_REAL *in, STATIC_REAL_DATA *out, int64_t n)
+{
+  int64_t i;
+  for (i = 0; i < n; i++) {
+    readVarInfo(image, &in[i].info, &out[i].info);
+    out[i].attribute.unit = NULL;
+    out[i].attribute.displayUnit = NULL;
+    out[i].attribute.useStart = in[i].useStart;
+    out[i].attribute.start = in[i].start;
+    out[i].attribute.fixed = in[i].fixed;
+    out[i].attribute.useNominal = in[i].useNominal;
+    out[i].attribute.nominal = in[i].nominal;
+    out[i].attribute.min = in[i].min;
+    out[i].attribute.max = in[i].max;
+    out[i].filterOutput = in[i].filterOutput;
+  }
+}
+
+static void readInteger(INIT_BIN_IMAGE *image, const INIT_BIN_INTEGER *in, STATIC_INTEGER_DATA *out, int64_t n)
+{
+  int64_t i;
+  for (i = 0; i < n; i++) {
+    readVarInfo(image, &in[i].info, &out[i].info);
+    out[i].attribute.useStart = in[i].useStart;
+    out[i].attribute.start = (modelica_integer) in[i].start;
+    out[i].attribute.fixed = in[i].fixed;
+    out[i].attribute.min = (modelica_integer) in[i].min;
+    out[i].attribute.max = (modelica_integer) in[i].max;
+    out[i].filterOutput = in[i].filterOutput;
+  }
+}
+
+static void readBoolean(INIT_BIN_IMAGE *image, const INIT_BIN_BOOLEAN *in, STATIC_BOOLEAN_DATA *out, int64_t n)
+{
+  int64_t i;
+  for (i = 0; i < n; i++) {
+    readVarInfo(image, &in[i].info, &out[i].info);
+    out[i].attribute.useStart = in[i].useStart;
+    out[i].attribute.start = in[i].start;
+    out[i].attribute.fixed = in[i].fixed;
+    out[i].filterOutput = in[i].filterOutput;
+  }
+}
+
+static void readString(INIT_BIN_IMAGE *image, const INIT_BIN_STRING *in, STATIC_STRING_DATA *out, int64_t n)
+{
+  int64_t i;
+  for (i = 0; i < n; i++) {
+    readVarInfo(image, &in[i].info, &out[i].info);
+    out[i].attribute.useStart = in[i].useStart;
+    out[i].attribute.start = mmc_mk_scon_persist(binString(image, in[i].start));
+    out[i].filterOutput = in[i].filterOutput;
+  }
+}
+
+static void readAlias(INIT_BIN_IMAGE *image, const INIT_BIN_ALIAS *in, DATA_ALIAS *out, int64_t n)
+{
+  int64_t i;
+  for (i = 0; i < n; i++) {
+    readVarInfo(image, &in[i].info, &out[i].info);
+    out[i].negate = in[i].negate;
+    out[i].nameID = in[i].nameID;
+    out[i].aliasType = (char) in[i].aliasType;
+    out[i].filterOutput = in[i].filterOutput;
+  }
+}
+
+int read_input_bin(MODEL_DATA* modelData, SIMULATION_INFO* simulationInfo, const char *binFilename, const char *xmlFilename)
+{
+  INIT_BIN_IMAGE image = {0};
+  const INIT_BIN_HEADER *header;
+  int64_t count[INIT_BIN_NUM_SECTIONS], xmlSize, xmlMTime;
+  int64_t binSize, binMTime;
+  const char *reason = NULL;
+  int i;
+
+  if (!statFile(binFilename, &binSize, &binMTime) || binSize < (int64_t) sizeof(INIT_BIN_HEADER)) {
+    infoStreamPrint(LOG_SIMULATION, 0, "no init image %s found, reading %s", binFilename, xmlFilename);
+    return 0;
+  }
+  if (!statFile(xmlFilename, &xmlSize, &xmlMTime)) {
+    return 0;
+  }
+
+  image.map = omc_mmap_open_read(binFilename);
+  header = (const INIT_BIN_HEADER*) image.map.data;
+  modelCounts(modelData, count);
+
+  if (image.map.size < sizeof(INIT_BIN_HEADER) || memcmp(header->magic, INIT_BIN_MAGIC, sizeof(INIT_BIN_MAGIC))) {
+    reason = "not an init image";
+  } else if (header->version != INIT_BIN_VERSION || header->byteOrder != INIT_BIN_BYTE_ORDER || memcmp(header->recordSize, recordSizes, sizeof(recordSizes))) {
+    reason = "created by a different runtime version";
+  } else if (header->xmlSize != xmlSize || header->xmlMTime != xmlMTime) {
+    reason = "the XML file has changed";
+  } else if (header->emitProtected != (uint32_t) omc_flag[FLAG_EMIT_PROTECTED] || header->ignoreHideResult != (uint32_t) omc_flag[FLAG_IGNORE_HIDERESULT]) {
+    reason = "the output filter flags differ";
+  } else if (header->nStates != modelData->nStates || memcmp(header->count, count, sizeof(count))) {
+    reason = "the number of variables differs";
+  } else if (header->stringsOffset > image.map.size || header->stringsSize > image.map.size - header->stringsOffset
+    || header->stringsSize == 0 || image.map.data[header->stringsOffset + header->stringsSize - 1] != '\0') {
+    reason = "the string table is corrupt";
+  } else {
+    for (i = 0; i < INIT_BIN_NUM_SECTIONS; i++) {
+      if (header->offset[i] > image.map.size || (uint64_t) count[i] * recordSizes[i] > image.map.size - header->offset[i] || header->offset[i] % 8) {
+        reason = "a section is corrupt";
+        break;
+      }
+    }
+  }
+
+  if (NULL == reason) {
+    image.strings = image.map.data + header->stringsOffset;
+    image.stringsSize = header->stringsSize;
+    image.valid = 1;
+    if (strcmp(binString(&image, header->guid), modelData->modelGUID)) {
+      reason = "the model GUID differs";
+    }
+  }
+
+  if (NULL != reason) {
+    infoStreamPrint(LOG_SIMULATION, 0, "ignoring init image %s: %s", binFilename, reason);
+    omc_mmap_close_read(image.map);
+    return 0;
+  }
+
+#define SECTION(type, s) ((const type*) (image.map.data + header->offset[s]))
+  readReal(&image, SECTION(INIT_BIN_REAL, INIT_BIN_REAL_VARS), modelData->realVarsData, count[INIT_BIN_REAL_VARS]);
+  readInteger(&image, SECTION(INIT_BIN_INTEGER, INIT_BIN_INTEGER_VARS), modelData->integerVarsData, count[INIT_BIN_INTEGER_VARS]);
+  readBoolean(&image, SECTION(INIT_BIN_BOOLEAN, INIT_BIN_BOOLEAN_VARS), modelData->booleanVarsData, count[INIT_BIN_BOOLEAN_VARS]);
+  readString(&image, SECTION(INIT_BIN_STRING, INIT_BIN_STRING_VARS), modelData->stringVarsData, count[INIT_BIN_STRING_VARS]);
+  readReal(&image, SECTION(INIT_BIN_REAL, INIT_BIN_REAL_PARAMETERS), modelData->realParameterData, count[INIT_BIN_REAL_PARAMETERS]);
+  readInteger(&image, SECTION(INIT_BIN_INTEGER, INIT_BIN_INTEGER_PARAMETERS), modelData->integerParameterData, count[INIT_BIN_INTEGER_PARAMETERS]);
+  readBoolean(&image, SECTION(INIT_BIN_BOOLEAN, INIT_BIN_BOOLEAN_PARAMETERS), modelData->booleanParameterData, count[INIT_BIN_BOOLEAN_PARAMETERS]);
+  readString(&image, SECTION(INIT_BIN_STRING, INIT_BIN_STRING_PARAMETERS), modelData->stringParameterData, count[INIT_BIN_STRING_PARAMETERS]);
+  readAlias(&image, SECTION(INIT_BIN_ALIAS, INIT_BIN_REAL_ALIAS), modelData->realAlias, count[INIT_BIN_REAL_ALIAS]);
+  readAlias(&image, SECTION(INIT_BIN_ALIAS, INIT_BIN_INTEGER_ALIAS), modelData->integerAlias, count[INIT_BIN_INTEGER_ALIAS]);
+  readAlias(&image, SECTION(INIT_BIN_ALIAS, INIT_BIN_BOOLEAN_ALIAS), modelData->booleanAlias, count[INIT_BIN_BOOLEAN_ALIAS]);
+  readAlias(&image, SECTION(INIT_BIN_ALIAS, INIT_BIN_STRING_ALIAS), modelData->stringAlias, count[INIT_BIN_STRING_ALIAS]);
+#undef SECTION
+
+  simulationInfo->startTime = header->startTime;
+  simulationInfo->stopTime = header->stopTime;
+  simulationInfo->stepSize = header->stepSize;
+  simulationInfo->tolerance = header->tolerance;
+  simulationInfo->solverMethod = strdup(binString(&image, header->solverMethod));
+  simulationInfo->outputFormat = strdup(binString(&image, header->outputFormat));
+  simulationInfo->variableFilter = strdup(binString(&image, header->variableFilter));
+  simulationInfo->OPENMODELICAHOME = strdup(binString(&image, header->OPENMODELICAHOME));
+
+  if (!image.valid) {
+    omc_mmap_close_read(image.map);
+    throwStreamPrint(NULL, "simulation_input_bin.c: Error: the init image %s is corrupt, remove it and run again", binFilename);
+  }
+
+  modelData->initImage = malloc(sizeof(omc_mmap_read));
+  *((omc_mmap_read*) modelData->initImage) = image.map;
+  infoStreamPrint(LOG_SIMULATION, 0, "read init image %s", binFilename);
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+/* writing */
+
+typedef struct hash_string_offset
+{
+  const char *id;
+  uint32_t offset;
+  UT_hash_handle hh;
+} hash_string_offset;
+
+typedef struct INIT_BIN_STRINGS
+{
+  char *data;
+  uint64_t size;
+  uint64_t capacity;
+  hash_string_offset *index;   /* file names and comments repeat a lot */
+} INIT_BIN_STRINGS;
+
+static uint32_t addString(INIT_BIN_STRINGS *strings, const char *str)
+{
+  hash_string_offset *res;
+  size_t len;
+  if (NULL == str) {
+    str = "";
+  }
+  HASH_FIND_STR(strings->index, str, res);
+  if (res) {
+    return res->offset;
+  }
+  len = strlen(str) + 1;
+  if (strings->size + len > UINT32_MAX) {
+    throwStreamPrint(NULL, "simulation_input_bin.c: Error: the string table of the init image is too large");
+  }
+  if (strings->size + len > strings->capacity) {
+    strings->capacity = 2*strings->capacity + len + 4096;
+    strings->data = (char*) realloc(strings->data, strings->capacity);
+  }
+  memcpy(strings->data + strings->size, str, len);
+  res = (hash_string_offset*) malloc(sizeof(hash_string_offset));
+  res->id = strdup(str);
+  res->offset = (uint32_t) strings->size;
+  HASH_ADD_KEYPTR(hh, strings->index, res->id, len - 1, res);
+  strings->size += len;
+  return res->offset;
+}
+
+static void freeStrings(INIT_BIN_STRINGS *strings)
+{
+  hash_string_offset *c, *tmp;
+  HASH_ITER(hh, strings->index, c, tmp) {
+    HASH_DEL(strings->index, c);
+    free((void*)c->id);
+    free(c);
+  }
+  free(strings->data);
+}
+
+static inline void writeVarInfo(INIT_BIN_STRINGS *strings, const VAR_INFO *info, INIT_BIN_VAR_INFO *out)
+{
+  out->name = addString(strings, info->name);
+  out->comment = addString(strings, info->comment);
+  out->filename = addString(strings, info->info.filename);
+  out->id = info->id;
+  out->inputIndex = info->inputIndex;
+  out->lineStart = info->info.lineStart;
+  out->colStart = info->info.colStart;
+  out->lineEnd = info->info.lineEnd;
+  out->colEnd = info->info.colEnd;
+  out->readonly = info->info.readonly;
+}
+
+/* Writes one section padded to 8 bytes and returns its offset */
+static uint64_t writeSection(FILE *file, const void *records, size_t size, uint64_t *pos)
+{
+  static const char zeros[8] = {0};
+  uint64_t offset = *pos;
+  if (size && 1 != fwrite(records, size, 1, file)) {
+    return UINT64_MAX;
+  }
+  *pos += size;
+  if (*pos % 8) {
+    fwrite(zeros, 8 - *pos % 8, 1, file);
+    *pos += 8 - *pos % 8;
+  }
+  return offset;
+}
+
+void write_input_bin(MODEL_DATA* modelData, SIMULATION_INFO* simulationInfo, const char *binFilename, const char *xmlFilename)
+{
+  INIT_BIN_HEADER header;
+  INIT_BIN_STRINGS strings = {0};
+  void *records[INIT_BIN_NUM_SECTIONS] = {0};
+  char *tmpFilename;
+  FILE *file;
+  uint64_t pos;
+  int64_t i;
+  int s, ok = 1;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INIT_BIN_MAGIC, sizeof(INIT_BIN_MAGIC));
+  header.version = INIT_BIN_VERSION;
+  header.byteOrder = INIT_BIN_BYTE_ORDER;
+  memcpy(header.recordSize, recordSizes, sizeof(recordSizes));
+  header.emitProtected = omc_flag[FLAG_EMIT_PROTECTED];
+  header.ignoreHideResult = omc_flag[FLAG_IGNORE_HIDERESULT];
+  if (!statFile(xmlFilename, &header.xmlSize, &header.xmlMTime)) {
+    return;
+  }
+  header.nStates = modelData->nStates;
+  modelCounts(modelData, header.count);
+  header.startTime = simulationInfo->startTime;
+  header.stopTime = simulationInfo->stopTime;
+  header.stepSize = simulationInfo->stepSize;
+  header.tolerance = simulationInfo->tolerance;
+  header.guid = addString(&strings, modelData->modelGUID);
+  header.solverMethod = addString(&strings, simulationInfo->solverMethod);
+  header.outputFormat = addString(&strings, simulationInfo->outputFormat);
+  header.variableFilter = addString(&strings, simulationInfo->variableFilter);
+  header.OPENMODELICAHOME = addString(&strings, simulationInfo->OPENMODELICAHOME);
+
+  for (s = 0; s < INIT_BIN_NUM_SECTIONS; s++) {
+    records[s] = calloc(header.count[s] ? header.count[s] : 1, recordSizes[s]);
+  }
+
+#define WRITE_REAL(s, vars) \
+  for (i = 0; i < header.count[s]; i++) { \
+    INIT_BIN_REAL *r = ((INIT_BIN_REAL*) records[s]) + i; \
+    writeVarInfo(&strings, &vars[i].info, &r->info); \
+    r->useStart = vars[i].attribute.useStart; \
+    r->start = vars[i].attribute.start; \
+    r->fixed = vars[i].attribute.fixed; \
+    r->useNominal = vars[i].attribute.useNominal; \
+    r->nominal = vars[i].attribute.nominal; \
+    r->min = vars[i].attribute.min; \
+    r->max = vars[i].attribute.max; \
+    r->filterOutput = vars[i].filterOutput; \
+  }
+#define WRITE_INTEGER(s, vars) \
+  for (i = 0; i < header.count[s]; i++) { \
+    INIT_BIN_INTEGER *r = ((INIT_BIN_INTEGER*) records[s]) + i; \
+    writeVarInfo(&strings, &vars[i].info, &r->info); \
+    r->useStart = vars[i].attribute.useStart; \
+    r->start = vars[i].attribute.start; \
+    r->fixed = vars[i].attribute.fixed; \
+    r->min = vars[i].attribute.min; \
+    r->max = vars[i].attribute.max; \
+    r->filterOutput = vars[i].filterOutput; \
+  }
+#define WRITE_BOOLEAN(s, vars) \
+  for (i = 0; i < header.count[s]; i++) { \
+    INIT_BIN_BOOLEAN *r = ((INIT_BIN_BOOLEAN*) records[s]) + i; \
+    writeVarInfo(&strings, &vars[i].info, &r->info); \
+    r->useStart = vars[i].attribute.useStart; \
+    r->start = vars[i].attribute.start; \
+    r->fixed = vars[i].attribute.fixed; \
+    r->filterOutput = vars[i].filterOutput; \
+  }
+#define WRITE_STRING(s, vars) \
+  for (i = 0; i < header.count[s]; i++) { \
+    INIT_BIN_STRING *r = ((INIT_BIN_STRING*) records[s]) + i; \
+    writeVarInfo(&strings, &vars[i].info, &r->info); \
+    r->useStart = vars[i].attribute.useStart; \
+    r->start = addString(&strings, MMC_STRINGDATA(vars[i].attribute.start)); \
+    r->filterOutput = vars[i].filterOutput; \
+  }
+#define WRITE_ALIAS(s, vars) \
+  for (i = 0; i < header.count[s]; i++) { \
+    INIT_BIN_ALIAS *r = ((INIT_BIN_ALIAS*) records[s]) + i; \
+    writeVarInfo(&strings, &vars[i].info, &r->info); \
+    r->nameID = vars[i].nameID; \
+    r->negate = vars[i].negate; \
+    r->aliasType = vars[i].aliasType; \
+    r->filterOutput = vars[i].filterOutput; \
+  }
+
+  WRITE_REAL(INIT_BIN_REAL_VARS, modelData->realVarsData)
+  WRITE_INTEGER(INIT_BIN_INTEGER_VARS, modelData->integerVarsData)
+  WRITE_BOOLEAN(INIT_BIN_BOOLEAN_VARS, modelData->booleanVarsData)
+  WRITE_STRING(INIT_BIN_STRING_VARS, modelData->stringVarsData)
+  WRITE_REAL(INIT_BIN_REAL_PARAMETERS, modelData->realParameterData)
+  WRITE_INTEGER(INIT_BIN_INTEGER_PARAMETERS, modelData->integerParameterData)
+  WRITE_BOOLEAN(INIT_BIN_BOOLEAN_PARAMETERS, modelData->booleanParameterData)
+  WRITE_STRING(INIT_BIN_STRING_PARAMETERS, modelData->stringParameterData)
+  WRITE_ALIAS(INIT_BIN_REAL_ALIAS, modelData->realAlias)
+  WRITE_ALIAS(INIT_BIN_INTEGER_ALIAS, modelData->integerAlias)
+  WRITE_ALIAS(INIT_BIN_BOOLEAN_ALIAS, modelData->booleanAlias)
+  WRITE_ALIAS(INIT_BIN_STRING_ALIAS, modelData->stringAlias)
+
+#undef WRITE_REAL
+#undef WRITE_INTEGER
+#undef WRITE_BOOLEAN
+#undef WRITE_STRING
+#undef WRITE_ALIAS
+
+  /* write to a temporary file first; other processes may map the old image */
+  tmpFilename = (char*) malloc(strlen(binFilename) + 32);
+  sprintf(tmpFilename, "%s.%ld.tmp", binFilename, (long) getpid());
+  file = fopen(tmpFilename, "wb");
+  if (NULL == file) {
+    warningStreamPrint(LOG_STDOUT, 0, "simulation_input_bin.c: could not create the init image %s: %s", tmpFilename, strerror(errno));
+    ok = 0;
+  } else {
+    /* the header is written again once all offsets are known */
+    pos = 0;
+    ok = UINT64_MAX != writeSection(file, &header, sizeof(header), &pos);
+    for (s = 0; ok && s < INIT_BIN_NUM_SECTIONS; s++) {
+      header.offset[s] = writeSection(file, records[s], (size_t) header.count[s] * recordSizes[s], &pos);
+      ok = UINT64_MAX != header.offset[s];
+    }
+    header.stringsSize = strings.size;
+    header.stringsOffset = ok ? writeSection(file, strings.data, strings.size, &pos) : UINT64_MAX;
+    ok = ok && UINT64_MAX != header.stringsOffset && 0 == fseek(file, 0, SEEK_SET) && 1 == fwrite(&header, sizeof(header), 1, file);
+    ok = (0 == fclose(file)) && ok;
+    if (ok) {
+#if defined(_WIN32)
+      remove(binFilename);
+#endif
+      ok = 0 == rename(tmpFilename, binFilename);
+    }
+    if (!ok) {
+      warningStreamPrint(LOG_STDOUT, 0, "simulation_input_bin.c: could not write the init image %s: %s", binFilename, strerror(errno));
+      remove(tmpFilename);
+    }
+  }
+  if (ok) {
+    infoStreamPrint(LOG_SIMULATION, 0, "wrote init image %s (%ld bytes)", binFilename, (long) pos);
+  }
+
+  free(tmpFilename);
+  for (s = 0; s < INIT_BIN_NUM_SECTIONS; s++) {
+    free(records[s]);
+  }
+  freeStrings(&strings);
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Binary init image.
+ *
+ * The data read from <model>_init.xml is stored in a flat binary image
+ * (<model>_init.bin) with a header identifying the model (GUID), the XML file
+ * it was created from (size and modification time), the variable counts and
+ * the layout of the records. Later runs map the image and copy the records
+ * into MODEL_DATA without parsing any XML, see -initCache.
+ */
+
+#ifndef _SIMULATION_INPUT_BIN_H
+#define _SIMULATION_INPUT_BIN_H
+
+#include "simulation_runtime.h"
+#include "util/omc_mmap.h"
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns the name of the image belonging to the given _init.xml file (malloc'ed) */
+char* input_bin_filename(const char *xmlFilename);
+
+/* Fills modelData and simulationInfo from the image. Returns 0 if the image
+ * does not exist or does not match the model or the XML file. */
+int read_input_bin(MODEL_DATA* modelData, SIMULATION_INFO* simulationInfo, const char *binFilename, const char *xmlFilename);
+
+/* Stores the data read by read_input_xml (before any override is applied) */
+void write_input_bin(MODEL_DATA* modelData, SIMULATION_INFO* simulationInfo, const char *binFilename, const char *xmlFilename);
+
+/* Unmaps the image; the variable names point into it until then */
+static inline void free_input_bin(MODEL_DATA* modelData)
+{
+  if (modelData->initImage) {
+    omc_mmap_close_read(*((omc_mmap_read*) modelData->initImage));
+    free(modelData->initImage);
+    modelData->initImage = NULL;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -39,6 +39,7 @@
 
 
 #include "simulation_input_xml.h"
+#include "simulation_input_bin.h"
 #include "simulation_runtime.h"
 #include "options.h"
 #include "util/omc_error.h"
@@ -205,6 +206,8 @@ typedef hash_string_long omc_CommandLineOverridesUses;
 
 // function to handle command line settings override
 void doOverride(omc_ModelInput *mi, MODEL_DATA* modelData, const char* override, const char* overrideFile);
+// same for the data loaded from the binary init image
+static void doOverrideModelData(MODEL_DATA* modelData, SIMULATION_INFO* simulationInfo, const char* override, const char* overrideFile);
 
 static const double REAL_MIN = -DBL_MAX;
 static const double REAL_MAX = DBL_MAX;
@@ -423,6 +426,7 @@ void read_input_xml(MODEL_DATA* modelData,
 {
   omc_ModelInput mi = {0};
   const char *filename, *guid, *override, *overrideFile;
+  char *binFilename = NULL;
   FILE* file = NULL;
   XML_Parser parser = NULL;
   hash_string_long *mapAlias = NULL, *mapAliasParam = NULL;
@@ -435,6 +439,11 @@ void read_input_xml(MODEL_DATA* modelData,
   modelica_integer nyboolchk, npboolchk;
   modelica_integer nystrchk, npstrchk;
 
+  modelData->initImage = NULL;
+  modelData->sharesStaticData = 0;
+  override = omc_flagValue[FLAG_OVERRIDE];
+  overrideFile = omc_flagValue[FLAG_OVERRIDE_FILE];
+
   if(NULL == modelData->initXMLData)
   {
     /* read the filename from the command line (if any) */
@@ -448,6 +457,16 @@ void read_input_xml(MODEL_DATA* modelData,
       }
     }
 
+    /* use the binary init image if it is up to date, otherwise it is written after reading the XML file */
+    if(omc_flag[FLAG_INIT_CACHE]) {
+      binFilename = input_bin_filename(filename);
+      if(read_input_bin(modelData, simulationInfo, binFilename, filename)) {
+        free(binFilename);
+        doOverrideModelData(modelData, simulationInfo, override, overrideFile);
+        return;
+      }
+    }
+
     /* open the file and fail on error. we open it read-write to be sure other processes can overwrite it */
     file = fopen(filename, "r");
     if(!file) {
@@ -514,10 +533,10 @@ void read_input_xml(MODEL_DATA* modelData,
     throwStreamPrint(NULL, "see last warning");
   }
 
-  // deal with override
-  override = omc_flagValue[FLAG_OVERRIDE];
-  overrideFile = omc_flagValue[FLAG_OVERRIDE_FILE];
-  doOverride(&mi, modelData, override, overrideFile);
+  // deal with override; the init image is written without them
+  if(NULL == binFilename) {
+    doOverride(&mi, modelData, override, overrideFile);
+  }
 
   /* read all the DefaultExperiment values */
   infoStreamPrint(LOG_SIMULATION, 1, "read all the DefaultExperiment values:");
@@ -807,6 +826,12 @@ void read_input_xml(MODEL_DATA* modelData,
   messageClose(LOG_DEBUG);
 
   XML_ParserFree(parser);
+
+  if(NULL != binFilename) {
+    write_input_bin(modelData, simulationInfo, binFilename, filename);
+    free(binFilename);
+    doOverrideModelData(modelData, simulationInfo, override, overrideFile);
+  }
 }
 
 /* reads modelica_string value from a string */
@@ -884,11 +909,10 @@ static const char* getOverrideValue(omc_CommandLineOverrides *mOverrides, omc_Co
   return findHashStringString(mOverrides, name);
 }
 
-void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override, const char *overrideFile)
+/* reads the -override/-overrideFile values into a map, NULL if there are none */
+static omc_CommandLineOverrides* readOverrides(const char *override, const char *overrideFile, omc_CommandLineOverridesUses **mOverridesUses)
 {
   omc_CommandLineOverrides *mOverrides = NULL;
-  omc_CommandLineOverridesUses *mOverridesUses = NULL, *it = NULL, *ittmp = NULL;
-  mmc_sint_t i;
   char* overrideStr = NULL;
   if((override != NULL) && (overrideFile != NULL)) {
     throwStreamPrint(NULL, "simulation_input_xml.c: usage error you cannot have both -override and -overrideFile active at the same time. see Model -? for more info!");
@@ -950,7 +974,6 @@ void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override,
 
   if (overrideStr != NULL) {
     char *value, *p;
-    const char *strs[] = {"solver","startTime","stopTime","stepSize","tolerance","outputFormat","variableFilter"};
     /* read override values */
     infoStreamPrint(LOG_SOLVER, 0, "read override values: %s", overrideStr);
     /* fix overrideStr to contain | instead of , for splitting */
@@ -968,7 +991,7 @@ void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override,
       value++;
       // map[key]=value
       addHashStringString(&mOverrides, p, value);
-      addHashStringLong(&mOverridesUses, p, OMC_OVERRIDE_UNUSED);
+      addHashStringLong(mOverridesUses, p, OMC_OVERRIDE_UNUSED);
 
       infoStreamPrint(LOG_SOLVER, 0, "override %s = %s", p, value);
 
@@ -977,7 +1000,31 @@ void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override,
     }
 
     free(overrideStr);
+  }
+
+  return mOverrides;
+}
+
+/* gives a warning if an override is not used #3204 */
+static void checkOverridesUsed(omc_CommandLineOverridesUses *mOverridesUses)
+{
+  omc_CommandLineOverridesUses *it = NULL, *ittmp = NULL;
+  HASH_ITER(hh, mOverridesUses, it, ittmp) {
+    if (it->val == OMC_OVERRIDE_UNUSED) {
+      warningStreamPrint(LOG_STDOUT, 0, "simulation_input_xml.c: override variable name not found in model: %s\n", it->id);
+    }
+  }
+}
+
+void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override, const char *overrideFile)
+{
+  omc_CommandLineOverrides *mOverrides = NULL;
+  omc_CommandLineOverridesUses *mOverridesUses = NULL;
+  mmc_sint_t i;
 
+  mOverrides = readOverrides(override, overrideFile, &mOverridesUses);
+  if (mOverrides != NULL) {
+    const char *strs[] = {"solver","startTime","stopTime","stepSize","tolerance","outputFormat","variableFilter"};
     // now we have all overrides in mOverrides, override mi now
     for (i=0; i<sizeof(strs)/sizeof(char*); i++) {
       if (findHashStringStringNull(mOverrides, strs[i])) {
@@ -1036,12 +1083,7 @@ void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override,
       CHECK_OVERRIDE(sAli);
     }
 
-    // give a warning if an override is not used #3204
-    HASH_ITER(hh, mOverridesUses, it, ittmp) {
-      if (it->val == OMC_OVERRIDE_UNUSED) {
-        warningStreamPrint(LOG_STDOUT, 0, "simulation_input_xml.c: override variable name not found in model: %s\n", it->id);
-      }
-    }
+    checkOverridesUsed(mOverridesUses);
 
     infoStreamPrint(LOG_SOLVER, 0, "override done!");
   } else {
@@ -1049,6 +1091,78 @@ void doOverride(omc_ModelInput *mi, MODEL_DATA *modelData, const char *override,
   }
 }
 
+/* applies the overrides directly to the data loaded from the init image */
+static void doOverrideModelData(MODEL_DATA *modelData, SIMULATION_INFO *simulationInfo, const char *override, const char *overrideFile)
+{
+  omc_CommandLineOverrides *mOverrides = NULL;
+  omc_CommandLineOverridesUses *mOverridesUses = NULL;
+  const char *value;
+  mmc_sint_t i;
+
+  mOverrides = readOverrides(override, overrideFile, &mOverridesUses);
+  if (mOverrides == NULL) {
+    infoStreamPrint(LOG_SOLVER, 0, "NO override given on the command line.");
+    return;
+  }
+
+  if (findHashStringStringNull(mOverrides, "startTime")) {
+    read_value_real(getOverrideValue(mOverrides, &mOverridesUses, "startTime"), &simulationInfo->startTime, 0);
+  }
+  if (findHashStringStringNull(mOverrides, "stopTime")) {
+    read_value_real(getOverrideValue(mOverrides, &mOverridesUses, "stopTime"), &simulationInfo->stopTime, 1.0);
+  }
+  if (findHashStringStringNull(mOverrides, "stepSize")) {
+    read_value_real(getOverrideValue(mOverrides, &mOverridesUses, "stepSize"), &simulationInfo->stepSize, (simulationInfo->stopTime - simulationInfo->startTime) / 500);
+  }
+  if (findHashStringStringNull(mOverrides, "tolerance")) {
+    read_value_real(getOverrideValue(mOverrides, &mOverridesUses, "tolerance"), &simulationInfo->tolerance, 1e-5);
+  }
+  if (findHashStringStringNull(mOverrides, "solver")) {
+    read_value_string(getOverrideValue(mOverrides, &mOverridesUses, "solver"), &simulationInfo->solverMethod);
+  }
+  if (findHashStringStringNull(mOverrides, "outputFormat")) {
+    read_value_string(getOverrideValue(mOverrides, &mOverridesUses, "outputFormat"), &simulationInfo->outputFormat);
+  }
+  if (findHashStringStringNull(mOverrides, "variableFilter")) {
+    read_value_string(getOverrideValue(mOverrides, &mOverridesUses, "variableFilter"), &simulationInfo->variableFilter);
+  }
+
+  #define CHECK_OVERRIDE_DATA(vars, n, read_start) \
+    for(i=0; i<modelData->n; i++) { \
+      if (findHashStringStringNull(mOverrides, modelData->vars[i].info.name)) { \
+        value = getOverrideValue(mOverrides, &mOverridesUses, modelData->vars[i].info.name); \
+        read_start; \
+      } \
+    }
+
+  CHECK_OVERRIDE_DATA(realVarsData, nVariablesReal, read_value_real(value, &modelData->realVarsData[i].attribute.start, 0.0));
+  CHECK_OVERRIDE_DATA(integerVarsData, nVariablesInteger, read_value_long(value, &modelData->integerVarsData[i].attribute.start, 0));
+  CHECK_OVERRIDE_DATA(booleanVarsData, nVariablesBoolean, read_value_bool(value, &modelData->booleanVarsData[i].attribute.start));
+  CHECK_OVERRIDE_DATA(stringVarsData, nVariablesString, {
+    const char *start = NULL;
+    read_value_string(value, &start);
+    modelData->stringVarsData[i].attribute.start = mmc_mk_scon_persist(start);
+  });
+  CHECK_OVERRIDE_DATA(realParameterData, nParametersReal, read_value_real(value, &modelData->realParameterData[i].attribute.start, 0.0));
+  CHECK_OVERRIDE_DATA(integerParameterData, nParametersInteger, read_value_long(value, &modelData->integerParameterData[i].attribute.start, 0));
+  CHECK_OVERRIDE_DATA(booleanParameterData, nParametersBoolean, read_value_bool(value, &modelData->booleanParameterData[i].attribute.start));
+  CHECK_OVERRIDE_DATA(stringParameterData, nParametersString, {
+    const char *start = NULL;
+    read_value_string(value, &start);
+    modelData->stringParameterData[i].attribute.start = mmc_mk_scon_persist(start);
+  });
+  /* the start value of an alias is not read from the XML file either */
+  CHECK_OVERRIDE_DATA(realAlias, nAliasReal, (void) value);
+  CHECK_OVERRIDE_DATA(integerAlias, nAliasInteger, (void) value);
+  CHECK_OVERRIDE_DATA(booleanAlias, nAliasBoolean, (void) value);
+  CHECK_OVERRIDE_DATA(stringAlias, nAliasString, (void) value);
+  #undef CHECK_OVERRIDE_DATA
+
+  checkOverridesUsed(mOverridesUses);
+
+  infoStreamPrint(LOG_SOLVER, 0, "override done!");
+}
+
 void parseVariableStr(char* variableStr)
 {
   /* TODO! FIXME!: support also quoted identifiers containing comma: , */
@@ -35,9 +35,11 @@
 #include "meta/meta_modelica.h"
 #include "simulation_runtime.h"
 
-int terminationTerminate = 0; /* Becomes non-zero when user terminates simulation. */
-FILE_INFO TermInfo;           /* message for termination. */
-char* TermMsg;                /* message for termination. */
+/* per thread, so that each thread can run its own model instance */
+OMC_THREAD_LOCAL int terminationTerminate = 0; /* Becomes non-zero when user terminates simulation. */
+OMC_THREAD_LOCAL FILE_INFO TermInfo;           /* message for termination. */
+OMC_THREAD_LOCAL char* TermMsg;                /* message for termination. */
+static OMC_THREAD_LOCAL size_t termMsgSize = 0;
 
 /*! \fn void setTermMsg(const char* msg)
  *
@@ -47,7 +49,6 @@ char* TermMsg;                /* message for termination. */
 static void setTermMsg(const char *msg, va_list ap)
 {
   size_t i;
-  static size_t termMsgSize = 0;
   if(NULL == TermMsg)
   {
     termMsgSize = modelica_integer_max(strlen(msg)*2+1,(size_t)2048);
@@ -67,6 +67,7 @@
 #include "linearize.h"
 #include "options.h"
 #include "simulation_runtime.h"
+#include "simulation_batch.h"
 #include "simulation_input_xml.h"
 #include "simulation/results/simulation_result_plt.h"
 #include "simulation/results/simulation_result_csv.h"
@@ -76,12 +77,14 @@
 #include "simulation/solver/solver_main.h"
 #include "simulation_info_json.h"
 #include "modelinfo.h"
+#include "profile_aggregate.h"
 #include "simulation/solver/events.h"
 #include "simulation/solver/model_help.h"
 #include "simulation/solver/mixedSystem.h"
 #include "simulation/solver/linearSystem.h"
 #include "simulation/solver/nonlinearSystem.h"
 #include "util/rtclock.h"
+#include "util/omc_trace.h"
 #include "omc_config.h"
 #include "simulation/solver/initialization/initialization.h"
 
@@ -461,12 +464,19 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
     }
   }
 
+  if(omc_flag[FLAG_BINARY_TRACE]) {
+    omc_trace_open(omc_flagValue[FLAG_BINARY_TRACE], OMC_TRACE_DEFAULT_RING_SIZE);
+  }
+
   if(measure_time_flag) {
     rt_tick(SIM_TIMER_INFO_XML);
     modelInfoInit(&data->modelData->modelDataXml);
     rt_accumulate(SIM_TIMER_INFO_XML);
     //std::cerr << "ModelData with " << data->modelData->modelDataXml.nFunctions << " functions and " << data->modelData->modelDataXml.nEquations << " equations and " << data->modelData->modelDataXml.nProfileBlocks << " profileBlocks\n" << std::endl;
     rt_init(SIM_TIMER_FIRST_FUNCTION + data->modelData->modelDataXml.nFunctions + data->modelData->modelDataXml.nEquations + data->modelData->modelDataXml.nProfileBlocks + 4 /* sentinel */);
+    if (omc_flag[FLAG_MEASURETIME_PERF_COUNTERS] && rt_hw_init(SIM_TIMER_FIRST_FUNCTION + data->modelData->modelDataXml.nFunctions + data->modelData->modelDataXml.nProfileBlocks)) {
+      warningStreamPrint(LOG_STDOUT, 0, "Hardware performance counters are not available for the current platform or user (see /proc/sys/kernel/perf_event_paranoid): %s", strerror(errno));
+    }
     rt_measure_overhead(SIM_TIMER_TOTAL);
     rt_clear(SIM_TIMER_TOTAL);
     rt_tick(SIM_TIMER_TOTAL);
@@ -486,13 +496,6 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
     infoStreamPrint(LOG_STDOUT, 0, "Linearization will performed at point of time: %f", data->simulationInfo->stopTime);
   }
 
-  if(omc_flag[FLAG_S]) {
-    if (omc_flagValue[FLAG_S]) {
-      data->simulationInfo->solverMethod = GC_strdup(omc_flagValue[FLAG_S]);
-      infoStreamPrint(LOG_SOLVER, 0, "overwrite solver method: %s [from command line]", data->simulationInfo->solverMethod);
-    }
-  }
-
   // Create a result file
   const char *result_file = omc_flagValue[FLAG_R];
   string result_file_cstr;
@@ -503,42 +506,7 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
     data->modelData->resultFileName = GC_strdup(result_file);
   }
 
-  string init_initMethod = "";
-  string init_file = "";
-  string init_time_string = "";
-  double init_time = 0.0;
-  string init_lambda_steps_string = "";
-  int init_lambda_steps = 1;
-  string outputVariablesAtEnd = "";
-  int cpuTime = omc_flag[FLAG_CPU];
-
-  if(omc_flag[FLAG_IIM]) {
-    init_initMethod = omc_flagValue[FLAG_IIM];
-  }
-  if(omc_flag[FLAG_IIF]) {
-    init_file = omc_flagValue[FLAG_IIF];
-  }
-  if(omc_flag[FLAG_IIT]) {
-    init_time_string = omc_flagValue[FLAG_IIT];
-    init_time = atof(init_time_string.c_str());
-  }
-  if(omc_flag[FLAG_ILS]) {
-    init_lambda_steps_string = omc_flagValue[FLAG_ILS];
-    init_lambda_steps = atoi(init_lambda_steps_string.c_str());
-  }
-  if(omc_flag[FLAG_MAX_BISECTION_ITERATIONS]) {
-    maxBisectionIterations = atoi(omc_flagValue[FLAG_MAX_BISECTION_ITERATIONS]);
-    infoStreamPrint(LOG_STDOUT, 0, "Maximum number of bisection iterations changed to %d", maxBisectionIterations);
-  }
-  if(omc_flag[FLAG_MAX_EVENT_ITERATIONS]) {
-    maxEventIterations = atoi(omc_flagValue[FLAG_MAX_EVENT_ITERATIONS]);
-    infoStreamPrint(LOG_STDOUT, 0, "Maximum number of event iterations changed to %d", maxEventIterations);
-  }
-  if(omc_flag[FLAG_OUTPUT]) {
-    outputVariablesAtEnd = omc_flagValue[FLAG_OUTPUT];
-  }
-
-  retVal = callSolver(data, threadData, init_initMethod, init_file, init_time, init_lambda_steps, outputVariablesAtEnd, cpuTime, argv[0]);
+  retVal = runSimulation(data, threadData, argv[0]);
 
   if (omc_flag[FLAG_ALARM]) {
     alarm(0);
@@ -567,11 +535,58 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
         data->simulationInfo->solverMethod, data->simulationInfo->outputFormat, data->modelData->resultFileName) && retVal;
     retVal = printModelInfoJSON(data, threadData, jsonInfo.c_str(), data->modelData->resultFileName) && retVal;
   }
+  prof_aggregate_free();
+  rt_hw_close();
+  omc_trace_close();
 
   TRACE_POP
   return retVal;
 }
 
+/**
+ * Simulates an initialized model with the solver and the initialization
+ * settings given on the command line. The caller sets the result file name
+ * and the number of steps; used for single simulations and batch runs.
+ */
+int runSimulation(DATA* data, threadData_t *threadData, const char *argv_0)
+{
+  if(omc_flag[FLAG_S]) {
+    if (omc_flagValue[FLAG_S]) {
+      data->simulationInfo->solverMethod = GC_strdup(omc_flagValue[FLAG_S]);
+      infoStreamPrint(LOG_SOLVER, 0, "overwrite solver method: %s [from command line]", data->simulationInfo->solverMethod);
+    }
+  }
+
+  string init_initMethod = "";
+  string init_file = "";
+  string init_time_string = "";
+  double init_time = 0.0;
+  string init_lambda_steps_string = "";
+  int init_lambda_steps = 1;
+  string outputVariablesAtEnd = "";
+  int cpuTime = omc_flag[FLAG_CPU];
+
+  if(omc_flag[FLAG_IIM]) {
+    init_initMethod = omc_flagValue[FLAG_IIM];
+  }
+  if(omc_flag[FLAG_IIF]) {
+    init_file = omc_flagValue[FLAG_IIF];
+  }
+  if(omc_flag[FLAG_IIT]) {
+    init_time_string = omc_flagValue[FLAG_IIT];
+    init_time = atof(init_time_string.c_str());
+  }
+  if(omc_flag[FLAG_ILS]) {
+    init_lambda_steps_string = omc_flagValue[FLAG_ILS];
+    init_lambda_steps = atoi(init_lambda_steps_string.c_str());
+  }
+  if(omc_flag[FLAG_OUTPUT]) {
+    outputVariablesAtEnd = omc_flagValue[FLAG_OUTPUT];
+  }
+
+  return callSolver(data, threadData, init_initMethod, init_file, init_time, init_lambda_steps, outputVariablesAtEnd, cpuTime, argv_0);
+}
+
 /*! \fn initializeResultData(DATA* simData, int cpuTime)
  *
  *  \param [ref] [simData]
@@ -801,6 +816,14 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
     linearSparseSolverMinSize = atoi(omc_flagValue[FLAG_LSS_MIN_SIZE]);
     infoStreamPrint(LOG_STDOUT, 0, "Maximum system size for using linear sparse solver changed to %d", linearSparseSolverMinSize);
   }
+  if(omc_flag[FLAG_MAX_BISECTION_ITERATIONS]) {
+    maxBisectionIterations = atoi(omc_flagValue[FLAG_MAX_BISECTION_ITERATIONS]);
+    infoStreamPrint(LOG_STDOUT, 0, "Maximum number of bisection iterations changed to %d", maxBisectionIterations);
+  }
+  if(omc_flag[FLAG_MAX_EVENT_ITERATIONS]) {
+    maxEventIterations = atoi(omc_flagValue[FLAG_MAX_EVENT_ITERATIONS]);
+    infoStreamPrint(LOG_STDOUT, 0, "Maximum number of event iterations changed to %d", maxEventIterations);
+  }
 
   rt_tick(SIM_TIMER_INIT_XML);
   read_input_xml(data->modelData, data->simulationInfo);
@@ -904,7 +927,11 @@ int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *thre
     signal(SIGUSR1, SimulationRuntime_printStatus);
 #endif
 
-    retVal = startNonInteractiveSimulation(argc, argv, data, threadData);
+    if(omc_flag[FLAG_BATCH]) {
+      retVal = runBatch(argc, argv, data, threadData);
+    } else {
+      retVal = startNonInteractiveSimulation(argc, argv, data, threadData);
+    }
 
     freeMixedSystems(data, threadData);        /* free mixed system data */
     freeLinearSystems(data, threadData);       /* free linear system data */
@@ -0,0 +1,1115 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file checkpoint.c
+ *
+ *  The checkpoint image consists of a header followed by the sections below,
+ *  always in this order:
+ *   - the localData ring buffer
+ *   - simulationInfo: old and pre values, parameters, zero-crossings,
+ *     relations, samples, clocks, chattering and call statistics
+ *   - the timer queue of the synchronous features
+ *   - the delay buffers
+ *   - per nonlinear system the iteration variables and the value list used
+ *     for extrapolation
+ *   - the pivoting of the state sets
+ *   - SOLVER_INFO and the internal data of the integrator
+ *  Values are stored in the native byte order; the header records byte order
+ *  and type sizes and an image from another platform is rejected. It also
+ *  holds a checksum of the sections. checkpointDeserialize validates sizes
+ *  and checksum of the whole image before it copies anything, so a corrupt
+ *  image leaves the model as it was.
+ */
+
+#include "checkpoint.h"
+#include "dassl.h"
+#include "delay.h"
+#include "ida_solver.h"
+#include "model_help.h"
+#include "nonlinearValuesList.h"
+#include "synchronous.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+#include "util/ringbuffer.h"
+#include "meta/meta_modelica.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#if defined(_MSC_VER)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define CHECKPOINT_MAGIC "OMCCHKPT"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_BYTE_ORDER 0x01020304
+#define CHECKPOINT_NO_STRING UINT32_MAX
+
+enum CHECKPOINT_COUNT
+{
+  CHECKPOINT_STATES = 0,
+  CHECKPOINT_REAL_VARS,
+  CHECKPOINT_INTEGER_VARS,
+  CHECKPOINT_BOOLEAN_VARS,
+  CHECKPOINT_STRING_VARS,
+  CHECKPOINT_REAL_PARAMETERS,
+  CHECKPOINT_INTEGER_PARAMETERS,
+  CHECKPOINT_BOOLEAN_PARAMETERS,
+  CHECKPOINT_STRING_PARAMETERS,
+  CHECKPOINT_ZERO_CROSSINGS,
+  CHECKPOINT_RELATIONS,
+  CHECKPOINT_MATH_EVENTS,
+  CHECKPOINT_SAMPLES,
+  CHECKPOINT_CLOCKS,
+  CHECKPOINT_DELAY_EXPRESSIONS,
+  CHECKPOINT_NONLINEAR_SYSTEMS,
+  CHECKPOINT_STATE_SETS,
+  CHECKPOINT_INPUT_VARS,
+  CHECKPOINT_OUTPUT_VARS,
+  CHECKPOINT_RING_BUFFER,
+  CHECKPOINT_NUM_COUNTS
+};
+
+typedef struct CHECKPOINT_HEADER
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t sizeofInteger;
+  uint32_t sizeofBoolean;
+  int64_t count[CHECKPOINT_NUM_COUNTS];
+  int32_t solverMethod;                /* -1 if the image holds no integrator state */
+  uint32_t guidLength;
+  uint64_t checksum;                   /* of everything after the header */
+} CHECKPOINT_HEADER;
+
+static const char *COUNT_NAME[CHECKPOINT_NUM_COUNTS] = {
+  "states", "real variables", "integer variables", "boolean variables", "string variables",
+  "real parameters", "integer parameters", "boolean parameters", "string parameters",
+  "zero-crossings", "relations", "math events", "samples", "clocks", "delay expressions",
+  "nonlinear systems", "state sets", "inputs", "outputs", "ring buffer"
+};
+
+static void modelCounts(DATA *data, int64_t *count)
+{
+  MODEL_DATA *mData = data->modelData;
+
+  count[CHECKPOINT_STATES] = mData->nStates;
+  count[CHECKPOINT_REAL_VARS] = mData->nVariablesReal;
+  count[CHECKPOINT_INTEGER_VARS] = mData->nVariablesInteger;
+  count[CHECKPOINT_BOOLEAN_VARS] = mData->nVariablesBoolean;
+  count[CHECKPOINT_STRING_VARS] = mData->nVariablesString;
+  count[CHECKPOINT_REAL_PARAMETERS] = mData->nParametersReal;
+  count[CHECKPOINT_INTEGER_PARAMETERS] = mData->nParametersInteger;
+  count[CHECKPOINT_BOOLEAN_PARAMETERS] = mData->nParametersBoolean;
+  count[CHECKPOINT_STRING_PARAMETERS] = mData->nParametersString;
+  count[CHECKPOINT_ZERO_CROSSINGS] = mData->nZeroCrossings;
+  count[CHECKPOINT_RELATIONS] = mData->nRelations;
+  count[CHECKPOINT_MATH_EVENTS] = mData->nMathEvents;
+  count[CHECKPOINT_SAMPLES] = mData->nSamples;
+  count[CHECKPOINT_CLOCKS] = mData->nClocks;
+  count[CHECKPOINT_DELAY_EXPRESSIONS] = mData->nDelayExpressions;
+  count[CHECKPOINT_NONLINEAR_SYSTEMS] = mData->nNonLinearSystems;
+  count[CHECKPOINT_STATE_SETS] = mData->nStateSets;
+  count[CHECKPOINT_INPUT_VARS] = mData->nInputVars;
+  count[CHECKPOINT_OUTPUT_VARS] = mData->nOutputVars;
+  count[CHECKPOINT_RING_BUFFER] = (int64_t) SIZERINGBUFFER;
+}
+
+/* FNV-1a */
+static uint64_t checksum(const char *p, size_t n)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    hash = (hash ^ (unsigned char) p[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+/***************************************    BUFFER     *********************************/
+
+static void putBytes(CHECKPOINT_BUFFER *buffer, const void *p, size_t n)
+{
+  if (buffer->error || 0 == n) {
+    return;
+  }
+  if (buffer->size + n > buffer->capacity) {
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    char *tmp;
+    while (capacity < buffer->size + n) {
+      capacity *= 2;
+    }
+    if (buffer->allocateMemory) {
+      tmp = (char*) buffer->allocateMemory(capacity, 1);
+      if (tmp && buffer->size) {
+        memcpy(tmp, buffer->data, buffer->size);
+      }
+      if (tmp && buffer->data) {
+        buffer->freeMemory(buffer->data);
+      }
+    } else {
+      tmp = (char*) realloc(buffer->data, capacity);
+    }
+    if (NULL == tmp) {
+      buffer->error = 1;
+      return;
+    }
+    buffer->data = tmp;
+    buffer->capacity = capacity;
+  }
+  memcpy(buffer->data + buffer->size, p, n);
+  buffer->size += n;
+}
+
+static void getBytes(CHECKPOINT_BUFFER *buffer, void *p, size_t n)
+{
+  if (0 == n) {
+    return;
+  }
+  if (buffer->error || buffer->pos + n > buffer->size) {
+    buffer->error = 1;
+    memset(p, 0, n);
+    return;
+  }
+  memcpy(p, buffer->data + buffer->pos, n);
+  buffer->pos += n;
+}
+
+/* moves the read position over n elements of the given size without reading them */
+static void skipBytes(CHECKPOINT_BUFFER *buffer, uint64_t n, size_t size)
+{
+  if (buffer->error || n > (buffer->size - buffer->pos) / size) {
+    buffer->error = 1;
+    return;
+  }
+  buffer->pos += (size_t) n * size;
+}
+
+#define PUT(buffer, x) putBytes(buffer, &(x), sizeof(x))
+#define GET(buffer, x) getBytes(buffer, &(x), sizeof(x))
+#define SKIP(buffer, x) skipBytes(buffer, 1, sizeof(x))
+#define PUT_ARRAY(buffer, p, n) putBytes(buffer, p, (size_t)(n) * sizeof(*(p)))
+#define GET_ARRAY(buffer, p, n) getBytes(buffer, p, (size_t)(n) * sizeof(*(p)))
+#define SKIP_ARRAY(buffer, p, n) skipBytes(buffer, n, sizeof(*(p)))
+
+static void putString(CHECKPOINT_BUFFER *buffer, modelica_string s)
+{
+  uint32_t len = s ? (uint32_t) MMC_STRLEN(s) : CHECKPOINT_NO_STRING;
+  PUT(buffer, len);
+  if (s) {
+    putBytes(buffer, MMC_STRINGDATA(s), (size_t) len + 1);
+  }
+}
+
+static modelica_string getString(CHECKPOINT_BUFFER *buffer)
+{
+  uint32_t len;
+  const char *s;
+
+  GET(buffer, len);
+  if (buffer->error || CHECKPOINT_NO_STRING == len) {
+    return NULL;
+  }
+  if (buffer->pos + len + 1 > buffer->size || buffer->data[buffer->pos + len] != '\0') {
+    buffer->error = 1;
+    return NULL;
+  }
+  s = buffer->data + buffer->pos;
+  buffer->pos += (size_t) len + 1;
+  return (modelica_string) mmc_mk_scon(s);
+}
+
+static void skipString(CHECKPOINT_BUFFER *buffer)
+{
+  uint32_t len;
+
+  GET(buffer, len);
+  if (buffer->error || CHECKPOINT_NO_STRING == len) {
+    return;
+  }
+  skipBytes(buffer, len, 1);
+  if (buffer->error || buffer->pos == buffer->size || buffer->data[buffer->pos] != '\0') {
+    buffer->error = 1;
+    return;
+  }
+  buffer->pos++;
+}
+
+static void putStrings(CHECKPOINT_BUFFER *buffer, modelica_string *s, long n)
+{
+  long i;
+  for (i = 0; i < n; i++) {
+    putString(buffer, s[i]);
+  }
+}
+
+static void getStrings(CHECKPOINT_BUFFER *buffer, modelica_string *s, long n)
+{
+  long i;
+  for (i = 0; i < n; i++) {
+    s[i] = getString(buffer);
+  }
+}
+
+static void skipStrings(CHECKPOINT_BUFFER *buffer, long n)
+{
+  long i;
+  for (i = 0; i < n; i++) {
+    skipString(buffer);
+  }
+}
+
+/***************************************    SERIALIZE     *********************************/
+
+static void putDasslData(CHECKPOINT_BUFFER *buffer, DATA *data, DASSL_DATA *dasslData)
+{
+  PUT(buffer, dasslData->liw);
+  PUT(buffer, dasslData->lrw);
+  PUT(buffer, dasslData->idid);
+  PUT(buffer, dasslData->dasslStepsOutputCounter);
+  PUT_ARRAY(buffer, dasslData->info, infoLength);
+  PUT_ARRAY(buffer, dasslData->iwork, dasslData->liw);
+  PUT_ARRAY(buffer, dasslData->rwork, dasslData->lrw);
+  PUT_ARRAY(buffer, dasslData->jroot, data->modelData->nZeroCrossings);
+  PUT_ARRAY(buffer, dasslData->stateDer, data->modelData->nStates);
+}
+
+static void putSolverInfo(CHECKPOINT_BUFFER *buffer, DATA *data, SOLVER_INFO *solverInfo)
+{
+  CHECKPOINT_BUFFER solverData = {0};
+  uint64_t size, nEvents = listLen(solverInfo->eventLst);
+  LIST_NODE *node;
+
+  PUT(buffer, solverInfo->currentTime);
+  PUT(buffer, solverInfo->currentStepSize);
+  PUT(buffer, solverInfo->laststep);
+  PUT(buffer, solverInfo->lastdesiredStep);
+  PUT(buffer, solverInfo->didEventStep);
+  PUT(buffer, solverInfo->stateEvents);
+  PUT(buffer, solverInfo->sampleEvents);
+  PUT_ARRAY(buffer, solverInfo->solverStats, numStatistics);
+  PUT_ARRAY(buffer, solverInfo->solverStatsTmp, numStatistics);
+  PUT(buffer, solverInfo->integratorSteps);
+  PUT(buffer, solverInfo->stepNo);
+  PUT(buffer, solverInfo->syncStep);
+  PUT(buffer, nEvents);
+  for (node = nEvents ? listFirstNode(solverInfo->eventLst) : NULL; node; node = listNextNode(node)) {
+    putBytes(buffer, listNodeData(node), sizeof(long));
+  }
+
+  /* integrator specific part, skipped on restore if the solver differs */
+  if (S_DASSL == solverInfo->solverMethod) {
+    putDasslData(&solverData, data, (DASSL_DATA*) solverInfo->solverData);
+  }
+  buffer->error = buffer->error || solverData.error;
+  size = solverData.size;
+  PUT(buffer, size);
+  putBytes(buffer, solverData.data, solverData.size);
+  free(solverData.data);
+}
+
+int checkpointSerialize(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer)
+{
+  TRACE_PUSH
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  CHECKPOINT_HEADER header;
+  LIST_NODE *node;
+  uint64_t len;
+  size_t start = buffer->size;
+  long i, j;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  header.byteOrder = CHECKPOINT_BYTE_ORDER;
+  header.sizeofInteger = sizeof(modelica_integer);
+  header.sizeofBoolean = sizeof(modelica_boolean);
+  modelCounts(data, header.count);
+  header.solverMethod = solverInfo ? solverInfo->solverMethod : -1;
+  header.guidLength = (uint32_t) strlen(mData->modelGUID);
+  PUT(buffer, header);
+  putBytes(buffer, mData->modelGUID, header.guidLength);
+
+  /* ring buffer, localData[0] is the current time step */
+  for (i = 0; i < SIZERINGBUFFER; i++) {
+    SIMULATION_DATA *sData = data->localData[i];
+    PUT(buffer, sData->timeValue);
+    PUT_ARRAY(buffer, sData->realVars, mData->nVariablesReal);
+    PUT_ARRAY(buffer, sData->integerVars, mData->nVariablesInteger);
+    PUT_ARRAY(buffer, sData->booleanVars, mData->nVariablesBoolean);
+    putStrings(buffer, sData->stringVars, mData->nVariablesString);
+  }
+
+  /* simulationInfo */
+  PUT(buffer, sInfo->timeValueOld);
+  PUT(buffer, sInfo->tStart);
+  PUT(buffer, sInfo->lambda);
+  PUT(buffer, sInfo->initial);
+  PUT(buffer, sInfo->terminal);
+  PUT(buffer, sInfo->sampleActivated);
+  PUT(buffer, sInfo->nextSampleEvent);
+  PUT_ARRAY(buffer, sInfo->realVarsOld, mData->nVariablesReal);
+  PUT_ARRAY(buffer, sInfo->integerVarsOld, mData->nVariablesInteger);
+  PUT_ARRAY(buffer, sInfo->booleanVarsOld, mData->nVariablesBoolean);
+  putStrings(buffer, sInfo->stringVarsOld, mData->nVariablesString);
+  PUT_ARRAY(buffer, sInfo->realVarsPre, mData->nVariablesReal);
+  PUT_ARRAY(buffer, sInfo->integerVarsPre, mData->nVariablesInteger);
+  PUT_ARRAY(buffer, sInfo->booleanVarsPre, mData->nVariablesBoolean);
+  putStrings(buffer, sInfo->stringVarsPre, mData->nVariablesString);
+
+  /* parameters, together with the start values they were computed from */
+  PUT_ARRAY(buffer, sInfo->realParameter, mData->nParametersReal);
+  PUT_ARRAY(buffer, sInfo->integerParameter, mData->nParametersInteger);
+  PUT_ARRAY(buffer, sInfo->booleanParameter, mData->nParametersBoolean);
+  putStrings(buffer, sInfo->stringParameter, mData->nParametersString);
+  for (i = 0; i < mData->nParametersReal; i++) {
+    PUT(buffer, mData->realParameterData[i].attribute.start);
+  }
+  for (i = 0; i < mData->nParametersInteger; i++) {
+    PUT(buffer, mData->integerParameterData[i].attribute.start);
+  }
+  for (i = 0; i < mData->nParametersBoolean; i++) {
+    PUT(buffer, mData->booleanParameterData[i].attribute.start);
+  }
+  for (i = 0; i < mData->nParametersString; i++) {
+    putString(buffer, mData->stringParameterData[i].attribute.start);
+  }
+
+  PUT_ARRAY(buffer, sInfo->zeroCrossings, mData->nZeroCrossings);
+  PUT_ARRAY(buffer, sInfo->zeroCrossingsPre, mData->nZeroCrossings);
+  PUT_ARRAY(buffer, sInfo->zeroCrossingsBackup, mData->nZeroCrossings);
+  PUT_ARRAY(buffer, sInfo->relations, mData->nRelations);
+  PUT_ARRAY(buffer, sInfo->relationsPre, mData->nRelations);
+  PUT_ARRAY(buffer, sInfo->storedRelations, mData->nRelations);
+  PUT_ARRAY(buffer, sInfo->mathEventsValuePre, mData->nMathEvents);
+  PUT_ARRAY(buffer, sInfo->nextSampleTimes, mData->nSamples);
+  PUT_ARRAY(buffer, sInfo->samples, mData->nSamples);
+  PUT_ARRAY(buffer, sInfo->clocksData, mData->nClocks);
+  PUT_ARRAY(buffer, sInfo->inputVars, mData->nInputVars);
+  PUT_ARRAY(buffer, sInfo->outputVars, mData->nOutputVars);
+
+  PUT(buffer, sInfo->chatteringInfo.numEventLimit);
+  PUT_ARRAY(buffer, sInfo->chatteringInfo.lastSteps, sInfo->chatteringInfo.numEventLimit);
+  PUT_ARRAY(buffer, sInfo->chatteringInfo.lastTimes, sInfo->chatteringInfo.numEventLimit);
+  PUT(buffer, sInfo->chatteringInfo.currentIndex);
+  PUT(buffer, sInfo->chatteringInfo.lastStepsNumStateEvents);
+  PUT(buffer, sInfo->chatteringInfo.messageEmitted);
+  PUT(buffer, sInfo->callStatistics);
+
+  /* timers of the synchronous features */
+  len = sInfo->intvlTimers ? listLen(sInfo->intvlTimers) : 0;
+  PUT(buffer, len);
+  for (node = len ? listFirstNode(sInfo->intvlTimers) : NULL; node; node = listNextNode(node)) {
+    PUT_ARRAY(buffer, (SYNC_TIMER*) listNodeData(node), 1);
+  }
+
+  /* delay buffers */
+  for (i = 0; i < mData->nDelayExpressions; i++) {
+    RINGBUFFER *delayStruct = sInfo->delayStructure[i];
+    len = ringBufferLength(delayStruct);
+    PUT(buffer, len);
+    for (j = 0; j < (long) len; j++) {
+      PUT_ARRAY(buffer, (TIME_AND_VALUE*) getRingData(delayStruct, j), 1);
+    }
+  }
+
+  /* nonlinear systems: iteration variables and extrapolation history */
+  for (i = 0; i < mData->nNonLinearSystems; i++) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    VALUES_LIST *valueList = (VALUES_LIST*) nonlinsys->oldValueList;
+    PUT(buffer, nonlinsys->size);
+    PUT_ARRAY(buffer, nonlinsys->nlsx, nonlinsys->size);
+    PUT_ARRAY(buffer, nonlinsys->nlsxOld, nonlinsys->size);
+    PUT_ARRAY(buffer, nonlinsys->nlsxExtrapolation, nonlinsys->size);
+    len = listLen(valueList->valueList);
+    PUT(buffer, len);
+    for (node = len ? listFirstNode(valueList->valueList) : NULL; node; node = listNextNode(node)) {
+      VALUE *elem = (VALUE*) listNodeData(node);
+      PUT(buffer, elem->time);
+      PUT(buffer, elem->size);
+      PUT_ARRAY(buffer, elem->values, elem->size);
+    }
+  }
+
+  /* dynamic state selection */
+  for (i = 0; i < mData->nStateSets; i++) {
+    STATE_SET_DATA *set = &sInfo->stateSetData[i];
+    PUT_ARRAY(buffer, set->rowPivot, set->nDummyStates);
+    PUT_ARRAY(buffer, set->colPivot, set->nCandidates);
+  }
+
+  if (solverInfo) {
+    putSolverInfo(buffer, data, solverInfo);
+  }
+
+  if (!buffer->error) {
+    header.checksum = checksum(buffer->data + start + sizeof(header), buffer->size - start - sizeof(header));
+    memcpy(buffer->data + start + offsetof(CHECKPOINT_HEADER, checksum), &header.checksum, sizeof(header.checksum));
+  }
+
+  TRACE_POP
+  return buffer->error;
+}
+
+/***************************************    DESERIALIZE     *********************************/
+
+static int getDasslData(CHECKPOINT_BUFFER *buffer, DATA *data, DASSL_DATA *dasslData)
+{
+  int liw, lrw;
+
+  GET(buffer, liw);
+  GET(buffer, lrw);
+  if (buffer->error || liw != dasslData->liw || lrw != dasslData->lrw ||
+      buffer->size - buffer->pos != sizeof(dasslData->idid) + sizeof(dasslData->dasslStepsOutputCounter) +
+                                    infoLength * sizeof(*dasslData->info) + liw * sizeof(*dasslData->iwork) +
+                                    lrw * sizeof(*dasslData->rwork) + data->modelData->nZeroCrossings * sizeof(*dasslData->jroot) +
+                                    data->modelData->nStates * sizeof(*dasslData->stateDer)) {
+    return 1;
+  }
+  GET(buffer, dasslData->idid);
+  GET(buffer, dasslData->dasslStepsOutputCounter);
+  GET_ARRAY(buffer, dasslData->info, infoLength);
+  GET_ARRAY(buffer, dasslData->iwork, dasslData->liw);
+  GET_ARRAY(buffer, dasslData->rwork, dasslData->lrw);
+  GET_ARRAY(buffer, dasslData->jroot, data->modelData->nZeroCrossings);
+  GET_ARRAY(buffer, dasslData->stateDer, data->modelData->nStates);
+  return buffer->error;
+}
+
+static void getSolverInfo(CHECKPOINT_BUFFER *buffer, DATA *data, SOLVER_INFO *solverInfo, int solverMethod)
+{
+  CHECKPOINT_BUFFER solverData = {0};
+  uint64_t size, nEvents, k;
+  long idx;
+  int restored = 0;
+
+  GET(buffer, solverInfo->currentTime);
+  GET(buffer, solverInfo->currentStepSize);
+  GET(buffer, solverInfo->laststep);
+  GET(buffer, solverInfo->lastdesiredStep);
+  GET(buffer, solverInfo->didEventStep);
+  GET(buffer, solverInfo->stateEvents);
+  GET(buffer, solverInfo->sampleEvents);
+  GET_ARRAY(buffer, solverInfo->solverStats, numStatistics);
+  GET_ARRAY(buffer, solverInfo->solverStatsTmp, numStatistics);
+  GET(buffer, solverInfo->integratorSteps);
+  GET(buffer, solverInfo->stepNo);
+  GET(buffer, solverInfo->syncStep);
+  GET(buffer, nEvents);
+  listClear(solverInfo->eventLst);
+  for (k = 0; k < nEvents && !buffer->error; k++) {
+    GET(buffer, idx);
+    listPushBack(solverInfo->eventLst, &idx);
+  }
+
+  GET(buffer, size);
+  if (buffer->error || buffer->pos + size > buffer->size) {
+    buffer->error = 1;
+    return;
+  }
+  solverData.data = buffer->data + buffer->pos;
+  solverData.size = (size_t) size;
+  buffer->pos += (size_t) size;
+
+  if (solverMethod == solverInfo->solverMethod) {
+    switch (solverInfo->solverMethod)
+    {
+    case S_DASSL:
+      restored = 0 == getDasslData(&solverData, data, (DASSL_DATA*) solverInfo->solverData);
+      break;
+#ifdef WITH_SUNDIALS
+    case S_IDA:
+      /* the IDA memory is opaque, restart it like after an event */
+      ((IDA_SOLVER*) solverInfo->solverData)->setInitialSolution = 0;
+      restored = 1;
+      break;
+#endif
+    default:
+      /* single step methods keep no state besides the ring buffer */
+      restored = 0 == size;
+    }
+  }
+  if (!restored) {
+    warningStreamPrint(LOG_SOLVER, 0, "checkpoint: the integrator state could not be restored, the integrator is restarted at time %g", solverInfo->currentTime);
+    solverInfo->didEventStep = 1;
+  }
+}
+
+static int checkHeader(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer, CHECKPOINT_HEADER *header)
+{
+  int64_t count[CHECKPOINT_NUM_COUNTS];
+  int i;
+
+  GET(buffer, *header);
+  if (buffer->error || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic))) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: not a checkpoint image");
+    return 1;
+  }
+  if (CHECKPOINT_VERSION != header->version || CHECKPOINT_BYTE_ORDER != header->byteOrder ||
+      sizeof(modelica_integer) != header->sizeofInteger || sizeof(modelica_boolean) != header->sizeofBoolean) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image was written by an incompatible runtime (version %u)", (unsigned int) header->version);
+    return 1;
+  }
+  if (header->checksum != checksum(buffer->data + buffer->pos, buffer->size - buffer->pos)) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image is corrupt (checksum mismatch)");
+    return 1;
+  }
+  if (buffer->pos + header->guidLength > buffer->size ||
+      header->guidLength != strlen(data->modelData->modelGUID) ||
+      memcmp(buffer->data + buffer->pos, data->modelData->modelGUID, header->guidLength)) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image was written by a different model");
+    return 1;
+  }
+  buffer->pos += header->guidLength;
+
+  modelCounts(data, count);
+  for (i = 0; i < CHECKPOINT_NUM_COUNTS; i++) {
+    if (count[i] != header->count[i]) {
+      errorStreamPrint(LOG_STDOUT, 0, "checkpoint: number of %s differs (image: %ld, model: %ld)", COUNT_NAME[i], (long) header->count[i], (long) count[i]);
+      return 1;
+    }
+  }
+  if (solverInfo && header->solverMethod < 0) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image holds no integrator state");
+    return 1;
+  }
+  return 0;
+}
+
+/* restores the parameters; returns 1 if a start value was changed since the
+ * image was written, those parameters keep the value of this run */
+static int getParameters(CHECKPOINT_BUFFER *buffer, DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  modelica_real *realParameter = (modelica_real*) malloc(mData->nParametersReal * sizeof(modelica_real));
+  modelica_integer *integerParameter = (modelica_integer*) malloc(mData->nParametersInteger * sizeof(modelica_integer));
+  modelica_boolean *booleanParameter = (modelica_boolean*) malloc(mData->nParametersBoolean * sizeof(modelica_boolean));
+  modelica_string *stringParameter = (modelica_string*) malloc(mData->nParametersString * sizeof(modelica_string));
+  int changed = 0;
+  long i;
+
+  GET_ARRAY(buffer, realParameter, mData->nParametersReal);
+  GET_ARRAY(buffer, integerParameter, mData->nParametersInteger);
+  GET_ARRAY(buffer, booleanParameter, mData->nParametersBoolean);
+  getStrings(buffer, stringParameter, mData->nParametersString);
+
+  for (i = 0; i < mData->nParametersReal; i++) {
+    modelica_real start;
+    GET(buffer, start);
+    if (start == mData->realParameterData[i].attribute.start) {
+      sInfo->realParameter[i] = realParameter[i];
+    } else {
+      infoStreamPrint(LOG_SOLVER, 0, "checkpoint: parameter %s changed to %g", mData->realParameterData[i].info.name, sInfo->realParameter[i]);
+      changed = 1;
+    }
+  }
+  for (i = 0; i < mData->nParametersInteger; i++) {
+    modelica_integer start;
+    GET(buffer, start);
+    if (start == mData->integerParameterData[i].attribute.start) {
+      sInfo->integerParameter[i] = integerParameter[i];
+    } else {
+      infoStreamPrint(LOG_SOLVER, 0, "checkpoint: parameter %s changed to %ld", mData->integerParameterData[i].info.name, (long) sInfo->integerParameter[i]);
+      changed = 1;
+    }
+  }
+  for (i = 0; i < mData->nParametersBoolean; i++) {
+    modelica_boolean start;
+    GET(buffer, start);
+    if (start == mData->booleanParameterData[i].attribute.start) {
+      sInfo->booleanParameter[i] = booleanParameter[i];
+    } else {
+      infoStreamPrint(LOG_SOLVER, 0, "checkpoint: parameter %s changed to %s", mData->booleanParameterData[i].info.name, sInfo->booleanParameter[i] ? "true" : "false");
+      changed = 1;
+    }
+  }
+  for (i = 0; i < mData->nParametersString; i++) {
+    modelica_string start = getString(buffer);
+    modelica_string current = mData->stringParameterData[i].attribute.start;
+    if (start && current && !strcmp(MMC_STRINGDATA(start), MMC_STRINGDATA(current))) {
+      sInfo->stringParameter[i] = stringParameter[i];
+    } else {
+      infoStreamPrint(LOG_SOLVER, 0, "checkpoint: parameter %s changed", mData->stringParameterData[i].info.name);
+      changed = 1;
+    }
+  }
+
+  free(realParameter);
+  free(integerParameter);
+  free(booleanParameter);
+  free(stringParameter);
+  return changed && !buffer->error;
+}
+
+/* walks over the image like checkpointDeserialize, checking the sizes of
+ * all sections against the model but writing nothing */
+int checkpointValidate(DATA *data, SOLVER_INFO *solverInfo, const char *image, size_t size)
+{
+  TRACE_PUSH
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  CHECKPOINT_BUFFER buffer = {0};
+  CHECKPOINT_HEADER header;
+  uint64_t len, k;
+  long i;
+  int numEventLimit;
+
+  buffer.data = (char*) image;
+  buffer.size = size;
+
+  if (checkHeader(data, solverInfo, &buffer, &header)) {
+    TRACE_POP
+    return 1;
+  }
+
+  for (i = 0; i < SIZERINGBUFFER; i++) {
+    SIMULATION_DATA *sData = data->localData[i];
+    SKIP(&buffer, sData->timeValue);
+    SKIP_ARRAY(&buffer, sData->realVars, mData->nVariablesReal);
+    SKIP_ARRAY(&buffer, sData->integerVars, mData->nVariablesInteger);
+    SKIP_ARRAY(&buffer, sData->booleanVars, mData->nVariablesBoolean);
+    skipStrings(&buffer, mData->nVariablesString);
+  }
+
+  SKIP(&buffer, sInfo->timeValueOld);
+  SKIP(&buffer, sInfo->tStart);
+  SKIP(&buffer, sInfo->lambda);
+  SKIP(&buffer, sInfo->initial);
+  SKIP(&buffer, sInfo->terminal);
+  SKIP(&buffer, sInfo->sampleActivated);
+  SKIP(&buffer, sInfo->nextSampleEvent);
+  for (i = 0; i < 2; i++) {
+    /* old and pre values */
+    SKIP_ARRAY(&buffer, sInfo->realVarsOld, mData->nVariablesReal);
+    SKIP_ARRAY(&buffer, sInfo->integerVarsOld, mData->nVariablesInteger);
+    SKIP_ARRAY(&buffer, sInfo->booleanVarsOld, mData->nVariablesBoolean);
+    skipStrings(&buffer, mData->nVariablesString);
+  }
+  for (i = 0; i < 2; i++) {
+    /* parameters and their start values */
+    SKIP_ARRAY(&buffer, sInfo->realParameter, mData->nParametersReal);
+    SKIP_ARRAY(&buffer, sInfo->integerParameter, mData->nParametersInteger);
+    SKIP_ARRAY(&buffer, sInfo->booleanParameter, mData->nParametersBoolean);
+    skipStrings(&buffer, mData->nParametersString);
+  }
+
+  SKIP_ARRAY(&buffer, sInfo->zeroCrossings, mData->nZeroCrossings);
+  SKIP_ARRAY(&buffer, sInfo->zeroCrossingsPre, mData->nZeroCrossings);
+  SKIP_ARRAY(&buffer, sInfo->zeroCrossingsBackup, mData->nZeroCrossings);
+  SKIP_ARRAY(&buffer, sInfo->relations, mData->nRelations);
+  SKIP_ARRAY(&buffer, sInfo->relationsPre, mData->nRelations);
+  SKIP_ARRAY(&buffer, sInfo->storedRelations, mData->nRelations);
+  SKIP_ARRAY(&buffer, sInfo->mathEventsValuePre, mData->nMathEvents);
+  SKIP_ARRAY(&buffer, sInfo->nextSampleTimes, mData->nSamples);
+  SKIP_ARRAY(&buffer, sInfo->samples, mData->nSamples);
+  SKIP_ARRAY(&buffer, sInfo->clocksData, mData->nClocks);
+  SKIP_ARRAY(&buffer, sInfo->inputVars, mData->nInputVars);
+  SKIP_ARRAY(&buffer, sInfo->outputVars, mData->nOutputVars);
+
+  GET(&buffer, numEventLimit);
+  if (numEventLimit != sInfo->chatteringInfo.numEventLimit) {
+    buffer.error = 1;
+  }
+  SKIP_ARRAY(&buffer, sInfo->chatteringInfo.lastSteps, sInfo->chatteringInfo.numEventLimit);
+  SKIP_ARRAY(&buffer, sInfo->chatteringInfo.lastTimes, sInfo->chatteringInfo.numEventLimit);
+  SKIP(&buffer, sInfo->chatteringInfo.currentIndex);
+  SKIP(&buffer, sInfo->chatteringInfo.lastStepsNumStateEvents);
+  SKIP(&buffer, sInfo->chatteringInfo.messageEmitted);
+  SKIP(&buffer, sInfo->callStatistics);
+
+  GET(&buffer, len);
+  if (len && !sInfo->intvlTimers) {
+    buffer.error = 1;
+  }
+  skipBytes(&buffer, len, sizeof(SYNC_TIMER));
+
+  for (i = 0; i < mData->nDelayExpressions; i++) {
+    GET(&buffer, len);
+    skipBytes(&buffer, len, sizeof(TIME_AND_VALUE));
+  }
+
+  for (i = 0; i < mData->nNonLinearSystems && !buffer.error; i++) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    modelica_integer nlsSize;
+    GET(&buffer, nlsSize);
+    if (nlsSize != nonlinsys->size) {
+      buffer.error = 1;
+      break;
+    }
+    SKIP_ARRAY(&buffer, nonlinsys->nlsx, 3 * nonlinsys->size);
+    GET(&buffer, len);
+    for (k = 0; k < len && !buffer.error; k++) {
+      VALUE elem;
+      SKIP(&buffer, elem.time);
+      GET(&buffer, elem.size);
+      if (elem.size != nonlinsys->size) {
+        buffer.error = 1;
+      }
+      SKIP_ARRAY(&buffer, elem.values, elem.size);
+    }
+  }
+
+  for (i = 0; i < mData->nStateSets; i++) {
+    STATE_SET_DATA *set = &sInfo->stateSetData[i];
+    SKIP_ARRAY(&buffer, set->rowPivot, set->nDummyStates);
+    SKIP_ARRAY(&buffer, set->colPivot, set->nCandidates);
+  }
+
+  /* the integrator part, also if it is not restored */
+  if (header.solverMethod >= 0) {
+    SKIP(&buffer, solverInfo->currentTime);
+    SKIP(&buffer, solverInfo->currentStepSize);
+    SKIP(&buffer, solverInfo->laststep);
+    SKIP(&buffer, solverInfo->lastdesiredStep);
+    SKIP(&buffer, solverInfo->didEventStep);
+    SKIP(&buffer, solverInfo->stateEvents);
+    SKIP(&buffer, solverInfo->sampleEvents);
+    SKIP_ARRAY(&buffer, solverInfo->solverStats, 2 * numStatistics);
+    SKIP(&buffer, solverInfo->integratorSteps);
+    SKIP(&buffer, solverInfo->stepNo);
+    SKIP(&buffer, solverInfo->syncStep);
+    GET(&buffer, len);
+    skipBytes(&buffer, len, sizeof(long));
+    GET(&buffer, len);
+    skipBytes(&buffer, len, 1);
+  }
+
+  if (buffer.error || buffer.pos != buffer.size) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image is truncated or inconsistent");
+    TRACE_POP
+    return 1;
+  }
+
+  TRACE_POP
+  return 0;
+}
+
+int checkpointDeserialize(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *image, size_t size)
+{
+  TRACE_PUSH
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  CHECKPOINT_BUFFER buffer = {0};
+  CHECKPOINT_HEADER header;
+  SYNC_TIMER timer;
+  TIME_AND_VALUE delayValue;
+  uint64_t len, k;
+  long i;
+  int numEventLimit, parametersChanged;
+
+  /* nothing is copied from an image that does not fit the model completely */
+  if (checkpointValidate(data, solverInfo, image, size)) {
+    TRACE_POP
+    return 1;
+  }
+
+  buffer.data = (char*) image;
+  buffer.size = size;
+  GET(&buffer, header);
+  buffer.pos += header.guidLength;
+
+  for (i = 0; i < SIZERINGBUFFER; i++) {
+    SIMULATION_DATA *sData = data->localData[i];
+    GET(&buffer, sData->timeValue);
+    GET_ARRAY(&buffer, sData->realVars, mData->nVariablesReal);
+    GET_ARRAY(&buffer, sData->integerVars, mData->nVariablesInteger);
+    GET_ARRAY(&buffer, sData->booleanVars, mData->nVariablesBoolean);
+    getStrings(&buffer, sData->stringVars, mData->nVariablesString);
+  }
+
+  GET(&buffer, sInfo->timeValueOld);
+  GET(&buffer, sInfo->tStart);
+  GET(&buffer, sInfo->lambda);
+  GET(&buffer, sInfo->initial);
+  GET(&buffer, sInfo->terminal);
+  GET(&buffer, sInfo->sampleActivated);
+  GET(&buffer, sInfo->nextSampleEvent);
+  GET_ARRAY(&buffer, sInfo->realVarsOld, mData->nVariablesReal);
+  GET_ARRAY(&buffer, sInfo->integerVarsOld, mData->nVariablesInteger);
+  GET_ARRAY(&buffer, sInfo->booleanVarsOld, mData->nVariablesBoolean);
+  getStrings(&buffer, sInfo->stringVarsOld, mData->nVariablesString);
+  GET_ARRAY(&buffer, sInfo->realVarsPre, mData->nVariablesReal);
+  GET_ARRAY(&buffer, sInfo->integerVarsPre, mData->nVariablesInteger);
+  GET_ARRAY(&buffer, sInfo->booleanVarsPre, mData->nVariablesBoolean);
+  getStrings(&buffer, sInfo->stringVarsPre, mData->nVariablesString);
+  parametersChanged = getParameters(&buffer, data);
+
+  GET_ARRAY(&buffer, sInfo->zeroCrossings, mData->nZeroCrossings);
+  GET_ARRAY(&buffer, sInfo->zeroCrossingsPre, mData->nZeroCrossings);
+  GET_ARRAY(&buffer, sInfo->zeroCrossingsBackup, mData->nZeroCrossings);
+  GET_ARRAY(&buffer, sInfo->relations, mData->nRelations);
+  GET_ARRAY(&buffer, sInfo->relationsPre, mData->nRelations);
+  GET_ARRAY(&buffer, sInfo->storedRelations, mData->nRelations);
+  GET_ARRAY(&buffer, sInfo->mathEventsValuePre, mData->nMathEvents);
+  GET_ARRAY(&buffer, sInfo->nextSampleTimes, mData->nSamples);
+  GET_ARRAY(&buffer, sInfo->samples, mData->nSamples);
+  GET_ARRAY(&buffer, sInfo->clocksData, mData->nClocks);
+  GET_ARRAY(&buffer, sInfo->inputVars, mData->nInputVars);
+  GET_ARRAY(&buffer, sInfo->outputVars, mData->nOutputVars);
+
+  GET(&buffer, numEventLimit);
+  if (numEventLimit != sInfo->chatteringInfo.numEventLimit) {
+    buffer.error = 1;
+  }
+  GET_ARRAY(&buffer, sInfo->chatteringInfo.lastSteps, sInfo->chatteringInfo.numEventLimit);
+  GET_ARRAY(&buffer, sInfo->chatteringInfo.lastTimes, sInfo->chatteringInfo.numEventLimit);
+  GET(&buffer, sInfo->chatteringInfo.currentIndex);
+  GET(&buffer, sInfo->chatteringInfo.lastStepsNumStateEvents);
+  GET(&buffer, sInfo->chatteringInfo.messageEmitted);
+  GET(&buffer, sInfo->callStatistics);
+
+  GET(&buffer, len);
+  if (sInfo->intvlTimers) {
+    listClear(sInfo->intvlTimers);
+  } else if (len) {
+    buffer.error = 1;
+  }
+  for (k = 0; k < len && !buffer.error; k++) {
+    GET(&buffer, timer);
+    listPushBack(sInfo->intvlTimers, &timer);
+  }
+
+  for (i = 0; i < mData->nDelayExpressions; i++) {
+    GET(&buffer, len);
+    if (buffer.error) {
+      break;
+    }
+    freeRingBuffer(sInfo->delayStructure[i]);
+    sInfo->delayStructure[i] = allocRingBuffer(1024, sizeof(TIME_AND_VALUE));
+    for (k = 0; k < len && !buffer.error; k++) {
+      GET(&buffer, delayValue);
+      appendRingData(sInfo->delayStructure[i], &delayValue);
+    }
+  }
+
+  for (i = 0; i < mData->nNonLinearSystems && !buffer.error; i++) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    VALUES_LIST *valueList = (VALUES_LIST*) nonlinsys->oldValueList;
+    modelica_integer nlsSize;
+    GET(&buffer, nlsSize);
+    if (nlsSize != nonlinsys->size) {
+      buffer.error = 1;
+      break;
+    }
+    GET_ARRAY(&buffer, nonlinsys->nlsx, nonlinsys->size);
+    GET_ARRAY(&buffer, nonlinsys->nlsxOld, nonlinsys->size);
+    GET_ARRAY(&buffer, nonlinsys->nlsxExtrapolation, nonlinsys->size);
+    GET(&buffer, len);
+    cleanValueList(valueList, NULL);
+    for (k = 0; k < len && !buffer.error; k++) {
+      VALUE elem;
+      GET(&buffer, elem.time);
+      GET(&buffer, elem.size);
+      if (buffer.error || elem.size != nonlinsys->size) {
+        buffer.error = 1;
+        break;
+      }
+      elem.values = (double*) malloc(elem.size * sizeof(double));
+      GET_ARRAY(&buffer, elem.values, elem.size);
+      listPushBack(valueList->valueList, &elem);
+    }
+  }
+
+  for (i = 0; i < mData->nStateSets; i++) {
+    STATE_SET_DATA *set = &sInfo->stateSetData[i];
+    GET_ARRAY(&buffer, set->rowPivot, set->nDummyStates);
+    GET_ARRAY(&buffer, set->colPivot, set->nCandidates);
+  }
+
+  if (solverInfo && !buffer.error) {
+    getSolverInfo(&buffer, data, solverInfo, header.solverMethod);
+  }
+
+  if (buffer.error) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: the image is truncated or inconsistent");
+    TRACE_POP
+    return 1;
+  }
+
+  if (parametersChanged) {
+    /* what-if continuation: recompute the dependent parameters and the
+     * discrete system, then restart the integrator like after an event */
+    data->callback->updateBoundParameters(data, threadData);
+    updateDiscreteSystem(data, threadData);
+    overwriteOldSimulationData(data);
+    storeOldValues(data);
+    if (solverInfo) {
+      solverInfo->didEventStep = 1;
+    }
+  }
+
+  TRACE_POP
+  return 0;
+}
+
+/***************************************    FILES     *********************************/
+
+int checkpointWrite(DATA *data, SOLVER_INFO *solverInfo, const char *filename)
+{
+  TRACE_PUSH
+  CHECKPOINT_BUFFER buffer = {0};
+  char *tmpFilename;
+  FILE *file;
+  int ok;
+
+  ok = 0 == checkpointSerialize(data, solverInfo, &buffer);
+
+  /* write to a temporary file first, a crash must not destroy the previous checkpoint */
+  tmpFilename = (char*) malloc(strlen(filename) + 32);
+  sprintf(tmpFilename, "%s.%ld.tmp", filename, (long) getpid());
+  file = ok ? fopen(tmpFilename, "wb") : NULL;
+  if (NULL == file) {
+    ok = 0;
+  } else {
+    ok = buffer.size == fwrite(buffer.data, 1, buffer.size, file);
+    ok = (0 == fclose(file)) && ok;
+    if (ok) {
+#if defined(_WIN32)
+      remove(filename);
+#endif
+      ok = 0 == rename(tmpFilename, filename);
+    }
+    if (!ok) {
+      remove(tmpFilename);
+    }
+  }
+
+  if (ok) {
+    infoStreamPrint(LOG_SIMULATION, 0, "wrote checkpoint %s at time %g (%ld bytes)", filename, data->localData[0]->timeValue, (long) buffer.size);
+  } else {
+    warningStreamPrint(LOG_STDOUT, 0, "checkpoint: could not write %s: %s", filename, buffer.error ? "out of memory" : strerror(errno));
+  }
+  free(buffer.data);
+  free(tmpFilename);
+
+  TRACE_POP
+  return !ok;
+}
+
+int checkpointRead(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *filename)
+{
+  TRACE_PUSH
+  FILE *file = fopen(filename, "rb");
+  char *image = NULL;
+  long size = -1;
+  int ret;
+
+  if (file && 0 == fseek(file, 0, SEEK_END)) {
+    size = ftell(file);
+  }
+  if (size >= 0 && 0 == fseek(file, 0, SEEK_SET)) {
+    image = (char*) malloc(size ? size : 1);
+    if (image && (size_t) size != fread(image, 1, size, file)) {
+      size = -1;
+    }
+  }
+  if (file) {
+    fclose(file);
+  }
+  if (NULL == image || size < 0) {
+    errorStreamPrint(LOG_STDOUT, 0, "checkpoint: could not read %s: %s", filename, strerror(errno));
+    free(image);
+    TRACE_POP
+    return 1;
+  }
+
+  ret = checkpointDeserialize(data, threadData, solverInfo, image, (size_t) size);
+  free(image);
+
+  if (0 == ret) {
+    solverInfo->restarted = 1;
+    checkpointInit(data, solverInfo);
+    infoStreamPrint(LOG_STDOUT, 0, "restarted from checkpoint %s at time %g", filename, solverInfo->currentTime);
+  }
+
+  TRACE_POP
+  return ret;
+}
+
+/***************************************    SCHEDULE     *********************************/
+
+static const char* checkpointFilename(DATA *data)
+{
+  static OMC_THREAD_LOCAL char filename[1024];
+
+  if (omc_flag[FLAG_CHECKPOINT]) {
+    return omc_flagValue[FLAG_CHECKPOINT];
+  }
+  snprintf(filename, sizeof(filename), "%s.chk", data->modelData->modelFilePrefix);
+  return filename;
+}
+
+void checkpointInit(DATA *data, SOLVER_INFO *solverInfo)
+{
+  double start = data->simulationInfo->startTime;
+  double time = solverInfo->currentTime;
+  double next = DBL_MAX;
+
+  if (omc_flag[FLAG_CHECKPOINT_INTERVAL]) {
+    double interval = atof(omc_flagValue[FLAG_CHECKPOINT_INTERVAL]);
+    if (interval > 0) {
+      next = start + (floor((time - start) / interval) + 1) * interval;
+    } else {
+      warningStreamPrint(LOG_STDOUT, 0, "checkpoint: ignoring -%s=%s, the interval must be positive", FLAG_NAME[FLAG_CHECKPOINT_INTERVAL], omc_flagValue[FLAG_CHECKPOINT_INTERVAL]);
+    }
+  }
+  if (omc_flag[FLAG_CHECKPOINT_TIME]) {
+    double checkpointTime = atof(omc_flagValue[FLAG_CHECKPOINT_TIME]);
+    if (checkpointTime > time) {
+      next = fmin(next, checkpointTime);
+    }
+  }
+  solverInfo->nextCheckpoint = next;
+}
+
+int checkpointStep(DATA *data, SOLVER_INFO *solverInfo)
+{
+  int ret = checkpointWrite(data, solverInfo, checkpointFilename(data));
+  checkpointInit(data, solverInfo);
+  return ret;
+}
+
+int checkpointFinish(DATA *data, SOLVER_INFO *solverInfo)
+{
+  if (omc_flag[FLAG_CHECKPOINT] && !omc_flag[FLAG_CHECKPOINT_TIME] && !omc_flag[FLAG_CHECKPOINT_INTERVAL]) {
+    return checkpointWrite(data, solverInfo, checkpointFilename(data));
+  }
+  return 0;
+}
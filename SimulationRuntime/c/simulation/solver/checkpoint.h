@@ -0,0 +1,84 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file checkpoint.h
+ *
+ *  Description: saves the complete runtime state of a simulation in a
+ *  versioned binary image and restores it again (see -checkpoint and
+ *  -restart).
+ */
+
+#ifndef OMC_CHECKPOINT_H
+#define OMC_CHECKPOINT_H
+
+#include "simulation_data.h"
+#include "simulation/solver/solver_main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CHECKPOINT_BUFFER
+{
+  char *data;
+  size_t size;                         /* number of valid bytes */
+  size_t capacity;
+  size_t pos;                          /* read position */
+  int error;                           /* set if an element did not fit or was inconsistent */
+  void *(*allocateMemory)(size_t nobj, size_t size);  /* if set, used for data instead of realloc */
+  void (*freeMemory)(void *obj);                      /* and free, e.g. the callbacks of an FMU */
+} CHECKPOINT_BUFFER;
+
+/* serializes the state of data and, if solverInfo != NULL, of the integrator;
+ * buffer->data is realloc'ed (or reallocated with buffer->allocateMemory) as
+ * needed and must be freed by the caller */
+int checkpointSerialize(DATA *data, SOLVER_INFO *solverInfo, CHECKPOINT_BUFFER *buffer);
+/* checks that an image fits the model, is complete and has the right
+ * checksum, without changing data */
+int checkpointValidate(DATA *data, SOLVER_INFO *solverInfo, const char *image, size_t size);
+/* restores a state written by checkpointSerialize into an initialized model,
+ * after checking the whole image with checkpointValidate */
+int checkpointDeserialize(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *image, size_t size);
+
+int checkpointWrite(DATA *data, SOLVER_INFO *solverInfo, const char *filename);
+int checkpointRead(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, const char *filename);
+
+/* sets solverInfo->nextCheckpoint from -checkpointTime and -checkpointInterval */
+void checkpointInit(DATA *data, SOLVER_INFO *solverInfo);
+/* writes the checkpoint due at solverInfo->nextCheckpoint */
+int checkpointStep(DATA *data, SOLVER_INFO *solverInfo);
+/* writes the checkpoint at the end of the simulation if only -checkpoint is given */
+int checkpointFinish(DATA *data, SOLVER_INFO *solverInfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
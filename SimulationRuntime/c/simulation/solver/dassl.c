@@ -58,7 +58,7 @@ extern "C" {
  *  - it's set to 1 if the continuous system is evaluated
  *    when dassl finished a step, otherwise it's 0.
  */
-int RHSFinalFlag;
+static OMC_THREAD_LOCAL int RHSFinalFlag;
 
 /* provides a dummy Jacobian to be used with DASSL */
 static int
@@ -145,6 +145,7 @@ int dassl_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
   assertStreamPrint(threadData, 0 != dasslData->info,"out of memory");
 
   dasslData->idid = 0;
+  dasslData->dasslStepsOutputCounter = 1;
 
   dasslData->sqrteps = sqrt(DBL_EPSILON);
   dasslData->ysave = (double*) malloc(data->modelData->nStates*sizeof(double));
@@ -228,14 +229,21 @@ int dassl_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
     dasslData->dasslSteps = 1; /* TRUE */
     solverInfo->solverNoEquidistantGrid = 1;
   }
+  else if (omc_flag[FLAG_DENSE_OUTPUT])
+  {
+    /* return after every internal step, the output points are interpolated */
+    dasslData->dasslSteps = 1; /* TRUE */
+    solverInfo->solverDenseOutput = 1;
+  }
   else
   {
     dasslData->dasslSteps = 0; /* FALSE */
   }
   infoStreamPrint(LOG_SOLVER, 0, "use equidistant time grid %s", dasslData->dasslSteps?"NO":"YES");
+  infoStreamPrint(LOG_SOLVER, 0, "interpolate output points %s", solverInfo->solverDenseOutput?"YES":"NO");
 
   /* check if Flags FLAG_NOEQUIDISTANT_OUT_FREQ or FLAG_NOEQUIDISTANT_OUT_TIME are set */
-  if (dasslData->dasslSteps){
+  if (solverInfo->solverNoEquidistantGrid){
     if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ])
     {
       dasslData->dasslStepsFreq = atoi(omc_flagValue[FLAG_NOEQUIDISTANT_OUT_FREQ]);
@@ -418,6 +426,44 @@ int printCurrentStatesVector(int logLevel, double* states, DATA* data, double ti
 
 
 
+/* \fn dassl_interpolate(DASSL_DATA *dasslData, int nStates, double time, double *states, double *stateDer)
+ *
+ * \param [in]  [dasslData]
+ * \param [in]  [nStates]
+ * \param [in]  [time] time inside the last DDASKR step
+ * \param [out] [states]
+ * \param [out] [stateDer]
+ *
+ * This function evaluates the interpolation polynomial of the last DDASKR
+ * step and its derivative, the same way as DDATRP does. The work arrays are
+ * used directly: TN is RWORK(4), PSI starts at RWORK(39), KOLD is IWORK(8)
+ * and PHI starts at RWORK(61+3*NEQ) for the direct method without
+ * constraints (INFO(12) = INFO(16) = 0).
+ */
+void dassl_interpolate(DASSL_DATA *dasslData, int nStates, double time, double *states, double *stateDer)
+{
+  const double *phi = dasslData->rwork + 60 + 3*nStates;
+  const double *psi = dasslData->rwork + 38;
+  const int kold = dasslData->iwork[7];
+  const double delta = time - dasslData->rwork[3];
+  double c = 1.0, d = 0.0, gamma = delta / psi[0];
+  int i, j;
+
+  memcpy(states, phi, nStates*sizeof(double));
+  memset(stateDer, 0, nStates*sizeof(double));
+  for(j = 1; j <= kold; j++)
+  {
+    d = d * gamma + c / psi[j-1];
+    c = c * gamma;
+    gamma = (delta + psi[j-1]) / psi[j];
+    for(i = 0; i < nStates; i++)
+    {
+      states[i] += c * phi[j*nStates + i];
+      stateDer[i] += d * phi[j*nStates + i];
+    }
+  }
+}
+
 /**********************************************************************************************
  * DASSL with synchronous treating of when equation
  *   - without integrated ZeroCrossing method.
@@ -432,7 +478,6 @@ int dassl_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   unsigned int ui = 0;
   int retVal = 0;
   int saveJumpState;
-  static unsigned int dasslStepsOutputCounter = 1;
 
   DASSL_DATA *dasslData = (DASSL_DATA*) solverInfo->solverData;
 
@@ -560,17 +605,20 @@ int dassl_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
     /* emit step, if dasslsteps is selected */
     if (dasslData->dasslSteps)
     {
-      if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ]){
+      if (solverInfo->solverDenseOutput){
+        /* the output points inside the step are interpolated by the caller */
+        break;
+      } else if (omc_flag[FLAG_NOEQUIDISTANT_OUT_FREQ]){
         /* output every n-th time step */
-        if (dasslStepsOutputCounter >= dasslData->dasslStepsFreq){
-          dasslStepsOutputCounter = 1; /* next line set it to one */
+        if (dasslData->dasslStepsOutputCounter >= dasslData->dasslStepsFreq){
+          dasslData->dasslStepsOutputCounter = 1; /* next line set it to one */
           break;
         }
-        dasslStepsOutputCounter++;
+        dasslData->dasslStepsOutputCounter++;
       } else if (omc_flag[FLAG_NOEQUIDISTANT_OUT_TIME]){
         /* output when time>=k*timeValue */
-        if (solverInfo->currentTime > dasslStepsOutputCounter * dasslData->dasslStepsTime){
-          dasslStepsOutputCounter++;
+        if (solverInfo->currentTime > dasslData->dasslStepsOutputCounter * dasslData->dasslStepsTime){
+          dasslData->dasslStepsOutputCounter++;
           break;
         }
       } else {
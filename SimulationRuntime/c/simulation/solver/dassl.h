@@ -46,6 +46,7 @@ typedef struct DASSL_DATA{
   int dasslRootFinding;         /* if TRUE then the internal root finding is used */
   int dasslJacobian;            /* specifices the method to calculate the jacobian matrix */
   int dasslAvoidEventRestart;   /* if TRUE then no restart after an event is performed */
+  unsigned int dasslStepsOutputCounter; /* internal steps or output times passed in dasslSteps mode */
 
   int* info;
 
@@ -88,4 +89,8 @@ dassl_initial(DATA* simData, threadData_t *threadData, SOLVER_INFO* solverInfo,
 int
 dassl_deinitial(DASSL_DATA *dasslData);
 
+/* interpolate the states of the last dassl step */
+void
+dassl_interpolate(DASSL_DATA *dasslData, int nStates, double time, double *states, double *stateDer);
+
 #endif
@@ -33,6 +33,7 @@
 
 #include "simulation/solver/delay.h"
 #include "util/omc_error.h"
+#include "util/omc_trace.h"
 #include "simulation_data.h"
 #include "util/ringbuffer.h"
 #include "openmodelica.h"
@@ -75,6 +76,7 @@ static int findTime(double time, RINGBUFFER *delayStruct)
       start = i;
   }while(t != time && end > start + 1);
   infoStreamPrint(LOG_EVENTS, 0, "return time[%d, %d] = %e", start, end, t);
+  OMC_TRACE(LOG_EVENTS, OMC_TRACE_DELAY_FIND_TIME, 3, time, start, ringBufferLength(delayStruct), 0);
   return (start);
 }
 
@@ -30,6 +30,7 @@
 
 #include "simulation/solver/events.h"
 #include "util/omc_error.h"
+#include "util/omc_trace.h"
 #include "simulation/options.h"
 #include "simulation_data.h"
 #include "simulation/results/simulation_result.h"
@@ -300,7 +301,7 @@ double findRoot(DATA* data, threadData_t *threadData, LIST *eventList)
   long event_id;
   LIST_NODE* it;
   fortran_integer i=0;
-  static LIST *tmpEventList = NULL;
+  LIST *tmpEventList = NULL;
 
   double *states_right = (double*) malloc(data->modelData->nStates * sizeof(double));
   double *states_left = (double*) malloc(data->modelData->nStates * sizeof(double));
@@ -391,6 +392,7 @@ double findRoot(DATA* data, threadData_t *threadData, LIST *eventList)
 
   free(states_left);
   free(states_right);
+  freeList(tmpEventList);
 
   TRACE_POP
   return eventTime;
@@ -493,6 +495,8 @@ int checkZeroCrossings(DATA *data, LIST *tmpEventList, LIST *eventList)
             *((long*) listNodeData(it)),
             (data->simulationInfo->zeroCrossingsPre[*((long*) listNodeData(it))] > 0) ? "TRUE" : "FALSE",
             (data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))] > 0) ? "TRUE" : "FALSE");
+      OMC_TRACE(LOG_ZEROCROSSINGS, OMC_TRACE_ZEROCROSSING_CHANGED, 4, data->localData[0]->timeValue, *((long*) listNodeData(it)),
+            data->simulationInfo->zeroCrossingsPre[*((long*) listNodeData(it))], data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))]);
       listPushFront(tmpEventList, listNodeData(it));
     }
   }
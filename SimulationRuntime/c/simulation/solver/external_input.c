@@ -28,244 +28,633 @@
  *
  */
 
+/*! \file external_input.c
+ *
+ * Inputs from -csvInput or -exInputFile are streamed from the file instead of
+ * being read completely before the simulation starts. Only two windows are
+ * held in memory: the one the simulation is currently in and the next one,
+ * into which a background thread reads the following -inputWindow rows while
+ * the solver works on the current one. A solver steps back at most to the
+ * time of the last accepted step (event iteration, retries, interpolation),
+ * so when the simulation moves on, the rows of the current window from that
+ * time on are put in front of the new rows. A window grows if a step spans
+ * more rows than that.
+ */
+
 #include <string.h>
 #include <setjmp.h>
+#include <pthread.h>
 
 #include "openmodelica.h"
 #include "openmodelica_func.h"
 #include "simulation_data.h"
 
 #include "util/omc_error.h"
-#include "util/memory_pool.h"
-#include "util/read_csv.h"
 #include "util/libcsv.h"
-#include "util/read_matlab4.h"
 
 #include "simulation/simulation_runtime.h"
 #include "simulation/solver/solver_main.h"
 #include "simulation/solver/model_help.h"
 #include "simulation/options.h"
 
-static inline void externalInputallocate1(DATA* data, FILE * pFile);
-static inline void externalInputallocate2(DATA* data, char *filename);
+#define EXTERNAL_INPUT_DEFAULT_WINDOW 16384
+#define EXTERNAL_INPUT_MIN_OVERLAP 16
+#define EXTERNAL_INPUT_READ_SIZE 65536
+#define EXTERNAL_INPUT_MAX_TOKEN 256
 
-int externalInputallocate(DATA* data)
+typedef enum {
+  EXTERNAL_INPUT_TEXT = 0,  /* -exInputFile: header line, then whitespace separated numbers */
+  EXTERNAL_INPUT_CSV        /* -csvInput: csv-file with a header naming the inputs */
+} EXTERNAL_INPUT_FORMAT;
+
+typedef enum {
+  PREFETCH_IDLE = 0,
+  PREFETCH_REQUESTED,
+  PREFETCH_DONE
+} PREFETCH_STATE;
+
+typedef struct EXTERNAL_INPUT_STREAM
+{
+  FILE *file;
+  const char *filename;
+  EXTERNAL_INPUT_FORMAT format;
+  int nu;
+  long capacity;                 /* rows read ahead per window */
+  long overlap;                  /* rows at least kept from the end of the previous window */
+  int endOfInput;                /* no more rows can be read */
+  int error;
+
+  /* text format */
+  char *buffer;
+  size_t pos, size;
+
+  /* csv format */
+  struct csv_parser parser;
+  char **names;                  /* input names, only needed for the header */
+  int *column;                   /* input index of each csv column, -1 if unused */
+  int nColumns, col;
+  long csvRow;
+  double *csvValues;             /* row being parsed: time and the nu inputs */
+  double *pending;               /* parsed rows not yet copied into a window */
+  long nPending, firstPending, maxPending;
+
+  double *row;                   /* scratch row: time and the nu inputs */
+
+  /* the two windows */
+  modelica_real *t[2], *u[2];
+  long allocated[2], n[2], offset[2];
+  int current;
+  int warnedBehind;
+
+  /* prefetch thread */
+  int threadStarted, quit;
+  PREFETCH_STATE state;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} EXTERNAL_INPUT_STREAM;
+
+/* text format */
+
+static int refillBuffer(EXTERNAL_INPUT_STREAM *s)
+{
+  size_t len;
+  if (feof(s->file)) {
+    return 0;
+  }
+  memmove(s->buffer, s->buffer + s->pos, s->size - s->pos);
+  s->size -= s->pos;
+  s->pos = 0;
+  len = fread(s->buffer + s->size, 1, EXTERNAL_INPUT_READ_SIZE - s->size, s->file);
+  s->size += len;
+  s->buffer[s->size] = '\0';
+  return len > 0;
+}
+
+static int nextNumber(EXTERNAL_INPUT_STREAM *s, double *value)
+{
+  char *end;
+  for (;;) {
+    if (s->size - s->pos < EXTERNAL_INPUT_MAX_TOKEN) {
+      refillBuffer(s);
+    }
+    while (s->pos < s->size && strchr(" \t\r\n,;", s->buffer[s->pos])) {
+      s->pos++;
+    }
+    if (s->pos < s->size) {
+      break;
+    }
+    if (!refillBuffer(s)) {
+      return 0;
+    }
+  }
+  if (s->size - s->pos < EXTERNAL_INPUT_MAX_TOKEN) {
+    refillBuffer(s);
+  }
+  *value = strtod(s->buffer + s->pos, &end);
+  if (end == s->buffer + s->pos) {
+    warningStreamPrint(LOG_STDOUT, 0, "External input file %s contains non-numeric data at \"%.20s\". The remaining lines are ignored.", s->filename, s->buffer + s->pos);
+    s->error = 1;
+    return 0;
+  }
+  s->pos = end - s->buffer;
+  return 1;
+}
+
+static int nextTextRow(EXTERNAL_INPUT_STREAM *s, double *row)
 {
-  FILE * pFile = NULL;
-  int i,j;
-  short useLibCsvH = 1;
-  char * cflags = NULL;
-
-
-  cflags = (char*)omc_flagValue[FLAG_INPUT_CSV];
-  if(!cflags){
-    cflags = (char*)omc_flagValue[FLAG_INPUT_FILE];
-    useLibCsvH = 0;
-    if(cflags){
-      pFile = fopen(cflags,"r");
-      if(pFile == NULL)
-        warningStreamPrint(LOG_STDOUT, 0, "OMC can't find the file %s.",cflags);
-    }else{
-      pFile = fopen("externalInput.csv","r");
+  int j;
+  for (j = 0; j <= s->nu; ++j) {
+    if (!nextNumber(s, row + j)) {
+      if (j > 0 && !s->error) {
+        warningStreamPrint(LOG_STDOUT, 0, "External input file %s ends with an incomplete row. It is ignored.", s->filename);
+      }
+      return 0;
     }
   }
+  return 1;
+}
+
+/* csv format */
 
-  data->simulationInfo->external_input.active = (modelica_boolean) (pFile != NULL);
-  if(data->simulationInfo->external_input.active || useLibCsvH){
-    if(useLibCsvH){
-      externalInputallocate2(data, cflags);
-    }else
-      externalInputallocate1(data, pFile);
-
-    if(ACTIVE_STREAM(LOG_SIMULATION))
-    {
-      printf("\nExternal Input");
-      printf("\n========================================================");
-      for(i = 0; i < data->simulationInfo->external_input.n; ++i){
-        printf("\nInput: t=%f   \t", data->simulationInfo->external_input.t[i]);
-        for(j = 0; j < data->modelData->nInputVars; ++j){
-          printf("u%d(t)= %f \t",j+1,data->simulationInfo->external_input.u[i][j]);
+static void csvCell(void *cell, size_t len, void *user)
+{
+  EXTERNAL_INPUT_STREAM *s = (EXTERNAL_INPUT_STREAM*) user;
+  int j, index = -1;
+  char *end;
+
+  if (s->error) {
+    return;
+  }
+  if (s->csvRow == 0) {
+    s->column = (int*) realloc(s->column, (s->col+1)*sizeof(int));
+    if (s->col == 0) {
+      index = 0;
+    } else {
+      for (j = 0; cell && j < s->nu; ++j) {
+        if (0 == strcmp(s->names[j], (const char*) cell)) {
+          index = j+1;
+          break;
         }
       }
-      printf("\n========================================================\n");
     }
+    s->column[s->col++] = index;
+    return;
+  }
+  if (s->col < s->nColumns) {
+    index = s->column[s->col];
+  }
+  if (index >= 0 && cell) {
+    s->csvValues[index] = strtod((const char*) cell, &end);
+    if (*end) {
+      warningStreamPrint(LOG_STDOUT, 0, "Found non-double data in csv-file %s: %s. The remaining rows are ignored.", s->filename, (const char*) cell);
+      s->error = 1;
+    }
+  }
+  s->col++;
+}
 
-    data->simulationInfo->external_input.i = 0;
+static void csvRowEnd(int c, void *user)
+{
+  EXTERNAL_INPUT_STREAM *s = (EXTERNAL_INPUT_STREAM*) user;
+
+  if (s->error) {
+    return;
+  }
+  if (s->csvRow == 0) {
+    s->nColumns = s->col;
+  } else if (s->col != s->nColumns) {
+    warningStreamPrint(LOG_STDOUT, 0, "Row %ld of csv-file %s has %d instead of %d columns. The remaining rows are ignored.", s->csvRow, s->filename, s->col, s->nColumns);
+    s->error = 1;
+    return;
+  } else {
+    if (s->firstPending + s->nPending == s->maxPending) {
+      s->maxPending = s->maxPending ? 2*s->maxPending : 1024;
+      s->pending = (double*) realloc(s->pending, s->maxPending*(s->nu+1)*sizeof(double));
+    }
+    memcpy(s->pending + (s->firstPending + s->nPending)*(s->nu+1), s->csvValues, (s->nu+1)*sizeof(double));
+    s->nPending++;
   }
+  memset(s->csvValues, 0, (s->nu+1)*sizeof(double));
+  s->csvRow++;
+  s->col = 0;
+}
 
-  return 0;
+static int nextCsvRow(EXTERNAL_INPUT_STREAM *s, double *row)
+{
+  size_t len;
+
+  while (!s->nPending) {
+    s->firstPending = 0;
+    if (s->error || !s->file) {
+      return 0;
+    }
+    len = fread(s->buffer, 1, EXTERNAL_INPUT_READ_SIZE, s->file);
+    if (len) {
+      csv_parse(&s->parser, s->buffer, len, csvCell, csvRowEnd, s);
+    }
+    if (len < EXTERNAL_INPUT_READ_SIZE) {
+      csv_fini(&s->parser, csvCell, csvRowEnd, s);
+      fclose(s->file);
+      s->file = NULL;
+    }
+  }
+  memcpy(row, s->pending + s->firstPending*(s->nu+1), (s->nu+1)*sizeof(double));
+  s->firstPending++;
+  s->nPending--;
+  return 1;
 }
 
+/* windows */
 
+/*! \fn fillWindow
+ *
+ * Reads the next rows of the file into window w. Runs in the prefetch thread
+ * for all but the first window, the rows kept from the current window are
+ * put in front of them by nextWindow.
+ */
+static void fillWindow(EXTERNAL_INPUT_STREAM *s, int w)
+{
+  const int nu = s->nu;
+  long k = 0;
 
-void externalInputallocate2(DATA* data, char *filename){
-  int i, j, k;
-  struct csv_data *res = read_csv(filename);
-  char ** names;
-  int * indx;
-  const int nu = data->modelData->nInputVars;
-  const int nnu = modelica_integer_min(nu, res ? res->numvars - 1 : 0);
+  while (k < s->capacity) {
+    if (!(s->format == EXTERNAL_INPUT_CSV ? nextCsvRow(s, s->row) : nextTextRow(s, s->row))) {
+      s->endOfInput = 1;
+      break;
+    }
+    s->t[w][k] = s->row[0];
+    memcpy(s->u[w] + k*nu, s->row + 1, nu*sizeof(modelica_real));
+    k++;
+  }
+  s->n[w] = k;
+}
+
+static void* prefetchThread(void *arg)
+{
+  EXTERNAL_INPUT_STREAM *s = (EXTERNAL_INPUT_STREAM*) arg;
+
+  int current;
 
-  if (NULL == res) {
-    fprintf(stderr, "Failed to read CSV-file %s", filename);
-    EXIT(1);
+  pthread_mutex_lock(&s->mutex);
+  for (;;) {
+    while (s->state != PREFETCH_REQUESTED && !s->quit) {
+      pthread_cond_wait(&s->cond, &s->mutex);
+    }
+    if (s->quit) {
+      break;
+    }
+    current = s->current;
+    pthread_mutex_unlock(&s->mutex);
+    fillWindow(s, 1 - current);
+    pthread_mutex_lock(&s->mutex);
+    s->state = PREFETCH_DONE;
+    pthread_cond_broadcast(&s->cond);
   }
+  pthread_mutex_unlock(&s->mutex);
+  return NULL;
+}
 
-  data->modelData->nInputVars = nu;
-  data->simulationInfo->external_input.n = res->numsteps;
-  data->simulationInfo->external_input.N = data->simulationInfo->external_input.n;
+static void setWindow(EXTERNAL_INPUT *input, EXTERNAL_INPUT_STREAM *s)
+{
+  input->t = s->t[s->current];
+  input->u = s->u[s->current];
+  input->n = s->n[s->current];
+  input->offset = s->offset[s->current];
+}
 
-  data->simulationInfo->external_input.u = (modelica_real**)calloc(data->simulationInfo->external_input.n+1, sizeof(modelica_real*));
+/*! \fn keptRows
+ *
+ * Number of rows at the end of window w needed to interpolate at times from
+ * keepFrom on, at least the minimum overlap.
+ */
+static long keptRows(EXTERNAL_INPUT_STREAM *s, int w, double keepFrom)
+{
+  const modelica_real *t = s->t[w];
+  long lo = 1, hi = s->n[w], mid;
+
+  /* first k in [1, n] with keepFrom <= t[k], the interval starts at k-1 */
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (t[mid] < keepFrom) {
+      lo = mid+1;
+    } else {
+      hi = mid;
+    }
+  }
+  return modelica_integer_max(s->n[w] - (lo-1), modelica_integer_min(s->overlap, s->n[w]));
+}
 
-  names = (char**)malloc(nu * sizeof(char*));
+/*! \fn nextWindow
+ *
+ * Makes the prefetched window the current one, with the rows of the current
+ * window from time keepFrom on in front of the new rows, and starts reading
+ * the one after it. Waits if the prefetch thread is not done yet.
+ *
+ *  \return 0 if there are no more rows
+ */
+static int nextWindow(EXTERNAL_INPUT *input, double keepFrom)
+{
+  EXTERNAL_INPUT_STREAM *s = (EXTERNAL_INPUT_STREAM*) input->stream;
+  const int nu = s->nu;
+  int current = s->current, next = 1 - current;
+  long k;
 
-  for(i = 0; i<data->simulationInfo->external_input.n; ++i){
-    data->simulationInfo->external_input.u[i] = (modelica_real*)calloc(nnu, sizeof(modelica_real));
+  if (!s->threadStarted) {
+    return 0;
+  }
+  pthread_mutex_lock(&s->mutex);
+  while (s->state == PREFETCH_REQUESTED) {
+    pthread_cond_wait(&s->cond, &s->mutex);
+  }
+  if (s->state != PREFETCH_DONE || 0 == s->n[next]) {
+    pthread_mutex_unlock(&s->mutex);
+    return 0;
   }
 
-  data->simulationInfo->external_input.t = (modelica_real*)calloc(data->simulationInfo->external_input.n+1, sizeof(modelica_real));
+  /* the prefetch thread is idle until the next request */
+  k = keptRows(s, current, keepFrom);
+  if (k + s->n[next] > s->allocated[next]) {
+    s->allocated[next] = k + s->n[next];
+    s->t[next] = (modelica_real*) realloc(s->t[next], s->allocated[next]*sizeof(modelica_real));
+    s->u[next] = (modelica_real*) realloc(s->u[next], modelica_integer_max(1, s->allocated[next]*nu)*sizeof(modelica_real));
+    infoStreamPrint(LOG_SOLVER, 0, "External input: a step spans %ld rows, the window grows to %ld rows", k, s->allocated[next]);
+  }
+  memmove(s->t[next] + k, s->t[next], s->n[next]*sizeof(modelica_real));
+  memmove(s->u[next] + k*nu, s->u[next], s->n[next]*nu*sizeof(modelica_real));
+  memcpy(s->t[next], s->t[current] + s->n[current] - k, k*sizeof(modelica_real));
+  memcpy(s->u[next], s->u[current] + (s->n[current] - k)*nu, k*nu*sizeof(modelica_real));
+  s->n[next] += k;
+  s->offset[next] = s->offset[current] + s->n[current] - k;
+
+  s->current = next;
+  s->state = PREFETCH_IDLE;
+  if (!s->endOfInput) {
+    s->state = PREFETCH_REQUESTED;
+    pthread_cond_broadcast(&s->cond);
+  }
+  pthread_mutex_unlock(&s->mutex);
 
-  data->callback->inputNames(data, names);
+  input->i -= s->offset[next] - input->offset;
+  if (input->i < 0) {
+    input->i = 0;
+  }
+  setWindow(input, s);
+  return 1;
+}
 
-  indx = (int*)malloc(nu*sizeof(int));
-  for(i = 0; i < nu; ++i){
-    indx[i] = -1;
-    for(j = 0; j < (res->numvars - 1); ++j){
-      if(strcmp(names[i], res->variables[j]) == 0){
-        indx[i] = j;
-        break;
-      }
-    }
+static EXTERNAL_INPUT_STREAM* openStream(DATA* data, const char *filename, EXTERNAL_INPUT_FORMAT format)
+{
+  EXTERNAL_INPUT_STREAM *s;
+  const int nu = data->modelData->nInputVars;
+  const char *window = omc_flagValue[FLAG_INPUT_WINDOW];
+  long capacity = window ? atol(window) : EXTERNAL_INPUT_DEFAULT_WINDOW;
+  FILE *file = fopen(filename, "r");
+  int c, w;
+
+  if (!file) {
+    return NULL;
+  }
+  if (capacity < 4) {
+    warningStreamPrint(LOG_STDOUT, 0, "-%s=%s is too small, using %d rows.", FLAG_NAME[FLAG_INPUT_WINDOW], window, EXTERNAL_INPUT_DEFAULT_WINDOW);
+    capacity = EXTERNAL_INPUT_DEFAULT_WINDOW;
   }
 
-  for(i = 0, k= 0; i < data->simulationInfo->external_input.n; ++i)
-    data->simulationInfo->external_input.t[i] = res->data[k++];
+  s = (EXTERNAL_INPUT_STREAM*) calloc(1, sizeof(EXTERNAL_INPUT_STREAM));
+  s->file = file;
+  s->filename = filename;
+  s->format = format;
+  s->nu = nu;
+  s->capacity = capacity;
+  s->overlap = capacity/4 < EXTERNAL_INPUT_MIN_OVERLAP ? capacity/4 : EXTERNAL_INPUT_MIN_OVERLAP;
+  s->buffer = (char*) malloc(EXTERNAL_INPUT_READ_SIZE+1);
+  s->row = (double*) calloc(nu+1, sizeof(double));
+  for (w = 0; w < 2; ++w) {
+    s->allocated[w] = capacity;
+    s->t[w] = (modelica_real*) malloc(capacity*sizeof(modelica_real));
+    s->u[w] = (modelica_real*) malloc(modelica_integer_max(1, capacity*nu)*sizeof(modelica_real));
+  }
 
-  for(j = 0; j < nu; ++j){
-    if(indx[j] != -1){
-      k = (indx[j])*data->simulationInfo->external_input.n;
-      for(i = 0; i < data->simulationInfo->external_input.n; ++i){
-        data->simulationInfo->external_input.u[i][j] = res->data[k++];
-      }
+  if (format == EXTERNAL_INPUT_CSV) {
+    csv_init(&s->parser, CSV_STRICT | CSV_REPALL_NL | CSV_STRICT_FINI | CSV_APPEND_NULL | CSV_EMPTY_IS_NULL);
+    csv_set_realloc_func(&s->parser, realloc);
+    csv_set_free_func(&s->parser, free);
+    s->csvValues = (double*) calloc(nu+1, sizeof(double));
+    s->names = (char**) malloc(modelica_integer_max(1, nu)*sizeof(char*));
+    data->callback->inputNames(data, s->names);
+  } else {
+    /* skip the header line */
+    do {
+      c = fgetc(file);
+    } while (c != EOF && c != '\n');
+  }
+
+  fillWindow(s, 0);
+  if (s->names) {
+    free(s->names);
+    s->names = NULL;
+  }
+
+  if (!s->endOfInput) {
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->state = PREFETCH_REQUESTED;
+    if (0 == pthread_create(&s->thread, NULL, prefetchThread, s)) {
+      s->threadStarted = 1;
+    } else {
+      warningStreamPrint(LOG_STDOUT, 0, "Could not start the thread reading %s ahead. Only the first %ld rows are used.", filename, capacity);
+      pthread_mutex_destroy(&s->mutex);
+      pthread_cond_destroy(&s->cond);
     }
   }
+  return s;
+}
 
-  omc_free_csv_reader(res);
-  free(names);
-  free(indx);
-  data->simulationInfo->external_input.active = data->simulationInfo->external_input.n > 0;
+static void closeStream(EXTERNAL_INPUT_STREAM *s)
+{
+  int w;
+
+  if (s->threadStarted) {
+    pthread_mutex_lock(&s->mutex);
+    s->quit = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    pthread_join(s->thread, NULL);
+    pthread_mutex_destroy(&s->mutex);
+    pthread_cond_destroy(&s->cond);
+  }
+  if (s->format == EXTERNAL_INPUT_CSV) {
+    csv_free(&s->parser);
+  }
+  if (s->file) {
+    fclose(s->file);
+  }
+  for (w = 0; w < 2; ++w) {
+    free(s->t[w]);
+    free(s->u[w]);
+  }
+  free(s->column);
+  free(s->csvValues);
+  free(s->pending);
+  free(s->buffer);
+  free(s->row);
+  free(s);
 }
 
-static inline void externalInputallocate1(DATA* data, FILE * pFile){
-  int n,m,c;
-  int i,j;
-  n = 0;
+int externalInputallocate(DATA* data)
+{
+  EXTERNAL_INPUT *input = &data->simulationInfo->external_input;
+  EXTERNAL_INPUT_STREAM *s;
+  const char *filename;
+  int i, j;
+
+  memset(input, 0, sizeof(EXTERNAL_INPUT));
+
+  if (omc_flagValue[FLAG_INPUT_CSV]) {
+    filename = omc_flagValue[FLAG_INPUT_CSV];
+    s = openStream(data, filename, EXTERNAL_INPUT_CSV);
+    if (NULL == s) {
+      fprintf(stderr, "Failed to read CSV-file %s", filename);
+      EXIT(1);
+    }
+  } else {
+    filename = omc_flagValue[FLAG_INPUT_FILE] ? omc_flagValue[FLAG_INPUT_FILE] : "externalInput.csv";
+    s = openStream(data, filename, EXTERNAL_INPUT_TEXT);
+    if (NULL == s) {
+      if (omc_flagValue[FLAG_INPUT_FILE]) {
+        warningStreamPrint(LOG_STDOUT, 0, "OMC can't find the file %s.", filename);
+      }
+      return 0;
+    }
+  }
 
-  while(1) {
-    c = fgetc(pFile);
-    if (c==EOF) break;
-    if (c=='\n') ++n;
+  if (0 == s->n[0]) {
+    if (s->format == EXTERNAL_INPUT_TEXT) {
+      fprintf(stderr, "External input file: %s is empty!\n", filename); fflush(NULL);
+      EXIT(1);
+    }
+    closeStream(s);
+    return 0;
   }
-  // check if csv file is empty!
-  if (n == 0)
+
+  input->stream = s;
+  input->nu = s->nu;
+  input->i = 0;
+  setWindow(input, s);
+  input->active = 1;
+
+  if(ACTIVE_STREAM(LOG_SIMULATION))
   {
-    fprintf(stderr, "External input file: externalInput.csv is empty!\n"); fflush(NULL);
-    EXIT(1);
-  }
-
-  --n;
-  data->simulationInfo->external_input.n = n;
-  data->simulationInfo->external_input.N = data->simulationInfo->external_input.n;
-  rewind(pFile);
-
-  do{
-    c = fgetc(pFile);
-    if (c==EOF) break;
-  }while(c!='\n');
-
-  m = data->modelData->nInputVars;
-  data->simulationInfo->external_input.u = (modelica_real**)calloc(modelica_integer_max(1,n),sizeof(modelica_real*));
-  for(i = 0; i<data->simulationInfo->external_input.n; ++i)
-    data->simulationInfo->external_input.u[i] = (modelica_real*)calloc(modelica_integer_max(1,m),sizeof(modelica_real));
-  data->simulationInfo->external_input.t = (modelica_real*)calloc(modelica_integer_max(1,data->simulationInfo->external_input.n),sizeof(modelica_real));
-
-  for(i = 0; i < data->simulationInfo->external_input.n; ++i){
-    c = fscanf(pFile, "%lf", &data->simulationInfo->external_input.t[i]);
-    for(j = 0; j < m; ++j){
-    c = fscanf(pFile, "%lf", &data->simulationInfo->external_input.u[i][j]);
+    printf("\nExternal Input");
+    printf("\n========================================================");
+    for(i = 0; i < input->n; ++i){
+      printf("\nInput: t=%f   \t", input->t[i]);
+      for(j = 0; j < input->nu; ++j){
+        printf("u%d(t)= %f \t", j+1, input->u[i*input->nu+j]);
+      }
+    }
+    if(s->threadStarted){
+      printf("\n... the following rows are read while simulating");
     }
-    if(c<0)
-    data->simulationInfo->external_input.n = i;
+    printf("\n========================================================\n");
   }
-  fclose(pFile);
+
+  return 0;
 }
 
 int externalInputFree(DATA* data)
 {
-  if(data->simulationInfo->external_input.active){
-    int j;
+  EXTERNAL_INPUT *input = &data->simulationInfo->external_input;
 
-    free(data->simulationInfo->external_input.t);
-    for(j = 0; j < data->simulationInfo->external_input.N; ++j)
-      free(data->simulationInfo->external_input.u[j]);
-    free(data->simulationInfo->external_input.u);
-    data->simulationInfo->external_input.active = 0;
+  if(input->stream){
+    closeStream((EXTERNAL_INPUT_STREAM*) input->stream);
   }
+  memset(input, 0, sizeof(EXTERNAL_INPUT));
   return 0;
 }
 
+/*! \fn findInterval
+ *
+ * Moves the cursor to the first interval [t[i], t[i+1]] with t <= t[i+1],
+ * or the last one if t is behind the window. The next interval is checked
+ * before falling back to a binary search, since time mostly moves forward
+ * by less than one row.
+ */
+static void findInterval(EXTERNAL_INPUT *input, double t)
+{
+  const modelica_real *tt = input->t;
+  long i = input->i, lo, hi, mid;
+
+  if (i > input->n-2) {
+    i = input->n-2;
+  }
+  if ((i == 0 || t > tt[i]) && t <= tt[i+1]) {
+    input->i = i;
+    return;
+  }
+  if (i+2 < input->n && t > tt[i+1] && t <= tt[i+2]) {
+    input->i = i+1;
+    return;
+  }
+
+  /* first k in [1, n-1] with t <= tt[k] */
+  lo = 1;
+  hi = input->n-1;
+  while (lo < hi) {
+    mid = lo + (hi-lo)/2;
+    if (tt[mid] < t) {
+      lo = mid+1;
+    } else {
+      hi = mid;
+    }
+  }
+  input->i = lo-1;
+}
 
 int externalInputUpdate(DATA* data)
 {
-  double u1, u2;
-  double t, t1, t2;
-  long double dt;
-  int i;
+  EXTERNAL_INPUT *input = &data->simulationInfo->external_input;
+  EXTERNAL_INPUT_STREAM *s;
+  const modelica_real *u1, *u2;
+  double t, t1, t2, w;
+  int j;
 
-  if(!data->simulationInfo->external_input.active){
+  if(!input->active){
     return -1;
   }
 
+  /* localData[1] holds the last accepted step, no solver steps back further */
   t = data->localData[0]->timeValue;
-  t1 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i];
-  t2 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i+1];
+  while(t > input->t[input->n-1] && nextWindow(input, fmin(t, data->localData[1]->timeValue)));
 
-  while(data->simulationInfo->external_input.i > 0 && t < t1){
-    --data->simulationInfo->external_input.i;
-    t1 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i];
-    t2 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i+1];
+  if(input->n == 1){
+    memcpy(data->simulationInfo->inputVars, input->u, input->nu*sizeof(modelica_real));
+    return t == input->t[0];
   }
 
-  while(t > t2
-        && data->simulationInfo->external_input.i+1 < (data->simulationInfo->external_input.n-1)){
-    ++data->simulationInfo->external_input.i;
-    t1 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i];
-    t2 = data->simulationInfo->external_input.t[data->simulationInfo->external_input.i+1];
+  s = (EXTERNAL_INPUT_STREAM*) input->stream;
+  if(t < input->t[0] && input->offset > 0 && !s->warnedBehind){
+    s->warnedBehind = 1;
+    warningStreamPrint(LOG_SIMULATION, 0, "External input at t=%g lies before the rows held in memory (t>=%g).", t, input->t[0]);
   }
 
+  findInterval(input, t);
+  t1 = input->t[input->i];
+  t2 = input->t[input->i+1];
+  u1 = input->u + input->i*input->nu;
+  u2 = u1 + input->nu;
+
   if(t == t1){
-    for(i = 0; i < data->modelData->nInputVars; ++i){
-      data->simulationInfo->inputVars[i] = data->simulationInfo->external_input.u[data->simulationInfo->external_input.i][i];
-    }
-    return 1;
-  }else if(t == t2){
-    for(i = 0; i < data->modelData->nInputVars; ++i){
-      data->simulationInfo->inputVars[i] = data->simulationInfo->external_input.u[data->simulationInfo->external_input.i+1][i];
-    }
+    memcpy(data->simulationInfo->inputVars, u1, input->nu*sizeof(modelica_real));
     return 1;
+  }else if(t == t2 || t1 == t2){
+    memcpy(data->simulationInfo->inputVars, u2, input->nu*sizeof(modelica_real));
+    return t == t2;
   }
 
-  dt = (data->simulationInfo->external_input.t[data->simulationInfo->external_input.i+1] - data->simulationInfo->external_input.t[data->simulationInfo->external_input.i]);
-  for(i = 0; i < data->modelData->nInputVars; ++i){
-    u1 = data->simulationInfo->external_input.u[data->simulationInfo->external_input.i][i];
-    u2 = data->simulationInfo->external_input.u[data->simulationInfo->external_input.i+1][i];
-
-    if(u1 != u2){
-      data->simulationInfo->inputVars[i] =  (u1*(dt+t1-t)+(t-t1)*u2)/dt;
-    }else{
-      data->simulationInfo->inputVars[i] = u1;
-    }
+  w = (t-t1)/(t2-t1);
+  for(j = 0; j < input->nu; ++j){
+    data->simulationInfo->inputVars[j] = u1[j] + w*(u2[j]-u1[j]);
   }
- return 0;
+  return 0;
 }
-
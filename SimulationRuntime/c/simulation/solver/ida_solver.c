@@ -358,6 +358,13 @@ ida_solver_initial(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo
   }
   infoStreamPrint(LOG_SOLVER, 0, "jacobian is calculated by %s", JACOBIAN_METHOD_DESC[idaData->jacobianMethod]);
 
+  /* return after every internal step, the output points are interpolated */
+  if (omc_flag[FLAG_DENSE_OUTPUT] && !omc_flag[FLAG_NOEQUIDISTANT_GRID])
+  {
+    solverInfo->solverDenseOutput = 1;
+  }
+  infoStreamPrint(LOG_SOLVER, 0, "interpolate output points %s", solverInfo->solverDenseOutput?"YES":"NO");
+
 
   TRACE_POP
   return 0;
@@ -381,6 +388,21 @@ ida_solver_deinitial(IDA_SOLVER *idaData){
   return 0;
 }
 
+/* interpolate the states of the last ida step */
+void
+ida_solver_interpolate(IDA_SOLVER *idaData, int nStates, double time, double *states, double *stateDer)
+{
+  N_Vector dky = N_VMake_Serial(nStates, states);
+
+  if (checkIDAflag(IDAGetDky(idaData->ida_mem, time, 0, dky)))
+  {
+    warningStreamPrint(LOG_SOLVER, 0, "##IDA## interpolation at time %.15g failed", time);
+  }
+  N_VSetArrayPointer(stateDer, dky);
+  IDAGetDky(idaData->ida_mem, time, 1, dky);
+  N_VDestroy_Serial(dky);
+}
+
 /* main ida function to make a step */
 int
 ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
@@ -459,6 +481,15 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   /* Calculate steps until TOUT is reached */
   tout = solverInfo->currentTime + solverInfo->currentStepSize;
 
+  /* in dense output mode a single step is taken, which must not pass tout */
+  if (solverInfo->solverDenseOutput)
+  {
+    flag = IDASetStopTime(idaData->ida_mem, tout);
+    if (checkIDAflag(flag)){
+      throwStreamPrint(threadData, "##IDA## Setting the stop time failed!");
+    }
+  }
+
 
   do
   {
@@ -468,13 +499,18 @@ ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
     externalInputUpdate(data);
     data->callback->input_function(data, threadData);
 
-    flag = IDASolve(idaData->ida_mem, tout, &solverInfo->currentTime, idaData->y, idaData->yp, IDA_NORMAL);
+    flag = IDASolve(idaData->ida_mem, tout, &solverInfo->currentTime, idaData->y, idaData->yp, solverInfo->solverDenseOutput ? IDA_ONE_STEP : IDA_NORMAL);
 
     /* set time to current time */
     sData->timeValue = solverInfo->currentTime;
 
     /* error handling */
-    if ( !checkIDAflag(flag) && solverInfo->currentTime >=tout)
+    if (solverInfo->solverDenseOutput && (flag == IDA_SUCCESS || flag == IDA_TSTOP_RETURN))
+    {
+      infoStreamPrint(LOG_SOLVER, 0, "##IDA## step to time = %.15g", solverInfo->currentTime);
+      finished = TRUE;
+    }
+    else if ( !checkIDAflag(flag) && solverInfo->currentTime >=tout)
     {
       infoStreamPrint(LOG_SOLVER, 0, "##IDA## step to time = %.15g", solverInfo->currentTime);
       finished = TRUE;
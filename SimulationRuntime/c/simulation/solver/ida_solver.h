@@ -87,6 +87,10 @@ ida_solver_deinitial(IDA_SOLVER *idaData);
 int
 ida_solver_step(DATA* simData, threadData_t *threadData, SOLVER_INFO* solverInfo);
 
+/* interpolate the states of the last ida step */
+void
+ida_solver_interpolate(IDA_SOLVER *idaData, int nStates, double time, double *states, double *stateDer);
+
 #endif
 
 #endif
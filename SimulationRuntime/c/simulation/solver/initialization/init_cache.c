@@ -0,0 +1,357 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file init_cache.c
+ *
+ *  The cache file consists of a header and up to INIT_CACHE_MAX_ENTRIES fixed
+ *  size entries. Each entry holds the hashes and the real key vector of a run
+ *  and the converged values of all real variables. The file is rewritten
+ *  completely by each store, via a temporary file, so readers never see a
+ *  partial entry. Threads of the same process (-batch) serialize their
+ *  accesses; concurrent processes may lose each other's entries but never
+ *  corrupt the file.
+ */
+
+#include "init_cache.h"
+
+#include "util/omc_error.h"
+#include "meta/meta_modelica.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#if defined(_MSC_VER)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define INIT_CACHE_MAGIC "OMCINITS"
+#define INIT_CACHE_VERSION 1
+#define INIT_CACHE_BYTE_ORDER 0x01020304
+#define INIT_CACHE_MAX_ENTRIES 64
+
+typedef struct INIT_CACHE_HEADER
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  char guid[64];
+  uint32_t nKey;
+  uint32_t nReal;
+  uint32_t nEntries;
+  uint32_t reserved;
+  uint64_t useCounter;                 /* incremented by every store, orders the entries by last use */
+  uint64_t hits;
+  uint64_t nearHits;
+  uint64_t misses;
+  uint64_t rejected;                   /* (near) hits whose starting guess did not converge */
+} INIT_CACHE_HEADER;
+
+typedef struct INIT_CACHE_ENTRY
+{
+  uint64_t hash;
+  uint64_t discreteHash;
+  uint64_t lastUse;
+  /* followed by double key[nKey] and double solution[nReal] */
+} INIT_CACHE_ENTRY;
+
+static pthread_mutex_t initCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *RESULT_NAME[] = {"miss", "near hit", "hit"};
+
+/* FNV-1a */
+static uint64_t hashBytes(uint64_t hash, const void *p, size_t n)
+{
+  const unsigned char *c = (const unsigned char*) p;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    hash = (hash ^ c[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static void initHeader(DATA *data, INIT_CACHE_HEADER *header, uint32_t nKey)
+{
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, INIT_CACHE_MAGIC, sizeof(header->magic));
+  header->version = INIT_CACHE_VERSION;
+  header->byteOrder = INIT_CACHE_BYTE_ORDER;
+  strncpy(header->guid, data->modelData->modelGUID, sizeof(header->guid) - 1);
+  header->nKey = nKey;
+  header->nReal = (uint32_t) data->modelData->nVariablesReal;
+}
+
+/* opens the cache and reads a header that matches the model; NULL otherwise */
+static FILE* openCache(DATA *data, const char *filename, INIT_CACHE_HEADER *header, uint32_t nKey)
+{
+  INIT_CACHE_HEADER expected;
+  FILE *file = fopen(filename, "rb");
+
+  if (NULL == file) {
+    return NULL;
+  }
+  initHeader(data, &expected, nKey);
+  if (1 != fread(header, sizeof(*header), 1, file) || memcmp(header->magic, expected.magic, sizeof(header->magic)) ||
+      header->version != expected.version || header->byteOrder != expected.byteOrder || memcmp(header->guid, expected.guid, sizeof(header->guid)) ||
+      header->nKey != expected.nKey || header->nReal != expected.nReal || header->nEntries > INIT_CACHE_MAX_ENTRIES) {
+    infoStreamPrint(LOG_INIT, 0, "initialization cache %s belongs to another model or version and is replaced", filename);
+    fclose(file);
+    return NULL;
+  }
+  return file;
+}
+
+static void computeKey(DATA *data, INIT_CACHE_KEY *key)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  uint64_t discreteHash = 14695981039346656037ULL;
+  long i, n = 0;
+
+  for (i = 0; i < mData->nVariablesReal; i++) {
+    n += mData->realVarsData[i].attribute.fixed ? 1 : 0;
+  }
+  key->nKey = (uint32_t) (mData->nParametersReal + n + 1);
+  key->key = (double*) malloc(key->nKey * sizeof(double));
+
+  n = 0;
+  memcpy(key->key, sInfo->realParameter, mData->nParametersReal * sizeof(double));
+  n += mData->nParametersReal;
+  for (i = 0; i < mData->nVariablesReal; i++) {
+    if (mData->realVarsData[i].attribute.fixed) {
+      key->key[n++] = mData->realVarsData[i].attribute.start;
+    }
+  }
+  key->key[n++] = sInfo->startTime;
+
+  discreteHash = hashBytes(discreteHash, sInfo->integerParameter, mData->nParametersInteger * sizeof(modelica_integer));
+  discreteHash = hashBytes(discreteHash, sInfo->booleanParameter, mData->nParametersBoolean * sizeof(modelica_boolean));
+  for (i = 0; i < mData->nParametersString; i++) {
+    modelica_string s = sInfo->stringParameter[i];
+    discreteHash = s ? hashBytes(discreteHash, MMC_STRINGDATA(s), MMC_STRLEN(s) + 1) : hashBytes(discreteHash, "", 0);
+  }
+  for (i = 0; i < mData->nVariablesInteger; i++) {
+    if (mData->integerVarsData[i].attribute.fixed) {
+      discreteHash = hashBytes(discreteHash, &mData->integerVarsData[i].attribute.start, sizeof(modelica_integer));
+    }
+  }
+  for (i = 0; i < mData->nVariablesBoolean; i++) {
+    if (mData->booleanVarsData[i].attribute.fixed) {
+      discreteHash = hashBytes(discreteHash, &mData->booleanVarsData[i].attribute.start, sizeof(modelica_boolean));
+    }
+  }
+  key->discreteHash = discreteHash;
+  key->hash = hashBytes(discreteHash, key->key, key->nKey * sizeof(double));
+}
+
+/* root mean square of the relative differences */
+static double keyDistance(const double *a, const double *b, uint32_t n)
+{
+  double sum = 0.0;
+  uint32_t i;
+  for (i = 0; i < n; i++) {
+    double scale = fmax(fmax(fabs(a[i]), fabs(b[i])), 1e-10);
+    double d = (a[i] - b[i]) / scale;
+    sum += d*d;
+  }
+  return n ? sqrt(sum / n) : 0.0;
+}
+
+enum INIT_CACHE_RESULT initCacheLookup(DATA *data, const char *filename, INIT_CACHE_KEY *key)
+{
+  TRACE_PUSH
+  MODEL_DATA *mData = data->modelData;
+  INIT_CACHE_HEADER header;
+  INIT_CACHE_ENTRY entry;
+  double *entryKey, *solution;
+  long best = -1, i;
+  size_t entrySize;
+  FILE *file;
+
+  computeKey(data, key);
+  key->result = INIT_CACHE_MISS;
+  key->distance = INFINITY;
+
+  pthread_mutex_lock(&initCacheMutex);
+  file = openCache(data, filename, &header, key->nKey);
+  if (NULL == file) {
+    pthread_mutex_unlock(&initCacheMutex);
+    infoStreamPrint(LOG_INIT, 0, "initialization cache: miss (no entries)");
+    TRACE_POP
+    return INIT_CACHE_MISS;
+  }
+
+  entrySize = sizeof(INIT_CACHE_ENTRY) + (header.nKey + header.nReal) * sizeof(double);
+  entryKey = (double*) malloc(header.nKey * sizeof(double));
+  for (i = 0; i < (long) header.nEntries; i++) {
+    if (0 != fseek(file, (long) (sizeof(header) + i * entrySize), SEEK_SET) ||
+        1 != fread(&entry, sizeof(entry), 1, file) || header.nKey != fread(entryKey, sizeof(double), header.nKey, file)) {
+      break;
+    }
+    if (entry.discreteHash != key->discreteHash) {
+      continue;
+    }
+    if (entry.hash == key->hash && 0 == memcmp(entryKey, key->key, key->nKey * sizeof(double))) {
+      key->result = INIT_CACHE_HIT;
+      key->distance = 0.0;
+      best = i;
+      break;
+    } else {
+      double distance = keyDistance(entryKey, key->key, key->nKey);
+      if (distance < key->distance) {
+        key->result = INIT_CACHE_NEAR;
+        key->distance = distance;
+        best = i;
+      }
+    }
+  }
+  free(entryKey);
+
+  /* read the solution of the chosen entry, fixed variables keep their start value */
+  solution = best >= 0 ? (double*) malloc(header.nReal * sizeof(double)) : NULL;
+  if (solution && (0 != fseek(file, (long) (sizeof(header) + best * entrySize + sizeof(entry) + header.nKey * sizeof(double)), SEEK_SET) ||
+                   header.nReal != fread(solution, sizeof(double), header.nReal, file))) {
+    key->result = INIT_CACHE_MISS;
+  }
+  fclose(file);
+  pthread_mutex_unlock(&initCacheMutex);
+
+  if (INIT_CACHE_MISS != key->result) {
+    for (i = 0; i < mData->nVariablesReal; i++) {
+      if (!mData->realVarsData[i].attribute.fixed) {
+        data->localData[0]->realVars[i] = solution[i];
+      }
+    }
+  }
+  free(solution);
+
+  infoStreamPrint(LOG_INIT, 0, "initialization cache: %s (entry %ld of %u, relative distance %g)", RESULT_NAME[key->result], best+1, (unsigned int) header.nEntries, key->distance);
+  TRACE_POP
+  return key->result;
+}
+
+void initCacheStore(DATA *data, const char *filename, INIT_CACHE_KEY *key, int rejected)
+{
+  TRACE_PUSH
+  INIT_CACHE_HEADER header;
+  INIT_CACHE_ENTRY *entry;
+  char *entries = NULL, *tmpFilename;
+  size_t entrySize;
+  long i, slot = -1;
+  FILE *file;
+  int ok;
+
+  pthread_mutex_lock(&initCacheMutex);
+  file = openCache(data, filename, &header, key->nKey);
+  if (NULL != file) {
+    entrySize = sizeof(INIT_CACHE_ENTRY) + (header.nKey + header.nReal) * sizeof(double);
+    entries = (char*) malloc((header.nEntries + 1) * entrySize);
+    if (header.nEntries != fread(entries, entrySize, header.nEntries, file)) {
+      header.nEntries = 0;
+    }
+    fclose(file);
+  } else {
+    initHeader(data, &header, key->nKey);
+    entrySize = sizeof(INIT_CACHE_ENTRY) + (header.nKey + header.nReal) * sizeof(double);
+    entries = (char*) malloc(entrySize);
+  }
+
+  /* same key, a free slot or the least recently used entry */
+  for (i = 0; i < (long) header.nEntries; i++) {
+    entry = (INIT_CACHE_ENTRY*) (entries + i * entrySize);
+    if (entry->hash == key->hash && entry->discreteHash == key->discreteHash &&
+        0 == memcmp(entry + 1, key->key, key->nKey * sizeof(double))) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0 && header.nEntries < INIT_CACHE_MAX_ENTRIES) {
+    slot = header.nEntries++;
+  } else if (slot < 0) {
+    slot = 0;
+    for (i = 1; i < (long) header.nEntries; i++) {
+      if (((INIT_CACHE_ENTRY*) (entries + i * entrySize))->lastUse < ((INIT_CACHE_ENTRY*) (entries + slot * entrySize))->lastUse) {
+        slot = i;
+      }
+    }
+  }
+  entry = (INIT_CACHE_ENTRY*) (entries + slot * entrySize);
+  entry->hash = key->hash;
+  entry->discreteHash = key->discreteHash;
+  entry->lastUse = ++header.useCounter;
+  memcpy(entry + 1, key->key, key->nKey * sizeof(double));
+  memcpy((double*) (entry + 1) + key->nKey, data->localData[0]->realVars, header.nReal * sizeof(double));
+
+  header.hits += INIT_CACHE_HIT == key->result && !rejected;
+  header.nearHits += INIT_CACHE_NEAR == key->result && !rejected;
+  header.misses += INIT_CACHE_MISS == key->result;
+  header.rejected += 0 != rejected;
+
+  tmpFilename = (char*) malloc(strlen(filename) + 32);
+  sprintf(tmpFilename, "%s.%ld.tmp", filename, (long) getpid());
+  file = fopen(tmpFilename, "wb");
+  ok = NULL != file;
+  if (ok) {
+    ok = 1 == fwrite(&header, sizeof(header), 1, file) && header.nEntries == fwrite(entries, entrySize, header.nEntries, file);
+    ok = (0 == fclose(file)) && ok;
+#if defined(_WIN32)
+    if (ok) {
+      remove(filename);
+    }
+#endif
+    ok = ok && 0 == rename(tmpFilename, filename);
+    if (!ok) {
+      remove(tmpFilename);
+    }
+  }
+  pthread_mutex_unlock(&initCacheMutex);
+
+  if (!ok) {
+    warningStreamPrint(LOG_STDOUT, 0, "initialization cache: could not write %s: %s", filename, strerror(errno));
+  }
+  infoStreamPrint(LOG_STATS, 0, "initialization cache: %s%s, %lu hits, %lu near hits, %lu misses, %lu rejected guesses in %u entries",
+                  RESULT_NAME[key->result], rejected ? " (rejected)" : "", (unsigned long) header.hits, (unsigned long) header.nearHits,
+                  (unsigned long) header.misses, (unsigned long) header.rejected, (unsigned int) header.nEntries);
+
+  free(entries);
+  free(tmpFilename);
+  TRACE_POP
+}
+
+void initCacheFreeKey(INIT_CACHE_KEY *key)
+{
+  free(key->key);
+  key->key = NULL;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file init_cache.h
+ *
+ *  Description: file cache of converged initial solutions, keyed by a hash
+ *  of the parameters and fixed start values (see -initSolutionCache).
+ */
+
+#ifndef _INIT_CACHE_H_
+#define _INIT_CACHE_H_
+
+#include "simulation_data.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+enum INIT_CACHE_RESULT
+{
+  INIT_CACHE_MISS = 0,                 /* no usable entry, regular initialization */
+  INIT_CACHE_NEAR,                     /* warm start from the nearest entry */
+  INIT_CACHE_HIT                       /* start from the solution of the same key */
+};
+
+typedef struct INIT_CACHE_KEY
+{
+  uint64_t hash;                       /* all parameters, fixed start values and start time */
+  uint64_t discreteHash;               /* integer, boolean and string parts of the key only */
+  uint32_t nKey;
+  double *key;                         /* real parameters, real fixed start values and start time */
+  enum INIT_CACHE_RESULT result;
+  double distance;                     /* relative distance to the entry used */
+} INIT_CACHE_KEY;
+
+/* computes the key of the current parameters and, on a (near) hit, writes the
+ * cached solution of the non-fixed real variables to localData[0] */
+enum INIT_CACHE_RESULT initCacheLookup(DATA *data, const char *filename, INIT_CACHE_KEY *key);
+/* stores the converged solution in localData[0] and updates the statistics;
+ * rejected is set if the cached starting guess did not converge */
+void initCacheStore(DATA *data, const char *filename, INIT_CACHE_KEY *key, int rejected);
+void initCacheFreeKey(INIT_CACHE_KEY *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
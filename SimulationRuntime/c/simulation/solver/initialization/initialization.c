@@ -50,6 +50,11 @@
 #include "simulation/solver/nonlinearSystem.h"
 #include "simulation/solver/delay.h"
 #include "simulation/solver/synchronous.h"
+#include "simulation/solver/nonlinearValuesList.h"
+#if !defined(OMC_MINIMAL_RUNTIME)
+#include "simulation/solver/initialization/init_cache.h"
+#include "simulation/options.h"
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -274,6 +279,34 @@ static int symbolic_initialization(DATA *data, threadData_t *threadData, long nu
   return retVal;
 }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+/*! \fn static void resetInitialGuess(DATA *data)
+ *
+ *  Restores the state before symbolic_initialization after a cached starting
+ *  guess did not converge.
+ *
+ *  \param [ref] [data]
+ */
+static void resetInitialGuess(DATA *data)
+{
+  long i;
+
+  setAllVarsToStart(data);
+  for(i=0; i<data->modelData->nNonLinearSystems; ++i) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &data->simulationInfo->nonlinearSystemData[i];
+    nonlinsys->solved = 1;
+    if (listLen(((VALUES_LIST*)nonlinsys->oldValueList)->valueList)>0)
+      cleanValueList((VALUES_LIST*)nonlinsys->oldValueList, NULL);
+  }
+  for(i=0; i<data->modelData->nLinearSystems; ++i) {
+    data->simulationInfo->linearSystemData[i].solved = 1;
+  }
+  for(i=0; i<data->modelData->nMixedSystems; ++i) {
+    data->simulationInfo->mixedSystemData[i].solved = 1;
+  }
+}
+#endif
+
 /*! \fn static char *mapToDymolaVars(const char *varname)
  *
  *  \param [in]  [varname]
@@ -529,6 +562,11 @@ int initialization(DATA *data, threadData_t *threadData, const char* pInitMethod
   int initMethod = IIM_SYMBOLIC; /* default method */
   int retVal = -1;
   int i;
+#if !defined(OMC_MINIMAL_RUNTIME)
+  const char *cacheFile = omc_flag[FLAG_INIT_SOLUTION_CACHE] ? omc_flagValue[FLAG_INIT_SOLUTION_CACHE] : NULL;
+  INIT_CACHE_KEY cacheKey = {0};
+  int cacheRejected = 0;
+#endif
 
   infoStreamPrint(LOG_INIT, 0, "### START INITIALIZATION ###");
 
@@ -603,6 +641,30 @@ int initialization(DATA *data, threadData_t *threadData, const char* pInitMethod
   if(IIM_NONE == initMethod) {
     retVal = 0;
   } else if(IIM_SYMBOLIC == initMethod) {
+#if !defined(OMC_MINIMAL_RUNTIME)
+    /* start from a cached solution of the same or a similar parameter set */
+    if(cacheFile && !(pInitFile && strcmp(pInitFile, "")) &&
+       INIT_CACHE_MISS != initCacheLookup(data, cacheFile, &cacheKey)) {
+      /* the generated code throws if a system does not converge */
+      volatile int cacheConverged = 0;
+#ifndef OMC_EMCC
+      MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+      retVal = symbolic_initialization(data, threadData, 0);
+      cacheConverged = !(check_nonlinear_solutions(data, 0) ||
+                         check_linear_solutions(data, 0) ||
+                         check_mixed_solutions(data, 0));
+#ifndef OMC_EMCC
+      MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+      if(!cacheConverged) {
+        infoStreamPrint(LOG_INIT, 0, "initialization cache: cached starting guess rejected, using the start values");
+        cacheRejected = 1;
+        resetInitialGuess(data);
+        retVal = symbolic_initialization(data, threadData, lambda_steps);
+      }
+    } else
+#endif
     retVal = symbolic_initialization(data, threadData, lambda_steps);
   } else {
     throwStreamPrint(threadData, "unsupported option -iim");
@@ -628,6 +690,15 @@ int initialization(DATA *data, threadData_t *threadData, const char* pInitMethod
   }
   /* end workaround */
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+  if(cacheKey.key) {
+    if(0 == retVal) {
+      initCacheStore(data, cacheFile, &cacheKey, cacheRejected);
+    }
+    initCacheFreeKey(&cacheKey);
+  }
+#endif
+
   dumpInitialSolution(data);
   infoStreamPrint(LOG_INIT, 0, "### END INITIALIZATION ###");
 
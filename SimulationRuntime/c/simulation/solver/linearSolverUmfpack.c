@@ -41,6 +41,7 @@
 #include "simulation_data.h"
 #include "simulation/simulation_info_json.h"
 #include "util/omc_error.h"
+#include "util/omc_trace.h"
 #include "util/varinfo.h"
 #include "model_help.h"
 
@@ -329,6 +330,7 @@ solveUmfPack(DATA *data, threadData_t *threadData, int sysNumber)
         (int)systemData->equationIndex, data->localData[0]->timeValue, status);
   }
   solverData->numberSolving += 1;
+  OMC_TRACE(LOG_LS, OMC_TRACE_LS_UMFPACK_SOLVE, 4, data->localData[0]->timeValue, eqSystemNumber, systemData->size, success);
 
   return success;
 }
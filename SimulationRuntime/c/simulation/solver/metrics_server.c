@@ -0,0 +1,383 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file metrics_server.c
+ *
+ *  The counters are read without locks while the simulation thread changes
+ *  them. They are word-sized, so every value is one the simulation had, but
+ *  values of one response may belong to slightly different points of time.
+ *
+ *  Every model instance has its own server, so the instances of -batch do not
+ *  share one. They are given the same address; the first one that listens on
+ *  it serves its runs and the others only warn.
+ */
+
+#include "metrics_server.h"
+#include "real_time_profile.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+#include "util/rtclock.h"
+#include "meta/gc/mmc_gc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define METRICS_POLL_MS 200
+
+/* a client that is gone must not raise SIGPIPE in the simulation */
+#if defined(MSG_NOSIGNAL)
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+struct METRICS_SERVER
+{
+  DATA *data;
+  SOLVER_INFO *solverInfo;
+  int fd;
+  char *path;                           /* Unix socket, removed at the end */
+  volatile int stop;
+  pthread_t thread;
+  rtclock_t started;
+};
+
+typedef struct METRICS_BUFFER
+{
+  char *str;
+  size_t len;
+  size_t size;
+} METRICS_BUFFER;
+
+static void metricsAppend(METRICS_BUFFER *buf, const char *format, ...)
+{
+  va_list ap;
+  int n;
+  while (1) {
+    va_start(ap, format);
+    n = vsnprintf(buf->str + buf->len, buf->size - buf->len, format, ap);
+    va_end(ap);
+    if (n < 0) {
+      return;
+    }
+    if (buf->len + n < buf->size) {
+      buf->len += n;
+      return;
+    }
+    buf->size = 2*buf->size + n;
+    buf->str = (char*) realloc(buf->str, buf->size);
+  }
+}
+
+static void metricsGauge(METRICS_BUFFER *buf, const char *name, const char *type, const char *help, double value)
+{
+  metricsAppend(buf, "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", name, help, name, type, name, value);
+}
+
+static long residentBytes(void)
+{
+#if defined(__linux__)
+  long size, resident = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (2 != fscanf(f, "%ld %ld", &size, &resident)) {
+      resident = 0;
+    }
+    fclose(f);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+static void metricsCollect(METRICS_SERVER *s, METRICS_BUFFER *buf)
+{
+  DATA *data = s->data;
+  SOLVER_INFO *solverInfo = s->solverInfo;
+  MODEL_DATA *modelData = data->modelData;
+  SIMULATION_INFO *simulationInfo = data->simulationInfo;
+  unsigned long stats[5] = {0};
+  long i;
+
+  /* the solver counts since its last restart in solverStatsTmp */
+  if (solverInfo->solverStats && solverInfo->solverStatsTmp) {
+    for (i=0; i<5; i++) {
+      stats[i] = solverInfo->solverStats[i] + solverInfo->solverStatsTmp[i];
+    }
+  }
+
+  metricsAppend(buf, "# HELP omc_info The simulated model\n# TYPE omc_info gauge\nomc_info{model=\"%s\",solver=\"%s\"} 1\n",
+                modelData->modelName, SOLVER_METHOD_NAME[solverInfo->solverMethod]);
+  metricsGauge(buf, "omc_initializing", "gauge", "1 while the initial system is solved", simulationInfo->initial);
+  metricsGauge(buf, "omc_time", "gauge", "Simulated time", solverInfo->currentTime);
+  metricsGauge(buf, "omc_start_time", "gauge", "Start time of the simulation", simulationInfo->startTime);
+  metricsGauge(buf, "omc_stop_time", "gauge", "Stop time of the simulation", simulationInfo->stopTime);
+  metricsGauge(buf, "omc_wall_time_seconds", "gauge", "Wall clock time since the server started", rt_ext_tp_tock(&s->started));
+  metricsGauge(buf, "omc_step_size", "gauge", "Current step size of the integrator", solverInfo->currentStepSize);
+  metricsGauge(buf, "omc_steps_total", "counter", "Steps taken by the integrator", stats[0]);
+  metricsGauge(buf, "omc_function_evaluations_total", "counter", "Evaluations of functionODE", stats[1]);
+  metricsGauge(buf, "omc_jacobian_evaluations_total", "counter", "Evaluations of the Jacobian", stats[2]);
+  metricsGauge(buf, "omc_error_test_failures_total", "counter", "Steps rejected by the error test", stats[3]);
+  metricsGauge(buf, "omc_convergence_test_failures_total", "counter", "Steps rejected by the convergence test", stats[4]);
+  metricsGauge(buf, "omc_state_events_total", "counter", "State events", solverInfo->stateEvents);
+  metricsGauge(buf, "omc_sample_events_total", "counter", "Sample events", solverInfo->sampleEvents);
+
+  if (modelData->nLinearSystems > 0) {
+    metricsAppend(buf, "# HELP omc_linear_system_calls_total Solver calls of the linear system\n# TYPE omc_linear_system_calls_total counter\n");
+    for (i=0; i<modelData->nLinearSystems; i++) {
+      LINEAR_SYSTEM_DATA *system = &simulationInfo->linearSystemData[i];
+      metricsAppend(buf, "omc_linear_system_calls_total{equation=\"%ld\",size=\"%ld\"} %lu\n", (long) system->equationIndex, (long) system->size, system->numberOfCall);
+    }
+    metricsAppend(buf, "# HELP omc_linear_system_seconds_total Time spent solving the linear system\n# TYPE omc_linear_system_seconds_total counter\n");
+    for (i=0; i<modelData->nLinearSystems; i++) {
+      LINEAR_SYSTEM_DATA *system = &simulationInfo->linearSystemData[i];
+      metricsAppend(buf, "omc_linear_system_seconds_total{equation=\"%ld\",size=\"%ld\"} %.9g\n", (long) system->equationIndex, (long) system->size, system->totalTime);
+    }
+  }
+  if (modelData->nNonLinearSystems > 0) {
+    metricsAppend(buf, "# HELP omc_nonlinear_system_calls_total Solver calls of the non-linear system\n# TYPE omc_nonlinear_system_calls_total counter\n");
+    for (i=0; i<modelData->nNonLinearSystems; i++) {
+      NONLINEAR_SYSTEM_DATA *system = &simulationInfo->nonlinearSystemData[i];
+      metricsAppend(buf, "omc_nonlinear_system_calls_total{equation=\"%ld\",size=\"%ld\"} %lu\n", (long) system->equationIndex, (long) system->size, system->numberOfCall);
+    }
+    metricsAppend(buf, "# HELP omc_nonlinear_system_iterations_total Iterations of the non-linear solver\n# TYPE omc_nonlinear_system_iterations_total counter\n");
+    for (i=0; i<modelData->nNonLinearSystems; i++) {
+      NONLINEAR_SYSTEM_DATA *system = &simulationInfo->nonlinearSystemData[i];
+      metricsAppend(buf, "omc_nonlinear_system_iterations_total{equation=\"%ld\",size=\"%ld\"} %lu\n", (long) system->equationIndex, (long) system->size, system->numberOfIterations);
+    }
+    metricsAppend(buf, "# HELP omc_nonlinear_system_function_evaluations_total Residual evaluations of the non-linear system\n# TYPE omc_nonlinear_system_function_evaluations_total counter\n");
+    for (i=0; i<modelData->nNonLinearSystems; i++) {
+      NONLINEAR_SYSTEM_DATA *system = &simulationInfo->nonlinearSystemData[i];
+      metricsAppend(buf, "omc_nonlinear_system_function_evaluations_total{equation=\"%ld\",size=\"%ld\"} %lu\n", (long) system->equationIndex, (long) system->size, system->numberOfFEval);
+    }
+    metricsAppend(buf, "# HELP omc_nonlinear_system_seconds_total Time spent solving the non-linear system\n# TYPE omc_nonlinear_system_seconds_total counter\n");
+    for (i=0; i<modelData->nNonLinearSystems; i++) {
+      NONLINEAR_SYSTEM_DATA *system = &simulationInfo->nonlinearSystemData[i];
+      metricsAppend(buf, "omc_nonlinear_system_seconds_total{equation=\"%ld\",size=\"%ld\"} %.9g\n", (long) system->equationIndex, (long) system->size, system->totalTime);
+    }
+  }
+
+  if (data->real_time_sync.enabled) {
+    RT_PROFILE_STATS rt;
+    metricsGauge(buf, "omc_real_time_max_lateness_seconds", "gauge", "Maximum lateness of a step, negative is slack", data->real_time_sync.maxLate*1e-9);
+    if (omc_real_time_profile_stats(&rt)) {
+      metricsGauge(buf, "omc_real_time_deadline_misses_total", "counter", "Steps later than the allowed lateness", rt.deadlineMisses);
+      metricsGauge(buf, "omc_real_time_max_jitter_seconds", "gauge", "Maximum change of the lateness between two steps", rt.jitter.max*1e-9);
+      metricsGauge(buf, "omc_real_time_dropped_messages_total", "counter", "Log messages dropped by -rtProfile", rt.droppedMessages);
+    }
+  }
+
+  metricsGauge(buf, "omc_resident_memory_bytes", "gauge", "Resident memory of the process", residentBytes());
+  metricsGauge(buf, "omc_gc_heap_bytes", "gauge", "Size of the garbage collected heap", GC_get_heap_size());
+}
+
+/* answers every connection with the metrics, whatever was requested */
+static void metricsServe(METRICS_SERVER *s, int fd)
+{
+  METRICS_BUFFER buf = {NULL, 0, 0};
+  char header[256], request[1024];
+  struct timeval timeout = {1, 0};
+  size_t sent;
+  ssize_t n;
+
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  /* read the request line of an HTTP client; plain connections send nothing */
+  n = recv(fd, request, sizeof(request), 0);
+
+  buf.size = 16384;
+  buf.str = (char*) malloc(buf.size);
+  buf.str[0] = '\0';
+  metricsCollect(s, &buf);
+  if (n > 0) {
+    snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %ld\r\nConnection: close\r\n\r\n", (long) buf.len);
+    send(fd, header, strlen(header), METRICS_SEND_FLAGS);
+  }
+  for (sent = 0; sent < buf.len; sent += n) {
+    n = send(fd, buf.str + sent, buf.len - sent, METRICS_SEND_FLAGS);
+    if (n <= 0) {
+      break;
+    }
+  }
+  free(buf.str);
+}
+
+static void* metricsThread(void *arg)
+{
+  METRICS_SERVER *s = (METRICS_SERVER*) arg;
+  fd_set fds;
+  int client;
+
+  while (!s->stop) {
+    struct timeval timeout = {0, 1000*METRICS_POLL_MS};
+    FD_ZERO(&fds);
+    FD_SET(s->fd, &fds);
+    if (select(s->fd+1, &fds, NULL, NULL, &timeout) <= 0) {
+      continue;
+    }
+    client = accept(s->fd, NULL, NULL);
+    if (client >= 0) {
+      metricsServe(s, client);
+      close(client);
+    }
+  }
+  return NULL;
+}
+
+static int metricsListen(METRICS_SERVER *s, const char *address)
+{
+  char *end;
+  long port = strtol(address, &end, 10);
+
+  if (*address && *end == '\0') {
+    struct sockaddr_in addr;
+    int on = 1;
+    if (port <= 0 || port > 65535) {
+      warningStreamPrint(LOG_STDOUT, 0, "-metrics: invalid port %s", address);
+      return 1;
+    }
+    s->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (s->fd < 0) {
+      return 1;
+    }
+    setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short) port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(s->fd, (struct sockaddr*) &addr, sizeof(addr))) {
+      return 1;
+    }
+  } else {
+    struct sockaddr_un addr;
+    if (strlen(address) >= sizeof(addr.sun_path)) {
+      warningStreamPrint(LOG_STDOUT, 0, "-metrics: the socket path %s is too long", address);
+      return 1;
+    }
+    s->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s->fd < 0) {
+      return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, address);
+    if (bind(s->fd, (struct sockaddr*) &addr, sizeof(addr))) {
+      /* the socket of an earlier run is removed, the one of another instance that still listens is kept */
+      int bindError = errno, probe, stale = 0;
+      if (bindError == EADDRINUSE && (probe = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0) {
+        stale = connect(probe, (struct sockaddr*) &addr, sizeof(addr)) && errno == ECONNREFUSED;
+        close(probe);
+      }
+      if (!stale) {
+        errno = bindError;
+        return 1;
+      }
+      unlink(address);
+      if (bind(s->fd, (struct sockaddr*) &addr, sizeof(addr))) {
+        return 1;
+      }
+    }
+    s->path = strdup(address);
+  }
+  return listen(s->fd, 8) ? 1 : 0;
+}
+
+METRICS_SERVER* omc_metrics_server_start(DATA *data, SOLVER_INFO *solverInfo)
+{
+  METRICS_SERVER *s;
+
+  if (!omc_flag[FLAG_METRICS]) {
+    return NULL;
+  }
+  s = (METRICS_SERVER*) calloc(1, sizeof(METRICS_SERVER));
+  s->data = data;
+  s->solverInfo = solverInfo;
+  s->fd = -1;
+  rt_ext_tp_tick(&s->started);
+  if (metricsListen(s, omc_flagValue[FLAG_METRICS])) {
+    warningStreamPrint(LOG_STDOUT, 0, "-metrics: could not listen on %s: %s", omc_flagValue[FLAG_METRICS], strerror(errno));
+  } else if (GC_pthread_create(&s->thread, NULL, metricsThread, s)) {
+    warningStreamPrint(LOG_STDOUT, 0, "-metrics: could not start the server thread: %s", strerror(errno));
+  } else {
+    infoStreamPrint(LOG_STDOUT, 0, "Serving metrics on %s%s", s->path ? "" : "127.0.0.1:", omc_flagValue[FLAG_METRICS]);
+    return s;
+  }
+  if (s->fd >= 0) {
+    close(s->fd);
+  }
+  free(s->path);
+  free(s);
+  return NULL;
+}
+
+void omc_metrics_server_stop(METRICS_SERVER *server)
+{
+  if (!server) {
+    return;
+  }
+  server->stop = 1;
+  GC_pthread_join(server->thread, NULL);
+  close(server->fd);
+  if (server->path) {
+    unlink(server->path);
+    free(server->path);
+  }
+  free(server);
+}
+
+#else /* _WIN32 */
+
+METRICS_SERVER* omc_metrics_server_start(DATA *data, SOLVER_INFO *solverInfo)
+{
+  if (omc_flag[FLAG_METRICS]) {
+    warningStreamPrint(LOG_STDOUT, 0, "-metrics is not supported on Windows.");
+  }
+  return NULL;
+}
+
+void omc_metrics_server_stop(METRICS_SERVER *server)
+{
+}
+
+#endif
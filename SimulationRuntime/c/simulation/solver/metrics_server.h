@@ -0,0 +1,59 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file metrics_server.h
+ *
+ *  Description: serves live counters of a running simulation (-metrics)
+ *  in the Prometheus text format. A background thread reads the counters
+ *  the runtime keeps anyway, so the simulation itself does no extra work.
+ */
+
+#ifndef _OMC_METRICS_SERVER_H_
+#define _OMC_METRICS_SERVER_H_
+
+#include "simulation_data.h"
+#include "solver_main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct METRICS_SERVER METRICS_SERVER;
+
+/* starts a server for this model instance if -metrics is given, NULL if it
+ * does not serve; solverInfo must stay valid until omc_metrics_server_stop */
+METRICS_SERVER* omc_metrics_server_start(DATA *data, SOLVER_INFO *solverInfo);
+void omc_metrics_server_stop(METRICS_SERVER *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,6 +40,7 @@
 #include "util/varinfo.h"
 #include "model_help.h"
 #include "simulation/simulation_info_json.h"
+#include "simulation/simulation_input_bin.h"
 #include "util/omc_msvc.h" /* for freaking round! */
 #include "nonlinearSystem.h"
 #include "linearSystem.h"
@@ -53,7 +54,7 @@ double linearSparseSolverMaxDensity = 0.2;
 int linearSparseSolverMinSize = 4001;
 const size_t SIZERINGBUFFER = 3;
 
-static double tolZC;
+static OMC_THREAD_LOCAL double tolZC;
 
 /*! \fn updateDiscreteSystem
  *
@@ -1029,7 +1030,8 @@ void deInitializeDataStruc(DATA *data)
 {
   TRACE_PUSH
   size_t i = 0;
-  int needToFree = !data->callback->read_input_fmu;
+  /* the names of the variables point into the init image if one was mapped */
+  int needToFree = !data->callback->read_input_fmu && !data->modelData->initImage && !data->modelData->sharesStaticData;
 
   /* prepare RingBuffer */
   for(i=0; i<SIZERINGBUFFER; i++)
@@ -1065,6 +1067,10 @@ void deInitializeDataStruc(DATA *data)
   FREE_VARS(nAliasBoolean,booleanAlias)
   FREE_VARS(nAliasString,stringAlias)
 
+  if (!data->callback->read_input_fmu && !data->modelData->sharesStaticData) {
+    free_input_bin(data->modelData);
+  }
+
   omc_alloc_interface.free_uncollectable(data->modelData->samplesInfo);
   free(data->simulationInfo->nextSampleTimes);
   free(data->simulationInfo->samples);
@@ -0,0 +1,398 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file multirate.c
+ *
+ *  One macro step of size H from t0 with the states x0 and derivatives f0:
+ *   1. slow predictor       xs(t) = x0_s + (t-t0)*f0_s
+ *   2. m micro steps h=H/m  ROS2 of the fast states with W = I - gamma*h*J_ff:
+ *        W k1 = h*f_f(t, xs(t), x_f) + gamma*h^2*d
+ *        W k2 = h*f_f(t+h, xs(t+h), x_f+k1) - 2*k1 - gamma*h^2*d
+ *        x_f  = x_f + 3/2*k1 + 1/2*k2
+ *   3. slow corrector       x_s = x0_s + H/2*(f0_s + f_s(t0+H, xs(t0+H), x_f))
+ *  The fast states see the slow ones through the predictor, the slow states
+ *  see the fast ones at the end of the macro step. J_ff is the block of the
+ *  fast states of the Jacobian, which is computed by colored finite
+ *  differences on the sparse pattern of INDEX_JAC_A whenever the states are
+ *  partitioned again. ROS2 (Verwer et al., SIAM J. Sci. Comput. 20, 1999)
+ *  is L-stable with gamma = 1 + 1/sqrt(2) and of second order for any
+ *  approximation of J_ff, so the old Jacobian can be kept between two
+ *  partitions and both the fast and the slow states are of second order.
+ *  d is the derivative of f_f w.r.t. time along the predictor at t0, by a
+ *  forward difference; without it a fast state that follows a time
+ *  dependent input lags behind it by an error that does not decrease
+ *  with the step size.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "multirate.h"
+#include "external_input.h"
+#include "simulation/options.h"
+#include "util/omc_error.h"
+
+extern void dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern void dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+
+/* states with H*|J_i| above this are fast; an explicit step would not be stable for them */
+#define MR_FAST_THRESHOLD 1.0
+/* micro steps are chosen such that h*|J_i| of the fastest state stays below this */
+#define MR_MICRO_STEP_LIMIT 4.0
+/* gamma of ROS2, 1 + 1/sqrt(2) */
+#define MR_GAMMA 1.7071067811865475
+
+static void evalODE(DATA* data, threadData_t *threadData, double time, const double *states)
+{
+  SIMULATION_DATA *sData = data->localData[0];
+  sData->timeValue = time;
+  memcpy(sData->realVars, states, sizeof(double)*data->modelData->nStates);
+  /* read input vars */
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+}
+
+/* uses the sparse pattern of the generated Jacobian A, or a dense one */
+static void initPattern(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr)
+{
+  const int n = mr->nStates;
+  int i, j;
+
+  if (data->callback->initialAnalyticJacobianA(data, threadData) == 0) {
+    SPARSE_PATTERN *pattern = &data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+    mr->leadindex = pattern->leadindex;
+    mr->index = pattern->index;
+    mr->colorCols = pattern->colorCols;
+    mr->maxColors = pattern->maxColors;
+    mr->ownPattern = 0;
+    mr->jacobian = (double*) calloc(pattern->numberOfNoneZeros > 0 ? pattern->numberOfNoneZeros : 1, sizeof(double));
+    return;
+  }
+
+  infoStreamPrint(LOG_SOLVER, 0, "multirate: the sparse pattern is not available, using a dense Jacobian");
+  mr->ownPattern = 1;
+  mr->leadindex = (unsigned int*) malloc(n*sizeof(unsigned int));
+  mr->index = (unsigned int*) malloc(n*n*sizeof(unsigned int));
+  mr->colorCols = (unsigned int*) malloc(n*sizeof(unsigned int));
+  mr->maxColors = n;
+  for (j=0; j<n; j++) {
+    mr->leadindex[j] = (j+1)*n;
+    mr->colorCols[j] = j+1;
+    for (i=0; i<n; i++) {
+      mr->index[j*n+i] = i;
+    }
+  }
+  mr->jacobian = (double*) calloc(n*n, sizeof(double));
+}
+
+int allocateMultirate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  const int n = data->modelData->nStates;
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) calloc(1, sizeof(DATA_MULTIRATE));
+  int i;
+
+  mr->nStates = n;
+  mr->maxRatio = omc_flag[FLAG_MR_RATIO] ? atoi(omc_flagValue[FLAG_MR_RATIO]) : 16;
+  mr->repartition = omc_flag[FLAG_MR_REPARTITION] ? atoi(omc_flagValue[FLAG_MR_REPARTITION]) : 50;
+  if (mr->maxRatio < 1 || mr->repartition < 1) {
+    throwStreamPrint(threadData, "-multirateRatio and -multirateRepartition must be positive");
+  }
+  mr->forcedFast = (modelica_boolean*) calloc(n, sizeof(modelica_boolean));
+  mr->fastStates = (int*) malloc(n*sizeof(int));
+  mr->position = (int*) malloc(n*sizeof(int));
+  mr->matrix = (double*) malloc(n*n*sizeof(double));
+  mr->ipiv = (int*) malloc(n*sizeof(int));
+  mr->rhs = (double*) malloc(n*sizeof(double));
+  mr->k1 = (double*) malloc(n*sizeof(double));
+  mr->dfdt = (double*) malloc(n*sizeof(double));
+  mr->x0 = (double*) malloc(n*sizeof(double));
+  mr->f0 = (double*) malloc(n*sizeof(double));
+  mr->xFast = (double*) malloc(n*sizeof(double));
+  mr->rowSum = (double*) malloc(n*sizeof(double));
+  mr->perturbation = (double*) malloc(n*sizeof(double));
+
+  if (omc_flag[FLAG_MR_FAST]) {
+    char *names = strdup(omc_flagValue[FLAG_MR_FAST]), *name, *saveptr = NULL;
+    for (name = strtok_r(names, ",", &saveptr); name; name = strtok_r(NULL, ",", &saveptr)) {
+      for (i=0; i<n && strcmp(data->modelData->realVarsData[i].info.name, name); i++);
+      if (i<n) {
+        mr->forcedFast[i] = 1;
+      } else {
+        warningStreamPrint(LOG_STDOUT, 0, "-multirateFast: %s is not a state", name);
+      }
+    }
+    free(names);
+  }
+
+  initPattern(data, threadData, mr);
+  /* partitioned at the first step */
+  mr->stepsSincePartition = mr->repartition;
+  solverInfo->solverData = mr;
+  return 0;
+}
+
+int freeMultirate(SOLVER_INFO* solverInfo)
+{
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) solverInfo->solverData;
+  if (mr->ownPattern) {
+    free(mr->leadindex);
+    free(mr->index);
+    free(mr->colorCols);
+  }
+  free(mr->jacobian);
+  free(mr->forcedFast);
+  free(mr->fastStates);
+  free(mr->position);
+  free(mr->matrix);
+  free(mr->ipiv);
+  free(mr->rhs);
+  free(mr->k1);
+  free(mr->dfdt);
+  free(mr->x0);
+  free(mr->f0);
+  free(mr->xFast);
+  free(mr->rowSum);
+  free(mr->perturbation);
+  free(mr);
+  return 0;
+}
+
+/* Jacobian der(x)/x at (t0, x0) by colored forward differences */
+static void computeJacobian(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DATA_MULTIRATE* mr, double t0)
+{
+  const int n = mr->nStates;
+  const double *stateDer = data->localData[0]->realVars + n;
+  const double delta = sqrt(DBL_EPSILON);
+  unsigned int color, j, k, start;
+
+  for (color=1; color<=mr->maxColors; color++) {
+    memcpy(mr->xFast, mr->x0, n*sizeof(double));
+    for (j=0; j<n; j++) {
+      if (mr->colorCols[j] == color) {
+        double h = delta * fmax(fabs(mr->x0[j]), fabs(data->modelData->realVarsData[j].attribute.nominal));
+        mr->xFast[j] += h;
+        mr->perturbation[j] = mr->xFast[j] - mr->x0[j];
+      }
+    }
+    evalODE(data, threadData, t0, mr->xFast);
+    for (j=0; j<n; j++) {
+      if (mr->colorCols[j] == color) {
+        start = j == 0 ? 0 : mr->leadindex[j-1];
+        for (k=start; k<mr->leadindex[j]; k++) {
+          mr->jacobian[k] = (stateDer[mr->index[k]] - mr->f0[mr->index[k]]) / mr->perturbation[j];
+        }
+      }
+    }
+  }
+  solverInfo->solverStatsTmp[1] += mr->maxColors;
+  solverInfo->solverStatsTmp[2] += 1;
+}
+
+/* W = I - gamma*h*J_ff, factorized */
+static void factorizeFast(threadData_t *threadData, DATA_MULTIRATE* mr, double h)
+{
+  const int n = mr->nStates;
+  int nFast = mr->nFast, info = 0;
+  int *position = mr->position;
+  unsigned int j, k, start;
+  int i, row, col;
+
+  if (nFast == 0) {
+    return;
+  }
+  /* position of every state in the fast block, -1 if slow */
+  for (i=0; i<n; i++) {
+    position[i] = -1;
+  }
+  for (i=0; i<nFast; i++) {
+    position[mr->fastStates[i]] = i;
+  }
+  memset(mr->matrix, 0, nFast*nFast*sizeof(double));
+  for (i=0; i<nFast; i++) {
+    mr->matrix[i*nFast+i] = 1.0;
+  }
+  for (j=0; j<n; j++) {
+    col = position[j];
+    if (col < 0) {
+      continue;
+    }
+    start = j == 0 ? 0 : mr->leadindex[j-1];
+    for (k=start; k<mr->leadindex[j]; k++) {
+      row = position[mr->index[k]];
+      if (row >= 0) {
+        mr->matrix[col*nFast+row] -= MR_GAMMA*h*mr->jacobian[k];
+      }
+    }
+  }
+  dgetrf_(&nFast, &nFast, mr->matrix, &nFast, mr->ipiv, &info);
+  if (info != 0) {
+    throwStreamPrint(threadData, "multirate: the matrix of the fast states is singular (dgetrf info %d)", info);
+  }
+}
+
+/* fast states are those whose explicit step would be unstable */
+static void partition(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DATA_MULTIRATE* mr, double t0, double H)
+{
+  const int n = mr->nStates;
+  unsigned int j, k, start;
+  double maxFast = 0;
+  int i, nFastBefore = mr->nFast;
+
+  computeJacobian(data, threadData, solverInfo, mr, t0);
+  for (i=0; i<n; i++) {
+    mr->rowSum[i] = 0;
+  }
+  for (j=0; j<n; j++) {
+    start = j == 0 ? 0 : mr->leadindex[j-1];
+    for (k=start; k<mr->leadindex[j]; k++) {
+      mr->rowSum[mr->index[k]] += fabs(mr->jacobian[k]);
+    }
+  }
+  mr->nFast = 0;
+  for (i=0; i<n; i++) {
+    if (mr->forcedFast[i] || H*mr->rowSum[i] > MR_FAST_THRESHOLD) {
+      mr->fastStates[mr->nFast++] = i;
+      maxFast = fmax(maxFast, mr->rowSum[i]);
+    }
+  }
+  mr->ratio = (int) fmin(mr->maxRatio, fmax(1.0, ceil(H*maxFast/MR_MICRO_STEP_LIMIT)));
+  factorizeFast(threadData, mr, H/mr->ratio);
+  mr->stepsSincePartition = 0;
+  mr->partitionStepSize = H;
+
+  if (mr->nFast != nFastBefore) {
+    infoStreamPrint(LOG_SOLVER, 0, "multirate at time %g: %d of %d states fast, %d micro steps per step", t0, mr->nFast, n, mr->ratio);
+  }
+}
+
+/* derivatives at t with the slow states of the predictor and the fast ones x_f + increment */
+static void evalStage(DATA* data, threadData_t *threadData, DATA_MULTIRATE* mr, double t0, double t, const double *increment)
+{
+  const int n = mr->nStates;
+  int i;
+
+  for (i=0; i<n; i++) {
+    mr->rhs[i] = mr->x0[i] + (t-t0)*mr->f0[i];
+  }
+  for (i=0; i<mr->nFast; i++) {
+    mr->rhs[mr->fastStates[i]] = mr->xFast[mr->fastStates[i]] + (increment ? increment[i] : 0.0);
+  }
+  evalODE(data, threadData, t, mr->rhs);
+}
+
+/*! \fn multirate_step
+ *
+ *  Takes one macro step of solverInfo->currentStepSize. The derivatives
+ *  of the new states are evaluated by the caller.
+ */
+int multirate_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+{
+  DATA_MULTIRATE* mr = (DATA_MULTIRATE*) solverInfo->solverData;
+  const int n = mr->nStates;
+  SIMULATION_DATA *sData = data->localData[0];
+  SIMULATION_DATA *sDataOld = data->localData[1];
+  const double *stateDer = sData->realVars + n;
+  const double t0 = sDataOld->timeValue, H = solverInfo->currentStepSize;
+  double h, t, delta;
+  int i, k, one = 1, info = 0;
+  char trans = 'N';
+
+  memcpy(mr->x0, sDataOld->realVars, n*sizeof(double));
+  memcpy(mr->f0, sDataOld->realVars + n, n*sizeof(double));
+
+  if (solverInfo->didEventStep || mr->stepsSincePartition >= mr->repartition) {
+    partition(data, threadData, solverInfo, mr, t0, H);
+  } else if (fabs(H - mr->partitionStepSize) > 1e-12*fabs(H)) {
+    /* e.g. the last step before stopTime; keep the partition */
+    factorizeFast(threadData, mr, H/mr->ratio);
+    mr->partitionStepSize = H;
+  }
+  mr->stepsSincePartition++;
+  h = H / mr->ratio;
+
+  /* fast states; the first stage of the first micro step uses the derivatives at t0 */
+  memcpy(mr->xFast, mr->x0, n*sizeof(double));
+  if (mr->nFast > 0) {
+    /* d, the slow states move along the predictor */
+    delta = sqrt(DBL_EPSILON) * fmax(fabs(t0), 1.0);
+    delta = (t0 + delta) - t0;
+    evalStage(data, threadData, mr, t0, t0 + delta, NULL);
+    for (i=0; i<mr->nFast; i++) {
+      mr->dfdt[i] = (stateDer[mr->fastStates[i]] - mr->f0[mr->fastStates[i]]) / delta;
+    }
+  }
+  for (k=0; k<mr->ratio && mr->nFast > 0; k++) {
+    const double *f = mr->f0;
+    t = t0 + k*h;
+    if (k > 0) {
+      evalStage(data, threadData, mr, t0, t, NULL);
+      f = stateDer;
+    }
+    for (i=0; i<mr->nFast; i++) {
+      mr->k1[i] = h*f[mr->fastStates[i]] + MR_GAMMA*h*h*mr->dfdt[i];
+    }
+    dgetrs_(&trans, &mr->nFast, &one, mr->matrix, &mr->nFast, mr->ipiv, mr->k1, &mr->nFast, &info);
+    evalStage(data, threadData, mr, t0, t + h, mr->k1);
+    for (i=0; i<mr->nFast; i++) {
+      mr->rhs[i] = h*stateDer[mr->fastStates[i]] - 2.0*mr->k1[i] - MR_GAMMA*h*h*mr->dfdt[i];
+    }
+    dgetrs_(&trans, &mr->nFast, &one, mr->matrix, &mr->nFast, mr->ipiv, mr->rhs, &mr->nFast, &info);
+    for (i=0; i<mr->nFast; i++) {
+      mr->xFast[mr->fastStates[i]] += 1.5*mr->k1[i] + 0.5*mr->rhs[i];
+    }
+  }
+
+  /* slow states: predictor, derivatives at t0+H with the new fast states, corrector */
+  for (i=0; i<n; i++) {
+    mr->rhs[i] = mr->x0[i] + H*mr->f0[i];
+  }
+  for (i=0; i<mr->nFast; i++) {
+    mr->rhs[mr->fastStates[i]] = mr->xFast[mr->fastStates[i]];
+  }
+  evalODE(data, threadData, t0 + H, mr->rhs);
+  for (i=0; i<n; i++) {
+    sData->realVars[i] = mr->x0[i] + 0.5*H*(mr->f0[i] + stateDer[i]);
+  }
+  for (i=0; i<mr->nFast; i++) {
+    sData->realVars[mr->fastStates[i]] = mr->xFast[mr->fastStates[i]];
+  }
+  solverInfo->currentTime = t0 + H;
+  sData->timeValue = solverInfo->currentTime;
+
+  /* save stats */
+  /* steps */
+  solverInfo->solverStatsTmp[0] += 1;
+  /* function ODE evaluation is done directly after this */
+  solverInfo->solverStatsTmp[1] += (mr->nFast > 0 ? 2*mr->ratio : 0) + 1;
+
+  return 0;
+}
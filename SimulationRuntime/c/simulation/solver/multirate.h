@@ -0,0 +1,95 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file multirate.h
+ *
+ *  Multirate solver (-s=multirate) for models whose states live on very
+ *  different time scales. The states are partitioned by the magnitude of
+ *  their rows of the Jacobian der(x)/x: slow states are integrated
+ *  explicitly with the macro step, fast states with linearly implicit
+ *  micro steps (ROS2) that see the slow states interpolated over the macro
+ *  step.
+ */
+
+#ifndef _MULTIRATE_H_
+#define _MULTIRATE_H_
+
+#include "simulation_data.h"
+#include "solver_main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DATA_MULTIRATE
+{
+  int nStates;
+  /* sparsity of der(x) w.r.t. x in compressed columns, see SPARSE_PATTERN */
+  unsigned int *leadindex;
+  unsigned int *index;
+  unsigned int *colorCols;
+  unsigned int maxColors;
+  int ownPattern;                      /* the pattern was not generated, all entries are used */
+  double *jacobian;                    /* values of the pattern entries */
+
+  /* partition */
+  modelica_boolean *forcedFast;        /* -multirateFast */
+  int *fastStates;                     /* indexes of the fast states */
+  int *position;                       /* position of a state in the fast block, -1 if slow */
+  int nFast;
+  int ratio;                           /* micro steps per macro step */
+  int maxRatio;
+  int repartition;                     /* macro steps between two partitions */
+  int stepsSincePartition;
+  double partitionStepSize;
+
+  /* ROS2 of the fast states: W = I - gamma*h*J_ff */
+  double *matrix;                      /* LU factors of W, nFast x nFast */
+  int *ipiv;
+  double *rhs;                         /* second stage, or the states of an evaluation */
+  double *k1;                          /* first stage */
+  double *dfdt;                        /* time derivative of f_f at t0 */
+
+  double *x0;
+  double *f0;
+  double *xFast;
+  double *rowSum;
+  double *perturbation;
+} DATA_MULTIRATE;
+
+int allocateMultirate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+int freeMultirate(SOLVER_INFO* solverInfo);
+int multirate_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MULTIRATE_H_ */
@@ -42,6 +42,7 @@
 
 #include "util/list.h"
 #include "util/omc_error.h"
+#include "util/omc_trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -171,6 +172,7 @@ void addListElement(VALUES_LIST* valuesList, VALUE* newElem)
   /* debug output */
   infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "Adding element in a list of size %d", listLen(valuesList->valueList));
   printValueElement(newElem);
+  OMC_TRACE(LOG_NLS_EXTRAPOLATE, OMC_TRACE_NLS_VALUES_ADD, 2, newElem->time, listLen(valuesList->valueList), 0, 0);
 
   /*  if it's empty, just push in  */
   if (listLen(valuesList->valueList) == 0)
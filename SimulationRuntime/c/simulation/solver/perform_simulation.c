@@ -31,9 +31,11 @@
 #include "solver_main.h"
 #include "events.h"
 #include "dassl.h"
+#include "checkpoint.h"
 
 #include "simulation/simulation_runtime.h"
 #include "simulation/results/simulation_result.h"
+#include "simulation/profile_aggregate.h"
 #include "openmodelica_func.h"
 #include "linearSystem.h"
 #include "nonlinearSystem.h"
@@ -52,6 +54,7 @@
 #if !defined(OMC_MINIMAL_RUNTIME)
 #include "simulation/solver/embedded_server.h"
 #include "simulation/solver/real_time_sync.h"
+#include "simulation/solver/real_time_profile.h"
 #endif
 
 /*! \fn updateContinuousSystem
@@ -76,7 +79,79 @@ static void prefixedName_updateContinuousSystem(DATA *data, threadData_t *thread
   TRACE_POP
 }
 
-static int simulationUpdate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
+/* time of the output point stepNo of the equidistant grid */
+static double outputGridTime(SIMULATION_INFO *simInfo, unsigned int stepNo)
+{
+  return (double)(stepNo*(simInfo->stopTime-simInfo->startTime))/(simInfo->numSteps) + simInfo->startTime;
+}
+
+typedef struct DENSE_OUTPUT {
+  unsigned int *stepNo;                /* last emitted output point */
+  double *realVarsBackup;              /* variables at the end of the step while output points are interpolated */
+  modelica_boolean *relationsBackup;
+} DENSE_OUTPUT;
+
+static void denseOutputInit(DATA* data, DENSE_OUTPUT* dense, unsigned int *stepNo)
+{
+  dense->stepNo = stepNo;
+  dense->realVarsBackup = (double*) malloc(data->modelData->nVariablesReal*sizeof(double));
+  dense->relationsBackup = (modelica_boolean*) malloc(data->modelData->nRelations*sizeof(modelica_boolean));
+}
+
+static void denseOutputFree(DENSE_OUTPUT* dense)
+{
+  free(dense->realVarsBackup);
+  free(dense->relationsBackup);
+}
+
+/*! \fn emitDenseOutput
+ *
+ *  Emits the output points that lie inside the last solver step and before
+ *  the current time, which is the end of the step or the event found in it.
+ *  The states are interpolated by the solver and all other continuous
+ *  variables are recomputed from them. Output points at the current time are
+ *  left to the regular emit after the event handling.
+ */
+static void emitDenseOutput(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DENSE_OUTPUT* dense)
+{
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  SIMULATION_DATA *sData = data->localData[0];
+  double stepEnd = sData->timeValue;
+  double eps = 1e-10 * simInfo->stepSize;
+  double gridTime = outputGridTime(simInfo, *dense->stepNo + 1);
+
+  if (gridTime >= stepEnd - eps || *dense->stepNo >= simInfo->numSteps) {
+    return;
+  }
+
+  memcpy(dense->realVarsBackup, sData->realVars, data->modelData->nVariablesReal*sizeof(double));
+  memcpy(dense->relationsBackup, simInfo->relations, data->modelData->nRelations*sizeof(modelica_boolean));
+  while (gridTime < stepEnd - eps && *dense->stepNo < simInfo->numSteps)
+  {
+    solver_main_interpolate(data, solverInfo, gridTime, sData->realVars, sData->realVars + data->modelData->nStates);
+    sData->timeValue = gridTime;
+
+    externalInputUpdate(data);
+    data->callback->input_function(data, threadData);
+    data->callback->functionODE(data, threadData);
+    data->callback->functionAlgebraics(data, threadData);
+    data->callback->output_function(data, threadData);
+    sim_result.emit(&sim_result, data, threadData);
+
+    (*dense->stepNo)++;
+    gridTime = outputGridTime(simInfo, *dense->stepNo + 1);
+  }
+  memcpy(sData->realVars, dense->realVarsBackup, data->modelData->nVariablesReal*sizeof(double));
+  memcpy(simInfo->relations, dense->relationsBackup, data->modelData->nRelations*sizeof(modelica_boolean));
+  sData->timeValue = stepEnd;
+  externalInputUpdate(data);
+}
+
+/*! \fn simulationUpdate
+ *
+ *  \param [ref] [denseOutput] NULL if the output points are not interpolated
+ */
+static int simulationUpdate(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, DENSE_OUTPUT* denseOutput)
 {
   prefixedName_updateContinuousSystem(data, threadData);
 
@@ -92,6 +167,14 @@ static int simulationUpdate(DATA* data, threadData_t *threadData, SOLVER_INFO* s
   do
   {
     int eventType = checkEvents(data, threadData, solverInfo->eventLst, !solverInfo->solverRootFinding, /*out*/ &solverInfo->currentTime);
+    /* Without root finding in the solver, the step may have passed a state
+     * event. The output points after it are only valid once the event has
+     * been handled and are emitted by the next steps. */
+    if (denseOutput)
+    {
+      emitDenseOutput(data, threadData, solverInfo, denseOutput);
+      denseOutput = NULL;
+    }
     if(eventType > 0 || syncRet == 2) /* event */
     {
       threadData->currentErrorStage = ERROR_EVENTHANDLING;
@@ -157,7 +240,12 @@ static void fmtInit(DATA* data, MEASURE_TIME* mt)
 {
   mt->fmtReal = NULL;
   mt->fmtInt = NULL;
-  if(measure_time_flag)
+  if(measure_time_flag && !omc_flag[FLAG_MEASURETIME_RAW])
+  {
+    double windowSize = omc_flag[FLAG_MEASURETIME_WINDOW] ? atof(omc_flagValue[FLAG_MEASURETIME_WINDOW]) : 0;
+    prof_aggregate_init(data->modelData->modelDataXml.nFunctions + data->modelData->modelDataXml.nProfileBlocks, SIM_TIMER_FIRST_FUNCTION, windowSize);
+  }
+  else if(measure_time_flag)
   {
     size_t len = strlen(data->modelData->modelFilePrefix);
     char* filename = (char*) malloc((len+15) * sizeof(char));
@@ -180,9 +268,16 @@ static void fmtInit(DATA* data, MEASURE_TIME* mt)
   }
 }
 
-static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt, int didEventStep)
+static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt, int didEventStep, int emitResult)
 {
-  if(mt->fmtReal)
+  if(prof_aggregate_active())
+  {
+    rt_tick(SIM_TIMER_OVERHEAD);
+    rt_accumulate(SIM_TIMER_STEP);
+    prof_aggregate_step(data->localData[0]->timeValue, rt_accumulated(SIM_TIMER_STEP));
+    rt_accumulate(SIM_TIMER_OVERHEAD);
+  }
+  else if(mt->fmtReal)
   {
     int i, flag=1;
     double tmpdbl;
@@ -215,7 +310,7 @@ static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt,
   }
 
   /* prevent emit if noEventEmit flag is used, if it's an event */
-  if ((omc_flag[FLAG_NOEVENTEMIT] && didEventStep == 0) || !omc_flag[FLAG_NOEVENTEMIT]) {
+  if (emitResult && ((omc_flag[FLAG_NOEVENTEMIT] && didEventStep == 0) || !omc_flag[FLAG_NOEVENTEMIT])) {
     sim_result.emit(&sim_result, data, threadData);
   }
 #if !defined(OMC_MINIMAL_RUNTIME)
@@ -224,6 +319,7 @@ static void fmtEmitStep(DATA* data, threadData_t *threadData, MEASURE_TIME* mt,
     double time = data->localData[0]->timeValue;
     int64_t res = rt_ext_tp_sync_nanosec(&data->real_time_sync.clock, (uint64_t) (data->real_time_sync.scaling*(time-data->real_time_sync.time)*1e9));
     int64_t maxLateNano = data->simulationInfo->stepSize*1e9*0.1*data->real_time_sync.scaling /* Maximum late time: 10% of step size */;
+    omc_real_time_profile_step(res, maxLateNano);
     if (res > maxLateNano) {
       int t=0,tMaxLate=0;
       const char *unit = prettyPrintNanoSec(res, &t);
@@ -292,6 +388,136 @@ static void retrySimulationStep(DATA* data, threadData_t *threadData, SOLVER_INF
   solverInfo->didEventStep = 1;
 }
 
+/* number of times a zero crossing is evaluated at to find time events ahead */
+#define STEADY_STATE_PROBES 16
+
+typedef struct STEADY_STATE {
+  double tolerance;                    /* 0 if steady-state detection is disabled */
+  double window;
+  double since;                        /* time since the states are below the tolerance, NAN if not */
+  double *realVarsBackup;              /* variables while zero crossings are evaluated ahead */
+  double *zeroCrossings;
+} STEADY_STATE;
+
+static void steadyStateInit(DATA* data, STEADY_STATE* ss)
+{
+  MODEL_DATA *mData = data->modelData;
+
+  ss->tolerance = omc_flag[FLAG_STEADY_STATE] ? atof(omc_flagValue[FLAG_STEADY_STATE]) : 0.0;
+  ss->window = omc_flag[FLAG_STEADY_STATE_WINDOW] ? atof(omc_flagValue[FLAG_STEADY_STATE_WINDOW]) : 10.0*data->simulationInfo->stepSize;
+  ss->since = NAN;
+  ss->realVarsBackup = NULL;
+  ss->zeroCrossings = NULL;
+
+  if (omc_flag[FLAG_STEADY_STATE] && ss->tolerance <= 0.0) {
+    warningStreamPrint(LOG_STDOUT, 0, "-steadyState=%s is not a positive tolerance, steady-state detection is disabled", omc_flagValue[FLAG_STEADY_STATE]);
+    ss->tolerance = 0.0;
+  } else if (ss->tolerance > 0.0 && (0 == mData->nStates || (1 == mData->nStates && !strcmp(mData->realVarsData[0].info.name, "$dummy")))) {
+    warningStreamPrint(LOG_STDOUT, 0, "-steadyState needs a model with states, steady-state detection is disabled");
+    ss->tolerance = 0.0;
+  }
+
+  if (ss->tolerance > 0.0) {
+    ss->realVarsBackup = (double*) malloc(mData->nVariablesReal*sizeof(double));
+    ss->zeroCrossings = (double*) malloc(2*mData->nZeroCrossings*sizeof(double));
+  }
+}
+
+static void steadyStateFree(STEADY_STATE* ss)
+{
+  free(ss->realVarsBackup);
+  free(ss->zeroCrossings);
+}
+
+/*! \fn steadyStateTimeEventPending
+ *
+ *  Constant states do not rule out events that only depend on time. Returns 1
+ *  if a sample or a clock is due before the stop time, or if a zero crossing
+ *  changes its sign when the model is evaluated at later times with the
+ *  current states. Without a stop time any remaining sample or clock counts,
+ *  and the zero crossings are evaluated over the next STEADY_STATE_PROBES
+ *  windows.
+ */
+static int steadyStateTimeEventPending(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, STEADY_STATE* ss)
+{
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_DATA *sData = data->localData[0];
+  double *gNow = ss->zeroCrossings, *gAhead = ss->zeroCrossings + mData->nZeroCrossings;
+  double horizon = simInfo->useStopTime ? simInfo->stopTime : solverInfo->currentTime + STEADY_STATE_PROBES*ss->window;
+  int k, pending = 0;
+  long i;
+
+  if (mData->nSamples > 0 && (!simInfo->useStopTime || simInfo->nextSampleEvent <= simInfo->stopTime)) {
+    infoStreamPrint(LOG_SOLVER, 0, "steady-state detection: sample event pending at time %g", simInfo->nextSampleEvent);
+    return 1;
+  }
+  if (simInfo->intvlTimers && listLen(simInfo->intvlTimers) > 0) {
+    infoStreamPrint(LOG_SOLVER, 0, "steady-state detection: clock tick pending");
+    return 1;
+  }
+  if (0 == mData->nZeroCrossings) {
+    return 0;
+  }
+
+  memcpy(ss->realVarsBackup, sData->realVars, mData->nVariablesReal*sizeof(double));
+  data->callback->function_ZeroCrossings(data, threadData, gNow);
+  for (k=1; k<=STEADY_STATE_PROBES && !pending; ++k) {
+    sData->timeValue = solverInfo->currentTime + k*(horizon - solverInfo->currentTime)/STEADY_STATE_PROBES;
+    externalInputUpdate(data);
+    data->callback->input_function(data, threadData);
+    data->callback->function_ZeroCrossingsEquations(data, threadData);
+    data->callback->function_ZeroCrossings(data, threadData, gAhead);
+    for (i=0; i<mData->nZeroCrossings; ++i) {
+      if ((gNow[i] > 0.0) != (gAhead[i] > 0.0)) {
+        infoStreamPrint(LOG_SOLVER, 0, "steady-state detection: zero crossing %ld changes its sign until time %g", i, sData->timeValue);
+        pending = 1;
+        break;
+      }
+    }
+    memcpy(sData->realVars, ss->realVarsBackup, mData->nVariablesReal*sizeof(double));
+  }
+  sData->timeValue = solverInfo->currentTime;
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  return pending;
+}
+
+/*! \fn steadyStateReached
+ *
+ *  Checks the root mean square of der(x)/nominal(x) after a step. It returns 1
+ *  if it has stayed below the tolerance for the whole window without events
+ *  and no time event is pending.
+ */
+static int steadyStateReached(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, STEADY_STATE* ss, modelica_boolean syncStep)
+{
+  MODEL_DATA *mData = data->modelData;
+  const double *der = data->localData[0]->realVars + mData->nStates;
+  double norm = 0.0;
+  long i;
+
+  if (solverInfo->didEventStep || syncStep) {
+    ss->since = NAN;
+    return 0;
+  }
+
+  for (i=0; i<mData->nStates; ++i) {
+    double d = der[i] / fmax(fabs(mData->realVarsData[i].attribute.nominal), 1e-32);
+    norm += d*d;
+  }
+  norm = sqrt(norm / mData->nStates);
+
+  if (norm >= ss->tolerance) {
+    ss->since = NAN;
+    return 0;
+  }
+  if (isnan(ss->since)) {
+    ss->since = solverInfo->currentTime;
+    infoStreamPrint(LOG_SOLVER, 0, "steady-state detection: states below tolerance since time %g (norm %g)", ss->since, norm);
+  }
+  return solverInfo->currentTime - ss->since >= ss->window && !steadyStateTimeEventPending(data, threadData, solverInfo, ss);
+}
+
 static void saveIntegratorStats(SOLVER_INFO* solverInfo)
 {
   int ui;
@@ -322,16 +548,32 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
   unsigned int __currStepNo = 0;
 
   SIMULATION_INFO *simInfo = data->simulationInfo;
-  solverInfo->currentTime = simInfo->startTime;
+  modelica_boolean syncStep = 0;
+  modelica_boolean emitResult = 1;
+  modelica_boolean steadyStateEnded = 0;
+  DENSE_OUTPUT denseOutput;
+
+  /* a restored checkpoint continues the loop where it was written */
+  if(solverInfo->restarted) {
+    __currStepNo = solverInfo->stepNo;
+    syncStep = solverInfo->syncStep;
+  } else {
+    solverInfo->currentTime = simInfo->startTime;
+  }
 
   MEASURE_TIME fmt;
   fmtInit(data, &fmt);
 
+  STEADY_STATE steadyState;
+  steadyStateInit(data, &steadyState);
+
+  if (solverInfo->solverDenseOutput) {
+    denseOutputInit(data, &denseOutput, &__currStepNo);
+  }
+
   printAllVarsDebug(data, 0, LOG_DEBUG); /* ??? */
   printSparseStructure(data, LOG_SOLVER);
 
-  modelica_boolean syncStep = 0;
-
   /***** Start main simulation loop *****/
   while(solverInfo->currentTime < simInfo->stopTime || !simInfo->useStopTime)
   {
@@ -369,11 +611,16 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
               solverInfo->currentStepSize = (double)(__currStepNo*(simInfo->stopTime-simInfo->startTime))/(simInfo->numSteps) + simInfo->startTime - solverInfo->currentTime;
             } while(solverInfo->currentStepSize <= 0);
           }
-        } else {
+        } else if (!solverInfo->solverDenseOutput) {
           __currStepNo++;
         }
       }
-      solverInfo->currentStepSize = (double)(__currStepNo*(simInfo->stopTime-simInfo->startTime))/(simInfo->numSteps) + simInfo->startTime - solverInfo->currentTime;
+      if (solverInfo->solverDenseOutput) {
+        /* the solver takes its natural steps, the output points are interpolated */
+        solverInfo->currentStepSize = simInfo->stopTime - solverInfo->currentTime;
+      } else {
+        solverInfo->currentStepSize = (double)(__currStepNo*(simInfo->stopTime-simInfo->startTime))/(simInfo->numSteps) + simInfo->startTime - solverInfo->currentTime;
+      }
       solverInfo->lastdesiredStep = solverInfo->currentTime + solverInfo->currentStepSize;
 
       /* if retry reduce stepsize */
@@ -389,7 +636,9 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
       /* if regular output point and last time events are almost equals
        * skip that step and go further */
       if (solverInfo->currentStepSize < 1e-15 && syncEventStep){
-        __currStepNo++;
+        if (!solverInfo->solverDenseOutput) {
+          __currStepNo++;
+        }
         continue;
       }
 
@@ -403,10 +652,18 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
       messageClose(LOG_SOLVER);
 
       if (S_OPTIMIZATION == solverInfo->solverMethod) break;
-      syncStep = simulationUpdate(data, threadData, solverInfo);
+      syncStep = simulationUpdate(data, threadData, solverInfo, solverInfo->solverDenseOutput ? &denseOutput : NULL);
       retry = 0; /* reset retry */
 
-      fmtEmitStep(data, threadData, &fmt, solverInfo->didEventStep);
+      /* with dense output only events and output points at the end of the step are emitted */
+      if (solverInfo->solverDenseOutput) {
+        emitResult = solverInfo->didEventStep;
+        if (__currStepNo < simInfo->numSteps && solverInfo->currentTime >= outputGridTime(simInfo, __currStepNo + 1) - 1e-10 * simInfo->stepSize) {
+          __currStepNo++;
+          emitResult = 1;
+        }
+      }
+      fmtEmitStep(data, threadData, &fmt, solverInfo->didEventStep, emitResult);
       saveIntegratorStats(solverInfo);
       checkSimulationTerminated(data, solverInfo);
 
@@ -432,6 +689,18 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
         infoStreamPrint(LOG_STDOUT, 0, "model terminate | mixed system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
         break;
       }
+
+      if (steadyState.tolerance > 0.0 && steadyStateReached(data, threadData, solverInfo, &steadyState, syncStep)) {
+        infoStreamPrint(LOG_STDOUT, 0, "model terminate | Steady state reached at time %g (settled since %g) | Simulation terminated at time %g", solverInfo->currentTime, steadyState.since, solverInfo->currentTime);
+        simInfo->stopTime = solverInfo->currentTime;
+        steadyStateEnded = 1;
+      }
+
+      solverInfo->stepNo = __currStepNo;
+      solverInfo->syncStep = syncStep;
+      if (solverInfo->currentTime >= solverInfo->nextCheckpoint) {
+        checkpointStep(data, solverInfo);
+      }
       success = 1;
     }
 #if !defined(OMC_EMCC)
@@ -447,11 +716,19 @@ int prefixedName_performSimulation(DATA* data, threadData_t *threadData, SOLVER_
         break;
       }
     }
+    /* the loop does not test the stop time if useStopTime is not set */
+    if (steadyStateEnded) {
+      break;
+    }
 
     TRACE_POP /* pop loop */
   } /* end while solver */
 
   fmtClose(&fmt);
+  if (solverInfo->solverDenseOutput) {
+    denseOutputFree(&denseOutput);
+  }
+  steadyStateFree(&steadyState);
 
   TRACE_POP
   return retValue;
@@ -0,0 +1,590 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file real_time_profile.c
+ *
+ *  The simulation thread must not block on file output or on the console
+ *  while it runs in real time. Log messages therefore go through a bounded
+ *  multi-producer queue (a message is dropped if it is full) and result
+ *  points through a single-producer ring to background threads, which call
+ *  the original message functions and the original result emitter.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1 /* sched_setaffinity */
+#endif
+
+#include "real_time_profile.h"
+#include "simulation/options.h"
+#include "simulation/results/simulation_result.h"
+#include "simulation/simulation_runtime.h"
+#include "util/omc_error.h"
+#include "util/rtclock.h"
+#include "meta/meta_modelica.h"
+#include "meta/gc/mmc_gc.h"
+
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define RT_PROFILE_CAS(ptr, old, new) (InterlockedCompareExchange64((LONG64*)(ptr), (new), (old)) == (old))
+#define RT_PROFILE_FETCH_ADD(ptr, n) InterlockedExchangeAdd64((LONG64*)(ptr), (n))
+#define RT_PROFILE_BARRIER() MemoryBarrier()
+#define RT_PROFILE_SLEEP_MS(ms) Sleep(ms)
+#else
+#define RT_PROFILE_CAS(ptr, old, new) __sync_bool_compare_and_swap((ptr), (old), (new))
+#define RT_PROFILE_FETCH_ADD(ptr, n) __sync_fetch_and_add((ptr), (n))
+#define RT_PROFILE_BARRIER() __sync_synchronize()
+#define RT_PROFILE_SLEEP_MS(ms) usleep(1000*(ms))
+#endif
+#define RT_PROFILE_READ(ptr) RT_PROFILE_FETCH_ADD((ptr), 0)
+
+#define RT_LOG_QUEUE_SIZE 256           /* power of two */
+#define RT_LOG_MSG_SIZE 2048
+#define RT_LOG_MAX_INDEXES 32
+#define RT_OUTPUT_ROWS 256
+#define RT_STACK_PREFAULT (256*1024)
+
+enum RT_LOG_KIND
+{
+  RT_LOG_MESSAGE = 0,
+  RT_LOG_CLOSE,
+  RT_LOG_CLOSE_WARNING
+};
+
+typedef struct RT_LOG_SLOT
+{
+  volatile uint64_t sequence;
+  int kind;
+  int type;
+  int stream;
+  int indentNext;
+  int subline;
+  int hasIndexes;
+  int indexes[RT_LOG_MAX_INDEXES+1];
+  char msg[RT_LOG_MSG_SIZE];
+} RT_LOG_SLOT;
+
+typedef struct RT_PROFILE
+{
+  volatile int active;
+  volatile int stopWriter;
+  volatile int stopLogger;
+  RT_PROFILE_STATS stats;
+  int64_t lastLateness;                 /* only used by the simulation thread */
+
+  /* log messages; many producers, the logger thread consumes */
+  RT_LOG_SLOT *log;
+  volatile uint64_t logTail;
+  uint64_t logHead;
+  int *logStreams;
+  void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes);
+  void (*messageClose)(int stream);
+  void (*messageCloseWarning)(int stream);
+  pthread_t logger;
+  int hasLogger;
+
+  /* result points; the simulation thread produces, the writer thread consumes */
+  SIMULATION_DATA *rows;
+  double *rowCpuTimes;                  /* taken by the simulation thread, see sim_result_cpuTime */
+  void *rowMemory;
+  volatile uint64_t rowTail;
+  volatile uint64_t rowHead;
+  simulation_result *result;
+  void (*emit)(struct simulation_result*,DATA*,threadData_t *threadData);
+  DATA shadowData;
+  SIMULATION_DATA *shadowLocal;
+  volatile int writerFailed;
+  pthread_t writer;
+  int hasWriter;
+} RT_PROFILE;
+
+static RT_PROFILE profile;
+
+static void histogramAdd(RT_PROFILE_HISTOGRAM *h, uint64_t v)
+{
+  uint64_t max;
+  int i = 0;
+  uint64_t x = v;
+
+  while (x && i < RT_PROFILE_BUCKETS-1) {
+    x >>= 1;
+    i++;
+  }
+  RT_PROFILE_FETCH_ADD(&h->bucket[i], 1);
+  RT_PROFILE_FETCH_ADD(&h->sum, v);
+  RT_PROFILE_FETCH_ADD(&h->count, 1);
+  do {
+    max = h->max;
+  } while (v > max && !RT_PROFILE_CAS(&h->max, max, v));
+}
+
+static void histogramCopy(RT_PROFILE_HISTOGRAM *dst, RT_PROFILE_HISTOGRAM *src)
+{
+  int i;
+  dst->count = RT_PROFILE_READ(&src->count);
+  dst->sum = RT_PROFILE_READ(&src->sum);
+  dst->max = RT_PROFILE_READ(&src->max);
+  for (i=0; i<RT_PROFILE_BUCKETS; i++) {
+    dst->bucket[i] = RT_PROFILE_READ(&src->bucket[i]);
+  }
+}
+
+/* upper bound of the bucket that holds the given fraction of the samples */
+static uint64_t histogramPercentile(const RT_PROFILE_HISTOGRAM *h, double p)
+{
+  uint64_t n = 0, limit = (uint64_t) (p*h->count);
+  int i;
+  for (i=0; i<RT_PROFILE_BUCKETS-1; i++) {
+    n += h->bucket[i];
+    if (n > limit) {
+      uint64_t bound = i == 0 ? 0 : ((uint64_t)1) << i;
+      return bound < h->max ? bound : h->max;
+    }
+  }
+  return h->max;
+}
+
+/* === log messages === */
+
+static int logEnqueue(int kind, int type, int stream, int indentNext, const char *msg, int subline, const int *indexes)
+{
+  RT_LOG_SLOT *slot;
+  uint64_t pos = profile.logTail, seq;
+  int i, n;
+
+  while (1) {
+    slot = &profile.log[pos & (RT_LOG_QUEUE_SIZE-1)];
+    seq = slot->sequence;
+    RT_PROFILE_BARRIER();
+    if (seq == pos) {
+      if (RT_PROFILE_CAS(&profile.logTail, pos, pos+1)) {
+        break;
+      }
+    } else if ((int64_t)(seq - pos) < 0) {
+      RT_PROFILE_FETCH_ADD(&profile.stats.droppedMessages, 1);
+      return 1;
+    }
+    pos = profile.logTail;
+  }
+
+  slot->kind = kind;
+  slot->type = type;
+  slot->stream = stream;
+  slot->indentNext = indentNext;
+  slot->subline = subline;
+  slot->hasIndexes = indexes != NULL;
+  if (indexes) {
+    n = indexes[0] < RT_LOG_MAX_INDEXES ? indexes[0] : RT_LOG_MAX_INDEXES;
+    slot->indexes[0] = n;
+    for (i=1; i<=n; i++) {
+      slot->indexes[i] = indexes[i];
+    }
+  }
+  if (msg) {
+    strncpy(slot->msg, msg, RT_LOG_MSG_SIZE-1);
+    slot->msg[RT_LOG_MSG_SIZE-1] = '\0';
+  }
+  RT_PROFILE_BARRIER();
+  slot->sequence = pos+1;
+  return 0;
+}
+
+static int logDequeue(void)
+{
+  RT_LOG_SLOT *slot = &profile.log[profile.logHead & (RT_LOG_QUEUE_SIZE-1)];
+
+  if (slot->sequence != profile.logHead+1) {
+    return 0;
+  }
+  RT_PROFILE_BARRIER();
+  switch (slot->kind) {
+  case RT_LOG_CLOSE:
+    profile.messageClose(slot->stream);
+    break;
+  case RT_LOG_CLOSE_WARNING:
+    profile.messageCloseWarning(slot->stream);
+    break;
+  default:
+    profile.messageFunction(slot->type, slot->stream, slot->indentNext, slot->msg, slot->subline, slot->hasIndexes ? slot->indexes : NULL);
+  }
+  RT_PROFILE_BARRIER();
+  slot->sequence = profile.logHead + RT_LOG_QUEUE_SIZE;
+  profile.logHead++;
+  return 1;
+}
+
+static void rtMessageFunction(int type, int stream, int indentNext, char *msg, int subline, const int *indexes)
+{
+  logEnqueue(RT_LOG_MESSAGE, type, stream, indentNext, msg, subline, indexes);
+}
+
+static void rtMessageClose(int stream)
+{
+  /* the stream is checked by the original function on the logger thread */
+  logEnqueue(RT_LOG_CLOSE, 0, stream, 0, NULL, 0, NULL);
+}
+
+static void rtMessageCloseWarning(int stream)
+{
+  logEnqueue(RT_LOG_CLOSE_WARNING, 0, stream, 0, NULL, 0, NULL);
+}
+
+static void* loggerThread(void *arg)
+{
+  int stop;
+#if defined(__linux__)
+  struct sched_param param = {.sched_priority = 0};
+  sched_setscheduler(0, SCHED_OTHER, &param);
+#endif
+  /* print with the log flags of the simulation thread */
+  useStream = profile.logStreams;
+  while (1) {
+    stop = profile.stopLogger;
+    RT_PROFILE_BARRIER();
+    if (!logDequeue()) {
+      if (stop) {
+        break;
+      }
+      RT_PROFILE_SLEEP_MS(1);
+    }
+  }
+  return NULL;
+}
+
+/* === result output === */
+
+static void rtEmit(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  const MODEL_DATA *modelData = data->modelData;
+  SIMULATION_DATA *src = data->localData[0], *row;
+  uint64_t tail = profile.rowTail;
+  int stalled = 0;
+
+  if (profile.writerFailed) {
+    return;
+  }
+  while (tail - profile.rowHead >= RT_OUTPUT_ROWS) {
+    if (profile.writerFailed) {
+      return;
+    }
+    if (!stalled) {
+      RT_PROFILE_FETCH_ADD(&profile.stats.outputStalls, 1);
+      stalled = 1;
+    }
+    sched_yield();
+  }
+  RT_PROFILE_BARRIER();
+  row = &profile.rows[tail % RT_OUTPUT_ROWS];
+  row->timeValue = src->timeValue;
+  if (self->cpuTime) {
+    rt_accumulate(SIM_TIMER_TOTAL);
+    profile.rowCpuTimes[tail % RT_OUTPUT_ROWS] = rt_accumulated(SIM_TIMER_TOTAL);
+    rt_tick(SIM_TIMER_TOTAL);
+  }
+  memcpy(row->realVars, src->realVars, sizeof(modelica_real)*modelData->nVariablesReal);
+  memcpy(row->integerVars, src->integerVars, sizeof(modelica_integer)*modelData->nVariablesInteger);
+  memcpy(row->booleanVars, src->booleanVars, sizeof(modelica_boolean)*modelData->nVariablesBoolean);
+  memcpy(row->stringVars, src->stringVars, sizeof(modelica_string)*modelData->nVariablesString);
+  RT_PROFILE_BARRIER();
+  profile.rowTail = tail+1;
+}
+
+static void* writerThread(void *arg)
+{
+  int stop;
+#if defined(__linux__)
+  struct sched_param param = {.sched_priority = 0};
+  sched_setscheduler(0, SCHED_OTHER, &param);
+#endif
+  useStream = profile.logStreams;
+  MMC_TRY_TOP()
+  while (1) {
+    stop = profile.stopWriter;
+    RT_PROFILE_BARRIER();
+    if (profile.rowHead == profile.rowTail) {
+      if (stop) {
+        break;
+      }
+      RT_PROFILE_SLEEP_MS(1);
+      continue;
+    }
+    profile.shadowLocal = &profile.rows[profile.rowHead % RT_OUTPUT_ROWS];
+    profile.result->rowCpuTime = &profile.rowCpuTimes[profile.rowHead % RT_OUTPUT_ROWS];
+    profile.emit(profile.result, &profile.shadowData, threadData);
+    RT_PROFILE_BARRIER();
+    profile.rowHead++;
+  }
+  MMC_CATCH_TOP(profile.writerFailed = 1)
+  return NULL;
+}
+
+static int allocateRows(DATA *data)
+{
+  const MODEL_DATA *modelData = data->modelData;
+  size_t nReal = modelData->nVariablesReal, nInt = modelData->nVariablesInteger;
+  size_t nBool = modelData->nVariablesBoolean, nString = modelData->nVariablesString;
+  /* reals first, then the other types in decreasing alignment; strings must be visible to the garbage collector */
+  size_t rowSize = nReal*sizeof(modelica_real) + nInt*sizeof(modelica_integer) + nString*sizeof(modelica_string) + nBool*sizeof(modelica_boolean);
+  char *p;
+  int i;
+
+  rowSize = (rowSize + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+  profile.rows = (SIMULATION_DATA*) calloc(RT_OUTPUT_ROWS, sizeof(SIMULATION_DATA));
+  profile.rowCpuTimes = (double*) calloc(RT_OUTPUT_ROWS, sizeof(double));
+  profile.rowMemory = omc_alloc_interface.malloc_uncollectable(RT_OUTPUT_ROWS*rowSize + 1);
+  if (!profile.rows || !profile.rowCpuTimes || !profile.rowMemory) {
+    return 1;
+  }
+  memset(profile.rowMemory, 0, RT_OUTPUT_ROWS*rowSize + 1);
+  p = (char*) profile.rowMemory;
+  for (i=0; i<RT_OUTPUT_ROWS; i++, p+=rowSize) {
+    profile.rows[i].realVars = (modelica_real*) p;
+    profile.rows[i].integerVars = (modelica_integer*) (p + nReal*sizeof(modelica_real));
+    profile.rows[i].stringVars = (modelica_string*) (p + nReal*sizeof(modelica_real) + nInt*sizeof(modelica_integer));
+    profile.rows[i].booleanVars = (modelica_boolean*) (p + nReal*sizeof(modelica_real) + nInt*sizeof(modelica_integer) + nString*sizeof(modelica_string));
+  }
+  return 0;
+}
+
+/* === setup === */
+
+#if defined(__linux__)
+/* writes one byte of every page; not inlined, so that the memory escapes and the writes are kept */
+static void __attribute__((noinline)) touchPages(volatile char *memory, size_t size, long pageSize)
+{
+  size_t i;
+  for (i=0; i<size; i+=pageSize) {
+    memory[i] = 0;
+  }
+}
+#endif
+
+static void prefault(void)
+{
+#if defined(__linux__)
+  char stack[RT_STACK_PREFAULT];
+  long pageSize = sysconf(_SC_PAGESIZE);
+  size_t size = 1024*1024*(size_t)(omc_flag[FLAG_RT_PREFAULT] ? atoi(omc_flagValue[FLAG_RT_PREFAULT]) : 64);
+  char *heap;
+
+  touchPages(stack, RT_STACK_PREFAULT, pageSize);
+#if defined(__GLIBC__)
+  /* keep freed memory in the process and do not use mmap, so that the prefaulted pages stay mapped */
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+#endif
+  if (size > 0) {
+    heap = (char*) malloc(size);
+    if (heap) {
+      touchPages(heap, size, pageSize);
+      free(heap);
+    } else {
+      warningStreamPrint(LOG_RT, 0, "-rtPrefault: could not allocate %ld MB", (long) (size/(1024*1024)));
+    }
+    GC_expand_hp(size);
+  }
+#endif
+}
+
+void omc_real_time_profile_init(threadData_t *threadData, DATA *data)
+{
+  if (!omc_flag[FLAG_RT_PROFILE]) {
+    if (omc_flag[FLAG_RT_CPU] || omc_flag[FLAG_RT_PREFAULT]) {
+      warningStreamPrint(LOG_STDOUT, 0, "-rtCpu and -rtPrefault are only used together with -rtProfile.");
+    }
+    return;
+  }
+  if (!data->real_time_sync.enabled) {
+    warningStreamPrint(LOG_STDOUT, 0, "-rtProfile is ignored since the simulation does not run in real time (-rt).");
+    return;
+  }
+
+  memset(&profile, 0, sizeof(RT_PROFILE));
+  profile.logStreams = useStream;
+  profile.log = (RT_LOG_SLOT*) calloc(RT_LOG_QUEUE_SIZE, sizeof(RT_LOG_SLOT));
+  if (!profile.log || allocateRows(data)) {
+    throwStreamPrint(threadData, "-rtProfile: out of memory");
+  }
+  profile.shadowData = *data;
+  profile.shadowData.localData = &profile.shadowLocal;
+  profile.result = &sim_result;
+  profile.emit = sim_result.emit;
+  profile.messageFunction = messageFunction;
+  profile.messageClose = messageClose;
+  profile.messageCloseWarning = messageCloseWarning;
+  {
+    uint64_t i;
+    for (i=0; i<RT_LOG_QUEUE_SIZE; i++) {
+      profile.log[i].sequence = i;
+    }
+  }
+
+  /* the threads are started before the simulation thread changes its scheduling, so they do not inherit it */
+  if (GC_pthread_create(&profile.logger, NULL, loggerThread, NULL)) {
+    warningStreamPrint(LOG_RT, 0, "-rtProfile: could not start the logger thread: %s", strerror(errno));
+  } else {
+    profile.hasLogger = 1;
+    messageFunction = rtMessageFunction;
+    messageClose = rtMessageClose;
+    messageCloseWarning = rtMessageCloseWarning;
+  }
+  if (GC_pthread_create(&profile.writer, NULL, writerThread, NULL)) {
+    warningStreamPrint(LOG_RT, 0, "-rtProfile: could not start the result writer thread: %s", strerror(errno));
+  } else {
+    profile.hasWriter = 1;
+    sim_result.emit = rtEmit;
+  }
+  profile.active = 1;
+}
+
+void omc_real_time_profile_prepare_thread(DATA *data)
+{
+  if (!profile.active) {
+    return;
+  }
+#if defined(__linux__)
+  if (omc_flag[FLAG_RT_CPU]) {
+    cpu_set_t set;
+    int cpu = atoi(omc_flagValue[FLAG_RT_CPU]);
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &set) == -1) {
+      warningStreamPrint(LOG_RT, 0, "-rtCpu: could not pin the simulation thread to CPU %d: %s", cpu, strerror(errno));
+    }
+  }
+  prefault();
+#else
+  if (omc_flag[FLAG_RT_CPU] || omc_flag[FLAG_RT_PREFAULT]) {
+    warningStreamPrint(LOG_RT, 0, "-rtCpu and -rtPrefault are only supported on Linux.");
+  }
+#endif
+}
+
+void omc_real_time_profile_step(int64_t lateness, int64_t maxLate)
+{
+  int64_t jitter;
+
+  if (!profile.active) {
+    return;
+  }
+  RT_PROFILE_FETCH_ADD(&profile.stats.steps, 1);
+  if (profile.stats.steps > 1) {
+    jitter = lateness - profile.lastLateness;
+    histogramAdd(&profile.stats.jitter, (uint64_t) (jitter < 0 ? -jitter : jitter));
+  }
+  profile.lastLateness = lateness;
+  if (lateness > 0) {
+    histogramAdd(&profile.stats.lateness, (uint64_t) lateness);
+  }
+  if (lateness > maxLate) {
+    RT_PROFILE_FETCH_ADD(&profile.stats.deadlineMisses, 1);
+  }
+}
+
+int omc_real_time_profile_stats(RT_PROFILE_STATS *stats)
+{
+  if (!profile.active) {
+    return 0;
+  }
+  histogramCopy(&stats->jitter, &profile.stats.jitter);
+  histogramCopy(&stats->lateness, &profile.stats.lateness);
+  stats->steps = RT_PROFILE_READ(&profile.stats.steps);
+  stats->deadlineMisses = RT_PROFILE_READ(&profile.stats.deadlineMisses);
+  stats->droppedMessages = RT_PROFILE_READ(&profile.stats.droppedMessages);
+  stats->outputStalls = RT_PROFILE_READ(&profile.stats.outputStalls);
+  return 1;
+}
+
+static void printHistogram(const char *name, const RT_PROFILE_HISTOGRAM *h)
+{
+  int v50, v99, v999, vMax;
+  const char *u50 = prettyPrintNanoSec(histogramPercentile(h, 0.5), &v50);
+  const char *u99 = prettyPrintNanoSec(histogramPercentile(h, 0.99), &v99);
+  const char *u999 = prettyPrintNanoSec(histogramPercentile(h, 0.999), &v999);
+  const char *uMax = prettyPrintNanoSec(h->max, &vMax);
+  infoStreamPrint(LOG_RT, 0, "%s (%ld samples): p50 <= %d %s, p99 <= %d %s, p99.9 <= %d %s, max %d %s", name, (long) h->count,
+                  v50, u50, v99, u99, v999, u999, vMax, uMax);
+}
+
+void omc_real_time_profile_finish(DATA *data)
+{
+  RT_PROFILE_STATS stats;
+
+  if (!profile.active) {
+    return;
+  }
+  /* the writer may still log, so the logger is stopped after it */
+  profile.stopWriter = 1;
+  RT_PROFILE_BARRIER();
+  if (profile.hasWriter) {
+    GC_pthread_join(profile.writer, NULL);
+    sim_result.emit = profile.emit;
+    sim_result.rowCpuTime = NULL;
+    if (profile.writerFailed) {
+      errorStreamPrint(LOG_STDOUT, 0, "-rtProfile: writing the result file failed, the result is incomplete.");
+    }
+  }
+  profile.stopLogger = 1;
+  RT_PROFILE_BARRIER();
+  if (profile.hasLogger) {
+    GC_pthread_join(profile.logger, NULL);
+    messageFunction = profile.messageFunction;
+    messageClose = profile.messageClose;
+    messageCloseWarning = profile.messageCloseWarning;
+  }
+  omc_real_time_profile_stats(&stats);
+  profile.active = 0;
+
+  infoStreamPrint(LOG_RT, 1, "Real-time profile: %ld steps, %ld missed deadlines", (long) stats.steps, (long) stats.deadlineMisses);
+  printHistogram("step jitter", &stats.jitter);
+  printHistogram("lateness of late steps", &stats.lateness);
+  infoStreamPrint(LOG_RT, 0, "%ld log messages dropped, %ld result points waited for the writer thread", (long) stats.droppedMessages, (long) stats.outputStalls);
+  messageClose(LOG_RT);
+
+  free(profile.log);
+  free(profile.rows);
+  free(profile.rowCpuTimes);
+  omc_alloc_interface.free_uncollectable(profile.rowMemory);
+  profile.log = NULL;
+  profile.rows = NULL;
+  profile.rowCpuTimes = NULL;
+  profile.rowMemory = NULL;
+}
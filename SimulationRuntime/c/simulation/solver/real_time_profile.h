@@ -0,0 +1,86 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file real_time_profile.h
+ *
+ *  Description: real-time profile for hardware-in-the-loop runs (-rtProfile).
+ *  The simulation thread is pinned and prefaulted, result output and log
+ *  messages are handed over to background threads without locks, and the
+ *  timing of every synchronized step is collected in histograms.
+ */
+
+#ifndef __OMC_REAL_TIME_PROFILE__H
+#define __OMC_REAL_TIME_PROFILE__H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "simulation_data.h"
+
+#include <stdint.h>
+
+/* bucket 0 counts 0ns, bucket i counts [2^(i-1), 2^i) ns; the last bucket counts everything above */
+#define RT_PROFILE_BUCKETS 40
+
+typedef struct RT_PROFILE_HISTOGRAM
+{
+  uint64_t count;
+  uint64_t sum;                        /* [ns] */
+  uint64_t max;                        /* [ns] */
+  uint64_t bucket[RT_PROFILE_BUCKETS];
+} RT_PROFILE_HISTOGRAM;
+
+typedef struct RT_PROFILE_STATS
+{
+  RT_PROFILE_HISTOGRAM jitter;         /* change of the lateness between two steps */
+  RT_PROFILE_HISTOGRAM lateness;       /* late steps only */
+  uint64_t steps;
+  uint64_t deadlineMisses;             /* steps later than the allowed lateness */
+  uint64_t droppedMessages;            /* log messages lost because the queue was full */
+  uint64_t outputStalls;               /* result points that had to wait for the writer thread */
+} RT_PROFILE_STATS;
+
+/* called by omc_real_time_sync_init before and after the scheduling setup */
+void omc_real_time_profile_init(threadData_t *threadData, DATA *data);
+void omc_real_time_profile_prepare_thread(DATA *data);
+/* records one synchronized step; lateness is the result of rt_ext_tp_sync_nanosec */
+void omc_real_time_profile_step(int64_t lateness, int64_t maxLate);
+/* flushes the background threads, restores the output and prints the summary */
+void omc_real_time_profile_finish(DATA *data);
+/* copies the current statistics, may be called from any thread while the simulation runs;
+ * returns 0 if the profile is not active */
+int omc_real_time_profile_stats(RT_PROFILE_STATS *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -29,6 +29,7 @@
  */
 
 #include "real_time_sync.h"
+#include "real_time_profile.h"
 
 #if defined(__linux__)
 #include <sys/mman.h>
@@ -41,6 +42,8 @@ void omc_real_time_sync_init(threadData_t *threadData, DATA *data)
 
   omc_real_time_sync_update(data, data->real_time_sync.scaling);
 
+  /* starts the background threads of -rtProfile before the scheduling is changed */
+  omc_real_time_profile_init(threadData, data);
   if (data->real_time_sync.enabled == 0) {
     return;
   }
@@ -54,6 +57,7 @@ void omc_real_time_sync_init(threadData_t *threadData, DATA *data)
     warningStreamPrint(LOG_RT, 0, __FILE__ ": sched_setscheduler failed: %s\n", strerror(errno));
   }
 #endif
+  omc_real_time_profile_prepare_thread(data);
 }
 
 void omc_real_time_sync_update(DATA *data, double scaling)
@@ -42,6 +42,7 @@
 #include "dassl.h"
 #include "ida_solver.h"
 #include "delay.h"
+#include "checkpoint.h"
 #include "events.h"
 #include "external_input.h"
 #include "util/varinfo.h"
@@ -55,6 +56,9 @@
 #if !defined(OMC_MINIMAL_RUNTIME)
 #include "simulation/solver/embedded_server.h"
 #include "simulation/solver/real_time_sync.h"
+#include "simulation/solver/real_time_profile.h"
+#include "simulation/solver/metrics_server.h"
+#include "simulation/solver/multirate.h"
 #endif
 
 #include "optimization/OptimizerInterface.h"
@@ -115,6 +119,11 @@ int solver_main_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
     retVal = dassl_step(data, threadData, solverInfo);
     TRACE_POP
     return retVal;
+
+  case S_MULTIRATE:
+    retVal = multirate_step(data, threadData, solverInfo);
+    TRACE_POP
+    return retVal;
 #endif
 
 #ifdef WITH_IPOPT
@@ -155,6 +164,34 @@ int solver_main_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
   return 1;
 }
 
+/*! \fn solver_main_interpolate
+ *
+ *  Evaluates the interpolation polynomial of the last solver step at the
+ *  given time. Only used for solvers that set solverDenseOutput.
+ *
+ *  \param [in]  [time] time inside the last step
+ *  \param [out] [states]
+ *  \param [out] [stateDerivatives]
+ */
+void solver_main_interpolate(DATA* data, SOLVER_INFO* solverInfo, double time, double *states, double *stateDerivatives)
+{
+  switch(solverInfo->solverMethod)
+  {
+#if !defined(OMC_MINIMAL_RUNTIME)
+  case S_DASSL:
+    dassl_interpolate((DASSL_DATA*) solverInfo->solverData, data->modelData->nStates, time, states, stateDerivatives);
+    break;
+#endif
+#ifdef WITH_SUNDIALS
+  case S_IDA:
+    ida_solver_interpolate((IDA_SOLVER*) solverInfo->solverData, data->modelData->nStates, time, states, stateDerivatives);
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
 /*! \fn initializeSolverData(DATA* data, SOLVER_INFO* solverInfo)
  *
  *  \param [ref] [data]
@@ -185,6 +222,7 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
   solverInfo->laststep = 0;
   solverInfo->solverRootFinding = 0;
   solverInfo->solverNoEquidistantGrid = 0;
+  solverInfo->solverDenseOutput = 0;
   solverInfo->lastdesiredStep = solverInfo->currentTime + solverInfo->currentStepSize;
   solverInfo->eventLst = allocList(sizeof(long));
   solverInfo->didEventStep = 0;
@@ -192,6 +230,10 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
   solverInfo->sampleEvents = 0;
   solverInfo->solverStats = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
   solverInfo->solverStatsTmp = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
+  solverInfo->stepNo = 0;
+  solverInfo->syncStep = 0;
+  solverInfo->restarted = 0;
+  checkpointInit(data, solverInfo);
 
   /* if FLAG_NOEQUIDISTANT_GRID is set, choose dassl step method */
   if (omc_flag[FLAG_NOEQUIDISTANT_GRID])
@@ -255,6 +297,12 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
     solverInfo->solverData = dasslData;
     break;
   }
+  case S_MULTIRATE:
+  {
+    infoStreamPrint(LOG_SOLVER, 0, "Initializing multirate solver");
+    retValue = allocateMultirate(data, threadData, solverInfo);
+    break;
+  }
 #endif
 #ifdef WITH_IPOPT
   case S_OPTIMIZATION:
@@ -330,6 +378,12 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
     return 1;
   }
 
+  if (omc_flag[FLAG_DENSE_OUTPUT] && !solverInfo->solverDenseOutput)
+  {
+    warningStreamPrint(LOG_STDOUT, 0, "-denseOutput is not supported by solver %s%s, using the regular output grid", SOLVER_METHOD_NAME[solverInfo->solverMethod],
+                       omc_flag[FLAG_NOEQUIDISTANT_GRID] ? " together with -noEquidistantTimeGrid" : "");
+  }
+
   externalInputallocate(data);
   if(measure_time_flag)
   {
@@ -373,6 +427,10 @@ int freeSolverData(DATA* data, SOLVER_INFO* solverInfo)
     /* De-Initial DASSL solver */
     dassl_deinitial(solverInfo->solverData);
   }
+  else if(solverInfo->solverMethod == S_MULTIRATE)
+  {
+    freeMultirate(solverInfo);
+  }
 #endif
 #ifdef WITH_IPOPT
   else if(solverInfo->solverMethod == S_OPTIMIZATION)
@@ -636,6 +694,9 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
   SOLVER_INFO solverInfo;
   SIMULATION_INFO *simInfo = data->simulationInfo;
   void *dllHandle=NULL;
+#if !defined(OMC_MINIMAL_RUNTIME)
+  METRICS_SERVER *metricsServer=NULL;
+#endif
 
   solverInfo.solverMethod = solverID;
 
@@ -666,6 +727,11 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
   /* allocate SolverInfo memory */
   retVal = initializeSolverData(data, threadData, &solverInfo);
   omc_alloc_interface.collect_a_little();
+#if !defined(OMC_MINIMAL_RUNTIME)
+  if(0 == retVal) {
+    metricsServer = omc_metrics_server_start(data, &solverInfo);
+  }
+#endif
 
   /* initialize all parts of the model */
   if(0 == retVal) {
@@ -709,27 +775,42 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
       finishSimulation(data, threadData, &solverInfo, outputVariablesAtEnd);
       omc_alloc_interface.collect_a_little();
     } else {
-      /* starts the simulation main loop - standard solver interface */
-      if(solverInfo.solverMethod != S_OPTIMIZATION) {
-        sim_result.emit(&sim_result,data,threadData);
+      /* continue from a checkpoint instead of the initial values */
+      if(omc_flag[FLAG_RESTART]) {
+        retVal = checkpointRead(data, threadData, &solverInfo, omc_flagValue[FLAG_RESTART]);
+      }
+      if(0 == retVal) {
+        /* starts the simulation main loop - standard solver interface */
+        if(solverInfo.solverMethod != S_OPTIMIZATION) {
+          sim_result.emit(&sim_result,data,threadData);
+        }
+
+        /* the ring-buffer and the old values of a checkpoint are kept */
+        if(!solverInfo.restarted) {
+          /* overwrite the whole ring-buffer with initialized values */
+          overwriteOldSimulationData(data);
+
+          /* store all values for non-dassl event search */
+          storeOldValues(data);
+        }
+
+        infoStreamPrint(LOG_SOLVER, 0, "Start numerical solver from %g to %g", solverInfo.currentTime, simInfo->stopTime);
+        retVal = data->callback->performSimulation(data, threadData, &solverInfo);
+        omc_alloc_interface.collect_a_little();
+        if(0 == retVal) {
+          checkpointFinish(data, &solverInfo);
+        }
+        /* terminate the simulation */
+        if (solverInfo.solverMethod == S_SYM_IMP_EULER) data->callback->symEulerUpdate(data, 0);
+        finishSimulation(data, threadData, &solverInfo, outputVariablesAtEnd);
+        omc_alloc_interface.collect_a_little();
       }
-
-      /* overwrite the whole ring-buffer with initialized values */
-      overwriteOldSimulationData(data);
-
-      /* store all values for non-dassl event search */
-      storeOldValues(data);
-
-      infoStreamPrint(LOG_SOLVER, 0, "Start numerical solver from %g to %g", simInfo->startTime, simInfo->stopTime);
-      retVal = data->callback->performSimulation(data, threadData, &solverInfo);
-      omc_alloc_interface.collect_a_little();
-      /* terminate the simulation */
-      if (solverInfo.solverMethod == S_SYM_IMP_EULER) data->callback->symEulerUpdate(data, 0);
-      finishSimulation(data, threadData, &solverInfo, outputVariablesAtEnd);
-      omc_alloc_interface.collect_a_little();
     }
   }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+  omc_real_time_profile_finish(data);
+#endif
   if (data->real_time_sync.enabled) {
     int tMaxLate=0;
     const char *unit = prettyPrintNanoSec(data->real_time_sync.maxLate, &tMaxLate);
@@ -738,6 +819,7 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
 #if !defined(OMC_MINIMAL_RUNTIME)
   embedded_server_deinit(data->embeddedServerState);
   embedded_server_unload_functions(dllHandle);
+  omc_metrics_server_stop(metricsServer);
 #endif
   /* free SolverInfo memory */
   freeSolverData(data, &solverInfo);
@@ -56,6 +56,8 @@ typedef struct SOLVER_INFO
   modelica_boolean solverRootFinding;
   /* set by solver if output points are set by step size control */
   modelica_boolean solverNoEquidistantGrid;
+  /* set by solver if output points are interpolated from its natural steps (-denseOutput) */
+  modelica_boolean solverDenseOutput;
   double lastdesiredStep;
 
   /* events */
@@ -75,6 +77,12 @@ typedef struct SOLVER_INFO
   /* further options */
   int integratorSteps;
 
+  /* checkpoint/restart, see checkpoint.h */
+  double nextCheckpoint;
+  unsigned int stepNo;                 /* output step of the main loop */
+  modelica_boolean syncStep;
+  modelica_boolean restarted;          /* set if the state was restored from a checkpoint */
+
   void* solverData;
 }SOLVER_INFO;
 
@@ -96,6 +104,7 @@ extern int initializeModel(DATA* data, threadData_t *threadData, const char* ini
 extern int finishSimulation(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, const char* outputVariablesAtEnd);
 
 extern int solver_main_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo);
+extern void solver_main_interpolate(DATA* data, SOLVER_INFO* solverInfo, double time, double *states, double *stateDerivatives);
 
 void checkTermination(DATA* data);
 
@@ -0,0 +1,258 @@
+/* Writes the checkpoint image of a fake model with two real variables, a
+ * string variable, a parameter and a delay buffer, and restores it into a
+ * second instance of the model whose values differ, once from the image as
+ * written and once from damaged copies of it:
+ *  - one byte of the last value flipped,
+ *  - the last byte cut off,
+ * and once into an instance whose event limit of the chattering detection
+ * differs from the one in the image, which is only found after the ring
+ * buffer has been read.
+ * Then the model is run with a fake solver, once without interruption and
+ * once stopped with a checkpoint file part way and resumed from it in an
+ * instance at its start values, like a restarted simulation.
+ * Checks that the intact image restores all values, that a damaged one is
+ * rejected before anything of the model is changed, and that the resumed
+ * run reproduces every step of the uninterrupted one bit for bit. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulation_data.h"
+#include "openmodelica_func.h"
+#include "util/omc_error.h"
+#include "util/ringbuffer.h"
+#include "simulation/options.h"
+#include "simulation/solver/checkpoint.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/nonlinearValuesList.h"
+
+#define RING 3
+#define NUM_REALS 2
+#define NUM_DELAY_VALUES 5
+#define STEP 0.05
+/* der(x) = -k*x + delay(x, DELAY_STEPS*STEP) */
+#define DELAY_STEPS 5
+#define RESUME_STEPS 15
+#define TOTAL_STEPS 40
+#define CHECKPOINT_FILE "test_checkpoint.chk"
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* simulation and solver library */
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+const size_t SIZERINGBUFFER = RING;
+void updateDiscreteSystem(DATA *data, threadData_t *threadData) {}
+void overwriteOldSimulationData(DATA *data) {}
+void storeOldValues(DATA *data) {}
+void cleanValueList(VALUES_LIST *valueList, LIST_NODE* next) {}
+
+typedef struct {
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  SIMULATION_DATA simulationData[RING];
+  SIMULATION_DATA *localData[RING];
+  STATIC_REAL_DATA realParameterData[1];
+  STATIC_STRING_DATA stringParameterData[1];
+  modelica_real realVars[RING][NUM_REALS];
+  modelica_string stringVars[RING][1];
+  modelica_real realVarsOld[NUM_REALS], realVarsPre[NUM_REALS];
+  modelica_string stringVarsOld[1], stringVarsPre[1];
+  modelica_real realParameter[1];
+  RINGBUFFER *delayStructure[1];
+} MODEL;
+
+/* a model whose values are derived from v */
+static void initModel(MODEL *m, double v)
+{
+  TIME_AND_VALUE delayValue;
+  int i;
+
+  memset(m, 0, sizeof(*m));
+  m->modelData.modelGUID = "{test_checkpoint}";
+  m->modelData.nStates = 1;
+  m->modelData.nVariablesReal = NUM_REALS;
+  m->modelData.nVariablesString = 1;
+  m->modelData.nParametersReal = 1;
+  m->modelData.nDelayExpressions = 1;
+  m->modelData.realParameterData = m->realParameterData;
+  m->realParameterData[0].attribute.start = 1.0;
+  for (i = 0; i < RING; i++) {
+    m->simulationData[i].timeValue = v - i;
+    m->simulationData[i].realVars = m->realVars[i];
+    m->simulationData[i].stringVars = m->stringVars[i];
+    m->realVars[i][0] = v + i;
+    m->realVars[i][1] = 2*v + i;
+    m->stringVars[i][0] = mmc_mk_scon(v > 0 ? "positive" : "negative");
+    m->localData[i] = &m->simulationData[i];
+  }
+  m->simulationInfo.realVarsOld = m->realVarsOld;
+  m->simulationInfo.realVarsPre = m->realVarsPre;
+  m->simulationInfo.stringVarsOld = m->stringVarsOld;
+  m->simulationInfo.stringVarsPre = m->stringVarsPre;
+  m->simulationInfo.realParameter = m->realParameter;
+  m->realParameter[0] = 3*v;
+  m->delayStructure[0] = allocRingBuffer(1024, sizeof(TIME_AND_VALUE));
+  for (i = 0; i < NUM_DELAY_VALUES + (v > 0); i++) {
+    delayValue.t = i;
+    delayValue.value = v*i;
+    appendRingData(m->delayStructure[0], &delayValue);
+  }
+  m->simulationInfo.delayStructure = m->delayStructure;
+  m->data.modelData = &m->modelData;
+  m->data.simulationInfo = &m->simulationInfo;
+  m->data.localData = m->localData;
+}
+
+/* 1 if m holds the values initModel derives from v */
+static int hasValues(MODEL *m, double v)
+{
+  int i;
+
+  for (i = 0; i < RING; i++) {
+    if (m->simulationData[i].timeValue != v - i || m->realVars[i][0] != v + i || m->realVars[i][1] != 2*v + i ||
+        strcmp(MMC_STRINGDATA(m->stringVars[i][0]), v > 0 ? "positive" : "negative")) {
+      return 0;
+    }
+  }
+  return m->realParameter[0] == 3*v && ringBufferLength(m->delayStructure[0]) == NUM_DELAY_VALUES + (v > 0) &&
+         ((TIME_AND_VALUE*) getRingData(m->delayStructure[0], 1))->value == v;
+}
+
+/* the model at its start values, with the state of the fake solver */
+static void startModel(MODEL *m, SOLVER_INFO *solverInfo)
+{
+  int i;
+
+  initModel(m, 1.0);
+  freeRingBuffer(m->delayStructure[0]);
+  m->delayStructure[0] = allocRingBuffer(1024, sizeof(TIME_AND_VALUE));
+  for (i = 0; i < RING; i++) {
+    m->simulationData[i].timeValue = 0.0;
+    m->realVars[i][0] = 1.0;
+    m->realVars[i][1] = 0.0;
+  }
+  memset(solverInfo, 0, sizeof(*solverInfo));
+  solverInfo->solverMethod = S_EULER;
+  solverInfo->currentStepSize = STEP;
+  solverInfo->eventLst = allocList(sizeof(long));
+  solverInfo->solverStats = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
+  solverInfo->solverStatsTmp = (unsigned int*) calloc(numStatistics, sizeof(unsigned int));
+}
+
+/* one step of the fake solver, Adams-Bashforth of order 2 for
+ *   der(x) = -k*x + delay(x, DELAY_STEPS*STEP)
+ * with x in realVars[0] and der(x) in realVars[1]. Besides x it needs the
+ * previous derivative in the ring buffer, the delay buffer, the parameter k
+ * and the step counter, so it only continues like the uninterrupted run if
+ * all of them are restored. */
+static void solverStep(MODEL *m, SOLVER_INFO *solverInfo)
+{
+  RINGBUFFER *delay = m->delayStructure[0];
+  TIME_AND_VALUE delayValue;
+  double h = solverInfo->currentStepSize, delayed, der, x;
+  int i;
+
+  delayValue.t = m->simulationData[0].timeValue;
+  delayValue.value = m->realVars[0][0];
+  appendRingData(delay, &delayValue);
+  delayed = ringBufferLength(delay) > DELAY_STEPS ?
+            ((TIME_AND_VALUE*) getRingData(delay, ringBufferLength(delay) - 1 - DELAY_STEPS))->value : 1.0;
+  der = -m->realParameter[0]*m->realVars[0][0] + delayed;
+  m->realVars[0][1] = der;
+  x = m->realVars[0][0] + (solverInfo->stepNo ? h*(1.5*der - 0.5*m->realVars[1][1]) : h*der);
+
+  for (i = RING - 1; i > 0; i--) {
+    m->simulationData[i].timeValue = m->simulationData[i-1].timeValue;
+    memcpy(m->realVars[i], m->realVars[i-1], sizeof(m->realVars[i]));
+  }
+  m->simulationData[0].timeValue += h;
+  m->realVars[0][0] = x;
+  m->realVarsPre[0] = x;
+  solverInfo->currentTime = m->simulationData[0].timeValue;
+  solverInfo->stepNo++;
+  solverInfo->solverStats[0]++;
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  static MODEL source, target, resumed;
+  CHECKPOINT_BUFFER image = {0};
+  SOLVER_INFO sourceSolver, targetSolver, resumedSolver;
+  char *damaged;
+  int lastSteps[1];
+  double lastTimes[1];
+  double reference[TOTAL_STEPS];
+  int step;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  initModel(&source, 1.0);
+  CHECK(checkpointSerialize(&source.data, NULL, &image) == 0, "checkpointSerialize failed");
+  damaged = (char*) malloc(image.size);
+
+  /* a flipped byte in the last value */
+  initModel(&target, -1.0);
+  memcpy(damaged, image.data, image.size);
+  damaged[image.size - 1] ^= 0x10;
+  CHECK(checkpointDeserialize(&target.data, NULL, NULL, damaged, image.size) != 0, "an image with a flipped byte was accepted");
+  CHECK(hasValues(&target, -1.0), "an image with a flipped byte changed the model");
+
+  /* the last byte is missing */
+  CHECK(checkpointDeserialize(&target.data, NULL, NULL, image.data, image.size - 1) != 0, "a truncated image was accepted");
+  CHECK(hasValues(&target, -1.0), "a truncated image changed the model");
+
+  /* an intact image that does not fit the chattering detection */
+  target.simulationInfo.chatteringInfo.numEventLimit = 1;
+  target.simulationInfo.chatteringInfo.lastSteps = lastSteps;
+  target.simulationInfo.chatteringInfo.lastTimes = lastTimes;
+  CHECK(checkpointDeserialize(&target.data, NULL, NULL, image.data, image.size) != 0, "an image with another event limit was accepted");
+  CHECK(hasValues(&target, -1.0), "an image with another event limit changed the model");
+  target.simulationInfo.chatteringInfo.numEventLimit = 0;
+
+  /* intact */
+  CHECK(checkpointDeserialize(&target.data, NULL, NULL, image.data, image.size) == 0, "the image was rejected");
+  CHECK(hasValues(&target, 1.0), "the image did not restore the values");
+
+  /* the uninterrupted run */
+  startModel(&source, &sourceSolver);
+  for (step = 0; step < TOTAL_STEPS; step++) {
+    solverStep(&source, &sourceSolver);
+    reference[step] = source.realVars[0][0];
+  }
+
+  /* stopped after RESUME_STEPS and resumed from the checkpoint file in a new instance */
+  startModel(&target, &targetSolver);
+  for (step = 0; step < RESUME_STEPS; step++) {
+    solverStep(&target, &targetSolver);
+  }
+  CHECK(checkpointWrite(&target.data, &targetSolver, CHECKPOINT_FILE) == 0, "checkpointWrite failed");
+  startModel(&resumed, &resumedSolver);
+  CHECK(checkpointRead(&resumed.data, NULL, &resumedSolver, CHECKPOINT_FILE) == 0, "checkpointRead failed");
+  CHECK(resumedSolver.restarted && resumedSolver.stepNo == RESUME_STEPS && resumedSolver.currentTime == targetSolver.currentTime,
+        "the solver resumed at step %u, time %g instead of step %d, time %g", resumedSolver.stepNo, resumedSolver.currentTime,
+        RESUME_STEPS, targetSolver.currentTime);
+  for (step = RESUME_STEPS; step < TOTAL_STEPS; step++) {
+    solverStep(&resumed, &resumedSolver);
+    CHECK(resumed.realVars[0][0] == reference[step], "step %d of the resumed run: x = %.17g, the uninterrupted run has %.17g",
+          step + 1, resumed.realVars[0][0], reference[step]);
+  }
+  CHECK(resumedSolver.currentTime == sourceSolver.currentTime && resumedSolver.solverStats[0] == sourceSolver.solverStats[0] &&
+        ringBufferLength(resumed.delayStructure[0]) == ringBufferLength(source.delayStructure[0]),
+        "the resumed run ends at time %g after %u steps with %d delay values, the uninterrupted one at %g after %u steps with %d",
+        resumedSolver.currentTime, resumedSolver.solverStats[0], ringBufferLength(resumed.delayStructure[0]),
+        sourceSolver.currentTime, sourceSolver.solverStats[0], ringBufferLength(source.delayStructure[0]));
+  remove(CHECKPOINT_FILE);
+
+  free(damaged);
+  free(image.data);
+  return errors;
+}
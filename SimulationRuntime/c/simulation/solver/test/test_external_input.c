@@ -0,0 +1,141 @@
+/* Streams an external input file with windows of 64 rows, once as
+ * -exInputFile and once as -csvInput, the way a solver queries it: each step
+ * first evaluates the inputs at its end, which moves the stream to the next
+ * windows, then steps back inside the step, down to its start.
+ * The steps span more rows than the minimum overlap of the windows, one of
+ * them more rows than a whole window.
+ * Checks that the inputs are interpolated linearly between the rows at every
+ * query. The input is quadratic in time, so extrapolating from rows of a
+ * wrong interval gives wrong values. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "simulation_data.h"
+#include "openmodelica_func.h"
+#include "util/omc_error.h"
+#include "simulation/options.h"
+#include "simulation/solver/external_input.h"
+
+#define TEXT_FILE "test_external_input.txt"
+#define CSV_FILE "test_external_input.csv"
+#define ROWS 1000
+#define DT 0.01
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* simulation library */
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+
+static double u(double t)
+{
+  return 1.0 + t*t;
+}
+
+/* linear interpolation of the rows written to the file */
+static double interpolated(double t)
+{
+  int i = (int) floor(t/DT + 1e-9);
+  double t1 = i*DT, t2 = (i+1)*DT;
+  if (i >= ROWS-1) {
+    return u((ROWS-1)*DT);
+  }
+  return u(t1) + (t-t1)/(t2-t1)*(u(t2)-u(t1));
+}
+
+static int inputNames(DATA *data, char **names)
+{
+  names[0] = (char*) "u";
+  return 0;
+}
+
+static void writeFile(const char *filename, int csv)
+{
+  FILE *file = fopen(filename, "w");
+  int i;
+
+  fprintf(file, csv ? "time,u\n" : "time u\n");
+  for (i = 0; i < ROWS; i++) {
+    fprintf(file, csv ? "%.17g,%.17g\n" : "%.17g %.17g\n", i*DT, u(i*DT));
+  }
+  fclose(file);
+}
+
+/* evaluates the input at time t of a step from the last accepted time tStart */
+static void query(DATA *data, double tStart, double t, const char *format)
+{
+  data->localData[1]->timeValue = tStart;
+  data->localData[0]->timeValue = t;
+  externalInputUpdate(data);
+  CHECK(fabs(data->simulationInfo->inputVars[0] - interpolated(t)) < 1e-9,
+        "%s: u(%g) = %.17g in the step from %g, expected %.17g", format, t, data->simulationInfo->inputVars[0], tStart, interpolated(t));
+}
+
+static void simulate(DATA *data, const char *format)
+{
+  const double steps[] = {0.37, 0.05, 1.5, 0.25, 0.6};
+  double tStart = 0.0, h;
+  int k = 0;
+
+  externalInputallocate(data);
+  CHECK(data->simulationInfo->external_input.active, "%s: the input file was not read", format);
+  if (!data->simulationInfo->external_input.active) {
+    return;
+  }
+  query(data, tStart, tStart, format);
+  for (;;) {
+    h = steps[k++ % (sizeof(steps)/sizeof(steps[0]))];
+    if (tStart + h > (ROWS-1)*DT) {
+      break;
+    }
+    query(data, tStart, tStart + h, format);
+    query(data, tStart, tStart + 0.05*h, format);
+    query(data, tStart, tStart, format);
+    query(data, tStart, tStart + 0.5*h, format);
+    query(data, tStart, tStart + h, format);
+    tStart += h;
+  }
+  CHECK(data->simulationInfo->external_input.offset > 0, "%s: the file was not streamed", format);
+  externalInputFree(data);
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {0};
+  static MODEL_DATA modelData;
+  static SIMULATION_INFO simulationInfo;
+  static SIMULATION_DATA simulationData[2];
+  static SIMULATION_DATA *localData[2] = {&simulationData[0], &simulationData[1]};
+  static modelica_real inputVars[1];
+  static DATA data;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+  omc_flagValue[FLAG_INPUT_WINDOW] = "64";
+
+  callbacks.inputNames = inputNames;
+  modelData.nInputVars = 1;
+  simulationInfo.inputVars = inputVars;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+  data.callback = &callbacks;
+
+  writeFile(TEXT_FILE, 0);
+  omc_flagValue[FLAG_INPUT_FILE] = TEXT_FILE;
+  simulate(&data, "-exInputFile");
+  omc_flagValue[FLAG_INPUT_FILE] = NULL;
+
+  writeFile(CSV_FILE, 1);
+  omc_flagValue[FLAG_INPUT_CSV] = CSV_FILE;
+  simulate(&data, "-csvInput");
+
+  remove(TEXT_FILE);
+  remove(CSV_FILE);
+  return errors;
+}
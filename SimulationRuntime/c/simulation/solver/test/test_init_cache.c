@@ -0,0 +1,205 @@
+/* Runs the initialization with -initSolutionCache on a fake model with a
+ * fixed state x (start 1), a parameter p and an algebraic variable y
+ * (start 1) from the initial equation y^2 = p + x. Like the generated code
+ * of a nonlinear system, the initial equations solve for y by a Newton
+ * iteration from the current value of y and throw if it does not converge,
+ * which is the case for a starting guess y <= 0.
+ * The functions of the solver library used around the initialization are
+ * replaced by stubs.
+ * Checks that
+ *  - a converged solution is stored and used as starting guess on a hit,
+ *  - a cached guess that makes the solve throw is rejected, the start
+ *    values are restored and the initialization succeeds from them,
+ *  - the solution found then replaces the cached guess. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "simulation_data.h"
+#include "openmodelica_func.h"
+#include "util/omc_error.h"
+#include "simulation/options.h"
+#include "simulation/solver/model_help.h"
+#include "simulation/solver/stateset.h"
+#include "simulation/solver/mixedSystem.h"
+#include "simulation/solver/linearSystem.h"
+#include "simulation/solver/nonlinearSystem.h"
+#include "simulation/solver/delay.h"
+#include "simulation/solver/synchronous.h"
+#include "simulation/solver/nonlinearValuesList.h"
+#include "simulation/solver/initialization/initialization.h"
+#include "simulation/solver/initialization/init_cache.h"
+
+#define CACHE_FILE "test_init_cache.bin"
+#define MAX_GUESSES 10
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* starting guesses of y the initial equations were called with */
+static double guesses[MAX_GUESSES];
+static int nGuesses = 0;
+
+enum { X, Y };
+
+/* simulation and solver library */
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+
+int check_linear_solutions(DATA *data, int printFailingSystems) { return 0; }
+int check_mixed_solutions(DATA *data, int printFailingSystems) { return 0; }
+int check_nonlinear_solutions(DATA *data, int printFailingSystems) { return 0; }
+int updateStaticDataOfLinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int updateStaticDataOfNonlinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int stateSelection(DATA *data, threadData_t *threadData, char reportError, int switchStates) { return 0; }
+void initDelay(DATA* data, double startTime) {}
+void initSynchronous(DATA* data, threadData_t *threadData, modelica_real startTime) {}
+void overwriteOldSimulationData(DATA *data) {}
+void printParameters(DATA *data, int stream) {}
+void printRelations(DATA *data, int stream) {}
+void printZeroCrossings(DATA *data, int stream) {}
+void saveZeroCrossings(DATA *data, threadData_t *threadData) {}
+void setAllParamsToStart(DATA *data) {}
+void setAllStartToVars(DATA* data) {}
+void storePreValues(DATA *data) {}
+void storeRelations(DATA* data) {}
+void updateDiscreteSystem(DATA *data, threadData_t *threadData) {}
+void cleanValueList(VALUES_LIST *valueList, LIST_NODE* next) {}
+
+void setAllVarsToStart(DATA* data)
+{
+  long i;
+  for (i = 0; i < data->modelData->nVariablesReal; i++) {
+    data->localData[0]->realVars[i] = data->modelData->realVarsData[i].attribute.start;
+  }
+}
+
+/* model */
+static int functionInitialEquations(DATA *data, threadData_t *threadData)
+{
+  double *x = &data->localData[0]->realVars[X], *y = &data->localData[0]->realVars[Y];
+  double p = data->simulationInfo->realParameter[0];
+  int iter;
+
+  if (nGuesses < MAX_GUESSES) {
+    guesses[nGuesses++] = *y;
+  }
+  *x = data->modelData->realVarsData[X].attribute.start;
+  for (iter = 0; iter < 20 && *y > 0.0; iter++) {
+    *y -= (*y * *y - p - *x) / (2.0 * *y);
+  }
+  if (!(*y > 0.0) || fabs(*y * *y - p - *x) > 1e-12) {
+    throwStreamPrint(threadData, "Solving non-linear system 1 failed at time=0.");
+  }
+  return 0;
+}
+
+static int functionNoop(DATA *data, threadData_t *threadData) { return 0; }
+static int functionUpdateRelations(DATA *data, threadData_t *threadData, int evalZeroCross) { return 0; }
+static void functionInitSample(DATA *data, threadData_t *threadData) {}
+
+static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {
+  .updateBoundParameters = functionNoop,
+  .updateBoundVariableAttributes = functionNoop,
+  .useHomotopy = 0,
+  .functionInitialEquations = functionInitialEquations,
+  .functionInitialEquations_lambda0 = functionInitialEquations,
+  .functionRemovedInitialEquations = functionNoop,
+  .function_storeDelayed = functionNoop,
+  .function_updateRelations = functionUpdateRelations,
+  .function_initSample = functionInitSample
+};
+
+static STATIC_REAL_DATA realVarsData[2];
+static MODEL_DATA modelData;
+static SIMULATION_INFO simulationInfo;
+static SIMULATION_DATA simulationData;
+static SIMULATION_DATA *localData[1] = {&simulationData};
+static modelica_real realVars[2];
+static modelica_real realParameter[1];
+static DATA data;
+
+/* runs the initialization like initializeModel, returns its result or 1 if it threw */
+static int initialize(double p)
+{
+  threadData_t threadDataOnStack = {0}, *threadData = &threadDataOnStack;
+  volatile int retVal = 1;
+
+  realParameter[0] = p;
+  realVars[X] = realVars[Y] = 0.0;
+  nGuesses = 0;
+
+  threadData->currentErrorStage = ERROR_SIMULATION;
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+  retVal = initialization(&data, threadData, "", "", 0.0, 0);
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+  return retVal;
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  INIT_CACHE_KEY key = {0};
+  int retVal;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+  omc_flag[FLAG_INIT_SOLUTION_CACHE] = 1;
+  omc_flagValue[FLAG_INIT_SOLUTION_CACHE] = CACHE_FILE;
+  remove(CACHE_FILE);
+
+  realVarsData[X].info.name = "x";
+  realVarsData[X].attribute.fixed = 1;
+  realVarsData[X].attribute.start = 1.0;
+  realVarsData[Y].info.name = "y";
+  realVarsData[Y].attribute.start = 1.0;
+  modelData.modelGUID = "{test_init_cache}";
+  modelData.modelFilePrefix = "test_init_cache";
+  modelData.realVarsData = realVarsData;
+  modelData.nVariablesReal = 2;
+  modelData.nParametersReal = 1;
+  simulationInfo.realParameter = realParameter;
+  simulationInfo.startTime = 0.0;
+  simulationInfo.stopTime = 1.0;
+  simulationData.realVars = realVars;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+  data.callback = &callbacks;
+
+  /* miss: y = 2 from the start value */
+  retVal = initialize(3.0);
+  CHECK(retVal == 0, "initialization with p = 3 returned %d", retVal);
+  CHECK(realVars[Y] == 2.0, "y = %g with p = 3, expected 2", realVars[Y]);
+  CHECK(nGuesses == 1 && guesses[0] == 1.0, "p = 3 started from y = %g, expected the start value", guesses[0]);
+
+  /* hit: starts from the stored solution */
+  retVal = initialize(3.0);
+  CHECK(retVal == 0 && realVars[Y] == 2.0, "initialization with p = 3 from the cache returned %d, y = %g", retVal, realVars[Y]);
+  CHECK(nGuesses == 1 && guesses[0] == 2.0, "p = 3 started from y = %g, expected the cached 2", guesses[0]);
+
+  /* an entry for p = 5 whose solution is not a valid starting guess */
+  realParameter[0] = 5.0;
+  initCacheLookup(&data, CACHE_FILE, &key);
+  realVars[X] = 1.0;
+  realVars[Y] = -1.0;
+  initCacheStore(&data, CACHE_FILE, &key, 0);
+  initCacheFreeKey(&key);
+
+  /* near hit of that entry: the solve from y = -1 throws, the start values are used instead */
+  retVal = initialize(5.1);
+  CHECK(retVal == 0, "initialization with p = 5.1 returned %d, the rejected cached guess was not caught", retVal);
+  CHECK(fabs(realVars[Y] - sqrt(6.1)) < 1e-12, "y = %g with p = 5.1, expected %g", realVars[Y], sqrt(6.1));
+  CHECK(nGuesses == 2 && guesses[0] == -1.0 && guesses[1] == 1.0,
+        "p = 5.1 started from y = %g, then from y = %g; expected the cached -1, then the start value 1", guesses[0], guesses[1]);
+
+  /* the solution found from the start values replaced the entry */
+  retVal = initialize(5.1);
+  CHECK(retVal == 0 && nGuesses == 1 && fabs(guesses[0] - sqrt(6.1)) < 1e-12,
+        "p = 5.1 from the cache returned %d and started from y = %g, expected %g", retVal, guesses[0], sqrt(6.1));
+
+  remove(CACHE_FILE);
+  return errors;
+}
@@ -0,0 +1,197 @@
+/* Integrates a stiff model with a slow and a fast state
+ *   der(x1) = -x1 + x2
+ *   der(x2) = x1 - 1000*(x2 - cos(t))
+ * from t = 0 to 1 with the multirate solver, the way solver_main.c drives
+ * it, and with DDASKR at a tolerance far below the errors of the multirate
+ * steps, which gives the reference.
+ * Checks that
+ *  - x2 is integrated as the fast state with several micro steps,
+ *  - with the macro step 5e-3 both states agree with DDASKR to within 1e-5,
+ *  - with a fixed number of micro steps (-multirateRatio=2) the error drops
+ *    with the square of the macro step, i.e. the fast states are of second
+ *    order. Micro steps of implicit Euler only halve it, and ROS2 without
+ *    the time derivative of the fast states hardly reduces it, since x2
+ *    follows the input cos(t). */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "simulation_data.h"
+#include "openmodelica_func.h"
+#include "util/omc_error.h"
+#include "simulation/options.h"
+#include "simulation/solver/dassl.h"
+#include "simulation/solver/multirate.h"
+
+#define NUM_STATES 2
+#define STOP_TIME 1.0
+/* work arrays of DDASKR with the maximal order 5 and a dense Jacobian */
+#define LRW (60 + (5 + 4)*NUM_STATES + NUM_STATES*NUM_STATES)
+#define LIW (40 + NUM_STATES)
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* simulation and solver library */
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+int externalInputUpdate(DATA* data) { return 0; }
+
+void DDASKR(
+    int (*res) (double *t, double *y, double *yprime, double* cj, double *delta, int *ires, double *rpar, int* ipar),
+    int *neq,
+    double *t,
+    double *y,
+    double *yprime,
+    double *tout,
+    int *info,
+    double *rtol,
+    double *atol,
+    int *idid,
+    double *rwork,
+    int *lrw,
+    int *iwork,
+    int *liw,
+    double *rpar,
+    int *ipar,
+    int (*jac) (double *t, double *y, double *yprime, double *deltaD, double *delta, double *cj, double *h, double *wt, double *rpar, int* ipar),
+    int (*psol) (int *neq, double *t, double *y, double *yprime, double *savr, double *pwk, double *cj, double *wt, double *wp, int *iwp, double *b, double eplin, int* ires, double *rpar, int* ipar),
+    int (*g) (int *neqm, double *t, double *y, double *yp, int *ng, double *gout, double *rpar, int* ipar),
+    int *ng,
+    int *jroot
+);
+
+/* model */
+static void rhs(double t, const double *x, double *f)
+{
+  f[0] = -x[0] + x[1];
+  f[1] = x[0] - 1000.0*(x[1] - cos(t));
+}
+
+static int functionODE(DATA *data, threadData_t *threadData)
+{
+  double *v = data->localData[0]->realVars;
+  rhs(data->localData[0]->timeValue, v, v + NUM_STATES);
+  return 0;
+}
+
+static int functionNoop(DATA *data, threadData_t *threadData) { return 0; }
+
+/* no generated Jacobian, the multirate solver uses a dense pattern */
+static int initialAnalyticJacobianA(void *data, threadData_t *threadData) { return 1; }
+
+static int residual(double *t, double *x, double *xprime, double *cj, double *delta, int *ires, double *rpar, int* ipar)
+{
+  int i;
+  rhs(*t, x, delta);
+  for (i = 0; i < NUM_STATES; i++) {
+    delta[i] -= xprime[i];
+  }
+  return 0;
+}
+
+static const double x0[NUM_STATES] = {1.0, 1.0};
+
+/* states at STOP_TIME by DDASKR */
+static void reference(double *x)
+{
+  int neq = NUM_STATES, info[20] = {0}, idid = 0, ipar[1] = {0}, ng = 0, jroot[1];
+  int lrw = LRW, liw = LIW, iwork[LIW] = {0};
+  double rwork[LRW] = {0};
+  double t = 0.0, tout = STOP_TIME, rtol = 1e-12, atol = 1e-12, xprime[NUM_STATES], rpar[1];
+
+  memcpy(x, x0, sizeof(x0));
+  rhs(t, x, xprime);
+  DDASKR(residual, &neq, &t, x, xprime, &tout, info, &rtol, &atol, &idid, rwork, &lrw, iwork, &liw, rpar, ipar,
+         NULL, NULL, NULL, &ng, jroot);
+  CHECK(idid > 0, "DDASKR failed (idid %d)", idid);
+}
+
+/* states at STOP_TIME by the multirate solver with the macro step H */
+static void multirate(double H, double *x, int *ratio)
+{
+  static STATIC_REAL_DATA realVarsData[NUM_STATES];
+  static MODEL_DATA modelData;
+  static SIMULATION_DATA simulationData[2];
+  static SIMULATION_DATA *localData[2] = {&simulationData[0], &simulationData[1]};
+  static DATA data;
+  static struct OpenModelicaGeneratedFunctionCallbacks callbacks = {
+    .functionODE = functionODE,
+    .input_function = functionNoop,
+    .initialAnalyticJacobianA = initialAnalyticJacobianA
+  };
+  modelica_real realVars[2][2*NUM_STATES];
+  unsigned int solverStats[5] = {0};
+  SOLVER_INFO solverInfo = {0};
+  DATA_MULTIRATE *mr;
+  int steps = (int) floor(STOP_TIME/H + 0.5), step;
+
+  realVarsData[0].info.name = "x1";
+  realVarsData[1].info.name = "x2";
+  realVarsData[0].attribute.nominal = realVarsData[1].attribute.nominal = 1.0;
+  modelData.nStates = NUM_STATES;
+  modelData.nVariablesReal = 2*NUM_STATES;
+  modelData.realVarsData = realVarsData;
+  simulationData[0].realVars = realVars[0];
+  simulationData[1].realVars = realVars[1];
+  data.modelData = &modelData;
+  data.localData = localData;
+  data.callback = &callbacks;
+  solverInfo.solverStatsTmp = solverStats;
+  solverInfo.currentStepSize = H;
+
+  allocateMultirate(&data, NULL, &solverInfo);
+  mr = (DATA_MULTIRATE*) solverInfo.solverData;
+  simulationData[0].timeValue = 0.0;
+  memcpy(realVars[0], x0, sizeof(x0));
+  functionODE(&data, NULL);
+  for (step = 0; step < steps; step++) {
+    /* the ring buffer is rotated, the derivatives of the new states are evaluated by the caller */
+    simulationData[1].timeValue = simulationData[0].timeValue;
+    memcpy(realVars[1], realVars[0], sizeof(realVars[0]));
+    multirate_step(&data, NULL, &solverInfo);
+    functionODE(&data, NULL);
+  }
+  memcpy(x, realVars[0], NUM_STATES*sizeof(double));
+  *ratio = mr->nFast == 1 && mr->fastStates[0] == 1 ? mr->ratio : 0;
+  freeMultirate(&solverInfo);
+}
+
+static double maxError(const double *x, const double *ref)
+{
+  return fmax(fabs(x[0] - ref[0]), fabs(x[1] - ref[1]));
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  double ref[NUM_STATES], x[NUM_STATES], error, error1, error2;
+  int ratio, ratio1, ratio2;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  reference(ref);
+
+  multirate(5e-3, x, &ratio);
+  error = maxError(x, ref);
+  CHECK(ratio > 1, "x2 is not the only fast state or has no micro steps (%d)", ratio);
+  CHECK(error < 1e-5, "the multirate solution differs from DDASKR by %g, x1 %.12g (%.12g), x2 %.12g (%.12g)",
+        error, x[0], ref[0], x[1], ref[1]);
+
+  omc_flag[FLAG_MR_RATIO] = 1;
+  omc_flagValue[FLAG_MR_RATIO] = "2";
+  multirate(2e-2, x, &ratio1);
+  error1 = maxError(x, ref);
+  multirate(1e-2, x, &ratio2);
+  error2 = maxError(x, ref);
+  CHECK(ratio1 == 2 && ratio2 == 2, "%d and %d micro steps, expected 2", ratio1, ratio2);
+  CHECK(error1/error2 > 3.0, "halving the macro step reduced the error only by %g, expected 4 for second order", error1/error2);
+
+  printf("error %g with H = 5e-3 and %d micro steps\n", error, ratio);
+  printf("error %g with H = 2e-2, %g with H = 1e-2 and 2 micro steps\n", error1, error2);
+  return errors;
+}
@@ -0,0 +1,236 @@
+/* Runs a sweep of 24 runs over the gain k, the start value of x and the stop
+ * time of a fake model
+ *   der(x) = -k*x
+ * whose solver writes the explicit Euler steps of x as its CSV result, once
+ * with one model instance and once with four instances in parallel, both
+ * times with -batchResult=stacked.
+ * Checks that
+ *  - every run succeeds and the result files of the runs are removed,
+ *  - the stacked results of both sweeps are identical,
+ *  - the stacked file holds the runs in order with the values of their own
+ *    row of the matrix, i.e. the instances do not see each other's values,
+ *  - the start values of the loaded model are not changed by the runs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "simulation_data.h"
+#include "openmodelica_func.h"
+#include "util/omc_error.h"
+#include "meta/meta_modelica.h"
+#include "simulation/options.h"
+#include "simulation/simulation_batch.h"
+#include "simulation/solver/model_help.h"
+
+#define NUM_RUNS 24
+#define MATRIX_FILE "test_batch_matrix.csv"
+#define STEP_SIZE 0.01
+/* rows of the longest run, stopTime 0.7 */
+#define MAX_ROWS 71
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* simulation and solver library */
+int omc_flag[FLAG_MAX];
+const char *omc_flagValue[FLAG_MAX];
+int measure_time_flag = 0;
+int initializeMixedSystems(DATA *data, threadData_t *threadData) { return 0; }
+int initializeLinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int initializeNonlinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int freeMixedSystems(DATA *data, threadData_t *threadData) { return 0; }
+int freeLinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+int freeNonlinearSystems(DATA *data, threadData_t *threadData) { return 0; }
+
+void initializeDataStruc(DATA *data, threadData_t *threadData)
+{
+  MODEL_DATA *modelData = data->modelData;
+  modelData->realVarsData = (STATIC_REAL_DATA*) calloc(modelData->nVariablesReal, sizeof(STATIC_REAL_DATA));
+  modelData->realParameterData = (STATIC_REAL_DATA*) calloc(modelData->nParametersReal, sizeof(STATIC_REAL_DATA));
+}
+
+void deInitializeDataStruc(DATA *data)
+{
+  free(data->modelData->realVarsData);
+  free(data->modelData->realParameterData);
+}
+
+/* the explicit Euler steps of x, which run() repeats for the check */
+static void euler(double k, double x, double startTime, long numSteps, FILE *file, double *values)
+{
+  long i;
+  for (i = 0; i <= numSteps; i++) {
+    if (file) {
+      fprintf(file, "%.17g,%.17g\n", startTime + i*STEP_SIZE, x);
+    } else {
+      values[i] = x;
+    }
+    x -= STEP_SIZE*k*x;
+    /* lets the other instances interleave their steps */
+    sched_yield();
+  }
+}
+
+int runSimulation(DATA *data, threadData_t *threadData, const char *argv_0)
+{
+  const SIMULATION_INFO *simulationInfo = data->simulationInfo;
+  FILE *file = fopen(data->modelData->resultFileName, "w");
+  if (!file) {
+    return 1;
+  }
+  fprintf(file, "\"time\",\"x\"\n");
+  euler(data->modelData->realParameterData[0].attribute.start, data->modelData->realVarsData[0].attribute.start,
+        simulationInfo->startTime, (long) simulationInfo->numSteps, file, NULL);
+  fclose(file);
+  return 0;
+}
+
+static void callExternalObjectDestructors(DATA *data, threadData_t *threadData) {}
+
+/* model */
+static double gain(int run) { return 0.5 + run; }
+static double start(int run) { return 1.0 + 0.25*(run % 5); }
+static double stopTime(int run) { return 0.1*(1 + run % 7); }
+
+/* simulates the matrix with the given number of instances into <base>.csv */
+static int sweep(DATA *data, const char *base, const char *threads)
+{
+  char *argv[] = {"test_batch"};
+  char resultFile[64];
+  omc_flagValue[FLAG_BATCH] = MATRIX_FILE;
+  omc_flagValue[FLAG_BATCH_RESULT] = "stacked";
+  omc_flag[FLAG_BATCH_THREADS] = 1;
+  omc_flagValue[FLAG_BATCH_THREADS] = threads;
+  sprintf(resultFile, "%s.csv", base);
+  omc_flag[FLAG_R] = 1;
+  omc_flagValue[FLAG_R] = resultFile;
+  return runBatch(1, argv, data, NULL);
+}
+
+static char* readFile(const char *fileName)
+{
+  FILE *file = fopen(fileName, "rb");
+  long size;
+  char *content;
+  if (!file) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  content = (char*) calloc(size + 1, 1);
+  if (fread(content, 1, size, file) != (size_t) size) {
+    content[0] = '\0';
+  }
+  fclose(file);
+  return content;
+}
+
+/* checks the stacked file against the Euler steps of every run */
+static void checkStacked(const char *fileName)
+{
+  FILE *file = fopen(fileName, "r");
+  char header[64];
+  double values[MAX_ROWS], t, x;
+  int run, expectedRun = 0, row = 0, numRows = 0;
+
+  CHECK(file != NULL, "%s is missing", fileName);
+  if (!file) {
+    return;
+  }
+  CHECK(fgets(header, sizeof(header), file) && !strcmp(header, "\"run\",\"time\",\"x\"\n"), "%s: the header is wrong", fileName);
+  while (fscanf(file, "%d,%lf,%lf", &run, &t, &x) == 3) {
+    if (run != expectedRun) {
+      CHECK(expectedRun == 0 || row == numRows, "%s: run %d has %d rows, %d expected", fileName, expectedRun, row, numRows);
+      CHECK(run == expectedRun + 1, "%s: run %d follows run %d", fileName, run, expectedRun);
+      expectedRun = run;
+      row = 0;
+      numRows = (int) (stopTime(run-1)/STEP_SIZE + 0.5) + 1;
+      euler(gain(run-1), start(run-1), 0.0, numRows - 1, NULL, values);
+    }
+    CHECK(row < numRows && x == values[row], "%s: run %d, row %d: x = %.17g, expected %.17g", fileName, run, row, x,
+          row < numRows ? values[row] : 0.0);
+    row++;
+  }
+  CHECK(expectedRun == NUM_RUNS && row == numRows, "%s: ends with row %d of run %d", fileName, row, expectedRun);
+  fclose(file);
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  STATIC_REAL_DATA realVarsData[2], realParameterData[1];
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  DATA data;
+  struct OpenModelicaGeneratedFunctionCallbacks callbacks;
+  char fileName[64], *stacked1, *stacked4;
+  FILE *file;
+  int run;
+
+  MMC_INIT(0);
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  memset(realVarsData, 0, sizeof(realVarsData));
+  memset(realParameterData, 0, sizeof(realParameterData));
+  memset(&modelData, 0, sizeof(modelData));
+  memset(&simulationInfo, 0, sizeof(simulationInfo));
+  memset(&data, 0, sizeof(data));
+  memset(&callbacks, 0, sizeof(callbacks));
+  realVarsData[0].info.name = "x";
+  realVarsData[0].attribute.start = 7.0;
+  realVarsData[1].info.name = "der(x)";
+  realParameterData[0].info.name = "k";
+  realParameterData[0].attribute.start = 3.0;
+  modelData.modelFilePrefix = "test_batch";
+  modelData.realVarsData = realVarsData;
+  modelData.nVariablesReal = 2;
+  modelData.realParameterData = realParameterData;
+  modelData.nParametersReal = 1;
+  simulationInfo.startTime = 0.0;
+  simulationInfo.stopTime = 1.0;
+  simulationInfo.stepSize = STEP_SIZE;
+  simulationInfo.outputFormat = "csv";
+  callbacks.callExternalObjectDestructors = callExternalObjectDestructors;
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.callback = &callbacks;
+
+  file = fopen(MATRIX_FILE, "w");
+  fprintf(file, "k,x,stopTime\n");
+  for (run = 0; run < NUM_RUNS; run++) {
+    fprintf(file, "%.17g,%.17g,%.17g\n", gain(run), start(run), stopTime(run));
+  }
+  fclose(file);
+
+  CHECK(sweep(&data, "test_batch_1", "1") == 0, "the sweep with one instance failed");
+  CHECK(sweep(&data, "test_batch_4", "4") == 0, "the sweep with four instances failed");
+  for (run = 1; run <= NUM_RUNS; run++) {
+    sprintf(fileName, "test_batch_4_%d.csv", run);
+    file = fopen(fileName, "r");
+    CHECK(file == NULL, "the result file %s of run %d was not removed", fileName, run);
+    if (file) {
+      fclose(file);
+    }
+  }
+
+  stacked1 = readFile("test_batch_1.csv");
+  stacked4 = readFile("test_batch_4.csv");
+  CHECK(stacked1 && stacked4 && !strcmp(stacked1, stacked4), "the stacked results with one and four instances differ");
+  checkStacked("test_batch_4.csv");
+  CHECK(realParameterData[0].attribute.start == 3.0 && realVarsData[0].attribute.start == 7.0,
+        "the start values of the loaded model were changed to k = %g, x = %g", realParameterData[0].attribute.start,
+        realVarsData[0].attribute.start);
+
+  free(stacked1);
+  free(stacked4);
+  remove(MATRIX_FILE);
+  remove("test_batch_1.csv");
+  remove("test_batch_4.csv");
+  return errors;
+}
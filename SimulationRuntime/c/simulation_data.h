@@ -162,11 +162,13 @@ typedef struct ANALYTIC_JACOBIAN
 typedef struct EXTERNAL_INPUT
 {
   modelica_boolean active;
-  modelica_real** u;
-  modelica_real* t;
-  modelica_integer N;
-  modelica_integer n;
-  modelica_integer i;
+  modelica_real* u;                    /* current window, the nu inputs of a row are contiguous */
+  modelica_real* t;                    /* time column of the current window */
+  modelica_integer nu;                 /* number of inputs per row */
+  modelica_integer n;                  /* number of rows in the current window */
+  modelica_integer i;                  /* cursor, t[i] <= time <= t[i+1] */
+  modelica_integer offset;             /* row of t[0] in the input file */
+  void* stream;                        /* file reader and prefetch thread, see external_input.c */
 }EXTERNAL_INPUT;
 
 /* Alias data with various types*/
@@ -433,6 +435,8 @@ typedef struct MODEL_DATA
   const char* modelDir;
   const char* modelGUID;
   const char* initXMLData;
+  void* initImage;                     /* mapped binary init image (see -initCache), NULL if the XML data was parsed */
+  modelica_boolean sharesStaticData;   /* instance of a batch run: the variable infos and the init image belong to the loaded model */
 
   long nSamples;                       /* number of different sample-calls */
   SAMPLE_INFO* samplesInfo;            /* array containing each sample-call */
@@ -36,9 +36,8 @@
 
 #include "omc_inline.h"
 #include "ModelicaUtilities.h"
-#ifdef _MSC_VER
 #include "omc_msvc.h"
-#endif
+#include "OldModelicaTables.h"
 
 /* Definition to get some Debug information if interface is called */
 /* #define INFOS */
@@ -74,11 +73,6 @@ typedef struct InterpolationTable2D
   int expoType;
 } InterpolationTable2D;
 
-static InterpolationTable** interpolationTables=NULL;
-static int ninterpolationTables=0;
-static InterpolationTable2D** interpolationTables2D=NULL;
-static int ninterpolationTables2D=0;
-
 static InterpolationTable *InterpolationTable_init(double time,double startTime, int ipoType, int expoType,
          const char* tableName, const char* fileName,
          const double *table,
@@ -107,6 +101,61 @@ static const double InterpolationTable2D_getElt(InterpolationTable2D *tpl, size_
 static void InterpolationTable2D_checkValidityOfData(InterpolationTable2D *tpl);
 
 
+/* The table ids handed out to the model index these arrays. Every model
+ * instance has its own group of tables, shared by all threads working for
+ * it; threads outside a group use the tables of the process. The tables are
+ * created while the instance is initialized, before its worker threads
+ * interpolate, so reading them needs no lock. */
+struct table_group
+{
+  InterpolationTable** interpolationTables;
+  int ninterpolationTables;
+  InterpolationTable2D** interpolationTables2D;
+  int ninterpolationTables2D;
+};
+
+static table_group process_tables = {NULL, 0, NULL, 0};
+static OMC_THREAD_LOCAL table_group *thread_tables = NULL;
+
+static inline table_group* current_tables(void)
+{
+  return thread_tables ? thread_tables : &process_tables;
+}
+
+table_group* table_group_new(void)
+{
+  return (table_group*) calloc(1, sizeof(table_group));
+}
+
+void table_group_join(table_group *group)
+{
+  thread_tables = group;
+}
+
+void table_group_free(table_group *group)
+{
+  int i;
+  if (!group) {
+    return;
+  }
+  if (thread_tables == group) {
+    thread_tables = NULL;
+  }
+  for (i = 0; i < group->ninterpolationTables; ++i) {
+    if (group->interpolationTables[i]) {
+      InterpolationTable_deinit(group->interpolationTables[i]);
+    }
+  }
+  for (i = 0; i < group->ninterpolationTables2D; ++i) {
+    if (group->interpolationTables2D[i]) {
+      InterpolationTable2D_deinit(group->interpolationTables2D[i]);
+    }
+  }
+  free(group->interpolationTables);
+  free(group->interpolationTables2D);
+  free(group);
+}
+
 
 /* Initialize table.
  * timeIn - time
@@ -131,14 +180,15 @@ int omcTableTimeIni(double timeIn, double startTime,int ipoType,int expoType,
         const char *tableName, const char* fileName,
         const double *table,int tableDim1, int tableDim2,int colWise)
 {
+  table_group *tables = current_tables();
   int i = 0;
   InterpolationTable** tmp = NULL;
 #ifdef INFOS
   INFO10("Init Table \n timeIn %f \n startTime %f \n ipoType %d \n expoType %d \n tableName %s \n fileName %s \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", timeIn, startTime, ipoType, expoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
   /* if table is already initialized, find it */
-  for(i = 0; i < ninterpolationTables; ++i)
-    if(InterpolationTable_compare(interpolationTables[i],fileName,tableName,table))
+  for(i = 0; i < tables->ninterpolationTables; ++i)
+    if(InterpolationTable_compare(tables->interpolationTables[i],fileName,tableName,table))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
@@ -146,54 +196,59 @@ int omcTableTimeIni(double timeIn, double startTime,int ipoType,int expoType,
       return i;
     }
 #ifdef INFOS
-  infoStreamPrint("Table id = %d",ninterpolationTables);
+  infoStreamPrint("Table id = %d",tables->ninterpolationTables);
 #endif
   /* increase array */
-  tmp = (InterpolationTable**)malloc((ninterpolationTables+1)*sizeof(InterpolationTable*));
+  tmp = (InterpolationTable**)malloc((tables->ninterpolationTables+1)*sizeof(InterpolationTable*));
   if (!tmp) {
-    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables, tableName, fileName);
+    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)tables->ninterpolationTables, tableName, fileName);
   }
-  for(i = 0; i < ninterpolationTables; ++i)
+  for(i = 0; i < tables->ninterpolationTables; ++i)
   {
-    tmp[i] = interpolationTables[i];
+    tmp[i] = tables->interpolationTables[i];
   }
-  free(interpolationTables);
-  interpolationTables = tmp;
-  ninterpolationTables++;
+  free(tables->interpolationTables);
+  tables->interpolationTables = tmp;
+  tables->ninterpolationTables++;
   /* otherwise initialize new table */
-  interpolationTables[ninterpolationTables-1] = InterpolationTable_init(timeIn,startTime,
+  tables->interpolationTables[tables->ninterpolationTables-1] = InterpolationTable_init(timeIn,startTime,
                    ipoType,expoType,
                    tableName, fileName,
                    table, tableDim1,
                    tableDim2, colWise);
-  return (ninterpolationTables-1);
+  return (tables->ninterpolationTables-1);
 }
 
 
 void omcTableTimeIpoClose(int tableID)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables)
   {
-    InterpolationTable_deinit(interpolationTables[tableID]);
-    interpolationTables[tableID] = NULL;
-    ninterpolationTables--;
+    InterpolationTable_deinit(tables->interpolationTables[tableID]);
+    tables->interpolationTables[tableID] = NULL;
+    tables->ninterpolationTables--;
+  }
+  if(tables->ninterpolationTables <=0)
+  {
+    free(tables->interpolationTables);
+    tables->interpolationTables = NULL;
   }
-  if(ninterpolationTables <=0)
-    free(interpolationTables);
 }
 
 
 double omcTableTimeIpo(int tableID, int icol, double timeIn)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,icol,timeIn);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables)
   {
-    return InterpolationTable_interpolate(interpolationTables[tableID],timeIn,icol-1);
+    return InterpolationTable_interpolate(tables->interpolationTables[tableID],timeIn,icol-1);
   }
   else
     return 0.0;
@@ -202,11 +257,12 @@ double omcTableTimeIpo(int tableID, int icol, double timeIn)
 
 double omcTableTimeTmax(int tableID)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Time max from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
-    return InterpolationTable_maxTime(interpolationTables[tableID]);
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables)
+    return InterpolationTable_maxTime(tables->interpolationTables[tableID]);
   else
     return 0.0;
 }
@@ -214,11 +270,12 @@ double omcTableTimeTmax(int tableID)
 
 double omcTableTimeTmin(int tableID)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Time min from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
-    return InterpolationTable_minTime(interpolationTables[tableID]);
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables)
+    return InterpolationTable_minTime(tables->interpolationTables[tableID]);
   else
     return 0.0;
 }
@@ -227,14 +284,15 @@ double omcTableTimeTmin(int tableID)
 int omcTable2DIni(int ipoType, const char *tableName, const char* fileName,
       const double *table,int tableDim1,int tableDim2,int colWise)
 {
+  table_group *tables = current_tables();
   int i=0;
   InterpolationTable2D** tmp = NULL;
 #ifdef INFOS
   infoStreamPrint("Init Table \n ipoType %f \n tableName %f \n fileName %d \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", ipoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
   /* if table is already initialized, find it */
-  for(i = 0; i < ninterpolationTables2D; ++i)
-    if(InterpolationTable2D_compare(interpolationTables2D[i],fileName,tableName,table))
+  for(i = 0; i < tables->ninterpolationTables2D; ++i)
+    if(InterpolationTable2D_compare(tables->interpolationTables2D[i],fileName,tableName,table))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
@@ -242,50 +300,55 @@ int omcTable2DIni(int ipoType, const char *tableName, const char* fileName,
       return i;
     }
 #ifdef INFOS
-  infoStreamPrint("Table id = %d",ninterpolationTables2D);
+  infoStreamPrint("Table id = %d",tables->ninterpolationTables2D);
 #endif
   /* increase array */
-  tmp = (InterpolationTable2D**)malloc((ninterpolationTables2D+1)*sizeof(InterpolationTable2D*));
+  tmp = (InterpolationTable2D**)malloc((tables->ninterpolationTables2D+1)*sizeof(InterpolationTable2D*));
   if (!tmp) {
-    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)ninterpolationTables, tableName, fileName);
+    ModelicaFormatError("Not enough memory for new Table[%lu] Tablename %s Filename %s", (unsigned long)tables->ninterpolationTables, tableName, fileName);
   }
-  for(i = 0; i < ninterpolationTables2D; ++i)
+  for(i = 0; i < tables->ninterpolationTables2D; ++i)
   {
-    tmp[i] = interpolationTables2D[i];
+    tmp[i] = tables->interpolationTables2D[i];
   }
-  free(interpolationTables2D);
-  interpolationTables2D = tmp;
-  ninterpolationTables2D++;
+  free(tables->interpolationTables2D);
+  tables->interpolationTables2D = tmp;
+  tables->ninterpolationTables2D++;
   /* otherwise initialize new table */
-  interpolationTables2D[ninterpolationTables2D-1] = InterpolationTable2D_init(ipoType,tableName,
+  tables->interpolationTables2D[tables->ninterpolationTables2D-1] = InterpolationTable2D_init(ipoType,tableName,
                       fileName,table,tableDim1,tableDim2,colWise);
-  return (ninterpolationTables2D-1);
+  return (tables->ninterpolationTables2D-1);
 }
 
 
 void omcTable2DIpoClose(int tableID)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables2D)
+  {
+    InterpolationTable2D_deinit(tables->interpolationTables2D[tableID]);
+    tables->interpolationTables2D[tableID] = NULL;
+    tables->ninterpolationTables2D--;
+  }
+  if(tables->ninterpolationTables2D <=0)
   {
-    InterpolationTable2D_deinit(interpolationTables2D[tableID]);
-    interpolationTables2D[tableID] = NULL;
-    ninterpolationTables2D--;
+    free(tables->interpolationTables2D);
+    tables->interpolationTables2D = NULL;
   }
-  if(ninterpolationTables2D <=0)
-    free(interpolationTables2D);
 }
 
 
 double omcTable2DIpo(int tableID,double u1_, double u2_)
 {
+  table_group *tables = current_tables();
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,u1_,u2_);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
-    return InterpolationTable2D_interpolate(interpolationTables2D[tableID], u1_, u2_);
+  if(tableID >= 0 && tableID < (int)tables->ninterpolationTables2D)
+    return InterpolationTable2D_interpolate(tables->interpolationTables2D[tableID], u1_, u2_);
   else
     return 0.0;
 }
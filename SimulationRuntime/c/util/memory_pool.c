@@ -50,16 +50,114 @@ typedef struct list_s {
   struct list_s *next;
 } list;
 
-static pthread_mutex_t memory_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
-static list *memory_pools = NULL;
+/* Each thread allocates from its own pool, so pool_free in one model
+ * instance never releases memory another instance is still using.
+ * The pools of the threads working for one instance form a group:
+ * pool_free resets all pools of the calling thread's group. It is called by
+ * the instance between steps, while its worker threads (e.g. OpenMP) are
+ * idle. A thread that did not join a group with pool_group_join only resets
+ * its own pool, since other threads outside a group may belong to other
+ * instances. A pool is given back when its thread exits. */
+typedef struct pool_state {
+  list *head;
+  pool_group *group;             /* NULL outside a group */
+  struct pool_state *next;       /* next pool of the group */
+} pool_state;
+
+struct pool_group {
+  pool_state *pools;
+};
+
+/* protects the pool lists of all groups */
+static pthread_mutex_t pool_group_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static OMC_THREAD_LOCAL list *memory_pools = NULL;
+static OMC_THREAD_LOCAL pool_state *thread_pool = NULL;
+static OMC_THREAD_LOCAL pool_group *thread_pool_group = NULL;
+static pthread_key_t memory_pool_key;
+static pthread_once_t memory_pool_key_once = PTHREAD_ONCE_INIT;
+
+static void pool_free_list(list *freelist)
+{
+  while (freelist) {
+    list *next = freelist->next;
+    free(freelist->memory);
+    free(freelist);
+    freelist = next;
+  }
+}
+
+/* the caller holds pool_group_mutex */
+static void pool_unlink(pool_state *state)
+{
+  pool_state **p;
+  if (!state->group) {
+    return;
+  }
+  for (p = &state->group->pools; *p; p = &(*p)->next) {
+    if (*p == state) {
+      *p = state->next;
+      break;
+    }
+  }
+  state->group = NULL;
+  state->next = NULL;
+}
+
+/* the caller holds pool_group_mutex */
+static void pool_link(pool_state *state, pool_group *group)
+{
+  if (!group) {
+    return;
+  }
+  state->group = group;
+  state->next = group->pools;
+  group->pools = state;
+}
+
+static void pool_thread_exit(void *ptr)
+{
+  pool_state *state = (pool_state*) ptr;
+  pthread_mutex_lock(&pool_group_mutex);
+  pool_unlink(state);
+  pthread_mutex_unlock(&pool_group_mutex);
+  pool_free_list(state->head);
+  free(state);
+  memory_pools = NULL;
+  thread_pool = NULL;
+}
+
+static void pool_key_create(void)
+{
+  pthread_key_create(&memory_pool_key, pool_thread_exit);
+}
+
+static void pool_set_head(list *head)
+{
+  if (!thread_pool) {
+    thread_pool = (pool_state*) calloc(1, sizeof(pool_state));
+    pthread_setspecific(memory_pool_key, thread_pool);
+    pthread_mutex_lock(&pool_group_mutex);
+    pool_link(thread_pool, thread_pool_group);
+    pthread_mutex_unlock(&pool_group_mutex);
+  }
+  thread_pool->head = head;
+  memory_pools = head;
+}
 
 static void pool_init(void)
 {
-  memory_pools = (list*) malloc(sizeof(list));
-  memory_pools->used = 0;
-  memory_pools->size = 2*1024*1024; /* 2MB pool by default */
-  memory_pools->memory = malloc(memory_pools->size);
-  memory_pools->next = NULL;
+  list *head;
+  pthread_once(&memory_pool_key_once, pool_key_create);
+  if (memory_pools) {
+    return;
+  }
+  head = (list*) malloc(sizeof(list));
+  head->used = 0;
+  head->size = 2*1024*1024; /* 2MB pool by default */
+  head->memory = malloc(head->size);
+  head->next = NULL;
+  pool_set_head(head);
 }
 
 static unsigned long upper_power_of_two(unsigned long v)
@@ -88,39 +186,96 @@ static inline void pool_expand(size_t len)
   }
   newlist = (list*) malloc(sizeof(list));
   newlist->next = memory_pools;
-  memory_pools = newlist;
-  memory_pools->used = 0;
-  memory_pools->size = upper_power_of_two(3*memory_pools->next->size/2 + len); /* expand by 1.5x the old memory pool. More if we request a very large array. */
-  memory_pools->memory = malloc(memory_pools->size);
+  newlist->used = 0;
+  newlist->size = upper_power_of_two(3*memory_pools->size/2 + len); /* expand by 1.5x the old memory pool. More if we request a very large array. */
+  newlist->memory = malloc(newlist->size);
+  pool_set_head(newlist);
 }
 
 static void* pool_malloc(size_t sz)
 {
   void *res;
   sz = round_up(sz,8);
-  pthread_mutex_lock(&memory_pool_mutex);
+  if (!memory_pools) {
+    pool_init();
+  }
   pool_expand(sz);
   res = (void*)((char*)memory_pools->memory + memory_pools->used);
   memory_pools->used += sz;
-  pthread_mutex_unlock(&memory_pool_mutex);
   memset(res,0,sz);
   return res;
 }
 
+/* keeps the newest and largest block of the pool */
+static void pool_reset(list *head)
+{
+  pool_free_list(head->next);
+  head->used = 0;
+  head->next = 0;
+}
+
 static int pool_free(void)
 {
-  list *freelist = memory_pools->next;
-  while (freelist) {
-    list *next = freelist->next;
-    free(freelist->memory);
-    free(freelist);
-    freelist = next;
+  pool_state *state;
+  if (!memory_pools) {
+    return 0;
+  }
+  /* outside a group no other thread touches the pool */
+  if (!thread_pool_group) {
+    pool_reset(memory_pools);
+    return 0;
+  }
+  pthread_mutex_lock(&pool_group_mutex);
+  if (thread_pool->group) {
+    for (state = thread_pool->group->pools; state; state = state->next) {
+      if (state->head) {
+        pool_reset(state->head);
+      }
+    }
+  } else {
+    pool_reset(memory_pools);
   }
-  memory_pools->used = 0;
-  memory_pools->next = 0;
+  pthread_mutex_unlock(&pool_group_mutex);
   return 0;
 }
 
+pool_group* pool_group_new(void)
+{
+  return (pool_group*) calloc(1, sizeof(pool_group));
+}
+
+void pool_group_join(pool_group *group)
+{
+  thread_pool_group = group;
+  if (thread_pool) {
+    pthread_mutex_lock(&pool_group_mutex);
+    pool_unlink(thread_pool);
+    pool_link(thread_pool, group);
+    pthread_mutex_unlock(&pool_group_mutex);
+  }
+}
+
+void pool_group_free(pool_group *group)
+{
+  if (!group) {
+    return;
+  }
+  if (thread_pool_group == group) {
+    thread_pool_group = NULL;
+  }
+  pthread_mutex_lock(&pool_group_mutex);
+  /* threads still in the group continue with their own pools outside a group */
+  while (group->pools) {
+    pool_unlink(group->pools);
+  }
+  pthread_mutex_unlock(&pool_group_mutex);
+  /* the memory of the calling thread is not used by anyone else anymore */
+  if (memory_pools) {
+    pool_reset(memory_pools);
+  }
+  free(group);
+}
+
 static void nofree(void* ptr)
 {
 }
@@ -48,6 +48,17 @@ extern _index_t** index_alloc(int n);
 
 void* generic_alloc(int n, size_t sze);
 
+/* The pools of omc_alloc_interface_pooled of the threads working for one
+ * model instance. A thread joins the group of its instance before it
+ * allocates, NULL leaves the group. collect_a_little resets all pools of the
+ * calling thread's group, or only the thread's own pool outside a group.
+ * pool_group_free takes the threads still in the group out of it. */
+typedef struct pool_group pool_group;
+
+pool_group* pool_group_new(void);
+void pool_group_join(pool_group *group);
+void pool_group_free(pool_group *group);
+
 #if defined(__cplusplus)
 } /* end extern "C" */
 #endif
@@ -30,6 +30,7 @@
 
 #include "setjmp.h"
 #include <stdio.h>
+#include <string.h>
 #include "omc_error.h"
 /* For MMC_THROW, so we can end this thing */
 #include "meta/meta_modelica.h"
@@ -133,10 +134,11 @@ static const char *LOG_TYPE_DESC[LOG_TYPE_MAX] = {
   "debug"
 };
 
-int useStream[SIM_LOG_MAX];
-int level[SIM_LOG_MAX];
-int lastType[SIM_LOG_MAX];
-int lastStream = LOG_UNKNOWN;
+int useStreamDefault[SIM_LOG_MAX];
+OMC_THREAD_LOCAL int *useStream = useStreamDefault;
+OMC_THREAD_LOCAL int level[SIM_LOG_MAX];
+OMC_THREAD_LOCAL int lastType[SIM_LOG_MAX];
+OMC_THREAD_LOCAL int lastStream = LOG_UNKNOWN;
 int showAllWarnings = 0;
 
 #ifdef USE_DEBUG_TRACE
@@ -159,6 +161,16 @@ void initDumpSystem()
   useStream[LOG_ASSERT] = 1;
 }
 
+void omc_set_thread_streams(int *streams)
+{
+  if (streams) {
+    memcpy(streams, useStream, SIM_LOG_MAX*sizeof(int));
+    useStream = streams;
+  } else {
+    useStream = useStreamDefault;
+  }
+}
+
 void printInfo(FILE *stream, FILE_INFO info)
 {
   fprintf(stream, "[%s:%d:%d-%d:%d:%s]", info.filename, info.lineStart, info.colStart, info.lineEnd, info.colEnd, info.readonly ? "readonly" : "writable");
@@ -312,7 +324,7 @@ static void messageCloseXMLWarning(int stream)
   }
 }
 
-static void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes) = messageText;
+void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes) = messageText;
 void (*messageClose)(int stream) = messageCloseText;
 void (*messageCloseWarning)(int stream) = messageCloseTextWarning;
 
@@ -339,7 +351,7 @@ void va_infoStreamPrint(int stream, int indentNext, const char *format, va_list
   }
 }
 
-void infoStreamPrintWithEquationIndexes(int stream, int indentNext, const int *indexes, const char *format, ...)
+void (infoStreamPrintWithEquationIndexes)(int stream, int indentNext, const int *indexes, const char *format, ...)
 {
   if (useStream[stream]) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -351,7 +363,7 @@ void infoStreamPrintWithEquationIndexes(int stream, int indentNext, const int *i
   }
 }
 
-void infoStreamPrint(int stream, int indentNext, const char *format, ...)
+void (infoStreamPrint)(int stream, int indentNext, const char *format, ...)
 {
   if (useStream[stream]) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -363,7 +375,7 @@ void infoStreamPrint(int stream, int indentNext, const char *format, ...)
   }
 }
 
-void warningStreamPrintWithEquationIndexes(int stream, int indentNext, const int *indexes, const char *format, ...)
+void (warningStreamPrintWithEquationIndexes)(int stream, int indentNext, const int *indexes, const char *format, ...)
 {
   if (ACTIVE_WARNING_STREAM(stream)) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -375,7 +387,7 @@ void warningStreamPrintWithEquationIndexes(int stream, int indentNext, const int
   }
 }
 
-void warningStreamPrint(int stream, int indentNext, const char *format, ...)
+void (warningStreamPrint)(int stream, int indentNext, const char *format, ...)
 {
   if (ACTIVE_WARNING_STREAM(stream)) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -431,7 +443,7 @@ void va_errorStreamPrintWithEquationIndexes(int stream, int indentNext, const in
 }
 
 #ifdef USE_DEBUG_OUTPUT
-void debugStreamPrint(int stream, int indentNext, const char *format, ...)
+void (debugStreamPrint)(int stream, int indentNext, const char *format, ...)
 {
   if (useStream[stream]) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -443,7 +455,7 @@ void debugStreamPrint(int stream, int indentNext, const char *format, ...)
   }
 }
 
-void debugStreamPrintWithEquationIndexes(int stream, int indentNext, const int *indexes, const char *format, ...)
+void (debugStreamPrintWithEquationIndexes)(int stream, int indentNext, const int *indexes, const char *format, ...)
 {
   if (useStream[stream]) {
     char logBuffer[SIZE_LOG_BUFFER];
@@ -136,12 +136,19 @@ enum LOG_TYPE
   LOG_TYPE_MAX
 };
 
-extern int useStream[SIM_LOG_MAX];
-extern int level[SIM_LOG_MAX];
-extern int lastType[SIM_LOG_MAX];
-extern int lastStream;
+/* useStream points to the log flags of the calling thread. All threads
+ * share useStreamDefault unless omc_set_thread_streams gave them their own,
+ * which allows model instances with different -lv in one process. */
+extern int useStreamDefault[SIM_LOG_MAX];
+extern OMC_THREAD_LOCAL int *useStream;
+extern OMC_THREAD_LOCAL int level[SIM_LOG_MAX];
+extern OMC_THREAD_LOCAL int lastType[SIM_LOG_MAX];
+extern OMC_THREAD_LOCAL int lastStream;
 extern int showAllWarnings;
-extern char logBuffer[2048];
+
+/* streams must hold SIM_LOG_MAX flags; it is initialized from the flags the
+ * thread used so far. NULL switches back to useStreamDefault. */
+void omc_set_thread_streams(int *streams);
 
 void setStreamPrintXML(int isXML);
 
@@ -164,6 +171,8 @@ void setStreamPrintXML(int isXML);
   #define TRACE_POP
 #endif
 
+/* the message backend; replaced e.g. to hand messages over to another thread */
+extern void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes);
 extern void (*messageClose)(int stream);
 extern void (*messageCloseWarning)(int stream);
 extern void va_infoStreamPrint(int stream, int indentNext, const char *format, va_list ap);
@@ -180,6 +189,15 @@ extern void va_throwStreamPrint(threadData_t *threadData, const char *format, va
 extern void throwStreamPrint(threadData_t *threadData, const char *format, ...) __attribute__ ((format (printf, 2, 3), noreturn));
 extern void throwStreamPrintWithEquationIndexes(threadData_t *threadData, const int *indexes, const char *format, ...) __attribute__ ((format (printf, 3, 4), noreturn));
 #ifdef HAVE_VA_MACROS
+/* Check the stream before evaluating the arguments. The functions check it
+ * again, so calling them directly (e.g. as (infoStreamPrint)(...)) is
+ * equivalent, only slower if the stream is not active. The stream is
+ * evaluated once. */
+#define OMC_STREAM_PRINT_IF(active, fn, stream, ...) do { const int omc_stream_ = (stream); if (active(omc_stream_)) fn(omc_stream_, __VA_ARGS__); } while (0)
+#define infoStreamPrint(stream, ...) OMC_STREAM_PRINT_IF(ACTIVE_STREAM, infoStreamPrint, stream, __VA_ARGS__)
+#define infoStreamPrintWithEquationIndexes(stream, ...) OMC_STREAM_PRINT_IF(ACTIVE_STREAM, infoStreamPrintWithEquationIndexes, stream, __VA_ARGS__)
+#define warningStreamPrint(stream, ...) OMC_STREAM_PRINT_IF(ACTIVE_WARNING_STREAM, warningStreamPrint, stream, __VA_ARGS__)
+#define warningStreamPrintWithEquationIndexes(stream, ...) OMC_STREAM_PRINT_IF(ACTIVE_WARNING_STREAM, warningStreamPrintWithEquationIndexes, stream, __VA_ARGS__)
 #define assertStreamPrint(threadData, cond, ...) (cond) ? (void) 0 : throwStreamPrint((threadData), __VA_ARGS__)
 #else
 static void OMC_INLINE assertStreamPrint(threadData_t *threadData, int cond, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
@@ -217,6 +235,18 @@ static OMC_INLINE void debugStreamPrintWithEquationIndexes(int stream __attribut
 static OMC_INLINE void debugStreamPrintWithEquationIndexes(int stream  __attribute__((unused)), int indentNext __attribute__((unused)), const int *indexes __attribute__((unused)), const char *format __attribute__((unused)), ...)  {/* Do nothing */}
 #endif
 
+#ifdef HAVE_VA_MACROS
+/* without USE_DEBUG_OUTPUT the arguments are not evaluated at all, but still
+ * count as used and are checked against the format */
+#if defined(USE_DEBUG_OUTPUT)
+#define debugStreamPrint(stream, ...) OMC_STREAM_PRINT_IF(DEBUG_STREAM, debugStreamPrint, stream, __VA_ARGS__)
+#define debugStreamPrintWithEquationIndexes(stream, ...) OMC_STREAM_PRINT_IF(DEBUG_STREAM, debugStreamPrintWithEquationIndexes, stream, __VA_ARGS__)
+#else
+#define debugStreamPrint(stream, ...) do { if (0) (debugStreamPrint)(stream, __VA_ARGS__); } while (0)
+#define debugStreamPrintWithEquationIndexes(stream, ...) do { if (0) (debugStreamPrintWithEquationIndexes)(stream, __VA_ARGS__); } while (0)
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
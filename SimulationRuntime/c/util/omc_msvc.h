@@ -76,6 +76,8 @@ static union MSVC_FLOAT_HACK __NAN = {{0x00, 0x00, 0xC0, 0x7F}};
 /* get rid of inline for MSVC */
 #define OMC_INLINE
 
+#define OMC_THREAD_LOCAL __declspec(thread)
+
 #ifndef WIN32
 #define WIN32
 #endif
@@ -113,6 +115,8 @@ unsigned int alarm (unsigned int seconds);
 /* define inline for non-MSVC */
 #define OMC_INLINE inline
 
+#define OMC_THREAD_LOCAL __thread
+
 #endif /* end msvc */
 
 #if defined(__MINGW32__)
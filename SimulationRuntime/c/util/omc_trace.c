@@ -0,0 +1,217 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "omc_trace.h"
+#include "omc_error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define OMC_TRACE_CAS(ptr, old, new) (InterlockedCompareExchangePointer((PVOID*)(ptr), (new), (old)) == (old))
+#define OMC_TRACE_FETCH_ADD(ptr, n) InterlockedExchangeAdd((LONG*)(ptr), (n))
+#else
+#define OMC_TRACE_CAS(ptr, old, new) __sync_bool_compare_and_swap((ptr), (old), (new))
+#define OMC_TRACE_FETCH_ADD(ptr, n) __sync_fetch_and_add((ptr), (n))
+#endif
+
+static const char *OMC_TRACE_EVENT_NAME[OMC_TRACE_MAX_EVENT] = {
+  /* OMC_TRACE_UNKNOWN */              "unknown",
+  /* OMC_TRACE_DELAY_FIND_TIME */      "delayFindTime",
+  /* OMC_TRACE_NLS_VALUES_ADD */       "nlsValuesAdd",
+  /* OMC_TRACE_ZEROCROSSING_CHANGED */ "zeroCrossingChanged",
+  /* OMC_TRACE_LS_KLU_SOLVE */         "lsKluSolve",
+  /* OMC_TRACE_LS_UMFPACK_SOLVE */     "lsUmfpackSolve"
+};
+
+/* Each ring is only written by the thread owning it. The rings of all
+ * threads are kept in a list so omc_trace_close can write what is left. */
+typedef struct OMC_TRACE_RING
+{
+  OMC_TRACE_RECORD *records;
+  unsigned int pos;
+  uint16_t thread;
+  struct OMC_TRACE_RING *next;
+} OMC_TRACE_RING;
+
+int omc_trace_active = 0;
+
+static FILE *traceFile = NULL;
+static pthread_mutex_t traceFileMutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int traceRingSize = OMC_TRACE_DEFAULT_RING_SIZE;
+static OMC_TRACE_RING *volatile traceRings = NULL;
+static volatile int traceNumThreads = 0;
+/* incremented by omc_trace_close so threads drop rings of an earlier trace */
+static volatile int traceGeneration = 0;
+
+static OMC_THREAD_LOCAL OMC_TRACE_RING *threadRing = NULL;
+static OMC_THREAD_LOCAL int threadGeneration = -1;
+
+static OMC_TRACE_RING* newRing()
+{
+  OMC_TRACE_RING *ring = (OMC_TRACE_RING*) calloc(1, sizeof(OMC_TRACE_RING));
+  OMC_TRACE_RING *head;
+  if (ring) {
+    ring->records = (OMC_TRACE_RECORD*) malloc(traceRingSize * sizeof(OMC_TRACE_RECORD));
+  }
+  if (NULL == ring || NULL == ring->records) {
+    free(ring);
+    return NULL;
+  }
+  ring->thread = (uint16_t) OMC_TRACE_FETCH_ADD(&traceNumThreads, 1);
+  do {
+    head = traceRings;
+    ring->next = head;
+  } while (!OMC_TRACE_CAS(&traceRings, head, ring));
+  threadRing = ring;
+  threadGeneration = traceGeneration;
+  return ring;
+}
+
+/* Appends the records to the file; only called when a ring is full or the trace is closed */
+static void flushRing(OMC_TRACE_RING *ring)
+{
+  if (ring->pos) {
+    pthread_mutex_lock(&traceFileMutex);
+    if (traceFile) {
+      fwrite(ring->records, sizeof(OMC_TRACE_RECORD), ring->pos, traceFile);
+    }
+    pthread_mutex_unlock(&traceFileMutex);
+  }
+  ring->pos = 0;
+}
+
+void omc_trace_record(int stream, int event, int numValues, double v0, double v1, double v2, double v3)
+{
+  OMC_TRACE_RING *ring = threadRing;
+  OMC_TRACE_RECORD *rec;
+
+  if (NULL == ring || threadGeneration != traceGeneration) {
+    ring = newRing();
+    if (NULL == ring) {
+      return;
+    }
+  }
+
+  rec = ring->records + ring->pos;
+  rec->stream = (uint16_t) stream;
+  rec->event = (uint16_t) event;
+  rec->thread = ring->thread;
+  rec->numValues = (uint16_t) numValues;
+  rec->values[0] = v0;
+  rec->values[1] = v1;
+  rec->values[2] = v2;
+  rec->values[3] = v3;
+
+  if (++ring->pos == traceRingSize) {
+    flushRing(ring);
+  }
+}
+
+static void writeName(const char *name, uint32_t *size)
+{
+  size_t len = strlen(name) + 1;
+  fwrite(name, len, 1, traceFile);
+  *size += (uint32_t) len;
+}
+
+int omc_trace_open(const char *filename, unsigned int ringSize)
+{
+  static const char zeros[8] = {0};
+  OMC_TRACE_HEADER header;
+  int i;
+
+  if (omc_trace_active) {
+    omc_trace_close();
+  }
+
+  traceFile = fopen(filename, "wb");
+  if (NULL == traceFile) {
+    warningStreamPrint(LOG_STDOUT, 0, "Could not open the binary trace file %s: %s", filename, strerror(errno));
+    return 1;
+  }
+  traceRingSize = ringSize > 0 ? ringSize : OMC_TRACE_DEFAULT_RING_SIZE;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, OMC_TRACE_MAGIC, sizeof(header.magic));
+  header.version = OMC_TRACE_VERSION;
+  header.recordSize = sizeof(OMC_TRACE_RECORD);
+  header.numStreams = SIM_LOG_MAX;
+  header.numEvents = OMC_TRACE_MAX_EVENT;
+
+  /* the names are written first to know their size */
+  fseek(traceFile, sizeof(header), SEEK_SET);
+  for (i = 0; i < SIM_LOG_MAX; i++) {
+    writeName(LOG_STREAM_NAME[i], &header.namesSize);
+  }
+  for (i = 0; i < OMC_TRACE_MAX_EVENT; i++) {
+    writeName(OMC_TRACE_EVENT_NAME[i], &header.namesSize);
+  }
+  if (header.namesSize % 8) {
+    fwrite(zeros, 8 - header.namesSize % 8, 1, traceFile);
+    header.namesSize += 8 - header.namesSize % 8;
+  }
+  fseek(traceFile, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, traceFile);
+  fseek(traceFile, 0, SEEK_END);
+
+  infoStreamPrint(LOG_STDOUT, 0, "Writing binary trace to %s", filename);
+  omc_trace_active = 1;
+  return 0;
+}
+
+void omc_trace_close()
+{
+  OMC_TRACE_RING *ring, *next;
+
+  if (NULL == traceFile) {
+    return;
+  }
+  omc_trace_active = 0;
+
+  for (ring = traceRings; ring; ring = next) {
+    next = ring->next;
+    flushRing(ring);
+    free(ring->records);
+    free(ring);
+  }
+  traceRings = NULL;
+  traceNumThreads = 0;
+  OMC_TRACE_FETCH_ADD(&traceGeneration, 1);
+
+  pthread_mutex_lock(&traceFileMutex);
+  fclose(traceFile);
+  traceFile = NULL;
+  pthread_mutex_unlock(&traceFileMutex);
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Binary trace of runtime events.
+ *
+ * Hot paths record (stream, event id, up to four doubles) into a ring buffer
+ * owned by the calling thread. Recording needs neither locks nor formatting;
+ * a full ring is appended to the trace file as one block and the file is
+ * decoded offline (tools/trace/omc_trace_decode.py). Enabled with
+ * -binaryTrace=<file>; when disabled OMC_TRACE costs a single load and branch.
+ */
+
+#ifndef OMC_TRACE_H
+#define OMC_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMC_TRACE_MAGIC "OMCTRACE"
+#define OMC_TRACE_VERSION 1
+#define OMC_TRACE_MAX_VALUES 4
+#define OMC_TRACE_DEFAULT_RING_SIZE 16384
+
+/* The ids are stored in the trace file; only append new events */
+enum OMC_TRACE_EVENT
+{
+  OMC_TRACE_UNKNOWN = 0,
+  OMC_TRACE_DELAY_FIND_TIME,           /* time, found position, ring buffer length */
+  OMC_TRACE_NLS_VALUES_ADD,            /* time, list length */
+  OMC_TRACE_ZEROCROSSING_CHANGED,      /* time, zero crossing index, previous value, current value */
+  OMC_TRACE_LS_KLU_SOLVE,              /* time, equation system index, size, success */
+  OMC_TRACE_LS_UMFPACK_SOLVE,          /* time, equation system index, size, success */
+
+  OMC_TRACE_MAX_EVENT
+};
+
+typedef struct OMC_TRACE_RECORD
+{
+  uint16_t stream;                     /* enum LOG_STREAM */
+  uint16_t event;                      /* enum OMC_TRACE_EVENT */
+  uint16_t thread;                     /* index of the recording thread */
+  uint16_t numValues;
+  double values[OMC_TRACE_MAX_VALUES];
+} OMC_TRACE_RECORD;
+
+/* The trace file starts with this header, followed by the NUL-terminated
+ * names of the streams and events (padded to 8 bytes) and the records */
+typedef struct OMC_TRACE_HEADER
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t numStreams;
+  uint32_t numEvents;
+  uint32_t namesSize;
+  uint32_t reserved;
+} OMC_TRACE_HEADER;
+
+extern int omc_trace_active;
+
+/* Returns 0 on success */
+int omc_trace_open(const char *filename, unsigned int ringSize);
+/* Writes the rings of all threads; no thread may record anymore */
+void omc_trace_close();
+void omc_trace_record(int stream, int event, int numValues, double v0, double v1, double v2, double v3);
+
+#define OMC_TRACE(stream, event, numValues, v0, v1, v2, v3) \
+  (omc_trace_active ? omc_trace_record((stream), (event), (numValues), (v0), (v1), (v2), (v3)) : (void) 0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
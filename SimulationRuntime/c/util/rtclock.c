@@ -37,31 +37,189 @@
 #include "memory_pool.h"
 #include <errno.h>
 #include "util/omc_error.h"
+#include <pthread.h>
 #define NSEC_PER_SEC 1000000000L
 
-/* If min_time is set, subtract this amount from measured times to avoid
- * including the time of measuring in reported statistics */
-static double min_time = 0;
-static uint32_t default_rt_clock_ncall[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_min[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_max[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_total[NUM_RT_CLOCKS] = { 0 };
-static uint32_t *rt_clock_ncall = default_rt_clock_ncall;
-static uint32_t *rt_clock_ncall_min = default_rt_clock_ncall_min;
-static uint32_t *rt_clock_ncall_max = default_rt_clock_ncall_max;
-static uint32_t *rt_clock_ncall_total = default_rt_clock_ncall_total;
-
-static rtclock_t default_total_tp[NUM_RT_CLOCKS];
-static rtclock_t default_max_tp[NUM_RT_CLOCKS];
-static rtclock_t default_acc_tp[NUM_RT_CLOCKS];
-static rtclock_t default_tick_tp[NUM_RT_CLOCKS];
-
-static rtclock_t *total_tp = default_total_tp;
-static rtclock_t *max_tp = default_max_tp;
-static rtclock_t *acc_tp = default_acc_tp;
-static rtclock_t *tick_tp = default_tick_tp;
+/* All timers live in a per-thread state, so several model instances can be
+ * simulated in the threads of one process without mixing their timings.
+ * The state is created on first use and freed when the thread exits.
+ *
+ * The states of the threads working for one instance form a group, so that
+ * the ticks of its worker threads (e.g. OpenMP) count for the instance.
+ * The functions called in every step (rt_tick, rt_accumulate, rt_clear,
+ * rt_accumulated, rt_ncall, rt_ncall_arr) only use the state of the calling
+ * thread and take no lock. rt_total, rt_ncall_total and rt_hw_total, which
+ * report the totals, add the accumulated and total times of the other
+ * threads of the group and of its exited threads; rt_clear_total and rt_init
+ * apply to all threads of the group. Like the pools of the memory
+ * allocator, these are called while the workers are idle. Threads that did
+ * not join a group with rt_group_join belong to the default group of the
+ * process. */
+typedef struct rt_clock_state {
+  int numTimers;
+  /* If min_time is set, subtract this amount from measured times to avoid
+   * including the time of measuring in reported statistics */
+  double min_time;
+  uint32_t *ncall;
+  uint32_t *ncall_min;
+  uint32_t *ncall_max;
+  uint32_t *ncall_total;
+  rtclock_t *total_tp;
+  rtclock_t *max_tp;
+  rtclock_t *acc_tp;
+  rtclock_t *tick_tp;
+  int hw_enabled;
+  int hw_tried;                  /* counters of a worker thread were opened on first use */
+  int hw_fd[RT_HW_NUM_COUNTERS];   /* perf_event group of the thread (leader: cycles), -1 if not open */
+  int hw_slot[RT_HW_NUM_COUNTERS]; /* position in the group read buffer, -1 if not available */
+  int hw_numTimers;
+  uint64_t *hw_tick;
+  uint64_t *hw_acc;
+  uint64_t *hw_total;
+  rt_clock_group *group;
+  struct rt_clock_state *next;   /* next state of the group */
+} rt_clock_state;
+
+struct rt_clock_group {
+  int numTimers;                 /* of rt_init */
+  int hw_numTimers;              /* of rt_hw_init, 0 if the counters are not used */
+  rt_clock_state *states;
+  rt_clock_state *retired;       /* times of the threads that have exited */
+};
+
+static rt_clock_group rt_default_group = {0, 0, NULL, NULL};
+/* protects the state lists of all groups */
+static pthread_mutex_t rt_group_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static OMC_THREAD_LOCAL rt_clock_state *rt_thread_state = NULL;
+static OMC_THREAD_LOCAL rt_clock_group *rt_thread_group = NULL;
+static pthread_key_t rt_state_key;
+static pthread_once_t rt_state_key_once = PTHREAD_ONCE_INIT;
+
+static void hw_reset(rt_clock_state *rt);
+static void hw_close(rt_clock_state *rt);
+static void rt_hw_free(rt_clock_state *rt);
+static void rt_group_unlink(rt_clock_state *rt);
+static void rt_state_retire(rt_clock_state *rt);
+
+static void rt_state_free_arrays(rt_clock_state *rt)
+{
+  free(rt->ncall);
+  free(rt->ncall_min);
+  free(rt->ncall_max);
+  free(rt->ncall_total);
+  free(rt->total_tp);
+  free(rt->max_tp);
+  free(rt->acc_tp);
+  free(rt->tick_tp);
+  free(rt->hw_tick);
+  free(rt->hw_acc);
+  free(rt->hw_total);
+  free(rt);
+}
+
+static void rt_state_free(void *ptr)
+{
+  rt_clock_state *rt = (rt_clock_state*) ptr;
+  pthread_mutex_lock(&rt_group_mutex);
+  rt_state_retire(rt);
+  rt_group_unlink(rt);
+  /* under the lock, rt_hw_close of another thread may close it as well */
+  hw_close(rt);
+  pthread_mutex_unlock(&rt_group_mutex);
+  rt_hw_free(rt);
+  rt_state_free_arrays(rt);
+  rt_thread_state = NULL;
+}
+
+static void rt_state_key_create(void)
+{
+  pthread_key_create(&rt_state_key, rt_state_free);
+}
+
+static void* resize_zero(void *ptr, size_t n, size_t oldn, size_t sz)
+{
+  void *newmemory = realloc(ptr, n*sz);
+  assert(newmemory != 0);
+  memset((char*)newmemory + oldn*sz, 0, (n-oldn)*sz);
+  return newmemory;
+}
+
+static void rt_state_resize(rt_clock_state *rt, int numTimers)
+{
+  if (numTimers <= rt->numTimers) {
+    return;
+  }
+  rt->ncall = (uint32_t*) resize_zero(rt->ncall, numTimers, rt->numTimers, sizeof(uint32_t));
+  rt->ncall_min = (uint32_t*) resize_zero(rt->ncall_min, numTimers, rt->numTimers, sizeof(uint32_t));
+  rt->ncall_max = (uint32_t*) resize_zero(rt->ncall_max, numTimers, rt->numTimers, sizeof(uint32_t));
+  rt->ncall_total = (uint32_t*) resize_zero(rt->ncall_total, numTimers, rt->numTimers, sizeof(uint32_t));
+  rt->total_tp = (rtclock_t*) resize_zero(rt->total_tp, numTimers, rt->numTimers, sizeof(rtclock_t));
+  rt->max_tp = (rtclock_t*) resize_zero(rt->max_tp, numTimers, rt->numTimers, sizeof(rtclock_t));
+  rt->acc_tp = (rtclock_t*) resize_zero(rt->acc_tp, numTimers, rt->numTimers, sizeof(rtclock_t));
+  rt->tick_tp = (rtclock_t*) resize_zero(rt->tick_tp, numTimers, rt->numTimers, sizeof(rtclock_t));
+  rt->numTimers = numTimers;
+}
+
+static void rt_hw_resize(rt_clock_state *rt, int numTimers)
+{
+  if (numTimers <= rt->hw_numTimers) {
+    return;
+  }
+  rt->hw_tick = (uint64_t*) resize_zero(rt->hw_tick, numTimers*RT_HW_NUM_COUNTERS, rt->hw_numTimers*RT_HW_NUM_COUNTERS, sizeof(uint64_t));
+  rt->hw_acc = (uint64_t*) resize_zero(rt->hw_acc, numTimers*RT_HW_NUM_COUNTERS, rt->hw_numTimers*RT_HW_NUM_COUNTERS, sizeof(uint64_t));
+  rt->hw_total = (uint64_t*) resize_zero(rt->hw_total, numTimers*RT_HW_NUM_COUNTERS, rt->hw_numTimers*RT_HW_NUM_COUNTERS, sizeof(uint64_t));
+  rt->hw_numTimers = numTimers;
+}
+
+/* the caller holds rt_group_mutex */
+static void rt_group_link(rt_clock_state *rt, rt_clock_group *group)
+{
+  rt_state_resize(rt, group->numTimers);
+  rt->group = group;
+  rt->next = group->states;
+  group->states = rt;
+}
+
+/* the caller holds rt_group_mutex */
+static void rt_group_unlink(rt_clock_state *rt)
+{
+  rt_clock_state **p;
+  if (!rt->group) {
+    return;
+  }
+  for (p = &rt->group->states; *p; p = &(*p)->next) {
+    if (*p == rt) {
+      *p = rt->next;
+      break;
+    }
+  }
+  rt->group = NULL;
+  rt->next = NULL;
+}
+
+static rt_clock_state* rt_state_new(void)
+{
+  rt_clock_state *rt = (rt_clock_state*) calloc(1, sizeof(rt_clock_state));
+  assert(rt != 0);
+  hw_reset(rt);
+  rt_state_resize(rt, NUM_RT_CLOCKS);
+  pthread_once(&rt_state_key_once, rt_state_key_create);
+  pthread_setspecific(rt_state_key, rt);
+  pthread_mutex_lock(&rt_group_mutex);
+  rt_group_link(rt, rt_thread_group ? rt_thread_group : &rt_default_group);
+  pthread_mutex_unlock(&rt_group_mutex);
+  rt_thread_state = rt;
+  return rt;
+}
+
+static OMC_INLINE rt_clock_state* rt_state(void)
+{
+  return rt_thread_state ? rt_thread_state : rt_state_new();
+}
 
 static int rtclock_compare(rtclock_t, rtclock_t);
+static void rtclock_add(rtclock_t *acc, const rtclock_t *d);
 
 static rtclock_t max_rtclock(rtclock_t t1, rtclock_t t2) {
   if (rtclock_compare(t1, t2) < 0)
@@ -71,80 +229,478 @@ static rtclock_t max_rtclock(rtclock_t t1, rtclock_t t2) {
 
 static double rtclock_value(rtclock_t);
 
+/* Hardware performance counters. One perf_event group (leader: cycles) is
+ * opened per thread, so a single read() returns all counters. The group is
+ * kept in the state of the thread, so that rt_hw_close can close the
+ * counters of all threads of the group. */
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t hw_config[RT_HW_NUM_COUNTERS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int hw_perf_event_open(uint64_t config, int group_fd)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = group_fd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, group_fd, 0);
+}
+
+/* opens the counters of the calling thread, which rt belongs to */
+static int hw_open(rt_clock_state *rt)
+{
+  int i, numSlots;
+  rt->hw_fd[RT_HW_CYCLES] = hw_perf_event_open(hw_config[RT_HW_CYCLES], -1);
+  if (rt->hw_fd[RT_HW_CYCLES] == -1) {
+    return 1;
+  }
+  rt->hw_slot[RT_HW_CYCLES] = 0;
+  numSlots = 1;
+  for (i=1; i<RT_HW_NUM_COUNTERS; i++) {
+    rt->hw_fd[i] = hw_perf_event_open(hw_config[i], rt->hw_fd[RT_HW_CYCLES]);
+    rt->hw_slot[i] = rt->hw_fd[i] == -1 ? -1 : numSlots++;
+  }
+  ioctl(rt->hw_fd[RT_HW_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(rt->hw_fd[RT_HW_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return 0;
+}
+
+static inline void hw_read(rt_clock_state *rt, uint64_t *values)
+{
+  uint64_t buf[1+RT_HW_NUM_COUNTERS] = {0}; /* nr, values[nr] */
+  int i;
+  if (rt->hw_fd[RT_HW_CYCLES] == -1 || read(rt->hw_fd[RT_HW_CYCLES], buf, sizeof(buf)) <= 0) {
+    memset(values, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+    return;
+  }
+  for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+    values[i] = rt->hw_slot[i] >= 0 ? buf[1+rt->hw_slot[i]] : 0;
+  }
+}
+
+int rt_hw_available(enum omc_rt_hwcounter_t counter)
+{
+  rt_clock_state *rt = rt_state();
+  return rt->hw_enabled && rt->hw_fd[RT_HW_CYCLES] != -1 && rt->hw_slot[counter] >= 0;
+}
+
+/* also called for the state of another thread, which is idle then */
+static void hw_close(rt_clock_state *rt)
+{
+  int i;
+  for (i=RT_HW_NUM_COUNTERS-1; i>=0; i--) {
+    if (rt->hw_fd[i] != -1) {
+      close(rt->hw_fd[i]);
+    }
+  }
+  hw_reset(rt);
+}
+
+#else
+
+static inline void hw_read(rt_clock_state *rt, uint64_t *values)
+{
+  memset(values, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+}
+
+static int hw_open(rt_clock_state *rt)
+{
+  return 1;
+}
+
+static void hw_close(rt_clock_state *rt)
+{
+}
+
+int rt_hw_available(enum omc_rt_hwcounter_t counter)
+{
+  return 0;
+}
+
+#endif
+
+static void hw_reset(rt_clock_state *rt)
+{
+  int i;
+  for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+    rt->hw_fd[i] = -1;
+    rt->hw_slot[i] = -1;
+  }
+}
+
+/* closes the counters of all threads of the group; a later rt_hw_init opens them again */
+void rt_hw_close()
+{
+  rt_clock_state *rt = rt_state(), *st;
+  pthread_mutex_lock(&rt_group_mutex);
+  for (st = rt->group->states; st; st = st->next) {
+    hw_close(st);
+    st->hw_enabled = 0;
+    st->hw_tried = 0;
+  }
+  rt->group->hw_numTimers = 0;
+  pthread_mutex_unlock(&rt_group_mutex);
+}
+
+static void rt_hw_free(rt_clock_state *rt)
+{
+  hw_close(rt);
+  free(rt->hw_tick);
+  free(rt->hw_acc);
+  free(rt->hw_total);
+  rt->hw_tick = NULL;
+  rt->hw_acc = NULL;
+  rt->hw_total = NULL;
+  rt->hw_numTimers = 0;
+  rt->hw_enabled = 0;
+}
+
+int rt_hw_init(int numTimers)
+{
+  rt_clock_state *rt = rt_state();
+  if (numTimers < NUM_RT_CLOCKS) {
+    numTimers = NUM_RT_CLOCKS;
+  }
+  rt_hw_free(rt);
+  if (hw_open(rt)) {
+    return 1;
+  }
+  rt_hw_resize(rt, numTimers);
+  rt->hw_enabled = 1;
+  /* the other threads of the group open their counters on first use */
+  pthread_mutex_lock(&rt_group_mutex);
+  if (rt->group->hw_numTimers < numTimers) {
+    rt->group->hw_numTimers = numTimers;
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+  return 0;
+}
+
+int rt_hw_enabled()
+{
+  rt_clock_state *rt = rt_state();
+  return rt->hw_enabled;
+}
+
+uint64_t rt_hw_total(int ix, enum omc_rt_hwcounter_t counter)
+{
+  rt_clock_state *rt = rt_state(), *st;
+  uint64_t n = 0;
+  if (!rt->hw_enabled || ix >= rt->hw_numTimers) {
+    return 0;
+  }
+  pthread_mutex_lock(&rt_group_mutex);
+  for (st = rt->group->states; st; st = st->next) {
+    if (ix < st->hw_numTimers) {
+      n += st->hw_total[ix*RT_HW_NUM_COUNTERS+counter] + st->hw_acc[ix*RT_HW_NUM_COUNTERS+counter];
+    }
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+  return n;
+}
+
+static inline void rt_hw_tick(int ix)
+{
+  rt_clock_state *rt = rt_state();
+  if (!rt->hw_enabled && !rt->hw_tried && rt->group->hw_numTimers) {
+    rt->hw_tried = 1;
+    if (0 == hw_open(rt)) {
+      rt_hw_resize(rt, rt->group->hw_numTimers);
+      rt->hw_enabled = 1;
+    }
+  }
+  if (rt->hw_enabled && ix < rt->hw_numTimers) {
+    hw_read(rt, rt->hw_tick + ix*RT_HW_NUM_COUNTERS);
+  }
+}
+
+static inline void rt_hw_accumulate(int ix)
+{
+  rt_clock_state *rt = rt_state();
+  int i;
+  uint64_t values[RT_HW_NUM_COUNTERS];
+  if (rt->hw_enabled && ix < rt->hw_numTimers) {
+    hw_read(rt, values);
+    for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+      rt->hw_acc[ix*RT_HW_NUM_COUNTERS+i] += values[i] - rt->hw_tick[ix*RT_HW_NUM_COUNTERS+i];
+    }
+  }
+}
+
+static inline void rt_hw_clear(int ix)
+{
+  rt_clock_state *rt = rt_state();
+  int i;
+  if (rt->hw_enabled && ix < rt->hw_numTimers) {
+    for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+      rt->hw_total[ix*RT_HW_NUM_COUNTERS+i] += rt->hw_acc[ix*RT_HW_NUM_COUNTERS+i];
+      rt->hw_acc[ix*RT_HW_NUM_COUNTERS+i] = 0;
+    }
+  }
+}
+
+static inline void rt_hw_clear_total(int ix)
+{
+  rt_clock_state *rt = rt_state();
+  if (rt->hw_enabled && ix < rt->hw_numTimers) {
+    memset(rt->hw_total + ix*RT_HW_NUM_COUNTERS, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+    memset(rt->hw_acc + ix*RT_HW_NUM_COUNTERS, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+  }
+}
+
+/* moves the accumulated time and calls of timer ix, the caller holds rt_group_mutex */
+static void rt_state_move_acc(rt_clock_state *to, rt_clock_state *from, int ix)
+{
+  int i;
+  if (ix >= from->numTimers || ix >= to->numTimers) {
+    return;
+  }
+  rtclock_add(to->acc_tp + ix, from->acc_tp + ix);
+  to->ncall[ix] += from->ncall[ix];
+  memset(from->acc_tp + ix, 0, sizeof(rtclock_t));
+  from->ncall[ix] = 0;
+  if (ix < from->hw_numTimers) {
+    for (i=0; i<RT_HW_NUM_COUNTERS; i++) {
+      if (ix < to->hw_numTimers) {
+        to->hw_acc[ix*RT_HW_NUM_COUNTERS+i] += from->hw_acc[ix*RT_HW_NUM_COUNTERS+i];
+      }
+      from->hw_acc[ix*RT_HW_NUM_COUNTERS+i] = 0;
+    }
+  }
+}
+
+/* moves all times of a state to the retired times of its group, the caller holds rt_group_mutex */
+static void rt_state_retire(rt_clock_state *rt)
+{
+  rt_clock_state *retired;
+  int ix, i;
+  if (!rt->group) {
+    return;
+  }
+  if (!rt->group->retired) {
+    retired = (rt_clock_state*) calloc(1, sizeof(rt_clock_state));
+    assert(retired != 0);
+    hw_reset(retired);
+    rt_group_link(retired, rt->group);
+    rt->group->retired = retired;
+  }
+  retired = rt->group->retired;
+  rt_state_resize(retired, rt->numTimers);
+  rt_hw_resize(retired, rt->hw_numTimers);
+  for (ix=0; ix<rt->numTimers; ix++) {
+    rt_state_move_acc(retired, rt, ix);
+    rtclock_add(retired->total_tp + ix, rt->total_tp + ix);
+    retired->max_tp[ix] = max_rtclock(retired->max_tp[ix], rt->max_tp[ix]);
+    retired->ncall_total[ix] += rt->ncall_total[ix];
+    memset(rt->total_tp + ix, 0, sizeof(rtclock_t));
+    memset(rt->max_tp + ix, 0, sizeof(rtclock_t));
+    rt->ncall_total[ix] = 0;
+  }
+  for (i=0; i<rt->hw_numTimers*RT_HW_NUM_COUNTERS; i++) {
+    retired->hw_total[i] += rt->hw_total[i];
+    rt->hw_total[i] = 0;
+  }
+}
+
+/* clears timer ix of the other threads of the group */
+static void rt_group_clear_total(rt_clock_state *rt, int ix)
+{
+  rt_clock_state *st;
+  pthread_mutex_lock(&rt_group_mutex);
+  for (st = rt->group->states; st; st = st->next) {
+    if (st == rt || ix >= st->numTimers) {
+      continue;
+    }
+    memset(st->acc_tp + ix, 0, sizeof(rtclock_t));
+    memset(st->total_tp + ix, 0, sizeof(rtclock_t));
+    st->ncall[ix] = 0;
+    st->ncall_total[ix] = 0;
+    if (ix < st->hw_numTimers) {
+      memset(st->hw_acc + ix*RT_HW_NUM_COUNTERS, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+      memset(st->hw_total + ix*RT_HW_NUM_COUNTERS, 0, RT_HW_NUM_COUNTERS*sizeof(uint64_t));
+    }
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+}
+
+rt_clock_group* rt_group_new(void)
+{
+  rt_clock_group *group = (rt_clock_group*) calloc(1, sizeof(rt_clock_group));
+  assert(group != 0);
+  return group;
+}
+
+void rt_group_join(rt_clock_group *group)
+{
+  rt_thread_group = group;
+  if (rt_thread_state) {
+    pthread_mutex_lock(&rt_group_mutex);
+    rt_state_retire(rt_thread_state);
+    rt_group_unlink(rt_thread_state);
+    rt_group_link(rt_thread_state, group ? group : &rt_default_group);
+    pthread_mutex_unlock(&rt_group_mutex);
+  }
+}
+
+void rt_group_free(rt_clock_group *group)
+{
+  rt_clock_state *st;
+  if (!group) {
+    return;
+  }
+  if (rt_thread_group == group) {
+    rt_thread_group = NULL;
+  }
+  pthread_mutex_lock(&rt_group_mutex);
+  /* threads still in the group continue in the default group */
+  while (group->states) {
+    st = group->states;
+    rt_group_unlink(st);
+    if (st == group->retired) {
+      rt_state_free_arrays(st);
+    } else {
+      rt_group_link(st, &rt_default_group);
+    }
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+  free(group);
+}
+
 void rt_add_ncall(int ix, int n) {
-  rt_clock_ncall[ix] += n;
+  rt_clock_state *rt = rt_state();
+  rt->ncall[ix] += n;
 }
 
 uint32_t rt_ncall(int ix) {
-  return rt_clock_ncall[ix];
+  rt_clock_state *rt = rt_state();
+  return rt->ncall[ix];
 }
 
 uint32_t* rt_ncall_arr(int ix) {
-  return rt_clock_ncall+ix;
+  rt_clock_state *rt = rt_state();
+  return rt->ncall+ix;
 }
 
 uint32_t rt_ncall_min(int ix) {
-  return rt_clock_ncall_min[ix];
+  rt_clock_state *rt = rt_state();
+  return rt->ncall_min[ix];
 }
 
 uint32_t rt_ncall_max(int ix) {
-  return rt_clock_ncall_max[ix];
+  rt_clock_state *rt = rt_state();
+  return rt->ncall_max[ix];
 }
 
 uint32_t rt_ncall_total(int ix) {
-  return rt_clock_ncall_total[ix];
+  rt_clock_state *rt = rt_state(), *st;
+  uint32_t n = 0;
+  pthread_mutex_lock(&rt_group_mutex);
+  for (st = rt->group->states; st; st = st->next) {
+    if (ix < st->numTimers) {
+      n += st->ncall_total[ix];
+      /* the other threads do not clear their timers */
+      if (st != rt) {
+        n += st->ncall[ix];
+      }
+    }
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+  return n;
 }
 
 void rt_update_min_max_ncall(int ix) {
-  unsigned long nmin = rt_clock_ncall_min[ix];
-  unsigned long nmax = rt_clock_ncall_max[ix];
-  unsigned long n = rt_clock_ncall[ix];
+  rt_clock_state *rt = rt_state();
+  unsigned long nmin = rt->ncall_min[ix];
+  unsigned long nmax = rt->ncall_max[ix];
+  unsigned long n = rt->ncall[ix];
   if (n == 0) {
     return;
   }
-  rt_clock_ncall_min[ix] = nmin && nmin < n ? nmin : n;
-  rt_clock_ncall_max[ix] = nmax > n ? nmax : n;
+  rt->ncall_min[ix] = nmin && nmin < n ? nmin : n;
+  rt->ncall_max[ix] = nmax > n ? nmax : n;
 }
 
 void rt_clear_total_ncall(int ix) {
-  rt_clock_ncall[ix] = 0;
-  rt_clock_ncall_total[ix] = 0;
-  rt_clock_ncall_min[ix] = UINT32_MAX;
-  rt_clock_ncall_max[ix] = 0;
+  rt_clock_state *rt = rt_state();
+  rt->ncall[ix] = 0;
+  rt->ncall_total[ix] = 0;
+  rt->ncall_min[ix] = UINT32_MAX;
+  rt->ncall_max[ix] = 0;
 }
 
 double rt_accumulated(int ix) {
-  double d = rtclock_value(acc_tp[ix]);
+  rt_clock_state *rt = rt_state();
+  double d = rtclock_value(rt->acc_tp[ix]);
   if (d == 0) {
     return d;
   }
-  if (d > 0 && d < min_time * rt_clock_ncall[ix]) {
-    min_time = d / rt_clock_ncall[ix];
+  if (d > 0 && d < rt->min_time * rt->ncall[ix]) {
+    rt->min_time = d / rt->ncall[ix];
   }
-  return d - min_time * rt_clock_ncall[ix];
+  return d - rt->min_time * rt->ncall[ix];
 }
 
 double rt_max_accumulated(int ix) {
-  double d = rtclock_value(max_tp[ix]);
+  rt_clock_state *rt = rt_state();
+  double d = rtclock_value(rt->max_tp[ix]);
   if (d == 0) {
     return d;
   }
-  if (d > 0 && d < min_time) {
-    min_time = d;
+  if (d > 0 && d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
-double rt_total(int ix) {
-  double d = rtclock_value(total_tp[ix]);
+/* the total time of timer ix of a state, with its accumulated time if it is
+ * not the caller's; only reads the state, the minimum of another thread is
+ * left to that thread */
+static double rt_state_total(rt_clock_state *rt, int ix, int withAcc) {
+  rtclock_t tp = rt->total_tp[ix];
+  uint32_t n = rt->ncall_total[ix];
+  double d;
+  if (withAcc) {
+    rtclock_add(&tp, rt->acc_tp + ix);
+    n += rt->ncall[ix];
+  }
+  d = rtclock_value(tp);
   if (d == 0) {
     return d;
   }
-  d = d - min_time * rt_clock_ncall_total[ix];
+  d = d - rt->min_time * n;
   assert(d >= 0);
   return d;
 }
 
+double rt_total(int ix) {
+  rt_clock_state *rt = rt_state(), *st;
+  double d = 0;
+  pthread_mutex_lock(&rt_group_mutex);
+  for (st = rt->group->states; st; st = st->next) {
+    if (ix < st->numTimers) {
+      d += rt_state_total(st, ix, st != rt);
+    }
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
+  return d;
+}
+
 #if defined(__MINGW32__) || defined(_MSC_VER)
 
 static enum omc_rt_clock_t selectedClock = OMC_CLOCK_REALTIME;
@@ -182,6 +738,8 @@ enum omc_rt_clock_t rt_get_clock() {
 static LARGE_INTEGER performance_frequency;
 
 void rt_tick(int ix) {
+  rt_clock_state *rt = rt_state();
+  rt_hw_tick(ix);
   if(selectedClock == OMC_CLOCK_REALTIME) {
     static int init = 0;
     if (!init) {
@@ -189,66 +747,78 @@ void rt_tick(int ix) {
       init = 1;
       QueryPerformanceFrequency(&performance_frequency);
     }
-    QueryPerformanceCounter(&tick_tp[ix]);
+    QueryPerformanceCounter(&rt->tick_tp[ix]);
   } else {
     LARGE_INTEGER time;
     time.QuadPart = RDTSC();
-    tick_tp[ix] = time;
+    rt->tick_tp[ix] = time;
   }
-  rt_clock_ncall[ix]++;
+  rt->ncall[ix]++;
 }
 
 double rt_tock(int ix) {
+  rt_clock_state *rt = rt_state();
   double d;
   if(selectedClock == OMC_CLOCK_REALTIME) {
     LARGE_INTEGER tock_tp;
     double d1, d2;
     QueryPerformanceCounter(&tock_tp);
-    d1 = (double) (tock_tp.QuadPart - tick_tp[ix].QuadPart);
+    d1 = (double) (tock_tp.QuadPart - rt->tick_tp[ix].QuadPart);
     d2 = (double) performance_frequency.QuadPart;
     d = d1 / d2;
   } else {
     LARGE_INTEGER tock_tp;
     tock_tp.QuadPart = RDTSC();
-    d = (double) (tock_tp.QuadPart - tick_tp[ix].QuadPart);
+    d = (double) (tock_tp.QuadPart - rt->tick_tp[ix].QuadPart);
   }
-  if (d < min_time) {
-    min_time = d;
+  if (d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 void rt_clear(int ix) {
-  total_tp[ix].QuadPart += acc_tp[ix].QuadPart;
-  rt_clock_ncall_total[ix] += rt_clock_ncall[ix];
-  max_tp[ix] = max_rtclock(max_tp[ix], acc_tp[ix]);
+  rt_clock_state *rt = rt_state();
+  rt_hw_clear(ix);
+  rt->total_tp[ix].QuadPart += rt->acc_tp[ix].QuadPart;
+  rt->ncall_total[ix] += rt->ncall[ix];
+  rt->max_tp[ix] = max_rtclock(rt->max_tp[ix], rt->acc_tp[ix]);
   rt_update_min_max_ncall(ix);
-  acc_tp[ix].QuadPart = 0;
-  rt_clock_ncall[ix] = 0;
+  rt->acc_tp[ix].QuadPart = 0;
+  rt->ncall[ix] = 0;
 }
 
 void rt_clear_total(int ix) {
-  total_tp[ix].QuadPart = 0;
-  acc_tp[ix].QuadPart = 0;
+  rt_clock_state *rt = rt_state();
+  rt_group_clear_total(rt, ix);
+  rt_hw_clear_total(ix);
+  rt->total_tp[ix].QuadPart = 0;
+  rt->acc_tp[ix].QuadPart = 0;
   rt_clear_total_ncall(ix);
 }
 
 void rt_accumulate(int ix) {
+  rt_clock_state *rt = rt_state();
   if(selectedClock == OMC_CLOCK_REALTIME) {
     LARGE_INTEGER tock_tp;
     QueryPerformanceCounter(&tock_tp);
-    acc_tp[ix].QuadPart += tock_tp.QuadPart - tick_tp[ix].QuadPart;
+    rt->acc_tp[ix].QuadPart += tock_tp.QuadPart - rt->tick_tp[ix].QuadPart;
   } else {
     LARGE_INTEGER tock_tp;
     tock_tp.QuadPart = RDTSC();
-    acc_tp[ix].QuadPart += tock_tp.QuadPart - tick_tp[ix].QuadPart;
+    rt->acc_tp[ix].QuadPart += tock_tp.QuadPart - rt->tick_tp[ix].QuadPart;
   }
+  rt_hw_accumulate(ix);
 }
 
 int rtclock_compare(rtclock_t t1, rtclock_t t2) {
   return t1.QuadPart - t2.QuadPart;
 }
 
+static void rtclock_add(rtclock_t *acc, const rtclock_t *d) {
+  acc->QuadPart += d->QuadPart;
+}
+
 double rtclock_value(LARGE_INTEGER tp) {
   if(selectedClock == OMC_CLOCK_REALTIME) {
     double d1, d2;
@@ -290,6 +860,7 @@ double rt_ext_tp_tock_realtime(rtclock_t* tick_tp) {
 }
 
 double rt_ext_tp_tock(rtclock_t* tick_tp) {
+  rt_clock_state *rt = rt_state();
   double d;
   if(selectedClock == OMC_CLOCK_REALTIME) {
     d = rt_ext_tp_tock_realtime(tick_tp);
@@ -298,10 +869,10 @@ double rt_ext_tp_tock(rtclock_t* tick_tp) {
     tock_tp.QuadPart = RDTSC();
     d = (double) (tock_tp.QuadPart - tick_tp->QuadPart);
   }
-  if (d < min_time) {
-    min_time = d;
+  if (d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 int64_t rt_ext_tp_sync_nanosec(rtclock_t* tick_tp, uint64_t nsec)
@@ -331,45 +902,55 @@ int rt_set_clock(enum omc_rt_clock_t newClock) {
 }
 
 void rt_tick(int ix) {
-  tick_tp[ix] = mach_absolute_time();
-  rt_clock_ncall[ix]++;
+  rt_clock_state *rt = rt_state();
+  rt_hw_tick(ix);
+  rt->tick_tp[ix] = mach_absolute_time();
+  rt->ncall[ix]++;
 }
 
 double rt_tock(int ix) {
+  rt_clock_state *rt = rt_state();
   uint64_t tock_tp = mach_absolute_time();
   uint64_t nsec;
   static mach_timebase_info_data_t info = {0,0};
   if(info.denom == 0)
   mach_timebase_info(&info);
-  uint64_t elapsednano = (tock_tp-tick_tp[ix]) * (info.numer / info.denom);
+  uint64_t elapsednano = (tock_tp-rt->tick_tp[ix]) * (info.numer / info.denom);
   double d = elapsednano * 1e-9;
-  if (d < min_time) {
-    min_time = d;
+  if (d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 void rt_clear(int ix)
 {
-  total_tp[ix] += acc_tp[ix];
-  rt_clock_ncall_total[ix] += rt_clock_ncall[ix];
-  max_tp[ix] = max_rtclock(max_tp[ix],acc_tp[ix]);
+  rt_clock_state *rt = rt_state();
+  rt_hw_clear(ix);
+  rt->total_tp[ix] += rt->acc_tp[ix];
+  rt->ncall_total[ix] += rt->ncall[ix];
+  rt->max_tp[ix] = max_rtclock(rt->max_tp[ix],rt->acc_tp[ix]);
   rt_update_min_max_ncall(ix);
-  acc_tp[ix] = 0;
-  rt_clock_ncall[ix] = 0;
+  rt->acc_tp[ix] = 0;
+  rt->ncall[ix] = 0;
 }
 
 void rt_clear_total(int ix)
 {
-  total_tp[ix] = 0;
-  rt_clock_ncall_total[ix] = 0;
-  acc_tp[ix] = 0;
-  rt_clock_ncall[ix] = 0;
+  rt_clock_state *rt = rt_state();
+  rt_group_clear_total(rt, ix);
+  rt_hw_clear_total(ix);
+  rt->total_tp[ix] = 0;
+  rt->ncall_total[ix] = 0;
+  rt->acc_tp[ix] = 0;
+  rt->ncall[ix] = 0;
 }
 
 void rt_accumulate(int ix) {
+  rt_clock_state *rt = rt_state();
   uint64_t tock_tp = mach_absolute_time();
-  acc_tp[ix] += tock_tp - tick_tp[ix];
+  rt->acc_tp[ix] += tock_tp - rt->tick_tp[ix];
+  rt_hw_accumulate(ix);
 }
 
 double rtclock_value(uint64_t tp) {
@@ -384,11 +965,16 @@ int rtclock_compare(uint64_t t1, uint64_t t2) {
   return t1-t2;
 }
 
+static void rtclock_add(rtclock_t *acc, const rtclock_t *d) {
+  *acc += *d;
+}
+
 void rt_ext_tp_tick(rtclock_t* tick_tp) {
   *tick_tp = mach_absolute_time();
 }
 
 double rt_ext_tp_tock(rtclock_t* tick_tp) {
+  rt_clock_state *rt = rt_state();
   uint64_t tock_tp = mach_absolute_time();
   uint64_t nsec;
   static mach_timebase_info_data_t info = {0,0};
@@ -396,10 +982,10 @@ double rt_ext_tp_tock(rtclock_t* tick_tp) {
   mach_timebase_info(&info);
   uint64_t elapsednano = (tock_tp-*tick_tp) * (info.numer / info.denom);
   double d = elapsednano * 1e-9;
-  if (d < min_time) {
-    min_time = d;
+  if (d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 void rt_ext_tp_tick_realtime(rtclock_t* tick_tp) {
@@ -468,70 +1054,78 @@ static inline unsigned long long RDTSC(void)
 #endif
 
 void rt_tick(int ix) {
+  rt_clock_state *rt = rt_state();
+  rt_hw_tick(ix);
   if(omc_clock == OMC_CPU_CYCLES) {
-    tick_tp[ix].cycles = RDTSC();
+    rt->tick_tp[ix].cycles = RDTSC();
   } else {
-    clock_gettime(omc_clock, &tick_tp[ix].time);
+    clock_gettime(omc_clock, &rt->tick_tp[ix].time);
   }
-  rt_clock_ncall[ix]++;
+  rt->ncall[ix]++;
 }
 
 double rt_tock(int ix) {
+  rt_clock_state *rt = rt_state();
   double d;
   if(omc_clock == OMC_CPU_CYCLES) {
     unsigned long long timer = RDTSC();
-    d = (double) (timer - tick_tp[ix].cycles);
+    d = (double) (timer - rt->tick_tp[ix].cycles);
   } else {
     struct timespec tock_tp = {0,0};
     clock_gettime(omc_clock, &tock_tp);
-    d = (tock_tp.tv_sec - tick_tp[ix].time.tv_sec) + (tock_tp.tv_nsec - tick_tp[ix].time.tv_nsec)*1e-9;
-    if (d < min_time) {
-      min_time = d;
+    d = (tock_tp.tv_sec - rt->tick_tp[ix].time.tv_sec) + (tock_tp.tv_nsec - rt->tick_tp[ix].time.tv_nsec)*1e-9;
+    if (d < rt->min_time) {
+      rt->min_time = d;
     }
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 void rt_clear(int ix)
 {
+  rt_clock_state *rt = rt_state();
+  rt_hw_clear(ix);
   if(omc_clock == OMC_CPU_CYCLES) {
-    total_tp[ix].cycles += acc_tp[ix].cycles;
-    rt_clock_ncall_total[ix] += rt_clock_ncall[ix];
-    max_tp[ix] = max_rtclock(max_tp[ix],acc_tp[ix]);
+    rt->total_tp[ix].cycles += rt->acc_tp[ix].cycles;
+    rt->ncall_total[ix] += rt->ncall[ix];
+    rt->max_tp[ix] = max_rtclock(rt->max_tp[ix],rt->acc_tp[ix]);
     rt_update_min_max_ncall(ix);
 
-    acc_tp[ix].cycles = 0;
-    acc_tp[ix].cycles = 0;
-    rt_clock_ncall[ix] = 0;
+    rt->acc_tp[ix].cycles = 0;
+    rt->acc_tp[ix].cycles = 0;
+    rt->ncall[ix] = 0;
   } else {
-    total_tp[ix].time.tv_sec += acc_tp[ix].time.tv_sec;
-    total_tp[ix].time.tv_nsec += acc_tp[ix].time.tv_nsec;
-    rt_clock_ncall_total[ix] += rt_clock_ncall[ix];
-    max_tp[ix] = max_rtclock(max_tp[ix],acc_tp[ix]);
+    rt->total_tp[ix].time.tv_sec += rt->acc_tp[ix].time.tv_sec;
+    rt->total_tp[ix].time.tv_nsec += rt->acc_tp[ix].time.tv_nsec;
+    rt->ncall_total[ix] += rt->ncall[ix];
+    rt->max_tp[ix] = max_rtclock(rt->max_tp[ix],rt->acc_tp[ix]);
     rt_update_min_max_ncall(ix);
 
-    acc_tp[ix].time.tv_sec = 0;
-    acc_tp[ix].time.tv_nsec = 0;
-    rt_clock_ncall[ix] = 0;
+    rt->acc_tp[ix].time.tv_sec = 0;
+    rt->acc_tp[ix].time.tv_nsec = 0;
+    rt->ncall[ix] = 0;
   }
 }
 
 void rt_clear_total(int ix)
 {
+  rt_clock_state *rt = rt_state();
+  rt_group_clear_total(rt, ix);
+  rt_hw_clear_total(ix);
   if(omc_clock == OMC_CPU_CYCLES) {
-    total_tp[ix].cycles = 0;
-    rt_clock_ncall_total[ix] = 0;
+    rt->total_tp[ix].cycles = 0;
+    rt->ncall_total[ix] = 0;
 
-    acc_tp[ix].cycles = 0;
-    rt_clock_ncall[ix] = 0;
+    rt->acc_tp[ix].cycles = 0;
+    rt->ncall[ix] = 0;
   } else {
-    total_tp[ix].time.tv_sec = 0;
-    total_tp[ix].time.tv_nsec = 0;
-    rt_clock_ncall_total[ix] = 0;
+    rt->total_tp[ix].time.tv_sec = 0;
+    rt->total_tp[ix].time.tv_nsec = 0;
+    rt->ncall_total[ix] = 0;
 
-    acc_tp[ix].time.tv_sec = 0;
-    acc_tp[ix].time.tv_nsec = 0;
-    rt_clock_ncall[ix] = 0;
+    rt->acc_tp[ix].time.tv_sec = 0;
+    rt->acc_tp[ix].time.tv_nsec = 0;
+    rt->ncall[ix] = 0;
   }
 }
 
@@ -575,19 +1169,21 @@ static inline int timeSpecCmp(struct timespec  t1, struct timespec t2)
 }
 
 void rt_accumulate(int ix) {
+  rt_clock_state *rt = rt_state();
   if(omc_clock == OMC_CPU_CYCLES) {
     long long cycles = RDTSC();
-    acc_tp[ix].cycles += cycles -tick_tp[ix].cycles;
+    rt->acc_tp[ix].cycles += cycles -rt->tick_tp[ix].cycles;
   } else {
     struct timespec tock_tp = {0,0};
     clock_gettime(omc_clock, &tock_tp);
-    acc_tp[ix].time.tv_sec += tock_tp.tv_sec -tick_tp[ix].time.tv_sec;
-    acc_tp[ix].time.tv_nsec += tock_tp.tv_nsec-tick_tp[ix].time.tv_nsec;
-    if(acc_tp[ix].time.tv_nsec >= 1e9) {
-      acc_tp[ix].time.tv_sec++;
-      acc_tp[ix].time.tv_nsec -= 1e9;
+    rt->acc_tp[ix].time.tv_sec += tock_tp.tv_sec -rt->tick_tp[ix].time.tv_sec;
+    rt->acc_tp[ix].time.tv_nsec += tock_tp.tv_nsec-rt->tick_tp[ix].time.tv_nsec;
+    if(rt->acc_tp[ix].time.tv_nsec >= 1e9) {
+      rt->acc_tp[ix].time.tv_sec++;
+      rt->acc_tp[ix].time.tv_nsec -= 1e9;
     }
   }
+  rt_hw_accumulate(ix);
 }
 
 static double rtclock_value(rtclock_t tp) {
@@ -600,6 +1196,15 @@ static double rtclock_value(rtclock_t tp) {
   return d;
 }
 
+static void rtclock_add(rtclock_t *acc, const rtclock_t *d)
+{
+  if(omc_clock == OMC_CPU_CYCLES) {
+    acc->cycles += d->cycles;
+  } else {
+    acc->time = timeSpecAdd(acc->time, d->time);
+  }
+}
+
 int rtclock_compare(rtclock_t t1, rtclock_t t2)
 {
   if(omc_clock == OMC_CPU_CYCLES) {
@@ -625,14 +1230,15 @@ void rt_ext_tp_tick_realtime(rtclock_t* tick_tp) {
 }
 
 static inline double rt_ext_tp_tock_common(clockid_t clk_id, rtclock_t* tick_tp) {
+  rt_clock_state *rt = rt_state();
   double d;
   struct timespec tock_tp = {0,0};
   clock_gettime(clk_id, &tock_tp);
   d = (tock_tp.tv_sec - tick_tp->time.tv_sec) + (tock_tp.tv_nsec - tick_tp->time.tv_nsec)*1e-9;
-  if (d < min_time) {
-    min_time = d;
+  if (d < rt->min_time) {
+    rt->min_time = d;
   }
-  return d - min_time;
+  return d - rt->min_time;
 }
 
 double rt_ext_tp_tock_realtime(rtclock_t* tick_tp) {
@@ -640,10 +1246,11 @@ double rt_ext_tp_tock_realtime(rtclock_t* tick_tp) {
 }
 
 double rt_ext_tp_tock(rtclock_t* tick_tp) {
+  rt_clock_state *rt = rt_state();
   if(omc_clock == OMC_CPU_CYCLES) {
     unsigned long long timer = RDTSC();
     double d = (double) (timer - tick_tp->cycles);
-    return d - min_time;
+    return d - rt->min_time;
   } else {
     return rt_ext_tp_tock_common(omc_clock, tick_tp);
   }
@@ -674,38 +1281,25 @@ int64_t rt_ext_tp_sync_nanosec(rtclock_t* tick_tp, uint64_t nsec)
 
 #endif
 
-static OMC_INLINE void alloc_and_copy(void **ptr, size_t n, size_t sz)
-{
-  void *newmemory = omc_alloc_interface.malloc(n*sz);
-  assert(newmemory != 0);
-  memcpy(newmemory,*ptr,NUM_RT_CLOCKS*sz);
-  *ptr = newmemory;
-}
-
 void rt_init(int numTimers) {
-  if (numTimers < NUM_RT_CLOCKS) {
-    return; /* We already have more than we need statically allocated */
-  }
-  alloc_and_copy((void**)&acc_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&max_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&total_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&tick_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&rt_clock_ncall,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_total,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_min,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_max,numTimers,sizeof(uint32_t));
-  /* This memset-command is not working properly, especially on windows.
-   * It's writing into the rt_clock_ncall_total-array and thus the values are wrong.
-   * However, the profiling-functionality seems to work without it. */
-  //memset(rt_clock_ncall_min + NUM_RT_CLOCKS*sizeof(uint32_t), 0xFF, (numTimers-NUM_RT_CLOCKS) * sizeof(uint32_t));
+  rt_clock_state *rt = rt_state(), *st;
+  pthread_mutex_lock(&rt_group_mutex);
+  if (rt->group->numTimers < numTimers) {
+    rt->group->numTimers = numTimers;
+  }
+  for (st = rt->group->states; st; st = st->next) {
+    rt_state_resize(st, numTimers);
+  }
+  pthread_mutex_unlock(&rt_group_mutex);
 }
 
 void rt_measure_overhead(int ix)
 {
+  rt_clock_state *rt = rt_state();
   int i;
-  min_time = 0;
+  rt->min_time = 0;
   rt_tick(ix);
-  min_time = rt_tock(ix);
+  rt->min_time = rt_tock(ix);
   for (i=0; i<300; i++) {
     rt_tick(ix);
     rt_tock(ix);
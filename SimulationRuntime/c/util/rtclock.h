@@ -128,6 +128,37 @@ void rt_add_ncall(int ix, int n);
 
 void rt_measure_overhead(int ix);
 
+/* The timers of the threads working for one model instance, e.g. its OpenMP
+ * workers, see rtclock.c. A thread joins the group of its instance before it
+ * ticks, NULL is the default group of the process. rt_group_free moves the
+ * threads still in the group to the default group. */
+typedef struct rt_clock_group rt_clock_group;
+
+rt_clock_group* rt_group_new(void);
+void rt_group_join(rt_clock_group *group);
+void rt_group_free(rt_clock_group *group);
+
+/* Hardware performance counters (Linux perf_event), read in rt_tick() and
+ * rt_accumulate() for every timer when enabled: before the clock in
+ * rt_tick() and after it in rt_accumulate(), so that reading them is not
+ * part of the measured time */
+enum omc_rt_hwcounter_t {
+  RT_HW_CYCLES,
+  RT_HW_INSTRUCTIONS,
+  RT_HW_CACHE_MISSES,
+  RT_HW_BRANCH_MISSES,
+  RT_HW_NUM_COUNTERS
+};
+
+int rt_hw_init(int numTimers); /* non-zero on failure */
+int rt_hw_enabled();
+/* Returns 0 if the counter could not be opened */
+int rt_hw_available(enum omc_rt_hwcounter_t counter);
+/* Returns the number of events counted between tick() and accumulate() since the last clear_total() */
+uint64_t rt_hw_total(int ix, enum omc_rt_hwcounter_t counter);
+/* Closes the counters of all threads of the group, which are idle */
+void rt_hw_close();
+
 /* tick() ... tock() with external rtclock_t -> returns the number of seconds since the tick */
 void rt_ext_tp_tick(rtclock_t* tick_tp);
 void rt_ext_tp_tick_realtime(rtclock_t* tick_tp);
@@ -35,11 +35,19 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
 
   /* FLAG_ABORT_SLOW */            "abortSlowSimulation",
   /* FLAG_ALARM */                 "alarm",
+  /* FLAG_BATCH */                 "batch",
+  /* FLAG_BATCH_RESULT */          "batchResult",
+  /* FLAG_BATCH_THREADS */         "batchThreads",
+  /* FLAG_BINARY_TRACE */          "binaryTrace",
+  /* FLAG_CHECKPOINT */            "checkpoint",
+  /* FLAG_CHECKPOINT_INTERVAL */   "checkpointInterval",
+  /* FLAG_CHECKPOINT_TIME */       "checkpointTime",
   /* FLAG_CLOCK */                 "clock",
   /* FLAG_CPU */                   "cpu",
   /* FLAG_CSV_OSTEP */             "csvOstep",
   /* FLAG_DASSL_NO_RESTART */      "dasslnoRestart",
   /* FLAG_DASSL_NO_ROOTFINDING */  "dasslnoRootFinding",
+  /* FLAG_DENSE_OUTPUT */          "denseOutput",
   /* FLAG_EMBEDDED_SERVER */       "embeddedServer",
   /* FLAG_EMIT_PROTECTED */        "emit_protected",
   /* FLAG_F */                     "f",
@@ -48,11 +56,14 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_IIF */                   "iif",
   /* FLAG_IIM */                   "iim",
   /* FLAG_IIT */                   "iit",
+  /* FLAG_INIT_CACHE */            "initCache",
+  /* FLAG_INIT_SOLUTION_CACHE */   "initSolutionCache",
   /* FLAG_ILS */                   "ils",
   /* FLAG_INITIAL_STEP_SIZE */     "initialStepSize",
   /* FLAG_INPUT_CSV */             "csvInput",
   /* FLAG_INPUT_FILE */            "exInputFile",
   /* FLAG_INPUT_FILE_STATES */     "stateFile",
+  /* FLAG_INPUT_WINDOW */          "inputWindow",
   /* FLAG_IPOPT_HESSE*/            "ipopt_hesse",
   /* FLAG_IPOPT_INIT*/             "ipopt_init",
   /* FLAG_IPOPT_JAC*/              "ipopt_jac",
@@ -73,6 +84,13 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_MAX_ORDER */             "maxIntegrationOrder",
   /* FLAG_MAX_STEP_SIZE */         "maxStepSize",
   /* FLAG_MEASURETIMEPLOTFORMAT */ "measureTimePlotFormat",
+  /* FLAG_MEASURETIME_PERF_COUNTERS */ "measureTimePerfCounters",
+  /* FLAG_MEASURETIME_RAW */       "measureTimeRaw",
+  /* FLAG_MEASURETIME_WINDOW */    "measureTimeWindow",
+  /* FLAG_METRICS */               "metrics",
+  /* FLAG_MR_FAST */               "multirateFast",
+  /* FLAG_MR_RATIO */              "multirateRatio",
+  /* FLAG_MR_REPARTITION */        "multirateRepartition",
   /* FLAG_NEWTON_STRATEGY */       "newton",
   /* FLAG_NLS */                   "nls",
   /* FLAG_NLS_INFO */              "nlsInfo",
@@ -89,8 +107,14 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_OVERRIDE_FILE */         "overrideFile",
   /* FLAG_PORT */                  "port",
   /* FLAG_R */                     "r",
+  /* FLAG_RESTART */               "restart",
   /* FLAG_RT */                    "rt",
+  /* FLAG_RT_CPU */                "rtCpu",
+  /* FLAG_RT_PREFAULT */           "rtPrefault",
+  /* FLAG_RT_PROFILE */            "rtProfile",
   /* FLAG_S */                     "s",
+  /* FLAG_STEADY_STATE */          "steadyState",
+  /* FLAG_STEADY_STATE_WINDOW */   "steadyStateWindow",
   /* FLAG_UP_HESSIAN */            "keepHessian",
   /* FLAG_W */                     "w",
 
@@ -102,11 +126,19 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
 
   /* FLAG_ABORT_SLOW */            "aborts if the simulation chatters",
   /* FLAG_ALARM */                 "aborts after the given number of seconds (0 disables)",
+  /* FLAG_BATCH */                 "value specifies a parameter matrix (.csv or .json); the model is simulated once per row",
+  /* FLAG_BATCH_RESULT */          "value specifies how the results of a batch run are stored: files or stacked",
+  /* FLAG_BATCH_THREADS */         "value specifies the number of model instances simulating the runs of -batch in parallel",
+  /* FLAG_BINARY_TRACE */          "value specifies a file to record the binary trace of solver events in",
+  /* FLAG_CHECKPOINT */            "value specifies the file the simulation state is saved to for a later -restart",
+  /* FLAG_CHECKPOINT_INTERVAL */   "value specifies the simulation time between two checkpoints",
+  /* FLAG_CHECKPOINT_TIME */       "value specifies the simulation time a checkpoint is written at",
   /* FLAG_CLOCK */                 "selects the type of clock to use -clock=RT, -clock=CYC or -clock=CPU",
   /* FLAG_CPU */                   "dumps the cpu-time into the results-file",
   /* FLAG_CSV_OSTEP */             "value specifies csv-files for debuge values for optimizer step",
   /* FLAG_DASSL_NO_RESTART */      "flag deactivates the restart of dassl after an event is performed.",
   /* FLAG_DASSL_NO_ROOTFINDING */  "flag deactivates the internal root finding procedure of dassl.",
+  /* FLAG_DENSE_OUTPUT */          "[flag] lets the integrator take its own steps and interpolates the result points in between (dassl and ida)",
   /* FLAG_EMBEDDED_SERVER */       "enables an embedded server. Valid values: none, opc-da [broken], opc-ua [experimental], or the path to a shared object.",
   /* FLAG_EMIT_PROTECTED */        "emits protected variables to the result-file",
   /* FLAG_F */                     "value specifies a new setup XML file to the generated simulation code",
@@ -115,11 +147,14 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_IIF */                   "value specifies an external file for the initialization of the model",
   /* FLAG_IIM */                   "value specifies the initialization method",
   /* FLAG_IIT */                   "[double] value specifies a time for the initialization of the model",
+  /* FLAG_INIT_CACHE */            "[flag] cache the parsed _init.xml in a binary image and load it on later runs",
+  /* FLAG_INIT_SOLUTION_CACHE */   "value specifies a file converged initial solutions are cached in, keyed by the parameters",
   /* FLAG_ILS */                   "[int] default: 1",
   /* FLAG_INITIAL_STEP_SIZE */     "value specifies an initial stepsize for the dassl solver",
   /* FLAG_INPUT_CSV */             "value specifies an csv-file with inputs for the simulation/optimization of the model",
   /* FLAG_INPUT_FILE */            "value specifies an external file with inputs for the simulation/optimization of the model",
   /* FLAG_INPUT_FILE_STATES */     "value specifies an file with states start values for the optimization of the model",
+  /* FLAG_INPUT_WINDOW */          "value specifies the number of rows of the external input file that are held in memory at once",
   /* FLAG_IPOPT_HESSE */           "value specifies the hessian for Ipopt",
   /* FLAG_IPOPT_INIT */            "value specifies the initial guess for optimization",
   /* FLAG_IPOPT_JAC */             "value specifies the jacobian for Ipopt",
@@ -140,6 +175,13 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_MAX_ORDER */             "value specifies maximum integration order, used by dassl solver",
   /* FLAG_MAX_STEP_SIZE */         "value specifies maximum absolute step size, used by dassl solver",
   /* FLAG_MEASURETIMEPLOTFORMAT */ "value specifies the output format of the measure time functionality",
+  /* FLAG_MEASURETIME_PERF_COUNTERS */ "reads hardware performance counters around the measured functions and profile blocks (Linux only)",
+  /* FLAG_MEASURETIME_RAW */       "writes the per-step measure time data to _prof.realdata and _prof.intdata",
+  /* FLAG_MEASURETIME_WINDOW */    "[double] value specifies the length of the sampled time windows for aggregated time measurements",
+  /* FLAG_METRICS */               "[port|path] serves live counters of the running simulation on 127.0.0.1:<port> or on a Unix socket",
+  /* FLAG_MR_FAST */               "[string list] states that -s=multirate always integrates with micro steps",
+  /* FLAG_MR_RATIO */              "[int] maximum number of micro steps per macro step of -s=multirate (default 16)",
+  /* FLAG_MR_REPARTITION */        "[int] macro steps between the re-partitioning of -s=multirate (default 50)",
   /* FLAG_NEWTON_STRATEGY */       "value specifies the damping strategy for the newton solver",
   /* FLAG_NLS */                   "value specifies the nonlinear solver",
   /* FLAG_NLS_INFO */              "outputs detailed information about solving process of non-linear systems into csv files.",
@@ -156,8 +198,14 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_OVERRIDE_FILE */         "will override the variables or the simulation settings in the XML setup file with the values from the file",
   /* FLAG_PORT */                  "value specifies the port for simulation status (default disabled)",
   /* FLAG_R */                     "value specifies a new result file than the default Model_res.mat",
+  /* FLAG_RESTART */               "value specifies a checkpoint file the simulation is resumed from",
   /* FLAG_RT */                    "value specifies the scaling factor for real-time synchronization (0 disables)",
+  /* FLAG_RT_CPU */                "[int] value specifies the CPU core the real-time simulation thread is pinned to",
+  /* FLAG_RT_PREFAULT */           "[int] value specifies how many MB of heap are prefaulted for -rtProfile (default 64)",
+  /* FLAG_RT_PROFILE */            "[flag] real-time profile: pinned and prefaulted simulation thread, output and logging in background threads, step jitter histograms",
   /* FLAG_S */                     "value specifies the solver",
+  /* FLAG_STEADY_STATE */          "[double] terminates the simulation early once the states settle below the given tolerance",
+  /* FLAG_STEADY_STATE_WINDOW */   "[double] length of the time window used by -steadyState",
   /* FLAG_UP_HESSIAN */            "value specifies the number of steps, which keep hessian matrix constant",
   /* FLAG_W */                     "shows all warnings even if a related log-stream is inactive",
 
@@ -170,6 +218,38 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Aborts if the simulation chatters.",
   /* FLAG_ALARM */
   "  Aborts after the given number of seconds (default=0 disables the alarm).",
+  /* FLAG_BATCH */
+  "  Value specifies a parameter matrix. The model is loaded and initialized once and simulated once per row\n"
+  "  of the matrix by a pool of model instances (see -batchThreads). Each run starts from the start values\n"
+  "  of the model, with the values of the row overriding the start values of the named parameters and\n"
+  "  variables and the experiment settings startTime, stopTime, stepSize and tolerance.\n"
+  "  A .csv file has the names in its header line and one run per line.\n"
+  "  A .json file contains an array of objects, one per run, mapping names to numbers, booleans or strings.\n"
+  "  The results are written as configured by -batchResult.",
+  /* FLAG_BATCH_RESULT */
+  "  Value specifies how the results of the runs of -batch are stored:\n"
+  "    files:   each run writes <-r or model_res>_<run>.<format> (default)\n"
+  "    stacked: all runs are written to one CSV file <-r or model_res>.csv with the run index in the first column",
+  /* FLAG_BATCH_THREADS */
+  "  Value specifies the number of model instances (threads) that simulate the runs of -batch in parallel.\n"
+  "  The default is the number of processors.",
+  /* FLAG_BINARY_TRACE */
+  "  Value specifies a file the solver events of the hot paths (delay buffers, nonlinear value lists, zero crossings, sparse linear solvers) are recorded in.\n"
+  "  The events are collected in a ring buffer per thread without formatting any text and are decoded offline with tools/trace/omc_trace_decode.py.\n"
+  "  The trace is independent of the -lv streams and cheap enough to stay enabled in production runs.",
+  /* FLAG_CHECKPOINT */
+  "  Value specifies the file the complete simulation state is saved to. A checkpoint\n"
+  "  is written when -checkpointTime or -checkpointInterval is reached; without\n"
+  "  either of them a single checkpoint is written at the end of the simulation.\n"
+  "  Default: <model>.chk. Periodic checkpoints replace the file atomically.",
+  /* FLAG_CHECKPOINT_INTERVAL */
+  "  Value specifies the simulation time between two checkpoints, which are written\n"
+  "  to the file given by -checkpoint. The checkpoint is taken at the end of the first\n"
+  "  output or event step at or after the requested time.",
+  /* FLAG_CHECKPOINT_TIME */
+  "  Value specifies the simulation time a single checkpoint is written at, see\n"
+  "  -checkpoint. The checkpoint is taken at the end of the first output or event\n"
+  "  step at or after that time.",
   /* FLAG_CLOCK */
   "  Selects the type of clock to use. Valid options include:\n\n"
   "  * RT (monotonic real-time clock)\n"
@@ -183,6 +263,12 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Deactivates the restart of dassl after an event is performed.",
   /* FLAG_DASSL_NO_ROOTFINDING */
   "  Deactivates the internal root finding procedure of dassl.",
+  /* FLAG_DENSE_OUTPUT */
+  "  Lets the integrator (dassl or ida) take its natural steps instead of returning at every\n"
+  "  output point. The result points of the equidistant grid that lie inside a step are computed\n"
+  "  from the interpolation polynomial of the integrator, and algebraic variables at those points\n"
+  "  are recomputed from the interpolated states. Events are emitted as usual.\n"
+  "  Other solvers, and -noEquidistantTimeGrid, ignore this flag.",
   /* FLAG_EMBEDDED_SERVER */
   "  Enables an embedded server. Valid values:\n"
   "  * none - default, run without embedded server\n"
@@ -204,6 +290,20 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies the initialization method.", /* TODO: Fill me in */
   /* FLAG_IIT */
   "  Value [Real] specifies a time for the initialization of the model.",
+  /* FLAG_INIT_CACHE */
+  "  Stores the data read from the _init.xml file in the binary image <file>_init.bin next to it\n"
+  "  and maps that image on subsequent runs instead of parsing the XML file again.\n"
+  "  The image is rebuilt automatically whenever the model or the _init.xml file changes.\n"
+  "  Values given by -override and -overrideFile are still applied on top of the image.",
+  /* FLAG_INIT_SOLUTION_CACHE */
+  "  Value specifies a file that caches converged initial solutions. The key of an entry is a\n"
+  "  hash of all parameter values, the fixed start values and the start time.\n"
+  "  If the key of a run is found, the initial system is solved starting from the cached solution,\n"
+  "  so the nonlinear solvers only have to confirm the residuals. Otherwise the entry with the\n"
+  "  nearest real parameters and the same discrete parameters is used as starting guess, and\n"
+  "  the run falls back to the regular initialization if that does not converge.\n"
+  "  The file holds at most 64 entries, the least recently used one is replaced. Hit and miss\n"
+  "  counts are reported with -lv=LOG_STATS.",
   /* FLAG_ILS */
   "  Value specifies the number of steps for homotopy method (required: -iim=symbolic) or 'start value homotopy' method (required: -iim=numeric -iom=nelder_mead_ex).\n"
   "  The value is an Integer with default value 1.",
@@ -215,6 +315,11 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies an external file with inputs for the simulation/optimization of the model.",
  /* FLAG_INPUT_FILE_STATES */
   "  Value specifies an file with states start values for the optimization of the model.",
+  /* FLAG_INPUT_WINDOW */
+  "  Value specifies the number of rows of the external input file (-csvInput, -exInputFile) that are held in memory at once.\n"
+  "  The file is read window by window while the simulation runs and the next window is read ahead by a background thread.\n"
+  "  A window also keeps the rows back to the last accepted solver step, so it grows if a step spans more rows.\n"
+  "  Default: 16384.",
   /* FLAG_IPOPT_HESSE */
   "  Value specifies the hessematrix for Ipopt(OMC, BFGS, const).",
   /* FLAG_IPOPT_INIT */
@@ -273,6 +378,43 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  * ps\n"
   "  * gif\n"
   "  * ...",
+  /* FLAG_MEASURETIME_PERF_COUNTERS */
+  "  Opens hardware performance counters (cycles, instructions, cache misses and\n"
+  "  branch misses) using perf_event_open and reads them around every measured\n"
+  "  function and profile block. The profiling output then contains the counters,\n"
+  "  the instructions per cycle and the miss rates per block, which shows if a\n"
+  "  block is compute-bound or memory-bound. Only available on Linux; the counters\n"
+  "  may be restricted by /proc/sys/kernel/perf_event_paranoid.",
+  /* FLAG_MEASURETIME_RAW */
+  "  Writes the time measurements of every global step to the files _prof.realdata\n"
+  "  and _prof.intdata (one row per step). These files are used to plot the\n"
+  "  execution time of each function and profile block over time, but may grow\n"
+  "  very large for long simulations. Without this flag only aggregated\n"
+  "  statistics (count, total, min, max and a latency histogram) are kept.",
+  /* FLAG_MEASURETIME_WINDOW */
+  "  Value specifies the length (in simulation time) of the windows in which the\n"
+  "  aggregated time measurements are additionally sampled. Each window stores the\n"
+  "  number of steps and the time spent in each function and profile block.\n"
+  "  Disabled by default.",
+  /* FLAG_METRICS */
+  "  Serves live counters of the running simulation in the Prometheus text format:\n"
+  "  simulated time, solver steps and rejected steps, function and Jacobian evaluations,\n"
+  "  events, calls and time of every linear and non-linear system, real-time lateness\n"
+  "  and memory usage. A number opens a TCP port on 127.0.0.1, anything else is used\n"
+  "  as the path of a Unix socket, e.g. curl --unix-socket <path> http://localhost/metrics.\n"
+  "  The counters are read without locks from a background thread, so the simulation\n"
+  "  does no extra work. With -batch only the model instance that listens first serves\n"
+  "  its runs. Not supported on Windows.",
+  /* FLAG_MR_FAST */
+  "  Comma separated list of states that the multirate solver (-s=multirate) always puts\n"
+  "  into the fast partition, in addition to the states it detects as fast.",
+  /* FLAG_MR_RATIO */
+  "  Value specifies the maximum number of micro steps of the fast partition per macro step\n"
+  "  of the multirate solver (-s=multirate). The default is 16.",
+  /* FLAG_MR_REPARTITION */
+  "  Value specifies after how many macro steps the multirate solver (-s=multirate) estimates\n"
+  "  the time constants of the states again and re-partitions them. The states are also\n"
+  "  re-partitioned after every event. The default is 50.",
   /* FLAG_NEWTON_STRATEGY */
   "  Value specifies the damping strategy for the newton solver.",
   /* FLAG_NLS */
@@ -322,11 +464,40 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies the name of the output result file.\n"
   "  The default file-name is based on the model name and output format.\n"
   "  For example: Model_res.mat.",
+  /* FLAG_RESTART */
+  "  Value specifies a checkpoint file written with -checkpoint. The model is\n"
+  "  initialized as usual, then the state of the checkpoint is restored and the\n"
+  "  simulation continues from the time it was taken. Parameters changed with\n"
+  "  -override since the checkpoint was written take their new values, all other\n"
+  "  parameters keep the values of the checkpoint.",
   /* FLAG_RT */
   "  Value specifies the scaling factor for real-time synchronization (0 disables).\n"
   "  A value > 1 means the simulation takes a longer time to simulate.\n",
+  /* FLAG_RT_CPU */
+  "  Value specifies the CPU core (starting at 0) the simulation thread is pinned to when running\n"
+  "  in real time (-rt) with -rtProfile. Use a core isolated from the scheduler (isolcpus).\n"
+  "  Only supported on Linux.",
+  /* FLAG_RT_PREFAULT */
+  "  Value specifies how many megabytes of heap (malloc and garbage collected) are allocated and touched\n"
+  "  before the first step when running with -rtProfile, so that later allocations do not page fault.\n"
+  "  The stack is prefaulted as well. The default is 64.",
+  /* FLAG_RT_PROFILE */
+  "  Prepares the simulation thread for hardware-in-the-loop use when running in real time (-rt):\n"
+  "  the thread is pinned to the core given by -rtCpu, heap and stack are prefaulted (see -rtPrefault),\n"
+  "  and result output as well as log messages are handed over lock-free to background threads.\n"
+  "  Step jitter, lateness and deadline misses are collected in lock-free histograms that can be\n"
+  "  read while the simulation runs and that are summarized at the end (-lv=LOG_RT).",
   /* FLAG_S */
   "  Value specifies the solver (integration method).",
+  /* FLAG_STEADY_STATE */
+  "  Value specifies a tolerance for steady-state detection. After every step the root mean\n"
+  "  square of der(x)/nominal(x) over all states is computed. If it stays below the tolerance\n"
+  "  for the time window given by -steadyStateWindow and no event occurs meanwhile, the\n"
+  "  simulation stops at the current time and writes the steady state as its last result point.\n"
+  "  Only the states are monitored, so time events scheduled after the window cannot be anticipated.",
+  /* FLAG_STEADY_STATE_WINDOW */
+  "  Value specifies how long (in model time) the states have to stay below the tolerance\n"
+  "  of -steadyState before the simulation terminates. The default is ten output intervals.",
   /* FLAG_UP_HESSIAN */
   "  Value specifies the number of steps, which keep hessian matrix constant.",
   /* FLAG_W */
@@ -340,11 +511,19 @@ const int FLAG_TYPE[FLAG_MAX] = {
 
   /* FLAG_ABORT_SLOW */            FLAG_TYPE_FLAG,
   /* FLAG_ALARM */                 FLAG_TYPE_OPTION,
+  /* FLAG_BATCH */                 FLAG_TYPE_OPTION,
+  /* FLAG_BATCH_RESULT */          FLAG_TYPE_OPTION,
+  /* FLAG_BATCH_THREADS */         FLAG_TYPE_OPTION,
+  /* FLAG_BINARY_TRACE */          FLAG_TYPE_OPTION,
+  /* FLAG_CHECKPOINT */            FLAG_TYPE_OPTION,
+  /* FLAG_CHECKPOINT_INTERVAL */   FLAG_TYPE_OPTION,
+  /* FLAG_CHECKPOINT_TIME */       FLAG_TYPE_OPTION,
   /* FLAG_CLOCK */                 FLAG_TYPE_OPTION,
   /* FLAG_CPU */                   FLAG_TYPE_FLAG,
   /* FLAG_CSV_OSTEP */             FLAG_TYPE_OPTION,
   /* FLAG_DASSL_NO_RESTART */      FLAG_TYPE_FLAG,
   /* FLAG_DASSL_NO_ROOTFINDING */  FLAG_TYPE_FLAG,
+  /* FLAG_DENSE_OUTPUT */          FLAG_TYPE_FLAG,
   /* FLAG_EMBEDDED_SERVER */       FLAG_TYPE_OPTION,
   /* FLAG_EMIT_PROTECTED */        FLAG_TYPE_FLAG,
   /* FLAG_F */                     FLAG_TYPE_OPTION,
@@ -353,11 +532,14 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_IIF */                   FLAG_TYPE_OPTION,
   /* FLAG_IIM */                   FLAG_TYPE_OPTION,
   /* FLAG_IIT */                   FLAG_TYPE_OPTION,
+  /* FLAG_INIT_CACHE */            FLAG_TYPE_FLAG,
+  /* FLAG_INIT_SOLUTION_CACHE */   FLAG_TYPE_OPTION,
   /* FLAG_ILS */                   FLAG_TYPE_OPTION,
   /* FLAG_INITIAL_STEP_SIZE */     FLAG_TYPE_OPTION,
   /* FLAG_INPUT_CSV */             FLAG_TYPE_OPTION,
   /* FLAG_INPUT_FILE */            FLAG_TYPE_OPTION,
   /* FLAG_INPUT_FILE_STATES */     FLAG_TYPE_OPTION,
+  /* FLAG_INPUT_WINDOW */          FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_HESSE */           FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_INIT */            FLAG_TYPE_OPTION,
   /* FLAG_IPOPT_JAC */             FLAG_TYPE_OPTION,
@@ -378,6 +560,13 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_MAX_ORDER */             FLAG_TYPE_OPTION,
   /* FLAG_MAX_STEP_SIZE */         FLAG_TYPE_OPTION,
   /* FLAG_MEASURETIMEPLOTFORMAT */ FLAG_TYPE_OPTION,
+  /* FLAG_MEASURETIME_PERF_COUNTERS */ FLAG_TYPE_FLAG,
+  /* FLAG_MEASURETIME_RAW */       FLAG_TYPE_FLAG,
+  /* FLAG_MEASURETIME_WINDOW */    FLAG_TYPE_OPTION,
+  /* FLAG_METRICS */               FLAG_TYPE_OPTION,
+  /* FLAG_MR_FAST */               FLAG_TYPE_OPTION,
+  /* FLAG_MR_RATIO */              FLAG_TYPE_OPTION,
+  /* FLAG_MR_REPARTITION */        FLAG_TYPE_OPTION,
   /* FLAG_NEWTON_STRATEGY */       FLAG_TYPE_OPTION,
   /* FLAG_NLS */                   FLAG_TYPE_OPTION,
   /* FLAG_NLS_INFO */              FLAG_TYPE_FLAG,
@@ -394,8 +583,14 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_OVERRIDE_FILE */         FLAG_TYPE_OPTION,
   /* FLAG_PORT */                  FLAG_TYPE_OPTION,
   /* FLAG_R */                     FLAG_TYPE_OPTION,
+  /* FLAG_RESTART */               FLAG_TYPE_OPTION,
   /* FLAG_RT */                    FLAG_TYPE_OPTION,
+  /* FLAG_RT_CPU */                FLAG_TYPE_OPTION,
+  /* FLAG_RT_PREFAULT */           FLAG_TYPE_OPTION,
+  /* FLAG_RT_PROFILE */            FLAG_TYPE_FLAG,
   /* FLAG_S */                     FLAG_TYPE_OPTION,
+  /* FLAG_STEADY_STATE */          FLAG_TYPE_OPTION,
+  /* FLAG_STEADY_STATE_WINDOW */   FLAG_TYPE_OPTION,
   /* FLAG_UP_HESSIAN */            FLAG_TYPE_OPTION,
   /* FLAG_W */                     FLAG_TYPE_FLAG
 };
@@ -416,7 +611,8 @@ const char *SOLVER_METHOD_NAME[S_MAX] = {
   "symEulerSsc",
   "heun",
   "ida",
-  "qss"
+  "qss",
+  "multirate"
 };
 
 const char *SOLVER_METHOD_DESC[S_MAX] = {
@@ -435,7 +631,8 @@ const char *SOLVER_METHOD_DESC[S_MAX] = {
   "symEulerSsc - symbolic implicit euler with step-size control, [compiler flag +symEuler needed]",
   "heun - Heun's method (Runge-Kutta fixed step, order 2)",
   "ida - Sundials ida solver",
-  "qss - A QSS solver [experimental]"
+  "qss - A QSS solver [experimental]",
+  "multirate - Explicit slow states with macro steps, linearly implicit fast states with micro steps (fixed step)"
 };
 
 const char *INIT_METHOD_NAME[IIM_MAX] = {
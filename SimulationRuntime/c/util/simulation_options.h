@@ -43,11 +43,19 @@ enum _FLAG
 
   FLAG_ABORT_SLOW,
   FLAG_ALARM,
+  FLAG_BATCH,
+  FLAG_BATCH_RESULT,
+  FLAG_BATCH_THREADS,
+  FLAG_BINARY_TRACE,
+  FLAG_CHECKPOINT,
+  FLAG_CHECKPOINT_INTERVAL,
+  FLAG_CHECKPOINT_TIME,
   FLAG_CLOCK,
   FLAG_CPU,
   FLAG_CSV_OSTEP,
   FLAG_DASSL_NO_RESTART,
   FLAG_DASSL_NO_ROOTFINDING,
+  FLAG_DENSE_OUTPUT,
   FLAG_EMBEDDED_SERVER,
   FLAG_EMIT_PROTECTED,
   FLAG_F,
@@ -56,11 +64,14 @@ enum _FLAG
   FLAG_IIF,
   FLAG_IIM,
   FLAG_IIT,
+  FLAG_INIT_CACHE,
+  FLAG_INIT_SOLUTION_CACHE,
   FLAG_ILS,
   FLAG_INITIAL_STEP_SIZE,
   FLAG_INPUT_CSV,
   FLAG_INPUT_FILE,
   FLAG_INPUT_FILE_STATES,
+  FLAG_INPUT_WINDOW,
   FLAG_IPOPT_HESSE,
   FLAG_IPOPT_INIT,
   FLAG_IPOPT_JAC,
@@ -81,6 +92,13 @@ enum _FLAG
   FLAG_MAX_ORDER,
   FLAG_MAX_STEP_SIZE,
   FLAG_MEASURETIMEPLOTFORMAT,
+  FLAG_MEASURETIME_PERF_COUNTERS,
+  FLAG_MEASURETIME_RAW,
+  FLAG_MEASURETIME_WINDOW,
+  FLAG_METRICS,
+  FLAG_MR_FAST,
+  FLAG_MR_RATIO,
+  FLAG_MR_REPARTITION,
   FLAG_NEWTON_STRATEGY,
   FLAG_NLS,
   FLAG_NLS_INFO,
@@ -97,8 +115,14 @@ enum _FLAG
   FLAG_OVERRIDE_FILE,
   FLAG_PORT,
   FLAG_R,
+  FLAG_RESTART,
   FLAG_RT,
+  FLAG_RT_CPU,
+  FLAG_RT_PREFAULT,
+  FLAG_RT_PROFILE,
   FLAG_S,
+  FLAG_STEADY_STATE,
+  FLAG_STEADY_STATE_WINDOW,
   FLAG_UP_HESSIAN,
   FLAG_W,
 
@@ -139,6 +163,7 @@ enum SOLVER_METHOD
   S_HEUN,          /* 13 */
   S_IDA,           /* 14 */
   S_QSS,
+  S_MULTIRATE,
 
   S_MAX
 };
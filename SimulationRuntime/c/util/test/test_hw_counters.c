@@ -0,0 +1,109 @@
+/* Measures a timer with the hardware performance counters in the main
+ * thread and in worker threads of the same timer group, like the OpenMP
+ * workers of a model instance, which open their counters on first use.
+ * While the workers are idle, the main thread closes the counters.
+ * Checks that
+ *  - rt_hw_close closes the counters of all threads, not only of the
+ *    calling one,
+ *  - the workers open their counters again after a new rt_hw_init and
+ *    their events count for the timer.
+ * Without hardware counters (other platforms, virtual machines, a
+ * restrictive perf_event_paranoid) the test is skipped. */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "util/rtclock.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+#define NUM_WORKERS 4
+#define TIMER (SIM_TIMER_FIRST_FUNCTION + 1)
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+static pthread_barrier_t barrier;
+
+/* stands for the work of a parallel region */
+static double work(int n)
+{
+  volatile double sum = 0.0;
+  int i;
+  for (i = 0; i < n; i++) {
+    sum += i * 0.5;
+  }
+  return sum;
+}
+
+/* runs two parallel regions, the main thread closes and opens the counters in between */
+static void* run_worker(void *arg)
+{
+  int region;
+  for (region = 0; region < 2; region++) {
+    rt_tick(TIMER);
+    work(100000);
+    rt_accumulate(TIMER);
+    pthread_barrier_wait(&barrier);
+    pthread_barrier_wait(&barrier);
+  }
+  return NULL;
+}
+
+static int open_fds(void)
+{
+  int n = 0;
+#if defined(__linux__)
+  DIR *dir = opendir("/proc/self/fd");
+  if (dir) {
+    while (readdir(dir)) {
+      n++;
+    }
+    closedir(dir);
+  }
+#endif
+  return n;
+}
+
+int main()
+{
+  pthread_t workers[NUM_WORKERS];
+  int fds, i;
+
+  rt_init(TIMER + 1);
+  fds = open_fds();
+  if (rt_hw_init(TIMER + 1)) {
+    printf("no hardware performance counters, skipped\n");
+    return 0;
+  }
+  rt_clear_total(TIMER);
+
+  pthread_barrier_init(&barrier, NULL, NUM_WORKERS + 1);
+  for (i = 0; i < NUM_WORKERS; i++) {
+    pthread_create(&workers[i], NULL, run_worker, NULL);
+  }
+
+  /* first region: every thread has its counters open */
+  pthread_barrier_wait(&barrier);
+  CHECK(open_fds() > fds + NUM_WORKERS, "the workers did not open their counters (%d files open, %d before)", open_fds(), fds);
+  rt_hw_close();
+  CHECK(open_fds() == fds, "rt_hw_close left %d counters of the workers open", open_fds() - fds);
+
+  /* second region: the workers open their counters again */
+  rt_hw_init(TIMER + 1);
+  rt_clear_total(TIMER);
+  pthread_barrier_wait(&barrier);
+  pthread_barrier_wait(&barrier);
+  CHECK(rt_hw_total(TIMER, RT_HW_CYCLES) > 0, "the cycles of the workers did not count after rt_hw_init");
+  pthread_barrier_wait(&barrier);
+
+  for (i = 0; i < NUM_WORKERS; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  pthread_barrier_destroy(&barrier);
+  rt_hw_close();
+  return errors;
+}
@@ -0,0 +1,136 @@
+/* Records events of the binary trace from the main thread and from worker
+ * threads, with rings so small that every thread appends several blocks to
+ * the file, and reads the file back. The trace is then opened a second
+ * time, after the rings of the first trace have been freed.
+ * Checks that
+ *  - the file starts with the header and the names of the streams and
+ *    events,
+ *  - every recorded event is in the file exactly once, with its stream,
+ *    event id and values, and the events of a thread in the order they were
+ *    recorded under one thread index,
+ *  - OMC_TRACE records nothing while the trace is closed,
+ *  - the second trace only holds its own events. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "util/omc_error.h"
+#include "util/omc_trace.h"
+
+#define NUM_WORKERS 4
+#define NUM_EVENTS 1000
+#define RING_SIZE 7
+#define MAIN_ID NUM_WORKERS
+#define TRACE_FILE "test_omc_trace.bin"
+
+static int errors = 0;
+
+#define CHECK(cond, ...) if (!(cond)) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; }
+
+/* records the events 0, 1, ... of the thread id */
+static void record(int id, int n)
+{
+  int k;
+  for (k = 0; k < n; k++) {
+    OMC_TRACE(LOG_EVENTS, OMC_TRACE_ZEROCROSSING_CHANGED, 4, id, k, 0.5*k, -k);
+  }
+}
+
+static void* run_worker(void *arg)
+{
+  record((int) (size_t) arg, NUM_EVENTS);
+  return NULL;
+}
+
+/* reads the trace file and checks it holds the events 0..counts[id]-1 of every thread id */
+static void checkFile(const int *counts, int numIds)
+{
+  FILE *file = fopen(TRACE_FILE, "rb");
+  OMC_TRACE_HEADER header;
+  OMC_TRACE_RECORD rec;
+  char *names;
+  int next[NUM_WORKERS + 1] = {0}, thread[NUM_WORKERS + 1];
+  int id, k, numRecords = 0, expected = 0;
+
+  CHECK(file != NULL, "could not open %s", TRACE_FILE);
+  if (file == NULL) {
+    return;
+  }
+  CHECK(fread(&header, sizeof(header), 1, file) == 1 && !memcmp(header.magic, OMC_TRACE_MAGIC, sizeof(header.magic)) &&
+        header.version == OMC_TRACE_VERSION && header.recordSize == sizeof(OMC_TRACE_RECORD) &&
+        header.numStreams == SIM_LOG_MAX && header.numEvents == OMC_TRACE_MAX_EVENT && header.namesSize % 8 == 0,
+        "the header of the trace is wrong");
+  names = (char*) calloc(header.namesSize + 1, 1);
+  CHECK(fread(names, 1, header.namesSize, file) == header.namesSize && !strcmp(names, LOG_STREAM_NAME[0]),
+        "the names of the streams are missing");
+  free(names);
+
+  for (id = 0; id < numIds; id++) {
+    thread[id] = -1;
+    expected += counts[id];
+  }
+  while (fread(&rec, sizeof(rec), 1, file) == 1) {
+    numRecords++;
+    id = (int) rec.values[0];
+    k = (int) rec.values[1];
+    if (id < 0 || id >= numIds || rec.stream != LOG_EVENTS || rec.event != OMC_TRACE_ZEROCROSSING_CHANGED ||
+        rec.numValues != 4 || rec.values[2] != 0.5*k || rec.values[3] != -k) {
+      CHECK(0, "record %d is corrupt", numRecords);
+      continue;
+    }
+    CHECK(k == next[id], "thread %d: event %d where %d was expected", id, k, next[id]);
+    next[id] = k + 1;
+    if (thread[id] < 0) {
+      thread[id] = rec.thread;
+    }
+    CHECK(rec.thread == thread[id], "thread %d: events under the thread indexes %d and %d", id, thread[id], rec.thread);
+  }
+  fclose(file);
+
+  CHECK(numRecords == expected, "%d records in the trace, %d expected", numRecords, expected);
+  for (id = 0; id < numIds; id++) {
+    CHECK(next[id] == counts[id], "thread %d: %d of %d events in the trace", id, next[id], counts[id]);
+  }
+}
+
+int main()
+{
+  int streams[SIM_LOG_MAX] = {0};
+  int counts[NUM_WORKERS + 1] = {0};
+  pthread_t workers[NUM_WORKERS];
+  int i;
+
+  omc_set_thread_streams(streams);
+  useStream[LOG_STDOUT] = 1;
+  useStream[LOG_ASSERT] = 1;
+
+  /* first trace */
+  CHECK(omc_trace_open(TRACE_FILE, RING_SIZE) == 0, "omc_trace_open failed");
+  for (i = 0; i < NUM_WORKERS; i++) {
+    pthread_create(&workers[i], NULL, run_worker, (void*) (size_t) i);
+    counts[i] = NUM_EVENTS;
+  }
+  record(MAIN_ID, NUM_EVENTS);
+  counts[MAIN_ID] = NUM_EVENTS;
+  for (i = 0; i < NUM_WORKERS; i++) {
+    pthread_join(workers[i], NULL);
+  }
+  omc_trace_close();
+  record(MAIN_ID, 3);
+  checkFile(counts, NUM_WORKERS + 1);
+
+  /* second trace, the main thread had a ring in the first one */
+  CHECK(omc_trace_open(TRACE_FILE, RING_SIZE) == 0, "omc_trace_open failed");
+  for (i = 0; i < NUM_WORKERS; i++) {
+    counts[i] = 0;
+  }
+  record(MAIN_ID, 10);
+  counts[MAIN_ID] = 10;
+  omc_trace_close();
+  checkFile(counts, NUM_WORKERS + 1);
+
+  remove(TRACE_FILE);
+  return errors;
+}
@@ -0,0 +1,263 @@
+/* Runs the same work load as several model instances, first one after
+ * another and then concurrently, each instance in a thread of its own.
+ * The results must be bit-identical: the timers, interpolation tables,
+ * memory pool and log flags of one instance must not be touched by the
+ * others.
+ * Every instance has a worker thread in the timer, pool and table groups of
+ * the instance, like an OpenMP worker, that runs a parallel region in every
+ * step. It interpolates the table of the instance by its id and must get
+ * the values of the instance. Its timer calls must count for the totals of
+ * the instance, also after it exited, and its pool must be reset by the
+ * collect of the instance. The odd instances and their workers use no pool
+ * group: the collect of such an instance must only reset its own pool, not
+ * the pools of the other instances. */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "openmodelica.h"
+#include "util/omc_error.h"
+#include "util/rtclock.h"
+#include "util/memory_pool.h"
+#include "util/OldModelicaTables.h"
+
+#define NUM_INSTANCES 8
+#define NUM_STEPS 20000
+#define STEPS_PER_COLLECT 100
+
+#define WORKER_TIMER (SIM_TIMER_FIRST_FUNCTION + 1)
+/* collects after which the pool of the worker has reached its size */
+#define WARM_UP 2
+
+typedef struct {
+  int id;
+  double result[NUM_STEPS];
+  double workerResult[NUM_STEPS];
+  uint32_t ncall;
+  uint32_t workerNcall;
+  uint32_t workerNcallExited;
+  int streamOk;
+  int poolOk;
+  int workerPoolOk;
+  /* the worker */
+  rt_clock_group *timers;
+  pool_group *pools;             /* NULL for the odd instances */
+  table_group *tables;
+  int tableID;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int region;                    /* number of the region to run, -1 to exit */
+  int done;                      /* number of the last region run */
+  void *firstAlloc;              /* of the worker after the last collect */
+  int allocated;                 /* the worker allocated since the last collect */
+} instance_t;
+
+static void* run_worker(void *arg)
+{
+  instance_t *inst = (instance_t*) arg;
+  int region = 0, j;
+  double *buffer;
+
+  rt_group_join(inst->timers);
+  pool_group_join(inst->pools);
+  table_group_join(inst->tables);
+  for (;;) {
+    pthread_mutex_lock(&inst->mutex);
+    while (inst->region == region) {
+      pthread_cond_wait(&inst->cond, &inst->mutex);
+    }
+    region = inst->region;
+    pthread_mutex_unlock(&inst->mutex);
+    if (region < 0) {
+      break;
+    }
+
+    rt_tick(WORKER_TIMER);
+    buffer = (double*) omc_alloc_interface_pooled.malloc(64*sizeof(double));
+    for (j = 0; j < 64; ++j) {
+      buffer[j] = region + j;
+    }
+    if (!inst->allocated) {
+      inst->firstAlloc = buffer;
+      inst->allocated = 1;
+    }
+    inst->workerResult[region-1] = omcTableTimeIpo(inst->tableID, 2, (region-1) * 1e-3 * (1 + inst->id));
+    rt_accumulate(WORKER_TIMER);
+
+    pthread_mutex_lock(&inst->mutex);
+    inst->done = region;
+    pthread_cond_signal(&inst->cond);
+    pthread_mutex_unlock(&inst->mutex);
+  }
+  return NULL;
+}
+
+/* runs a region on the worker and waits for it */
+static void parallel_region(instance_t *inst, int region)
+{
+  pthread_mutex_lock(&inst->mutex);
+  inst->region = region;
+  pthread_cond_signal(&inst->cond);
+  while (region >= 0 && inst->done != region) {
+    pthread_cond_wait(&inst->cond, &inst->mutex);
+  }
+  pthread_mutex_unlock(&inst->mutex);
+}
+
+static void* run_instance(void *arg)
+{
+  instance_t *inst = (instance_t*) arg;
+  int streams[SIM_LOG_MAX];
+  double table[8];
+  double *buffers[STEPS_PER_COLLECT];
+  int sizes[STEPS_PER_COLLECT];
+  int tableID, k, i, j, collects = 0;
+  void *firstAlloc = NULL;
+
+  inst->timers = rt_group_new();
+  inst->pools = inst->id % 2 ? NULL : pool_group_new();
+  inst->tables = table_group_new();
+  rt_group_join(inst->timers);
+  pool_group_join(inst->pools);
+  table_group_join(inst->tables);
+  omc_set_thread_streams(streams);
+  useStream[LOG_EVENTS] = inst->id % 2;
+
+  /* rows (time, value) */
+  table[0] = 0.0; table[1] = inst->id;
+  table[2] = 1.0; table[3] = 2.0*inst->id + 1;
+  table[4] = 2.0; table[5] = -inst->id;
+  table[6] = 3.0; table[7] = 0.5;
+  tableID = omcTableTimeIni(0.0, 0.0, 0 /* linear */, 2 /* periodic */, "NoName", "NoName", table, 4, 2, 0);
+  inst->tableID = tableID;
+
+  rt_init(SIM_TIMER_FIRST_FUNCTION + 4);
+  rt_clear_total(SIM_TIMER_STEP);
+
+  pthread_mutex_init(&inst->mutex, NULL);
+  pthread_cond_init(&inst->cond, NULL);
+  inst->region = inst->done = 0;
+  inst->allocated = 0;
+  if (pthread_create(&inst->thread, NULL, run_worker, inst)) {
+    return NULL;
+  }
+
+  inst->poolOk = 1;
+  inst->workerPoolOk = 1;
+  for (k = 0; k < NUM_STEPS; ++k) {
+    double t = k * 1e-3 * (1 + inst->id);
+    double y;
+
+    rt_tick(SIM_TIMER_STEP);
+    y = omcTableTimeIpo(tableID, 2, t);
+    parallel_region(inst, k+1);
+
+    i = k % STEPS_PER_COLLECT;
+    sizes[i] = 1 + (k*7 + inst->id) % 61;
+    buffers[i] = (double*) omc_alloc_interface_pooled.malloc(sizes[i]*sizeof(double));
+    for (j = 0; j < sizes[i]; ++j) {
+      buffers[i][j] = y + j;
+    }
+    inst->result[k] = y;
+
+    if (i == STEPS_PER_COLLECT-1) {
+      /* nothing allocated since the last collect may have been overwritten */
+      for (i = 0; i < STEPS_PER_COLLECT; ++i) {
+        for (j = 0; j < sizes[i]; ++j) {
+          if (buffers[i][j] != inst->result[k-STEPS_PER_COLLECT+1+i] + j) {
+            inst->poolOk = 0;
+          }
+        }
+      }
+      omc_alloc_interface_pooled.collect_a_little();
+      /* the worker starts again at the same place of its pool */
+      if (inst->pools && ++collects > WARM_UP && inst->firstAlloc != firstAlloc) {
+        inst->workerPoolOk = 0;
+      }
+      firstAlloc = inst->firstAlloc;
+      inst->allocated = 0;
+    }
+    rt_accumulate(SIM_TIMER_STEP);
+  }
+
+  inst->ncall = rt_ncall(SIM_TIMER_STEP);
+  inst->workerNcall = rt_ncall_total(WORKER_TIMER);
+  parallel_region(inst, -1);
+  pthread_join(inst->thread, NULL);
+  inst->workerNcallExited = rt_ncall_total(WORKER_TIMER);
+  pthread_cond_destroy(&inst->cond);
+  pthread_mutex_destroy(&inst->mutex);
+
+  inst->streamOk = useStream[LOG_EVENTS] == inst->id % 2;
+  omcTableTimeIpoClose(tableID);
+  omc_set_thread_streams(NULL);
+  rt_group_join(NULL);
+  pool_group_join(NULL);
+  table_group_join(NULL);
+  rt_group_free(inst->timers);
+  pool_group_free(inst->pools);
+  table_group_free(inst->tables);
+  return NULL;
+}
+
+int main()
+{
+  static instance_t sequential[NUM_INSTANCES], concurrent[NUM_INSTANCES];
+  pthread_t threads[NUM_INSTANCES];
+  int i;
+
+  initDumpSystem();
+
+  for (i = 0; i < NUM_INSTANCES; ++i) {
+    sequential[i].id = i;
+    if (pthread_create(&threads[i], NULL, run_instance, &sequential[i])) return 1;
+    pthread_join(threads[i], NULL);
+  }
+
+  for (i = 0; i < NUM_INSTANCES; ++i) {
+    concurrent[i].id = i;
+    if (pthread_create(&threads[i], NULL, run_instance, &concurrent[i])) return 2;
+  }
+  for (i = 0; i < NUM_INSTANCES; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (i = 0; i < NUM_INSTANCES; ++i) {
+    if (memcmp(sequential[i].result, concurrent[i].result, sizeof(sequential[i].result))) {
+      fprintf(stderr, "instance %d: results differ from the sequential run\n", i);
+      return 1000+i;
+    }
+    if (memcmp(concurrent[i].result, concurrent[i].workerResult, sizeof(concurrent[i].result)) ||
+        memcmp(sequential[i].result, sequential[i].workerResult, sizeof(sequential[i].result))) {
+      fprintf(stderr, "instance %d: the worker got other values from the table of the instance\n", i);
+      return 1500+i;
+    }
+    if (sequential[i].ncall != NUM_STEPS || concurrent[i].ncall != NUM_STEPS) {
+      fprintf(stderr, "instance %d: %u/%u timer calls, expected %d\n", i, sequential[i].ncall, concurrent[i].ncall, NUM_STEPS);
+      return 2000+i;
+    }
+    if (sequential[i].workerNcall != NUM_STEPS || concurrent[i].workerNcall != NUM_STEPS ||
+        sequential[i].workerNcallExited != NUM_STEPS || concurrent[i].workerNcallExited != NUM_STEPS) {
+      fprintf(stderr, "instance %d: %u/%u timer calls of the worker, %u/%u after it exited, expected %d\n", i,
+              sequential[i].workerNcall, concurrent[i].workerNcall, sequential[i].workerNcallExited, concurrent[i].workerNcallExited, NUM_STEPS);
+      return 2500+i;
+    }
+    if (!sequential[i].workerPoolOk || !concurrent[i].workerPoolOk) {
+      fprintf(stderr, "instance %d: the pool of the worker was not reset by the collect\n", i);
+      return 3500+i;
+    }
+    if (!sequential[i].poolOk || !concurrent[i].poolOk) {
+      fprintf(stderr, "instance %d: pooled memory was overwritten\n", i);
+      return 3000+i;
+    }
+    if (!sequential[i].streamOk || !concurrent[i].streamOk) {
+      fprintf(stderr, "instance %d: log flags were changed by another instance\n", i);
+      return 4000+i;
+    }
+  }
+
+  /* everything OK */
+  return 0;
+}
@@ -46,8 +46,28 @@ ISimVar* SimData::Get(string key)
 
 void  SimData::addOutputResults(string name,ublas::vector<double> v)
 {
-    std::pair<string,ublas::vector<double> > elem(name,v);
-    std::pair<OutputResults_type::iterator,bool> p = _result_vars.insert(elem);
+    unsigned int handle = _result_vars.size1();
+    std::pair<OutputHandles_type::iterator,bool> p = _result_handles.insert(make_pair(name,handle));
+    if(!p.second)
+        return;
+    if(handle > 0 && _result_vars.size2() != v.size())
+    {
+        _result_handles.erase(p.first);
+        throw ModelicaSimulationError(DATASTORAGE,"Wrong number of results for output variable " + name);
+    }
+    _result_vars.resize(handle + 1, v.size(), true);
+    ublas::row(_result_vars,handle) = v;
+}
+
+void SimData::addOutputResults(const vector<string>& names, ublas::matrix<double>& results)
+{
+    if(names.size() != results.size1())
+        throw ModelicaSimulationError(DATASTORAGE,"Number of output variables does not match the results");
+    _result_handles.clear();
+    for(unsigned int i = 0; i < names.size(); i++)
+        _result_handles.insert(make_pair(names[i],i));
+    _result_vars.swap(results);
+    results.resize(0,0,false);
 }
 
 void SimData::getTimeEntries(vector<double>& time_entries)
@@ -67,7 +87,8 @@ void  SimData::destroy()
 
 void SimData::clearResults()
 {
-    _result_vars.clear();
+    _result_handles.clear();
+    _result_vars.resize(0,0,false);
     _time_entries.clear();
 }
 
@@ -78,18 +99,28 @@ void SimData::clearVars()
 
 void  SimData::getOutputResults(string name,ublas::vector<double>& v)
 {
-    OutputResults_type::const_iterator iter =_result_vars.find(name);
+    v = ublas::row(_result_vars,getOutputHandle(name));
+}
 
-    //Prüfen ob die Ergebnisse  in Liste ist.
-    if(iter!=_result_vars.end())
-    {
+unsigned int SimData::getOutputHandle(string name)
+{
+    OutputHandles_type::const_iterator iter =_result_handles.find(name);
 
-        v = omcpp::ref(iter->second);
-    }
+    //Prüfen ob die Ergebnisse  in Liste ist.
+    if(iter!=_result_handles.end())
+        return iter->second;
     else
         throw ModelicaSimulationError(DATASTORAGE,"There is no such output variable " + name);
 }
 
+const double* SimData::getOutputResults(unsigned int handle, size_t& size)
+{
+    if(handle >= _result_vars.size1())
+        throw ModelicaSimulationError(DATASTORAGE,"There is no output variable for this handle");
+    size = _result_vars.size2();
+    return _result_vars.data().begin() + handle * size;
+}
+
 extern "C" ISimData* createSimDataAnalyzation()
 {
   return new SimData();
@@ -0,0 +1,159 @@
+/** @addtogroup dataexchangeTest
+ *
+ *  @{
+ */
+/*
+ * Test of the column-wise result buffer of BufferReaderWriter.
+ *
+ * NUM_ROWS rows are written, every seventh time step twice with different
+ * values, to a buffer that expects far fewer rows, so that the columns are
+ * doubled several times. This is done
+ *  - in memory, without a memory limit,
+ *  - with a memory limit that the second doubling exceeds, which moves the
+ *    columns into the mapping file and moves them within the file on the
+ *    next doublings.
+ * The test fails if read(R), getOutputSeries or getTime do not return the
+ * last values written for every time step, if the mapping file is not used
+ * above the memory limit or if it is left behind by eraseAll.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/DataExchange/Writer.h>
+#include <Core/DataExchange/Policies/BufferReaderWriter.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#define NUM_REALS 5
+#define NUM_INTS 2
+#define NUM_BOOLS 2
+#define NUM_OUTPUTS (NUM_REALS + NUM_INTS + NUM_BOOLS)
+#define NUM_ROWS 300
+/* the buffer starts with BUFFER_MIN_CAPACITY rows */
+#define EXPECTED_ROWS 50
+
+/** value of output i at row, the time step is written a second time with overwrite set */
+static double expected(int i, int row, bool overwrite)
+{
+  double time = 1e-3 * row;
+  double offset = overwrite ? 100.0 : 0.0;
+  if (i < NUM_REALS)
+    return (i == 3 ? -1.0 : 1.0) * (std::sin((i + 1) * time) + i + offset);
+  if (i < NUM_REALS + NUM_INTS)
+    return row / (i - NUM_REALS + 3) + (overwrite ? 1 : 0);
+  return ((row + i) % 4 == 0) != (i == NUM_OUTPUTS - 1) ? 1.0 : 0.0;
+}
+
+static bool fileExists(const std::string& file_name)
+{
+  return std::ifstream(file_name.c_str()).good();
+}
+
+/** writes NUM_ROWS rows to a buffer with the memory limit and checks what is read back */
+static void checkBuffer(const std::string& file_name, size_t memory_limit, int& errors)
+{
+  double reals[NUM_REALS];
+  int ints[NUM_INTS];
+  bool bools[NUM_BOOLS];
+  all_names_t names, parameter_names;
+  all_description_t descriptions, parameter_descriptions;
+  real_vars_t real_vars;
+  int_vars_t int_vars;
+  bool_vars_t bool_vars;
+  neg_all_vars_t negate;
+  std::string mapping_file = file_name + ".buffer";
+  bool mapped = false;
+
+  for (int i = 0; i < NUM_REALS; i++) {
+    get<0>(names).push_back("x" + std::to_string(i));
+    real_vars.push_back(&reals[i]);
+    get<0>(negate).push_back(i == 3);
+  }
+  for (int i = 0; i < NUM_INTS; i++) {
+    get<1>(names).push_back("n" + std::to_string(i));
+    int_vars.push_back(&ints[i]);
+    get<1>(negate).push_back(false);
+  }
+  for (int i = 0; i < NUM_BOOLS; i++) {
+    get<2>(names).push_back("b" + std::to_string(i));
+    bool_vars.push_back(&bools[i]);
+    get<2>(negate).push_back(i == NUM_BOOLS - 1);
+  }
+
+  BufferReaderWriter buffer(EXPECTED_ROWS, "", file_name, memory_limit);
+  buffer.init("", file_name, NUM_OUTPUTS);
+  buffer.write(names, descriptions, parameter_names, parameter_descriptions);
+  for (int row = 0; row < NUM_ROWS; row++) {
+    double time = 1e-3 * row;
+    for (int pass = 0; pass < (row % 7 == 0 ? 2 : 1); pass++) {
+      double offset = pass ? 100.0 : 0.0;
+      for (int i = 0; i < NUM_REALS; i++)
+        reals[i] = std::sin((i + 1) * time) + i + offset;
+      for (int i = 0; i < NUM_INTS; i++)
+        ints[i] = row / (i + 3) + pass;
+      for (int i = 0; i < NUM_BOOLS; i++)
+        bools[i] = (row + NUM_REALS + NUM_INTS + i) % 4 == 0;
+      buffer.write(make_tuple(real_vars, int_vars, bool_vars, time), negate);
+    }
+    mapped = mapped || fileExists(mapping_file);
+  }
+
+  if (buffer.size() != NUM_ROWS) {
+    std::fprintf(stderr, "%s: %lu rows in the buffer, %d were written\n", file_name.c_str(), buffer.size(), NUM_ROWS);
+    errors++;
+    return;
+  }
+  if (mapped != (memory_limit > 0)) {
+    std::fprintf(stderr, "%s: the buffer was %smapped to a file with the memory limit %lu\n", file_name.c_str(),
+                 mapped ? "" : "not ", (unsigned long)memory_limit);
+    errors++;
+  }
+
+  ublas::matrix<double> R;
+  vector<double> time;
+  buffer.read(R);
+  buffer.getTime(time);
+  if (R.size1() != NUM_OUTPUTS || R.size2() != NUM_ROWS || time.size() != NUM_ROWS) {
+    std::fprintf(stderr, "%s: read returned %lu x %lu values and %lu time steps\n", file_name.c_str(),
+                 (unsigned long)R.size1(), (unsigned long)R.size2(), (unsigned long)time.size());
+    errors++;
+    return;
+  }
+  for (int i = 0; i < NUM_OUTPUTS; i++) {
+    const double* series = buffer.getOutputSeries(i);
+    int wrong = 0;
+    for (int row = 0; row < NUM_ROWS; row++) {
+      double value = expected(i, row, row % 7 == 0);
+      wrong += R(i, row) != value || series[row] != value || time[row] != 1e-3 * row;
+    }
+    if (wrong > 0) {
+      std::fprintf(stderr, "%s: %d wrong values of output %d\n", file_name.c_str(), wrong, i);
+      errors++;
+    }
+  }
+  if (buffer.getOutputHandle("n1") != NUM_REALS + 1) {
+    std::fprintf(stderr, "%s: n1 has the handle %u\n", file_name.c_str(), buffer.getOutputHandle("n1"));
+    errors++;
+  }
+
+  buffer.eraseAll();
+  if (buffer.size() != 0 || fileExists(mapping_file)) {
+    std::fprintf(stderr, "%s: eraseAll left %lu rows or the mapping file\n", file_name.c_str(), buffer.size());
+    errors++;
+  }
+}
+
+int main()
+{
+  int errors = 0;
+  const size_t rowBytes = sizeof(double) * (NUM_OUTPUTS + 1);
+
+  /* 64 -> 128 -> 256 -> 512 rows */
+  checkBuffer("test_buffer_heap", 0, errors);
+  /* the first doubling stays in memory, the second one is mapped */
+  checkBuffer("test_buffer_mapped", 200 * rowBytes, errors);
+  return errors;
+}
+/** @} */ // end of dataexchangeTest
@@ -0,0 +1,160 @@
+/** @addtogroup dataexchangeTest
+ *
+ *  @{
+ */
+/*
+ * Regression test of the block buffer of MatFileWriter.
+ *
+ * The same result rows are written with blocks of
+ *  - one row, which writes and updates the "data_2" header after every row
+ *    like the writer did before the rows were buffered,
+ *  - seven rows, so that the last flush at close writes a partial block,
+ *  - the default block size, which holds all rows.
+ * The test fails if the files are not byte-identical or if the column count
+ * in the "data_2" header of a file is not the number of rows written.
+ * It also fails if, while the writer is open, the header counts more columns
+ * than the rows flushed so far, which is what a crashed run leaves.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/DataExchange/Writer.h>
+#include <Core/DataExchange/Policies/MatfileWriter.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#define NUM_REALS 5
+#define NUM_INTS 2
+#define NUM_BOOLS 2
+#define NUM_ROWS 1000
+
+/** gives access to the file while it is written */
+class TestMatFileWriter : public MatFileWriter
+{
+public:
+  TestMatFileWriter(const std::string& file_name, size_t buffer_size)
+    : MatFileWriter(NUM_ROWS, "", file_name, 0, buffer_size)
+  {
+  }
+
+  /** pushes what was written so far to the file, as the system does when the process dies */
+  void sync()
+  {
+    _output_stream.flush();
+  }
+};
+
+static std::string readFile(const std::string& file_name)
+{
+  std::ifstream file(file_name.c_str(), std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+/** column count in the header of the "data_2" matrix, which is the last one of a file with rows columns */
+static long dataColumns(const std::string& content, int rows)
+{
+  const size_t rowSize = NUM_REALS + NUM_INTS + NUM_BOOLS + 1;
+  const size_t headerSize = 5 * sizeof(unsigned int) + sizeof("data_2");
+  size_t dataSize = sizeof(double) * rowSize * rows;
+  unsigned int header[5];
+
+  if (content.size() < dataSize + headerSize)
+    return -1;
+  size_t headerPos = content.size() - dataSize - headerSize;
+  if (content.compare(headerPos + sizeof(header), sizeof("data_2"), "data_2", sizeof("data_2")) != 0)
+    return -1;
+  std::memcpy(header, content.data() + headerPos, sizeof(header));
+  return header[1] == rowSize ? (long)header[2] : -1;
+}
+
+/** writes NUM_ROWS rows with blocks of buffer_size bytes and returns the content of the file,
+    checks the file after the rows of the first block if a block holds more than one row */
+static std::string writeFile(const std::string& file_name, size_t buffer_size, int& errors)
+{
+  double reals[NUM_REALS];
+  int ints[NUM_INTS];
+  bool bools[NUM_BOOLS];
+  all_names_t names, parameter_names;
+  all_description_t descriptions, parameter_descriptions;
+  real_vars_t real_vars;
+  int_vars_t int_vars;
+  bool_vars_t bool_vars;
+  neg_all_vars_t negate;
+
+  for (int i = 0; i < NUM_REALS; i++) {
+    get<0>(names).push_back("x" + std::to_string(i));
+    get<0>(descriptions).push_back("");
+    real_vars.push_back(&reals[i]);
+    get<0>(negate).push_back(i == 3);
+  }
+  for (int i = 0; i < NUM_INTS; i++) {
+    get<1>(names).push_back("n" + std::to_string(i));
+    get<1>(descriptions).push_back("");
+    int_vars.push_back(&ints[i]);
+    get<1>(negate).push_back(false);
+  }
+  for (int i = 0; i < NUM_BOOLS; i++) {
+    get<2>(names).push_back("b" + std::to_string(i));
+    get<2>(descriptions).push_back("");
+    bool_vars.push_back(&bools[i]);
+    get<2>(negate).push_back(i == 1);
+  }
+
+  {
+    TestMatFileWriter writer(file_name, buffer_size);
+    writer.init("", file_name, NUM_REALS + NUM_INTS + NUM_BOOLS);
+    writer.write(names, descriptions, parameter_names, parameter_descriptions);
+    writer.write(make_tuple(real_vars_t(), int_vars_t(), bool_vars_t()), 0.0, 1.0);
+    for (int row = 0; row < NUM_ROWS; row++) {
+      double time = 1e-3 * row;
+      for (int i = 0; i < NUM_REALS; i++)
+        reals[i] = std::sin((i + 1) * time) + i;
+      for (int i = 0; i < NUM_INTS; i++)
+        ints[i] = row / (i + 3);
+      for (int i = 0; i < NUM_BOOLS; i++)
+        bools[i] = (row + i) % 4 == 0;
+      writer.write(make_tuple(real_vars, int_vars, bool_vars, time), negate);
+      if (row == 2 && buffer_size > 3 * sizeof(double) * (NUM_REALS + NUM_INTS + NUM_BOOLS + 1)) {
+        writer.sync();
+        long columns = dataColumns(readFile(file_name), 0);
+        if (columns != 0) {
+          std::fprintf(stderr, "%s: \"data_2\" has %ld columns before the first block is written\n", file_name.c_str(), columns);
+          errors++;
+        }
+      }
+    }
+  }
+
+  std::string content = readFile(file_name);
+  std::remove(file_name.c_str());
+  return content;
+}
+
+int main()
+{
+  int errors = 0;
+  const size_t rowBytes = sizeof(double) * (NUM_REALS + NUM_INTS + NUM_BOOLS + 1);
+
+  std::string unbuffered = writeFile("test_matfile_writer_row.mat", 1, errors);
+  std::string partial = writeFile("test_matfile_writer_block.mat", 7 * rowBytes, errors);
+  std::string buffered = writeFile("test_matfile_writer_default.mat", MAT_DATA_BUFFER_SIZE, errors);
+
+  if (dataColumns(unbuffered, NUM_ROWS) != NUM_ROWS) {
+    std::fprintf(stderr, "blocks of one row: \"data_2\" has %ld columns, %d rows were written\n", dataColumns(unbuffered, NUM_ROWS), NUM_ROWS);
+    errors++;
+  }
+  if (partial != unbuffered) {
+    std::fprintf(stderr, "blocks of 7 rows: the file differs from the one written row by row\n");
+    errors++;
+  }
+  if (buffered != unbuffered) {
+    std::fprintf(stderr, "default blocks: the file differs from the one written row by row\n");
+    errors++;
+  }
+  return errors;
+}
+/** @} */ // end of dataexchangeTest
@@ -0,0 +1,263 @@
+/** @addtogroup dataexchangeTest
+ *
+ *  @{
+ */
+/*
+ * Benchmark and regression test of the parallel result output.
+ *
+ * A small solver loop integrates a chain of nonlinear oscillators and
+ * queues the output variables after every output step, the way the
+ * generated writeOutput does. The loop runs
+ *  - without any output,
+ *  - with ParallelContainerManager, writing rows to a temporary file,
+ *  - with DefaultContainerManager, writing the same rows directly.
+ * The test fails if a row written by the writer thread differs from the
+ * values the variables had when the row was queued.
+ * It prints the wall times and the CPU time the solver thread spends in
+ * writeOutput, relative to the loop without output. If the writer thread
+ * has a core of its own, the latter is what the output adds to the wall
+ * time of the simulation; on a single core the wall time also contains the
+ * writing itself.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/DataExchange/Writer.h>
+#include <Core/DataExchange/ParallelContainerManager.h>
+#include <Core/DataExchange/DefaultContainerManager.h>
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#define NUM_REALS 200
+#define NUM_INTS 20
+#define NUM_BOOLS 20
+#define NUM_ROWS 5000
+#define SUBSTEPS 50
+
+/** checksum of a row, sensitive to the order of the values */
+static double rowChecksum(const real_vars_t& reals, const int_vars_t& ints, const bool_vars_t& bools, double time)
+{
+  double sum = time;
+  for (size_t i = 0; i < reals.size(); i++)
+    sum = 1.000001 * sum + *reals[i];
+  for (size_t i = 0; i < ints.size(); i++)
+    sum = 1.000001 * sum + *ints[i];
+  for (size_t i = 0; i < bools.size(); i++)
+    sum = 1.000001 * sum + *bools[i];
+  return sum;
+}
+
+/** writes the rows to a file and remembers their checksums */
+template<typename ContainerManager>
+class TestWriter : public ContainerManager
+{
+public:
+  TestWriter() : _file(std::tmpfile())
+  {
+    _checksums.reserve(NUM_ROWS);
+  }
+
+  virtual ~TestWriter()
+  {
+    ContainerManager::finishWriteQueue();
+    std::fclose(_file);
+  }
+
+  virtual void write(const all_vars_time_t& v_list, const neg_all_vars_t& neg_v_list)
+  {
+    const real_vars_t& reals = get<0>(v_list);
+    const int_vars_t& ints = get<1>(v_list);
+    const bool_vars_t& bools = get<2>(v_list);
+    double row[NUM_REALS + NUM_INTS + NUM_BOOLS + 1];
+    size_t n = 0;
+    row[n++] = get<3>(v_list);
+    for (size_t i = 0; i < reals.size(); i++)
+      row[n++] = WriteOutputVar<double>()(reals[i], get<0>(neg_v_list)[i]);
+    for (size_t i = 0; i < ints.size(); i++)
+      row[n++] = WriteOutputVar<int>()(ints[i], get<1>(neg_v_list)[i]);
+    for (size_t i = 0; i < bools.size(); i++)
+      row[n++] = WriteOutputVar<bool>()(bools[i], get<2>(neg_v_list)[i]);
+    std::fwrite(row, sizeof(double), n, _file);
+    _checksums.push_back(rowChecksum(reals, ints, bools, get<3>(v_list)));
+  }
+
+  const std::vector<double>& getChecksums() const { return _checksums; }
+
+private:
+  std::FILE* _file;
+  std::vector<double> _checksums;
+};
+
+/** the variables of the integrated system and the output pointers to them */
+struct TestSystem
+{
+  double x[NUM_REALS];
+  double xHelp[NUM_REALS];
+  int counts[NUM_INTS];
+  bool signs[NUM_BOOLS];
+  double time;
+  output_real_vars_t outputRealVars;
+  output_int_vars_t outputIntVars;
+  output_bool_vars_t outputBoolVars;
+  std::vector<double> checksums;
+
+  TestSystem() : time(0.0)
+  {
+    string name("x"), description("");
+    for (int i = 0; i < NUM_REALS; i++) {
+      x[i] = i % 2 ? 0.0 : 1.0 + 0.01 * i;
+      outputRealVars.addOutputVar(name, description, &x[i], false);
+    }
+    for (int i = 0; i < NUM_INTS; i++) {
+      counts[i] = 0;
+      outputIntVars.addOutputVar(name, description, &counts[i], false);
+    }
+    for (int i = 0; i < NUM_BOOLS; i++) {
+      signs[i] = false;
+      outputBoolVars.addOutputVar(name, description, &signs[i], i % 2 == 1);
+    }
+    checksums.reserve(NUM_ROWS);
+  }
+
+  /** pairs (x[2k], x[2k+1]) are Van der Pol oscillators, weakly coupled to their neighbours */
+  void rhs(const double* y, double* dy)
+  {
+    for (int k = 0; k < NUM_REALS / 2; k++) {
+      double p = y[2*k], v = y[2*k+1];
+      double left = k > 0 ? y[2*k-2] : 0.0, right = k < NUM_REALS / 2 - 1 ? y[2*k+2] : 0.0;
+      dy[2*k] = v;
+      dy[2*k+1] = (1.0 - p * p) * v - p + 0.1 * (left - 2.0 * p + right);
+    }
+  }
+
+  /** explicit midpoint steps up to the next output point */
+  void step(double h)
+  {
+    double k1[NUM_REALS], k2[NUM_REALS];
+    for (int s = 0; s < SUBSTEPS; s++) {
+      rhs(x, k1);
+      for (int i = 0; i < NUM_REALS; i++)
+        xHelp[i] = x[i] + 0.5 * h * k1[i];
+      rhs(xHelp, k2);
+      for (int i = 0; i < NUM_REALS; i++)
+        x[i] += h * k2[i];
+      time += h;
+    }
+    for (int i = 0; i < NUM_INTS; i++)
+      if (x[2*i] > 0.0 && !signs[i])
+        counts[i]++;
+    for (int i = 0; i < NUM_BOOLS; i++)
+      signs[i] = x[2*i] > 0.0;
+  }
+
+  /** as in the generated writeOutput */
+  template<typename ContainerManager>
+  void writeOutput(ContainerManager& writer)
+  {
+    write_data_t& container = writer.getFreeContainer();
+    all_vars_time_t& all_vars = get<0>(container);
+    neg_all_vars_t& neg_all_vars = get<1>(container);
+    get<0>(all_vars) = outputRealVars.outputVars;
+    get<1>(all_vars) = outputIntVars.outputVars;
+    get<2>(all_vars) = outputBoolVars.outputVars;
+    get<3>(all_vars) = time;
+    get<0>(neg_all_vars) = outputRealVars.negateOutputVars;
+    get<1>(neg_all_vars) = outputIntVars.negateOutputVars;
+    get<2>(neg_all_vars) = outputBoolVars.negateOutputVars;
+    writer.addContainerToWriteQueue(container);
+  }
+
+  /** remember the values at output time, also without output to compare the same work */
+  void addChecksum()
+  {
+    checksums.push_back(rowChecksum(outputRealVars.outputVars, outputIntVars.outputVars, outputBoolVars.outputVars, time));
+  }
+};
+
+static double threadCpuTime()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#else
+  return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+struct Timing
+{
+  /** wall time of the loop, including the wait for the writer thread */
+  double wall;
+  /** CPU time of the solver thread in writeOutput */
+  double output;
+};
+
+/** run the solver loop, with output if writer is not NULL */
+template<typename ContainerManager>
+static Timing run(TestWriter<ContainerManager>* writer, TestSystem& system)
+{
+  Timing timing;
+  timing.output = 0.0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int row = 0; row < NUM_ROWS; row++) {
+    system.step(1e-3);
+    system.addChecksum();
+    if (writer) {
+      double outputStart = threadCpuTime();
+      system.writeOutput(*writer);
+      timing.output += threadCpuTime() - outputStart;
+    }
+  }
+  if (writer)
+    writer->finishWriteQueue();
+  timing.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return timing;
+}
+
+template<typename ContainerManager>
+static int checkRows(const TestWriter<ContainerManager>& writer, const TestSystem& system, const char* name)
+{
+  const std::vector<double>& written = writer.getChecksums();
+  if (written.size() != system.checksums.size()) {
+    std::fprintf(stderr, "%s: %d rows queued, %d written\n", name, (int)system.checksums.size(), (int)written.size());
+    return 1;
+  }
+  for (size_t row = 0; row < written.size(); row++) {
+    if (written[row] != system.checksums[row]) {
+      std::fprintf(stderr, "%s: row %d differs from the values at output time\n", name, (int)row);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main()
+{
+  int errors = 0;
+
+  TestSystem noOutputSystem;
+  Timing noOutput = run<DefaultContainerManager>(NULL, noOutputSystem);
+
+  TestSystem parallelSystem;
+  TestWriter<ParallelContainerManager>* parallelWriter = new TestWriter<ParallelContainerManager>();
+  Timing parallel = run(parallelWriter, parallelSystem);
+  errors += checkRows(*parallelWriter, parallelSystem, "ParallelContainerManager");
+  delete parallelWriter;
+
+  TestSystem serialSystem;
+  TestWriter<DefaultContainerManager>* serialWriter = new TestWriter<DefaultContainerManager>();
+  Timing serial = run(serialWriter, serialSystem);
+  errors += checkRows(*serialWriter, serialSystem, "DefaultContainerManager");
+  delete serialWriter;
+
+  std::printf("%d rows of %d values, no output: wall %.3f s\n", NUM_ROWS, NUM_REALS + NUM_INTS + NUM_BOOLS + 1, noOutput.wall);
+  std::printf("parallel output: wall %+.1f%%, solver thread in writeOutput %.1f%%\n",
+              100.0 * (parallel.wall / noOutput.wall - 1.0), 100.0 * parallel.output / noOutput.wall);
+  std::printf("serial output:   wall %+.1f%%, solver thread in writeOutput %.1f%%\n",
+              100.0 * (serial.wall / noOutput.wall - 1.0), 100.0 * serial.output / noOutput.wall);
+  return errors;
+}
+/** @} */ // end of dataexchangeTest
@@ -1,12 +1,38 @@
 #include <Core/ModelicaDefine.h>
  #include <Core/Modelica.h>
-#include <Core/Math/matrix_t.h>
+#include <Core/Math/SparseMatrix.h>
 #ifdef USE_UMFPACK
 #include "umfpack.h"
 #endif
 
+sparse_matrix::~sparse_matrix() {
+    detach();
+    freeFactorization();
+}
+
+/* hands the current values back to the inserter, which assembles into its map again */
+void sparse_matrix::detach() {
+    if(_inserter) {
+        //the map holds exactly the frozen pattern in column major order
+        std::vector<double>::const_iterator value=Ax.begin();
+        for(map< pair<int,int>, double>::iterator it=_inserter->content.begin(); it!=_inserter->content.end(); it++)
+            it->second=*value++;
+        _inserter->matrix=NULL;
+        _inserter->order.clear();
+        _inserter=NULL;
+    }
+}
+
 #ifdef USE_UMFPACK
 void sparse_matrix::build(sparse_inserter& ins) {
+        //the values were written into the frozen pattern
+        if(_inserter==&ins) {
+            ins.cursor=0;
+            return;
+        }
+        if(ins.matrix)
+            ins.matrix->detach();
+        detach();
         if(n==-1) {
             n=ins.content.rbegin()->first.first+1;
         } else {
@@ -19,32 +45,68 @@ void sparse_matrix::build(sparse_inserter& ins) {
         Ai.resize(n);
         Ax.resize(n);
         unsigned int j=0;
-        int rowold=1;
         for(map< pair<int,int>, double>::iterator it=ins.content.begin(); it!=ins.content.end(); it++) {
-            if(it->first.first+1==rowold) {
-                ++Ap[rowold];
-            } else {
-                Ap[it->first.first+1]=Ap[rowold]+1;
-                rowold=it->first.first+1;
-            }
+            ++Ap[it->first.first+1];
             Ai[j]=it->first.second;
             Ax[j]=it->second;
             ++j;
         }
+        for(int col=0; col<this->n; col++)
+            Ap[col+1]+=Ap[col];
+
+        //precompute the slots in the order the entries were written
+        _slots.clear();
+        _positions.assign(n,-1);
+        size_t cursor=0;
+        for(std::vector<pair<int,int> >::iterator it=ins.order.begin(); it!=ins.order.end(); it++) {
+            int k=slot(it->first,it->second,cursor);
+            _positions[k]=_slots.size();
+            _slots.push_back(k);
+        }
+        ins.order.clear();
+        ins.matrix=this;
+        ins.cursor=0;
+        _inserter=&ins;
+
+        //a new pattern needs a new symbolic analysis
+        freeFactorization();
     }
 
 int sparse_matrix::solve(const double* b, double * x) {
     int status, sys=0;
     double Control [UMFPACK_CONTROL], Info [UMFPACK_INFO] ;
-    void *Symbolic, *Numeric ;
     umfpack_di_defaults (Control) ;
-    status = umfpack_di_symbolic (sparse_matrix::n, sparse_matrix::n, &sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], &Symbolic, Control, Info) ;
-    status = umfpack_di_numeric (&sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], Symbolic, &Numeric, Control, Info);
-    status = umfpack_di_solve (sys, &sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], x, b, Numeric, Control, Info);
-    umfpack_di_free_symbolic (&Symbolic);
-    umfpack_di_free_numeric (&Numeric);
+    //the symbolic analysis only depends on the pattern and is kept until it changes
+    if(!_symbolic) {
+        status = umfpack_di_symbolic (sparse_matrix::n, sparse_matrix::n, &sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], &_symbolic, Control, Info) ;
+        if(status!=UMFPACK_OK) {
+            freeFactorization();
+            return status;
+        }
+    }
+    //umfpack can't refactor in place, the numeric factorization is redone with the kept symbolic one
+    if(_refactor && _numeric)
+        umfpack_di_free_numeric (&_numeric);
+    if(!_numeric) {
+        status = umfpack_di_numeric (&sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], _symbolic, &_numeric, Control, Info);
+        if(status<UMFPACK_OK) {
+            umfpack_di_free_numeric (&_numeric);
+            return status;
+        }
+        _refactor=false;
+    }
+    status = umfpack_di_solve (sys, &sparse_matrix::Ap[0], &sparse_matrix::Ai[0], &sparse_matrix::Ax[0], x, b, _numeric, Control, Info);
     return status;
 }
+
+void sparse_matrix::freeFactorization() {
+    if(_symbolic)
+        umfpack_di_free_symbolic (&_symbolic);
+    if(_numeric)
+        umfpack_di_free_numeric (&_numeric);
+    _symbolic=NULL;
+    _numeric=NULL;
+}
 #else
 void sparse_matrix::build(sparse_inserter& ins) {
         throw ModelicaSimulationError(MATH_FUNCTION,"no umfpack");
@@ -54,4 +116,7 @@ int sparse_matrix::solve(const double* b, double * x) {
         throw ModelicaSimulationError(MATH_FUNCTION,"no umfpack");
 }
 
+void sparse_matrix::freeFactorization() {
+}
+
 #endif
@@ -0,0 +1,125 @@
+/** @addtogroup mathTest
+ *
+ *  @{
+ */
+/*
+ * Assembles a tridiagonal matrix through one sparse_inserter into one
+ * sparse_matrix several times and solves it after every assembly:
+ *  - twice in the order of the first assembly,
+ *  - once in reverse order,
+ *  - once with a new entry in the corner, which detaches the inserter from
+ *    the frozen pattern in the middle of the assembly,
+ *  - twice more with the new pattern, in order and in reverse order.
+ * The values change with every assembly.
+ * The test fails if a solution differs from the one of a sparse_matrix that
+ * is built from scratch with the same values, or if it does not solve the
+ * system, or if the symbolic analysis of UMFPACK is redone although the
+ * pattern did not change or is kept although it did.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+#include <Core/Math/SparseMatrix.h>
+#include "umfpack.h"
+
+#include <cmath>
+#include <cstdio>
+
+#define N 6
+
+static int symbolicAnalyses = 0;
+
+extern "C" int __real_umfpack_di_symbolic(int n_row, int n_col, const int Ap[], const int Ai[], const double Ax[],
+                                          void** Symbolic, const double Control[], double Info[]);
+
+/** counts the symbolic analyses, the test is linked with --wrap=umfpack_di_symbolic */
+extern "C" int __wrap_umfpack_di_symbolic(int n_row, int n_col, const int Ap[], const int Ai[], const double Ax[],
+                                          void** Symbolic, const double Control[], double Info[])
+{
+  symbolicAnalyses++;
+  return __real_umfpack_di_symbolic(n_row, n_col, Ap, Ai, Ax, Symbolic, Control, Info);
+}
+
+/** entry (i,j) of the matrix of an assembly, 0 outside of its pattern */
+static double value(int i, int j, int version, bool corner)
+{
+  if (i == j)
+    return 4.0 + 0.5 * version + i;
+  if (i == j + 1 || j == i + 1)
+    return -1.0 - 0.1 * version * (i + 1);
+  if (corner && i == 0 && j == N - 1)
+    return 0.5 + 0.1 * version;
+  return 0.0;
+}
+
+/** writes the entries row by row, the corner last in row 0 or first in reverse order */
+static void assemble(sparse_inserter& ins, int version, bool reverse, bool corner)
+{
+  for (int k = 0; k < N; k++) {
+    int i = reverse ? N - 1 - k : k;
+    for (int l = 0; l < 4; l++) {
+      int j = i - 1 + (reverse ? 3 - l : l);
+      if (j == i + 2)
+        j = corner && i == 0 ? N - 1 : -1;
+      if (j >= 0 && j < N)
+        ins[i][j] = value(i, j, version, corner);
+    }
+  }
+}
+
+/** assembles into matrix, solves and checks the solution and the number of symbolic analyses */
+static void step(sparse_matrix& matrix, sparse_inserter& ins, int version, bool reverse, bool corner,
+                 int expectedAnalyses, int& errors)
+{
+  double b[N], x[N], reference[N];
+  for (int i = 0; i < N; i++)
+    b[i] = 1.0 + i;
+
+  assemble(ins, version, reverse, corner);
+  matrix.build(ins);
+  int analyses = symbolicAnalyses;
+  if (matrix.solve(b, x) != UMFPACK_OK) {
+    std::fprintf(stderr, "assembly %d: solve failed\n", version);
+    errors++;
+    return;
+  }
+  analyses = symbolicAnalyses - analyses;
+  if (analyses != expectedAnalyses) {
+    std::fprintf(stderr, "assembly %d: %d symbolic analyses, expected %d\n", version, analyses, expectedAnalyses);
+    errors++;
+  }
+
+  {
+    sparse_inserter freshIns;
+    sparse_matrix fresh;
+    assemble(freshIns, version, false, corner);
+    fresh.build(freshIns);
+    fresh.solve(b, reference);
+  }
+  for (int i = 0; i < N; i++) {
+    double residual = -b[i];
+    for (int j = 0; j < N; j++)
+      residual += value(i, j, version, corner) * x[j];
+    if (x[i] != reference[i] || std::fabs(residual) > 1e-12) {
+      std::fprintf(stderr, "assembly %d: x[%d] = %.17g, a new matrix gives %.17g, residual %g\n", version, i, x[i],
+                   reference[i], residual);
+      errors++;
+    }
+  }
+}
+
+int main()
+{
+  int errors = 0;
+  sparse_inserter ins;
+  sparse_matrix matrix;
+
+  step(matrix, ins, 0, false, false, 1, errors);
+  step(matrix, ins, 1, false, false, 0, errors);
+  step(matrix, ins, 2, true, false, 0, errors);
+  step(matrix, ins, 3, false, true, 1, errors);
+  step(matrix, ins, 4, false, true, 0, errors);
+  step(matrix, ins, 5, true, true, 0, errors);
+  return errors;
+}
+/** @} */ // end of mathTest
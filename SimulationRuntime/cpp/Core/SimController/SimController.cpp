@@ -188,6 +188,7 @@ void SimController::Start(SimSettings simsettings, string modelKey)
         global_settings->setOutputFormat(simsettings.outputFomrat);
         global_settings->setNonLinearSolverContinueOnError(simsettings.nonLinearSolverContinueOnError);
         global_settings->setSolverThreads(simsettings.solverThreads);
+        global_settings->setHistoryMemoryLimit(simsettings.historyMemoryLimit);
         /*shared_ptr<SimManager>*/ _simMgr = shared_ptr<SimManager>(new SimManager(mixedsystem, _config.get()));
 
         ISolverSettings* solver_settings = _config->getSolverSettings();
@@ -232,15 +233,8 @@ void SimController::Start(SimSettings simsettings, string modelKey)
 			history->getOutputResults(Ro);
 			vector<string> output_names;
 			history->getOutputNames(output_names);
-			int j=0;
-
-			FOREACH(string& name, output_names)
-			{
-				ublas::vector<double> o_j;
-				o_j = ublas::row(Ro,j);
-				simData->addOutputResults(name,o_j);
-				j++;
-			}
+			//the results are handed over as a whole, each output row stays contiguous
+			simData->addOutputResults(output_names,Ro);
 
 			vector<double> time_values = history->getTimeEntries();
 			simData->addTimeEntries(time_values);
@@ -23,6 +23,7 @@ GlobalSettings::GlobalSettings()
   , _outputPointType(OPT_ALL)
   , _alarm_time(0)
   ,_outputFormat(MAT)
+  ,_historyMemoryLimit(0)
 {
 }
 
@@ -220,4 +221,14 @@ int GlobalSettings::getSolverThreads()
   {
       _outputFormat = outputFormat;
   }
+
+void GlobalSettings::setHistoryMemoryLimit(unsigned int limit)
+{
+  _historyMemoryLimit = limit;
+}
+
+unsigned int GlobalSettings::getHistoryMemoryLimit()
+{
+  return _historyMemoryLimit;
+}
 /** @} */ // end of coreSimulationSettings
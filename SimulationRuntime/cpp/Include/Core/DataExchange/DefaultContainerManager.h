@@ -35,6 +35,13 @@ class DefaultContainerManager : public Writer
     virtual ~DefaultContainerManager()
     {
     }
+
+    /**
+     * Containers are written directly, so there is nothing to wait for.
+     */
+    void finishWriteQueue()
+    {
+    }
     /**
      * Get the internal container. It is always the same.
      * @return A reference to the internal container that can be filled with values.
@@ -20,7 +20,8 @@ class HistoryImpl : public IHistory,
 {
 public:
   HistoryImpl(IGlobalSettings& globalSettings,size_t dim)
-    : ResultsPolicy((globalSettings.getEndTime()-globalSettings.getStartTime())/globalSettings.gethOutput(),globalSettings.getOutputPath(),globalSettings.getResultsFileName())
+    : ResultsPolicy((globalSettings.getEndTime()-globalSettings.getStartTime())/globalSettings.gethOutput(),globalSettings.getOutputPath(),globalSettings.getResultsFileName(),
+                    (size_t)globalSettings.getHistoryMemoryLimit() * 1024 * 1024)
     , _globalSettings(globalSettings)
     , _dim(dim)
   {
@@ -7,95 +7,204 @@
 #include <Core/Modelica.h>
 #include <Core/ModelicaDefine.h>
 
-#define CONTAINER_COUNT 3
+#define CONTAINER_COUNT 64
+/** a sleeping writer thread is only woken once this many containers are waiting, to keep wakeups rare */
+#define CONTAINER_WAKEUP_COUNT (CONTAINER_COUNT / 2)
 
 /**
  * This container manager is designed to write simulation results in parallel. It has multiple data containers that
- * can be filled with values. The write routine works asynchronously with the help of a consumer-producer-queue.
+ * can be filled with values. The write routine works asynchronously with the help of a bounded single-producer
+ * single-consumer ring of preallocated containers: the solver thread fills the container at the head, the writer
+ * thread writes the one at the tail. Both indices are atomics, so neither thread takes a lock while the ring is
+ * neither full nor empty. A thread that finds the ring full (solver) or empty (writer) blocks on a condition
+ * variable and is woken by the other side, instead of polling. The writer is only woken once a batch of containers
+ * is waiting, so the solver thread does not pay for a wakeup on every output step.
+ * Because a queued container is written later, its values are copied into storage owned by its ring slot when it
+ * is queued, and the slot's pointers are redirected to these copies.
  */
 class ParallelContainerManager : public Writer
 {
   private:
-    deque<write_data_t > _writeContainers;
-    deque<write_data_t > _freeContainers;
-    semaphore _freeContainerMutex;
-    semaphore _writeContainerMutex;
-    semaphore _nempty;
+    write_data_t _containers[CONTAINER_COUNT];
+    /** copies of the real, integer and boolean output values of the containers */
+    boost::container::vector<double> _realValues[CONTAINER_COUNT];
+    boost::container::vector<int> _intValues[CONTAINER_COUNT];
+    boost::container::vector<bool> _boolValues[CONTAINER_COUNT];
+    /** number of containers handed to the writer, only modified by the solver thread */
+    atomic<unsigned long> _head;
+    /** number of containers written, only modified by the writer thread */
+    atomic<unsigned long> _tail;
+    atomic<bool> _producerWaiting;
+    atomic<bool> _consumerWaiting;
+    atomic<bool> _threadWorkDone;
+    mutex _waitMutex;
+    condition_variable _notFull;
+    condition_variable _notEmpty;
     thread _writerThread;
-    bool _threadWorkDone;
 
   protected:
     void writeThread()
     {
       std::cerr << "Parallel writer thread used" << std::endl;
-      while(!_threadWorkDone)
+      while(waitForContainer())
         writeContainer();
+    }
 
-      while(!_writeContainers.empty())
-        writeContainer();
+    /**
+     * Block until there is a container to write. If the ring is empty, wait until CONTAINER_WAKEUP_COUNT
+     * containers are filled or the manager is shutting down.
+     * @return False if the ring is empty and the manager is shutting down.
+     */
+    bool waitForContainer()
+    {
+      unsigned long tail = _tail.load(memory_order_relaxed);
+      if (_head.load(memory_order_acquire) != tail)
+        return true;
+
+      unique_lock<mutex> lock(_waitMutex);
+      _consumerWaiting.store(true);
+      while (_head.load() - tail < CONTAINER_WAKEUP_COUNT && !_threadWorkDone.load())
+        _notEmpty.wait(lock);
+      _consumerWaiting.store(false);
+      return _head.load(memory_order_acquire) != tail;
     }
 
+    /**
+     * Write the container at the tail of the ring and hand it back to the solver thread.
+     */
     void writeContainer()
     {
-      const write_data_t* container;
-
-      _writeContainerMutex.wait();
-      if (!_writeContainers.empty())
-        container = &_writeContainers.front();
+      unsigned long tail = _tail.load(memory_order_relaxed);
+      const write_data_t& container = _containers[tail % CONTAINER_COUNT];
 
-      _writeContainerMutex.post();
+      write(get<0>(container),get<1>(container));
 
-      if (!container)
+      _tail.store(tail + 1);
+      if (_producerWaiting.load())
       {
-        usleep(5);
-        return;
+        unique_lock<mutex> lock(_waitMutex);
+        _notFull.notify_one();
       }
+    }
 
-      write(get<0>(*container),get<1>(*container));
-
-      _writeContainerMutex.wait();
-      _writeContainers.pop_front();
-      _writeContainerMutex.post();
+    /**
+     * Copy the values the pointers in vars refer to into values and let the pointers of the slot refer to the copies.
+     * The slot pointers may be the same container as vars.
+     */
+    template<typename T>
+    static void copyValues(const boost::container::vector<const T*>& vars, boost::container::vector<T>& values,
+                           boost::container::vector<const T*>& slotVars)
+    {
+      size_t size = vars.size();
+      values.resize(size);
+      for (size_t i = 0; i < size; i++)
+        values[i] = *vars[i];
+      slotVars.resize(size);
+      for (size_t i = 0; i < size; i++)
+        slotVars[i] = &values[i];
+    }
 
-      _freeContainerMutex.wait();
-      _freeContainers.push_back(*container);
-      _freeContainerMutex.post();
-      _nempty.post();
+    /**
+     * Allocate the value storage of all slots with the sizes of the first queued container, so that later rows
+     * do not allocate.
+     */
+    void allocateValues(const write_data_t& container)
+    {
+      const all_vars_time_t& vars = get<0>(container);
+      for (int i = 0; i < CONTAINER_COUNT; i++)
+      {
+        _realValues[i].reserve(get<0>(vars).size());
+        _intValues[i].reserve(get<1>(vars).size());
+        _boolValues[i].reserve(get<2>(vars).size());
+        get<0>(get<0>(_containers[i])).reserve(get<0>(vars).size());
+        get<1>(get<0>(_containers[i])).reserve(get<1>(vars).size());
+        get<2>(get<0>(_containers[i])).reserve(get<2>(vars).size());
+      }
     }
 
   public:
     ParallelContainerManager() : Writer()
-      , _writeContainers()
-      ,_freeContainers()
-      ,_freeContainerMutex(1)
-      ,_writeContainerMutex(1)
-      ,_nempty(CONTAINER_COUNT)
-      ,_writerThread(&ParallelContainerManager::writeThread, this)
+      ,_head(0)
+      ,_tail(0)
+      ,_producerWaiting(false)
+      ,_consumerWaiting(false)
       ,_threadWorkDone(false)
+      ,_waitMutex()
+      ,_notFull()
+      ,_notEmpty()
+      ,_writerThread(&ParallelContainerManager::writeThread, this)
     {
     }
 
     virtual ~ParallelContainerManager()
     {
-      _threadWorkDone = true;
+      finishWriteQueue();
+    }
+
+    /**
+     * Write all queued containers and stop the writer thread. The writer thread calls the virtual write method,
+     * so derived writers have to call this before they release their output resources.
+     */
+    void finishWriteQueue()
+    {
+      if (!_writerThread.joinable())
+        return;
+      {
+        unique_lock<mutex> lock(_waitMutex);
+        _threadWorkDone.store(true);
+        _notEmpty.notify_one();
+      }
       _writerThread.join();
     }
 
+    /**
+     * Get the container at the head of the ring, blocks while all containers are waiting to be written.
+     * @return A reference to a container that can be filled with values.
+     */
     virtual write_data_t& getFreeContainer()
     {
-      _nempty.wait();
-      _freeContainerMutex.wait();
-
-       write_data_t& container = _freeContainers.front();
-      _freeContainers.pop_front();
-      _freeContainerMutex.post();
-
-      return container;
-  };
+      unsigned long head = _head.load(memory_order_relaxed);
+      if (head - _tail.load(memory_order_acquire) >= CONTAINER_COUNT)
+      {
+        unique_lock<mutex> lock(_waitMutex);
+        _producerWaiting.store(true);
+        while (head - _tail.load() >= CONTAINER_COUNT)
+          _notFull.wait(lock);
+        _producerWaiting.store(false);
+      }
+      return _containers[head % CONTAINER_COUNT];
+    }
 
-  virtual void addContainerToWriteQueue(const write_data_t& container)
-  {
-    _writeContainers.push_back(container);
-  };
+    /**
+     * Pass the container at the head of the ring to the writer thread. The current values of the given container's
+     * variables are copied into the slot, reusing the slot's storage, so later changes of the variables do not
+     * alter the queued row.
+     * @param container The container that should be written.
+     */
+    virtual void addContainerToWriteQueue(const write_data_t& container)
+    {
+      write_data_t& slot = getFreeContainer();
+      unsigned long head = _head.load(memory_order_relaxed);
+      unsigned long index = head % CONTAINER_COUNT;
+      if (head == 0)
+        allocateValues(container);
+
+      const all_vars_time_t& vars = get<0>(container);
+      all_vars_time_t& slotVars = get<0>(slot);
+      copyValues(get<0>(vars), _realValues[index], get<0>(slotVars));
+      copyValues(get<1>(vars), _intValues[index], get<1>(slotVars));
+      copyValues(get<2>(vars), _boolValues[index], get<2>(slotVars));
+      get<3>(slotVars) = get<3>(vars);
+      if (&slot != &container)
+        get<1>(slot) = get<1>(container);
+
+      head++;
+      _head.store(head);
+      if (_consumerWaiting.load() && head - _tail.load(memory_order_relaxed) >= CONTAINER_WAKEUP_COUNT)
+      {
+        unique_lock<mutex> lock(_waitMutex);
+        _notEmpty.notify_one();
+      }
+    }
 };
 /** @} */ // end of dataexchange
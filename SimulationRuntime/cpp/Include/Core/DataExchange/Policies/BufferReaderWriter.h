@@ -5,31 +5,53 @@
  */
 #include "TextfileWriter.h"
 
-#include <boost/circular_buffer.hpp>
-
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(__TRICORE__) && !defined(__vxworks)
+#define USE_BUFFER_FILE_MAPPING
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#endif
+
+/*minimal number of time steps the buffer columns are allocated for*/
+#define BUFFER_MIN_CAPACITY 64
+/*upper bound in bytes for the first allocation, the buffer grows on demand*/
+#define BUFFER_INITIAL_SIZE (16*1024*1024)
+
+/**
+ Policy class to store simulation results in memory.
+ The results are stored column by column in one contiguous block: the time column is followed by
+ one column for each real, int and bool output variable, all converted to double. Every column has
+ room for _capacity time steps, the capacity is doubled when the block is full. If the block would
+ exceed the memory limit, it is moved to a memory mapped file next to the results file.
+*/
 class BufferReaderWriter : public ContainerManager
 {
-    //typedef TextFileWriter<dim_1,dim_2> TextwriterType;
 public:
-    BufferReaderWriter(unsigned long size, string output_path, string file_name)
+    BufferReaderWriter(unsigned long size, string output_path, string file_name, size_t memory_limit)
         : ContainerManager(),
-            _buffer_pos(0)
+          _data(NULL),
+          _columns(0),
+          _rows(0),
+          _capacity(0),
+          _expected_rows(size + size/10),
+          _memory_limit(memory_limit),
+          _mapped(false),
+          _mapping_file(output_path + file_name + ".buffer")
     {
-        try
-        {
-            _real_variables_buffer.set_capacity(size+size/10);
-            _bool_variables_buffer.set_capacity(size+size/10);
-            _int_variables_buffer.set_capacity(size+size/10);
-            /*ToDo: use correct size for corresponding type*/
-        }
-        catch(std::exception& ex)
-        {
-           throw ModelicaSimulationError(DATASTORAGE,string("allocating   buffers failed")+ex.what());
-        }
+    }
+
+    ~BufferReaderWriter()
+    {
+        finishWriteQueue();
+        releaseBuffer();
     }
 
     void init(/*string output_path,string file_name*/std::string output_path, std::string file_name, size_t dim)
     {
+        releaseBuffer();
+        _mapping_file = output_path + file_name + ".buffer";
     }
     /**
     Reads all Simulation results (algebraic and state variables in R, derivatives in dR)
@@ -83,43 +105,27 @@ public:
 
     }
 
+    /**
+    Reads all output variables results, R(i,j) is the value of output variable i at time index j
+    */
     void read(ublas::matrix<double>& R)
     {
-
-        ublas::matrix<double>::size_type m = size();
-        ublas::matrix<double>::size_type n = _var_outputs.size();/*get<0>(_var_outputs).size() + get<1>(_var_outputs).size() + get<2>(_var_outputs).size()*/;
-        ublas::matrix<double>::size_type i,i2=0,j;
+        ublas::matrix<double>::size_type m = _rows;
+        ublas::matrix<double>::size_type n = _var_outputs.size();
         try
         {
-
-
-            R.resize(n,m);
+            R.resize(n,m,false);
         }
         catch(std::exception& ex)
         {
-           // cout<<"read  from variables buffer faild alloc R with sizes "<<m <<"," << n << std::endl;
             throw ModelicaSimulationError(DATASTORAGE,string("read  from variables buffer failed alloc R matrix")+ex.what());
-
-        }
-         try
-        {
-            /*FOREACH(i,indices)*/
-            for(i=0;i<n;i++)
-            {
-                for(j=0;j<m;++j)
-                    R(i2,j)= *(_real_variables_buffer[j][i]);
-                    /*ToDo: add int and bool variables*/
-                i2++;
-            }
         }
-        catch(std::exception& ex)
+        //every column of the buffer is one contiguous row of R
+        for(ublas::matrix<double>::size_type i = 0; i < n && m > 0; i++)
         {
-
-          throw ModelicaSimulationError(DATASTORAGE,string("read  from variables buffer failed")+ex.what());
-
+            const double* series = getOutputSeries(i);
+            std::copy(series, series + m, ublas::row(R,i).begin());
         }
-
-
     }
 
     void read(const double& time,ublas::vector<double>& dv,ublas::vector<double>& v)
@@ -174,110 +180,198 @@ public:
      */
     virtual void write(const all_names_t& s_list,const all_description_t& s_desc_list,const all_names_t& s_parameter_list,const all_description_t& s_desc_parameter_list)
     {
-        //_var_outputs = s_list;
-		_var_outputs.clear();
-        for (var_names_t::const_iterator it = get<0>(s_list).begin(); it != get<0>(s_list).end(); ++it)
-        {
-            _var_outputs.push_back(*it);
-        }
+        _var_outputs.clear();
+        _var_outputs.insert(_var_outputs.end(), get<0>(s_list).begin(), get<0>(s_list).end());
+        _var_outputs.insert(_var_outputs.end(), get<1>(s_list).begin(), get<1>(s_list).end());
+        _var_outputs.insert(_var_outputs.end(), get<2>(s_list).begin(), get<2>(s_list).end());
+        //the column layout changes, results of a previous run are dropped
+        releaseBuffer();
+        _columns = _var_outputs.size() + 1;
     }
 
      /*
      writes simulation results for a time step
      @v_list variables and state vars
-     @v2_list derivatives vars
+     @neg_v_list flags for negated alias variables
      @time
      */
     virtual void write(const all_vars_time_t& v_list,const neg_all_vars_t& neg_v_list)
     {
+        size_t columns = get<0>(v_list).size() + get<1>(v_list).size() + get<2>(v_list).size() + 1;
+        double time = get<3>(v_list);
+        size_t row;
 
-
-        try
+        if (_columns != columns)
         {
-            std::pair<std::map<double, unsigned long>::iterator,bool> p;
-            p = _time_entries.insert(make_pair(get<3>(v_list),_buffer_pos));
-            if(!p.second)//if variable and derivatives for time are already inserted, erase old values
-            {
-                _real_variables_buffer.pop_back();
-                _int_variables_buffer.pop_back();
-                _bool_variables_buffer.pop_back();
-            }
-            else
-            {
-                _buffer_pos++;
-            }
-
-
-            _real_variables_buffer.push_back(get<0>(v_list));
-            _int_variables_buffer.push_back(get<1>(v_list));
-            _bool_variables_buffer.push_back(get<2>(v_list));
+            if (_rows > 0)
+                throw ModelicaSimulationError(DATASTORAGE,"write to buffer failed, number of variables changed");
+            releaseBuffer();
+            _columns = columns;
         }
-        catch(std::exception& ex)
+
+        //if variables for time are already inserted, overwrite old values
+        if (_rows > 0 && _data[_rows - 1] == time)
+            row = _rows - 1;
+        else
         {
+            if (_rows == _capacity)
+                reserve(_capacity > 0 ? 2 * _capacity : initialCapacity());
+            row = _rows++;
+        }
 
-            throw ModelicaSimulationError(DATASTORAGE,string("write to buffer failed")+ex.what());
+        double* value = _data + row;
+        *value = time;
+        value += _capacity;
+        value = writeColumns(get<0>(v_list), get<0>(neg_v_list), value, WriteOutputVar<double>());
+        value = writeColumns(get<1>(v_list), get<1>(neg_v_list), value, WriteOutputVar<int>());
+        writeColumns(get<2>(v_list), get<2>(neg_v_list), value, WriteOutputVar<bool>());
+    }
 
-        }
+    /**
+    Returns the handle of an output variable, that is the index of its results in read(R)
+    */
+    unsigned int getOutputHandle(const string& name) const
+    {
+        vector<string>::const_iterator iter = std::find(_var_outputs.begin(), _var_outputs.end(), name);
+        if (iter == _var_outputs.end())
+            throw ModelicaSimulationError(DATASTORAGE,"There is no such output variable " + name);
+        return iter - _var_outputs.begin();
+    }
 
-        // textwriter->write(v,v2, time);
+    /**
+    Returns the size() values of an output variable without copying them,
+    the pointer is valid until the next write or eraseAll
+    */
+    const double* getOutputSeries(unsigned int handle) const
+    {
+        return _data + (handle + 1) * _capacity;
     }
 
+    /**
+    Returns the size() time entries without copying them,
+    the pointer is valid until the next write or eraseAll
+    */
+    const double* getTimeSeries() const
+    {
+        return _data;
+    }
 
     void getTime(vector<double>& time)
     {
-        try
-        {
-            typedef std::pair<double, unsigned long> pair_double_ulong;
-            FOREACH(pair_double_ulong i, _time_entries)
-            {
-                time.push_back(i.first);
-            }
-        }
-        catch(std::exception& ex)
-        {
+        time.insert(time.end(), _data, _data + _rows);
+    }
+    unsigned long size()
+    {
+        return _rows;
+    }
+    void eraseAll()
+    {
+        releaseBuffer();
+    }
+
 
-            throw ModelicaSimulationError(DATASTORAGE,string("read from time buffer failed")+ex.what());
+protected:
+    template<typename T>
+    double* writeColumns(const boost::container::vector<const T*>& vars, const negate_values_t& negate, double* value, WriteOutputVar<T> output_var)
+    {
+        for (size_t i = 0; i < vars.size(); i++, value += _capacity)
+            *value = output_var(vars[i], negate[i]);
+        return value;
+    }
+
+    size_t initialCapacity() const
+    {
+        size_t capacity = min(_expected_rows, (size_t) (BUFFER_INITIAL_SIZE / (sizeof(double) * _columns)));
+        return max(capacity, (size_t) BUFFER_MIN_CAPACITY);
+    }
 
+    /**
+    Enlarges every column to capacity time steps, columns are moved in place starting with the last one
+    */
+    void reserve(size_t capacity)
+    {
+        size_t bytes = capacity * _columns * sizeof(double);
+#ifdef USE_BUFFER_FILE_MAPPING
+        if (_mapped || (_memory_limit > 0 && bytes > _memory_limit))
+            mapBuffer(bytes);
+        else
+#endif
+        {
+            double* data = (double*) std::realloc(_data, bytes);
+            if (!data)
+                throw ModelicaSimulationError(DATASTORAGE,"allocating buffer failed");
+            _data = data;
         }
+        for (size_t column = _columns - 1; column > 0 && _rows > 0; column--)
+            std::memmove(_data + column * capacity, _data + column * _capacity, _rows * sizeof(double));
+        _capacity = capacity;
     }
-    unsigned long size()
+
+#ifdef USE_BUFFER_FILE_MAPPING
+    /**
+    Resizes the mapping file to bytes and maps it, a heap buffer is copied into the file
+    */
+    void mapBuffer(size_t bytes)
     {
+        using namespace boost::interprocess;
         try
         {
-        return _time_entries.size();
+            //a file must not be resized while it is mapped
+            mapped_region().swap(_region);
+            {
+                std::filebuf file;
+                std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out | std::ios_base::binary;
+                if (!file.open(_mapping_file.c_str(), _mapped ? mode : mode | std::ios_base::trunc))
+                    throw ModelicaSimulationError(DATASTORAGE,"could not create buffer file " + _mapping_file);
+                file.pubseekoff(bytes - 1, std::ios_base::beg);
+                file.sputc(0);
+            }
+            file_mapping mapping(_mapping_file.c_str(), read_write);
+            mapped_region(mapping, read_write, 0, bytes).swap(_region);
         }
-        catch(std::exception& ex)
+        catch(interprocess_exception& ex)
         {
-
-            throw ModelicaSimulationError(DATASTORAGE,string("time entries size failed")+ex.what());
-
+            throw ModelicaSimulationError(DATASTORAGE,string("mapping buffer file failed ")+ex.what());
+        }
+        if (!_mapped)
+        {
+            if (_data)
+                std::memcpy(_region.get_address(), _data, _capacity * _columns * sizeof(double));
+            std::free(_data);
+            _mapped = true;
         }
+        _data = (double*) _region.get_address();
     }
-    void eraseAll()
-    {
+#endif
 
-        _real_variables_buffer.clear();
-        _int_variables_buffer.clear();
-         _bool_variables_buffer.clear();
-        //_residues_buffer.clear();
-        _time_entries.clear();
-        _buffer_pos=0;
-        //textwriter->eraseAll();
+    void releaseBuffer()
+    {
+#ifdef USE_BUFFER_FILE_MAPPING
+        if (_mapped)
+        {
+            boost::interprocess::mapped_region().swap(_region);
+            boost::interprocess::file_mapping::remove(_mapping_file.c_str());
+            _mapped = false;
+        }
+        else
+#endif
+            std::free(_data);
+        _data = NULL;
+        _rows = 0;
+        _capacity = 0;
     }
 
-
-protected:
-    typedef boost::circular_buffer<  real_vars_t   > real_buffer_type;
-     typedef boost::circular_buffer<  int_vars_t   > int_buffer_type;
-    typedef boost::circular_buffer<  bool_vars_t   > bool_buffer_type;
-
-    typedef std::map<double,unsigned long> _time_entries_type;
-    real_buffer_type _real_variables_buffer;
-    int_buffer_type _int_variables_buffer;
-    bool_buffer_type _bool_variables_buffer;
-    //buffer_type_r _residues_buffer;
-    _time_entries_type _time_entries;
-    unsigned long _buffer_pos;
+    double* _data;
+    size_t _columns;
+    size_t _rows;
+    size_t _capacity;
+    size_t _expected_rows;
+    size_t _memory_limit;
+    bool _mapped;
+    string _mapping_file;
+#ifdef USE_BUFFER_FILE_MAPPING
+    boost::interprocess::mapped_region _region;
+#endif
     vector<string> _var_outputs;
 };
 /** @} */ // end of dataexchangePolicies
@@ -14,7 +14,7 @@
 class DefaultWriter : public ContainerManager
 {
  public:
-    DefaultWriter(unsigned long size, string output_path, string file_name)
+    DefaultWriter(unsigned long size, string output_path, string file_name, size_t memory_limit)
             : ContainerManager()
 
     {
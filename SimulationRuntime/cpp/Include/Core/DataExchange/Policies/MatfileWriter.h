@@ -22,17 +22,25 @@
 using std::ios;
 */
 #include <Core/DataExchange/FactoryPolicy.h>
+#include <fstream>
 
+/** default size in bytes of the block in which rows of the "data_2" matrix are collected before they are written */
+#define MAT_DATA_BUFFER_SIZE (4 * 1024 * 1024)
 
 class MatFileWriter : public ContainerManager
 {
  public:
-    MatFileWriter(unsigned long size, string output_path, string file_name)
+    MatFileWriter(unsigned long size, string output_path, string file_name, size_t memory_limit, size_t buffer_size = MAT_DATA_BUFFER_SIZE)
             : ContainerManager(),
               _dataHdrPos(),
               _dataEofPos(),
               _curser_position(0),
               _uiValueCount(0),
+              _uiWrittenCount(0),
+              _uiBufferedCount(0),
+              _uiBufferCapacity(0),
+              _uiRowSize(0),
+              _uiBufferSize(buffer_size),
               _output_path(output_path),
               _file_name(file_name),
               _doubleMatrixData1(NULL),
@@ -45,6 +53,9 @@ class MatFileWriter : public ContainerManager
     }
     ~MatFileWriter()
     {
+        finishWriteQueue();
+        flushDataBuffer();
+
         // free memory and initialize pointer
         delete[] _doubleMatrixData1;
         delete[] _doubleMatrixData2;
@@ -155,20 +166,8 @@ class MatFileWriter : public ContainerManager
         hdr.imagf = 0;
         hdr.namelen = strlen(name) + 1;
 
-        // special treatment for "data_2" matrix. After new simualtion data, header has to be written
-        if ((strcmp(name, "data_2") == 0) && (_dataHdrPos != _output_stream.tellp()))
-        {
-            _dataEofPos = _output_stream.tellp();
-            _output_stream.seekp(_dataHdrPos);
-            _output_stream.write((char*) &hdr, sizeof(MHeader_t));
-            _output_stream.write(name, sizeof(char) * hdr.namelen);
-            _output_stream.seekp(_dataEofPos);
-        }
-        else  // standard routine for header
-        {
-            _output_stream.write((char*) &hdr, sizeof(MHeader_t));
-            _output_stream.write(name, sizeof(char) * hdr.namelen);
-        }
+        _output_stream.write((char*) &hdr, sizeof(MHeader_t));
+        _output_stream.write(name, sizeof(char) * hdr.namelen);
     }
 
     /*=={function}===================================================================================*/
@@ -207,16 +206,41 @@ class MatFileWriter : public ContainerManager
         // first matrix header has to be written
         writeMatVer4MatrixHeader(name, rows, cols, size);
 
-        // special treatment for "data_2" matrix. cols = 1
-        if (strcmp(name, "data_2") == 0)
-        {
-            _output_stream.write((const char*) matrixData, (size) * rows * 1);
-            //dataDummy = _output_stream.tellp(); // workaround: because with gcc compiled, sporadicaly the last simulation data is not written to file
-        }
-        else  // standard write routine
+        _output_stream.write((const char*) matrixData, (size) * rows * cols);
+    }
+
+    /*=={function}===================================================================================*/
+    /*!
+     *  void flushDataBuffer()
+     *
+     *  brief:
+     *  ------
+     *  function writes all buffered rows of the "data_2" matrix with one write call and
+     *  updates the column count in the "data_2" header, which is the only seek per block.
+     *  The header is rewritten even if no rows are buffered, so that the count is final
+     *  when the file is closed. It is updated after the rows are written: the file of
+     *  a run that crashed is consistent and holds the rows of the last flush.
+     *
+     * \return
+     */
+    /*========================================================================================{end}==*/
+    void flushDataBuffer()
+    {
+        // no "data_2" matrix without rows
+        if (_uiValueCount == 0 || !_output_stream.is_open())
+            return;
+
+        if (_uiBufferedCount > 0)
         {
-            _output_stream.write((const char*) matrixData, (size) * rows * cols);
+            _output_stream.write((const char*) _doubleMatrixData2, sizeof(double) * _uiRowSize * _uiBufferedCount);
+            _uiWrittenCount += _uiBufferedCount;
+            _uiBufferedCount = 0;
         }
+
+        _dataEofPos = _output_stream.tellp();
+        _output_stream.seekp(_dataHdrPos);
+        writeMatVer4MatrixHeader("data_2", _uiRowSize, _uiWrittenCount, sizeof(double));
+        _output_stream.seekp(_dataEofPos);
     }
 
     /*=={function}===================================================================================*/
@@ -246,7 +270,10 @@ class MatFileWriter : public ContainerManager
         _output_path = output_path;
 
         if (_output_stream.is_open())
+        {
+            flushDataBuffer();
             _output_stream.close();
+        }
 
         // building complete file path
         std::stringstream res_output_path;
@@ -260,18 +287,26 @@ class MatFileWriter : public ContainerManager
 
         // initialize help variables
         _uiValueCount = 0;
+        _uiWrittenCount = 0;
+        _uiBufferedCount = 0;
+        _uiBufferCapacity = 0;
+        _uiRowSize = 0;
         _dataHdrPos = 0;
         _dataEofPos = 0;
 
+        delete[] _doubleMatrixData1;
+        delete[] _doubleMatrixData2;
+        delete[] _stringMatrix;
+        delete[] _pacString;
+        delete[] _intMatrix;
+
         _doubleMatrixData1 = NULL;
         _doubleMatrixData2 = NULL;
         _stringMatrix = NULL;
         _pacString = NULL;
         _intMatrix = NULL;
 
-        // allocate temp buffer for simulation data:
-        // dim_1 (number of variables) + dim_2 (number of der. variables) + 1 (time)
-        _doubleMatrixData2 = new double[dim + 1];
+        // the buffer for the simulation data rows is allocated with the first row
     }
 
     /*=={function}===================================================================================*/
@@ -714,11 +749,23 @@ class MatFileWriter : public ContainerManager
         unsigned int uiVarCount = get<0>(v_list).size() + get<1>(v_list).size() + get<2>(v_list).size() + 1;  // alle Variablen, alle abgeleiteten Variablen und die Zeit
         double *doubleHelpMatrix = NULL;
 
+        // the first row writes the "data_2" header without columns, the column count is updated with every flush
+        if (_uiValueCount == 0)
+        {
+            _uiRowSize = uiVarCount;
+            _uiBufferCapacity = max(1u, (unsigned int) (_uiBufferSize / (sizeof(double) * _uiRowSize)));
+            delete[] _doubleMatrixData2;
+            _doubleMatrixData2 = new double[_uiRowSize * _uiBufferCapacity];
+            _dataHdrPos = _output_stream.tellp();
+            writeMatVer4MatrixHeader("data_2", _uiRowSize, 0, sizeof(double));
+        }
+        else if (_uiBufferedCount == _uiBufferCapacity)
+            flushDataBuffer();
+
         _uiValueCount++;
 
-        // reset tempbuffer to zero
-        memset(_doubleMatrixData2, 0, sizeof(double) * uiVarCount);
-        doubleHelpMatrix = _doubleMatrixData2;
+        // the row is assembled in place in the block buffer
+        doubleHelpMatrix = _doubleMatrixData2 + _uiRowSize * _uiBufferedCount++;
 
         // first time ist written to "data_2" matrix...
         *doubleHelpMatrix = get<3>(v_list);
@@ -755,9 +802,6 @@ class MatFileWriter : public ContainerManager
         std::transform(get<2>(v_list).begin(), get<2>(v_list).end(), get<2>(neg_v_list).begin(),
             doubleHelpMatrix+nReal+nInt, WriteOutputVar<bool>());
 
-        // write matrix to file
-        writeMatVer4Matrix("data_2", uiVarCount, _uiValueCount, _doubleMatrixData2, sizeof(double));
-
         // initialize pointer
         doubleHelpMatrix = NULL;
     }
@@ -815,6 +859,11 @@ class MatFileWriter : public ContainerManager
     std::ofstream::pos_type _dataEofPos;
     unsigned int _curser_position;
     unsigned int _uiValueCount;
+    unsigned int _uiWrittenCount;    // rows of "data_2" written to the file
+    unsigned int _uiBufferedCount;   // rows of "data_2" waiting in _doubleMatrixData2
+    unsigned int _uiBufferCapacity;
+    unsigned int _uiRowSize;
+    size_t _uiBufferSize;            // bytes of the block buffer of "data_2"
     std::string _output_path;
     std::string _file_name;
     double *_doubleMatrixData1;
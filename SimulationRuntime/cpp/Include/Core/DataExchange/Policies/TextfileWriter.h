@@ -16,7 +16,7 @@ const char EXTENSION = ',';
 class TextFileWriter : public ContainerManager
 {
  public:
-    TextFileWriter(unsigned long size, string output_path, string file_name)
+    TextFileWriter(unsigned long size, string output_path, string file_name, size_t memory_limit)
             : ContainerManager(),
               _output_stream(),
               _curser_position(0),
@@ -27,6 +27,7 @@ class TextFileWriter : public ContainerManager
 
     ~TextFileWriter()
     {
+        finishWriteQueue();
         if (_output_stream.is_open())
             _output_stream.close();
     }
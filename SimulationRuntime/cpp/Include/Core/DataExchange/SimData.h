@@ -19,6 +19,9 @@ public:
   virtual ISimVar* Get(string key);
   virtual void addOutputResults(string name, ublas::vector<double> v);
   virtual void getOutputResults(string name, ublas::vector<double>& v);
+  virtual void addOutputResults(const vector<string>& names, ublas::matrix<double>& results);
+  virtual unsigned int getOutputHandle(string name);
+  virtual const double* getOutputResults(unsigned int handle, size_t& size);
   virtual void clearResults();
   virtual void clearVars();
   virtual void getTimeEntries(vector<double>& time_entries);
@@ -27,10 +30,13 @@ public:
 
 private:
   typedef map<string,shared_ptr<ISimVar> > Objects_type;
-  typedef map<string,ublas::vector<double> > OutputResults_type;
+  typedef unordered_map<string,unsigned int> OutputHandles_type;
 
   Objects_type _sim_vars;
-  OutputResults_type _result_vars;
+  //row index of each output var in _result_vars
+  OutputHandles_type _result_handles;
+  //results of all output vars, one contiguous row per output var
+  ublas::matrix<double> _result_vars;
   vector<double> _time_entries;
 };
 /** @} */ // end of dataexchange
@@ -1,51 +1,134 @@
 #pragma once
 
 
+struct sparse_inserter;
+
+/**
+ * Square matrix in compressed sparse column format, solved with UMFPACK.
+ * The first build freezes the pattern: afterwards the inserter writes the values
+ * directly into Ax and the symbolic factorization is reused until the pattern changes.
+ */
+struct BOOST_EXTENSION_EXPORT_DECL sparse_matrix {
+    std::vector<int> Ap;
+    std::vector<int> Ai;
+    std::vector<double> Ax;
+    int n;
+    sparse_matrix(int n=-1): n(n), _inserter(NULL), _symbolic(NULL), _numeric(NULL), _refactor(false) {}
+    ~sparse_matrix();
+
+    void build(sparse_inserter& ins);
+    int solve(const double* b,double* x);
+
+    /**
+     * Returns the position of entry (i,j) in Ax or -1 if it is not in the pattern,
+     * cursor is the number of entries written so far in the current assembly
+     */
+    inline int slot(int i, int j, size_t& cursor) const {
+        if(j < 0 || j >= n)
+            return -1;
+        //entries are usually written in the same order as in the first assembly
+        if(cursor < _slots.size()) {
+            int k = _slots[cursor];
+            if(Ai[k] == i && k >= Ap[j] && k < Ap[j+1]) {
+                ++cursor;
+                return k;
+            }
+        }
+        std::vector<int>::const_iterator first = Ai.begin() + Ap[j], last = Ai.begin() + Ap[j+1];
+        std::vector<int>::const_iterator it = std::lower_bound(first, last, i);
+        if(it == last || *it != i)
+            return -1;
+        int k = it - Ai.begin();
+        if(_positions[k] >= 0)
+            cursor = _positions[k] + 1;
+        return k;
+    }
+
+private:
+    sparse_matrix(const sparse_matrix&);
+    sparse_matrix& operator=(const sparse_matrix&);
+
+    void detach();
+    void freeFactorization();
+
+    friend struct sparse_inserter;
+    //inserter writing into the frozen pattern
+    sparse_inserter* _inserter;
+    //slot of every entry written in the first assembly, in order of writing
+    std::vector<int> _slots;
+    //position of the last write of a slot in _slots, -1 if not written
+    std::vector<int> _positions;
+    void* _symbolic;
+    void* _numeric;
+    //values changed since the last numeric factorization
+    bool _refactor;
+};
 
 struct BOOST_EXTENSION_EXPORT_DECL sparse_inserter  {
     struct t2 {
         int i;
         int j;
-        map< pair<int,int>, double> & content;
-        t2(int i, int j, map< pair<int,int>, double> & c): i(i), j(j), content(c) {}
+        sparse_inserter& ins;
+        t2(int i, int j, sparse_inserter& ins): i(i), j(j), ins(ins) {}
         inline void operator=(double t) {
-            content[make_pair(j,i)]=t;
+            ins.set(i,j,t);
         }
     };
 
     struct t1 {
         int i;
-        map< pair<int,int>, double> & content;
-        t1(int i,map< pair<int,int>, double> & c): i(i), content(c) {}
+        sparse_inserter& ins;
+        t1(int i,sparse_inserter& ins): i(i), ins(ins) {}
         inline t2 operator[](size_t j) {
-            t2 res(i,j,content);
+            t2 res(i,j,ins);
             return res;
         }
     };
 
 
     map< pair<int,int>, double> content;
+    //entries in order of writing, recorded until the pattern is frozen
+    std::vector<pair<int,int> > order;
+
+    sparse_inserter(): matrix(NULL), cursor(0) {}
+    ~sparse_inserter() {
+        if(matrix)
+            matrix->_inserter = NULL;
+    }
+
     inline t1 operator[](size_t i) {
-        t1 res(i,content);
+        t1 res(i,*this);
         return res;
     }
 
     inline t2 operator()(const unsigned int  i, const unsigned int j)
     {
-      t2 res(i-1,j-1,content);
+      t2 res(i-1,j-1,*this);
       return res;
     }
 
-};
+    inline void set(int i, int j, double t) {
+        if(matrix) {
+            int k = matrix->slot(i, j, cursor);
+            if(k >= 0) {
+                matrix->Ax[k] = t;
+                matrix->_refactor = true;
+                return;
+            }
+            //new entry, the pattern of the matrix changes
+            matrix->detach();
+        }
+        content[make_pair(j,i)]=t;
+        order.push_back(make_pair(i,j));
+    }
 
-struct BOOST_EXTENSION_EXPORT_DECL sparse_matrix {
-    std::vector<int> Ap;
-    std::vector<int> Ai;
-    std::vector<double> Ax;
-    int n;
-    sparse_matrix(int n=-1): n(n) {}
+private:
+    sparse_inserter(const sparse_inserter&);
+    sparse_inserter& operator=(const sparse_inserter&);
 
-    void build(sparse_inserter& ins);
-    int solve(const double* b,double* x);
+    friend struct sparse_matrix;
+    //matrix whose frozen pattern receives the values, NULL while assembling into content
+    sparse_matrix* matrix;
+    //number of entries written since the last build
+    size_t cursor;
 };
-
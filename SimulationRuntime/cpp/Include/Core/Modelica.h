@@ -63,6 +63,7 @@ namespace ublas = boost::numeric::ublas;
     using std::thread;
     using std::atomic;
     using std::mutex;
+    using std::memory_order_acquire;
     using std::memory_order_release;
     using std::memory_order_relaxed;
     using std::condition_variable;
@@ -138,6 +139,7 @@ namespace ublas = boost::numeric::ublas;
     using boost::thread;
     using boost::atomic;
     using boost::mutex;
+    using boost::memory_order_acquire;
     using boost::memory_order_release;
     using boost::memory_order_relaxed;
     using boost::condition_variable;
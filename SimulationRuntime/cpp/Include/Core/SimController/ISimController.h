@@ -22,6 +22,7 @@ struct SimSettings
   bool nonLinearSolverContinueOnError;
   int solverThreads;
   OutputFormat outputFomrat;
+  unsigned int historyMemoryLimit;
 };
 
 /**
@@ -27,6 +27,13 @@ public:
   virtual void addOutputResults(std::string name, ublas::vector<double> v) = 0;
   //Returns reference to results for an output var, when simData object is destroyed results are no longer valid
   virtual void getOutputResults(std::string name, ublas::vector<double>& v) = 0;
+  //Adds Results for all output vars, one row per output var, the results matrix is taken over and left empty
+  virtual void addOutputResults(const std::vector<std::string>& names, ublas::matrix<double>& results) = 0;
+  //Returns the handle of an output var, resolve it once and access the results by handle afterwards
+  virtual unsigned int getOutputHandle(std::string name) = 0;
+  //Returns pointer to the results of an output var without copying them, size is set to the number of time entries
+  //the pointer is valid until the results are cleared
+  virtual const double* getOutputResults(unsigned int handle, size_t& size) = 0;
   //Clears all output var results
   virtual void clearResults() = 0;
   //Returns the time interval
@@ -60,6 +60,9 @@ public:
   virtual void setSolverThreads(int);
   virtual int getSolverThreads();
 
+  virtual void setHistoryMemoryLimit(unsigned int);
+  virtual unsigned int getHistoryMemoryLimit();
+
 private:
   double
       _startTime, ///< Start time of integration (default: 0.0)
@@ -82,5 +85,6 @@ private:
   unsigned int _alarm_time;
   int _solverThreads;
   OutputFormat _outputFormat;
+  unsigned int _historyMemoryLimit;
 };
 /** @} */ // end of coreSimulationSettings
@@ -93,5 +93,8 @@ public:
 
   virtual void setSolverThreads(int) = 0;
   virtual int getSolverThreads() = 0;
+  ///< RAM budget in MB for results kept in memory, larger results are moved to a memory mapped file (0: unlimited)
+  virtual void setHistoryMemoryLimit(unsigned int) = 0;
+  virtual unsigned int getHistoryMemoryLimit() = 0;
 };
 /** @} */ // end of coreSimulationSettings
@@ -77,6 +77,10 @@ public:
   virtual bool getUseSparseFormat() = 0;
   virtual void setUseSparseFormat(bool value) = 0;
   virtual float queryDensity() = 0;
+  /// Provide the sparse pattern of the jacobian in compressed column format (rows of column j in index[leadindex[j]] .. index[leadindex[j+1]-1])
+  /// and the colors of the columns starting at 1, columns of the same color are structurally orthogonal
+  /// returns the number of colors or 0 if no pattern is available
+  virtual int getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn) = 0;
 
   /*/// Fügt das übergebene Objekt als Across-Kante hinzu
   void addAcrossEdge(IObject& new_obj);
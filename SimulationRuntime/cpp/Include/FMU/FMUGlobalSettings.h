@@ -57,5 +57,7 @@ public:
     virtual int getSolverThreads() { return 1; };
     virtual OutputFormat getOutputFormat() {return EMPTY;};
     virtual void setOutputFormat(OutputFormat) {};
+    virtual void setHistoryMemoryLimit(unsigned int) {};
+    virtual unsigned int getHistoryMemoryLimit() { return 0; };
 private:
 };
@@ -89,5 +89,7 @@ class FMU2GlobalSettings : public IGlobalSettings
   virtual int getSolverThreads() { return 1; };
   virtual OutputFormat getOutputFormat() {return EMPTY;};
   virtual void setOutputFormat(OutputFormat) {};
+  virtual void setHistoryMemoryLimit(unsigned int) {};
+  virtual unsigned int getHistoryMemoryLimit() { return 0; };
 };
 /** @} */ // end of fmu2
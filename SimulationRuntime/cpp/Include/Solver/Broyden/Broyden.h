@@ -125,6 +125,13 @@ private:
 
   bool _sparse;
 
+  const int
+	  *_sparseLeadindex,            ///< Start of the columns of the Jacobian in _sparseIndex
+	  *_sparseIndex,                ///< Row indices of the non zero entries of the Jacobian
+	  *_colorOfColumn;              ///< Color of the columns of the Jacobian, starting at 1
+  int
+	  _maxColors;                   ///< Number of colors, 0 if the Jacobian is computed column by column
+
 
   int _dim;
 #if defined(klu)
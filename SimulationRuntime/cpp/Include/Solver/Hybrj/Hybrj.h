@@ -83,6 +83,12 @@ private:
         _t1,            //old time
         _t2;              //old time
     bool _usescale;
+    const int
+        *_sparseLeadindex,          ///< Start of the columns of the Jacobian in _sparseIndex
+        *_sparseIndex,              ///< Row indices of the non zero entries of the Jacobian
+        *_colorOfColumn;            ///< Color of the columns of the Jacobian, starting at 1
+    int
+        _maxColors;                 ///< Number of colors, 0 if the Jacobian is computed column by column
     /*Hybrj MinPack variables */
 
     double*  _diag;                        ///DIAG is an array of length N.  If MODE = 1 (see below), DIAG is internally set.  If MODE = 2, DIAG must contain positive  entries that serve as multiplicative scale factors for the variables.
@@ -10,6 +10,9 @@
 #include <Core/Solver/INonLinSolverSettings.h>
 #include <Solver/Newton/NewtonSettings.h>
 
+/// Minimal dimension of an algebraic loop with sparse pattern for which the Newton step is solved with UMFPACK
+#define NEWTON_UMFPACK_MIN_DIM 100
+
 
 /*****************************************************************************/
 /**
@@ -56,6 +59,12 @@ class Newton : public IAlgLoopSolver
   /// Encapsulation of determination of Jacobian
   void calcJacobian();
 
+  /// Solution of the linear system for the Newton step, the right hand side _f is overwritten
+  void solveJacobian(int totSteps);
+
+  /// Release the factorizations of the sparse Jacobian
+  void freeSparseFactorization();
+
 
   // Member variables
   //---------------------------------------------------------------
@@ -87,7 +96,22 @@ class Newton : public IAlgLoopSolver
     *_yTest,                    ///< Temp        - Auxillary variables
     *_fTest,                    ///< Temp        - Auxillary variables
     *_jac,                      ///< Temp        - Jacobian
-    *_zeroVec;
+    *_zeroVec,
+    *_jacValues;                ///< Temp        - Entries of the sparse Jacobian in compressed column format
   long int *_iHelp;
 
+  const int
+    *_sparseLeadindex,          ///< Start of the columns of the Jacobian in _sparseIndex
+    *_sparseIndex,              ///< Row indices of the non zero entries of the Jacobian
+    *_colorOfColumn;            ///< Color of the columns of the Jacobian, starting at 1
+  int
+    _maxColors;                 ///< Number of colors, 0 if the Jacobian is computed column by column
+
+  bool
+    _useSparse;                 ///< Newton step is solved with UMFPACK
+
+  void
+    *_symbolic,                 ///< Symbolic factorization of the sparse Jacobian, kept while the pattern is unchanged
+    *_numeric;                  ///< Numeric factorization of the sparse Jacobian
+
 };/** @} */ // end of solverNewton
@@ -111,6 +111,7 @@ SimSettings OMCFactory::readSimulationParameter(int argc, const char* argv[])
           ("alarm,A", po::value<unsigned int >()->default_value(360),  "sets timeout in seconds for simulation")
           ("output-type,O", po::value< string >()->default_value("all"),  "the points in time written to result file: all (output steps + events), step (just output points), none")
           ("output-format,P", po::value< string >()->default_value("mat"),  "The simulation results output format")
+          ("history-memory-limit", po::value< unsigned int >()->default_value(0),  "RAM budget in MB for buffered results, larger results are moved to a memory mapped file (0: unlimited)")
           ;
 
      // a group for all options that should not be visible if '--help' is set
@@ -160,6 +161,7 @@ SimSettings OMCFactory::readSimulationParameter(int argc, const char* argv[])
      double stepsize =vm["step-size"].as<double>();
      bool nlsContinueOnError = vm["nls-continue"].as<bool>();
      int solverThreads = vm["solverThreads"].as<int>();
+     unsigned int historyMemoryLimit = vm["history-memory-limit"].as<unsigned int>();
 
      if (!(stepsize > 0.0))
          stepsize = (stoptime - starttime) / vm["number-of-intervals"].as<int>();
@@ -247,7 +249,7 @@ SimSettings OMCFactory::readSimulationParameter(int argc, const char* argv[])
      libraries_path.make_preferred();
      modelica_path.make_preferred();
 
-     SimSettings settings = {solver,linSolver,nonLinSolver,starttime,stoptime,stepsize,1e-24,0.01,tolerance,resultsfilename,timeOut,outputPointType,logSet,nlsContinueOnError,solverThreads,outputFormat};
+     SimSettings settings = {solver,linSolver,nonLinSolver,starttime,stoptime,stepsize,1e-24,0.01,tolerance,resultsfilename,timeOut,outputPointType,logSet,nlsContinueOnError,solverThreads,outputFormat,historyMemoryLimit};
 
      _library_path = libraries_path.string();
      _modelicasystem_path = modelica_path.string();
@@ -41,6 +41,10 @@ Broyden::Broyden(IAlgLoop* algLoop, INonLinSolverSettings* settings)
 	, _work               (NULL)
 	,_zeroVec             (NULL)
 	, _identity           (NULL)
+	, _sparseLeadindex    (NULL)
+	, _sparseIndex        (NULL)
+	, _colorOfColumn      (NULL)
+	, _maxColors          (0)
 
 
 #if defined(klu)
@@ -242,6 +246,9 @@ void Broyden::initialize()
 	}
 
 
+	// Sparse pattern and coloring of the Jacobian, if provided by the algebraic loop
+	_maxColors = _dimSys > 0 ? _algLoop->getSparsePattern(_sparseLeadindex, _sparseIndex, _colorOfColumn) : 0;
+
 	long int
 		irtrn    = 0;
 
@@ -573,6 +580,34 @@ void Broyden::stepCompleted(double time)
 
 void Broyden::calcJacobian()
 {
+	if(_maxColors > 0)
+	{
+		// Columns of the same color have no common rows and are perturbed together
+		double stepsize=1.e-6;
+		memcpy(_jacHelpVec1,_y,_dimSys*sizeof(double));
+		memset(_jac,0,_dimSys*_dimSys*sizeof(double));
+
+		for(int color=1; color<=_maxColors; ++color)
+		{
+			for(int j=0; j<_dimSys; ++j)
+				if(_colorOfColumn[j] == color)
+					_jacHelpVec1[j] += stepsize;
+
+			calcFunction(_jacHelpVec1,_fHelp);
+
+			// Build Jacobian in Fortran format from the entries of the perturbed columns
+			for(int j=0; j<_dimSys; ++j)
+			{
+				if(_colorOfColumn[j] == color)
+				{
+					for(int k=_sparseLeadindex[j]; k<_sparseLeadindex[j+1]; ++k)
+						_jac[_sparseIndex[k]+j*_dimSys] = (_fHelp[_sparseIndex[k]] - _fold[_sparseIndex[k]]) / stepsize;
+					_jacHelpVec1[j] = _y[j];
+				}
+			}
+		}
+		return;
+	}
 
 	for(int j=0; j<_dimSys; ++j)
 	{
@@ -39,6 +39,10 @@ Hybrj::Hybrj(IAlgLoop* algLoop, INonLinSolverSettings* settings)
 	, _zeroVec(NULL)
 	,_initial_factor(100)
 	,_usescale(false)
+	,_sparseLeadindex(NULL)
+	,_sparseIndex(NULL)
+	,_colorOfColumn(NULL)
+	,_maxColors(0)
 {
 	_data = ((void*)this);
 }
@@ -169,7 +173,8 @@ void Hybrj::initialize()
 		}
 	}
 
-
+	// Sparse pattern and coloring of the Jacobian, if provided by the algebraic loop
+	_maxColors = _dimSys > 0 ? _algLoop->getSparsePattern(_sparseLeadindex, _sparseIndex, _colorOfColumn) : 0;
 }
 
 void Hybrj::solve()
@@ -444,6 +449,34 @@ void  Hybrj::extrapolateVars()
 
 void Hybrj::calcJacobian(double *fjac)
 {
+	if(_maxColors > 0)
+	{
+		// Columns of the same color have no common rows and are perturbed together
+		memcpy(_xHelp,_x,_dimSys*sizeof(double));
+		std::fill_n(fjac,_dimSys*_dimSys,0.0);
+
+		for(int color=1; color<=_maxColors; ++color)
+		{
+			for(int j=0; j<_dimSys; ++j)
+				if(_colorOfColumn[j] == color)
+					_xHelp[j] += sqrt(UROUND*std::max(1e-5,std::abs(_x[j])));
+
+			calcFunction(_xHelp,_fHelp);
+
+			// Build Jacobian in Fortran format from the entries of the perturbed columns
+			for(int j=0; j<_dimSys; ++j)
+			{
+				if(_colorOfColumn[j] == color)
+				{
+					double delta = _xHelp[j] - _x[j];
+					for(int k=_sparseLeadindex[j]; k<_sparseLeadindex[j+1]; ++k)
+						fjac[_sparseIndex[k]+j*_dimSys] = (_fHelp[_sparseIndex[k]] - _f[_sparseIndex[k]]) /delta;
+					_xHelp[j] = _x[j];
+				}
+			}
+		}
+		return;
+	}
 	for(int j=0; j<_dimSys; ++j)
 	{
 		// Reset variables for every column
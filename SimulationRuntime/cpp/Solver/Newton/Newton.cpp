@@ -14,6 +14,10 @@
 #include <Core/Math/ILapack.h>     // needed for solution of linear system with Lapack
 #include <Core/Math/Constants.h>   // definitializeion of constants like uround
 
+#ifdef USE_UMFPACK
+#include "umfpack.h"               // needed for solution of sparse linear system
+#endif
+
 template <typename S, typename T>
 static inline void LogSysVec(IAlgLoop* algLoop, S name, T vec[]) {
   if (Logger::getInstance()->isOutput(LC_NLS, LL_DEBUG)) {
@@ -43,6 +47,14 @@ Newton::Newton(IAlgLoop* algLoop, INonLinSolverSettings* settings)
   , _iHelp            (NULL)
   , _jac              (NULL)
   , _zeroVec          (NULL)
+  , _jacValues        (NULL)
+  , _sparseLeadindex  (NULL)
+  , _sparseIndex      (NULL)
+  , _colorOfColumn    (NULL)
+  , _maxColors        (0)
+  , _useSparse        (false)
+  , _symbolic         (NULL)
+  , _numeric          (NULL)
   , _dimSys           (0)
   , _firstCall        (true)
   , _iterationStatus  (CONTINUE)
@@ -64,6 +76,8 @@ Newton::~Newton()
   if (_iHelp)    delete []    _iHelp;
   if (_jac)      delete []    _jac;
   if (_zeroVec)  delete []   _zeroVec;
+  if (_jacValues) delete []  _jacValues;
+  freeSparseFactorization();
 }
 
 void Newton::initialize()
@@ -123,6 +137,19 @@ void Newton::initialize()
       _iterationStatus = SOLVERERROR;
     }
   }
+
+  // Sparse pattern and coloring of the Jacobian, if provided by the algebraic loop
+  _maxColors = _dimSys > 0? _algLoop->getSparsePattern(_sparseLeadindex, _sparseIndex, _colorOfColumn): 0;
+  freeSparseFactorization();
+  if (_jacValues) delete [] _jacValues;
+  _jacValues = NULL;
+  _useSparse = false;
+#ifdef USE_UMFPACK
+  if (_maxColors > 0 && _dimSys >= NEWTON_UMFPACK_MIN_DIM) {
+    _jacValues = new double[_sparseLeadindex[_dimSys]];
+    _useSparse = true;
+  }
+#endif
   if (Logger::getInstance()->isOutput(LC_NLS, LL_DEBUG)) {
     Logger::write("Newton: eq" + to_string(_algLoop->getEquationIndex())
                   + " initialized", LC_NLS, LL_DEBUG);
@@ -210,12 +237,7 @@ void Newton::solve()
           calcJacobian();
 
           // Solve linear System
-          dgesv_(&_dimSys, &dimRHS, _jac, &_dimSys, _iHelp, _f, &_dimSys, &info);
-
-          if (info != 0)
-            throw ModelicaSimulationError(ALGLOOP_SOLVER,
-              "error solving nonlinear system (iteration: " + to_string(totSteps)
-              + ", dgesv info: " + to_string(info) + ")");
+          solveJacobian(totSteps);
 
           // Increase counter
           ++ totSteps;
@@ -347,6 +369,38 @@ void Newton::stepCompleted(double time)
 
 void Newton::calcJacobian()
 {
+  if (_maxColors > 0) {
+    // Columns of the same color have no common rows and are perturbed together
+    std::copy(_y, _y + _dimSys, _yHelp);
+    if (!_useSparse)
+      std::fill(_jac, _jac + _dimSys*_dimSys, 0.0);
+
+    for (int color = 1; color <= _maxColors; ++color) {
+      for (int j = 0; j < _dimSys; ++j) {
+        if (_colorOfColumn[j] == color)
+          _yHelp[j] += 1e-6 * _yNominal[j];
+      }
+
+      calcFunction(_yHelp, _fHelp);
+
+      // Build Jacobian from the entries of the perturbed columns
+      for (int j = 0; j < _dimSys; ++j) {
+        if (_colorOfColumn[j] == color) {
+          double stepsize = 1e-6 * _yNominal[j];
+          for (int k = _sparseLeadindex[j]; k < _sparseLeadindex[j + 1]; ++k) {
+            int i = _sparseIndex[k];
+            if (_useSparse)
+              _jacValues[k] = (_fHelp[i] - _f[i]) / stepsize;
+            else
+              _jac[i + j * _dimSys] = (_fHelp[i] - _f[i]) / stepsize;
+          }
+          _yHelp[j] = _y[j];
+        }
+      }
+    }
+    return;
+  }
+
   for (int j = 0; j < _dimSys; ++j) {
     // Reset variables for every column
     std::copy(_y, _y + _dimSys, _yHelp);
@@ -365,6 +419,65 @@ void Newton::calcJacobian()
   }
 }
 
+void Newton::solveJacobian(int totSteps)
+{
+#ifdef USE_UMFPACK
+  if (_useSparse) {
+    double Control[UMFPACK_CONTROL], Info[UMFPACK_INFO];
+    int status;
+    umfpack_di_defaults(Control);
+    // the pattern doesn't change, so the symbolic factorization is done once
+    if (!_symbolic) {
+      status = umfpack_di_symbolic(_dimSys, _dimSys, _sparseLeadindex, _sparseIndex, _jacValues, &_symbolic, Control, Info);
+      if (status != UMFPACK_OK) {
+        // pattern not usable by umfpack, continue with the dense Jacobian
+        freeSparseFactorization();
+        _useSparse = false;
+        std::fill(_jac, _jac + _dimSys*_dimSys, 0.0);
+        for (int j = 0; j < _dimSys; ++j)
+          for (int k = _sparseLeadindex[j]; k < _sparseLeadindex[j + 1]; ++k)
+            _jac[_sparseIndex[k] + j * _dimSys] = _jacValues[k];
+      }
+    }
+    if (_useSparse) {
+      if (_numeric)
+        umfpack_di_free_numeric(&_numeric);
+      status = umfpack_di_numeric(_sparseLeadindex, _sparseIndex, _jacValues, _symbolic, &_numeric, Control, Info);
+      if (status == UMFPACK_OK)
+        status = umfpack_di_solve(UMFPACK_A, _sparseLeadindex, _sparseIndex, _jacValues, _fHelp, _f, _numeric, Control, Info);
+      if (status != UMFPACK_OK)
+        throw ModelicaSimulationError(ALGLOOP_SOLVER,
+          "error solving nonlinear system (iteration: " + to_string(totSteps)
+          + ", umfpack status: " + to_string(status) + ")");
+      std::copy(_fHelp, _fHelp + _dimSys, _f);
+      return;
+    }
+  }
+#endif
+  long int
+    dimRHS   = 1,        // Dimension of right hand side of linear system (=b)
+    info     = 0;        // Retrun-flag of Fortran code
+
+  dgesv_(&_dimSys, &dimRHS, _jac, &_dimSys, _iHelp, _f, &_dimSys, &info);
+
+  if (info != 0)
+    throw ModelicaSimulationError(ALGLOOP_SOLVER,
+      "error solving nonlinear system (iteration: " + to_string(totSteps)
+      + ", dgesv info: " + to_string(info) + ")");
+}
+
+void Newton::freeSparseFactorization()
+{
+#ifdef USE_UMFPACK
+  if (_symbolic)
+    umfpack_di_free_symbolic(&_symbolic);
+  if (_numeric)
+    umfpack_di_free_numeric(&_numeric);
+#endif
+  _symbolic = NULL;
+  _numeric = NULL;
+}
+
 void Newton::restoreOldValues()
 {
 }
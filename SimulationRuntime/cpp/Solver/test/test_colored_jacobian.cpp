@@ -0,0 +1,192 @@
+/** @addtogroup solverTest
+ *
+ *  @{
+ */
+/*
+ * Solves the same nonlinear algebraic loops with Newton, Broyden and Hybrj,
+ * once with finite differences column by column and once with the colored
+ * sparse pattern the loop provides. The loops are
+ *   f_i = y_i^3 + 4 y_i - y_(i-1) - 0.5 y_(i+2) - (1 + 0.1 i),
+ * the unknown y_j appears in the residuals j-2, j and j+1, so the pattern is
+ * not symmetric and a pattern with rows and columns swapped, or residuals in
+ * another order than the unknowns of the loop, gives wrong Jacobians.
+ * The columns j and j+4 have no common rows, so four colors are enough.
+ *
+ * The small loop provides its pattern like the generated code does, the
+ * large one is big enough for the sparse Newton step of NEWTON_UMFPACK_MIN_DIM.
+ */
+
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+
+#include <Solver/Newton/Newton.h>
+#include <Solver/Broyden/Broyden.h>
+#include <Solver/Hybrj/Hybrj.h>
+
+#include <cstdio>
+
+class TestSettings : public INonLinSolverSettings
+{
+public:
+  virtual long int getNewtMax() { return 50; }
+  virtual void setNewtMax(long int) {}
+  virtual double getRtol() { return 1e-12; }
+  virtual void setRtol(double) {}
+  virtual double getAtol() { return 1e-12; }
+  virtual void setAtol(double) {}
+  virtual double getDelta() { return 1e-2; }
+  virtual void setDelta(double) {}
+  virtual void load(string) {}
+  virtual void setContinueOnError(bool) {}
+  virtual bool getContinueOnError() { return false; }
+};
+
+class TestAlgLoop : public IAlgLoop
+{
+public:
+  TestAlgLoop(int dim, bool providePattern)
+    : _dim(dim)
+    , _providePattern(providePattern)
+    , _y(dim, 0.0)
+    , _evaluations(0)
+  {
+    // pattern in compressed column format with rows in ascending order
+    _columnStart.push_back(0);
+    for (int j = 0; j < _dim; j++) {
+      int rows[] = {j - 2, j, j + 1};
+      for (int k = 0; k < 3; k++)
+        if (rows[k] >= 0 && rows[k] < _dim)
+          _rowIndex.push_back(rows[k]);
+      _columnStart.push_back(_rowIndex.size());
+      _columnColor.push_back(j % 4 + 1);
+    }
+  }
+
+  int getEvaluations() const { return _evaluations; }
+  const std::vector<double>& getSolution() const { return _y; }
+
+  virtual int getEquationIndex() const { return 1; }
+  virtual int getDimReal() const { return _dim; }
+  virtual int getDimRHS() const { return _dim; }
+  virtual void initialize() { std::fill(_y.begin(), _y.end(), 0.0); }
+  virtual void getNamesReal(const char** names) const { for (int i = 0; i < _dim; i++) names[i] = "y"; }
+  virtual void getNominalReal(double* nominals) const { std::fill(nominals, nominals + _dim, 1.0); }
+  virtual void getMinReal(double* mins) const { std::fill(mins, mins + _dim, -1e10); }
+  virtual void getMaxReal(double* maxs) const { std::fill(maxs, maxs + _dim, 1e10); }
+  virtual double getSimTime() const { return 0.0; }
+  virtual void getReal(double* vars) const { std::copy(_y.begin(), _y.end(), vars); }
+  virtual void setReal(const double* vars) { std::copy(vars, vars + _dim, _y.begin()); }
+  virtual void evaluate() { _evaluations++; }
+  virtual void getRHS(double* res) const
+  {
+    for (int i = 0; i < _dim; i++)
+      res[i] = _y[i]*_y[i]*_y[i] + 4.0*_y[i] - (i > 0? _y[i-1]: 0.0) - 0.5*(i + 2 < _dim? _y[i+2]: 0.0) - (1.0 + 0.1*i);
+  }
+  virtual void getSparseAdata(double* data, int nonzeros) {}
+  virtual const matrix_t& getSystemMatrix() { return _A; }
+  virtual const sparsematrix_t& getSystemSparseMatrix() { return _ASparse; }
+  virtual bool isLinear() { return false; }
+  virtual bool isLinearTearing() { return false; }
+  virtual bool isConsistent() { return true; }
+  virtual bool getUseSparseFormat() { return false; }
+  virtual void setUseSparseFormat(bool value) {}
+  virtual float queryDensity() { return 1.0f; }
+
+  virtual int getSparsePattern(const int*& leadindex, const int*& index, const int*& colorOfColumn)
+  {
+    if (!_providePattern)
+      return 0;
+    if (_dim == 12) {
+      // as emitted by getSparsePatternCode of CodegenCpp.tpl
+      static const int columnStart[] = {0,2,4,7,10,13,16,19,22,25,28,31,33};
+      static const int rowIndex[] = {0,1,1,2,0,2,3,1,3,4,2,4,5,3,5,6,4,6,7,5,7,8,6,8,9,7,9,10,8,10,11,9,11};
+      static const int columnColor[] = {1,2,3,4,1,2,3,4,1,2,3,4};
+      leadindex = columnStart;
+      index = rowIndex;
+      colorOfColumn = columnColor;
+      return 4;
+    }
+    leadindex = &_columnStart[0];
+    index = &_rowIndex[0];
+    colorOfColumn = &_columnColor[0];
+    return 4;
+  }
+
+private:
+  int _dim;
+  bool _providePattern;
+  std::vector<double> _y;
+  int _evaluations;
+  std::vector<int> _columnStart;
+  std::vector<int> _rowIndex;
+  std::vector<int> _columnColor;
+  matrix_t _A;
+  sparsematrix_t _ASparse;
+};
+
+enum SolverType { NEWTON, BROYDEN, HYBRJ };
+static const char* solverNames[] = {"Newton", "Broyden", "Hybrj"};
+
+static void solve(SolverType type, TestAlgLoop& algLoop)
+{
+  TestSettings settings;
+  IAlgLoopSolver* solver;
+  switch (type) {
+  case NEWTON:  solver = new Newton(&algLoop, &settings); break;
+  case BROYDEN: solver = new Broyden(&algLoop, &settings); break;
+  default:      solver = new Hybrj(&algLoop, &settings); break;
+  }
+  solver->initialize();
+  solver->solve();
+  delete solver;
+}
+
+static double maxResidual(TestAlgLoop& algLoop)
+{
+  std::vector<double> res(algLoop.getDimRHS());
+  double maxRes = 0.0;
+  algLoop.getRHS(&res[0]);
+  for (size_t i = 0; i < res.size(); i++)
+    maxRes = std::max(maxRes, std::abs(res[i]));
+  return maxRes;
+}
+
+int main()
+{
+  int dims[] = {12, NEWTON_UMFPACK_MIN_DIM + 20};
+  int errors = 0;
+
+  for (int d = 0; d < 2; d++) {
+    for (int type = NEWTON; type <= HYBRJ; type++) {
+      TestAlgLoop dense(dims[d], false), colored(dims[d], true);
+      solve((SolverType)type, dense);
+      solve((SolverType)type, colored);
+
+      double maxDiff = 0.0;
+      for (int i = 0; i < dims[d]; i++)
+        maxDiff = std::max(maxDiff, std::abs(dense.getSolution()[i] - colored.getSolution()[i]));
+
+      if (maxResidual(dense) > 1e-6 || maxResidual(colored) > 1e-6) {
+        std::fprintf(stderr, "%s, dimension %d: residual %g dense, %g colored\n",
+                     solverNames[type], dims[d], maxResidual(dense), maxResidual(colored));
+        errors++;
+      }
+      if (maxDiff > 1e-8) {
+        std::fprintf(stderr, "%s, dimension %d: colored solution differs by %g\n", solverNames[type], dims[d], maxDiff);
+        errors++;
+      }
+      // the colored difference quotients are bitwise the ones of the single columns
+      if (type == NEWTON && dims[d] < NEWTON_UMFPACK_MIN_DIM && maxDiff != 0.0) {
+        std::fprintf(stderr, "Newton, dimension %d: colored iterates differ from the dense ones\n", dims[d]);
+        errors++;
+      }
+      if (colored.getEvaluations() >= dense.getEvaluations()) {
+        std::fprintf(stderr, "%s, dimension %d: %d evaluations colored, %d dense\n",
+                     solverNames[type], dims[d], colored.getEvaluations(), dense.getEvaluations());
+        errors++;
+      }
+    }
+  }
+  return errors;
+}
+/** @} */ // end of solverTest
@@ -28,6 +28,9 @@
  *
  */
 
+#include <math.h>
+#include <float.h>
+
 #include "simulation_data.h"
 #include "simulation/solver/stateset.h"
 #include "simulation/solver/model_help.h"
@@ -35,8 +38,13 @@
 #include "simulation/solver/linearSystem.h"
 #include "simulation/solver/mixedSystem.h"
 #include "simulation/solver/delay.h"
+#include "simulation/solver/checkpoint.h"
 #include "simulation/simulation_info_json.h"
 #include "simulation/simulation_input_xml.h"
+#include "util/cJSON.h"
+
+extern int dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+extern int dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
 /*
 DLLExport pthread_key_t fmu2_thread_data_key;
 */
@@ -58,6 +66,14 @@ fmi2ValueReference vrStates[NUMBER_OF_STATES] = STATES;
 fmi2ValueReference vrStatesDerivatives[NUMBER_OF_STATES] = STATESDERIVATIVES;
 #endif
 
+// array of value references of real inputs and outputs in the order of the Jacobians B, C and D
+#if NUMBER_OF_INPUTS>0
+fmi2ValueReference vrInputs[NUMBER_OF_INPUTS] = INPUTS;
+#endif
+#if NUMBER_OF_OUTPUTS>0
+fmi2ValueReference vrOutputs[NUMBER_OF_OUTPUTS] = OUTPUTS;
+#endif
+
 // ---------------------------------------------------------------------------
 // Private helpers used below to validate function arguments
 // ---------------------------------------------------------------------------
@@ -132,6 +148,253 @@ fmi2Boolean isCategoryLogged(ModelInstance *comp, int categoryIndex) {
   return fmi2False;
 }
 
+// ---------------------------------------------------------------------------
+// Private helpers for the lazy evaluation of the model
+// ---------------------------------------------------------------------------
+// A changed input, parameter, state or time makes both equation partitions and
+// the cached Jacobians stale. The getters only evaluate the partition the
+// requested values belong to and skip it if nothing changed since the last
+// evaluation. Both functions have to be called inside MMC_TRY_INTERNAL.
+static void invalidateModel(ModelInstance *comp) {
+  comp->_need_update = 1;
+  comp->_need_update_algebraics = 1;
+  comp->_need_jacobian_update = 1;
+}
+
+static void updateODE(ModelInstance *comp) {
+  if (comp->_need_update) {
+    comp->fmuData->callback->functionODE(comp->fmuData, comp->threadData);
+    overwriteOldSimulationData(comp->fmuData);
+    comp->_need_update = 0;
+  }
+}
+
+static void updateAlgebraics(ModelInstance *comp) {
+  updateODE(comp);
+  if (comp->_need_update_algebraics) {
+    comp->fmuData->callback->functionAlgebraics(comp->fmuData, comp->threadData);
+    comp->_need_update_algebraics = 0;
+  }
+}
+
+/* States, derivatives, inputs and parameters need no algebraic equations */
+static fmi2Boolean needsAlgebraics(ModelInstance *comp, fmi2ValueReference vr) {
+  if (vr < 2*NUMBER_OF_STATES)
+    return fmi2False;
+  if (comp->jac_known && comp->jac_known[vr] >= 0)
+    return fmi2False;
+  if (vr >= comp->fmuData->modelData->nVariablesReal && vr < comp->fmuData->modelData->nVariablesReal + comp->fmuData->modelData->nParametersReal)
+    return fmi2False;
+  return fmi2True;
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers for fmi2GetDirectionalDerivative
+// ---------------------------------------------------------------------------
+// The knowns [x; u] and unknowns [der(x); y] are coupled by the symbolic
+// Jacobians of the linearization
+//   [der(x); y] = [A B; C D] * [x; u]
+// with x, der(x) in the order of STATES, STATESDERIVATIVES and u, y in the
+// order of INPUTS, OUTPUTS.
+static void initializeDirectionalDerivativeJacobian(ModelInstance *comp, DirectionalDerivativeJacobian *jac, char name,
+    int index, int (*initialize)(void*, threadData_t*), int (*column)(void*, threadData_t*), int rowOffset, int colOffset, int nRows, int nCols) {
+  ANALYTIC_JACOBIAN *jacobian;
+
+  jac->index = index;
+  jac->column = column;
+  jac->rowOffset = rowOffset;
+  jac->colOffset = colOffset;
+  jac->available = fmi2False;
+  jac->valid = fmi2False;
+  /* an empty block is never used */
+  if (nRows == 0 || nCols == 0)
+    return;
+  if (initialize(comp->fmuData, comp->threadData)) {
+    FILTERED_LOG(comp, fmi2Warning, LOG_STATUSWARNING, "fmi2Instantiate: Jacobian %c could not be initialized. Its directional derivatives are approximated by finite differences.", name)
+    return;
+  }
+
+  jacobian = &(comp->fmuData->simulationInfo->analyticJacobians[index]);
+  if (jacobian->sizeRows != nRows || jacobian->sizeCols != nCols) {
+    FILTERED_LOG(comp, fmi2Warning, LOG_STATUSWARNING, "fmi2Instantiate: Jacobian %c has size %ux%u, expected %dx%d. Its directional derivatives are approximated by finite differences.",
+        name, jacobian->sizeRows, jacobian->sizeCols, nRows, nCols)
+    return;
+  }
+  if (!jac->values)
+    jac->values = (fmi2Real*)comp->functions->allocateMemory(jacobian->sparsePattern.numberOfNoneZeros+1, sizeof(fmi2Real));
+  jac->available = jac->values != NULL;
+}
+
+static void initializeDirectionalDerivatives(ModelInstance *comp) {
+  const int nx = NUMBER_OF_STATES, nu = NUMBER_OF_INPUTS, ny = NUMBER_OF_OUTPUTS;
+  int i;
+
+  if (!comp->jac_known) {
+    comp->jac_known = (int*)comp->functions->allocateMemory(NUMBER_OF_REALS+1, sizeof(int));
+    comp->jac_unknown = (int*)comp->functions->allocateMemory(NUMBER_OF_REALS+1, sizeof(int));
+    comp->jac_seed = (fmi2Real*)comp->functions->allocateMemory(nx+nu+1, sizeof(fmi2Real));
+    comp->jac_result = (fmi2Real*)comp->functions->allocateMemory(nx+ny+1, sizeof(fmi2Real));
+    comp->jac_work = (fmi2Real*)comp->functions->allocateMemory(2*nx+nu+ny+1, sizeof(fmi2Real));
+    if (!comp->jac_known || !comp->jac_unknown || !comp->jac_seed || !comp->jac_result || !comp->jac_work)
+      return;
+
+    for (i = 0; i < NUMBER_OF_REALS; i++) {
+      comp->jac_known[i] = -1;
+      comp->jac_unknown[i] = -1;
+    }
+#if NUMBER_OF_STATES>0
+    for (i = 0; i < nx; i++) {
+      comp->jac_known[vrStates[i]] = i;
+      comp->jac_unknown[vrStatesDerivatives[i]] = i;
+    }
+#endif
+#if NUMBER_OF_INPUTS>0
+    for (i = 0; i < nu; i++)
+      comp->jac_known[vrInputs[i]] = nx + i;
+#endif
+#if NUMBER_OF_OUTPUTS>0
+    for (i = 0; i < ny; i++)
+      comp->jac_unknown[vrOutputs[i]] = nx + i;
+#endif
+  }
+
+#ifndef FMU_DISABLE_DIRECTIONAL_DERIVATIVES
+  initializeDirectionalDerivativeJacobian(comp, &comp->jacobians[0], 'A', comp->fmuData->callback->INDEX_JAC_A,
+      comp->fmuData->callback->initialAnalyticJacobianA, comp->fmuData->callback->functionJacA_column, 0, 0, nx, nx);
+  initializeDirectionalDerivativeJacobian(comp, &comp->jacobians[1], 'B', comp->fmuData->callback->INDEX_JAC_B,
+      comp->fmuData->callback->initialAnalyticJacobianB, comp->fmuData->callback->functionJacB_column, 0, nx, nx, nu);
+  initializeDirectionalDerivativeJacobian(comp, &comp->jacobians[2], 'C', comp->fmuData->callback->INDEX_JAC_C,
+      comp->fmuData->callback->initialAnalyticJacobianC, comp->fmuData->callback->functionJacC_column, nx, 0, ny, nx);
+  initializeDirectionalDerivativeJacobian(comp, &comp->jacobians[3], 'D', comp->fmuData->callback->INDEX_JAC_D,
+      comp->fmuData->callback->initialAnalyticJacobianD, comp->fmuData->callback->functionJacD_column, nx, nx, ny, nu);
+#endif
+  comp->_need_jacobian_update = 1;
+}
+
+/* Computes all nonzeros of the Jacobian with one column evaluation per color
+ * of its sparse pattern, i.e. maxColors evaluations instead of one per column.
+ */
+static void updateDirectionalDerivativeJacobian(ModelInstance *comp, DirectionalDerivativeJacobian *jac) {
+  ANALYTIC_JACOBIAN *jacobian = &(comp->fmuData->simulationInfo->analyticJacobians[jac->index]);
+  const SPARSE_PATTERN *pattern = &(jacobian->sparsePattern);
+  unsigned int color, col, i;
+
+  for (color = 1; color <= pattern->maxColors; color++) {
+    for (col = 0; col < jacobian->sizeCols; col++)
+      jacobian->seedVars[col] = (pattern->colorCols[col] == color) ? 1.0 : 0.0;
+
+    jac->column(comp->fmuData, comp->threadData);
+
+    for (col = 0; col < jacobian->sizeCols; col++) {
+      if (pattern->colorCols[col] != color)
+        continue;
+      for (i = (col == 0) ? 0 : pattern->leadindex[col-1]; i < pattern->leadindex[col]; i++)
+        jac->values[i] = jacobian->resultVars[pattern->index[i]];
+    }
+  }
+  memset(jacobian->seedVars, 0, jacobian->sizeCols*sizeof(modelica_real));
+  jac->valid = fmi2True;
+}
+
+/* result += J * seed for a general direction with a single column evaluation */
+static void seedDirectionalDerivativeJacobian(ModelInstance *comp, DirectionalDerivativeJacobian *jac, const fmi2Real *seed, fmi2Real *result) {
+  ANALYTIC_JACOBIAN *jacobian = &(comp->fmuData->simulationInfo->analyticJacobians[jac->index]);
+  unsigned int row;
+
+  memcpy(jacobian->seedVars, seed + jac->colOffset, jacobian->sizeCols*sizeof(modelica_real));
+  jac->column(comp->fmuData, comp->threadData);
+  for (row = 0; row < jacobian->sizeRows; row++)
+    result[jac->rowOffset + row] += jacobian->resultVars[row];
+  memset(jacobian->seedVars, 0, jacobian->sizeCols*sizeof(modelica_real));
+}
+
+static fmi2ValueReference knownValueReference(int pos) {
+#if NUMBER_OF_STATES>0
+  if (pos < NUMBER_OF_STATES)
+    return vrStates[pos];
+#endif
+#if NUMBER_OF_INPUTS>0
+  return vrInputs[pos - NUMBER_OF_STATES];
+#else
+  return 0;
+#endif
+}
+
+static fmi2ValueReference unknownValueReference(int pos) {
+#if NUMBER_OF_STATES>0
+  if (pos < NUMBER_OF_STATES)
+    return vrStatesDerivatives[pos];
+#endif
+#if NUMBER_OF_OUTPUTS>0
+  return vrOutputs[pos - NUMBER_OF_STATES];
+#else
+  return 0;
+#endif
+}
+
+/* result = [A B; C D] * seed by a forward difference, used if one of the
+ * Jacobians is not available. The knowns are restored afterwards and the
+ * model is evaluated again by the next getter. */
+static fmi2Status finiteDifferenceDirectionalDerivative(ModelInstance *comp, fmi2Boolean useOutputs, const fmi2Real *seed, fmi2Real *result) {
+  const int nKnowns = NUMBER_OF_STATES + NUMBER_OF_INPUTS;
+  const int nUnknowns = NUMBER_OF_STATES + (useOutputs ? NUMBER_OF_OUTPUTS : 0);
+  fmi2Real *known = comp->jac_work, *base = comp->jac_work + nKnowns;
+  fmi2Real knownNorm = 0.0, seedNorm = 0.0, h;
+  int needJacobianUpdate = comp->_need_jacobian_update;
+  volatile fmi2Status status = fmi2Error;
+  threadData_t *threadData = comp->threadData;
+  int i;
+
+  for (i = 0; i < nKnowns; i++) {
+    known[i] = getReal(comp, knownValueReference(i));
+    knownNorm = fmax(knownNorm, fabs(known[i]));
+    seedNorm = fmax(seedNorm, fabs(seed[i]));
+  }
+  if (seedNorm == 0.0) {
+    memset(result, 0, nUnknowns*sizeof(fmi2Real));
+    return fmi2OK;
+  }
+  h = sqrt(DBL_EPSILON) * fmax(knownNorm, 1.0) / seedNorm;
+
+  /* try */
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+    if (useOutputs)
+      updateAlgebraics(comp);
+    else
+      updateODE(comp);
+    for (i = 0; i < nUnknowns; i++)
+      base[i] = getReal(comp, unknownValueReference(i));
+
+    for (i = 0; i < nKnowns; i++)
+      setReal(comp, knownValueReference(i), known[i] + h*seed[i]);
+    invalidateModel(comp);
+    if (useOutputs)
+      updateAlgebraics(comp);
+    else
+      updateODE(comp);
+    for (i = 0; i < nUnknowns; i++)
+      result[i] = (getReal(comp, unknownValueReference(i)) - base[i]) / h;
+    status = fmi2OK;
+  /* catch */
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+
+  for (i = 0; i < nKnowns; i++)
+    setReal(comp, knownValueReference(i), known[i]);
+  invalidateModel(comp);
+  /* the cached Jacobians still belong to the restored knowns */
+  comp->_need_jacobian_update = needJacobianUpdate;
+  return status;
+}
+
+/* result += J(:,col) * value from the cached nonzeros */
+static void addDirectionalDerivativeColumn(ModelInstance *comp, DirectionalDerivativeJacobian *jac, int col, fmi2Real value, fmi2Real *result) {
+  const SPARSE_PATTERN *pattern = &(comp->fmuData->simulationInfo->analyticJacobians[jac->index].sparsePattern);
+  unsigned int i;
+
+  for (i = (col == 0) ? 0 : pattern->leadindex[col-1]; i < pattern->leadindex[col]; i++)
+    result[jac->rowOffset + pattern->index[i]] += jac->values[i] * value;
+}
+
 // ---------------------------------------------------------------------------
 // Private helpers functions
 // ---------------------------------------------------------------------------
@@ -170,6 +433,10 @@ fmi2Status fmi2EventUpdate(fmi2Component c, fmi2EventInfo* eventInfo)
     }
 
     comp->fmuData->callback->functionDAE(comp->fmuData, comp->threadData);
+    /* functionDAE evaluates all equations */
+    comp->_need_update = 0;
+    comp->_need_update_algebraics = 0;
+    comp->_need_jacobian_update = 1;
 
     /* deactivate sample events */
     for(i=0; i<comp->fmuData->modelData->nSamples; ++i)
@@ -231,7 +498,7 @@ fmi2Status fmi2EventUpdate(fmi2Component c, fmi2EventInfo* eventInfo)
   MMC_CATCH_INTERNAL(simulationJumpBuffer)
 
   FILTERED_LOG(comp, fmi2Error, LOG_FMI2_CALL, "fmi2EventUpdate: terminated by an assertion.")
-  comp->_need_update = 1;
+  invalidateModel(comp);
   return fmi2Error;
 }
 
@@ -287,9 +554,86 @@ fmi2Status fmi2SetDebugLogging(fmi2Component c, fmi2Boolean loggingOn, size_t nC
   return fmi2OK;
 }
 
+#define FMU_STRINGIFY2(x) #x
+#define FMU_STRINGIFY(x) FMU_STRINGIFY2(x)
+
+/* Reads the co-simulation solver from the entry "s" of
+ * <fmuResourceLocation>/<modelIdentifier>_flags.json, e.g. {"s": "rk23"}.
+ * Without the file the solver is explicit Euler.
+ */
+static fmi2Status readCoSimulationFlags(ModelInstance* comp, fmi2String fmuResourceLocation)
+{
+  static const char *solverNames[] = {"euler", "rk23", "impeuler"};
+  const char *dir = fmuResourceLocation, *fileName = FMU_STRINGIFY(MODEL_IDENTIFIER) "_flags.json";
+  char *path, *buffer = NULL;
+  FILE *file;
+  long size;
+  cJSON *root, *item;
+  fmi2Status status = fmi2OK;
+  int i;
+
+  comp->solver = fmi2CoSimulationEuler;
+  if (!dir)
+    return fmi2OK;
+  /* file:///path, file://localhost/path or file:/path */
+  if (!strncmp(dir, "file://localhost/", 17))
+    dir += 16;
+  else if (!strncmp(dir, "file://", 7))
+    dir += 7;
+  else if (!strncmp(dir, "file:", 5))
+    dir += 5;
+#if defined(_WIN32)
+  /* /C:/path */
+  if (dir[0] == '/' && dir[1] && dir[2] == ':')
+    dir++;
+#endif
+  path = (char*)comp->functions->allocateMemory(strlen(dir) + strlen(fileName) + 2, sizeof(char));
+  if (!path)
+    return fmi2Error;
+  sprintf(path, "%s/%s", dir, fileName);
+  file = fopen(path, "rb");
+  comp->functions->freeMemory(path);
+  if (!file)
+    return fmi2OK;
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size >= 0)
+    buffer = (char*)comp->functions->allocateMemory(size + 1, sizeof(char));
+  if (!buffer || fread(buffer, 1, size, file) != (size_t)size) {
+    fclose(file);
+    if (buffer) comp->functions->freeMemory(buffer);
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2Instantiate: could not read %s.", fileName)
+    return fmi2Error;
+  }
+  fclose(file);
+  buffer[size] = '\0';
+  root = cJSON_Parse(buffer);
+  comp->functions->freeMemory(buffer);
+  if (!root) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2Instantiate: %s is no valid JSON.", fileName)
+    return fmi2Error;
+  }
+  item = cJSON_GetObjectItem(root, "s");
+  if (item) {
+    status = fmi2Error;
+    for (i = 0; i < sizeof(solverNames)/sizeof(solverNames[0]); i++) {
+      if (item->type == cJSON_String && !strcmp(item->valuestring, solverNames[i])) {
+        comp->solver = (CoSimulationSolver)i;
+        status = fmi2OK;
+      }
+    }
+    if (status != fmi2OK) {
+      FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2Instantiate: unknown co-simulation solver in %s, expected euler, rk23 or impeuler.", fileName)
+    }
+  }
+  cJSON_Delete(root);
+  return status;
+}
+
 fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2String fmuGUID, fmi2String fmuResourceLocation, const fmi2CallbackFunctions* functions,
     fmi2Boolean visible, fmi2Boolean loggingOn) {
-  // ignoring arguments: fmuResourceLocation, visible
+  // ignoring arguments: visible
   ModelInstance *comp;
   if (!functions->logger) {
     return NULL;
@@ -352,6 +696,10 @@ fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2Str
   comp->componentEnvironment = functions->componentEnvironment;
   comp->loggingOn = loggingOn;
   comp->state = modelInstantiated;
+  if (fmuType == fmi2CoSimulation && readCoSimulationFlags(comp, fmuResourceLocation) != fmi2OK) {
+    fmi2FreeInstance(comp);
+    return NULL;
+  }
   /* intialize modelData */
   fmu2_model_interface_setupDataStruc(comp->fmuData);
   useStream[LOG_STDOUT] = 1;
@@ -377,10 +725,8 @@ fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2Str
   /* allocate memory for state selection */
   initializeStateSetJacobians(comp->fmuData, comp->threadData);
 
-#ifdef FMU_EXPERIMENTAL
-  /* allocate memory for Jacobian */
-  comp->_has_jacobian = !comp->fmuData->callback->initialAnalyticJacobianA(comp->fmuData, comp->threadData);
-#endif
+  /* allocate memory for the directional derivatives */
+  initializeDirectionalDerivatives(comp);
 
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2Instantiate: GUID=%s", fmuGUID)
   return comp;
@@ -388,11 +734,32 @@ fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2Str
 
 void fmi2FreeInstance(fmi2Component c) {
   ModelInstance *comp = (ModelInstance *)c;
+  int i;
   if (!comp) return;
   if (invalidState(comp, "fmi2FreeInstance", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
     return;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2FreeInstance")
 
+  /* free co-simulation work arrays */
+  if (comp->states) {
+    comp->functions->freeMemory(comp->states);
+    comp->functions->freeMemory(comp->states_der);
+    comp->functions->freeMemory(comp->event_indicators);
+    comp->functions->freeMemory(comp->event_indicators_prev);
+    comp->functions->freeMemory(comp->rk_work);
+  }
+  if (comp->ie_jacobian) comp->functions->freeMemory(comp->ie_jacobian);
+  if (comp->ie_pivot) comp->functions->freeMemory(comp->ie_pivot);
+
+  /* free directional derivatives */
+  for (i = 0; i < 4; i++)
+    if (comp->jacobians[i].values) comp->functions->freeMemory(comp->jacobians[i].values);
+  if (comp->jac_known) comp->functions->freeMemory(comp->jac_known);
+  if (comp->jac_unknown) comp->functions->freeMemory(comp->jac_unknown);
+  if (comp->jac_seed) comp->functions->freeMemory(comp->jac_seed);
+  if (comp->jac_result) comp->functions->freeMemory(comp->jac_result);
+  if (comp->jac_work) comp->functions->freeMemory(comp->jac_work);
+
   /* free simuation data */
   comp->functions->freeMemory(comp->fmuData->modelData);
   comp->functions->freeMemory(comp->fmuData->simulationInfo);
@@ -419,6 +786,32 @@ fmi2Status fmi2SetupExperiment(fmi2Component c, fmi2Boolean toleranceDefined, fm
   comp->startTime = startTime;
   comp->stopTimeDefined = stopTimeDefined;
   comp->stopTime = stopTime;
+
+  if (comp->type == fmi2CoSimulation) {
+    comp->stepSize = 0;
+    /* fmi2DoStep must not allocate; the arrays are kept over fmi2Reset */
+    if (!comp->states) {
+      const fmi2CallbackFunctions* functions = comp->functions;
+      comp->states = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES+1, sizeof(fmi2Real));
+      comp->states_der = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES+1, sizeof(fmi2Real));
+      comp->event_indicators = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS+1, sizeof(fmi2Real));
+      comp->event_indicators_prev = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS+1, sizeof(fmi2Real));
+      /* stages k2, k3, k4 and the new states of the RK23 step */
+      comp->rk_work = (fmi2Real*)functions->allocateMemory(4*NUMBER_OF_STATES+1, sizeof(fmi2Real));
+      if (!comp->states || !comp->states_der || !comp->event_indicators || !comp->event_indicators_prev || !comp->rk_work) {
+        FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2SetupExperiment: Out of memory.")
+        return fmi2Error;
+      }
+    }
+    if (comp->solver == fmi2CoSimulationImplicitEuler && !comp->ie_jacobian) {
+      comp->ie_jacobian = (fmi2Real*)comp->functions->allocateMemory(NUMBER_OF_STATES*NUMBER_OF_STATES+1, sizeof(fmi2Real));
+      comp->ie_pivot = (int*)comp->functions->allocateMemory(NUMBER_OF_STATES+1, sizeof(int));
+      if (!comp->ie_jacobian || !comp->ie_pivot) {
+        FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2SetupExperiment: Out of memory.")
+        return fmi2Error;
+      }
+    }
+  }
   return fmi2OK;
 }
 
@@ -454,6 +847,9 @@ fmi2Status fmi2EnterInitializationMode(fmi2Component c) {
 
       /* due to an event overwrite old values */
       overwriteOldSimulationData(comp->fmuData);
+      comp->_need_update = 0;
+      comp->_need_update_algebraics = 0;
+      comp->_need_jacobian_update = 1;
 
       comp->eventInfo.terminateSimulation = fmi2False;
       comp->eventInfo.valuesOfContinuousStatesChanged = fmi2True;
@@ -528,11 +924,13 @@ fmi2Status fmi2Reset(fmi2Component c) {
     /* intialize modelData */
     fmu2_model_interface_setupDataStruc(comp->fmuData);
     initializeDataStruc(comp->fmuData, comp->threadData);
+    initializeDirectionalDerivatives(comp);
   }
   /* reset the values to start */
   setDefaultStartValues(comp);
   setAllVarsToStart(comp->fmuData);
   setAllParamsToStart(comp->fmuData);
+  invalidateModel(comp);
 
   comp->state = modelInstantiated;
   return fmi2OK;
@@ -541,6 +939,7 @@ fmi2Status fmi2Reset(fmi2Component c) {
 fmi2Status fmi2GetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Real value[]) {
   int i;
   ModelInstance *comp = (ModelInstance *)c;
+  threadData_t *threadData = comp->threadData;
   if (invalidState(comp, "fmi2GetReal", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
     return fmi2Error;
   if (nvr > 0 && nullPointer(comp, "fmi2GetReal", "vr[]", vr))
@@ -551,11 +950,35 @@ fmi2Status fmi2GetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nv
   for (i = 0; i < nvr; i++) {
     if (vrOutOfRange(comp, "fmi2GetReal", vr[i], NUMBER_OF_REALS))
       return fmi2Error;
-    value[i] = getReal(comp, vr[i]); // to be implemented by the includer of this file
-    FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetReal: #r%u# = %.16g", vr[i], value[i])
   }
-#endif
+
+  /* try */
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+
+    /* during initialization all values come from the initial system */
+    if (comp->state & (modelEventMode|modelContinuousTimeMode)) {
+      for (i = 0; i < nvr && (comp->_need_update || comp->_need_update_algebraics); i++) {
+        if (needsAlgebraics(comp, vr[i]))
+          updateAlgebraics(comp);
+        else if (vr[i] >= NUMBER_OF_STATES && vr[i] < 2*NUMBER_OF_STATES)
+          updateODE(comp);
+      }
+    }
+
+    for (i = 0; i < nvr; i++) {
+      value[i] = getReal(comp, vr[i]); // to be implemented by the includer of this file
+      FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetReal: #r%u# = %.16g", vr[i], value[i])
+    }
+    return fmi2OK;
+
+  /* catch */
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+
+  FILTERED_LOG(comp, fmi2Error, LOG_FMI2_CALL, "fmi2GetReal: terminated by an assertion.")
+  return fmi2Error;
+#else
   return fmi2OK;
+#endif
 }
 
 fmi2Status fmi2GetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Integer value[]) {
@@ -613,7 +1036,7 @@ fmi2Status fmi2GetString(fmi2Component c, const fmi2ValueReference vr[], size_t
 }
 
 fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Real value[]) {
-  int i;
+  int i, changed = 0;
   ModelInstance *comp = (ModelInstance *)c;
   if (invalidState(comp, "fmi2SetReal", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode))
     return fmi2Error;
@@ -627,15 +1050,20 @@ fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nv
     if (vrOutOfRange(comp, "fmi2SetReal", vr[i], NUMBER_OF_REALS+NUMBER_OF_STATES))
       return fmi2Error;
     FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetReal: #r%d# = %.16g", vr[i], value[i])
+    /* re-setting the same value keeps the model up to date */
+    if (vr[i] < NUMBER_OF_REALS && getReal(comp, vr[i]) == value[i])
+      continue;
     if (setReal(comp, vr[i], value[i]) != fmi2OK) // to be implemented by the includer of this file
       return fmi2Error;
+    changed = 1;
   }
-  comp->_need_update = 1;
+  if (changed)
+    invalidateModel(comp);
   return fmi2OK;
 }
 
 fmi2Status fmi2SetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer value[]) {
-  int i;
+  int i, changed = 0;
   ModelInstance *comp = (ModelInstance *)c;
   if (invalidState(comp, "fmi2SetInteger", modelInstantiated|modelInitializationMode|modelEventMode))
     return fmi2Error;
@@ -649,15 +1077,19 @@ fmi2Status fmi2SetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t
     if (vrOutOfRange(comp, "fmi2SetInteger", vr[i], NUMBER_OF_INTEGERS))
       return fmi2Error;
     FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetInteger: #i%d# = %d", vr[i], value[i])
+    if (getInteger(comp, vr[i]) == value[i])
+      continue;
     if (setInteger(comp, vr[i], value[i]) != fmi2OK) // to be implemented by the includer of this file
       return fmi2Error;
+    changed = 1;
   }
-  comp->_need_update = 1;
+  if (changed)
+    invalidateModel(comp);
   return fmi2OK;
 }
 
 fmi2Status fmi2SetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Boolean value[]) {
-  int i;
+  int i, changed = 0;
   ModelInstance *comp = (ModelInstance *)c;
   if (invalidState(comp, "fmi2SetBoolean", modelInstantiated|modelInitializationMode|modelEventMode))
     return fmi2Error;
@@ -671,10 +1103,14 @@ fmi2Status fmi2SetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t
     if (vrOutOfRange(comp, "fmi2SetBoolean", vr[i], NUMBER_OF_BOOLEANS))
       return fmi2Error;
     FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetBoolean: #b%d# = %s", vr[i], value[i] ? "true" : "false")
+    if (!getBoolean(comp, vr[i]) == !value[i])
+      continue;
     if (setBoolean(comp, vr[i], value[i]) != fmi2OK) // to be implemented by the includer of this file
       return fmi2Error;
+    changed = 1;
   }
-  comp->_need_update = 1;
+  if (changed)
+    invalidateModel(comp);
   return fmi2OK;
 }
 
@@ -697,69 +1133,336 @@ fmi2Status fmi2SetString(fmi2Component c, const fmi2ValueReference vr[], size_t
     if (setString(comp, vr[i], value[i]) != fmi2OK) // to be implemented by the includer of this file
       return fmi2Error;
   }
-  comp->_need_update = 1;
+  invalidateModel(comp);
   return fmi2OK;
 }
 
+/* The FMU state is the checkpoint image of the model (see checkpoint.h)
+ * together with the part of the instance that lives outside of DATA.
+ * Serialized, the header is followed by the co-simulation event indicators
+ * and the image. The state and its image are allocated with the memory
+ * callbacks of the environment.
+ */
+#define FMU_STATE_MAGIC 0x4f4d4332 /* "OMC2" */
+
+typedef struct {
+  unsigned int magic;
+  ModelState state;
+  fmi2EventInfo eventInfo;
+  fmi2Real stepSize;
+  size_t nEventIndicators;
+  size_t imageSize;
+} ModelInstanceStateHeader;
+
+typedef struct {
+  ModelInstanceStateHeader header;
+  fmi2Real eventIndicators[NUMBER_OF_EVENT_INDICATORS+1];
+  CHECKPOINT_BUFFER image;
+} ModelInstanceState;
+
 fmi2Status fmi2GetFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
-  return unsupportedFunction(c, "fmi2GetFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  ModelInstanceState *s;
+  if (invalidState(comp, "fmi2GetFMUstate", modelInitializationMode|modelEventMode|modelContinuousTimeMode))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2GetFMUstate", "FMUstate", FMUstate))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetFMUstate")
+
+  /* an existing state is overwritten and keeps its buffer */
+  s = (ModelInstanceState*) *FMUstate;
+  if (!s) {
+    s = (ModelInstanceState*) comp->functions->allocateMemory(1, sizeof(ModelInstanceState));
+    if (!s) {
+      FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2GetFMUstate: Out of memory.")
+      return fmi2Error;
+    }
+  }
+  s->image.size = 0;
+  s->image.pos = 0;
+  s->image.error = 0;
+  s->image.allocateMemory = comp->functions->allocateMemory;
+  s->image.freeMemory = comp->functions->freeMemory;
+  if (checkpointSerialize(comp->fmuData, NULL, &s->image) || s->image.error) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2GetFMUstate: Out of memory.")
+    if (!*FMUstate) {
+      if (s->image.data) comp->functions->freeMemory(s->image.data);
+      comp->functions->freeMemory(s);
+    }
+    return fmi2Error;
+  }
+  s->header.magic = FMU_STATE_MAGIC;
+  s->header.state = comp->state;
+  s->header.eventInfo = comp->eventInfo;
+  s->header.stepSize = comp->stepSize;
+  s->header.nEventIndicators = NUMBER_OF_EVENT_INDICATORS;
+  s->header.imageSize = s->image.size;
+  if (comp->event_indicators_prev) {
+    memcpy(s->eventIndicators, comp->event_indicators_prev, NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real));
+  }
+  *FMUstate = (fmi2FMUstate) s;
+  return fmi2OK;
 }
 
 fmi2Status fmi2SetFMUstate(fmi2Component c, fmi2FMUstate FMUstate) {
-  return unsupportedFunction(c, "fmi2SetFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  threadData_t *threadData = comp->threadData;
+  ModelInstanceState *s = (ModelInstanceState*) FMUstate;
+  if (invalidState(comp, "fmi2SetFMUstate", modelInitializationMode|modelEventMode|modelContinuousTimeMode))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2SetFMUstate", "FMUstate", FMUstate))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetFMUstate")
+
+  /* the whole state is checked before the instance is changed, the image by checkpointDeserialize */
+  if (s->header.magic != FMU_STATE_MAGIC || s->header.nEventIndicators != NUMBER_OF_EVENT_INDICATORS ||
+      s->header.imageSize != s->image.size) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2SetFMUstate: The state is corrupt or does not belong to this model.")
+    return fmi2Error;
+  }
+
+  /* try */
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+
+    if (checkpointDeserialize(comp->fmuData, comp->threadData, NULL, s->image.data, s->image.size)) {
+      FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2SetFMUstate: The state is corrupt or does not belong to this model.")
+      return fmi2Error;
+    }
+    comp->state = s->header.state;
+    comp->eventInfo = s->header.eventInfo;
+    comp->stepSize = s->header.stepSize;
+    if (comp->event_indicators_prev) {
+      memcpy(comp->event_indicators_prev, s->eventIndicators, NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real));
+    }
+    invalidateModel(comp);
+    return fmi2OK;
+
+  /* catch */
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+
+  FILTERED_LOG(comp, fmi2Error, LOG_FMI2_CALL, "fmi2SetFMUstate: terminated by an assertion.")
+  return fmi2Error;
 }
 
 fmi2Status fmi2FreeFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
-  return unsupportedFunction(c, "fmi2FreeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  ModelInstanceState *s;
+  if (invalidState(comp, "fmi2FreeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2FreeFMUstate", "FMUstate", FMUstate))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2FreeFMUstate")
+
+  s = (ModelInstanceState*) *FMUstate;
+  if (s) {
+    if (s->image.data) comp->functions->freeMemory(s->image.data);
+    comp->functions->freeMemory(s);
+    *FMUstate = NULL;
+  }
+  return fmi2OK;
 }
 
 fmi2Status fmi2SerializedFMUstateSize(fmi2Component c, fmi2FMUstate FMUstate, size_t *size) {
-  return unsupportedFunction(c, "fmi2SerializedFMUstateSize", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  ModelInstanceState *s = (ModelInstanceState*) FMUstate;
+  if (invalidState(comp, "fmi2SerializedFMUstateSize", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2SerializedFMUstateSize", "FMUstate", FMUstate) || nullPointer(comp, "fmi2SerializedFMUstateSize", "size", size))
+    return fmi2Error;
+
+  *size = sizeof(ModelInstanceStateHeader) + NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real) + s->image.size;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SerializedFMUstateSize: %lu bytes", (unsigned long) *size)
+  return fmi2OK;
 }
 
 fmi2Status fmi2SerializeFMUstate(fmi2Component c, fmi2FMUstate FMUstate, fmi2Byte serializedState[], size_t size) {
-  return unsupportedFunction(c, "fmi2SerializeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  ModelInstanceState *s = (ModelInstanceState*) FMUstate;
+  size_t required;
+  if (invalidState(comp, "fmi2SerializeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2SerializeFMUstate", "FMUstate", FMUstate) || nullPointer(comp, "fmi2SerializeFMUstate", "serializedState", serializedState))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SerializeFMUstate")
+
+  required = sizeof(ModelInstanceStateHeader) + NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real) + s->image.size;
+  if (size < required) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2SerializeFMUstate: Invalid argument size = %lu. Expected %lu.", (unsigned long) size, (unsigned long) required)
+    return fmi2Error;
+  }
+  memcpy(serializedState, &s->header, sizeof(ModelInstanceStateHeader));
+  serializedState += sizeof(ModelInstanceStateHeader);
+  memcpy(serializedState, s->eventIndicators, NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real));
+  serializedState += NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real);
+  memcpy(serializedState, s->image.data, s->image.size);
+  return fmi2OK;
 }
 
 fmi2Status fmi2DeSerializeFMUstate(fmi2Component c, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* FMUstate) {
-  return unsupportedFunction(c, "fmi2DeSerializeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
+  ModelInstance *comp = (ModelInstance *)c;
+  ModelInstanceState *s;
+  ModelInstanceStateHeader header;
+  if (invalidState(comp, "fmi2DeSerializeFMUstate", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2DeSerializeFMUstate", "serializedState", serializedState) || nullPointer(comp, "fmi2DeSerializeFMUstate", "FMUstate", FMUstate))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2DeSerializeFMUstate")
+
+  if (size >= sizeof(ModelInstanceStateHeader)) {
+    memcpy(&header, serializedState, sizeof(ModelInstanceStateHeader));
+  }
+  if (size < sizeof(ModelInstanceStateHeader) || header.magic != FMU_STATE_MAGIC || header.nEventIndicators != NUMBER_OF_EVENT_INDICATORS ||
+      size != sizeof(ModelInstanceStateHeader) + NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real) + header.imageSize) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2DeSerializeFMUstate: The serialized state is corrupt or was written by another model.")
+    return fmi2Error;
+  }
+  if (checkpointValidate(comp->fmuData, NULL, serializedState + size - header.imageSize, header.imageSize)) {
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2DeSerializeFMUstate: The serialized state is corrupt or was written by another model.")
+    return fmi2Error;
+  }
+
+  s = (ModelInstanceState*) comp->functions->allocateMemory(1, sizeof(ModelInstanceState));
+  if (s) {
+    s->image.data = (char*) comp->functions->allocateMemory(header.imageSize ? header.imageSize : 1, 1);
+  }
+  if (!s || !s->image.data) {
+    if (s) comp->functions->freeMemory(s);
+    FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2DeSerializeFMUstate: Out of memory.")
+    return fmi2Error;
+  }
+  s->header = header;
+  serializedState += sizeof(ModelInstanceStateHeader);
+  memcpy(s->eventIndicators, serializedState, NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real));
+  serializedState += NUMBER_OF_EVENT_INDICATORS*sizeof(fmi2Real);
+  memcpy(s->image.data, serializedState, header.imageSize);
+  s->image.size = header.imageSize;
+  s->image.capacity = header.imageSize;
+  s->image.allocateMemory = comp->functions->allocateMemory;
+  s->image.freeMemory = comp->functions->freeMemory;
+  *FMUstate = (fmi2FMUstate) s;
+  return fmi2OK;
 }
 
+/*!
+ * Returns dvUnknown = d(unknowns)/d(knowns) * dvKnown with the knowns being
+ * states or inputs and the unknowns being derivatives or outputs.
+ *
+ * A single direction (nKnown == 1, e.g. a unit vector when an importer builds
+ * the Jacobian column by column) computes the involved Jacobians once per
+ * model state with maxColors column evaluations each; the following columns
+ * are served from that cache. A general direction on a stale cache costs one
+ * column evaluation per involved Jacobian. If one of the involved Jacobians is
+ * not available, the directional derivative is a forward difference.
+ */
 fmi2Status fmi2GetDirectionalDerivative(fmi2Component c, const fmi2ValueReference vUnknown_ref[], size_t nUnknown, const fmi2ValueReference vKnown_ref[] , size_t nKnown,
     const fmi2Real dvKnown[], fmi2Real dvUnknown[]) {
-#ifndef FMU_EXPERIMENTAL
+#ifdef FMU_DISABLE_DIRECTIONAL_DERIVATIVES
   return unsupportedFunction(c, "fmi2GetDirectionalDerivative", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
 #else
-  int i,j;
+  size_t i;
+  int k, pos;
+  fmi2Boolean useKnowns[2] = {fmi2False, fmi2False};    /* x, u */
+  fmi2Boolean useUnknowns[2] = {fmi2False, fmi2False};  /* der(x), y */
+  fmi2Boolean useJacobian[4], cached = fmi2True, finiteDifferences = fmi2False;
   ModelInstance *comp = (ModelInstance *)c;
-  if (invalidState(comp, "fmi2GetDirectionalDerivative", modelInstantiated|modelEventMode|modelContinuousTimeMode))
+  threadData_t *threadData = comp->threadData;
+  if (invalidState(comp, "fmi2GetDirectionalDerivative", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError))
+    return fmi2Error;
+  if (nKnown > 0 && (nullPointer(comp, "fmi2GetDirectionalDerivative", "vKnown_ref[]", vKnown_ref) || nullPointer(comp, "fmi2GetDirectionalDerivative", "dvKnown[]", dvKnown)))
+    return fmi2Error;
+  if (nUnknown > 0 && (nullPointer(comp, "fmi2GetDirectionalDerivative", "vUnknown_ref[]", vUnknown_ref) || nullPointer(comp, "fmi2GetDirectionalDerivative", "dvUnknown[]", dvUnknown)))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2GetDirectionalDerivative", "jacobian", comp->jac_result) || nullPointer(comp, "fmi2GetDirectionalDerivative", "jacobian", comp->jac_work))
     return fmi2Error;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetDirectionalDerivative")
-  if (!comp->_has_jacobian)
-    return unsupportedFunction(c, "fmi2GetDirectionalDerivative", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError);
-  /***************************************/
-#if NUMBER_OF_STATES>0
-  // This code assumes that the FMU variables are always sorted,
-  // states first and then derivatives.
-  // This is true for the actual OMC FMUs.
-  // Anyway we'll check that the references are in the valid range
+
+  for (i = 0; i < nKnown; i++) {
+    if (vKnown_ref[i] >= NUMBER_OF_REALS || comp->jac_known[vKnown_ref[i]] < 0) {
+      FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2GetDirectionalDerivative: #r%u# is neither a state nor an input.", vKnown_ref[i])
+      return fmi2Error;
+    }
+    useKnowns[comp->jac_known[vKnown_ref[i]] >= NUMBER_OF_STATES] = fmi2True;
+  }
   for (i = 0; i < nUnknown; i++) {
-    if (vUnknown_ref[i]>=NUMBER_OF_STATES)
-        // We are only computing the A part of the Jacobian for now
-        // so unknowns can only be states
-        return fmi2Error;
+    if (vUnknown_ref[i] >= NUMBER_OF_REALS || comp->jac_unknown[vUnknown_ref[i]] < 0) {
+      FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2GetDirectionalDerivative: #r%u# is neither a state derivative nor an output.", vUnknown_ref[i])
+      return fmi2Error;
+    }
+    useUnknowns[comp->jac_unknown[vUnknown_ref[i]] >= NUMBER_OF_STATES] = fmi2True;
   }
-  for (i = 0; i < nKnown; i++) {
-    if (vKnown_ref[i]>=2*NUMBER_OF_STATES) {
-        // We are only computing the A part of the Jacobian for now
-        // so knowns can only be states derivatives
-        return fmi2Error;
+
+  if (comp->_need_jacobian_update) {
+    for (k = 0; k < 4; k++)
+      comp->jacobians[k].valid = fmi2False;
+    comp->_need_jacobian_update = 0;
+  }
+  for (k = 0; k < 4; k++) {
+    useJacobian[k] = useUnknowns[k/2] && useKnowns[k%2];
+    if (useJacobian[k] && !comp->jacobians[k].available)
+      finiteDifferences = fmi2True;
+    if (useJacobian[k] && !comp->jacobians[k].valid)
+      cached = fmi2False;
+  }
+
+  if (finiteDifferences) {
+    memset(comp->jac_seed, 0, (NUMBER_OF_STATES+NUMBER_OF_INPUTS)*sizeof(fmi2Real));
+    for (i = 0; i < nKnown; i++)
+      comp->jac_seed[comp->jac_known[vKnown_ref[i]]] += dvKnown[i];
+    if (finiteDifferenceDirectionalDerivative(comp, useUnknowns[1], comp->jac_seed, comp->jac_result) != fmi2OK) {
+      FILTERED_LOG(comp, fmi2Error, LOG_FMI2_CALL, "fmi2GetDirectionalDerivative: terminated by an assertion.")
+      return fmi2Error;
+    }
+    for (i = 0; i < nUnknown; i++) {
+      dvUnknown[i] = comp->jac_result[comp->jac_unknown[vUnknown_ref[i]]];
+      FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetDirectionalDerivative: #r%u# = %.16g", vUnknown_ref[i], dvUnknown[i])
     }
+    return fmi2OK;
   }
-  comp->fmuData->callback->functionFMIJacobian(comp->fmuData, comp->threadData, vUnknown_ref, nUnknown, vKnown_ref, nKnown, (double*)dvKnown, dvUnknown);
-#endif
-  /***************************************/
-  return fmi2OK;
+
+  /* try */
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+
+    if (!cached) {
+      /* the Jacobians are evaluated at the current values of all variables */
+      if (useUnknowns[1])
+        updateAlgebraics(comp);
+      else
+        updateODE(comp);
+    }
+
+    for (i = 0; i < nUnknown; i++)
+      comp->jac_result[comp->jac_unknown[vUnknown_ref[i]]] = 0.0;
+
+    if (cached || nKnown == 1) {
+      for (k = 0; k < 4; k++)
+        if (useJacobian[k] && !comp->jacobians[k].valid)
+          updateDirectionalDerivativeJacobian(comp, &comp->jacobians[k]);
+      for (i = 0; i < nKnown; i++) {
+        pos = comp->jac_known[vKnown_ref[i]];
+        for (k = (pos >= NUMBER_OF_STATES); k < 4; k += 2)
+          if (useJacobian[k])
+            addDirectionalDerivativeColumn(comp, &comp->jacobians[k], pos - comp->jacobians[k].colOffset, dvKnown[i], comp->jac_result);
+      }
+    } else {
+      memset(comp->jac_seed, 0, (NUMBER_OF_STATES+NUMBER_OF_INPUTS)*sizeof(fmi2Real));
+      for (i = 0; i < nKnown; i++)
+        comp->jac_seed[comp->jac_known[vKnown_ref[i]]] += dvKnown[i];
+      for (k = 0; k < 4; k++)
+        if (useJacobian[k])
+          seedDirectionalDerivativeJacobian(comp, &comp->jacobians[k], comp->jac_seed, comp->jac_result);
+    }
+
+    for (i = 0; i < nUnknown; i++) {
+      dvUnknown[i] = comp->jac_result[comp->jac_unknown[vUnknown_ref[i]]];
+      FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2GetDirectionalDerivative: #r%u# = %.16g", vUnknown_ref[i], dvUnknown[i])
+    }
+    return fmi2OK;
+
+  /* catch */
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+
+  FILTERED_LOG(comp, fmi2Error, LOG_FMI2_CALL, "fmi2GetDirectionalDerivative: terminated by an assertion.")
+  return fmi2Error;
 #endif
 }
 
@@ -819,7 +1522,7 @@ fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStat
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
-    comp->fmuData->callback->functionAlgebraics(comp->fmuData, comp->threadData);
+    updateAlgebraics(comp);
     comp->fmuData->callback->output_function(comp->fmuData, comp->threadData);
     comp->fmuData->callback->function_storeDelayed(comp->fmuData, comp->threadData);
     storePreValues(comp->fmuData);
@@ -830,6 +1533,7 @@ fmi2Status fmi2CompletedIntegratorStep(fmi2Component c, fmi2Boolean noSetFMUStat
     {
       /* if new set is calculated reinit the solver */
       *enterEventMode = fmi2True;
+      invalidateModel(comp);
       FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL,"fmi2CompletedIntegratorStep: Need to iterate state values changed!")
     }
     /* TODO: fix the extrapolation in non-linear system
@@ -850,14 +1554,16 @@ fmi2Status fmi2SetTime(fmi2Component c, fmi2Real t) {
   if (invalidState(comp, "fmi2SetTime", modelInstantiated|modelEventMode|modelContinuousTimeMode))
     return fmi2Error;
   FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetTime: time=%.16g", t)
-  comp->fmuData->localData[0]->timeValue = t;
-  comp->_need_update = 1;
+  if (comp->fmuData->localData[0]->timeValue != t) {
+    comp->fmuData->localData[0]->timeValue = t;
+    invalidateModel(comp);
+  }
   return fmi2OK;
 }
 
 fmi2Status fmi2SetContinuousStates(fmi2Component c, const fmi2Real x[], size_t nx) {
   ModelInstance *comp = (ModelInstance *)c;
-  int i;
+  int i, changed = 0;
   /* According to FMI RC2 specification fmi2SetContinuousStates should only be allowed in Continuous-Time Mode.
    * The following code is done only to make the FMUs compatible with Dymola because Dymola is trying to call fmi2SetContinuousStates after fmi2EnterInitializationMode.
    */
@@ -872,12 +1578,19 @@ fmi2Status fmi2SetContinuousStates(fmi2Component c, const fmi2Real x[], size_t n
   for (i = 0; i < nx; i++) {
     fmi2ValueReference vr = vrStates[i];
     FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2SetContinuousStates: #r%d# = %.16g", vr, x[i])
-    if (vr < 0 || vr >= NUMBER_OF_REALS|| setReal(comp, vr, x[i]) != fmi2OK) { // to be implemented by the includer of this file
+    if (vr < 0 || vr >= NUMBER_OF_REALS) {
+      return fmi2Error;
+    }
+    if (getReal(comp, vr) == x[i])
+      continue;
+    if (setReal(comp, vr, x[i]) != fmi2OK) { // to be implemented by the includer of this file
       return fmi2Error;
     }
+    changed = 1;
   }
 #endif
-  comp->_need_update = 1;
+  if (changed)
+    invalidateModel(comp);
   return fmi2OK;
 }
 
@@ -895,11 +1608,7 @@ fmi2Status fmi2GetDerivatives(fmi2Component c, fmi2Real derivatives[], size_t nx
   /* try */
   MMC_TRY_INTERNAL(simulationJumpBuffer)
 
-    if (comp->_need_update){
-      comp->fmuData->callback->functionODE(comp->fmuData, comp->threadData);
-      overwriteOldSimulationData(comp->fmuData);
-      comp->_need_update = 0;
-    }
+    updateODE(comp);
 
 #if NUMBER_OF_STATES>0
     for (i = 0; i < nx; i++) {
@@ -935,10 +1644,7 @@ fmi2Status fmi2GetEventIndicators(fmi2Component c, fmi2Real eventIndicators[], s
 
 #if NUMBER_OF_EVENT_INDICATORS>0
     /* eval needed equations*/
-    if (comp->_need_update){
-      comp->fmuData->callback->functionODE(comp->fmuData, comp->threadData);
-      comp->_need_update = 0;
-    }
+    updateODE(comp);
     comp->fmuData->callback->function_ZeroCrossings(comp->fmuData, comp->threadData, comp->fmuData->simulationInfo->zeroCrossings);
     for (i = 0; i < nx; i++) {
       eventIndicators[i] = comp->fmuData->simulationInfo->zeroCrossings[i];
@@ -1002,65 +1708,305 @@ fmi2Status fmi2GetRealOutputDerivatives (fmi2Component c, const fmi2ValueReferen
   return fmi2OK;
 }
 
-fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
-  ModelInstance *comp = (ModelInstance *)c;
-  fmi2CallbackFunctions* functions = (fmi2CallbackFunctions*)comp->functions;
-  int i, zc_event = 0, time_event = 0;
-  fmi2Status status = fmi2OK;
-  fmi2Real* states = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
-  fmi2Real* states_der = (fmi2Real*)functions->allocateMemory(NUMBER_OF_STATES, sizeof(fmi2Real));
-  fmi2Real* event_indicators = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
-  fmi2Real* event_indicators_prev = (fmi2Real*)functions->allocateMemory(NUMBER_OF_EVENT_INDICATORS, sizeof(fmi2Real));
-  fmi2Real t = comp->fmuData->localData[0]->timeValue;
-  fmi2Real tNext, tEnd;
+static fmi2Boolean zeroCrossed(const fmi2Real* before, const fmi2Real* after)
+{
+  int i;
+  for (i = 0; i < NUMBER_OF_EVENT_INDICATORS; i++) {
+    if (before[i]*after[i] < 0) {
+      return fmi2True;
+    }
+  }
+  return fmi2False;
+}
+
+/* event iteration at the current time, then reads the states, derivatives and event indicators again */
+static fmi2Status doStepEvent(ModelInstance* comp)
+{
+  fmi2Component c = (fmi2Component)comp;
+
+  FILTERED_LOG(comp, fmi2OK, LOG_EVENTS, "fmi2DoStep: event at time %.16g", comp->fmuData->localData[0]->timeValue)
+  if (fmi2EnterEventMode(c) != fmi2OK || fmi2EventIteration(c, &comp->eventInfo) != fmi2OK || fmi2EnterContinuousTimeMode(c) != fmi2OK)
+    return fmi2Error;
+  if (NUMBER_OF_STATES > 0) {
+    if (fmi2GetContinuousStates(c, comp->states, NUMBER_OF_STATES) != fmi2OK || fmi2GetDerivatives(c, comp->states_der, NUMBER_OF_STATES) != fmi2OK)
+      return fmi2Error;
+  }
+  if (NUMBER_OF_EVENT_INDICATORS > 0) {
+    if (fmi2GetEventIndicators(c, comp->event_indicators_prev, NUMBER_OF_EVENT_INDICATORS) != fmi2OK)
+      return fmi2Error;
+  }
+  return fmi2OK;
+}
+
+/* evaluates der(x) at (t, x); the model stays at that point */
+static fmi2Status doStepDerivatives(ModelInstance* comp, fmi2Real t, const fmi2Real* x, fmi2Real* der)
+{
+  fmi2Component c = (fmi2Component)comp;
+  if (fmi2SetTime(c, t) != fmi2OK)
+    return fmi2Error;
+  if (NUMBER_OF_STATES > 0) {
+    if (fmi2SetContinuousStates(c, x, NUMBER_OF_STATES) != fmi2OK || fmi2GetDerivatives(c, der, NUMBER_OF_STATES) != fmi2OK)
+      return fmi2Error;
+  }
+  return fmi2OK;
+}
+
+/* accepts the step to the point the model was last evaluated at; sets *event if an event has to be handled there */
+static fmi2Status doStepCompleted(ModelInstance* comp, fmi2Boolean* event)
+{
+  fmi2Component c = (fmi2Component)comp;
   fmi2Boolean enterEventMode = fmi2False, terminateSimulation = fmi2False;
-  fmi2EventInfo eventInfo;
-  eventInfo.newDiscreteStatesNeeded           = fmi2False;
-  eventInfo.terminateSimulation               = fmi2False;
-  eventInfo.nominalsOfContinuousStatesChanged = fmi2False;
-  eventInfo.valuesOfContinuousStatesChanged   = fmi2True;
-  eventInfo.nextEventTimeDefined              = fmi2False;
-  eventInfo.nextEventTime                     = -0.0;
+  fmi2Real* tmp;
+
+  if (fmi2CompletedIntegratorStep(c, fmi2True, &enterEventMode, &terminateSimulation) != fmi2OK)
+    return fmi2Error;
+  *event = enterEventMode;
+  if (NUMBER_OF_EVENT_INDICATORS > 0) {
+    if (fmi2GetEventIndicators(c, comp->event_indicators, NUMBER_OF_EVENT_INDICATORS) != fmi2OK)
+      return fmi2Error;
+    *event = *event || zeroCrossed(comp->event_indicators_prev, comp->event_indicators);
+    tmp = comp->event_indicators_prev;
+    comp->event_indicators_prev = comp->event_indicators;
+    comp->event_indicators = tmp;
+  }
+  return fmi2OK;
+}
 
-  /* fprintf(stderr, "DoStep %g + %g State: %d\n", currentCommunicationPoint, communicationStepSize, comp->state); */
+/* relative tolerance of the adaptive and implicit solvers */
+static fmi2Real solverTolerance(ModelInstance* comp)
+{
+  return comp->toleranceDefined && comp->tolerance > 0 ? comp->tolerance : 1e-6;
+}
 
-  fmi2EnterEventMode(c);
-  fmi2EventIteration(c, &eventInfo);
-  fmi2EnterContinuousTimeMode(c);
+/* one explicit Euler step to tTarget */
+static fmi2Status doStepEuler(ModelInstance* comp, fmi2Real* t, fmi2Real tTarget, fmi2Boolean* event)
+{
+  int i;
+  fmi2Real h = tTarget - *t;
 
-  if (NUMBER_OF_STATES > 0)
-  {
-    status = fmi2GetDerivatives(c, states_der, NUMBER_OF_STATES);
-    if (status != fmi2OK)
-    {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
+  for (i = 0; i < NUMBER_OF_STATES; i++) {
+    comp->states[i] += h * comp->states_der[i];
+  }
+  *t = tTarget;
+  if (doStepDerivatives(comp, *t, comp->states, comp->states_der) != fmi2OK)
+    return fmi2Error;
+  comp->stepsAccepted++;
+  return doStepCompleted(comp, event);
+}
+
+/* Bogacki-Shampine 3(2) steps to tTarget, or up to the first event. Steps
+ * with a zero crossing are halved until they are shorter than hMin, which
+ * locates the event.
+ */
+static fmi2Status doStepRK23(ModelInstance* comp, fmi2Real* t, fmi2Real tTarget, fmi2Real hMin, fmi2Boolean* event)
+{
+  const int n = NUMBER_OF_STATES;
+  const fmi2Real *k1 = comp->states_der;
+  fmi2Real *k2 = comp->rk_work, *k3 = k2 + n, *k4 = k3 + n, *x = k4 + n;
+  fmi2Real h, hLocate = 0, err, sc, e, tol = solverTolerance(comp);
+  fmi2Boolean locating = fmi2False, last;
+  int i;
+
+  *event = fmi2False;
+  while (*t < tTarget && !*event) {
+    h = fmin(comp->stepSize, tTarget - *t);
+    last = (h >= tTarget - *t);
+
+    for (i = 0; i < n; i++)
+      x[i] = comp->states[i] + 0.5*h*k1[i];
+    if (doStepDerivatives(comp, *t + 0.5*h, x, k2) != fmi2OK)
+      return fmi2Error;
+    for (i = 0; i < n; i++)
+      x[i] = comp->states[i] + 0.75*h*k2[i];
+    if (doStepDerivatives(comp, *t + 0.75*h, x, k3) != fmi2OK)
       return fmi2Error;
+    for (i = 0; i < n; i++)
+      x[i] = comp->states[i] + h*(2.0/9.0*k1[i] + 1.0/3.0*k2[i] + 4.0/9.0*k3[i]);
+    if (doStepDerivatives(comp, last ? tTarget : *t + h, x, k4) != fmi2OK)
+      return fmi2Error;
+
+    /* weighted RMS norm of the difference to the embedded 2nd order solution */
+    err = 0;
+    for (i = 0; i < n; i++) {
+      e = h*(-5.0/72.0*k1[i] + 1.0/12.0*k2[i] + 1.0/9.0*k3[i] - 1.0/8.0*k4[i]);
+      sc = tol*(1.0 + fmax(fabs(comp->states[i]), fabs(x[i])));
+      err += (e/sc)*(e/sc);
+    }
+    err = n > 0 ? sqrt(err/n) : 0;
+    if (err > 1.0 && h > hMin) {
+      comp->stepSize = h*fmax(0.2, 0.9*pow(err, -1.0/3.0));
+      comp->stepsRejected++;
+      continue;
     }
 
-    status = fmi2GetContinuousStates(c, states, NUMBER_OF_STATES);
-    if (status != fmi2OK)
-    {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
+    /* the model is at the end of the step, look for zero crossings before accepting it */
+    if (NUMBER_OF_EVENT_INDICATORS > 0 && h > hMin) {
+      if (fmi2GetEventIndicators((fmi2Component)comp, comp->event_indicators, NUMBER_OF_EVENT_INDICATORS) != fmi2OK)
+        return fmi2Error;
+      if (zeroCrossed(comp->event_indicators_prev, comp->event_indicators)) {
+        if (!locating) {
+          hLocate = h;
+          locating = fmi2True;
+        }
+        comp->stepSize = 0.5*h;
+        comp->stepsRejected++;
+        continue;
+      }
+    }
+
+    *t = last ? tTarget : *t + h;
+    memcpy(comp->states, x, n*sizeof(fmi2Real));
+    memcpy(comp->states_der, k4, n*sizeof(fmi2Real));
+    if (doStepCompleted(comp, event) != fmi2OK)
       return fmi2Error;
+    comp->stepsAccepted++;
+
+    if (locating) {
+      /* continue with the step size from before the event once it is found */
+      comp->stepSize = *event ? hLocate : 0.5*h;
+    } else if (!last || h == comp->stepSize) {
+      comp->stepSize = h*fmin(5.0, err > 0 ? fmax(0.2, 0.9*pow(err, -1.0/3.0)) : 5.0);
     }
   }
+  return fmi2OK;
+}
 
-  if (NUMBER_OF_EVENT_INDICATORS > 0)
-  {
-    status = fmi2GetEventIndicators(c, event_indicators_prev, NUMBER_OF_EVENT_INDICATORS);
-    if (status != fmi2OK)
-    {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
+/* Implicit Euler steps to tTarget, or up to the first event. The simplified
+ * Newton iteration uses a finite difference Jacobian computed once per step.
+ * Steps whose iteration does not converge are halved, steps with a zero
+ * crossing are halved until they are shorter than hMin. There is no error
+ * control: otherwise the steps are as long as the communication step.
+ */
+static fmi2Status doStepImplicitEuler(ModelInstance* comp, fmi2Real* t, fmi2Real tTarget, fmi2Real hMin, fmi2Boolean* event)
+{
+  int n = NUMBER_OF_STATES, nrhs = 1, info;
+  fmi2Real *x = comp->rk_work, *f = x + n, *fx = f + n, *dx = fx + n;
+  fmi2Real *jac = comp->ie_jacobian;
+  fmi2Real h, hLocate = 0, tNew, xj, delta, norm, sc, tol = solverTolerance(comp);
+  fmi2Boolean locating = fmi2False, last, converged;
+  int i, j, iter;
+
+  *event = fmi2False;
+  while (*t < tTarget && !*event) {
+    h = fmin(comp->stepSize, tTarget - *t);
+    last = (h >= tTarget - *t);
+    tNew = last ? tTarget : *t + h;
+
+    /* explicit Euler predictor and the Newton matrix I - h*df/dx there */
+    for (i = 0; i < n; i++)
+      x[i] = comp->states[i] + h*comp->states_der[i];
+    if (doStepDerivatives(comp, tNew, x, fx) != fmi2OK)
       return fmi2Error;
+    for (j = 0; j < n; j++) {
+      xj = x[j];
+      delta = sqrt(DBL_EPSILON)*fmax(fabs(xj), 1.0);
+      x[j] = xj + delta;
+      if (doStepDerivatives(comp, tNew, x, f) != fmi2OK)
+        return fmi2Error;
+      x[j] = xj;
+      for (i = 0; i < n; i++)
+        jac[i + j*n] = -h*(f[i] - fx[i])/delta;
+      jac[j + j*n] += 1.0;
+    }
+    info = 0;
+    if (n > 0)
+      dgetrf_(&n, &n, jac, &n, comp->ie_pivot, &info);
+
+    /* x - states - h*f(tNew, x) = 0 */
+    converged = (n == 0);
+    for (iter = 0; iter < 10 && info == 0 && !converged; iter++) {
+      if (iter > 0 && doStepDerivatives(comp, tNew, x, fx) != fmi2OK)
+        return fmi2Error;
+      for (i = 0; i < n; i++)
+        dx[i] = comp->states[i] + h*fx[i] - x[i];
+      dgetrs_("N", &n, &nrhs, jac, &n, comp->ie_pivot, dx, &n, &info);
+      norm = 0;
+      for (i = 0; i < n; i++) {
+        x[i] += dx[i];
+        sc = tol*(1.0 + fabs(x[i]));
+        norm += (dx[i]/sc)*(dx[i]/sc);
+      }
+      converged = sqrt(norm/n) < 0.1;
+    }
+    if (!converged) {
+      if (h <= hMin) {
+        FILTERED_LOG(comp, fmi2Error, LOG_STATUSERROR, "fmi2DoStep: the Newton iteration of the implicit Euler step at time %.16g does not converge.", *t)
+        return fmi2Error;
+      }
+      comp->stepSize = 0.5*h;
+      comp->stepsRejected++;
+      continue;
+    }
+    /* the model is at the end of the step, look for zero crossings before accepting it */
+    if (doStepDerivatives(comp, tNew, x, f) != fmi2OK)
+      return fmi2Error;
+    if (NUMBER_OF_EVENT_INDICATORS > 0 && h > hMin) {
+      if (fmi2GetEventIndicators((fmi2Component)comp, comp->event_indicators, NUMBER_OF_EVENT_INDICATORS) != fmi2OK)
+        return fmi2Error;
+      if (zeroCrossed(comp->event_indicators_prev, comp->event_indicators)) {
+        if (!locating) {
+          hLocate = h;
+          locating = fmi2True;
+        }
+        comp->stepSize = 0.5*h;
+        comp->stepsRejected++;
+        continue;
+      }
+    }
+
+    *t = tNew;
+    memcpy(comp->states, x, n*sizeof(fmi2Real));
+    memcpy(comp->states_der, f, n*sizeof(fmi2Real));
+    if (doStepCompleted(comp, event) != fmi2OK)
+      return fmi2Error;
+    comp->stepsAccepted++;
+
+    if (locating) {
+      comp->stepSize = *event ? hLocate : 0.5*h;
+    } else if (!last || h == comp->stepSize) {
+      comp->stepSize = 2.0*h;
+    }
+  }
+  return fmi2OK;
+}
+
+fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
+  ModelInstance *comp = (ModelInstance *)c;
+  fmi2Real t = comp->fmuData->localData[0]->timeValue;
+  fmi2Real tNext, tEnd, tTarget, hMin;
+  fmi2Boolean event = fmi2False, timeEvent;
+  fmi2Status status;
+
+  if (invalidState(comp, "fmi2DoStep", modelEventMode|modelContinuousTimeMode))
+    return fmi2Error;
+  if (nullPointer(comp, "fmi2DoStep", "work arrays, fmi2SetupExperiment was not called", comp->states))
+    return fmi2Error;
+  FILTERED_LOG(comp, fmi2OK, LOG_FMI2_CALL, "fmi2DoStep: %.16g + %.16g", currentCommunicationPoint, communicationStepSize)
+
+  /* Event mode is only entered after the initialization, if inputs set
+   * since the last step moved an event indicator, or if an event occurs
+   * inside the step.
+   */
+  if (comp->state == modelEventMode) {
+    event = fmi2True;
+  } else if (NUMBER_OF_EVENT_INDICATORS > 0) {
+    if (fmi2GetEventIndicators(c, comp->event_indicators, NUMBER_OF_EVENT_INDICATORS) != fmi2OK)
+      return fmi2Error;
+    event = zeroCrossed(comp->event_indicators_prev, comp->event_indicators);
+  }
+  if (event) {
+    if (doStepEvent(comp) != fmi2OK)
+      return fmi2Error;
+  } else {
+    /* inputs may have changed the derivatives */
+    if (NUMBER_OF_STATES > 0) {
+      if (fmi2GetContinuousStates(c, comp->states, NUMBER_OF_STATES) != fmi2OK || fmi2GetDerivatives(c, comp->states_der, NUMBER_OF_STATES) != fmi2OK)
+        return fmi2Error;
+    }
+    if (NUMBER_OF_EVENT_INDICATORS > 0) {
+      fmi2Real* tmp = comp->event_indicators_prev;
+      comp->event_indicators_prev = comp->event_indicators;
+      comp->event_indicators = tmp;
     }
   }
 
@@ -1079,89 +2025,36 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
     tNext = tEnd;
   }
 
-  /* adjust for time events */
-  if (eventInfo.nextEventTimeDefined && (tNext >= eventInfo.nextEventTime)) {
-    tNext = eventInfo.nextEventTime;
-    time_event = 1;
+  if (comp->stepSize <= 0) {
+    comp->stepSize = communicationStepSize;
   }
-
-  fmi2SetTime(c, tNext);
-
-  /* integrate */
-  for (i = 0; i < NUMBER_OF_STATES; i++) {
-    states[i] = states[i] + communicationStepSize * states_der[i];
-  }
-
-  /* set the continuous states */
-  if (NUMBER_OF_STATES > 0)
-  {
-    status = fmi2SetContinuousStates(c, states, NUMBER_OF_STATES);
-    if (status != fmi2OK)
-    {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
-      return fmi2Error;
+  hMin = solverTolerance(comp) * communicationStepSize;
+
+  while (t < tNext) {
+    /* stop at time events */
+    tTarget = tNext;
+    timeEvent = fmi2False;
+    if (comp->eventInfo.nextEventTimeDefined && comp->eventInfo.nextEventTime > t && comp->eventInfo.nextEventTime <= tNext) {
+      tTarget = comp->eventInfo.nextEventTime;
+      timeEvent = fmi2True;
     }
-  }
 
-  /* signal completed integrator step */
-  status = fmi2CompletedIntegratorStep(c, fmi2True, &enterEventMode, &terminateSimulation);
-  if (status != fmi2OK)
-  {
-    functions->freeMemory(states);
-    functions->freeMemory(states_der);
-    functions->freeMemory(event_indicators);
-    functions->freeMemory(event_indicators_prev);
-    return fmi2Error;
-  }
-
-  /* check for events */
-  if (NUMBER_OF_EVENT_INDICATORS > 0)
-  {
-    status = fmi2GetEventIndicators(c, event_indicators, NUMBER_OF_EVENT_INDICATORS);
+    if (comp->solver == fmi2CoSimulationRK23) {
+      status = doStepRK23(comp, &t, tTarget, hMin, &event);
+    } else if (comp->solver == fmi2CoSimulationImplicitEuler) {
+      status = doStepImplicitEuler(comp, &t, tTarget, hMin, &event);
+    } else {
+      status = doStepEuler(comp, &t, tTarget, &event);
+    }
     if (status != fmi2OK)
-    {
-      functions->freeMemory(states);
-      functions->freeMemory(states_der);
-      functions->freeMemory(event_indicators);
-      functions->freeMemory(event_indicators_prev);
       return fmi2Error;
-    }
 
-    for (i = 0; i < NUMBER_OF_EVENT_INDICATORS; i++)
-    {
-      if (event_indicators[i]*event_indicators_prev[i] < 0) {
-        zc_event = 1;
-        break;
-      }
-    }
-
-    /* fprintf(stderr, "enterEventMode = %d, zc_event = %d, time_event = %d\n", enterEventMode, zc_event, time_event); */
-
-    if (enterEventMode || zc_event || time_event) {
-      fmi2EnterEventMode(c);
-
-      fmi2EventIteration(c, &eventInfo);
-
-      if(eventInfo.valuesOfContinuousStatesChanged)
-         fmi2GetContinuousStates(c, states, NUMBER_OF_STATES);
-
-      if( eventInfo.nominalsOfContinuousStatesChanged)
-        fmi2GetNominalsOfContinuousStates(c, states, NUMBER_OF_STATES);
-
-      fmi2GetEventIndicators(c, event_indicators_prev, NUMBER_OF_EVENT_INDICATORS);
-
-      fmi2EnterContinuousTimeMode(c);
+    if (event || (timeEvent && t >= tTarget)) {
+      if (doStepEvent(comp) != fmi2OK)
+        return fmi2Error;
     }
   }
 
-  functions->freeMemory(states);
-  functions->freeMemory(states_der);
-  functions->freeMemory(event_indicators);
-  functions->freeMemory(event_indicators_prev);
-
   return fmi2OK;
 }
 
@@ -63,6 +63,26 @@ typedef enum {
   modelError              = 1<<5
 } ModelState;
 
+// integrator used by fmi2DoStep, selected by the entry "s" of the optional
+// file resources/<modelIdentifier>_flags.json of the FMU, e.g. {"s": "rk23"}
+typedef enum {
+  fmi2CoSimulationEuler         = 0,  // "euler": one explicit Euler step per communication step (default)
+  fmi2CoSimulationRK23          = 1,  // "rk23": Bogacki-Shampine 3(2) with step size control
+  fmi2CoSimulationImplicitEuler = 2   // "impeuler": implicit Euler for stiff models, no error control
+} CoSimulationSolver;
+
+// one of the symbolic Jacobians A = d(der(x))/dx, B = d(der(x))/du, C = dy/dx, D = dy/du
+// used by fmi2GetDirectionalDerivative
+typedef struct {
+  int index;                                            // INDEX_JAC_* of the model
+  int (*column)(void* data, threadData_t *threadData);  // functionJac*_column of the model
+  int rowOffset;                                        // first row in [der(x); y]
+  int colOffset;                                        // first column in [x; u]
+  fmi2Boolean available;
+  fmi2Boolean valid;                                    // values belong to the current model state
+  fmi2Real* values;                                     // nonzeros in the order of the sparse pattern
+} DirectionalDerivativeJacobian;
+
 typedef struct {
   fmi2String instanceName;
   fmi2Type type;
@@ -82,10 +102,33 @@ typedef struct {
   fmi2Boolean stopTimeDefined;
   fmi2Real stopTime;
 
-  int _need_update;
-#ifdef FMU_EXPERIMENTAL
-  int _has_jacobian;
-#endif
+  // lazy evaluation: the equations are split into the ODE partition (functionODE,
+  // everything the state derivatives depend on) and the algebraic partition
+  // (functionAlgebraics, the remaining equations); each is evaluated on demand
+  int _need_update;             // ODE partition is stale
+  int _need_update_algebraics;  // algebraic partition is stale
+
+  // co-simulation work arrays, allocated in fmi2SetupExperiment
+  CoSimulationSolver solver;
+  fmi2Real stepSize;
+  fmi2Real* states;
+  fmi2Real* states_der;
+  fmi2Real* event_indicators;
+  fmi2Real* event_indicators_prev;
+  fmi2Real* rk_work;
+  fmi2Real* ie_jacobian;        // LU factors of the Newton matrix of the implicit Euler step
+  int* ie_pivot;
+  unsigned long stepsAccepted;
+  unsigned long stepsRejected;  // by the error control, a zero crossing or a failed Newton iteration
+
+  // directional derivatives, see fmi2GetDirectionalDerivative
+  DirectionalDerivativeJacobian jacobians[4];  // A, B, C, D
+  int _need_jacobian_update;
+  int* jac_known;                              // value reference -> position in [x; u] or -1
+  int* jac_unknown;                            // value reference -> position in [der(x); y] or -1
+  fmi2Real* jac_seed;
+  fmi2Real* jac_result;
+  fmi2Real* jac_work;                          // finite differences: knowns, then unknowns
 } ModelInstance;
 
 #ifdef __cplusplus
@@ -0,0 +1,182 @@
+/* Load test for the embedded OPC UA server: several clients poll many
+ * variables as fast as they can while the simulation runs. Compare the
+ * simulated time reached and the read rate with and without clients.
+ *
+ * usage: loadtest [clients [variables [seconds [url]]]]
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "open62541.h"
+#include "omc_opc_ua.h"
+
+static const char *url = "opc.tcp://localhost:4841";
+static int nVars = 10000;
+static volatile int running = 1;
+
+typedef struct {
+  pthread_t thread;
+  long reads;
+  long failed;
+  double maxLatency;
+} client_stats;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static UA_Client* connectClient(void)
+{
+  UA_Client *client = UA_Client_new(UA_ClientConfig_standard, Logger_Stdout);
+  if (UA_Client_connect(client, UA_ClientConnectionTCP, url) != UA_STATUSCODE_GOOD) {
+    UA_Client_delete(client);
+    return NULL;
+  }
+  return client;
+}
+
+static double readTime(UA_Client *client)
+{
+  double res=0;
+  UA_ReadRequest rReq;
+  UA_ReadRequest_init(&rReq);
+  rReq.nodesToRead = UA_Array_new(1, &UA_TYPES[UA_TYPES_READVALUEID]);
+  rReq.nodesToReadSize = 1;
+  rReq.nodesToRead[0].nodeId = UA_NODEID_NUMERIC(0, OMC_OPC_NODEID_TIME);
+  rReq.nodesToRead[0].attributeId = UA_ATTRIBUTEID_VALUE;
+
+  UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+  if(rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+          rResp.resultsSize > 0 && rResp.results[0].hasValue &&
+          UA_Variant_isScalar(&rResp.results[0].value) &&
+          rResp.results[0].value.type == &UA_TYPES[UA_TYPES_DOUBLE]) {
+    res = *(UA_Double*)rResp.results[0].value.data;
+  }
+  UA_ReadRequest_deleteMembers(&rReq);
+  UA_ReadResponse_deleteMembers(&rResp);
+  return res;
+}
+
+static int writeBoolean(UA_Client *client, int id, UA_Boolean val)
+{
+  int res=0;
+  UA_WriteRequest wReq;
+  UA_WriteRequest_init(&wReq);
+  wReq.nodesToWrite = UA_WriteValue_new();
+  wReq.nodesToWriteSize = 1;
+  wReq.nodesToWrite[0].nodeId = UA_NODEID_NUMERIC(0, id);
+  wReq.nodesToWrite[0].attributeId = UA_ATTRIBUTEID_VALUE;
+  wReq.nodesToWrite[0].value.hasValue = UA_TRUE;
+  wReq.nodesToWrite[0].value.value.type = &UA_TYPES[UA_TYPES_BOOLEAN];
+  wReq.nodesToWrite[0].value.value.storageType = UA_VARIANT_DATA_NODELETE;
+  wReq.nodesToWrite[0].value.value.data = &val;
+
+  UA_WriteResponse wResp = UA_Client_Service_write(client, wReq);
+  if (wResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+    res = 1;
+  }
+  UA_WriteRequest_deleteMembers(&wReq);
+  UA_WriteResponse_deleteMembers(&wResp);
+  return res;
+}
+
+/* reads all variables in one request, over and over */
+static void* pollVariables(void *arg)
+{
+  client_stats *stats = (client_stats*) arg;
+  UA_Client *client = connectClient();
+  UA_ReadRequest rReq;
+  int i;
+
+  if (!client) {
+    fprintf(stderr, "Failed to connect to %s\n", url);
+    return NULL;
+  }
+  UA_ReadRequest_init(&rReq);
+  rReq.nodesToRead = UA_Array_new(nVars, &UA_TYPES[UA_TYPES_READVALUEID]);
+  rReq.nodesToReadSize = nVars;
+  for (i=0; i<nVars; i++) {
+    rReq.nodesToRead[i].nodeId = UA_NODEID_NUMERIC(1, VARKIND_REAL*MAX_VARS_KIND + i);
+    rReq.nodesToRead[i].attributeId = UA_ATTRIBUTEID_VALUE;
+  }
+  while (running) {
+    double t0 = now(), latency;
+    UA_ReadResponse rResp = UA_Client_Service_read(client, rReq);
+    latency = now() - t0;
+    if (rResp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+      for (i=0; i<rResp.resultsSize; i++) {
+        if (rResp.results[i].hasValue) {
+          stats->reads++;
+        } else {
+          stats->failed++;
+        }
+      }
+    } else {
+      stats->failed += nVars;
+    }
+    if (latency > stats->maxLatency) {
+      stats->maxLatency = latency;
+    }
+    UA_ReadResponse_deleteMembers(&rResp);
+  }
+  UA_ReadRequest_deleteMembers(&rReq);
+  UA_Client_disconnect(client);
+  UA_Client_delete(client);
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  int nClients = argc > 1 ? atoi(argv[1]) : 4;
+  double seconds = argc > 3 ? atof(argv[3]) : 10;
+  client_stats *stats;
+  UA_Client *control;
+  double t0, simTime0, simTime1, wall;
+  long reads = 0, failed = 0;
+  int i;
+
+  nVars = argc > 2 ? atoi(argv[2]) : nVars;
+  url = argc > 4 ? argv[4] : url;
+  control = connectClient();
+  if (!control) {
+    fprintf(stderr, "Failed to connect to %s\n", url);
+    return 1;
+  }
+  stats = calloc(nClients, sizeof(client_stats));
+  for (i=0; i<nClients; i++) {
+    pthread_create(&stats[i].thread, NULL, pollVariables, &stats[i]);
+  }
+
+  simTime0 = readTime(control);
+  t0 = now();
+  if (1!=writeBoolean(control, OMC_OPC_NODEID_RUN, UA_TRUE)) {
+    fprintf(stderr, "Writing to NODEID_RUN failed\n");
+  }
+  usleep((useconds_t) (seconds*1e6));
+  writeBoolean(control, OMC_OPC_NODEID_RUN, UA_FALSE);
+  wall = now() - t0;
+  simTime1 = readTime(control);
+
+  running = 0;
+  for (i=0; i<nClients; i++) {
+    pthread_join(stats[i].thread, NULL);
+    printf("client %d: %ld reads (%.0f/s), %ld failed, max request latency %.3g s\n", i, stats[i].reads, stats[i].reads/wall, stats[i].failed, stats[i].maxLatency);
+    reads += stats[i].reads;
+    failed += stats[i].failed;
+  }
+  printf("%d clients polling %d variables: %.0f reads/s, %ld failed\n", nClients, nVars, reads/wall, failed);
+  printf("simulation advanced from %g to %g in %.3g s wall clock time\n", simTime0, simTime1, wall);
+
+  free(stats);
+  UA_Client_disconnect(control);
+  UA_Client_delete(control);
+  return failed != 0;
+}
@@ -36,6 +36,32 @@
 
 #define BAD_RESULT() fprintf(stderr, "%s:%d: Bad OPC result\n", __FILE__, __LINE__);
 
+#define WRITE_QUEUE_SIZE 1024 /* power of two */
+
+/* The variables as seen by the clients. The simulation thread fills the
+ * snapshot that is not published and then publishes it, so clients never
+ * wait for the simulation. seq is odd while the snapshot is written; a
+ * reader that sees it change reads again. */
+typedef struct {
+  volatile unsigned int seq;
+  double time;
+  UA_Double *realVals;
+  UA_Boolean *boolVals;
+} omc_opc_ua_snapshot;
+
+typedef enum {
+  WRITE_INPUT,
+  WRITE_STATE
+} write_kind_t;
+
+/* A value written by a client, applied by the simulation thread at the next step */
+typedef struct {
+  volatile unsigned long sequence;
+  write_kind_t kind;
+  int index;
+  double value;
+} omc_opc_ua_write;
+
 typedef struct {
   DATA *data;
   UA_Logger logger;
@@ -46,20 +72,16 @@ typedef struct {
   UA_Boolean step;
   pthread_mutex_t mutex_pause;
   pthread_cond_t cond_pause;
-  double time;
   pthread_t thread;
   UA_MethodAttributes runAttr;
-  pthread_rwlock_t rwlock;
-  double *inputVarsBackup;
-  int gotNewInput;
-  UA_Double *realVals; /* All nReal doubles backed up in a separate array protected by rwlock */
+  omc_opc_ua_snapshot snapshots[2];
+  volatile int published;
   int *realValsInputIndex;
-  UA_Boolean *boolVals; /* All nReal doubles backed up in a separate array protected by rwlock */
   int *boolValsInputIndex;
-  int reinitStateFlag;
-  int *stateWasUpdatedFlag;
-  double *updatedStates;
-  double real_time_sync_scaling;
+  omc_opc_ua_write *writes;
+  volatile unsigned long writeTail;
+  unsigned long writeHead;
+  volatile double real_time_sync_scaling;
   void (*omc_real_time_sync_update)(DATA *data, double scaling);
 } omc_opc_ua_state;
 
@@ -85,6 +107,108 @@ static void* threadWork(void *data)
   return status == UA_STATUSCODE_GOOD ? (void*)0 : (void*)1;
 }
 
+static void publishSnapshot(omc_opc_ua_state *state, double t)
+{
+  DATA *data = state->data;
+  MODEL_DATA *modelData = data->modelData;
+  omc_opc_ua_snapshot *snapshot = &state->snapshots[1-state->published];
+  int i;
+
+  __sync_fetch_and_add(&snapshot->seq, 1);
+  __sync_synchronize();
+  snapshot->time = t;
+  for (i = 0; i < modelData->nVariablesReal; i++) {
+    snapshot->realVals[i] = (data->localData[0])->realVars[i];
+  }
+  for (i = 0; i < modelData->nVariablesBoolean; i++) {
+    snapshot->boolVals[i] = (data->localData[0])->booleanVars[i];
+  }
+  __sync_synchronize();
+  __sync_fetch_and_add(&snapshot->seq, 1);
+  state->published = 1-state->published;
+  __sync_synchronize();
+}
+
+/* index -1 reads the time */
+static UA_Double readSnapshotReal(omc_opc_ua_state *state, int index)
+{
+  omc_opc_ua_snapshot *snapshot;
+  unsigned int seq;
+  UA_Double val;
+  do {
+    snapshot = &state->snapshots[state->published];
+    seq = snapshot->seq;
+    __sync_synchronize();
+    val = index < 0 ? snapshot->time : snapshot->realVals[index];
+    __sync_synchronize();
+  } while ((seq & 1) || seq != snapshot->seq);
+  return val;
+}
+
+static UA_Boolean readSnapshotBoolean(omc_opc_ua_state *state, int index)
+{
+  omc_opc_ua_snapshot *snapshot;
+  unsigned int seq;
+  UA_Boolean val;
+  do {
+    snapshot = &state->snapshots[state->published];
+    seq = snapshot->seq;
+    __sync_synchronize();
+    val = snapshot->boolVals[index];
+    __sync_synchronize();
+  } while ((seq & 1) || seq != snapshot->seq);
+  return val;
+}
+
+/* bounded multi-producer queue; returns 0 if it is full */
+static int queueWrite(omc_opc_ua_state *state, write_kind_t kind, int index, double value)
+{
+  omc_opc_ua_write *w;
+  unsigned long pos = state->writeTail, seq;
+  while (1) {
+    w = &state->writes[pos & (WRITE_QUEUE_SIZE-1)];
+    seq = w->sequence;
+    __sync_synchronize();
+    if (seq == pos) {
+      if (__sync_bool_compare_and_swap(&state->writeTail, pos, pos+1)) {
+        break;
+      }
+    } else if ((long)(seq - pos) < 0) {
+      return 0;
+    }
+    pos = state->writeTail;
+  }
+  w->kind = kind;
+  w->index = index;
+  w->value = value;
+  __sync_synchronize();
+  w->sequence = pos+1;
+  return 1;
+}
+
+/* applies the values written by clients since the last step */
+static void applyWrites(omc_opc_ua_state *state)
+{
+  DATA *data = state->data;
+  omc_opc_ua_write *w;
+  while (1) {
+    w = &state->writes[state->writeHead & (WRITE_QUEUE_SIZE-1)];
+    if (w->sequence != state->writeHead+1) {
+      break;
+    }
+    __sync_synchronize();
+    if (w->kind == WRITE_INPUT) {
+      data->simulationInfo->inputVars[w->index] = w->value;
+    } else {
+      // TODO: Trigger an event / restarting the numerical solver
+      (data->localData[0])->realVars[w->index] = w->value;
+    }
+    __sync_synchronize();
+    w->sequence = state->writeHead + WRITE_QUEUE_SIZE;
+    state->writeHead++;
+  }
+}
+
 static void waitForStep(omc_opc_ua_state *state)
 {
   int run;
@@ -100,6 +224,7 @@ static void waitForStep(omc_opc_ua_state *state)
     state->omc_real_time_sync_update(state->data, state->real_time_sync_scaling);
     state->data->real_time_sync.scaling = state->real_time_sync_scaling;
   }
+  applyWrites(state);
 }
 
 static UA_StatusCode
@@ -124,10 +249,8 @@ readBoolean(void *handle, const UA_NodeId nodeid, UA_Boolean sourceTimeStamp, co
     int index1 = nodeid.identifier.numeric-VARKIND_BOOL*MAX_VARS_KIND;
     int index = index1 >= ALIAS_START_ID ? modelData->booleanAlias[index1-ALIAS_START_ID].nameID : index1;
     int negate = index1 >= ALIAS_START_ID ? modelData->booleanAlias[index1-ALIAS_START_ID].negate : 0;
-    pthread_rwlock_rdlock(&state->rwlock);
-    val = state->boolVals[index];
+    val = readSnapshotBoolean(state, index);
     val = negate ? !val : val;
-    pthread_rwlock_unlock(&state->rwlock);
   } else {
     dataValue->hasValue = UA_FALSE;
     BAD_RESULT()
@@ -165,9 +288,8 @@ writeBoolean(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const
       int inputIndex = state->boolValsInputIndex[index];
       newVal = negate ? !newVal : newVal;
       if (inputIndex != -1) {
-        if (state->data->simulationInfo->inputVars[inputIndex] != newVal) {
-          state->gotNewInput = 1;
-          state->inputVarsBackup[inputIndex] = newVal;
+        if (!queueWrite(state, WRITE_INPUT, inputIndex, newVal)) {
+          statusCode = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
         }
       } else {
         statusCode = UA_STATUSCODE_BADUNEXPECTEDERROR;
@@ -196,21 +318,15 @@ readReal(void *handle, const UA_NodeId nodeid, UA_Boolean sourceTimeStamp, const
   }
 
   if (nodeid.identifier.numeric==OMC_OPC_NODEID_TIME) {
-    pthread_rwlock_rdlock(&state->rwlock);
-    val = state->time;
-    pthread_rwlock_unlock(&state->rwlock);
+    val = readSnapshotReal(state, -1);
   } else if (nodeid.identifier.numeric==OMC_OPC_NODEID_REAL_TIME_SCALING_FACTOR) {
-    pthread_rwlock_rdlock(&state->rwlock);
     val = state->real_time_sync_scaling;
-    pthread_rwlock_unlock(&state->rwlock);
   } else if (nodeid.identifier.numeric >= VARKIND_REAL*MAX_VARS_KIND && nodeid.identifier.numeric < (1+VARKIND_REAL)*MAX_VARS_KIND) {
     int index1 = nodeid.identifier.numeric-VARKIND_REAL*MAX_VARS_KIND;
     int index = index1 >= ALIAS_START_ID ? modelData->realAlias[index1-ALIAS_START_ID].nameID : index1;
     int negate = index1 >= ALIAS_START_ID ? modelData->realAlias[index1-ALIAS_START_ID].negate : 0;
-    pthread_rwlock_rdlock(&state->rwlock);
-    val = state->realVals[index];
+    val = readSnapshotReal(state, index);
     val = negate ? -val : val;
-    pthread_rwlock_unlock(&state->rwlock);
   } else {
     BAD_RESULT()
     return UA_STATUSCODE_BADNODEIDUNKNOWN;
@@ -250,14 +366,13 @@ writeReal(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA
     int inputIndex = state->realValsInputIndex[index];
     newVal = negate ? -newVal : newVal;
     if (inputIndex != -1) {
-      if (state->data->simulationInfo->inputVars[inputIndex] != newVal) {
-        state->gotNewInput = 1;
-        state->inputVarsBackup[inputIndex] = newVal;
+      if (!queueWrite(state, WRITE_INPUT, inputIndex, newVal)) {
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
       }
     } else if (index < state->data->modelData->nStates) {
-      state->reinitStateFlag = 1;
-      state->stateWasUpdatedFlag[index] = 1;
-      state->updatedStates[index] = newVal;
+      if (!queueWrite(state, WRITE_STATE, index, newVal)) {
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+      }
     } else {
       BAD_RESULT()
       return UA_STATUSCODE_BADUNEXPECTEDERROR;
@@ -269,7 +384,7 @@ writeReal(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA
   return UA_STATUSCODE_GOOD;
 }
 
-static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varKind, int n, void *vars, int *varIndex)
+static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varKind, int n, int *varIndex)
 {
   MODEL_DATA *modelData = state->data->modelData;
   int i;
@@ -289,7 +404,6 @@ static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varK
     case VARKIND_REAL:
     {
       STATIC_REAL_DATA *realVarsData = modelData->realVarsData;
-      state->realVals[*varIndex] = ((double*)vars)[i];
       inputIndex = realVarsData[i].info.inputIndex;
       state->realValsInputIndex[*varIndex] = inputIndex;
       nameStr = (char*) realVarsData[i].info.name;
@@ -301,7 +415,6 @@ static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varK
     case VARKIND_BOOL:
     {
       STATIC_BOOLEAN_DATA *booleanVarsData = modelData->booleanVarsData;
-      state->boolVals[*varIndex] = ((int*)vars)[i];
       inputIndex = booleanVarsData[i].info.inputIndex;
       state->boolValsInputIndex[*varIndex] = inputIndex;
       nameStr = (char*) booleanVarsData[i].info.name;
@@ -454,6 +567,7 @@ void* omc_embedded_server_init(DATA *data, double t, double step, const char *ar
   omc_opc_ua_state *state = (omc_opc_ua_state*) malloc(sizeof(omc_opc_ua_state));
   UA_ServerConfig config = UA_ServerConfig_standard;
   var_kind_t vk;
+  int i;
   state->logger = Logger_Stdout;
   state->nl = UA_ServerNetworkLayerTCP(UA_ConnectionConfig_standard, 4841);
   config.logger = Logger_Stdout;
@@ -464,15 +578,29 @@ void* omc_embedded_server_init(DATA *data, double t, double step, const char *ar
   state->real_time_sync_scaling = data->real_time_sync.scaling;
 
   state->server_running = 1;
-  state->time = t;
   state->omc_real_time_sync_update = omc_real_time_sync_update;
 
   pthread_cond_init(&state->cond_pause, NULL);
   pthread_mutex_init(&state->mutex_pause, NULL);
-  pthread_rwlock_init(&state->rwlock, NULL);
   state->run = 0;
   state->step = 0;
 
+  for (i = 0; i < 2; i++) {
+    state->snapshots[i].seq = 0;
+    state->snapshots[i].realVals = malloc(modelData->nVariablesReal * sizeof(UA_Double));
+    state->snapshots[i].boolVals = malloc(modelData->nVariablesBoolean * sizeof(UA_Boolean));
+  }
+  state->published = 0;
+  publishSnapshot(state, t);
+  state->realValsInputIndex = malloc(modelData->nVariablesReal * sizeof(int));
+  state->boolValsInputIndex = malloc(modelData->nVariablesBoolean * sizeof(int));
+  state->writes = malloc(WRITE_QUEUE_SIZE * sizeof(omc_opc_ua_write));
+  for (i = 0; i < WRITE_QUEUE_SIZE; i++) {
+    state->writes[i].sequence = i;
+  }
+  state->writeTail = 0;
+  state->writeHead = 0;
+
 /*
   UA_MethodAttributes_init(&state->runAttr);
   state->runAttr.description = UA_LOCALIZEDTEXT("en_US","Puts the simulation in run mode");
@@ -559,32 +687,16 @@ void* omc_embedded_server_init(DATA *data, double t, double step, const char *ar
                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
                                       timeName, UA_NODEID_NULL, timeAttr, timeDataSource, NULL);
 
-  pthread_rwlock_wrlock(&state->rwlock);
-
-  state->gotNewInput = 0;
-  state->inputVarsBackup = malloc(modelData->nInputVars * sizeof(double));
-  memcpy(state->inputVarsBackup, data->simulationInfo->inputVars, modelData->nInputVars * sizeof(double));
-  state->realVals = malloc(modelData->nVariablesReal * sizeof(UA_Double));
-  state->realValsInputIndex = malloc(modelData->nVariablesReal * sizeof(int));
-  state->boolVals = malloc(modelData->nVariablesBoolean * sizeof(UA_Boolean));
-  state->boolValsInputIndex = malloc(modelData->nVariablesBoolean * sizeof(int));
-
-  state->reinitStateFlag = 0;
-  state->stateWasUpdatedFlag = (int*) calloc(sizeof(int), modelData->nStates);
-  state->updatedStates = (double*) malloc(sizeof(double)*modelData->nStates);
-
   int realIndex = 0, boolIndex = 0;
   assert(modelData->nVariablesReal < MAX_VARS_KIND);
 
   // state = addVars(state, VARKIND_REAL, nInputVars, modelData->realVarsData, &realIndex);
-  state = addVars(state, VARKIND_REAL, modelData->nVariablesReal, (data->localData[0])->realVars, &realIndex);
-  state = addVars(state, VARKIND_BOOL, modelData->nVariablesBoolean, (data->localData[0])->booleanVars, &boolIndex);
+  state = addVars(state, VARKIND_REAL, modelData->nVariablesReal, &realIndex);
+  state = addVars(state, VARKIND_BOOL, modelData->nVariablesBoolean, &boolIndex);
   for (vk=VARKIND_REAL; vk<=VARKIND_BOOL; vk++) {
     state = addAliasVars(state, vk);
   }
 
-  pthread_rwlock_unlock(&state->rwlock);
-
   if (state) {
     fprintf(stderr, "omc_embedded_server_init done, state=%p, server=%p. Pause run=%d step=%d\n", state, state->server, state->run, state->step);
     waitForStep(state);
@@ -597,6 +709,7 @@ void omc_embedded_server_deinit(void *state_vp)
 {
   omc_opc_ua_state *state = (omc_opc_ua_state*) state_vp;
   void *res;
+  int i;
 
   state->server_running = 0;
   if (pthread_join(state->thread, &res)) {
@@ -607,50 +720,22 @@ void omc_embedded_server_deinit(void *state_vp)
   }
   UA_Server_delete(state->server);
   state->nl.deleteMembers(&state->nl);
-  pthread_rwlock_destroy(&state->rwlock);
   pthread_mutex_destroy(&state->mutex_pause);
   pthread_cond_destroy(&state->cond_pause);
-  free(state->inputVarsBackup);
-  free(state->realVals);
+  for (i = 0; i < 2; i++) {
+    free(state->snapshots[i].realVals);
+    free(state->snapshots[i].boolVals);
+  }
   free(state->realValsInputIndex);
-  free(state->boolVals);
   free(state->boolValsInputIndex);
+  free(state->writes);
   free(state);
 }
 
 void omc_embedded_server_update(void *state_vp, double t)
 {
   omc_opc_ua_state *state = (omc_opc_ua_state*) state_vp;
-  int i, realIndex=0, boolIndex=0;
-  DATA *data = state->data;
-  MODEL_DATA *modelData = data->modelData;
-
-  pthread_rwlock_wrlock(&state->rwlock);
-
-  state->time = t;
-
-  for (i = 0; i < modelData->nVariablesReal; i++, realIndex++) {
-    state->realVals[realIndex] = (data->localData[0])->realVars[i];
-  }
-  for (i = 0; i < modelData->nVariablesReal; i++, boolIndex++) {
-    state->boolVals[boolIndex] = (data->localData[0])->booleanVars[i];
-  }
-
-  if (state->gotNewInput) {
-    memcpy(data->simulationInfo->inputVars, state->inputVarsBackup, modelData->nInputVars * sizeof(double));
-  }
-
-  if (state->reinitStateFlag) {
-    // TODO: Trigger an event / restarting the numerical solver
-    for (i = 0; i < modelData->nStates; i++) {
-      if (state->stateWasUpdatedFlag[i]) {
-        state->stateWasUpdatedFlag[i] = 0;
-        (data->localData[0])->realVars[i] = state->updatedStates[i];
-      }
-    }
-  }
-
-  pthread_rwlock_unlock(&state->rwlock);
 
+  publishSnapshot(state, t);
   waitForStep(state);
 }
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+
+# Decodes the binary trace written by a simulation executable started with
+# -binaryTrace=<file> (see SimulationRuntime/c/util/omc_trace.h) to CSV.
+#
+# usage: omc_trace_decode.py trace.bin [--stream LOG_EVENTS] [--event delayFindTime]
+
+import argparse
+import csv
+import struct
+import sys
+
+HEADER = struct.Struct("=8sIIIIII")
+RECORD = struct.Struct("=HHHH4d")
+
+def read_trace(filename):
+  with open(filename, "rb") as f:
+    data = f.read()
+  magic, version, recordSize, numStreams, numEvents, namesSize, _ = HEADER.unpack_from(data, 0)
+  if magic.rstrip(b"\0") != b"OMCTRACE":
+    raise ValueError("%s is not a binary trace file" % filename)
+  if version != 1 or recordSize != RECORD.size:
+    raise ValueError("unsupported trace version %d (record size %d)" % (version, recordSize))
+  names = data[HEADER.size:HEADER.size+namesSize].split(b"\0")
+  streams = [n.decode() for n in names[:numStreams]]
+  events = [n.decode() for n in names[numStreams:numStreams+numEvents]]
+  pos = HEADER.size + namesSize
+  for off in range(pos, len(data) - RECORD.size + 1, RECORD.size):
+    stream, event, thread, numValues, v0, v1, v2, v3 = RECORD.unpack_from(data, off)
+    yield (thread,
+           streams[stream] if stream < len(streams) else str(stream),
+           events[event] if event < len(events) else str(event),
+           (v0, v1, v2, v3)[:numValues])
+
+def main():
+  parser = argparse.ArgumentParser(description="Decode an OpenModelica binary trace to CSV")
+  parser.add_argument("file")
+  parser.add_argument("--stream", help="only print records of this stream")
+  parser.add_argument("--event", help="only print records of this event")
+  args = parser.parse_args()
+
+  out = csv.writer(sys.stdout)
+  out.writerow(["thread", "stream", "event", "values"])
+  for thread, stream, event, values in read_trace(args.file):
+    if args.stream and stream != args.stream:
+      continue
+    if args.event and event != args.event:
+      continue
+    out.writerow([thread, stream, event] + ["%.17g" % v for v in values])
+
+if __name__ == "__main__":
+  main()